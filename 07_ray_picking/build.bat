@@ -31,11 +31,13 @@ set LIBS=%LIB_PATH_GLFW% %LIB_PATH_GLEW% glew32.lib glfw3dll.lib OpenGL32.lib %S
 set DLL_PATH_GLEW="third_party\glew-2.1.0\bin\Release\x64\glew32.dll"
 set DLL_PATH_GLFW="third_party\glfw-3.4.bin.WIN64\lib-vc2019\glfw3.dll"
 set DLL_PATH_ASSIMP="third_party\assimp\bin\vs2022\assimp-vc143-mt.dll"
-set SRC="*.c??"
+set SRC=main.cpp gl_utils.cpp maths_funcs.cpp obj_parser.cpp mdi_renderer.cpp bvh.cpp
+set BENCH_SRC=bvh_bench.cpp bvh.cpp ray_batch.cpp maths_funcs.cpp obj_parser.cpp
 
 @echo on
 
 cl %CFLAGS% %SRC% %INCLUDES% /link %LFLAGS% %LIBS% /OUT:"raypick.exe" 
+cl %CFLAGS% /O2 /arch:AVX %BENCH_SRC% /link %LFLAGS% /OUT:"bvh_bench.exe" 
 
 copy ..\%DLL_PATH_GLEW% .\
 copy ..\%DLL_PATH_GLFW% .\
@@ -0,0 +1,490 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Bounding volume hierarchies for ray casting.                                 |
+\******************************************************************************/
+#include "bvh.h"
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------------------------------SAH BUILDER--------------------------------*/
+/* both kinds of tree are built the same way, from a box per primitive */
+struct bvh_build_t {
+  const float* prim_min; /* 3 floats per primitive */
+  const float* prim_max;
+  float* centres;
+  int* ids; /* primitive order. partitioned in place as the tree is built */
+  bvh_node_t* nodes;
+  int n_nodes;
+};
+
+struct sah_bin_t {
+  float min[3], max[3];
+  int count;
+};
+
+static void empty_box( float* mn, float* mx ) {
+  for ( int i = 0; i < 3; i++ ) {
+    mn[i] = FLT_MAX;
+    mx[i] = -FLT_MAX;
+  }
+}
+
+static void grow_box( float* mn, float* mx, const float* other_min, const float* other_max ) {
+  for ( int i = 0; i < 3; i++ ) {
+    mn[i] = other_min[i] < mn[i] ? other_min[i] : mn[i];
+    mx[i] = other_max[i] > mx[i] ? other_max[i] : mx[i];
+  }
+}
+
+/* half the surface area. the factor of 2 doesn't matter when comparing */
+static float box_area( const float* mn, const float* mx ) {
+  float e[3] = { mx[0] - mn[0], mx[1] - mn[1], mx[2] - mn[2] };
+  if ( e[0] < 0.0f ) { return 0.0f; }
+  return e[0] * e[1] + e[1] * e[2] + e[2] * e[0];
+}
+
+static void subdivide( bvh_build_t* b, int node_index, int first, int count, int depth ) {
+  bvh_node_t* node = &b->nodes[node_index];
+  empty_box( node->min, node->max );
+  float cmin[3], cmax[3]; /* bounds of primitive centres, for binning */
+  empty_box( cmin, cmax );
+  for ( int i = first; i < first + count; i++ ) {
+    int id = b->ids[i];
+    grow_box( node->min, node->max, &b->prim_min[id * 3], &b->prim_max[id * 3] );
+    grow_box( cmin, cmax, &b->centres[id * 3], &b->centres[id * 3] );
+  }
+  node->left_first = first;
+  node->count      = count;
+  /* a deeper node could overflow the traversal stacks, so it stays a leaf,
+  however many primitives it has */
+  if ( count <= 1 || depth >= BVH_MAX_DEPTH ) { return; }
+
+  /* find the cheapest split plane between bins on any axis */
+  int best_axis   = -1, best_split = 0;
+  float best_cost = FLT_MAX;
+  for ( int axis = 0; axis < 3; axis++ ) {
+    float extent = cmax[axis] - cmin[axis];
+    if ( extent <= 0.0f ) { continue; }
+    sah_bin_t bins[BVH_SAH_BINS];
+    for ( int i = 0; i < BVH_SAH_BINS; i++ ) {
+      empty_box( bins[i].min, bins[i].max );
+      bins[i].count = 0;
+    }
+    float scale = BVH_SAH_BINS / extent;
+    for ( int i = first; i < first + count; i++ ) {
+      int id  = b->ids[i];
+      int bin = (int)( ( b->centres[id * 3 + axis] - cmin[axis] ) * scale );
+      if ( bin > BVH_SAH_BINS - 1 ) { bin = BVH_SAH_BINS - 1; }
+      grow_box( bins[bin].min, bins[bin].max, &b->prim_min[id * 3], &b->prim_max[id * 3] );
+      bins[bin].count++;
+    }
+    /* sweep from both ends so every split's cost is known in 2 passes */
+    float left_area[BVH_SAH_BINS - 1], right_area[BVH_SAH_BINS - 1];
+    int left_count[BVH_SAH_BINS - 1], right_count[BVH_SAH_BINS - 1];
+    float lmin[3], lmax[3], rmin[3], rmax[3];
+    empty_box( lmin, lmax );
+    empty_box( rmin, rmax );
+    int lsum = 0, rsum = 0;
+    for ( int i = 0; i < BVH_SAH_BINS - 1; i++ ) {
+      lsum += bins[i].count;
+      grow_box( lmin, lmax, bins[i].min, bins[i].max );
+      left_count[i] = lsum;
+      left_area[i]  = box_area( lmin, lmax );
+      int j         = BVH_SAH_BINS - 1 - i;
+      rsum += bins[j].count;
+      grow_box( rmin, rmax, bins[j].min, bins[j].max );
+      right_count[j - 1] = rsum;
+      right_area[j - 1]  = box_area( rmin, rmax );
+    }
+    for ( int i = 0; i < BVH_SAH_BINS - 1; i++ ) {
+      if ( 0 == left_count[i] || 0 == right_count[i] ) { continue; }
+      float cost = left_count[i] * left_area[i] + right_count[i] * right_area[i];
+      if ( cost < best_cost ) {
+        best_cost  = cost;
+        best_axis  = axis;
+        best_split = i;
+      }
+    }
+  }
+
+  /* a leaf costs one test per primitive. a split costs a box test, about the
+  same as one primitive test, plus each half's tests weighted by the chance
+  that a ray through this node also goes through that half */
+  float area       = box_area( node->min, node->max );
+  float leaf_cost  = (float)count;
+  float split_cost = area > 0.0f ? 1.0f + best_cost / area : FLT_MAX;
+  if ( best_axis < 0 || split_cost >= leaf_cost ) {
+    if ( count <= BVH_MAX_LEAF_PRIMS ) { return; }
+  }
+
+  int mid = first;
+  if ( best_axis >= 0 ) {
+    float extent = cmax[best_axis] - cmin[best_axis];
+    float scale  = BVH_SAH_BINS / extent;
+    int last     = first + count - 1;
+    while ( mid <= last ) {
+      int id  = b->ids[mid];
+      int bin = (int)( ( b->centres[id * 3 + best_axis] - cmin[best_axis] ) * scale );
+      if ( bin > BVH_SAH_BINS - 1 ) { bin = BVH_SAH_BINS - 1; }
+      if ( bin <= best_split ) {
+        mid++;
+      } else {
+        b->ids[mid]  = b->ids[last];
+        b->ids[last] = id;
+        last--;
+      }
+    }
+  } else {
+    /* all the centres are in the same place so no plane separates them. a leaf
+    would be too big, so just cut the list in half */
+    mid = first + count / 2;
+  }
+
+  int left = b->n_nodes;
+  b->n_nodes += 2;
+  node->left_first = left;
+  node->count      = 0;
+  subdivide( b, left, first, mid - first, depth + 1 );
+  subdivide( b, left + 1, mid, first + count - mid, depth + 1 );
+}
+
+/* builds into nodes, which must have room for 2 * n_prims - 1 nodes. returns
+the number of nodes used */
+static int build_nodes( const float* prim_min, const float* prim_max, int n_prims, bvh_node_t* nodes, int* ids ) {
+  bvh_build_t b;
+  b.prim_min = prim_min;
+  b.prim_max = prim_max;
+  b.centres  = (float*)malloc( n_prims * 3 * sizeof( float ) );
+  b.ids      = ids;
+  b.nodes    = nodes;
+  b.n_nodes  = 1;
+  assert( b.centres );
+  for ( int i = 0; i < n_prims; i++ ) {
+    ids[i] = i;
+    for ( int j = 0; j < 3; j++ ) { b.centres[i * 3 + j] = 0.5f * ( prim_min[i * 3 + j] + prim_max[i * 3 + j] ); }
+  }
+  subdivide( &b, 0, 0, n_prims, 0 );
+  free( b.centres );
+  return b.n_nodes;
+}
+
+/*---------------------------------MESH BVH-----------------------------------*/
+bool build_mesh_bvh( mesh_bvh_t* bvh, const float* points, int point_count ) {
+  memset( bvh, 0, sizeof( mesh_bvh_t ) );
+  bvh->n_tris = point_count / 3;
+  if ( bvh->n_tris < 1 ) {
+    fprintf( stderr, "ERROR: mesh BVH needs at least one triangle\n" );
+    return false;
+  }
+  bvh->nodes     = (bvh_node_t*)malloc( ( 2 * bvh->n_tris - 1 ) * sizeof( bvh_node_t ) );
+  bvh->tris      = (float*)malloc( bvh->n_tris * 9 * sizeof( float ) );
+  bvh->tri_ids   = (int*)malloc( bvh->n_tris * sizeof( int ) );
+  float* tri_min = (float*)malloc( bvh->n_tris * 3 * sizeof( float ) );
+  float* tri_max = (float*)malloc( bvh->n_tris * 3 * sizeof( float ) );
+  if ( !bvh->nodes || !bvh->tris || !bvh->tri_ids || !tri_min || !tri_max ) {
+    fprintf( stderr, "ERROR: out of memory for BVH of %i triangles\n", bvh->n_tris );
+    free( tri_min );
+    free( tri_max );
+    free_mesh_bvh( bvh );
+    return false;
+  }
+  for ( int i = 0; i < bvh->n_tris; i++ ) {
+    empty_box( &tri_min[i * 3], &tri_max[i * 3] );
+    for ( int p = 0; p < 3; p++ ) { grow_box( &tri_min[i * 3], &tri_max[i * 3], &points[i * 9 + p * 3], &points[i * 9 + p * 3] ); }
+  }
+  bvh->n_nodes = build_nodes( tri_min, tri_max, bvh->n_tris, bvh->nodes, bvh->tri_ids );
+  /* copy triangles into leaf order so each leaf reads one run of memory */
+  for ( int i = 0; i < bvh->n_tris; i++ ) { memcpy( &bvh->tris[i * 9], &points[bvh->tri_ids[i] * 9], 9 * sizeof( float ) ); }
+  free( tri_min );
+  free( tri_max );
+  return true;
+}
+
+void free_mesh_bvh( mesh_bvh_t* bvh ) {
+  free( bvh->nodes );
+  free( bvh->tris );
+  free( bvh->tri_ids );
+  memset( bvh, 0, sizeof( mesh_bvh_t ) );
+}
+
+/*--------------------------------SCENE BVH-----------------------------------*/
+bool init_scene_bvh( scene_bvh_t* bvh, int max_objects ) {
+  memset( bvh, 0, sizeof( scene_bvh_t ) );
+  bvh->max_objects = max_objects;
+  bvh->nodes       = (bvh_node_t*)malloc( ( 2 * max_objects - 1 ) * sizeof( bvh_node_t ) );
+  bvh->objects     = (bvh_object_t*)malloc( max_objects * sizeof( bvh_object_t ) );
+  bvh->object_ids  = (int*)malloc( max_objects * sizeof( int ) );
+  if ( !bvh->nodes || !bvh->objects || !bvh->object_ids ) {
+    fprintf( stderr, "ERROR: out of memory for BVH of %i objects\n", max_objects );
+    free_scene_bvh( bvh );
+    return false;
+  }
+  return true;
+}
+
+void free_scene_bvh( scene_bvh_t* bvh ) {
+  free( bvh->nodes );
+  free( bvh->objects );
+  free( bvh->object_ids );
+  memset( bvh, 0, sizeof( scene_bvh_t ) );
+}
+
+void clear_scene_bvh( scene_bvh_t* bvh ) {
+  bvh->n_objects = 0;
+  bvh->n_nodes   = 0;
+}
+
+int add_scene_bvh_object( scene_bvh_t* bvh, const mesh_bvh_t* mesh, const mat4& M ) {
+  if ( bvh->n_objects >= bvh->max_objects ) {
+    fprintf( stderr, "ERROR: scene BVH is full with %i objects\n", bvh->max_objects );
+    return -1;
+  }
+  bvh_object_t* o = &bvh->objects[bvh->n_objects];
+  o->mesh         = mesh;
+  o->M            = M;
+  o->inv_M        = inverse( M );
+  return bvh->n_objects++;
+}
+
+/* column-major, like mat4 and GL. w is 1 for points and 0 for directions */
+static void transform( const mat4& M, const float* v, float w, float* out ) {
+  for ( int i = 0; i < 3; i++ ) { out[i] = M.m[i] * v[0] + M.m[4 + i] * v[1] + M.m[8 + i] * v[2] + M.m[12 + i] * w; }
+}
+
+void build_scene_bvh( scene_bvh_t* bvh ) {
+  bvh->n_nodes = 0;
+  if ( bvh->n_objects < 1 ) { return; }
+  float* obj_min = (float*)malloc( bvh->n_objects * 3 * sizeof( float ) );
+  float* obj_max = (float*)malloc( bvh->n_objects * 3 * sizeof( float ) );
+  assert( obj_min && obj_max );
+  for ( int i = 0; i < bvh->n_objects; i++ ) {
+    /* world box around the 8 corners of the mesh's box */
+    const bvh_object_t* o  = &bvh->objects[i];
+    const bvh_node_t* root = &o->mesh->nodes[0];
+    empty_box( &obj_min[i * 3], &obj_max[i * 3] );
+    for ( int c = 0; c < 8; c++ ) {
+      float corner[3] = { ( c & 1 ) ? root->max[0] : root->min[0], ( c & 2 ) ? root->max[1] : root->min[1], ( c & 4 ) ? root->max[2] : root->min[2] };
+      float wor[3];
+      transform( o->M, corner, 1.0f, wor );
+      grow_box( &obj_min[i * 3], &obj_max[i * 3], wor, wor );
+    }
+  }
+  bvh->n_nodes = build_nodes( obj_min, obj_max, bvh->n_objects, bvh->nodes, bvh->object_ids );
+  free( obj_min );
+  free( obj_max );
+}
+
+/*---------------------------------TRAVERSAL----------------------------------*/
+/* where the ray enters a box: the later of a and the nearer of t1 and t2 */
+static inline float slab_enter( float a, float t1, float t2 ) {
+  float t = t1 < t2 ? t1 : t2;
+  return t > a ? t : a;
+}
+
+/* where the ray exits a box: the earlier of a and the further of t1 and t2 */
+static inline float slab_exit( float a, float t1, float t2 ) {
+  float t = t1 > t2 ? t1 : t2;
+  return t < a ? t : a;
+}
+
+/* slab test. returns the distance to where the ray enters the box, or FLT_MAX
+if it misses or only enters beyond max_t */
+static float ray_box( const float* o, const float* inv_d, const bvh_node_t* node, float max_t ) {
+  float tmin = -FLT_MAX, tmax = FLT_MAX;
+  for ( int i = 0; i < 3; i++ ) {
+    float t1 = ( node->min[i] - o[i] ) * inv_d[i];
+    float t2 = ( node->max[i] - o[i] ) * inv_d[i];
+    /* plain compares rather than fminf() so this inlines to min/max instructions */
+    tmin = slab_enter( tmin, t1, t2 );
+    tmax = slab_exit( tmax, t1, t2 );
+  }
+  if ( tmax >= tmin && tmax > 0.0f && tmin < max_t ) { return tmin; }
+  return FLT_MAX;
+}
+
+/* Moller-Trumbore. both sides of the triangle count */
+static bool ray_triangle( const float* o, const float* d, const float* tri, float* t, float* u, float* v ) {
+  float e1[3] = { tri[3] - tri[0], tri[4] - tri[1], tri[5] - tri[2] };
+  float e2[3] = { tri[6] - tri[0], tri[7] - tri[1], tri[8] - tri[2] };
+  float p[3]  = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+  float det   = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+  if ( fabsf( det ) < 1e-12f ) { return false; } // ray is parallel to the triangle
+  float inv_det = 1.0f / det;
+  float s[3]    = { o[0] - tri[0], o[1] - tri[1], o[2] - tri[2] };
+  float uu      = ( s[0] * p[0] + s[1] * p[1] + s[2] * p[2] ) * inv_det;
+  if ( uu < 0.0f || uu > 1.0f ) { return false; }
+  float q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+  float vv   = ( d[0] * q[0] + d[1] * q[1] + d[2] * q[2] ) * inv_det;
+  if ( vv < 0.0f || uu + vv > 1.0f ) { return false; }
+  float tt = ( e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2] ) * inv_det;
+  if ( tt <= 0.0f || tt >= *t ) { return false; }
+  *t = tt;
+  *u = uu;
+  *v = vv;
+  return true;
+}
+
+/* hit->t is the closest hit so far, and is only changed by a closer hit */
+static bool traverse_mesh( const mesh_bvh_t* bvh, const float* o, const float* d, ray_hit_t* hit ) {
+  float inv_d[3] = { 1.0f / d[0], 1.0f / d[1], 1.0f / d[2] };
+  if ( FLT_MAX == ray_box( o, inv_d, &bvh->nodes[0], hit->t ) ) { return false; }
+  const bvh_node_t* stack[BVH_STACK_SIZE];
+  float stack_t[BVH_STACK_SIZE]; /* where the ray enters each node on the stack */
+  int stack_size         = 0;
+  const bvh_node_t* node = &bvh->nodes[0];
+  bool found             = false;
+  while ( true ) {
+    if ( node->count > 0 ) {
+      for ( int i = node->left_first; i < node->left_first + node->count; i++ ) {
+        if ( ray_triangle( o, d, &bvh->tris[i * 9], &hit->t, &hit->u, &hit->v ) ) {
+          hit->triangle = bvh->tri_ids[i];
+          found         = true;
+        }
+      }
+      /* skip nodes that the ray enters beyond its closest hit so far */
+      while ( stack_size > 0 && stack_t[stack_size - 1] >= hit->t ) { stack_size--; }
+      if ( 0 == stack_size ) { break; }
+      node = stack[--stack_size];
+      continue;
+    }
+    /* visit the nearer child first. the further one might be skipped later
+    if something closer than it has been hit by then */
+    const bvh_node_t* a = &bvh->nodes[node->left_first];
+    const bvh_node_t* b = &bvh->nodes[node->left_first + 1];
+    float ta            = ray_box( o, inv_d, a, hit->t );
+    float tb            = ray_box( o, inv_d, b, hit->t );
+    if ( ta > tb ) {
+      const bvh_node_t* tmp_node = a;
+      a                          = b;
+      b                          = tmp_node;
+      float tmp_t                = ta;
+      ta                         = tb;
+      tb                         = tmp_t;
+    }
+    if ( FLT_MAX == ta ) {
+      /* skip nodes that the ray enters beyond its closest hit so far */
+      while ( stack_size > 0 && stack_t[stack_size - 1] >= hit->t ) { stack_size--; }
+      if ( 0 == stack_size ) { break; }
+      node = stack[--stack_size];
+      continue;
+    }
+    node = a;
+    if ( FLT_MAX != tb ) {
+      assert( stack_size < BVH_STACK_SIZE );
+      stack_t[stack_size] = tb;
+      stack[stack_size++] = b;
+    }
+  }
+  return found;
+}
+
+bool ray_cast_mesh( const mesh_bvh_t* bvh, vec3 ray_origin, vec3 ray_direction, float max_t, ray_hit_t* hit ) {
+  hit->t        = max_t;
+  hit->triangle = -1;
+  return traverse_mesh( bvh, ray_origin.v, ray_direction.v, hit );
+}
+
+bool ray_cast( const scene_bvh_t* bvh, vec3 ray_origin, vec3 ray_direction, float max_t, ray_hit_t* hit ) {
+  hit->t        = max_t;
+  hit->object   = -1;
+  hit->triangle = -1;
+  if ( bvh->n_nodes < 1 ) { return false; }
+  const float* o = ray_origin.v;
+  const float* d = ray_direction.v;
+  float inv_d[3] = { 1.0f / d[0], 1.0f / d[1], 1.0f / d[2] };
+  if ( FLT_MAX == ray_box( o, inv_d, &bvh->nodes[0], hit->t ) ) { return false; }
+  const bvh_node_t* stack[BVH_STACK_SIZE];
+  float stack_t[BVH_STACK_SIZE]; /* where the ray enters each node on the stack */
+  int stack_size         = 0;
+  const bvh_node_t* node = &bvh->nodes[0];
+  while ( true ) {
+    if ( node->count > 0 ) {
+      for ( int i = node->left_first; i < node->left_first + node->count; i++ ) {
+        /* move the ray into mesh space. the direction isn't normalised after,
+        so distances along it are still world-space distances */
+        int id                  = bvh->object_ids[i];
+        const bvh_object_t* obj = &bvh->objects[id];
+        float mo[3], md[3];
+        transform( obj->inv_M, o, 1.0f, mo );
+        transform( obj->inv_M, d, 0.0f, md );
+        if ( traverse_mesh( obj->mesh, mo, md, hit ) ) { hit->object = id; }
+      }
+      /* skip nodes that the ray enters beyond its closest hit so far */
+      while ( stack_size > 0 && stack_t[stack_size - 1] >= hit->t ) { stack_size--; }
+      if ( 0 == stack_size ) { break; }
+      node = stack[--stack_size];
+      continue;
+    }
+    const bvh_node_t* a = &bvh->nodes[node->left_first];
+    const bvh_node_t* b = &bvh->nodes[node->left_first + 1];
+    float ta            = ray_box( o, inv_d, a, hit->t );
+    float tb            = ray_box( o, inv_d, b, hit->t );
+    if ( ta > tb ) {
+      const bvh_node_t* tmp_node = a;
+      a                          = b;
+      b                          = tmp_node;
+      float tmp_t                = ta;
+      ta                         = tb;
+      tb                         = tmp_t;
+    }
+    if ( FLT_MAX == ta ) {
+      /* skip nodes that the ray enters beyond its closest hit so far */
+      while ( stack_size > 0 && stack_t[stack_size - 1] >= hit->t ) { stack_size--; }
+      if ( 0 == stack_size ) { break; }
+      node = stack[--stack_size];
+      continue;
+    }
+    node = a;
+    if ( FLT_MAX != tb ) {
+      assert( stack_size < BVH_STACK_SIZE );
+      stack_t[stack_size] = tb;
+      stack[stack_size++] = b;
+    }
+  }
+  return hit->object >= 0;
+}
+
+bool ray_sphere( vec3 ray_origin_wor, vec3 ray_direction_wor, vec3 sphere_centre_wor, float sphere_radius, float* intersection_distance ) {
+  // work out components of quadratic
+  vec3 dist_to_sphere     = ray_origin_wor - sphere_centre_wor;
+  float b                 = dot( ray_direction_wor, dist_to_sphere );
+  float c                 = dot( dist_to_sphere, dist_to_sphere ) - sphere_radius * sphere_radius;
+  float b_squared_minus_c = b * b - c;
+  // check for "imaginary" answer. == ray completely misses sphere
+  if ( b_squared_minus_c < 0.0f ) { return false; }
+  // check for ray hitting twice (in and out of the sphere)
+  if ( b_squared_minus_c > 0.0f ) {
+    // get the 2 intersection distances along ray
+    float t_a              = -b + sqrt( b_squared_minus_c );
+    float t_b              = -b - sqrt( b_squared_minus_c );
+    *intersection_distance = t_b;
+    // if behind viewer, throw one or both away
+    if ( t_a < 0.0 ) {
+      if ( t_b < 0.0 ) { return false; }
+    } else if ( t_b < 0.0 ) {
+      *intersection_distance = t_a;
+    }
+
+    return true;
+  }
+  // check for ray hitting once (skimming the surface)
+  if ( 0.0f == b_squared_minus_c ) {
+    // if behind viewer, throw away
+    float t = -b + sqrt( b_squared_minus_c );
+    if ( t < 0.0f ) { return false; }
+    *intersection_distance = t;
+    return true;
+  }
+  // note: could also check if ray origin is inside sphere radius
+  return false;
+}
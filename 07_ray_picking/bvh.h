@@ -0,0 +1,101 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Bounding volume hierarchies for ray casting.                                 |
+| Testing a ray against every object is fine for a few spheres, but not for    |
+| 100000 objects or for the actual triangles of a mesh. A BVH is a binary tree |
+| of axis-aligned boxes - each node's box contains everything below it - so a  |
+| ray only visits the few branches whose boxes it passes through.              |
+| There are two levels here. Each mesh gets a BVH over its triangles, in mesh  |
+| space. A scene gets a BVH over its objects' world-space boxes, where each    |
+| object is a mesh and a model matrix. At an object the ray is moved into mesh |
+| space with the inverse matrix and carries on down that mesh's tree, so one   |
+| mesh BVH can be shared by any number of objects.                             |
+| Both trees are built with the surface area heuristic (SAH). A split is       |
+| chosen by sorting primitive centres into bins along each axis and picking    |
+| the plane that minimises (area x count) of the two halves, since the chance  |
+| of a ray hitting a box is roughly proportional to its surface area.          |
+| No GL in here, so it can be built into CPU-only tools like bvh_bench.        |
+\******************************************************************************/
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#include "maths_funcs.h"
+
+/* number of bins per axis to sort primitive centres into while building */
+#define BVH_SAH_BINS 16
+/* leaves can hold more than this only if their primitives can't be split */
+#define BVH_MAX_LEAF_PRIMS 4
+/* nodes waiting to be visited by a ray. a ray pushes at most one node for each
+level above the one it is on, so the build stops splitting at BVH_MAX_DEPTH */
+#define BVH_STACK_SIZE 64
+#define BVH_MAX_DEPTH ( BVH_STACK_SIZE - 1 )
+
+/* 32 bytes, so two nodes share a 64-byte cache line */
+struct bvh_node_t {
+  float min[3];
+  int left_first; /* left child index (right is the next node), or first primitive of a leaf */
+  float max[3];
+  int count;      /* primitives in a leaf. 0 for interior nodes */
+};
+
+struct mesh_bvh_t {
+  bvh_node_t* nodes;
+  int n_nodes;
+  float* tris;   /* 9 floats per triangle, reordered so that leaves are contiguous */
+  int* tri_ids;  /* original index of each triangle in tris */
+  int n_tris;
+};
+
+struct bvh_object_t {
+  const mesh_bvh_t* mesh;
+  mat4 M;
+  mat4 inv_M; /* takes rays from world space into mesh space */
+};
+
+struct scene_bvh_t {
+  bvh_node_t* nodes;
+  int n_nodes;
+  bvh_object_t* objects;
+  int* object_ids; /* index into objects for each leaf primitive */
+  int n_objects, max_objects;
+};
+
+struct ray_hit_t {
+  float t;      /* distance along the ray, in units of the ray's direction */
+  int object;   /* -1 if nothing was hit */
+  int triangle; /* index of the triangle in its mesh, in the order it was loaded */
+  /* barycentric coordinates. the hit is at (1 - u - v) * a + u * b + v * c */
+  float u, v;
+};
+
+/* points are xyz triangles, 3 points per triangle, as from load_obj_file() */
+bool build_mesh_bvh( mesh_bvh_t* bvh, const float* points, int point_count );
+void free_mesh_bvh( mesh_bvh_t* bvh );
+
+bool init_scene_bvh( scene_bvh_t* bvh, int max_objects );
+void free_scene_bvh( scene_bvh_t* bvh );
+/* removes all objects. add more then call build_scene_bvh() again */
+void clear_scene_bvh( scene_bvh_t* bvh );
+/* returns the object's index, which is reported in hits. -1 if full */
+int add_scene_bvh_object( scene_bvh_t* bvh, const mesh_bvh_t* mesh, const mat4& M );
+/* (re)builds the tree over all the objects added so far */
+void build_scene_bvh( scene_bvh_t* bvh );
+
+/* finds the closest triangle hit along a ray, ignoring anything further than
+max_t. returns false if nothing was hit */
+bool ray_cast( const scene_bvh_t* bvh, vec3 ray_origin, vec3 ray_direction, float max_t, ray_hit_t* hit );
+/* same, against one mesh's triangles in mesh space. hit->object isn't changed */
+bool ray_cast_mesh( const mesh_bvh_t* bvh, vec3 ray_origin, vec3 ray_direction, float max_t, ray_hit_t* hit );
+
+/* check if a ray and a sphere intersect. if not hit, returns false. it rejects
+intersections behind the ray caster's origin, and sets intersection_distance to
+the closest intersection */
+bool ray_sphere( vec3 ray_origin_wor, vec3 ray_direction_wor, vec3 sphere_centre_wor, float sphere_radius, float* intersection_distance );
+
+#endif
@@ -0,0 +1,229 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| BVH benchmark. CPU only - no window or GL context.                           |
+| Builds a BVH over a mesh's triangles, and over grids of 1000 to 100000       |
+| copies of it, timing the builds and ray casts per second. Every BVH hit is   |
+| checked against testing each triangle of each object in turn, so a broken    |
+| tree shows up as mismatches. Then casts batches of camera rays and random    |
+| rays in SIMD packets, with 1 up to as many threads as there are cores, and   |
+| checks the results against single ray casts.                                 |
+| Run with a mesh file, or sphere.obj by default:                              |
+|   ./bvh_bench [mesh.obj]                                                     |
+\******************************************************************************/
+#include "bvh.h"
+#include "maths_funcs.h"
+#include "obj_parser.h"
+#include "ray_batch.h"
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#define MESH_FILE "sphere.obj"
+#define N_RAYS 100000
+// rays to check against the brute force version, for 1000 objects. it is very
+// slow so fewer rays are checked in bigger scenes
+#define N_CHECK_RAYS 200
+// batches are camera rays through each pixel of a square image this wide
+#define BATCH_IMAGE_DIMS 512
+
+static double get_seconds() { return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count(); }
+
+static float rand_range( float min, float max ) { return min + ( max - min ) * ( (float)rand() / (float)RAND_MAX ); }
+
+/* the same cubic grid as the bigger scenes in the demo */
+static void grid_position( int i, int num_spheres, float spacing, vec3* pos ) {
+  int side   = (int)ceil( cbrt( (double)num_spheres ) );
+  float half = 0.5f * spacing * ( side - 1 );
+  int x      = i % side;
+  int y      = ( i / side ) % side;
+  int z      = i / ( side * side );
+  *pos       = vec3( x * spacing - half, y * spacing - half, -2.0f - z * spacing );
+}
+
+/* the closest hit found by testing every triangle of every object */
+static bool brute_force_cast( const scene_bvh_t* scene, vec3 origin, vec3 direction, ray_hit_t* hit ) {
+  ray_hit_t best;
+  best.t      = FLT_MAX;
+  best.object = -1;
+  for ( int i = 0; i < scene->n_objects; i++ ) {
+    const bvh_object_t* obj = &scene->objects[i];
+    mat4 inv_M              = obj->inv_M;
+    vec3 o                  = vec3( inv_M * vec4( origin, 1.0f ) );
+    vec3 d                  = vec3( inv_M * vec4( direction, 0.0f ) );
+    /* a mesh BVH with one leaf would do, but just walk the triangle list */
+    const mesh_bvh_t* mesh = obj->mesh;
+    for ( int t = 0; t < mesh->n_tris; t++ ) {
+      const float* tri = &mesh->tris[t * 9];
+      vec3 a( tri[0], tri[1], tri[2] ), b( tri[3], tri[4], tri[5] ), c( tri[6], tri[7], tri[8] );
+      vec3 e1   = b - a;
+      vec3 e2   = c - a;
+      vec3 p    = cross( d, e2 );
+      float det = dot( e1, p );
+      if ( fabsf( det ) < 1e-12f ) { continue; }
+      vec3 s   = o - a;
+      float u  = dot( s, p ) / det;
+      vec3 q   = cross( s, e1 );
+      float v  = dot( d, q ) / det;
+      float tt = dot( e2, q ) / det;
+      if ( u < 0.0f || v < 0.0f || u + v > 1.0f || tt <= 0.0f || tt >= best.t ) { continue; }
+      best.t        = tt;
+      best.object   = i;
+      best.triangle = mesh->tri_ids[t];
+    }
+  }
+  *hit = best;
+  return best.object >= 0;
+}
+
+/* compares one ray_cast() at a time against ray_cast_batch() with 1 to
+max_threads threads, reporting millions of rays per second */
+static void benchmark_batch( const scene_bvh_t* scene, ray_batch_t* batch, const char* label, int max_threads ) {
+  double start = get_seconds();
+  for ( int i = 0; i < batch->n_rays; i++ ) {
+    ray_hit_t hit;
+    vec3 o( batch->origin[0][i], batch->origin[1][i], batch->origin[2][i] );
+    vec3 d( batch->direction[0][i], batch->direction[1][i], batch->direction[2][i] );
+    ray_cast( scene, o, d, batch->max_t[i], &hit );
+  }
+  double single_s = get_seconds() - start;
+  printf( "  %s rays: one at a time %.2f Mrays/s | packets of %i:", label, batch->n_rays / single_s / 1e6, ray_packet_size() );
+  for ( int n_threads = 1; n_threads <= max_threads; n_threads++ ) {
+    ray_query_pool_t* pool = create_ray_query_pool( n_threads );
+    ray_cast_batch( pool, scene, batch ); // warm up the threads
+    start = get_seconds();
+    ray_cast_batch( pool, scene, batch );
+    double batch_s = get_seconds() - start;
+    destroy_ray_query_pool( pool );
+    printf( " %i thread%s %.2f Mrays/s |", n_threads, n_threads > 1 ? "s" : "", batch->n_rays / batch_s / 1e6 );
+  }
+  int n_mismatches = 0;
+  for ( int i = 0; i < batch->n_rays; i++ ) {
+    ray_hit_t hit;
+    vec3 o( batch->origin[0][i], batch->origin[1][i], batch->origin[2][i] );
+    vec3 d( batch->direction[0][i], batch->direction[1][i], batch->direction[2][i] );
+    ray_cast( scene, o, d, batch->max_t[i], &hit );
+    if ( hit.object != batch->object[i] || ( hit.object >= 0 && fabsf( hit.t - batch->t[i] ) > 1e-3f ) ) { n_mismatches++; }
+  }
+  printf( " %i/%i mismatches\n", n_mismatches, batch->n_rays );
+}
+
+int main( int argc, char** argv ) {
+  const char* mesh_file = argc > 1 ? argv[1] : MESH_FILE;
+  float* vp             = NULL;
+  float* vt             = NULL;
+  float* vn             = NULL;
+  int point_count       = 0;
+  if ( !load_obj_file( mesh_file, vp, vt, vn, point_count ) ) {
+    fprintf( stderr, "ERROR: loading mesh file %s\n", mesh_file );
+    return 1;
+  }
+  srand( 1 );
+
+  /* mesh BVH over triangles */
+  mesh_bvh_t mesh;
+  const int n_builds = 20;
+  double start       = get_seconds();
+  for ( int i = 0; i < n_builds; i++ ) {
+    if ( i > 0 ) { free_mesh_bvh( &mesh ); }
+    if ( !build_mesh_bvh( &mesh, vp, point_count ) ) { return 1; }
+  }
+  double build_ms = ( get_seconds() - start ) * 1000.0 / n_builds;
+  printf( "mesh %s: %i triangles, %i nodes, built in %.3fms\n", mesh_file, mesh.n_tris, mesh.n_nodes, build_ms );
+  float radius = 0.0f;
+  for ( int i = 0; i < 3; i++ ) { radius = fmaxf( radius, fmaxf( fabsf( mesh.nodes[0].min[i] ), fabsf( mesh.nodes[0].max[i] ) ) ); }
+
+  /* scenes of copies of the mesh */
+  const int sizes[] = { 1000, 10000, 100000 };
+  const int n_sizes = 3;
+  vec3* ray_d       = (vec3*)malloc( N_RAYS * sizeof( vec3 ) );
+  vec3 cam_pos( 0.0f, 0.0f, 5.0f );
+  scene_bvh_t scene;
+  ray_batch_t batch;
+  if ( !ray_d || !init_scene_bvh( &scene, sizes[n_sizes - 1] ) || !alloc_ray_batch( &batch, BATCH_IMAGE_DIMS * BATCH_IMAGE_DIMS ) ) { return 1; }
+  int max_threads = (int)std::thread::hardware_concurrency();
+  if ( max_threads < 1 ) { max_threads = 1; }
+  for ( int s = 0; s < n_sizes; s++ ) {
+    int n         = sizes[s];
+    float spacing = 3.0f * radius;
+    start         = get_seconds();
+    clear_scene_bvh( &scene );
+    for ( int i = 0; i < n; i++ ) {
+      vec3 pos;
+      grid_position( i, n, spacing, &pos );
+      add_scene_bvh_object( &scene, &mesh, translate( identity_mat4(), pos ) );
+    }
+    build_scene_bvh( &scene );
+    build_ms = ( get_seconds() - start ) * 1000.0;
+
+    /* rays from the camera at random points in the grid's box, so most hit */
+    const bvh_node_t* root = &scene.nodes[0];
+    for ( int i = 0; i < N_RAYS; i++ ) {
+      vec3 target( rand_range( root->min[0], root->max[0] ), rand_range( root->min[1], root->max[1] ), rand_range( root->min[2], root->max[2] ) );
+      ray_d[i] = normalise( target - cam_pos );
+    }
+    int n_hits = 0;
+    start      = get_seconds();
+    for ( int i = 0; i < N_RAYS; i++ ) {
+      ray_hit_t hit;
+      if ( ray_cast( &scene, cam_pos, ray_d[i], FLT_MAX, &hit ) ) { n_hits++; }
+    }
+    double ray_s = get_seconds() - start;
+
+    /* the old way, for comparison - a sphere test per object */
+    int n_sphere_rays = 1000;
+    start             = get_seconds();
+    for ( int i = 0; i < n_sphere_rays; i++ ) {
+      for ( int j = 0; j < n; j++ ) {
+        float t = 0.0f;
+        vec3 pos;
+        grid_position( j, n, spacing, &pos );
+        ray_sphere( cam_pos, ray_d[i], pos, radius, &t );
+      }
+    }
+    double sphere_s = get_seconds() - start;
+
+    int n_check_rays = N_CHECK_RAYS * 1000 / n;
+    int n_mismatches = 0;
+    for ( int i = 0; i < n_check_rays; i++ ) {
+      ray_hit_t hit, expected;
+      ray_cast( &scene, cam_pos, ray_d[i], FLT_MAX, &hit );
+      brute_force_cast( &scene, cam_pos, ray_d[i], &expected );
+      if ( hit.object != expected.object || ( hit.object >= 0 && ( hit.triangle != expected.triangle || fabsf( hit.t - expected.t ) > 1e-3f ) ) ) {
+        n_mismatches++;
+        printf( "  MISMATCH ray %i: bvh object %i tri %i t %f. brute force object %i tri %i t %f\n", i, hit.object, hit.triangle, hit.t, expected.object, expected.triangle, expected.t );
+      }
+    }
+    printf( "%6i objects: %6i nodes built in %8.3fms | %.2f Mrays/s (%i%% hit) | sphere loop %.4f Mrays/s | %i/%i mismatches\n", n, scene.n_nodes, build_ms,
+      N_RAYS / ray_s / 1e6, n_hits * 100 / N_RAYS, n_sphere_rays / sphere_s / 1e6, n_mismatches, n_check_rays );
+
+    /* a camera with a 67 degree field of view, like the demo's, looking down -z */
+    float tan_half_fov = tanf( 67.0f * 0.5f * (float)ONE_DEG_IN_RAD );
+    for ( int y = 0; y < BATCH_IMAGE_DIMS; y++ ) {
+      for ( int x = 0; x < BATCH_IMAGE_DIMS; x++ ) {
+        float ndc_x = ( 2.0f * ( x + 0.5f ) ) / BATCH_IMAGE_DIMS - 1.0f;
+        float ndc_y = 1.0f - ( 2.0f * ( y + 0.5f ) ) / BATCH_IMAGE_DIMS;
+        set_batch_ray( &batch, y * BATCH_IMAGE_DIMS + x, cam_pos, normalise( vec3( ndc_x * tan_half_fov, ndc_y * tan_half_fov, -1.0f ) ), FLT_MAX );
+      }
+    }
+    benchmark_batch( &scene, &batch, "camera", max_threads );
+    for ( int i = 0; i < batch.n_rays; i++ ) { set_batch_ray( &batch, i, cam_pos, ray_d[i % N_RAYS], FLT_MAX ); }
+    benchmark_batch( &scene, &batch, "random", max_threads );
+  }
+
+  free_ray_batch( &batch );
+  free_scene_bvh( &scene );
+  free_mesh_bvh( &mesh );
+  free( ray_d );
+  free( vp );
+  free( vt );
+  free( vn );
+  return 0;
+}
@@ -100,8 +100,10 @@ bool start_gl() {
     return false;
   }
 
+  /* 4.3 for multi-draw indirect, in mdi_renderer.h. macOS stops at 4.1 so fall
+  back to that if a 4.3 window can't be made */
   glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
-  glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 1 );
+  glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 3 );
   glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
   glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
   glfwWindowHint( GLFW_SAMPLES, 4 );
@@ -113,6 +115,10 @@ bool start_gl() {
   );*/
 
   g_window = glfwCreateWindow( g_gl_window_width, g_gl_window_height, "Extended Init.", NULL, NULL );
+  if ( !g_window ) {
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 1 );
+    g_window = glfwCreateWindow( g_gl_window_width, g_gl_window_height, "Extended Init.", NULL, NULL );
+  }
   if ( !g_window ) {
     fprintf( stderr, "ERROR: could not open window with GLFW3\n" );
     glfwTerminate();
@@ -8,8 +8,10 @@
 |******************************************************************************|
 | Mouse Picking with Ray Casting .                                             |
 \******************************************************************************/
+#include "bvh.h"         // bounding volume hierarchies for fast ray casts
 #include "gl_utils.h"    // common opengl functions and small utilities like logs
 #include "maths_funcs.h" // my maths functions
+#include "mdi_renderer.h" // draws every sphere with one multi-draw call
 #include "obj_parser.h"  // my little Wavefront .obj mesh loader
 #include <GL/glew.h>     // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h>  // GLFW helper library
@@ -20,17 +22,30 @@
 #define MESH_FILE "sphere.obj"
 #define VERTEX_SHADER_FILE "test_vs.glsl"
 #define FRAGMENT_SHADER_FILE "test_fs.glsl"
-#define NUM_SPHERES 4
+#define MDI_VERTEX_SHADER_FILE "mdi_vs.glsl"
+#define MDI_FRAGMENT_SHADER_FILE "mdi_fs.glsl"
+// biggest scene. keys 1-4 switch between 4, 1000, 10000, and 100000 spheres
+#define MAX_SPHERES 100000
 
 // camera matrices. it's easier if they are global
 mat4 view_mat;
 mat4 proj_mat;
 vec3 cam_pos( 0.0f, 0.0f, 5.0f );
-// a world position for each sphere in the scene
-vec3 sphere_pos_wor[]     = { vec3( -2.0, 0.0, 0.0 ), vec3( 2.0, 0.0, 0.0 ), vec3( -2.0, 0.0, -2.0 ), vec3( 1.5, 1.0, -1.0 ) };
-const float sphere_radius = 1.0f;
+// a world position for each sphere in the first scene
+vec3 first_sphere_pos_wor[] = { vec3( -2.0, 0.0, 0.0 ), vec3( 2.0, 0.0, 0.0 ), vec3( -2.0, 0.0, -2.0 ), vec3( 1.5, 1.0, -1.0 ) };
+const float sphere_radius   = 1.0f;
+// world positions of the spheres in the current scene
+vec3* g_sphere_pos_wor = NULL;
+int g_num_spheres      = 0;
 // indicates which sphere is selected
 int g_selected_sphere = -1;
+// draws all the spheres in one call, if supported. otherwise one call per sphere
+mdi_renderer_t g_mdi;
+bool g_use_mdi    = false;
+int g_sphere_mesh = -1;
+// picking casts rays through a BVH of the spheres' triangles
+mesh_bvh_t g_sphere_bvh;
+scene_bvh_t g_scene_bvh;
 
 /* takes mouse position on screen and return ray in world coords */
 vec3 get_ray_from_mouse( float mouse_x, float mouse_y ) {
@@ -52,42 +67,107 @@ vec3 get_ray_from_mouse( float mouse_x, float mouse_y ) {
   return ray_wor;
 }
 
-/* check if a ray and a sphere intersect. if not hit, returns false. it rejects
-intersections behind the ray caster's origin, and sets intersection_distance to
-the closest intersection */
-bool ray_sphere( vec3 ray_origin_wor, vec3 ray_direction_wor, vec3 sphere_centre_wor, float sphere_radius, float* intersection_distance ) {
-  // work out components of quadratic
-  vec3 dist_to_sphere     = ray_origin_wor - sphere_centre_wor;
-  float b                 = dot( ray_direction_wor, dist_to_sphere );
-  float c                 = dot( dist_to_sphere, dist_to_sphere ) - sphere_radius * sphere_radius;
-  float b_squared_minus_c = b * b - c;
-  // check for "imaginary" answer. == ray completely misses sphere
-  if ( b_squared_minus_c < 0.0f ) { return false; }
-  // check for ray hitting twice (in and out of the sphere)
-  if ( b_squared_minus_c > 0.0f ) {
-    // get the 2 intersection distances along ray
-    float t_a              = -b + sqrt( b_squared_minus_c );
-    float t_b              = -b - sqrt( b_squared_minus_c );
-    *intersection_distance = t_b;
-    // if behind viewer, throw one or both away
-    if ( t_a < 0.0 ) {
-      if ( t_b < 0.0 ) { return false; }
-    } else if ( t_b < 0.0 ) {
-      *intersection_distance = t_a;
+/* the selected sphere is drawn blue */
+void select_sphere( int sphere ) {
+  if ( g_use_mdi ) {
+    if ( g_selected_sphere >= 0 ) { mdi_set_object_colour( &g_mdi, g_selected_sphere, 1.0f, 0.0f, 0.0f ); }
+    if ( sphere >= 0 ) { mdi_set_object_colour( &g_mdi, sphere, 1.0f, 0.0f, 1.0f ); }
+  }
+  g_selected_sphere = sphere;
+}
+
+/* the first scene has 4 hand-placed spheres. bigger ones are a cubic grid of
+spheres going away from the camera */
+void create_scene( int num_spheres ) {
+  assert( num_spheres <= MAX_SPHERES );
+  g_num_spheres     = num_spheres;
+  g_selected_sphere = -1;
+  if ( 4 == num_spheres ) {
+    for ( int i = 0; i < 4; i++ ) { g_sphere_pos_wor[i] = first_sphere_pos_wor[i]; }
+  } else {
+    int side      = (int)ceil( cbrt( (double)num_spheres ) );
+    float spacing = 3.0f * sphere_radius;
+    float half    = 0.5f * spacing * ( side - 1 );
+    for ( int i = 0; i < num_spheres; i++ ) {
+      int x               = i % side;
+      int y               = ( i / side ) % side;
+      int z               = i / ( side * side );
+      g_sphere_pos_wor[i] = vec3( x * spacing - half, y * spacing - half, -2.0f - z * spacing );
     }
+  }
+  double start = glfwGetTime();
+  clear_scene_bvh( &g_scene_bvh );
+  for ( int i = 0; i < num_spheres; i++ ) { add_scene_bvh_object( &g_scene_bvh, &g_sphere_bvh, translate( identity_mat4(), g_sphere_pos_wor[i] ) ); }
+  build_scene_bvh( &g_scene_bvh );
+  gl_log( "built scene BVH of %i spheres in %.3fms. %i nodes\n", num_spheres, ( glfwGetTime() - start ) * 1000.0, g_scene_bvh.n_nodes );
+  if ( g_use_mdi ) {
+    mdi_clear_objects( &g_mdi );
+    for ( int i = 0; i < num_spheres; i++ ) {
+      mat4 M = translate( identity_mat4(), g_sphere_pos_wor[i] );
+      mdi_add_object( &g_mdi, g_sphere_mesh, M.m, 1.0f, 0.0f, 0.0f );
+    }
+  }
+  printf( "scene has %i spheres\n", num_spheres );
+}
 
-    return true;
+/* the original way - set uniforms and draw for each sphere */
+void draw_spheres_one_by_one( GLuint vao, int point_count, int model_mat_location, int blue_location ) {
+  glBindVertexArray( vao );
+  for ( int i = 0; i < g_num_spheres; i++ ) {
+    if ( g_selected_sphere == i ) {
+      glUniform1f( blue_location, 1.0f );
+    } else {
+      glUniform1f( blue_location, 0.0f );
+    }
+    mat4 M = translate( identity_mat4(), g_sphere_pos_wor[i] );
+    glUniformMatrix4fv( model_mat_location, 1, GL_FALSE, M.m );
+    glDrawArrays( GL_TRIANGLES, 0, point_count );
+  }
+}
+
+/* compares the CPU time spent submitting a frame's draws, and the whole frame
+time, for one call per sphere against one multi-draw, at 16, 1000, 10000, and
+100000 spheres. the multi-draw is timed with nothing changed, and with every
+object re-uploaded */
+void benchmark_submission( GLuint vao, int point_count, GLuint programme, GLuint mdi_programme, int model_mat_location, int blue_location ) {
+  if ( !g_use_mdi ) {
+    printf( "multi-draw indirect is not supported here. nothing to compare\n" );
+    return;
   }
-  // check for ray hitting once (skimming the surface)
-  if ( 0.0f == b_squared_minus_c ) {
-    // if behind viewer, throw away
-    float t = -b + sqrt( b_squared_minus_c );
-    if ( t < 0.0f ) { return false; }
-    *intersection_distance = t;
-    return true;
+  const int sizes[]        = { 16, 1000, 10000, 100000 };
+  const int n_sizes        = 4;
+  const int n_frames       = 10;
+  int previous_num_spheres = g_num_spheres;
+  gl_log( "benchmarking draw submission over %i frames per test...\n", n_frames );
+  for ( int s = 0; s < n_sizes; s++ ) {
+    create_scene( sizes[s] );
+    double cpu_ms[3] = { 0.0 }, frame_ms[3] = { 0.0 };
+    for ( int test = 0; test < 3; test++ ) {
+      if ( 0 == test ) { glUseProgram( programme ); }
+      if ( test > 0 ) { glUseProgram( mdi_programme ); }
+      for ( int f = 0; f < n_frames; f++ ) {
+        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+        glFinish();
+        double start = glfwGetTime();
+        if ( 0 == test ) {
+          draw_spheres_one_by_one( vao, point_count, model_mat_location, blue_location );
+        } else {
+          if ( 2 == test ) {
+            for ( int i = 0; i < g_num_spheres; i++ ) { mdi_set_object_colour( &g_mdi, i, 1.0f, 0.0f, 0.0f ); }
+          }
+          mdi_draw( &g_mdi );
+        }
+        double submitted = glfwGetTime();
+        glFinish();
+        double finished = glfwGetTime();
+        cpu_ms[test] += ( submitted - start ) * 1000.0 / n_frames;
+        frame_ms[test] += ( finished - start ) * 1000.0 / n_frames;
+      }
+    }
+    gl_log( "%6i spheres: one by one cpu %8.3fms frame %8.3fms | multi-draw cpu %8.3fms frame %8.3fms | multi-draw all changed cpu %8.3fms frame %8.3fms\n", sizes[s],
+      cpu_ms[0], frame_ms[0], cpu_ms[1], frame_ms[1], cpu_ms[2], frame_ms[2] );
   }
-  // note: could also check if ray origin is inside sphere radius
-  return false;
+  create_scene( previous_num_spheres );
 }
 
 /* this function is called when the mouse buttons are clicked or un-clicked */
@@ -98,28 +178,22 @@ void glfw_mouse_click_callback( GLFWwindow* window, int button, int action, int
     glfwGetCursorPos( g_window, &xpos, &ypos );
     // work out ray
     vec3 ray_wor = get_ray_from_mouse( (float)xpos, (float)ypos );
-    // check ray against all spheres in scene
-    int closest_sphere_clicked = -1;
-    float closest_intersection = 0.0f;
-    for ( int i = 0; i < NUM_SPHERES; i++ ) {
-      float t_dist = 0.0f;
-      if ( ray_sphere( cam_pos, ray_wor, sphere_pos_wor[i], sphere_radius, &t_dist ) ) {
-        // if more than one sphere is in path of ray, only use the closest one
-        if ( -1 == closest_sphere_clicked || t_dist < closest_intersection ) {
-          closest_sphere_clicked = i;
-          closest_intersection   = t_dist;
-        }
-      }
-    } // endfor
-    g_selected_sphere = closest_sphere_clicked;
-    printf( "sphere %i was clicked\n", closest_sphere_clicked );
+    // check ray against the triangles of all spheres in scene. the BVH only
+    // tests the few spheres near the ray, and gives back the closest hit
+    ray_hit_t hit;
+    double start = glfwGetTime();
+    ray_cast( &g_scene_bvh, cam_pos, ray_wor, 1000.0f, &hit );
+    double ray_ms = ( glfwGetTime() - start ) * 1000.0;
+    select_sphere( hit.object );
+    printf( "sphere %i was clicked\n", hit.object );
+    if ( hit.object >= 0 ) { printf( "  t = %.3f triangle %i barycentric (%.3f, %.3f, %.3f). ray took %.4fms\n", hit.t, hit.triangle, 1.0f - hit.u - hit.v, hit.u, hit.v, ray_ms ); }
   }
 }
 
 void update_perspective() {
   // input variables
   float near   = 0.1f;                                                           // clipping plane
-  float far    = 100.0f;                                                         // clipping plane
+  float far    = 200.0f;                                                         // clipping plane
   float fovy   = 67.0f;                                                          // 67 degrees
   float aspect = (float)g_gl_framebuffer_width / (float)g_gl_framebuffer_height; // aspect ratio
   proj_mat     = perspective( fovy, aspect, near, far );
@@ -155,6 +229,18 @@ int main() {
     glEnableVertexAttribArray( 0 );
   }
 
+  g_sphere_pos_wor = (vec3*)malloc( MAX_SPHERES * sizeof( vec3 ) );
+  g_use_mdi        = mdi_supported();
+  if ( !build_mesh_bvh( &g_sphere_bvh, vp, g_point_count ) || !init_scene_bvh( &g_scene_bvh, MAX_SPHERES ) ) { return 1; }
+  if ( g_use_mdi ) {
+    if ( !init_mdi_renderer( &g_mdi, MAX_SPHERES ) ) { return 1; }
+    g_sphere_mesh = mdi_add_mesh( &g_mdi, vp, g_point_count );
+    mdi_upload_meshes( &g_mdi );
+  } else {
+    gl_log_err( "WARNING: no multi-draw indirect support. drawing one sphere at a time\n" );
+  }
+  create_scene( 4 );
+
   /*-------------------------------CREATE SHADERS-------------------------------*/
   GLuint shader_programme = create_programme_from_files( VERTEX_SHADER_FILE, FRAGMENT_SHADER_FILE );
   int model_mat_location  = glGetUniformLocation( shader_programme, "model" );
@@ -162,6 +248,15 @@ int main() {
   int proj_mat_location   = glGetUniformLocation( shader_programme, "proj" );
   int blue_location       = glGetUniformLocation( shader_programme, "blue" );
 
+  GLuint mdi_programme      = 0;
+  int mdi_view_mat_location = -1;
+  int mdi_proj_mat_location = -1;
+  if ( g_use_mdi ) {
+    mdi_programme         = create_programme_from_files( MDI_VERTEX_SHADER_FILE, MDI_FRAGMENT_SHADER_FILE );
+    mdi_view_mat_location = glGetUniformLocation( mdi_programme, "view" );
+    mdi_proj_mat_location = glGetUniformLocation( mdi_programme, "proj" );
+  }
+
   /*-------------------------------CREATE CAMERA--------------------------------*/
   update_perspective();
 
@@ -178,10 +273,6 @@ int main() {
   vec4 up( 0.0f, 1.0f, 0.0f, 0.0f );
 
   /*---------------------------SET RENDERING DEFAULTS---------------------------*/
-  // unique model matrix for each sphere
-  mat4 model_mats[NUM_SPHERES];
-  for ( int i = 0; i < NUM_SPHERES; i++ ) { model_mats[i] = translate( identity_mat4(), sphere_pos_wor[i] ); }
-
   glEnable( GL_DEPTH_TEST );          // enable depth-testing
   glDepthFunc( GL_LESS );             // depth-testing interprets a smaller value as "closer"
   glEnable( GL_CULL_FACE );           // cull face
@@ -202,19 +293,16 @@ int main() {
     glViewport( 0, 0, g_gl_framebuffer_width, g_gl_framebuffer_height );
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
-    glUseProgram( shader_programme );
-    glUniformMatrix4fv( view_mat_location, 1, GL_FALSE, view_mat.m );
-    glUniformMatrix4fv( proj_mat_location, 1, GL_FALSE, proj_mat.m );
-    glBindVertexArray( vao );
-
-    for ( int i = 0; i < NUM_SPHERES; i++ ) {
-      if ( g_selected_sphere == i ) {
-        glUniform1f( blue_location, 1.0f );
-      } else {
-        glUniform1f( blue_location, 0.0f );
-      }
-      glUniformMatrix4fv( model_mat_location, 1, GL_FALSE, model_mats[i].m );
-      glDrawArrays( GL_TRIANGLES, 0, g_point_count );
+    if ( g_use_mdi ) {
+      glUseProgram( mdi_programme );
+      glUniformMatrix4fv( mdi_view_mat_location, 1, GL_FALSE, view_mat.m );
+      glUniformMatrix4fv( mdi_proj_mat_location, 1, GL_FALSE, proj_mat.m );
+      mdi_draw( &g_mdi );
+    } else {
+      glUseProgram( shader_programme );
+      glUniformMatrix4fv( view_mat_location, 1, GL_FALSE, view_mat.m );
+      glUniformMatrix4fv( proj_mat_location, 1, GL_FALSE, proj_mat.m );
+      draw_spheres_one_by_one( vao, g_point_count, model_mat_location, blue_location );
     }
     // update other events like input handling
     glfwPollEvents();
@@ -306,11 +394,32 @@ int main() {
       view_mat = inverse( R ) * inverse( T );
     }
 
+    // switch scene size
+    if ( glfwGetKey( g_window, GLFW_KEY_1 ) && g_num_spheres != 4 ) { create_scene( 4 ); }
+    if ( glfwGetKey( g_window, GLFW_KEY_2 ) && g_num_spheres != 1000 ) { create_scene( 1000 ); }
+    if ( glfwGetKey( g_window, GLFW_KEY_3 ) && g_num_spheres != 10000 ) { create_scene( 10000 ); }
+    if ( glfwGetKey( g_window, GLFW_KEY_4 ) && g_num_spheres != 100000 ) { create_scene( 100000 ); }
+    // benchmark on key press, not while held
+    static bool b_was_down = false;
+    bool b_is_down         = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) {
+      // both ways draw from the current camera
+      glUseProgram( shader_programme );
+      glUniformMatrix4fv( view_mat_location, 1, GL_FALSE, view_mat.m );
+      glUniformMatrix4fv( proj_mat_location, 1, GL_FALSE, proj_mat.m );
+      benchmark_submission( vao, g_point_count, shader_programme, mdi_programme, model_mat_location, blue_location );
+    }
+    b_was_down = b_is_down;
+
     if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( g_window, 1 ); }
     // put the stuff we've been drawing onto the display
     glfwSwapBuffers( g_window );
   }
 
+  if ( g_use_mdi ) { free_mdi_renderer( &g_mdi ); }
+  free_scene_bvh( &g_scene_bvh );
+  free_mesh_bvh( &g_sphere_bvh );
+  free( g_sphere_pos_wor );
   // close GL context and any other GLFW resources
   glfwTerminate();
   return 0;
@@ -0,0 +1,11 @@
+#version 430
+
+in float dist;
+flat in vec4 colour;
+out vec4 frag_colour;
+
+void main() {
+	frag_colour = colour;
+	// use z position to shader darker to help perception of distance
+	frag_colour.xyz *= dist;
+}
@@ -0,0 +1,157 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Multi-draw indirect renderer.                                                |
+\******************************************************************************/
+#include "mdi_renderer.h"
+#include "gl_utils.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* mdi_vs.glsl is #version 430 and reads the objects from a storage buffer, so
+ARB_multi_draw_indirect on an older context isn't enough */
+bool mdi_supported() { return GLEW_VERSION_4_3 && GLEW_ARB_shader_draw_parameters; }
+
+bool init_mdi_renderer( mdi_renderer_t* r, int max_objects ) {
+  memset( r, 0, sizeof( mdi_renderer_t ) );
+  r->max_objects = max_objects;
+  r->objects     = (mdi_object_t*)malloc( max_objects * sizeof( mdi_object_t ) );
+  r->commands    = (mdi_command_t*)malloc( max_objects * sizeof( mdi_command_t ) );
+  if ( !r->objects || !r->commands ) {
+    gl_log_err( "ERROR: out of memory for %i multi-draw objects\n", max_objects );
+    return false;
+  }
+  r->dirty_first = max_objects;
+  r->dirty_last  = -1;
+
+  glGenVertexArrays( 1, &r->vao );
+  glGenBuffers( 1, &r->points_vbo );
+  glGenBuffers( 1, &r->ibo );
+  glGenBuffers( 1, &r->object_ssbo );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, r->object_ssbo );
+  glBufferData( GL_SHADER_STORAGE_BUFFER, max_objects * sizeof( mdi_object_t ), NULL, GL_DYNAMIC_DRAW );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+  glGenBuffers( 1, &r->indirect_buffer );
+  glBindBuffer( GL_DRAW_INDIRECT_BUFFER, r->indirect_buffer );
+  glBufferData( GL_DRAW_INDIRECT_BUFFER, max_objects * sizeof( mdi_command_t ), NULL, GL_DYNAMIC_DRAW );
+  glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+  gl_log( "multi-draw renderer: room for %i objects, %i bytes of object data\n", max_objects, max_objects * (int)( sizeof( mdi_object_t ) + sizeof( mdi_command_t ) ) );
+  return true;
+}
+
+void free_mdi_renderer( mdi_renderer_t* r ) {
+  glDeleteBuffers( 1, &r->points_vbo );
+  glDeleteBuffers( 1, &r->ibo );
+  glDeleteBuffers( 1, &r->object_ssbo );
+  glDeleteBuffers( 1, &r->indirect_buffer );
+  glDeleteVertexArrays( 1, &r->vao );
+  free( r->points );
+  free( r->indices );
+  free( r->objects );
+  free( r->commands );
+  memset( r, 0, sizeof( mdi_renderer_t ) );
+}
+
+int mdi_add_mesh( mdi_renderer_t* r, const GLfloat* points, int point_count ) {
+  if ( r->n_meshes >= MDI_MAX_MESHES ) {
+    gl_log_err( "ERROR: multi-draw renderer already has %i meshes\n", MDI_MAX_MESHES );
+    return -1;
+  }
+  r->points  = (GLfloat*)realloc( r->points, ( r->n_points + point_count ) * 3 * sizeof( GLfloat ) );
+  r->indices = (GLuint*)realloc( r->indices, ( r->n_indices + point_count ) * sizeof( GLuint ) );
+  assert( r->points && r->indices );
+  memcpy( &r->points[r->n_points * 3], points, point_count * 3 * sizeof( GLfloat ) );
+  /* the mesh is unindexed so its indices just count up. they are relative to
+  the mesh's base vertex so every mesh's indices start at 0 */
+  for ( int i = 0; i < point_count; i++ ) { r->indices[r->n_indices + i] = (GLuint)i; }
+
+  mdi_mesh_t* mesh  = &r->meshes[r->n_meshes];
+  mesh->first_index = r->n_indices;
+  mesh->index_count = point_count;
+  mesh->base_vertex = r->n_points;
+  r->n_points += point_count;
+  r->n_indices += point_count;
+  return r->n_meshes++;
+}
+
+void mdi_upload_meshes( mdi_renderer_t* r ) {
+  glBindVertexArray( r->vao );
+  glBindBuffer( GL_ARRAY_BUFFER, r->points_vbo );
+  glBufferData( GL_ARRAY_BUFFER, r->n_points * 3 * sizeof( GLfloat ), r->points, GL_STATIC_DRAW );
+  glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, 0, NULL );
+  glEnableVertexAttribArray( 0 );
+  glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, r->ibo );
+  glBufferData( GL_ELEMENT_ARRAY_BUFFER, r->n_indices * sizeof( GLuint ), r->indices, GL_STATIC_DRAW );
+  glBindVertexArray( 0 );
+  gl_log( "multi-draw renderer: %i meshes, %i vertices, %i indices\n", r->n_meshes, r->n_points, r->n_indices );
+}
+
+static void mark_dirty( mdi_renderer_t* r, int object ) {
+  if ( object < r->dirty_first ) { r->dirty_first = object; }
+  if ( object > r->dirty_last ) { r->dirty_last = object; }
+}
+
+void mdi_clear_objects( mdi_renderer_t* r ) {
+  r->n_objects   = 0;
+  r->dirty_first = r->max_objects;
+  r->dirty_last  = -1;
+}
+
+int mdi_add_object( mdi_renderer_t* r, int mesh, const GLfloat* M, float red, float green, float blue ) {
+  assert( mesh >= 0 && mesh < r->n_meshes );
+  if ( r->n_objects >= r->max_objects ) {
+    gl_log_err( "ERROR: multi-draw renderer is full with %i objects\n", r->max_objects );
+    return -1;
+  }
+  int object = r->n_objects++;
+  mdi_set_object_matrix( r, object, M );
+  mdi_set_object_colour( r, object, red, green, blue );
+
+  mdi_command_t* cmd  = &r->commands[object];
+  cmd->count          = r->meshes[mesh].index_count;
+  cmd->instance_count = 1;
+  cmd->first_index    = r->meshes[mesh].first_index;
+  cmd->base_vertex    = r->meshes[mesh].base_vertex;
+  cmd->base_instance  = 0;
+  return object;
+}
+
+void mdi_set_object_matrix( mdi_renderer_t* r, int object, const GLfloat* M ) {
+  assert( object >= 0 && object < r->n_objects );
+  memcpy( r->objects[object].M, M, 16 * sizeof( GLfloat ) );
+  mark_dirty( r, object );
+}
+
+void mdi_set_object_colour( mdi_renderer_t* r, int object, float red, float green, float blue ) {
+  assert( object >= 0 && object < r->n_objects );
+  GLfloat* c = r->objects[object].colour;
+  c[0]       = red;
+  c[1]       = green;
+  c[2]       = blue;
+  c[3]       = 1.0f;
+  mark_dirty( r, object );
+}
+
+void mdi_draw( mdi_renderer_t* r ) {
+  if ( r->n_objects < 1 ) { return; }
+  glBindBuffer( GL_DRAW_INDIRECT_BUFFER, r->indirect_buffer );
+  if ( r->dirty_first <= r->dirty_last ) {
+    int n = r->dirty_last - r->dirty_first + 1;
+    glBindBuffer( GL_SHADER_STORAGE_BUFFER, r->object_ssbo );
+    glBufferSubData( GL_SHADER_STORAGE_BUFFER, r->dirty_first * sizeof( mdi_object_t ), n * sizeof( mdi_object_t ), &r->objects[r->dirty_first] );
+    /* commands only change when objects are added, but are small enough that
+    keeping a separate range for them isn't worth it */
+    glBufferSubData( GL_DRAW_INDIRECT_BUFFER, r->dirty_first * sizeof( mdi_command_t ), n * sizeof( mdi_command_t ), &r->commands[r->dirty_first] );
+    r->dirty_first = r->max_objects;
+    r->dirty_last  = -1;
+  }
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, MDI_OBJECT_SSBO_BINDING, r->object_ssbo );
+  glBindVertexArray( r->vao );
+  glMultiDrawElementsIndirect( GL_TRIANGLES, GL_UNSIGNED_INT, NULL, r->n_objects, 0 );
+}
@@ -0,0 +1,92 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Multi-draw indirect renderer.                                                |
+| Draws a whole scene of objects with one glMultiDrawElementsIndirect() call.  |
+| All meshes share one vertex buffer and one index buffer. Each object gets a  |
+| draw command that picks out its mesh's range of indices, and an entry in a   |
+| shader storage buffer with its model matrix and colour. The vertex shader    |
+| uses gl_DrawIDARB to find its object's entry. The CPU cost of a frame is     |
+| then the same for 10 objects or 100000 - only the GPU work grows.            |
+| Objects that change are tracked as a dirty range, and only that range is     |
+| uploaded before the next draw.                                               |
+|                                                                              |
+| Needs GL 4.3 and ARB_shader_draw_parameters. Check mdi_supported() and draw  |
+| with one call per object if it returns false (e.g. on macOS).                |
+\******************************************************************************/
+#ifndef _MDI_RENDERER_H_
+#define _MDI_RENDERER_H_
+
+#include <GL/glew.h>
+
+#define MDI_MAX_MESHES 16
+/* must match the binding of object_block in the vertex shader */
+#define MDI_OBJECT_SSBO_BINDING 0
+
+/* same layout as the struct in the vertex shader, with std430 rules */
+struct mdi_object_t {
+  GLfloat M[16];
+  GLfloat colour[4];
+};
+
+/* layout defined by GL for indirect glDrawElements() commands */
+struct mdi_command_t {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first_index;
+  GLint base_vertex;
+  GLuint base_instance;
+};
+
+struct mdi_mesh_t {
+  GLuint first_index;
+  GLuint index_count;
+  GLint base_vertex;
+};
+
+struct mdi_renderer_t {
+  GLuint vao;
+  GLuint points_vbo;
+  GLuint ibo;
+  GLuint object_ssbo;
+  GLuint indirect_buffer;
+  /* meshes are gathered here until mdi_upload_meshes() */
+  GLfloat* points;
+  GLuint* indices;
+  int n_points, n_indices;
+  mdi_mesh_t meshes[MDI_MAX_MESHES];
+  int n_meshes;
+  /* CPU copies of the per-object buffers */
+  mdi_object_t* objects;
+  mdi_command_t* commands;
+  int n_objects, max_objects;
+  /* range of objects to upload before the next draw. first > last if clean */
+  int dirty_first, dirty_last;
+};
+
+/* true if this context can draw with mdi_draw() */
+bool mdi_supported();
+bool init_mdi_renderer( mdi_renderer_t* r, int max_objects );
+void free_mdi_renderer( mdi_renderer_t* r );
+/* adds an unindexed triangle mesh, e.g. from load_obj_file(). points are xyz.
+returns the mesh's index, or -1 if there is no room */
+int mdi_add_mesh( mdi_renderer_t* r, const GLfloat* points, int point_count );
+/* copies all added meshes to the GPU. call once after the last mdi_add_mesh() */
+void mdi_upload_meshes( mdi_renderer_t* r );
+
+void mdi_clear_objects( mdi_renderer_t* r );
+/* returns the object's index, which is also its gl_DrawIDARB. -1 if full */
+int mdi_add_object( mdi_renderer_t* r, int mesh, const GLfloat* M, float red, float green, float blue );
+void mdi_set_object_matrix( mdi_renderer_t* r, int object, const GLfloat* M );
+void mdi_set_object_colour( mdi_renderer_t* r, int object, float red, float green, float blue );
+
+/* uploads any changed objects then draws every object with one call. the
+caller uses its own programme and sets its view and projection uniforms */
+void mdi_draw( mdi_renderer_t* r );
+
+#endif
@@ -0,0 +1,27 @@
+#version 430
+// gl_DrawIDARB - which draw command of a multi-draw this vertex belongs to
+#extension GL_ARB_shader_draw_parameters : require
+
+layout(location = 0) in vec3 vertex_position;
+
+/* per-object data for the whole scene. the multi-draw has one command per
+object, in the same order, so the draw ID indexes this array */
+struct object_t {
+	mat4 model;
+	vec4 colour;
+};
+layout(std430, binding = 0) readonly buffer object_block {
+	object_t objects[];
+};
+
+uniform mat4 view, proj;
+// use z position to shader darker to help perception of distance
+out float dist;
+flat out vec4 colour;
+
+void main() {
+	object_t obj = objects[gl_DrawIDARB];
+	gl_Position = proj * view * obj.model * vec4 (vertex_position, 1.0);
+	dist = vertex_position.z;
+	colour = obj.colour;
+}
@@ -0,0 +1,423 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Batches of ray casts against a scene BVH.                                    |
+\******************************************************************************/
+#include "ray_batch.h"
+#include <assert.h>
+#include <atomic>
+#include <condition_variable>
+#include <float.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+/*-----------------------------------SIMD-------------------------------------*/
+/* a few wrappers so the packet code below is written once for both widths */
+#if defined( __AVX__ )
+#include <immintrin.h>
+#define RAY_PACKET_SIZE 8
+typedef __m256 simd_t;
+static inline simd_t simd_set1( float f ) { return _mm256_set1_ps( f ); }
+static inline simd_t simd_load( const float* p ) { return _mm256_loadu_ps( p ); }
+static inline void simd_store( float* p, simd_t a ) { _mm256_storeu_ps( p, a ); }
+static inline simd_t simd_add( simd_t a, simd_t b ) { return _mm256_add_ps( a, b ); }
+static inline simd_t simd_sub( simd_t a, simd_t b ) { return _mm256_sub_ps( a, b ); }
+static inline simd_t simd_mul( simd_t a, simd_t b ) { return _mm256_mul_ps( a, b ); }
+static inline simd_t simd_div( simd_t a, simd_t b ) { return _mm256_div_ps( a, b ); }
+static inline simd_t simd_min( simd_t a, simd_t b ) { return _mm256_min_ps( a, b ); }
+static inline simd_t simd_max( simd_t a, simd_t b ) { return _mm256_max_ps( a, b ); }
+static inline simd_t simd_lt( simd_t a, simd_t b ) { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+static inline simd_t simd_le( simd_t a, simd_t b ) { return _mm256_cmp_ps( a, b, _CMP_LE_OQ ); }
+static inline simd_t simd_and( simd_t a, simd_t b ) { return _mm256_and_ps( a, b ); }
+static inline simd_t simd_andnot( simd_t a, simd_t b ) { return _mm256_andnot_ps( a, b ); }
+static inline simd_t simd_or( simd_t a, simd_t b ) { return _mm256_or_ps( a, b ); }
+static inline int simd_mask_bits( simd_t a ) { return _mm256_movemask_ps( a ); }
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define RAY_PACKET_SIZE 4
+typedef __m128 simd_t;
+static inline simd_t simd_set1( float f ) { return _mm_set1_ps( f ); }
+static inline simd_t simd_load( const float* p ) { return _mm_loadu_ps( p ); }
+static inline void simd_store( float* p, simd_t a ) { _mm_storeu_ps( p, a ); }
+static inline simd_t simd_add( simd_t a, simd_t b ) { return _mm_add_ps( a, b ); }
+static inline simd_t simd_sub( simd_t a, simd_t b ) { return _mm_sub_ps( a, b ); }
+static inline simd_t simd_mul( simd_t a, simd_t b ) { return _mm_mul_ps( a, b ); }
+static inline simd_t simd_div( simd_t a, simd_t b ) { return _mm_div_ps( a, b ); }
+static inline simd_t simd_min( simd_t a, simd_t b ) { return _mm_min_ps( a, b ); }
+static inline simd_t simd_max( simd_t a, simd_t b ) { return _mm_max_ps( a, b ); }
+static inline simd_t simd_lt( simd_t a, simd_t b ) { return _mm_cmplt_ps( a, b ); }
+static inline simd_t simd_le( simd_t a, simd_t b ) { return _mm_cmple_ps( a, b ); }
+static inline simd_t simd_and( simd_t a, simd_t b ) { return _mm_and_ps( a, b ); }
+static inline simd_t simd_andnot( simd_t a, simd_t b ) { return _mm_andnot_ps( a, b ); }
+static inline simd_t simd_or( simd_t a, simd_t b ) { return _mm_or_ps( a, b ); }
+static inline int simd_mask_bits( simd_t a ) { return _mm_movemask_ps( a ); }
+#else
+#define RAY_PACKET_SIZE 1
+#endif
+
+int ray_packet_size() { return RAY_PACKET_SIZE; }
+
+/*---------------------------------BATCHES------------------------------------*/
+bool alloc_ray_batch( ray_batch_t* batch, int n_rays ) {
+  memset( batch, 0, sizeof( ray_batch_t ) );
+  batch->n_rays = n_rays;
+  bool ok       = true;
+  for ( int i = 0; i < 3; i++ ) {
+    batch->origin[i]    = (float*)malloc( n_rays * sizeof( float ) );
+    batch->direction[i] = (float*)malloc( n_rays * sizeof( float ) );
+    ok                  = ok && batch->origin[i] && batch->direction[i];
+  }
+  batch->max_t    = (float*)malloc( n_rays * sizeof( float ) );
+  batch->t        = (float*)malloc( n_rays * sizeof( float ) );
+  batch->object   = (int*)malloc( n_rays * sizeof( int ) );
+  batch->triangle = (int*)malloc( n_rays * sizeof( int ) );
+  if ( !ok || !batch->max_t || !batch->t || !batch->object || !batch->triangle ) {
+    fprintf( stderr, "ERROR: out of memory for a batch of %i rays\n", n_rays );
+    free_ray_batch( batch );
+    return false;
+  }
+  return true;
+}
+
+void free_ray_batch( ray_batch_t* batch ) {
+  for ( int i = 0; i < 3; i++ ) {
+    free( batch->origin[i] );
+    free( batch->direction[i] );
+  }
+  free( batch->max_t );
+  free( batch->t );
+  free( batch->object );
+  free( batch->triangle );
+  memset( batch, 0, sizeof( ray_batch_t ) );
+}
+
+void set_batch_ray( ray_batch_t* batch, int i, vec3 origin, vec3 direction, float max_t ) {
+  assert( i >= 0 && i < batch->n_rays );
+  for ( int c = 0; c < 3; c++ ) {
+    batch->origin[c][i]    = origin.v[c];
+    batch->direction[c][i] = direction.v[c];
+  }
+  batch->max_t[i] = max_t;
+}
+
+/*----------------------------PACKET TRAVERSAL--------------------------------*/
+#if RAY_PACKET_SIZE > 1
+struct ray_packet_t {
+  simd_t o[3], d[3], inv_d[3];
+  simd_t t;
+  int triangle[RAY_PACKET_SIZE];
+};
+
+struct packet_stack_entry_t {
+  const bvh_node_t* node;
+  float t_enter;
+};
+
+/* slab test for every ray at once. returns a bit per ray that hits, and the
+closest entry distance of those rays */
+static inline int packet_box( const ray_packet_t* p, const bvh_node_t* node, float* t_enter ) {
+  simd_t t1   = simd_mul( simd_sub( simd_set1( node->min[0] ), p->o[0] ), p->inv_d[0] );
+  simd_t t2   = simd_mul( simd_sub( simd_set1( node->max[0] ), p->o[0] ), p->inv_d[0] );
+  simd_t tmin = simd_min( t1, t2 );
+  simd_t tmax = simd_max( t1, t2 );
+  for ( int i = 1; i < 3; i++ ) {
+    t1   = simd_mul( simd_sub( simd_set1( node->min[i] ), p->o[i] ), p->inv_d[i] );
+    t2   = simd_mul( simd_sub( simd_set1( node->max[i] ), p->o[i] ), p->inv_d[i] );
+    tmin = simd_max( tmin, simd_min( t1, t2 ) );
+    tmax = simd_min( tmax, simd_max( t1, t2 ) );
+  }
+  simd_t hit = simd_and( simd_and( simd_le( tmin, tmax ), simd_lt( simd_set1( 0.0f ), tmax ) ), simd_lt( tmin, p->t ) );
+  int bits   = simd_mask_bits( hit );
+  if ( !bits ) { return 0; }
+  float lanes[RAY_PACKET_SIZE];
+  simd_store( lanes, tmin );
+  *t_enter = FLT_MAX;
+  for ( int i = 0; i < RAY_PACKET_SIZE; i++ ) {
+    if ( ( bits & ( 1 << i ) ) && lanes[i] < *t_enter ) { *t_enter = lanes[i]; }
+  }
+  return bits;
+}
+
+/* furthest current hit of any ray in the packet. nodes entered beyond this
+can't hold a closer hit for any of them */
+static inline float packet_max_t( const ray_packet_t* p ) {
+  float lanes[RAY_PACKET_SIZE];
+  simd_store( lanes, p->t );
+  float max_t = lanes[0];
+  for ( int i = 1; i < RAY_PACKET_SIZE; i++ ) { max_t = lanes[i] > max_t ? lanes[i] : max_t; }
+  return max_t;
+}
+
+/* Moller-Trumbore for every ray against one triangle. returns a bit per ray
+that hits closer than its current t, and updates t */
+static inline int packet_triangle( ray_packet_t* p, const float* tri ) {
+  simd_t e1[3], e2[3], s[3];
+  for ( int i = 0; i < 3; i++ ) {
+    e1[i] = simd_set1( tri[3 + i] - tri[i] );
+    e2[i] = simd_set1( tri[6 + i] - tri[i] );
+    s[i]  = simd_sub( p->o[i], simd_set1( tri[i] ) );
+  }
+  simd_t px      = simd_sub( simd_mul( p->d[1], e2[2] ), simd_mul( p->d[2], e2[1] ) );
+  simd_t py      = simd_sub( simd_mul( p->d[2], e2[0] ), simd_mul( p->d[0], e2[2] ) );
+  simd_t pz      = simd_sub( simd_mul( p->d[0], e2[1] ), simd_mul( p->d[1], e2[0] ) );
+  simd_t det     = simd_add( simd_add( simd_mul( e1[0], px ), simd_mul( e1[1], py ) ), simd_mul( e1[2], pz ) );
+  simd_t abs_det = simd_andnot( simd_set1( -0.0f ), det );
+  simd_t inv_det = simd_div( simd_set1( 1.0f ), det );
+  simd_t u       = simd_mul( simd_add( simd_add( simd_mul( s[0], px ), simd_mul( s[1], py ) ), simd_mul( s[2], pz ) ), inv_det );
+  simd_t qx      = simd_sub( simd_mul( s[1], e1[2] ), simd_mul( s[2], e1[1] ) );
+  simd_t qy      = simd_sub( simd_mul( s[2], e1[0] ), simd_mul( s[0], e1[2] ) );
+  simd_t qz      = simd_sub( simd_mul( s[0], e1[1] ), simd_mul( s[1], e1[0] ) );
+  simd_t v       = simd_mul( simd_add( simd_add( simd_mul( p->d[0], qx ), simd_mul( p->d[1], qy ) ), simd_mul( p->d[2], qz ) ), inv_det );
+  simd_t t       = simd_mul( simd_add( simd_add( simd_mul( e2[0], qx ), simd_mul( e2[1], qy ) ), simd_mul( e2[2], qz ) ), inv_det );
+  simd_t zero    = simd_set1( 0.0f );
+  simd_t hit     = simd_lt( simd_set1( 1e-12f ), abs_det );
+  hit            = simd_and( hit, simd_and( simd_le( zero, u ), simd_le( zero, v ) ) );
+  hit            = simd_and( hit, simd_le( simd_add( u, v ), simd_set1( 1.0f ) ) );
+  hit            = simd_and( hit, simd_and( simd_lt( zero, t ), simd_lt( t, p->t ) ) );
+  p->t           = simd_or( simd_and( hit, t ), simd_andnot( hit, p->t ) );
+  return simd_mask_bits( hit );
+}
+
+/* tests a leaf's primitives and returns a bit per ray that found a closer hit */
+typedef int ( *visit_leaf_func_t )( const bvh_node_t* node, ray_packet_t* p, void* context );
+
+/* both levels walk their tree the same way, with a different visit_leaf() */
+static int traverse_packet( const bvh_node_t* nodes, ray_packet_t* p, visit_leaf_func_t visit_leaf, void* context ) {
+  packet_stack_entry_t stack[BVH_STACK_SIZE];
+  int stack_size = 0;
+  int hit_bits   = 0;
+  float t_enter  = 0.0f;
+  if ( !packet_box( p, &nodes[0], &t_enter ) ) { return 0; }
+  stack[stack_size].node      = &nodes[0];
+  stack[stack_size++].t_enter = t_enter;
+  while ( stack_size > 0 ) {
+    packet_stack_entry_t entry = stack[--stack_size];
+    if ( entry.t_enter >= packet_max_t( p ) ) { continue; } // every ray has hit something closer
+    const bvh_node_t* node = entry.node;
+    while ( true ) {
+      if ( node->count > 0 ) {
+        hit_bits |= visit_leaf( node, p, context );
+        break;
+      }
+      const bvh_node_t* a = &nodes[node->left_first];
+      const bvh_node_t* b = &nodes[node->left_first + 1];
+      float ta            = FLT_MAX;
+      float tb            = FLT_MAX;
+      int a_bits          = packet_box( p, a, &ta );
+      int b_bits          = packet_box( p, b, &tb );
+      if ( !a_bits && !b_bits ) { break; }
+      if ( !a_bits ) {
+        node = b;
+        continue;
+      }
+      if ( !b_bits ) {
+        node = a;
+        continue;
+      }
+      /* go on to the nearer child and come back for the other one */
+      assert( stack_size < BVH_STACK_SIZE );
+      if ( ta <= tb ) {
+        stack[stack_size].node      = b;
+        stack[stack_size++].t_enter = tb;
+        node                        = a;
+      } else {
+        stack[stack_size].node      = a;
+        stack[stack_size++].t_enter = ta;
+        node                        = b;
+      }
+    }
+  }
+  return hit_bits;
+}
+
+/* context is the mesh_bvh_t */
+static int visit_mesh_leaf( const bvh_node_t* node, ray_packet_t* p, void* context ) {
+  const mesh_bvh_t* mesh = (const mesh_bvh_t*)context;
+  int hit_bits           = 0;
+  for ( int i = node->left_first; i < node->left_first + node->count; i++ ) {
+    int bits = packet_triangle( p, &mesh->tris[i * 9] );
+    for ( int lane = 0; lane < RAY_PACKET_SIZE; lane++ ) {
+      if ( bits & ( 1 << lane ) ) { p->triangle[lane] = mesh->tri_ids[i]; }
+    }
+    hit_bits |= bits;
+  }
+  return hit_bits;
+}
+
+struct scene_leaf_context_t {
+  const scene_bvh_t* bvh;
+  int object[RAY_PACKET_SIZE];
+};
+
+/* context is a scene_leaf_context_t */
+static int visit_scene_leaf( const bvh_node_t* node, ray_packet_t* p, void* context ) {
+  scene_leaf_context_t* ctx = (scene_leaf_context_t*)context;
+  const scene_bvh_t* bvh    = ctx->bvh;
+  int hit_bits              = 0;
+  for ( int i = node->left_first; i < node->left_first + node->count; i++ ) {
+    /* move the packet into mesh space, as in ray_cast() */
+    int id                  = bvh->object_ids[i];
+    const bvh_object_t* obj = &bvh->objects[id];
+    const float* m          = obj->inv_M.m;
+    ray_packet_t mp;
+    for ( int c = 0; c < 3; c++ ) {
+      mp.o[c] = simd_add( simd_add( simd_mul( simd_set1( m[c] ), p->o[0] ), simd_mul( simd_set1( m[4 + c] ), p->o[1] ) ),
+        simd_add( simd_mul( simd_set1( m[8 + c] ), p->o[2] ), simd_set1( m[12 + c] ) ) );
+      mp.d[c]     = simd_add( simd_add( simd_mul( simd_set1( m[c] ), p->d[0] ), simd_mul( simd_set1( m[4 + c] ), p->d[1] ) ), simd_mul( simd_set1( m[8 + c] ), p->d[2] ) );
+      mp.inv_d[c] = simd_div( simd_set1( 1.0f ), mp.d[c] );
+    }
+    mp.t     = p->t;
+    int bits = traverse_packet( obj->mesh->nodes, &mp, visit_mesh_leaf, (void*)obj->mesh );
+    if ( !bits ) { continue; }
+    p->t = mp.t;
+    for ( int lane = 0; lane < RAY_PACKET_SIZE; lane++ ) {
+      if ( bits & ( 1 << lane ) ) {
+        ctx->object[lane] = id;
+        p->triangle[lane] = mp.triangle[lane];
+      }
+    }
+    hit_bits |= bits;
+  }
+  return hit_bits;
+}
+
+static void cast_chunk( const scene_bvh_t* bvh, ray_batch_t* batch, int first, int count ) {
+  const int w = RAY_PACKET_SIZE;
+  for ( int i = first; i < first + count; i += w ) {
+    /* gather the packet. a short packet at the end repeats its last ray */
+    float lanes[7][RAY_PACKET_SIZE];
+    for ( int lane = 0; lane < w; lane++ ) {
+      int r = i + lane < first + count ? i + lane : first + count - 1;
+      for ( int c = 0; c < 3; c++ ) {
+        lanes[c][lane]     = batch->origin[c][r];
+        lanes[3 + c][lane] = batch->direction[c][r];
+      }
+      lanes[6][lane] = batch->max_t[r];
+    }
+    ray_packet_t p;
+    for ( int c = 0; c < 3; c++ ) {
+      p.o[c]     = simd_load( lanes[c] );
+      p.d[c]     = simd_load( lanes[3 + c] );
+      p.inv_d[c] = simd_div( simd_set1( 1.0f ), p.d[c] );
+    }
+    p.t = simd_load( lanes[6] );
+    scene_leaf_context_t ctx;
+    ctx.bvh = bvh;
+    for ( int lane = 0; lane < w; lane++ ) {
+      ctx.object[lane] = -1;
+      p.triangle[lane] = -1;
+    }
+    if ( bvh->n_nodes > 0 ) { traverse_packet( bvh->nodes, &p, visit_scene_leaf, &ctx ); }
+    simd_store( lanes[0], p.t );
+    for ( int lane = 0; lane < w && i + lane < first + count; lane++ ) {
+      batch->t[i + lane]        = lanes[0][lane];
+      batch->object[i + lane]   = ctx.object[lane];
+      batch->triangle[i + lane] = p.triangle[lane];
+    }
+  }
+}
+#else
+static void cast_chunk( const scene_bvh_t* bvh, ray_batch_t* batch, int first, int count ) {
+  for ( int i = first; i < first + count; i++ ) {
+    ray_hit_t hit;
+    vec3 o( batch->origin[0][i], batch->origin[1][i], batch->origin[2][i] );
+    vec3 d( batch->direction[0][i], batch->direction[1][i], batch->direction[2][i] );
+    ray_cast( bvh, o, d, batch->max_t[i], &hit );
+    batch->t[i]        = hit.t;
+    batch->object[i]   = hit.object;
+    batch->triangle[i] = hit.triangle;
+  }
+}
+#endif
+
+/*--------------------------------THREAD POOL---------------------------------*/
+struct ray_query_pool_t {
+  std::thread* threads;
+  int n_threads; /* not counting the caller */
+  std::mutex mutex;
+  std::condition_variable start_cv, done_cv;
+  int generation; /* goes up by one for each batch, so workers know to start */
+  int n_working;
+  bool quit;
+  /* the current batch */
+  const scene_bvh_t* bvh;
+  ray_batch_t* batch;
+  std::atomic<int> next_chunk;
+  int n_chunks;
+};
+
+/* takes chunks until there are none left. every thread runs this */
+static void work_on_batch( ray_query_pool_t* pool ) {
+  while ( true ) {
+    int chunk = pool->next_chunk.fetch_add( 1 );
+    if ( chunk >= pool->n_chunks ) { return; }
+    int first = chunk * RAY_BATCH_CHUNK;
+    int count = pool->batch->n_rays - first < RAY_BATCH_CHUNK ? pool->batch->n_rays - first : RAY_BATCH_CHUNK;
+    cast_chunk( pool->bvh, pool->batch, first, count );
+  }
+}
+
+static void worker_main( ray_query_pool_t* pool ) {
+  int seen_generation = 0;
+  while ( true ) {
+    {
+      std::unique_lock<std::mutex> lock( pool->mutex );
+      while ( !pool->quit && pool->generation == seen_generation ) { pool->start_cv.wait( lock ); }
+      if ( pool->quit ) { return; }
+      seen_generation = pool->generation;
+    }
+    work_on_batch( pool );
+    std::lock_guard<std::mutex> lock( pool->mutex );
+    if ( 0 == --pool->n_working ) { pool->done_cv.notify_one(); }
+  }
+}
+
+ray_query_pool_t* create_ray_query_pool( int n_threads ) {
+  ray_query_pool_t* pool = new ray_query_pool_t;
+  pool->n_threads        = n_threads > 1 ? n_threads - 1 : 0;
+  pool->generation       = 0;
+  pool->n_working        = 0;
+  pool->quit             = false;
+  pool->bvh              = NULL;
+  pool->batch            = NULL;
+  pool->n_chunks         = 0;
+  pool->next_chunk.store( 0 );
+  pool->threads = new std::thread[pool->n_threads];
+  for ( int i = 0; i < pool->n_threads; i++ ) { pool->threads[i] = std::thread( worker_main, pool ); }
+  return pool;
+}
+
+void destroy_ray_query_pool( ray_query_pool_t* pool ) {
+  {
+    std::lock_guard<std::mutex> lock( pool->mutex );
+    pool->quit = true;
+  }
+  pool->start_cv.notify_all();
+  for ( int i = 0; i < pool->n_threads; i++ ) { pool->threads[i].join(); }
+  delete[] pool->threads;
+  delete pool;
+}
+
+void ray_cast_batch( ray_query_pool_t* pool, const scene_bvh_t* bvh, ray_batch_t* batch ) {
+  {
+    std::lock_guard<std::mutex> lock( pool->mutex );
+    pool->bvh      = bvh;
+    pool->batch    = batch;
+    pool->n_chunks = ( batch->n_rays + RAY_BATCH_CHUNK - 1 ) / RAY_BATCH_CHUNK;
+    pool->next_chunk.store( 0 );
+    pool->n_working = pool->n_threads;
+    pool->generation++;
+  }
+  pool->start_cv.notify_all();
+  work_on_batch( pool );
+  std::unique_lock<std::mutex> lock( pool->mutex );
+  while ( pool->n_working > 0 ) { pool->done_cv.wait( lock ); }
+}
@@ -0,0 +1,57 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Batches of ray casts against a scene BVH, for when there are thousands of    |
+| visibility or line-of-sight queries a frame rather than one mouse click.     |
+| Rays and results are stored as structures of arrays - one array for each    |
+| of origin x, origin y, etc. - so that consecutive rays load straight into    |
+| SIMD registers. Rays go down the BVH together in packets of 4 (SSE) or 8     |
+| (AVX, if compiled with -mavx): a node is visited if any ray in the packet    |
+| hits its box, and every box and triangle test is done for all rays at once.  |
+| Packets work best when neighbouring rays are coherent, e.g. rays through     |
+| neighbouring pixels from one camera, since they then visit the same nodes.   |
+| Batches are split into chunks that a pool of threads take in turn. The       |
+| calling thread works on chunks too. Without SSE the rays are cast one at a   |
+| time with ray_cast().                                                        |
+\******************************************************************************/
+#ifndef _RAY_BATCH_H_
+#define _RAY_BATCH_H_
+
+#include "bvh.h"
+
+/* rays per job taken by a thread. a multiple of the packet size */
+#define RAY_BATCH_CHUNK 256
+
+struct ray_batch_t {
+  int n_rays;
+  /* input */
+  float* origin[3];
+  float* direction[3];
+  float* max_t;
+  /* output. t is max_t and object and triangle are -1 for a ray that missed */
+  float* t;
+  int* object;
+  int* triangle;
+};
+
+/* the threads are hidden away in here */
+struct ray_query_pool_t;
+
+bool alloc_ray_batch( ray_batch_t* batch, int n_rays );
+void free_ray_batch( ray_batch_t* batch );
+void set_batch_ray( ray_batch_t* batch, int i, vec3 origin, vec3 direction, float max_t );
+
+/* n_threads includes the calling thread, so 1 starts no extra threads */
+ray_query_pool_t* create_ray_query_pool( int n_threads );
+void destroy_ray_query_pool( ray_query_pool_t* pool );
+/* casts every ray in the batch and returns once all the results are written */
+void ray_cast_batch( ray_query_pool_t* pool, const scene_bvh_t* bvh, ray_batch_t* batch );
+/* 8, 4, or 1 if there is no SIMD support */
+int ray_packet_size();
+
+#endif
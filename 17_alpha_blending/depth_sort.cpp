@@ -0,0 +1,142 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Radix sort by depth.                                                         |
+\******************************************************************************/
+#include "depth_sort.h"
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+/* fewer keys than this a thread aren't worth starting the thread for */
+#define MIN_KEYS_PER_THREAD 65536
+
+/* flips a float's bits so that unsigned int order is the same as float order.
+negative numbers flip entirely, so that bigger magnitudes come first, and
+positive numbers just get the sign bit set, so that they come after */
+static inline unsigned int float_sort_key( float f ) {
+  unsigned int u;
+  memcpy( &u, &f, sizeof( u ) );
+  return ( u & 0x80000000u ) ? ~u : u | 0x80000000u;
+}
+
+bool init_depth_sorter( depth_sorter_t* sorter, int max_n, int n_threads ) {
+  memset( sorter, 0, sizeof( depth_sorter_t ) );
+  if ( n_threads < 1 ) { n_threads = (int)std::thread::hardware_concurrency(); }
+  sorter->n_threads = n_threads > 0 ? n_threads : 1;
+  sorter->counts    = (unsigned int*)malloc( sorter->n_threads * 4 * 256 * sizeof( unsigned int ) );
+  if ( !sorter->counts ) { return false; }
+  for ( int i = 0; i < 2; i++ ) {
+    sorter->keys[i]  = (unsigned int*)malloc( max_n * sizeof( unsigned int ) );
+    sorter->order[i] = (unsigned int*)malloc( max_n * sizeof( unsigned int ) );
+    if ( !sorter->keys[i] || !sorter->order[i] ) {
+      free_depth_sorter( sorter );
+      return false;
+    }
+  }
+  sorter->max_n = max_n;
+  return true;
+}
+
+void free_depth_sorter( depth_sorter_t* sorter ) {
+  for ( int i = 0; i < 2; i++ ) {
+    free( sorter->keys[i] );
+    free( sorter->order[i] );
+  }
+  free( sorter->counts );
+  memset( sorter, 0, sizeof( depth_sorter_t ) );
+}
+
+/* makes the keys of depths first to last - 1, and counts each digit for every
+pass into counts[pass * 256 + digit] */
+static void count_chunk( depth_sorter_t* sorter, const float* depths, int first, int last, unsigned int* counts ) {
+  memset( counts, 0, 4 * 256 * sizeof( unsigned int ) );
+  for ( int i = first; i < last; i++ ) {
+    unsigned int key    = float_sort_key( depths[i] );
+    sorter->keys[0][i]  = key;
+    sorter->order[0][i] = (unsigned int)i;
+    counts[key & 0xff]++;
+    counts[256 + ( ( key >> 8 ) & 0xff )]++;
+    counts[512 + ( ( key >> 16 ) & 0xff )]++;
+    counts[768 + ( key >> 24 )]++;
+  }
+}
+
+/* counts each digit of one pass in keys first to last - 1 */
+static void count_digits( depth_sorter_t* sorter, int src, int pass, int first, int last, unsigned int* counts ) {
+  memset( counts, 0, 256 * sizeof( unsigned int ) );
+  int shift                = pass * 8;
+  const unsigned int* keys = sorter->keys[src];
+  for ( int i = first; i < last; i++ ) { counts[( keys[i] >> shift ) & 0xff]++; }
+}
+
+/* copies keys first to last - 1 of one pass to the places of their digits */
+static void scatter_chunk( depth_sorter_t* sorter, int src, int pass, int first, int last, unsigned int* places ) {
+  int shift                    = pass * 8;
+  const unsigned int* keys_in  = sorter->keys[src];
+  const unsigned int* order_in = sorter->order[src];
+  unsigned int* keys_out       = sorter->keys[1 - src];
+  unsigned int* order_out      = sorter->order[1 - src];
+  for ( int i = first; i < last; i++ ) {
+    unsigned int o = places[( keys_in[i] >> shift ) & 0xff]++;
+    keys_out[o]    = keys_in[i];
+    order_out[o]   = order_in[i];
+  }
+}
+
+/* where chunk c of n_chunks starts */
+static int chunk_start( int n, int c, int n_chunks ) { return (int)( (long long)n * c / n_chunks ); }
+
+const unsigned int* sort_depths( depth_sorter_t* sorter, const float* depths, int n ) {
+  if ( n > sorter->max_n ) { n = sorter->max_n; }
+  int n_chunks         = n / MIN_KEYS_PER_THREAD;
+  n_chunks             = n_chunks < 1 ? 1 : ( n_chunks > sorter->n_threads ? sorter->n_threads : n_chunks );
+  std::thread* threads = n_chunks > 1 ? new std::thread[n_chunks - 1] : NULL;
+  /* the keys, and a count of each digit for every pass. this thread does the
+  last chunk */
+  for ( int c = 0; c < n_chunks - 1; c++ ) { threads[c] = std::thread( count_chunk, sorter, depths, chunk_start( n, c, n_chunks ), chunk_start( n, c + 1, n_chunks ), &sorter->counts[c * 1024] ); }
+  count_chunk( sorter, depths, chunk_start( n, n_chunks - 1, n_chunks ), n, &sorter->counts[( n_chunks - 1 ) * 1024] );
+  for ( int c = 0; c < n_chunks - 1; c++ ) { threads[c].join(); }
+
+  int src    = 0;
+  bool moved = false;
+  for ( int pass = 0; pass < 4; pass++ ) {
+    /* already in order of this digit */
+    bool all_same = false;
+    for ( int d = 0; d < 256 && !all_same; d++ ) {
+      unsigned int digit_count = 0;
+      for ( int c = 0; c < n_chunks; c++ ) { digit_count += sorter->counts[c * 1024 + pass * 256 + d]; }
+      all_same = digit_count == (unsigned int)n;
+    }
+    if ( all_same ) { continue; }
+    /* an earlier pass moved keys between chunks, so count them again */
+    if ( moved && n_chunks > 1 ) {
+      for ( int c = 0; c < n_chunks - 1; c++ ) { threads[c] = std::thread( count_digits, sorter, src, pass, chunk_start( n, c, n_chunks ), chunk_start( n, c + 1, n_chunks ), &sorter->counts[c * 1024 + pass * 256] ); }
+      count_digits( sorter, src, pass, chunk_start( n, n_chunks - 1, n_chunks ), n, &sorter->counts[( n_chunks - 1 ) * 1024 + pass * 256] );
+      for ( int c = 0; c < n_chunks - 1; c++ ) { threads[c].join(); }
+    }
+    /* turn the counts into where each chunk's keys of each digit start. the
+    chunks follow each other within a digit, so equal digits keep their order */
+    unsigned int place = 0;
+    for ( int d = 0; d < 256; d++ ) {
+      for ( int c = 0; c < n_chunks; c++ ) {
+        unsigned int* count      = &sorter->counts[c * 1024 + pass * 256 + d];
+        unsigned int chunk_count = *count;
+        *count                   = place;
+        place += chunk_count;
+      }
+    }
+    for ( int c = 0; c < n_chunks - 1; c++ ) { threads[c] = std::thread( scatter_chunk, sorter, src, pass, chunk_start( n, c, n_chunks ), chunk_start( n, c + 1, n_chunks ), &sorter->counts[c * 1024 + pass * 256] ); }
+    scatter_chunk( sorter, src, pass, chunk_start( n, n_chunks - 1, n_chunks ), n, &sorter->counts[( n_chunks - 1 ) * 1024 + pass * 256] );
+    for ( int c = 0; c < n_chunks - 1; c++ ) { threads[c].join(); }
+    src   = 1 - src;
+    moved = true;
+  }
+  delete[] threads;
+  return sorter->order[src];
+}
@@ -0,0 +1,47 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Sorting things by their depth from the camera, so that they can be blended   |
+| back to front.                                                               |
+| A radix sort, rather than comparing depths with each other: each depth's     |
+| bits are flipped so that they sort as an unsigned int, then the keys are     |
+| put in order of their lowest 8 bits, then the next 8 bits, and so on. Each   |
+| pass keeps the order of keys with the same 8 bits, so after 4 passes they    |
+| are in order. A pass is one read to count each digit and one to copy the     |
+| keys to their place, so the time goes up with n rather than n log n. The     |
+| counts for all 4 passes are done in one read, and a pass where every key     |
+| has the same digit is skipped.                                               |
+| Big sorts are split into chunks, a thread each. For each pass every chunk    |
+| counts the digits of its keys, the counts are added up digit by digit in     |
+| chunk order, so each chunk knows where its keys of each digit go, and then   |
+| the chunks copy their keys there at the same time. Keys with the same digit  |
+| still keep their order.                                                      |
+| Sorts too small to be worth starting threads for stay on the calling thread. |
+\******************************************************************************/
+#ifndef _DEPTH_SORT_H_
+#define _DEPTH_SORT_H_
+
+struct depth_sorter_t {
+  int max_n;
+  int n_threads;
+  /* keys and indices, and the same again for the passes in between */
+  unsigned int *keys[2], *order[2];
+  /* 4 passes of 256 digit counts for each thread's chunk */
+  unsigned int* counts;
+};
+
+/* n_threads includes the calling thread. 0 is one per core */
+bool init_depth_sorter( depth_sorter_t* sorter, int max_n, int n_threads );
+void free_depth_sorter( depth_sorter_t* sorter );
+
+/* returns the indices of n depths in order of depth, smallest first. for
+view-space z that's the farthest first. the array belongs to the sorter and
+changes with the next sort */
+const unsigned int* sort_depths( depth_sorter_t* sorter, const float* depths, int n );
+
+#endif
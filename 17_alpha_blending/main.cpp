@@ -8,8 +8,10 @@
 |******************************************************************************|
 | Alpha Blending                                                               |
 \******************************************************************************/
+#include "depth_sort.h"
 #include "gl_utils.h"
 #include "maths_funcs.h"
+#include "wboit.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
@@ -27,6 +29,23 @@ int g_gl_width       = 640;
 int g_gl_height      = 480;
 GLFWwindow* g_window = NULL;
 
+/* blended quads scattered through a box in front of the camera. the first two
+are the original pair */
+#define QUAD_COUNT 400
+float g_quad_pos[QUAD_COUNT][3];
+
+/* "over" blending is only right back to front. sorting the quads by depth
+every frame gets that, and OIT doesn't need an order at all */
+enum blend_mode_t { BLEND_UNSORTED, BLEND_SORTED, BLEND_OIT, BLEND_MODE_COUNT };
+const char* g_blend_mode_names[] = { "blended unsorted", "sorted back to front", "weighted, blended order-independent transparency" };
+blend_mode_t g_blend_mode        = BLEND_UNSORTED;
+depth_sorter_t g_sorter;
+wboit_t g_wboit;
+/* the "over" and OIT accumulation shaders, and their model matrix uniforms */
+GLuint g_sp, g_oit_sp;
+int g_model_loc, g_oit_model_loc;
+mat4 g_view_mat;
+
 bool load_texture( const char* file_name, GLuint* tex ) {
   int x, y, n;
   int force_channels        = 4;
@@ -69,6 +88,117 @@ bool load_texture( const char* file_name, GLuint* tex ) {
   return true;
 }
 
+void gen_quads() {
+  float originals[2][3] = { { 0.0f, 0.0f, 0.0f }, { 0.5f, 0.0f, 0.1f } };
+  memcpy( g_quad_pos, originals, sizeof( originals ) );
+  srand( 1 );
+  for ( int i = 2; i < QUAD_COUNT; i++ ) {
+    g_quad_pos[i][0] = ( (float)rand() / RAND_MAX - 0.5f ) * 4.0f;
+    g_quad_pos[i][1] = ( (float)rand() / RAND_MAX - 0.5f ) * 3.0f;
+    g_quad_pos[i][2] = -(float)rand() / RAND_MAX * 4.0f;
+  }
+}
+
+/* draws every quad with a programme, in the given order or the order they
+were made if that's NULL. the two textures take turns */
+void draw_quads( GLuint sp, int model_loc, GLuint vao, const GLuint* texs, const unsigned int* order ) {
+  glUseProgram( sp );
+  glBindVertexArray( vao );
+  mat4 model = identity_mat4();
+  for ( int i = 0; i < QUAD_COUNT; i++ ) {
+    int q = order ? (int)order[i] : i;
+    glBindTexture( GL_TEXTURE_2D, texs[q % 2] );
+    model.m[12] = g_quad_pos[q][0];
+    model.m[13] = g_quad_pos[q][1];
+    model.m[14] = g_quad_pos[q][2];
+    glUniformMatrix4fv( model_loc, 1, GL_FALSE, model.m );
+    glDrawArrays( GL_TRIANGLES, 0, 6 );
+  }
+}
+
+/* draws the quads in the current blend mode. depth writes are off for all of
+them, so that quads behind a transparent one aren't hidden by it */
+void draw_blended( GLuint vao, const GLuint* texs ) {
+  if ( BLEND_OIT == g_blend_mode ) {
+    begin_wboit( &g_wboit, g_gl_width, g_gl_height );
+    draw_quads( g_oit_sp, g_oit_model_loc, vao, texs, NULL );
+    end_wboit( &g_wboit );
+    return;
+  }
+  const unsigned int* order = NULL;
+  if ( BLEND_SORTED == g_blend_mode ) {
+    /* view-space z of each quad's centre is negative in front of the camera,
+    so smallest first is farthest first */
+    float depths[QUAD_COUNT];
+    const float* v = g_view_mat.m;
+    for ( int i = 0; i < QUAD_COUNT; i++ ) { depths[i] = v[2] * g_quad_pos[i][0] + v[6] * g_quad_pos[i][1] + v[10] * g_quad_pos[i][2] + v[14]; }
+    order = sort_depths( &g_sorter, depths, QUAD_COUNT );
+  }
+  glEnable( GL_BLEND );
+  glDepthMask( GL_FALSE );
+  draw_quads( g_sp, g_model_loc, vao, texs, order );
+  glDepthMask( GL_TRUE );
+  glDisable( GL_BLEND );
+}
+
+/* times the radix sort on 1M random depths against qsort(), and checks its
+order. then times whole frames of the quads in each blend mode */
+static int compare_floats( const void* a, const void* b ) {
+  float fa = *(const float*)a, fb = *(const float*)b;
+  return ( fa > fb ) - ( fa < fb );
+}
+
+void benchmark_blending( GLuint vao, const GLuint* texs ) {
+  const int n_keys = 1000000;
+  const int n_runs = 10;
+  float* depths    = (float*)malloc( n_keys * sizeof( float ) );
+  float* copy      = (float*)malloc( n_keys * sizeof( float ) );
+  depth_sorter_t sorter;
+  if ( !depths || !copy || !init_depth_sorter( &sorter, n_keys, 0 ) ) {
+    free( depths );
+    free( copy );
+    return;
+  }
+  for ( int i = 0; i < n_keys; i++ ) { depths[i] = -0.1f - (float)rand() / RAND_MAX * 100.0f; }
+  double radix_ms           = 0.0, qsort_ms = 0.0;
+  const unsigned int* order = NULL;
+  for ( int r = 0; r < n_runs; r++ ) {
+    double start = glfwGetTime();
+    order        = sort_depths( &sorter, depths, n_keys );
+    radix_ms += ( glfwGetTime() - start ) * 1000.0 / n_runs;
+    memcpy( copy, depths, n_keys * sizeof( float ) );
+    start = glfwGetTime();
+    qsort( copy, n_keys, sizeof( float ), compare_floats );
+    qsort_ms += ( glfwGetTime() - start ) * 1000.0 / n_runs;
+  }
+  int n_wrong = 0;
+  for ( int i = 1; i < n_keys; i++ ) {
+    if ( depths[order[i]] < depths[order[i - 1]] ) { n_wrong++; }
+  }
+  gl_log( "%i depths, %i threads: radix sort %8.3fms (%.0fM keys/s), qsort() %8.3fms. %i out of order\n", n_keys, sorter.n_threads, radix_ms, n_keys / ( radix_ms * 1000.0 ), qsort_ms, n_wrong );
+  printf( "%i depths, %i threads: radix sort %8.3fms (%.0fM keys/s), qsort() %8.3fms. %i out of order\n", n_keys, sorter.n_threads, radix_ms, n_keys / ( radix_ms * 1000.0 ), qsort_ms, n_wrong );
+  free_depth_sorter( &sorter );
+  free( depths );
+  free( copy );
+
+  blend_mode_t previous_blend = g_blend_mode;
+  for ( int b = 0; b < BLEND_MODE_COUNT; b++ ) {
+    g_blend_mode    = (blend_mode_t)b;
+    double frame_ms = 0.0;
+    for ( int r = 0; r < n_runs; r++ ) {
+      glFinish();
+      double start = glfwGetTime();
+      glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+      draw_blended( vao, texs );
+      glFinish();
+      frame_ms += ( glfwGetTime() - start ) * 1000.0 / n_runs;
+    }
+    gl_log( "%i quads, %-48s: frame %8.3fms\n", QUAD_COUNT, g_blend_mode_names[b], frame_ms );
+    printf( "%i quads, %-48s: frame %8.3fms\n", QUAD_COUNT, g_blend_mode_names[b], frame_ms );
+  }
+  g_blend_mode = previous_blend;
+}
+
 int main() {
   restart_gl_log();
   start_gl();
@@ -101,6 +231,8 @@ int main() {
   glEnableVertexAttribArray( 1 );
 
   GLuint shader_programme = create_programme_from_files( "test_vs.glsl", "test_fs.glsl" );
+  /* the same quads, written into the OIT buffers instead of blended */
+  GLuint oit_programme = create_programme_from_files( "test_vs.glsl", "test_oit_fs.glsl" );
 
 #define ONE_DEG_IN_RAD ( 2.0 * M_PI ) / 360.0 // 0.017444444
   // input variables
@@ -122,24 +254,32 @@ int main() {
   float cam_yaw          = 0.0f;                 // y-rotation in degrees
   mat4 T                 = translate( identity_mat4(), vec3( -cam_pos[0], -cam_pos[1], -cam_pos[2] ) );
   mat4 R                 = rotate_y_deg( identity_mat4(), -cam_yaw );
-  mat4 view_mat          = R * T;
-  mat4 model             = identity_mat4();
+  g_view_mat             = R * T;
   int model_mat_location = glGetUniformLocation( shader_programme, "model" );
   int view_mat_location  = glGetUniformLocation( shader_programme, "view" );
   int proj_mat_location  = glGetUniformLocation( shader_programme, "proj" );
+  int oit_view_location  = glGetUniformLocation( oit_programme, "view" );
   glUseProgram( shader_programme );
-  glUniformMatrix4fv( view_mat_location, 1, GL_FALSE, view_mat.m );
+  glUniformMatrix4fv( view_mat_location, 1, GL_FALSE, g_view_mat.m );
   glUniformMatrix4fv( proj_mat_location, 1, GL_FALSE, proj_mat );
+  glUseProgram( oit_programme );
+  glUniformMatrix4fv( oit_view_location, 1, GL_FALSE, g_view_mat.m );
+  glUniformMatrix4fv( glGetUniformLocation( oit_programme, "proj" ), 1, GL_FALSE, proj_mat );
+  g_sp            = shader_programme;
+  g_oit_sp        = oit_programme;
+  g_model_loc     = model_mat_location;
+  g_oit_model_loc = glGetUniformLocation( oit_programme, "model" );
 
   // load texture
-  GLuint texa;
-  ( load_texture( "blob.png", &texa ) );
-  GLuint texb;
-  ( load_texture( "blob2.png", &texb ) );
+  GLuint texs[2];
+  ( load_texture( "blob.png", &texs[0] ) );
+  ( load_texture( "blob2.png", &texs[1] ) );
 
+  gen_quads();
+  init_depth_sorter( &g_sorter, QUAD_COUNT, 0 );
+  init_wboit( &g_wboit, g_gl_width, g_gl_height );
   glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-  glEnable( GL_BLEND );
-  // glDisable (GL_DEPTH_TEST);
+  printf( "blend mode: %s. O changes it, B benchmarks\n", g_blend_mode_names[g_blend_mode] );
 
   glClearColor( 0.2, 0.2, 0.2, 1.0 );
   glEnable( GL_CULL_FACE ); // cull face
@@ -157,27 +297,24 @@ int main() {
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
     glViewport( 0, 0, g_gl_width, g_gl_height );
 
-    glUseProgram( shader_programme );
-    glBindVertexArray( vao );
-
-    glDepthMask( GL_FALSE );
-
-    glBindTexture( GL_TEXTURE_2D, texa );
-    model = identity_mat4();
-    glUniformMatrix4fv( model_mat_location, 1, GL_FALSE, model.m );
-    glDrawArrays( GL_TRIANGLES, 0, 6 );
-
-    glBindTexture( GL_TEXTURE_2D, texb );
-    model.m[12] = 0.5;
-    model.m[14] = 0.1;
-    glUniformMatrix4fv( model_mat_location, 1, GL_FALSE, model.m );
-    glDrawArrays( GL_TRIANGLES, 0, 6 );
-
-    glDepthMask( GL_TRUE );
+    draw_blended( vao, texs );
 
     // update other events like input handling
     glfwPollEvents();
 
+    static bool o_was_down = false;
+    bool o_is_down         = glfwGetKey( g_window, GLFW_KEY_O );
+    if ( o_is_down && !o_was_down ) {
+      g_blend_mode = (blend_mode_t)( ( g_blend_mode + 1 ) % BLEND_MODE_COUNT );
+      printf( "blend mode: %s\n", g_blend_mode_names[g_blend_mode] );
+    }
+    o_was_down = o_is_down;
+
+    static bool b_was_down = false;
+    bool b_is_down         = glfwGetKey( g_window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) { benchmark_blending( vao, texs ); }
+    b_was_down = b_is_down;
+
     // control keys
     bool cam_moved = false;
     if ( glfwGetKey( g_window, GLFW_KEY_A ) ) {
@@ -217,8 +354,11 @@ int main() {
       mat4 T        = translate( identity_mat4(), vec3( -cam_pos[0], -cam_pos[1],
                                              -cam_pos[2] ) ); // cam translation
       mat4 R        = rotate_y_deg( identity_mat4(), -cam_yaw );     //
-      mat4 view_mat = R * T;
-      glUniformMatrix4fv( view_mat_location, 1, GL_FALSE, view_mat.m );
+      g_view_mat    = R * T;
+      glUseProgram( shader_programme );
+      glUniformMatrix4fv( view_mat_location, 1, GL_FALSE, g_view_mat.m );
+      glUseProgram( oit_programme );
+      glUniformMatrix4fv( oit_view_location, 1, GL_FALSE, g_view_mat.m );
     }
 
     if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( g_window, 1 ); }
@@ -226,6 +366,8 @@ int main() {
     glfwSwapBuffers( g_window );
   }
 
+  free_wboit( &g_wboit );
+  free_depth_sorter( &g_sorter );
   // close GL context and any other GLFW resources
   glfwTerminate();
   return 0;
@@ -0,0 +1,18 @@
+/* adds a quad into the order-independent transparency buffers */
+#version 410
+
+in vec2 texture_coordinates;
+uniform sampler2D basic_texture;
+layout (location = 0) out vec4 accum;
+layout (location = 1) out float revealage;
+
+void main() {
+	vec4 texel = texture (basic_texture, texture_coordinates);
+	float a = texel.a;
+	// distance from the camera. gl_FragCoord.w is 1 / clip-space w
+	float z = 1.0 / gl_FragCoord.w;
+	// weight nearer quads more heavily. this curve suits a scene a few units deep
+	float w = a * clamp (10.0 / (0.00001 + pow (z / 5.0, 2.0) + pow (z / 200.0, 6.0)), 0.01, 3000.0);
+	accum = vec4 (texel.rgb * a, a) * w;
+	revealage = a;
+}
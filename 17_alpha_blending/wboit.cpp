@@ -0,0 +1,119 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Weighted, blended order-independent transparency.                            |
+\******************************************************************************/
+#include "wboit.h"
+#include "gl_utils.h"
+#include <string.h>
+#define COMPOSITE_VS "wboit_composite_vs.glsl"
+#define COMPOSITE_FS "wboit_composite_fs.glsl"
+
+/* (re)makes the textures at the window size and attaches them */
+static bool create_wboit_textures( wboit_t* oit, int width, int height ) {
+  if ( oit->accum_tex ) { glDeleteTextures( 1, &oit->accum_tex ); }
+  if ( oit->revealage_tex ) { glDeleteTextures( 1, &oit->revealage_tex ); }
+  oit->width  = width;
+  oit->height = height;
+  /* colour weighted by up to a few thousand needs more range than 8 bits */
+  glGenTextures( 1, &oit->accum_tex );
+  glBindTexture( GL_TEXTURE_2D, oit->accum_tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+  glGenTextures( 1, &oit->revealage_tex );
+  glBindTexture( GL_TEXTURE_2D, oit->revealage_tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, NULL );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+  glBindTexture( GL_TEXTURE_2D, 0 );
+
+  glBindFramebuffer( GL_FRAMEBUFFER, oit->fb );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, oit->accum_tex, 0 );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, oit->revealage_tex, 0 );
+  GLenum draw_bufs[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+  glDrawBuffers( 2, draw_bufs );
+  GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  if ( GL_FRAMEBUFFER_COMPLETE != status ) {
+    gl_log_err( "ERROR: incomplete OIT framebuffer. status 0x%x\n", status );
+    return false;
+  }
+  return true;
+}
+
+bool init_wboit( wboit_t* oit, int width, int height ) {
+  memset( oit, 0, sizeof( wboit_t ) );
+  glGenFramebuffers( 1, &oit->fb );
+  if ( !create_wboit_textures( oit, width, height ) ) {
+    free_wboit( oit );
+    return false;
+  }
+  oit->composite_sp = create_programme_from_files( COMPOSITE_VS, COMPOSITE_FS );
+  glUseProgram( oit->composite_sp );
+  glUniform1i( glGetUniformLocation( oit->composite_sp, "accum_tex" ), 0 );
+  glUniform1i( glGetUniformLocation( oit->composite_sp, "revealage_tex" ), 1 );
+
+  GLfloat quad_pos[] = { -1.0, -1.0, 1.0, -1.0, 1.0, 1.0, 1.0, 1.0, -1.0, 1.0, -1.0, -1.0 };
+  glGenBuffers( 1, &oit->quad_vbo );
+  glBindBuffer( GL_ARRAY_BUFFER, oit->quad_vbo );
+  glBufferData( GL_ARRAY_BUFFER, sizeof( quad_pos ), quad_pos, GL_STATIC_DRAW );
+  glGenVertexArrays( 1, &oit->quad_vao );
+  glBindVertexArray( oit->quad_vao );
+  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 0, NULL );
+  glEnableVertexAttribArray( 0 );
+  glBindVertexArray( 0 );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  return true;
+}
+
+void free_wboit( wboit_t* oit ) {
+  glDeleteFramebuffers( 1, &oit->fb );
+  glDeleteTextures( 1, &oit->accum_tex );
+  glDeleteTextures( 1, &oit->revealage_tex );
+  if ( oit->composite_sp ) { glDeleteProgram( oit->composite_sp ); }
+  glDeleteBuffers( 1, &oit->quad_vbo );
+  glDeleteVertexArrays( 1, &oit->quad_vao );
+  memset( oit, 0, sizeof( wboit_t ) );
+}
+
+void begin_wboit( wboit_t* oit, int width, int height ) {
+  if ( width != oit->width || height != oit->height ) { create_wboit_textures( oit, width, height ); }
+  glBindFramebuffer( GL_FRAMEBUFFER, oit->fb );
+  glViewport( 0, 0, width, height );
+  /* nothing accumulated, everything behind fully revealed */
+  const GLfloat zeros[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  const GLfloat ones[]  = { 1.0f, 1.0f, 1.0f, 1.0f };
+  glClearBufferfv( GL_COLOR, 0, zeros );
+  glClearBufferfv( GL_COLOR, 1, ones );
+  /* there's no depth buffer here. a scene with opaque geometry would attach
+  its own depth buffer so that hidden surfaces are still depth-tested away */
+  glDepthMask( GL_FALSE );
+  glEnable( GL_BLEND );
+  glBlendFunci( 0, GL_ONE, GL_ONE );
+  glBlendFunci( 1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR );
+}
+
+void end_wboit( wboit_t* oit ) {
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  /* the composite shader outputs the average colour, with 1 - revealage as
+  alpha. ordinary "over" blending then works since there's only one layer */
+  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  glDisable( GL_DEPTH_TEST );
+  glUseProgram( oit->composite_sp );
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( GL_TEXTURE_2D, oit->accum_tex );
+  glActiveTexture( GL_TEXTURE1 );
+  glBindTexture( GL_TEXTURE_2D, oit->revealage_tex );
+  glBindVertexArray( oit->quad_vao );
+  glDrawArrays( GL_TRIANGLES, 0, 6 );
+  glActiveTexture( GL_TEXTURE0 );
+  glEnable( GL_DEPTH_TEST );
+  glDisable( GL_BLEND );
+  glDepthMask( GL_TRUE );
+}
@@ -0,0 +1,49 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Weighted, blended order-independent transparency (McGuire and Bavoil 2013).  |
+| Blending with "over" gives the right answer only if surfaces are drawn back  |
+| to front. This instead adds every surface up in any order:                   |
+|   accumulate - each fragment adds its premultiplied colour and alpha, scaled |
+|                by a weight that falls off with distance, into an RGBA16F     |
+|                texture, and multiplies (1 - alpha) into a revealage texture  |
+|   composite  - the average colour, accumulated colour / accumulated alpha,   |
+|                is blended over the scene with 1 - revealage as its coverage  |
+| Nothing is sorted, so there's no sort to pay for every frame.                |
+| It's an approximation: surfaces close together in depth blend as if they     |
+| were at the same depth, which is hardly visible with soft things like smoke. |
+| The accumulate pass's fragment shader writes 2 outputs:                      |
+|   layout (location = 0) out vec4 accum;     // rgb * a * w, a * w            |
+|   layout (location = 1) out float revealage; // a                            |
+\******************************************************************************/
+#ifndef _WBOIT_H_
+#define _WBOIT_H_
+
+#include <GL/glew.h>
+
+struct wboit_t {
+  GLuint fb;
+  GLuint accum_tex, revealage_tex;
+  int width, height;
+  GLuint composite_sp;
+  GLuint quad_vao, quad_vbo;
+};
+
+bool init_wboit( wboit_t* oit, int width, int height );
+void free_wboit( wboit_t* oit );
+
+/* binds and clears the accumulation framebuffer, and sets up blending for it.
+the textures are made again if the window has changed size. draw the
+transparent surfaces with an accumulate shader after this */
+void begin_wboit( wboit_t* oit, int width, int height );
+
+/* binds the default framebuffer and composites the transparent surfaces over
+whatever is in it. leaves blending off, and depth testing and writes on */
+void end_wboit( wboit_t* oit );
+
+#endif
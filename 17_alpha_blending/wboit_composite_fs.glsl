@@ -0,0 +1,22 @@
+/* blends the accumulated transparent surfaces over the scene */
+#version 410 core
+
+in vec2 st;
+uniform sampler2D accum_tex, revealage_tex;
+out vec4 frag_colour;
+
+void main () {
+	float revealage = texture (revealage_tex, st).r;
+	// nothing was drawn here, so leave the scene alone
+	if (revealage >= 1.0) {
+		discard;
+	}
+	vec4 accum = texture (accum_tex, st);
+	// a very bright or heavily weighted pile of surfaces can overflow 16 bits
+	if (isinf (max (max (abs (accum.r), abs (accum.g)), abs (accum.b)))) {
+		accum.rgb = vec3 (accum.a);
+	}
+	// the weighted average colour, covering as much as the surfaces did
+	vec3 average_colour = accum.rgb / max (accum.a, 0.00001);
+	frag_colour = vec4 (average_colour, 1.0 - revealage);
+}
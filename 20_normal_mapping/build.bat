@@ -31,11 +31,13 @@ set LIBS=%LIB_PATH_GLFW% %LIB_PATH_GLEW% %LIB_PATH_ASSIMP% OpenGL32.lib %SYSTEM_
 set DLL_PATH_GLEW="..\third_party\glew-2.1.0\bin\Release\x64\glew32.dll"
 set DLL_PATH_GLFW="..\third_party\glfw-3.4.bin.WIN64\lib-vc2019\glfw3.dll"
 set DLL_PATH_ASSIMP="..\third_party\assimp\bin\vs2022\assimp-vc143-mt.dll"
-set SRC="*.c??"
+set SRC=main.cpp maths_funcs.cpp gl_utils.cpp texture_loader.cpp block_compression.cpp ktx2.cpp
+set COMPRESS_SRC=compressor_main.cpp texture_loader.cpp block_compression.cpp ktx2.cpp
 
 @echo on
 
 cl %CFLAGS% %SRC% %INCLUDES% /link %LFLAGS% %LIBS% /OUT:"nmap.exe" 
+cl %CFLAGS% /O2 %COMPRESS_SRC% %INCLUDES% /link %LFLAGS% %LIB_PATH_GLFW% %LIB_PATH_GLEW% OpenGL32.lib /OUT:"compress.exe" 
 
 copy %DLL_PATH_GLEW% .\
 copy %DLL_PATH_GLFW% .\
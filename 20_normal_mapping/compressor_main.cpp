@@ -0,0 +1,248 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Texture Compressor                                                           |
+| Loads an image, or six cube map faces, through texture_loader.h, block       |
+| compresses every mipmap level on several threads, and writes a KTX2 file for |
+| load_ktx2_texture(). Reports the PSNR of the full size level, and how much   |
+| video memory the compressed texture takes compared to the RGBA8 textures     |
+| that load_texture() made of every image. Options:                            |
+|   -format bc7        bc1 (RGB), bc3 (RGBA), bc4 (grey), bc5 (normal maps'    |
+|                      x and y) or bc7 (RGBA). see block_compression.h         |
+|   -threads n         encoding threads. defaults to the number of cores       |
+|   -cube              six images, +X -X +Y -Y +Z -Z, make one cube map        |
+|   -normalise         the image is a normal map. makes every normal, in every |
+|                      level, unit length again, so z can be worked out from x |
+|                      and y. averaging normals for mipmaps shortens them      |
+|   -out file.ktx2     defaults to the first image's name, ending in .ktx2     |
+| e.g. ./compress -format bc5 -normalise brickwork_normal-map.png              |
+\******************************************************************************/
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "block_compression.h"
+#include "ktx2.h"
+#include "texture_loader.h"
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+/* a row of 4x4 blocks in one face of one level */
+struct encode_task_t {
+  int level, face, row;
+};
+
+struct encode_job_t {
+  bc_format_t format;
+  const texture_image_t* images;
+  unsigned char** levels; // output, all faces of a level together
+  const encode_task_t* tasks;
+  int n_tasks;
+  std::atomic<int> next_task;
+};
+
+static double get_seconds() { return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count(); }
+
+static void encode_worker( encode_job_t* job ) {
+  for ( int t = job->next_task++; t < job->n_tasks; t = job->next_task++ ) {
+    const encode_task_t* task    = &job->tasks[t];
+    const texture_image_t* image = &job->images[task->face];
+    int width                    = texture_level_dim( image->width, task->level );
+    int height                   = texture_level_dim( image->height, task->level );
+    unsigned char* blocks        = job->levels[task->level] + task->face * bc_image_bytes( job->format, width, height );
+    bc_encode_rows( job->format, image->levels[task->level], image->n_channels, width, height, task->row, task->row + 1, blocks );
+  }
+}
+
+/* texture_loader.h flips images to have their bottom row first, but cube map
+faces are the other way up */
+static void flip_rows( unsigned char* pixels, int width, int height, int n_channels ) {
+  size_t row_bytes   = (size_t)width * n_channels;
+  unsigned char* tmp = (unsigned char*)malloc( row_bytes );
+  for ( int y = 0; y < height / 2; y++ ) {
+    memcpy( tmp, pixels + y * row_bytes, row_bytes );
+    memcpy( pixels + y * row_bytes, pixels + ( height - 1 - y ) * row_bytes, row_bytes );
+    memcpy( pixels + ( height - 1 - y ) * row_bytes, tmp, row_bytes );
+  }
+  free( tmp );
+}
+
+/* normals are stored as 0 to 255 for -1 to 1 in r, g, and b */
+static void normalise_normals( unsigned char* pixels, size_t n_pixels, int n_channels ) {
+  for ( size_t i = 0; i < n_pixels; i++ ) {
+    unsigned char* p = pixels + i * n_channels;
+    float n[3]       = { p[0] / 255.0f * 2.0f - 1.0f, p[1] / 255.0f * 2.0f - 1.0f, p[2] / 255.0f * 2.0f - 1.0f };
+    float length     = sqrtf( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+    for ( int c = 0; c < 3; c++ ) {
+      float v = length > 1e-3f ? n[c] / length : ( 2 == c ? 1.0f : 0.0f );
+      p[c]    = (unsigned char)floorf( ( v * 0.5f + 0.5f ) * 255.0f + 0.5f );
+    }
+  }
+}
+
+/* decodes level 0 of each face again and compares it with the original, in the
+channels that the format keeps */
+static double level_0_psnr( bc_format_t format, const texture_image_t* images, int n_faces, const unsigned char* blocks ) {
+  int width             = images[0].width, height = images[0].height;
+  int n_compared        = bc_format_channels( format );
+  unsigned char* pixels = (unsigned char*)malloc( (size_t)width * height * 4 );
+  double squared_error  = 0.0;
+  for ( int f = 0; f < n_faces; f++ ) {
+    bc_decode_image( format, blocks + f * bc_image_bytes( format, width, height ), width, height, pixels );
+    int n = images[f].n_channels;
+    for ( size_t i = 0; i < (size_t)width * height; i++ ) {
+      const unsigned char* src = images[f].levels[0] + i * n;
+      /* grey, and grey with alpha, spread out as the encoder reads them */
+      unsigned char rgba[4] = { src[0], src[n < 3 ? 0 : 1], src[n < 3 ? 0 : 2], (unsigned char)( 2 == n ? src[1] : ( 4 == n ? src[3] : 255 ) ) };
+      for ( int c = 0; c < n_compared; c++ ) {
+        double d = (double)rgba[c] - pixels[i * 4 + c];
+        squared_error += d * d;
+      }
+    }
+  }
+  free( pixels );
+  double mse = squared_error / ( (double)width * height * n_faces * n_compared );
+  return mse > 0.0 ? 10.0 * log10( 255.0 * 255.0 / mse ) : INFINITY;
+}
+
+int main( int argc, char** argv ) {
+  const char* channel_names[] = { "", "R", "RG", "RGB", "RGBA" };
+  const char* output_name     = NULL;
+  const char* file_names[6];
+  bc_format_t format = BC_FORMAT_BC7;
+  int n_threads      = (int)std::thread::hardware_concurrency();
+  int n_files        = 0;
+  bool cube          = false;
+  bool normalise     = false;
+  for ( int i = 1; i < argc; i++ ) {
+    bool has_value = i + 1 < argc;
+    if ( 0 == strcmp( argv[i], "-format" ) && has_value ) {
+      int f = 0;
+      for ( ; f < BC_FORMAT_COUNT && 0 != strcmp( argv[i + 1], bc_format_name( (bc_format_t)f ) ); f++ ) { }
+      if ( BC_FORMAT_COUNT == f ) {
+        fprintf( stderr, "unknown format %s. use bc1, bc3, bc4, bc5 or bc7\n", argv[i + 1] );
+        return 1;
+      }
+      format = (bc_format_t)f;
+      i++;
+    } else if ( 0 == strcmp( argv[i], "-threads" ) && has_value ) {
+      n_threads = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-cube" ) ) {
+      cube = true;
+    } else if ( 0 == strcmp( argv[i], "-normalise" ) ) {
+      normalise = true;
+    } else if ( 0 == strcmp( argv[i], "-out" ) && has_value ) {
+      output_name = argv[++i];
+    } else if ( '-' != argv[i][0] && n_files < 6 ) {
+      file_names[n_files++] = argv[i];
+    } else {
+      fprintf( stderr, "unknown option %s\n", argv[i] );
+      return 1;
+    }
+  }
+  if ( n_threads < 1 ) { n_threads = 1; }
+  int n_faces = cube ? 6 : 1;
+  if ( n_files != n_faces ) {
+    fprintf( stderr, "usage: %s [-format bc1|bc3|bc4|bc5|bc7] [-threads n] [-normalise] [-out file.ktx2] image\n", argv[0] );
+    fprintf( stderr, "       %s [-format ...] [-threads n] [-out file.ktx2] -cube +x -x +y -y +z -z\n", argv[0] );
+    return 1;
+  }
+  char default_name[256];
+  if ( !output_name ) {
+    snprintf( default_name, sizeof( default_name ), "%s", file_names[0] );
+    char* dot = strrchr( default_name, '.' );
+    if ( dot ) { *dot = '\0'; }
+    strncat( default_name, ".ktx2", sizeof( default_name ) - strlen( default_name ) - 1 );
+    output_name = default_name;
+  }
+
+  double start = get_seconds();
+  texture_image_t images[6];
+  if ( load_texture_images( file_names, n_faces, images, n_threads ) != n_faces ) { return 1; }
+  for ( int f = 1; f < n_faces; f++ ) {
+    if ( images[f].width != images[0].width || images[f].height != images[0].height ) {
+      fprintf( stderr, "ERROR: %s is %ix%i, but %s is %ix%i\n", file_names[f], images[f].width, images[f].height, file_names[0], images[0].width, images[0].height );
+      return 1;
+    }
+  }
+  if ( normalise && images[0].n_channels < 3 ) {
+    fprintf( stderr, "ERROR: %s has no x, y, and z to normalise\n", file_names[0] );
+    return 1;
+  }
+  if ( cube && images[0].width != images[0].height ) {
+    fprintf( stderr, "ERROR: cube map faces must be square\n" );
+    return 1;
+  }
+  int n_levels = images[0].n_levels;
+  for ( int f = 0; normalise && f < n_faces; f++ ) {
+    for ( int l = 0; l < n_levels; l++ ) { normalise_normals( images[f].levels[l], (size_t)texture_level_dim( images[f].width, l ) * texture_level_dim( images[f].height, l ), images[f].n_channels ); }
+  }
+  for ( int f = 0; cube && f < n_faces; f++ ) {
+    for ( int l = 0; l < n_levels; l++ ) { flip_rows( images[f].levels[l], texture_level_dim( images[f].width, l ), texture_level_dim( images[f].height, l ), images[f].n_channels ); }
+  }
+  double loaded_s = get_seconds() - start;
+
+  /* biggest levels first, so that no thread is left with a big one at the end */
+  unsigned char* levels[TEXTURE_MAX_LEVELS];
+  int n_tasks = 0;
+  for ( int l = 0; l < n_levels; l++ ) {
+    int width  = texture_level_dim( images[0].width, l );
+    int height = texture_level_dim( images[0].height, l );
+    levels[l]  = (unsigned char*)malloc( n_faces * bc_image_bytes( format, width, height ) );
+    if ( !levels[l] ) {
+      fprintf( stderr, "ERROR: out of memory\n" );
+      return 1;
+    }
+    n_tasks += n_faces * ( ( height + 3 ) / 4 );
+  }
+  encode_task_t* tasks = (encode_task_t*)malloc( n_tasks * sizeof( encode_task_t ) );
+  n_tasks              = 0;
+  for ( int l = 0; l < n_levels; l++ ) {
+    for ( int f = 0; f < n_faces; f++ ) {
+      for ( int row = 0; row < ( texture_level_dim( images[0].height, l ) + 3 ) / 4; row++ ) { tasks[n_tasks++] = encode_task_t{ l, f, row }; }
+    }
+  }
+  encode_job_t job;
+  job.format    = format;
+  job.images    = images;
+  job.levels    = levels;
+  job.tasks     = tasks;
+  job.n_tasks   = n_tasks;
+  job.next_task = 0;
+
+  start                = get_seconds();
+  std::thread* threads = new std::thread[n_threads > 1 ? n_threads - 1 : 1];
+  for ( int t = 0; t < n_threads - 1; t++ ) { threads[t] = std::thread( encode_worker, &job ); }
+  encode_worker( &job );
+  for ( int t = 0; t < n_threads - 1; t++ ) { threads[t].join(); }
+  delete[] threads;
+  double encoded_s = get_seconds() - start;
+
+  size_t compressed_bytes = 0, rgba8_bytes = 0, pixels = 0;
+  for ( int l = 0; l < n_levels; l++ ) {
+    int width  = texture_level_dim( images[0].width, l );
+    int height = texture_level_dim( images[0].height, l );
+    compressed_bytes += n_faces * bc_image_bytes( format, width, height );
+    pixels += (size_t)n_faces * width * height;
+  }
+  rgba8_bytes = pixels * 4;
+  printf( "%s%s: %ix%i%s, %i levels, to %s on %i threads\n", file_names[0], cube ? " and 5 more faces" : "", images[0].width, images[0].height, cube ? " cube map" : "", n_levels, bc_format_name( format ), n_threads );
+  printf( "  loaded and mipmapped in %.3fs. encoded in %.3fs, %.2f Mpixels/s\n", loaded_s, encoded_s, pixels / encoded_s / 1e6 );
+  printf( "  PSNR %.2f dB, in %s, of level 0\n", level_0_psnr( format, images, n_faces, levels[0] ), channel_names[bc_format_channels( format )] );
+  printf( "  %.1f KB of video memory, against %.1f KB as RGBA8: %.1fx smaller, %.1f KB saved\n", compressed_bytes / 1024.0, rgba8_bytes / 1024.0, (double)rgba8_bytes / compressed_bytes, ( rgba8_bytes - compressed_bytes ) / 1024.0 );
+
+  bool ok = write_ktx2( output_name, format, images[0].width, images[0].height, n_faces, n_levels, levels, NULL, 0 );
+  if ( ok ) { printf( "wrote `%s`\n", output_name ); }
+  for ( int l = 0; l < n_levels; l++ ) { free( levels[l] ); }
+  for ( int f = 0; f < n_faces; f++ ) { free_texture_image( &images[f] ); }
+  free( tasks );
+  return ok ? 0 : 1;
+}
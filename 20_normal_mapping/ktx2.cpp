@@ -0,0 +1,259 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| KTX2 files of block compressed textures.                                     |
+\******************************************************************************/
+#include "ktx2.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KTX2_WRITER "compress, Anton's OpenGL 4 Tutorials"
+
+/* Khronos data format descriptor values */
+#define KHR_DF_PRIMARIES_BT709 1
+#define KHR_DF_TRANSFER_LINEAR 1
+#define KHR_DF_CHANNEL_BC_ALPHA 15
+
+static const unsigned char ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct ktx2_header_t {
+  unsigned char identifier[12];
+  uint32_t vk_format;
+  uint32_t type_size;
+  uint32_t pixel_width, pixel_height, pixel_depth;
+  uint32_t layer_count, face_count, level_count;
+  uint32_t supercompression_scheme;
+  uint32_t dfd_byte_offset, dfd_byte_length;
+  uint32_t kvd_byte_offset, kvd_byte_length;
+  uint64_t sgd_byte_offset, sgd_byte_length;
+};
+
+struct ktx2_level_t {
+  uint64_t byte_offset, byte_length, uncompressed_byte_length;
+};
+
+/* how each format is named in Vulkan, which KTX2 uses, and in GL */
+struct ktx2_format_t {
+  uint32_t vk_format;
+  GLenum gl_format;
+  uint32_t colour_model;
+  int n_samples;         // the parts of a block, as they are laid out in it
+  uint32_t channels[2];
+};
+
+static const ktx2_format_t ktx2_formats[BC_FORMAT_COUNT] = {
+  { 131, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 128, 1, { 0, 0 } },                        // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+  { 137, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 130, 2, { KHR_DF_CHANNEL_BC_ALPHA, 0 } }, // VK_FORMAT_BC3_UNORM_BLOCK
+  { 139, GL_COMPRESSED_RED_RGTC1, 131, 1, { 0, 0 } },                                // VK_FORMAT_BC4_UNORM_BLOCK
+  { 141, GL_COMPRESSED_RG_RGTC2, 132, 2, { 0, 1 } },                                 // VK_FORMAT_BC5_UNORM_BLOCK
+  { 145, GL_COMPRESSED_RGBA_BPTC_UNORM, 134, 1, { 0, 0 } }                           // VK_FORMAT_BC7_UNORM_BLOCK
+};
+
+static int level_dim( int dim, int level ) { return dim >> level > 1 ? dim >> level : 1; }
+
+/* a basic data format descriptor for one of the formats. returns its size */
+static uint32_t make_dfd( bc_format_t format, uint32_t* dfd ) {
+  const ktx2_format_t* f = &ktx2_formats[format];
+  uint32_t sample_bits   = bc_block_bytes( format ) * 8 / f->n_samples;
+  uint32_t n_words       = 7 + 4 * f->n_samples;
+  memset( dfd, 0, n_words * sizeof( uint32_t ) );
+  dfd[0] = n_words * 4;                                                             // total size
+  dfd[1] = 0;                                                                       // Khronos, basic descriptor block
+  dfd[2] = 2 | ( n_words - 1 ) * 4 << 16;                                           // version 2, block size
+  dfd[3] = f->colour_model | KHR_DF_PRIMARIES_BT709 << 8 | KHR_DF_TRANSFER_LINEAR << 16; // straight alpha
+  dfd[4] = 3 | 3 << 8;                                                              // 4x4 texel blocks
+  dfd[5] = bc_block_bytes( format );                                                // bytes in plane 0
+  for ( int s = 0; s < f->n_samples; s++ ) {
+    uint32_t* sample = dfd + 7 + 4 * s;
+    sample[0]        = s * sample_bits | ( sample_bits - 1 ) << 16 | f->channels[s] << 24;
+    sample[3]        = 0xffffffff; // upper
+  }
+  return dfd[0];
+}
+
+/* key/value pairs, each a length, a key and a value, padded to 4 bytes */
+static uint32_t add_key_value( unsigned char* kvd, uint32_t at, const char* key, const void* value, uint32_t n_bytes ) {
+  uint32_t length = (uint32_t)( strlen( key ) + 1 + n_bytes );
+  memcpy( kvd + at, &length, 4 );
+  memcpy( kvd + at + 4, key, strlen( key ) + 1 );
+  memcpy( kvd + at + 4 + strlen( key ) + 1, value, n_bytes );
+  at += 4 + length;
+  while ( at % 4 ) { kvd[at++] = 0; }
+  return at;
+}
+
+static uint32_t add_key_text( unsigned char* kvd, uint32_t at, const char* key, const char* value ) { return add_key_value( kvd, at, key, value, (uint32_t)strlen( value ) + 1 ); }
+
+bool write_ktx2( const char* file_name, bc_format_t format, int width, int height, int n_faces, int n_levels, const unsigned char* const* levels, const ktx2_key_value_t* key_values, int n_key_values ) {
+  ktx2_header_t header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.identifier, ktx2_identifier, sizeof( ktx2_identifier ) );
+  header.vk_format    = ktx2_formats[format].vk_format;
+  header.type_size    = 1;
+  header.pixel_width  = width;
+  header.pixel_height = height;
+  header.face_count   = n_faces;
+  header.level_count  = n_levels;
+
+  uint32_t dfd[15];
+  header.dfd_byte_offset = (uint32_t)( sizeof( header ) + n_levels * sizeof( ktx2_level_t ) );
+  header.dfd_byte_length = make_dfd( format, dfd );
+  /* keys in order */
+  size_t kvd_bytes = 128;
+  for ( int i = 0; i < n_key_values; i++ ) { kvd_bytes += 4 + strlen( key_values[i].key ) + 1 + key_values[i].n_bytes + 3; }
+  unsigned char* kvd = (unsigned char*)malloc( kvd_bytes );
+  if ( !kvd ) { return false; }
+  header.kvd_byte_offset = header.dfd_byte_offset + header.dfd_byte_length;
+  header.kvd_byte_length = add_key_text( kvd, 0, "KTXorientation", 6 == n_faces ? "rd" : "ru" );
+  header.kvd_byte_length = add_key_text( kvd, header.kvd_byte_length, "KTXwriter", KTX2_WRITER );
+  for ( int i = 0; i < n_key_values; i++ ) { header.kvd_byte_length = add_key_value( kvd, header.kvd_byte_length, key_values[i].key, key_values[i].value, key_values[i].n_bytes ); }
+
+  /* levels go in smallest first, each starting on a whole block */
+  ktx2_level_t index[32];
+  uint64_t block_bytes = bc_block_bytes( format );
+  uint64_t at          = header.kvd_byte_offset + header.kvd_byte_length;
+  for ( int l = n_levels - 1; l >= 0; l-- ) {
+    at                                = ( at + block_bytes - 1 ) / block_bytes * block_bytes;
+    index[l].byte_offset              = at;
+    index[l].byte_length              = n_faces * bc_image_bytes( format, level_dim( width, l ), level_dim( height, l ) );
+    index[l].uncompressed_byte_length = index[l].byte_length;
+    at += index[l].byte_length;
+  }
+
+  FILE* fp = fopen( file_name, "wb" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+    free( kvd );
+    return false;
+  }
+  bool ok = 1 == fwrite( &header, sizeof( header ), 1, fp );
+  ok      = ok && (size_t)n_levels == fwrite( index, sizeof( ktx2_level_t ), n_levels, fp );
+  ok      = ok && 1 == fwrite( dfd, header.dfd_byte_length, 1, fp );
+  ok      = ok && 1 == fwrite( kvd, header.kvd_byte_length, 1, fp );
+
+  uint64_t written              = header.kvd_byte_offset + header.kvd_byte_length;
+  const unsigned char zeros[16] = { 0 };
+  for ( int l = n_levels - 1; l >= 0 && ok; l-- ) {
+    ok      = index[l].byte_offset == written || 1 == fwrite( zeros, (size_t)( index[l].byte_offset - written ), 1, fp );
+    ok      = ok && 1 == fwrite( levels[l], (size_t)index[l].byte_length, 1, fp );
+    written = index[l].byte_offset + index[l].byte_length;
+  }
+  ok = 0 == fclose( fp ) && ok;
+  free( kvd );
+  if ( !ok ) { fprintf( stderr, "ERROR: could not write %s\n", file_name ); }
+  return ok;
+}
+
+bool load_ktx2_texture( const char* file_name, GLuint* tex, GLenum* target, size_t* gpu_bytes ) {
+  FILE* fp = fopen( file_name, "rb" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not open %s\n", file_name );
+    return false;
+  }
+  fseek( fp, 0, SEEK_END );
+  long size = ftell( fp );
+  rewind( fp );
+  unsigned char* data = (unsigned char*)malloc( size > 0 ? size : 1 );
+  bool ok             = data && size > 0 && 1 == fread( data, size, 1, fp );
+  fclose( fp );
+
+  const ktx2_header_t* header = (const ktx2_header_t*)data;
+  const ktx2_level_t* index   = (const ktx2_level_t*)( header + 1 );
+  int format                  = BC_FORMAT_COUNT;
+  /* everything in the header and index has to agree with the file's size */
+  ok = ok && (size_t)size >= sizeof( ktx2_header_t ) && 0 == memcmp( header->identifier, ktx2_identifier, sizeof( ktx2_identifier ) );
+  ok = ok && 0 == header->supercompression_scheme && 0 == header->pixel_depth && 0 == header->layer_count;
+  ok = ok && ( 1 == header->face_count || 6 == header->face_count ) && header->level_count >= 1 && header->level_count <= 32;
+  ok = ok && header->pixel_width > 0 && header->pixel_height > 0 && header->pixel_width <= 32768 && header->pixel_height <= 32768;
+  ok = ok && sizeof( ktx2_header_t ) + header->level_count * sizeof( ktx2_level_t ) <= (size_t)size;
+  if ( ok ) {
+    for ( format = 0; format < BC_FORMAT_COUNT && ktx2_formats[format].vk_format != header->vk_format; format++ ) { }
+  }
+  ok = ok && format < BC_FORMAT_COUNT;
+  for ( uint32_t l = 0; ok && l < header->level_count; l++ ) {
+    size_t face_bytes = bc_image_bytes( (bc_format_t)format, level_dim( header->pixel_width, l ), level_dim( header->pixel_height, l ) );
+    ok                = index[l].byte_length == header->face_count * face_bytes && index[l].byte_offset <= (uint64_t)size && index[l].byte_length <= (uint64_t)size - index[l].byte_offset;
+  }
+  if ( !ok ) {
+    fprintf( stderr, "ERROR: %s is not a KTX2 file of a BC1, BC3, BC4, BC5, or BC7 texture\n", file_name );
+    free( data );
+    return false;
+  }
+  /* RGTC has been core since GL 3.0. the others are extensions until 4.2 */
+  bool supported = BC_FORMAT_BC7 == format ? ( GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc ) : ( BC_FORMAT_BC1 == format || BC_FORMAT_BC3 == format ) ? GLEW_EXT_texture_compression_s3tc : true;
+  if ( !supported ) {
+    fprintf( stderr, "ERROR: %s is %s, which this GL can't sample\n", file_name, bc_format_name( (bc_format_t)format ) );
+    free( data );
+    return false;
+  }
+
+  GLenum tex_target = 6 == header->face_count ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+  size_t total      = 0;
+  glGenTextures( 1, tex );
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( tex_target, *tex );
+  for ( uint32_t l = 0; l < header->level_count; l++ ) {
+    int width         = level_dim( header->pixel_width, l );
+    int height        = level_dim( header->pixel_height, l );
+    size_t face_bytes = bc_image_bytes( (bc_format_t)format, width, height );
+    for ( uint32_t f = 0; f < header->face_count; f++ ) {
+      GLenum face_target = GL_TEXTURE_CUBE_MAP == tex_target ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + f : GL_TEXTURE_2D;
+      glCompressedTexImage2D( face_target, l, ktx2_formats[format].gl_format, width, height, 0, (GLsizei)face_bytes, data + index[l].byte_offset + f * face_bytes );
+    }
+    total += (size_t)index[l].byte_length;
+  }
+  glTexParameteri( tex_target, GL_TEXTURE_MAX_LEVEL, header->level_count - 1 );
+  /* BC4 is greyscale, read the same way as texture_loader.h's R8 textures */
+  if ( BC_FORMAT_BC4 == format ) {
+    const GLint grey[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+    glTexParameteriv( tex_target, GL_TEXTURE_SWIZZLE_RGBA, grey );
+  }
+  glTexParameteri( tex_target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( tex_target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glTexParameteri( tex_target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
+  glTexParameteri( tex_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexParameteri( tex_target, GL_TEXTURE_MIN_FILTER, header->level_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR );
+  if ( GL_TEXTURE_2D == tex_target ) {
+    GLfloat max_aniso = 0.0f;
+    glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso );
+    glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso );
+  }
+  free( data );
+  if ( target ) { *target = tex_target; }
+  if ( gpu_bytes ) { *gpu_bytes = total; }
+  return true;
+}
+
+bool read_ktx2_value( const char* file_name, const char* key, void* value, uint32_t n_bytes ) {
+  FILE* fp = fopen( file_name, "rb" );
+  if ( !fp ) { return false; }
+  ktx2_header_t header;
+  bool ok            = 1 == fread( &header, sizeof( header ), 1, fp ) && 0 == memcmp( header.identifier, ktx2_identifier, sizeof( ktx2_identifier ) );
+  ok                 = ok && header.kvd_byte_length > 0 && header.kvd_byte_length <= 65536 && 0 == fseek( fp, header.kvd_byte_offset, SEEK_SET );
+  unsigned char* kvd = ok ? (unsigned char*)malloc( header.kvd_byte_length ) : NULL;
+  ok                 = kvd && 1 == fread( kvd, header.kvd_byte_length, 1, fp );
+  fclose( fp );
+  bool found = false;
+  /* each pair is a length, then the key and its '\0', then the value */
+  for ( uint32_t at = 0; ok && !found && at + 4 <= header.kvd_byte_length; ) {
+    uint32_t length;
+    memcpy( &length, kvd + at, 4 );
+    if ( length > header.kvd_byte_length - at - 4 ) { break; }
+    const char* pair_key = (const char*)( kvd + at + 4 );
+    size_t key_bytes     = strnlen( pair_key, length ) + 1;
+    if ( key_bytes <= length && 0 == strcmp( pair_key, key ) && length - key_bytes == n_bytes ) {
+      memcpy( value, kvd + at + 4 + key_bytes, n_bytes );
+      found = true;
+    }
+    at += ( 4 + length + 3 ) / 4 * 4;
+  }
+  free( kvd );
+  return found;
+}
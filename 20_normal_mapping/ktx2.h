@@ -0,0 +1,50 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| KTX2 files of block compressed textures.                                     |
+| A KTX2 file holds a texture as the GPU stores it: a header, an index of      |
+| where each mipmap level is, a data format descriptor, and the levels         |
+| themselves, smallest first. A cube map has its 6 faces one after the other   |
+| in each level, in GL's order, +X, -X, +Y, -Y, +Z, -Z.                        |
+| Only the BCn formats in block_compression.h are written or read, and only    |
+| without supercompression, so each level can go straight to                   |
+| glCompressedTexImage2D() with no decoding at load time.                      |
+| Other data, like a cube map's spherical harmonics, can go in the file's      |
+| key/value metadata.                                                          |
+| See https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html               |
+\******************************************************************************/
+#ifndef _KTX2_H_
+#define _KTX2_H_
+
+#include "block_compression.h"
+#include <GL/glew.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* a metadata key and its value, which can be text, with its '\0', or binary */
+struct ktx2_key_value_t {
+  const char* key;
+  const void* value;
+  uint32_t n_bytes;
+};
+
+/* levels[l] has all of the faces of level l, one after the other. 2D textures
+have their bottom row first, as GL wants, and cube map faces their top row.
+key_values go after KTX2's own keys, which all start with "KTX", so their keys
+have to be in order and sort after those */
+bool write_ktx2( const char* file_name, bc_format_t format, int width, int height, int n_faces, int n_levels, const unsigned char* const* levels, const ktx2_key_value_t* key_values, int n_key_values );
+
+/* creates a 2D texture or a cube map, with all of the mipmap levels in the
+file. target and gpu_bytes, how much video memory the levels take, can be
+NULL */
+bool load_ktx2_texture( const char* file_name, GLuint* tex, GLenum* target, size_t* gpu_bytes );
+/* copies the value of a metadata key into value, if the file has the key and
+its value is n_bytes long */
+bool read_ktx2_value( const char* file_name, const char* key, void* value, uint32_t n_bytes );
+
+#endif
@@ -7,8 +7,13 @@
 | See individual libraries separate legal notices                              |
 |******************************************************************************|
 | Normal mapping                                                               |
+| The normal map is loaded from brickwork_normal-map.ktx2, which is the PNG    |
+| compressed to BC5 by the compress tool, and only keeps x and y. The fragment |
+| shader works out z. Build the tool with the Makefile, then remake it with    |
+|   ./compress -format bc5 -normalise brickwork_normal-map.png                 |
 \******************************************************************************/
 #include "gl_utils.h"
+#include "ktx2.h"
 #include "maths_funcs.h"
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h> // GLFW helper library
@@ -26,6 +31,7 @@
 #include <math.h>
 #define GL_LOG_FILE "gl.log"
 #define NMAP_IMG_FILE "brickwork_normal-map.png"
+#define NMAP_KTX2_FILE "brickwork_normal-map.ktx2"
 
 // keep track of window size for things like the viewport and the mouse cursor
 int g_gl_width       = 640;
@@ -209,9 +215,14 @@ int main() {
   glUniformMatrix4fv( view_mat_location, 1, GL_FALSE, view_mat.m );
   glUniformMatrix4fv( proj_mat_location, 1, GL_FALSE, proj_mat );
 
-  // load normal map image into texture
+  // load normal map image into texture. BC5 is 1 byte a pixel, against the 4 of RGBA8
   GLuint nmap_tex;
-  ( load_texture( NMAP_IMG_FILE, &nmap_tex ) );
+  size_t nmap_bytes = 0;
+  if ( load_ktx2_texture( NMAP_KTX2_FILE, &nmap_tex, NULL, &nmap_bytes ) ) {
+    printf( "normal map: %.1f KB of BC5 in video memory, a quarter of RGBA8\n", nmap_bytes / 1024.0 );
+  } else {
+    ( load_texture( NMAP_IMG_FILE, &nmap_tex ) );
+  }
 
   glEnable( GL_CULL_FACE ); // cull face
   glCullFace( GL_BACK );    // cull back face
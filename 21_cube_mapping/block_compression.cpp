@@ -0,0 +1,514 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Block compression (BCn) encoders and decoders.                               |
+\******************************************************************************/
+#include "block_compression.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/* times each endpoint fit is refined by least squares */
+#define REFINE_ITERATIONS 2
+
+static const char* format_names[BC_FORMAT_COUNT] = { "bc1", "bc3", "bc4", "bc5", "bc7" };
+
+/* BC7 interpolation weights, out of 64, for 4-bit indices */
+static const int bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+const char* bc_format_name( bc_format_t format ) { return format >= 0 && format < BC_FORMAT_COUNT ? format_names[format] : "unknown"; }
+
+int bc_block_bytes( bc_format_t format ) { return BC_FORMAT_BC1 == format || BC_FORMAT_BC4 == format ? 8 : 16; }
+
+size_t bc_image_bytes( bc_format_t format, int width, int height ) { return (size_t)( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * bc_block_bytes( format ); }
+
+int bc_format_channels( bc_format_t format ) {
+  switch ( format ) {
+  case BC_FORMAT_BC1: return 3;
+  case BC_FORMAT_BC4: return 1;
+  case BC_FORMAT_BC5: return 2;
+  default: return 4;
+  }
+}
+
+static int clamp_int( int v, int lo, int hi ) { return v < lo ? lo : ( v > hi ? hi : v ); }
+
+static int round_clamp( float v, int hi ) { return clamp_int( (int)floorf( v + 0.5f ), 0, hi ); }
+
+/* the main direction that the block's n-channel colours spread out along, by
+power iteration on their covariance. false if they are all the same */
+static bool principal_axis( const unsigned char* rgba, int n, float* mean, float* axis ) {
+  float cov[16];
+  memset( mean, 0, n * sizeof( float ) );
+  memset( cov, 0, sizeof( cov ) );
+  for ( int i = 0; i < 16; i++ ) {
+    for ( int c = 0; c < n; c++ ) { mean[c] += rgba[i * 4 + c] / 16.0f; }
+  }
+  for ( int i = 0; i < 16; i++ ) {
+    float d[4];
+    for ( int c = 0; c < n; c++ ) { d[c] = rgba[i * 4 + c] - mean[c]; }
+    for ( int r = 0; r < n; r++ ) {
+      for ( int c = 0; c < n; c++ ) { cov[r * 4 + c] += d[r] * d[c]; }
+    }
+  }
+  /* start from the channel that varies most, which can't be orthogonal to the
+  axis unless the block is flat */
+  int widest = 0;
+  for ( int c = 1; c < n; c++ ) {
+    if ( cov[c * 4 + c] > cov[widest * 4 + widest] ) { widest = c; }
+  }
+  if ( cov[widest * 4 + widest] < 1e-3f ) { return false; }
+  for ( int c = 0; c < n; c++ ) { axis[c] = cov[widest * 4 + c]; }
+  for ( int iteration = 0; iteration < 8; iteration++ ) {
+    float next[4] = { 0.0f }, biggest = 0.0f;
+    for ( int r = 0; r < n; r++ ) {
+      for ( int c = 0; c < n; c++ ) { next[r] += cov[r * 4 + c] * axis[c]; }
+      biggest = fabsf( next[r] ) > biggest ? fabsf( next[r] ) : biggest;
+    }
+    if ( biggest < 1e-6f ) { return false; }
+    for ( int c = 0; c < n; c++ ) { axis[c] = next[c] / biggest; }
+  }
+  float length = 0.0f;
+  for ( int c = 0; c < n; c++ ) { length += axis[c] * axis[c]; }
+  length = sqrtf( length );
+  for ( int c = 0; c < n; c++ ) { axis[c] /= length; }
+  return true;
+}
+
+/* the ends of the line through the colours, along the axis, kept in range */
+static void axis_endpoints( const unsigned char* rgba, int n, const float* mean, const float* axis, float* e0, float* e1 ) {
+  float t_min = 1e9f, t_max = -1e9f;
+  for ( int i = 0; i < 16; i++ ) {
+    float t = 0.0f;
+    for ( int c = 0; c < n; c++ ) { t += ( rgba[i * 4 + c] - mean[c] ) * axis[c]; }
+    t_min = t < t_min ? t : t_min;
+    t_max = t > t_max ? t : t_max;
+  }
+  for ( int c = 0; c < n; c++ ) {
+    e0[c] = fminf( fmaxf( mean[c] + axis[c] * t_min, 0.0f ), 255.0f );
+    e1[c] = fminf( fmaxf( mean[c] + axis[c] * t_max, 0.0f ), 255.0f );
+  }
+}
+
+/* the endpoints that best fit the pixels, given each pixel's weight of
+endpoint 0. false if every pixel picked the same weight */
+static bool least_squares_endpoints( const unsigned char* rgba, int n, int channel, const float* weights, float* e0, float* e1 ) {
+  float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[4] = { 0.0f }, bx[4] = { 0.0f };
+  for ( int i = 0; i < 16; i++ ) {
+    float a = weights[i], b = 1.0f - weights[i];
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for ( int c = 0; c < n; c++ ) {
+      ax[c] += a * rgba[i * 4 + channel + c];
+      bx[c] += b * rgba[i * 4 + channel + c];
+    }
+  }
+  float det = aa * bb - ab * ab;
+  if ( fabsf( det ) < 1e-6f ) { return false; }
+  for ( int c = 0; c < n; c++ ) {
+    e0[c] = fminf( fmaxf( ( ax[c] * bb - bx[c] * ab ) / det, 0.0f ), 255.0f );
+    e1[c] = fminf( fmaxf( ( bx[c] * aa - ax[c] * ab ) / det, 0.0f ), 255.0f );
+  }
+  return true;
+}
+
+/*----------------------------------- BC1 -----------------------------------*/
+
+static void rgb565_to_rgb( int c, int* rgb ) {
+  int r  = ( c >> 11 ) & 31, g = ( c >> 5 ) & 63, b = c & 31;
+  rgb[0] = ( r << 3 ) | ( r >> 2 );
+  rgb[1] = ( g << 2 ) | ( g >> 4 );
+  rgb[2] = ( b << 3 ) | ( b >> 2 );
+}
+
+static int rgb_to_rgb565( const float* rgb ) { return ( round_clamp( rgb[0] * 31.0f / 255.0f, 31 ) << 11 ) | ( round_clamp( rgb[1] * 63.0f / 255.0f, 63 ) << 5 ) | round_clamp( rgb[2] * 31.0f / 255.0f, 31 ); }
+
+/* four colours, or three and black when c0 <= c1. BC3 always has four */
+static void bc1_palette( int c0, int c1, bool four_colours, int palette[4][3] ) {
+  rgb565_to_rgb( c0, palette[0] );
+  rgb565_to_rgb( c1, palette[1] );
+  for ( int c = 0; c < 3; c++ ) {
+    if ( four_colours ) {
+      palette[2][c] = ( 2 * palette[0][c] + palette[1][c] ) / 3;
+      palette[3][c] = ( palette[0][c] + 2 * palette[1][c] ) / 3;
+    } else {
+      palette[2][c] = ( palette[0][c] + palette[1][c] ) / 2;
+      palette[3][c] = 0;
+    }
+  }
+}
+
+/* picks the nearest of the four colours for each pixel. c0 must be > c1, or
+equal, in which case every pixel gets c0. returns the squared error */
+static int bc1_indices( const unsigned char* rgba, int c0, int c1, int* indices ) {
+  int palette[4][3], error = 0;
+  bc1_palette( c0, c1, true, palette );
+  for ( int i = 0; i < 16; i++ ) {
+    int best = 0, best_d = 1 << 30;
+    for ( int p = 0; p < ( c0 == c1 ? 1 : 4 ); p++ ) {
+      int dr = rgba[i * 4] - palette[p][0], dg = rgba[i * 4 + 1] - palette[p][1], db = rgba[i * 4 + 2] - palette[p][2];
+      int d  = dr * dr + dg * dg + db * db;
+      if ( d < best_d ) {
+        best   = p;
+        best_d = d;
+      }
+    }
+    indices[i] = best;
+    error += best_d;
+  }
+  return error;
+}
+
+/* the colour half of BC1 and BC3, always in four-colour mode */
+static void encode_colour_block( const unsigned char* rgba, unsigned char* block ) {
+  float mean[3], axis[3], e0[3], e1[3];
+  int c0, c1;
+  if ( principal_axis( rgba, 3, mean, axis ) ) {
+    axis_endpoints( rgba, 3, mean, axis, e0, e1 );
+    c0 = rgb_to_rgb565( e0 );
+    c1 = rgb_to_rgb565( e1 );
+  } else {
+    c0 = c1 = rgb_to_rgb565( mean );
+  }
+  if ( c0 < c1 ) {
+    int tmp = c0;
+    c0      = c1;
+    c1      = tmp;
+  }
+  int indices[16], best_indices[16];
+  int best_error = bc1_indices( rgba, c0, c1, best_indices );
+  int best_c0    = c0, best_c1 = c1;
+  /* weights of c0 for each index */
+  const float index_weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+  for ( int iteration = 0; iteration < REFINE_ITERATIONS && best_error > 0 && best_c0 != best_c1; iteration++ ) {
+    float weights[16];
+    for ( int i = 0; i < 16; i++ ) { weights[i] = index_weights[best_indices[i]]; }
+    if ( !least_squares_endpoints( rgba, 3, 0, weights, e0, e1 ) ) { break; }
+    c0 = rgb_to_rgb565( e0 );
+    c1 = rgb_to_rgb565( e1 );
+    if ( c0 < c1 ) {
+      int tmp = c0;
+      c0      = c1;
+      c1      = tmp;
+    }
+    int error = bc1_indices( rgba, c0, c1, indices );
+    if ( error >= best_error ) { break; }
+    best_error = error;
+    best_c0    = c0;
+    best_c1    = c1;
+    memcpy( best_indices, indices, sizeof( indices ) );
+  }
+  uint32_t bits = 0;
+  for ( int i = 0; i < 16; i++ ) { bits |= (uint32_t)best_indices[i] << ( i * 2 ); }
+  block[0] = (unsigned char)best_c0;
+  block[1] = (unsigned char)( best_c0 >> 8 );
+  block[2] = (unsigned char)best_c1;
+  block[3] = (unsigned char)( best_c1 >> 8 );
+  for ( int b = 0; b < 4; b++ ) { block[4 + b] = (unsigned char)( bits >> ( b * 8 ) ); }
+}
+
+static void decode_colour_block( const unsigned char* block, bool always_four_colours, unsigned char* rgba ) {
+  int c0 = block[0] | block[1] << 8, c1 = block[2] | block[3] << 8;
+  int palette[4][3];
+  bc1_palette( c0, c1, always_four_colours || c0 > c1, palette );
+  uint32_t bits = block[4] | block[5] << 8 | block[6] << 16 | (uint32_t)block[7] << 24;
+  for ( int i = 0; i < 16; i++ ) {
+    int p = ( bits >> ( i * 2 ) ) & 3;
+    for ( int c = 0; c < 3; c++ ) { rgba[i * 4 + c] = (unsigned char)palette[p][c]; }
+  }
+}
+
+/*----------------------------------- BC4 -----------------------------------*/
+
+/* eight values from a0 down to a1 when a0 > a1. otherwise six, then 0 and 255 */
+static void bc4_palette( int a0, int a1, int* palette ) {
+  palette[0] = a0;
+  palette[1] = a1;
+  if ( a0 > a1 ) {
+    for ( int i = 1; i < 7; i++ ) { palette[i + 1] = ( ( 7 - i ) * a0 + i * a1 + 3 ) / 7; }
+  } else {
+    for ( int i = 1; i < 5; i++ ) { palette[i + 1] = ( ( 5 - i ) * a0 + i * a1 + 2 ) / 5; }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+static int bc4_indices( const unsigned char* values, int a0, int a1, int* indices ) {
+  int palette[8], error = 0;
+  bc4_palette( a0, a1, palette );
+  for ( int i = 0; i < 16; i++ ) {
+    int best = 0, best_d = 1 << 30;
+    for ( int p = 0; p < 8; p++ ) {
+      int d = ( values[i * 4] - palette[p] ) * ( values[i * 4] - palette[p] );
+      if ( d < best_d ) {
+        best   = p;
+        best_d = d;
+      }
+    }
+    indices[i] = best;
+    error += best_d;
+  }
+  return error;
+}
+
+/* one channel of the RGBA pixels, always in eight-value mode */
+static void encode_bc4_block( const unsigned char* rgba, int channel, unsigned char* block ) {
+  const unsigned char* values = rgba + channel;
+  int lo                      = 255, hi = 0;
+  for ( int i = 0; i < 16; i++ ) {
+    lo = values[i * 4] < lo ? values[i * 4] : lo;
+    hi = values[i * 4] > hi ? values[i * 4] : hi;
+  }
+  int indices[16], best_indices[16];
+  int best_a0    = hi, best_a1 = lo;
+  int best_error = bc4_indices( values, hi, lo, best_indices );
+  /* weights of a0 for each index */
+  const float index_weights[8] = { 1.0f, 0.0f, 6.0f / 7.0f, 5.0f / 7.0f, 4.0f / 7.0f, 3.0f / 7.0f, 2.0f / 7.0f, 1.0f / 7.0f };
+  for ( int iteration = 0; iteration < REFINE_ITERATIONS && best_error > 0 && hi > lo; iteration++ ) {
+    float weights[16], e0, e1;
+    for ( int i = 0; i < 16; i++ ) { weights[i] = index_weights[best_indices[i]]; }
+    if ( !least_squares_endpoints( rgba, 1, channel, weights, &e0, &e1 ) ) { break; }
+    int a0 = round_clamp( e0, 255 ), a1 = round_clamp( e1, 255 );
+    if ( a0 < a1 ) {
+      int tmp = a0;
+      a0      = a1;
+      a1      = tmp;
+    }
+    if ( a0 == a1 ) { break; }
+    int error = bc4_indices( values, a0, a1, indices );
+    if ( error >= best_error ) { break; }
+    best_error = error;
+    best_a0    = a0;
+    best_a1    = a1;
+    memcpy( best_indices, indices, sizeof( indices ) );
+  }
+  uint64_t bits = 0;
+  for ( int i = 0; i < 16; i++ ) { bits |= (uint64_t)best_indices[i] << ( i * 3 ); }
+  block[0] = (unsigned char)best_a0;
+  block[1] = (unsigned char)best_a1;
+  for ( int b = 0; b < 6; b++ ) { block[2 + b] = (unsigned char)( bits >> ( b * 8 ) ); }
+}
+
+static void decode_bc4_block( const unsigned char* block, int channel, unsigned char* rgba ) {
+  int palette[8];
+  bc4_palette( block[0], block[1], palette );
+  uint64_t bits = 0;
+  for ( int b = 0; b < 6; b++ ) { bits |= (uint64_t)block[2 + b] << ( b * 8 ); }
+  for ( int i = 0; i < 16; i++ ) { rgba[i * 4 + channel] = (unsigned char)palette[( bits >> ( i * 3 ) ) & 7]; }
+}
+
+/*----------------------------------- BC7 -----------------------------------*/
+
+/* a mode 6 endpoint: 7 bits a channel, and a shared lowest bit */
+struct bc7_endpoint_t {
+  int c[4];
+  int p;
+};
+
+static bc7_endpoint_t bc7_quantise( const float* e ) {
+  bc7_endpoint_t best;
+  float best_error = 1e9f;
+  for ( int p = 0; p < 2; p++ ) {
+    bc7_endpoint_t q;
+    float error = 0.0f;
+    q.p         = p;
+    for ( int c = 0; c < 4; c++ ) {
+      q.c[c]  = round_clamp( ( e[c] - p ) * 0.5f, 127 );
+      float d = (float)( q.c[c] << 1 | p ) - e[c];
+      error += d * d;
+    }
+    if ( error < best_error ) {
+      best       = q;
+      best_error = error;
+    }
+  }
+  return best;
+}
+
+static void bc7_palette( const bc7_endpoint_t* e0, const bc7_endpoint_t* e1, int palette[16][4] ) {
+  for ( int c = 0; c < 4; c++ ) {
+    int v0 = e0->c[c] << 1 | e0->p, v1 = e1->c[c] << 1 | e1->p;
+    for ( int i = 0; i < 16; i++ ) { palette[i][c] = ( ( 64 - bc7_weights[i] ) * v0 + bc7_weights[i] * v1 + 32 ) >> 6; }
+  }
+}
+
+static int bc7_indices( const unsigned char* rgba, const bc7_endpoint_t* e0, const bc7_endpoint_t* e1, int* indices ) {
+  int palette[16][4], error = 0;
+  bc7_palette( e0, e1, palette );
+  for ( int i = 0; i < 16; i++ ) {
+    int best = 0, best_d = 1 << 30;
+    for ( int p = 0; p < 16; p++ ) {
+      int d = 0;
+      for ( int c = 0; c < 4; c++ ) { d += ( rgba[i * 4 + c] - palette[p][c] ) * ( rgba[i * 4 + c] - palette[p][c] ); }
+      if ( d < best_d ) {
+        best   = p;
+        best_d = d;
+      }
+    }
+    indices[i] = best;
+    error += best_d;
+  }
+  return error;
+}
+
+/* writes n bits of v, lowest first, from bit *pos of the block on */
+static void put_bits( unsigned char* block, int* pos, int v, int n ) {
+  for ( int i = 0; i < n; i++, ( *pos )++ ) { block[*pos >> 3] |= (unsigned char)( ( ( v >> i ) & 1 ) << ( *pos & 7 ) ); }
+}
+
+static int get_bits( const unsigned char* block, int* pos, int n ) {
+  int v = 0;
+  for ( int i = 0; i < n; i++, ( *pos )++ ) { v |= ( ( block[*pos >> 3] >> ( *pos & 7 ) ) & 1 ) << i; }
+  return v;
+}
+
+static void encode_bc7_block( const unsigned char* rgba, unsigned char* block ) {
+  float mean[4], axis[4], e0[4], e1[4];
+  bc7_endpoint_t q0, q1;
+  if ( principal_axis( rgba, 4, mean, axis ) ) {
+    axis_endpoints( rgba, 4, mean, axis, e0, e1 );
+    q0 = bc7_quantise( e0 );
+    q1 = bc7_quantise( e1 );
+  } else {
+    q0 = q1 = bc7_quantise( mean );
+  }
+  int indices[16], best_indices[16];
+  int best_error        = bc7_indices( rgba, &q0, &q1, best_indices );
+  bc7_endpoint_t best_0 = q0, best_1 = q1;
+  for ( int iteration = 0; iteration < REFINE_ITERATIONS && best_error > 0; iteration++ ) {
+    float weights[16];
+    for ( int i = 0; i < 16; i++ ) { weights[i] = ( 64 - bc7_weights[best_indices[i]] ) / 64.0f; }
+    if ( !least_squares_endpoints( rgba, 4, 0, weights, e0, e1 ) ) { break; }
+    q0        = bc7_quantise( e0 );
+    q1        = bc7_quantise( e1 );
+    int error = bc7_indices( rgba, &q0, &q1, indices );
+    if ( error >= best_error ) { break; }
+    best_error = error;
+    best_0     = q0;
+    best_1     = q1;
+    memcpy( best_indices, indices, sizeof( indices ) );
+  }
+  /* the first pixel's index only has 3 bits, so it has to be in the lower half.
+  if not, the endpoints swap round */
+  if ( best_indices[0] & 8 ) {
+    bc7_endpoint_t tmp = best_0;
+    best_0             = best_1;
+    best_1             = tmp;
+    for ( int i = 0; i < 16; i++ ) { best_indices[i] = 15 - best_indices[i]; }
+  }
+  memset( block, 0, 16 );
+  int pos = 0;
+  put_bits( block, &pos, 1 << 6, 7 ); // mode 6
+  for ( int c = 0; c < 4; c++ ) {
+    put_bits( block, &pos, best_0.c[c], 7 );
+    put_bits( block, &pos, best_1.c[c], 7 );
+  }
+  put_bits( block, &pos, best_0.p, 1 );
+  put_bits( block, &pos, best_1.p, 1 );
+  for ( int i = 0; i < 16; i++ ) { put_bits( block, &pos, best_indices[i], 0 == i ? 3 : 4 ); }
+}
+
+/* only mode 6, as written above. other modes decode as transparent black */
+static void decode_bc7_block( const unsigned char* block, unsigned char* rgba ) {
+  int pos = 0;
+  if ( get_bits( block, &pos, 7 ) != 1 << 6 ) {
+    memset( rgba, 0, 64 );
+    return;
+  }
+  bc7_endpoint_t e0, e1;
+  for ( int c = 0; c < 4; c++ ) {
+    e0.c[c] = get_bits( block, &pos, 7 );
+    e1.c[c] = get_bits( block, &pos, 7 );
+  }
+  e0.p = get_bits( block, &pos, 1 );
+  e1.p = get_bits( block, &pos, 1 );
+  int palette[16][4];
+  bc7_palette( &e0, &e1, palette );
+  for ( int i = 0; i < 16; i++ ) {
+    int index = get_bits( block, &pos, 0 == i ? 3 : 4 );
+    for ( int c = 0; c < 4; c++ ) { rgba[i * 4 + c] = (unsigned char)palette[index][c]; }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bc_encode_block( bc_format_t format, const unsigned char* rgba, unsigned char* block ) {
+  switch ( format ) {
+  case BC_FORMAT_BC1: encode_colour_block( rgba, block ); break;
+  case BC_FORMAT_BC3:
+    encode_bc4_block( rgba, 3, block );
+    encode_colour_block( rgba, block + 8 );
+    break;
+  case BC_FORMAT_BC4: encode_bc4_block( rgba, 0, block ); break;
+  case BC_FORMAT_BC5:
+    encode_bc4_block( rgba, 0, block );
+    encode_bc4_block( rgba, 1, block + 8 );
+    break;
+  case BC_FORMAT_BC7: encode_bc7_block( rgba, block ); break;
+  default: break;
+  }
+}
+
+void bc_decode_block( bc_format_t format, const unsigned char* block, unsigned char* rgba ) {
+  memset( rgba, 0, 64 );
+  for ( int i = 0; i < 16; i++ ) { rgba[i * 4 + 3] = 255; }
+  switch ( format ) {
+  case BC_FORMAT_BC1: decode_colour_block( block, false, rgba ); break;
+  case BC_FORMAT_BC3:
+    decode_bc4_block( block, 3, rgba );
+    decode_colour_block( block + 8, true, rgba );
+    break;
+  case BC_FORMAT_BC4: decode_bc4_block( block, 0, rgba ); break;
+  case BC_FORMAT_BC5:
+    decode_bc4_block( block, 0, rgba );
+    decode_bc4_block( block + 8, 1, rgba );
+    break;
+  case BC_FORMAT_BC7: decode_bc7_block( block, rgba ); break;
+  default: break;
+  }
+}
+
+void bc_encode_rows( bc_format_t format, const unsigned char* pixels, int n_channels, int width, int height, int first_row, int last_row, unsigned char* blocks ) {
+  int blocks_across = ( width + 3 ) / 4;
+  int block_bytes   = bc_block_bytes( format );
+  for ( int by = first_row; by < last_row; by++ ) {
+    for ( int bx = 0; bx < blocks_across; bx++ ) {
+      unsigned char rgba[64];
+      for ( int i = 0; i < 16; i++ ) {
+        int x                    = bx * 4 + ( i & 3 ) < width ? bx * 4 + ( i & 3 ) : width - 1;
+        int y                    = by * 4 + ( i >> 2 ) < height ? by * 4 + ( i >> 2 ) : height - 1;
+        const unsigned char* src = pixels + ( (size_t)y * width + x ) * n_channels;
+        unsigned char* dst       = rgba + i * 4;
+        if ( n_channels < 3 ) {
+          dst[0] = dst[1] = dst[2] = src[0];
+          dst[3] = 2 == n_channels ? src[1] : 255;
+        } else {
+          memcpy( dst, src, 3 );
+          dst[3] = 4 == n_channels ? src[3] : 255;
+        }
+      }
+      bc_encode_block( format, rgba, blocks + ( (size_t)by * blocks_across + bx ) * block_bytes );
+    }
+  }
+}
+
+void bc_decode_image( bc_format_t format, const unsigned char* blocks, int width, int height, unsigned char* rgba ) {
+  int blocks_across = ( width + 3 ) / 4;
+  int block_bytes   = bc_block_bytes( format );
+  for ( int by = 0; by < ( height + 3 ) / 4; by++ ) {
+    for ( int bx = 0; bx < blocks_across; bx++ ) {
+      unsigned char pixels[64];
+      bc_decode_block( format, blocks + ( (size_t)by * blocks_across + bx ) * block_bytes, pixels );
+      for ( int i = 0; i < 16; i++ ) {
+        int x = bx * 4 + ( i & 3 ), y = by * 4 + ( i >> 2 );
+        if ( x < width && y < height ) { memcpy( rgba + ( (size_t)y * width + x ) * 4, pixels + i * 4, 4 ); }
+      }
+    }
+  }
+}
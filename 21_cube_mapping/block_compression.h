@@ -0,0 +1,51 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Block compression (BCn) encoders and decoders.                               |
+| Each 4x4 block of pixels is stored in 8 or 16 bytes, which GPUs decode as    |
+| they sample, so a compressed texture stays compressed in video memory:       |
+|   BC1  RGB         8 bytes a block, 1/8 the size of RGBA8                    |
+|   BC3  RGBA        16 bytes, BC1 colour plus a BC4 block for alpha           |
+|   BC4  R           8 bytes, for greyscale                                    |
+|   BC5  RG          16 bytes, two BC4 blocks. for normal maps, with z worked  |
+|                    out in the shader                                         |
+|   BC7  RGBA        16 bytes, better quality than BC1 or BC3                  |
+| Colour endpoints are fitted along the principal axis of the block's colours, |
+| then refined by least squares. BC7 blocks are only ever written in mode 6,   |
+| which has one pair of RGBA endpoints and 16 steps between them, and the      |
+| decoder only reads that mode back.                                           |
+\******************************************************************************/
+#ifndef _BLOCK_COMPRESSION_H_
+#define _BLOCK_COMPRESSION_H_
+
+#include <stddef.h>
+
+enum bc_format_t { BC_FORMAT_BC1, BC_FORMAT_BC3, BC_FORMAT_BC4, BC_FORMAT_BC5, BC_FORMAT_BC7, BC_FORMAT_COUNT };
+
+/* "bc1", "bc3" etc. */
+const char* bc_format_name( bc_format_t format );
+int bc_block_bytes( bc_format_t format );
+/* the size of an image in this format. edges that aren't a multiple of 4
+still take whole blocks */
+size_t bc_image_bytes( bc_format_t format, int width, int height );
+/* how many of R, G, B, A the format keeps */
+int bc_format_channels( bc_format_t format );
+
+/* rgba is 16 pixels, 4 bytes each, row by row */
+void bc_encode_block( bc_format_t format, const unsigned char* rgba, unsigned char* block );
+/* channels the format doesn't keep come back as 0, with alpha 255 */
+void bc_decode_block( bc_format_t format, const unsigned char* block, unsigned char* rgba );
+
+/* encodes rows of blocks, first_row to last_row - 1, of an image with
+n_channels bytes a pixel. grey is spread to r, g, and b, as texture_loader.h
+reads it. pixels past the edges repeat the last row or column */
+void bc_encode_rows( bc_format_t format, const unsigned char* pixels, int n_channels, int width, int height, int first_row, int last_row, unsigned char* blocks );
+/* decodes a whole image to RGBA */
+void bc_decode_image( bc_format_t format, const unsigned char* blocks, int width, int height, unsigned char* rgba );
+
+#endif
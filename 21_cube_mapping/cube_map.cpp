@@ -0,0 +1,389 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Cube map loading and prefiltering.                                           |
+\******************************************************************************/
+#include "cube_map.h"
+#include <atomic>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#define CUBE_PI 3.14159265358979f
+/* the irradiance is worked out from the first level this size or smaller */
+#define SH_LEVEL_SIZE 64
+
+static float g_srgb_to_linear[256];
+
+static void make_srgb_table() {
+  for ( int i = 0; i < 256; i++ ) {
+    float c             = i / 255.0f;
+    g_srgb_to_linear[i] = c <= 0.04045f ? c / 12.92f : powf( ( c + 0.055f ) / 1.055f, 2.4f );
+  }
+}
+
+static unsigned char linear_to_srgb( float c ) {
+  c = c < 0.0f ? 0.0f : ( c > 1.0f ? 1.0f : c );
+  c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf( c, 1.0f / 2.4f ) - 0.055f;
+  return (unsigned char)( c * 255.0f + 0.5f );
+}
+
+/* each face's axis, and the directions that its s and t go in, from the table
+in the GL spec, backwards */
+static const float face_axes[6][3][3] = {
+  { { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f } }, // +X
+  { { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, -1.0f, 0.0f } }, // -X
+  { { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },   // +Y
+  { { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } }, // -Y
+  { { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } },  // +Z
+  { { 0.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } } // -Z
+};
+
+/* the direction through a point on a face, where s and t go from -1 to 1, left
+to right and top to bottom. not normalised */
+static void face_direction( int face, float s, float t, float* dir ) {
+  for ( int i = 0; i < 3; i++ ) { dir[i] = face_axes[face][0][i] + s * face_axes[face][1][i] + t * face_axes[face][2][i]; }
+}
+
+/* the face a direction hits, and where, from -1 to 1 */
+static int direction_face( const float* dir, float* s, float* t ) {
+  float ax = fabsf( dir[0] ), ay = fabsf( dir[1] ), az = fabsf( dir[2] );
+  if ( ax >= ay && ax >= az ) {
+    *s = ( dir[0] > 0.0f ? -dir[2] : dir[2] ) / ax;
+    *t = -dir[1] / ax;
+    return dir[0] > 0.0f ? 0 : 1;
+  }
+  if ( ay >= az ) {
+    *s = dir[0] / ay;
+    *t = ( dir[1] > 0.0f ? dir[2] : -dir[2] ) / ay;
+    return dir[1] > 0.0f ? 2 : 3;
+  }
+  *s = ( dir[2] > 0.0f ? dir[0] : -dir[0] ) / az;
+  *t = -dir[1] / az;
+  return dir[2] > 0.0f ? 4 : 5;
+}
+
+static void texel_linear( const texture_image_t* image, int level, int x, int y, float* rgb ) {
+  int n                      = image->n_channels;
+  const unsigned char* texel = image->levels[level] + ( (size_t)y * texture_level_dim( image->width, level ) + x ) * n;
+  rgb[0]                     = g_srgb_to_linear[texel[0]];
+  rgb[1]                     = g_srgb_to_linear[texel[n < 3 ? 0 : 1]];
+  rgb[2]                     = g_srgb_to_linear[texel[n < 3 ? 0 : 2]];
+}
+
+/* bilinear, clamped to the edges of the face */
+static void sample_level( const texture_image_t* image, int level, float s, float t, float* rgb ) {
+  int dim  = texture_level_dim( image->width, level );
+  float x  = ( s * 0.5f + 0.5f ) * dim - 0.5f;
+  float y  = ( t * 0.5f + 0.5f ) * dim - 0.5f;
+  x        = x < 0.0f ? 0.0f : ( x > dim - 1 ? dim - 1 : x );
+  y        = y < 0.0f ? 0.0f : ( y > dim - 1 ? dim - 1 : y );
+  int x0   = (int)x, y0 = (int)y;
+  int x1   = x0 + 1 < dim ? x0 + 1 : x0;
+  int y1   = y0 + 1 < dim ? y0 + 1 : y0;
+  float fx = x - x0, fy = y - y0;
+  float a[3], b[3], c[3], d[3];
+  texel_linear( image, level, x0, y0, a );
+  texel_linear( image, level, x1, y0, b );
+  texel_linear( image, level, x0, y1, c );
+  texel_linear( image, level, x1, y1, d );
+  for ( int i = 0; i < 3; i++ ) { rgb[i] = ( a[i] * ( 1.0f - fx ) + b[i] * fx ) * ( 1.0f - fy ) + ( c[i] * ( 1.0f - fx ) + d[i] * fx ) * fy; }
+}
+
+/* trilinear, in linear colour */
+static void sample_cube( const texture_image_t* faces, const float* dir, float lod, float* rgb ) {
+  float s, t;
+  const texture_image_t* image = &faces[direction_face( dir, &s, &t )];
+  lod                          = lod < 0.0f ? 0.0f : ( lod > image->n_levels - 1 ? image->n_levels - 1 : lod );
+  int level                    = (int)lod;
+  float f                      = lod - level;
+  sample_level( image, level, s, t, rgb );
+  if ( f > 0.0f && level + 1 < image->n_levels ) {
+    float next[3];
+    sample_level( image, level + 1, s, t, next );
+    for ( int i = 0; i < 3; i++ ) { rgb[i] += ( next[i] - rgb[i] ) * f; }
+  }
+}
+
+static void flip_face( texture_image_t* image ) {
+  for ( int l = 0; l < image->n_levels; l++ ) {
+    int dim            = texture_level_dim( image->width, l );
+    size_t row_bytes   = (size_t)dim * image->n_channels;
+    unsigned char* tmp = (unsigned char*)malloc( row_bytes );
+    for ( int y = 0; y < dim / 2; y++ ) {
+      unsigned char* top    = image->levels[l] + y * row_bytes;
+      unsigned char* bottom = image->levels[l] + ( dim - 1 - y ) * row_bytes;
+      memcpy( tmp, top, row_bytes );
+      memcpy( top, bottom, row_bytes );
+      memcpy( bottom, tmp, row_bytes );
+    }
+    free( tmp );
+  }
+}
+
+bool load_cube_map_faces( const char* const* file_names, texture_image_t* faces, int n_threads ) {
+  bool ok = 6 == load_texture_images( file_names, 6, faces, n_threads );
+  for ( int f = 0; ok && f < 6; f++ ) {
+    if ( faces[f].width != faces[f].height || faces[f].width != faces[0].width ) {
+      fprintf( stderr, "ERROR: %s is %ix%i. cube map faces have to be square and all the same size\n", file_names[f], faces[f].width, faces[f].height );
+      ok = false;
+    }
+  }
+  if ( !ok ) {
+    for ( int f = 0; f < 6; f++ ) { free_texture_image( &faces[f] ); }
+    return false;
+  }
+  std::thread threads[5];
+  for ( int f = 0; f < 5; f++ ) { threads[f] = std::thread( flip_face, &faces[f] ); }
+  flip_face( &faces[5] );
+  for ( int f = 0; f < 5; f++ ) { threads[f].join(); }
+  return true;
+}
+
+bool create_cube_map_from_faces( const texture_image_t* faces, GLuint* tex ) {
+  int n = faces[0].n_channels;
+  if ( n < 1 || n > 4 ) { return false; }
+  const GLint internal_formats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+  const GLenum formats[]         = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+  glGenTextures( 1, tex );
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( GL_TEXTURE_CUBE_MAP, *tex );
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+  for ( int f = 0; f < 6; f++ ) {
+    for ( int l = 0; l < faces[f].n_levels; l++ ) {
+      int dim = texture_level_dim( faces[f].width, l );
+      glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, l, internal_formats[n - 1], dim, dim, 0, formats[n - 1], GL_UNSIGNED_BYTE, faces[f].levels[l] );
+    }
+  }
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, faces[0].n_levels - 1 );
+  if ( n < 3 ) {
+    const GLint grey[] = { GL_RED, GL_RED, GL_RED, 1 == n ? GL_ONE : GL_GREEN };
+    glTexParameteriv( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_SWIZZLE_RGBA, grey );
+  }
+  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  return true;
+}
+
+/* a direction to sample, around a normal of 0, 0, 1, and the source level to
+read it from */
+struct prefilter_sample_t {
+  float dir[3];
+  float weight; // n.l
+  float lod;
+};
+
+/* a row of texels in one face of one level */
+struct prefilter_task_t {
+  int level, face, row;
+};
+
+struct prefilter_job_t {
+  const texture_image_t* faces;
+  int size;
+  unsigned char** levels;
+  prefilter_sample_t* samples[TEXTURE_MAX_LEVELS];
+  int n_samples[TEXTURE_MAX_LEVELS];
+  const prefilter_task_t* tasks;
+  int n_tasks;
+  std::atomic<int> next_task;
+};
+
+/* a well spread out point in the unit square, for sample i of n */
+static void hammersley( int i, int n, float* xy ) {
+  uint32_t bits = (uint32_t)i;
+  bits          = ( bits << 16 ) | ( bits >> 16 );
+  bits          = ( ( bits & 0x55555555u ) << 1 ) | ( ( bits & 0xAAAAAAAAu ) >> 1 );
+  bits          = ( ( bits & 0x33333333u ) << 2 ) | ( ( bits & 0xCCCCCCCCu ) >> 2 );
+  bits          = ( ( bits & 0x0F0F0F0Fu ) << 4 ) | ( ( bits & 0xF0F0F0F0u ) >> 4 );
+  bits          = ( ( bits & 0x00FF00FFu ) << 8 ) | ( ( bits & 0xFF00FF00u ) >> 8 );
+  xy[0]         = ( i + 0.5f ) / n;
+  xy[1]         = bits * 2.3283064365386963e-10f;
+}
+
+/* the view is assumed to be along the normal, as if the surface were looked at
+head on, so that a level only depends on the direction. microfacet normals, h,
+are spread out as GGX says, and reflect the view into l. where samples are
+far apart, each is read from a blurrier level of the source, as big as the
+solid angle that the sample stands for, after Colbert and Krivanek, "GPU-Based
+Importance Sampling", GPU Gems 3 */
+static int make_samples( float roughness, int n_samples, int source_size, prefilter_sample_t* samples ) {
+  if ( roughness <= 0.0f ) {
+    samples[0] = prefilter_sample_t{ { 0.0f, 0.0f, 1.0f }, 1.0f, 0.0f };
+    return 1;
+  }
+  float a2          = roughness * roughness * roughness * roughness;
+  float texel_angle = 4.0f * CUBE_PI / ( 6.0f * source_size * source_size );
+  int n             = 0;
+  for ( int i = 0; i < n_samples; i++ ) {
+    float xy[2];
+    hammersley( i, n_samples, xy );
+    float phi       = 2.0f * CUBE_PI * xy[0];
+    float cos_theta = sqrtf( ( 1.0f - xy[1] ) / ( 1.0f + ( a2 - 1.0f ) * xy[1] ) );
+    float sin_theta = sqrtf( 1.0f - cos_theta * cos_theta );
+    float h[3]      = { sin_theta * cosf( phi ), sin_theta * sinf( phi ), cos_theta };
+    /* l = 2 (v.h) h - v, with v = n = 0, 0, 1 */
+    float n_dot_l = 2.0f * h[2] * h[2] - 1.0f;
+    if ( n_dot_l <= 0.0f ) { continue; }
+    float d                    = a2 / ( CUBE_PI * powf( h[2] * h[2] * ( a2 - 1.0f ) + 1.0f, 2.0f ) );
+    float sample_angle         = 1.0f / ( n_samples * d * 0.25f );
+    prefilter_sample_t* sample = &samples[n++];
+    sample->dir[0]             = 2.0f * h[2] * h[0];
+    sample->dir[1]             = 2.0f * h[2] * h[1];
+    sample->dir[2]             = n_dot_l;
+    sample->weight             = n_dot_l;
+    sample->lod                = 0.5f * log2f( sample_angle / texel_angle ) + 1.0f;
+  }
+  return n;
+}
+
+static void prefilter_worker( prefilter_job_t* job ) {
+  for ( int t = job->next_task++; t < job->n_tasks; t = job->next_task++ ) {
+    const prefilter_task_t* task      = &job->tasks[t];
+    int dim                           = texture_level_dim( job->size, task->level );
+    const prefilter_sample_t* samples = job->samples[task->level];
+    unsigned char* out                = job->levels[task->level] + ( ( (size_t)task->face * dim + task->row ) * dim ) * 4;
+    for ( int x = 0; x < dim; x++ ) {
+      float n[3];
+      face_direction( task->face, ( x + 0.5f ) / dim * 2.0f - 1.0f, ( task->row + 0.5f ) / dim * 2.0f - 1.0f, n );
+      float length = sqrtf( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+      for ( int i = 0; i < 3; i++ ) { n[i] /= length; }
+      /* a tangent and bitangent to turn the samples around n */
+      bool z_up     = fabsf( n[2] ) < 0.999f;
+      float up[3]   = { z_up ? 0.0f : 1.0f, 0.0f, z_up ? 1.0f : 0.0f };
+      float tx[3]   = { up[1] * n[2] - up[2] * n[1], up[2] * n[0] - up[0] * n[2], up[0] * n[1] - up[1] * n[0] };
+      float tlength = sqrtf( tx[0] * tx[0] + tx[1] * tx[1] + tx[2] * tx[2] );
+      for ( int i = 0; i < 3; i++ ) { tx[i] /= tlength; }
+      float ty[3]       = { n[1] * tx[2] - n[2] * tx[1], n[2] * tx[0] - n[0] * tx[2], n[0] * tx[1] - n[1] * tx[0] };
+      float sum[3]      = { 0.0f, 0.0f, 0.0f };
+      float sum_weights = 0.0f;
+      for ( int s = 0; s < job->n_samples[task->level]; s++ ) {
+        const prefilter_sample_t* sample = &samples[s];
+        float l[3], rgb[3];
+        for ( int i = 0; i < 3; i++ ) { l[i] = tx[i] * sample->dir[0] + ty[i] * sample->dir[1] + n[i] * sample->dir[2]; }
+        sample_cube( job->faces, l, sample->lod, rgb );
+        for ( int i = 0; i < 3; i++ ) { sum[i] += rgb[i] * sample->weight; }
+        sum_weights += sample->weight;
+      }
+      for ( int i = 0; i < 3; i++ ) { out[x * 4 + i] = linear_to_srgb( sum[i] / sum_weights ); }
+      out[x * 4 + 3] = 255;
+    }
+  }
+}
+
+bool prefilter_cube_map( const texture_image_t* faces, int size, int n_levels, int n_samples, int n_threads, unsigned char** levels ) {
+  make_srgb_table();
+  n_levels = n_levels < TEXTURE_MAX_LEVELS ? n_levels : TEXTURE_MAX_LEVELS;
+  prefilter_job_t job;
+  memset( levels, 0, n_levels * sizeof( unsigned char* ) );
+  job.faces   = faces;
+  job.size    = size;
+  job.levels  = levels;
+  job.n_tasks = 0;
+  bool ok     = true;
+  for ( int l = 0; l < n_levels; l++ ) {
+    int dim        = texture_level_dim( size, l );
+    levels[l]      = (unsigned char*)malloc( (size_t)6 * dim * dim * 4 );
+    job.samples[l] = (prefilter_sample_t*)malloc( ( n_samples > 1 ? n_samples : 1 ) * sizeof( prefilter_sample_t ) );
+    ok             = ok && levels[l] && job.samples[l];
+    if ( !ok ) { break; }
+    /* level 0 is a mirror, so it only has to be resampled to size */
+    float roughness  = n_levels > 1 ? (float)l / ( n_levels - 1 ) : 0.0f;
+    job.n_samples[l] = make_samples( roughness, n_samples, faces[0].width, job.samples[l] );
+    if ( 0 == l ) { job.samples[l][0].lod = log2f( (float)faces[0].width / size ); }
+    job.n_tasks += 6 * dim;
+  }
+  prefilter_task_t* tasks = ok ? (prefilter_task_t*)malloc( job.n_tasks * sizeof( prefilter_task_t ) ) : NULL;
+  if ( !tasks ) {
+    for ( int l = 0; l < n_levels; l++ ) {
+      free( levels[l] );
+      levels[l] = NULL;
+    }
+    fprintf( stderr, "ERROR: out of memory\n" );
+    return false;
+  }
+  /* roughest levels first, as their rows take the most samples */
+  job.n_tasks = 0;
+  for ( int l = n_levels - 1; l >= 0; l-- ) {
+    for ( int f = 0; f < 6; f++ ) {
+      for ( int row = 0; row < texture_level_dim( size, l ); row++ ) { tasks[job.n_tasks++] = prefilter_task_t{ l, f, row }; }
+    }
+  }
+  job.tasks     = tasks;
+  job.next_task = 0;
+
+  n_threads            = n_threads > 0 ? n_threads : (int)std::thread::hardware_concurrency();
+  std::thread* threads = new std::thread[n_threads > 1 ? n_threads - 1 : 1];
+  for ( int t = 0; t < n_threads - 1; t++ ) { threads[t] = std::thread( prefilter_worker, &job ); }
+  prefilter_worker( &job );
+  for ( int t = 0; t < n_threads - 1; t++ ) { threads[t].join(); }
+  delete[] threads;
+  for ( int l = 0; l < n_levels; l++ ) { free( job.samples[l] ); }
+  free( tasks );
+  return true;
+}
+
+/* the 9 spherical harmonics of bands 0, 1, and 2, without their constants,
+which are folded into the coefficients */
+static void sh_basis( const float* d, float* y ) {
+  y[0] = 0.282095f;
+  y[1] = 0.488603f * d[1];
+  y[2] = 0.488603f * d[2];
+  y[3] = 0.488603f * d[0];
+  y[4] = 1.092548f * d[0] * d[1];
+  y[5] = 1.092548f * d[1] * d[2];
+  y[6] = 0.315392f * ( 3.0f * d[2] * d[2] - 1.0f );
+  y[7] = 1.092548f * d[0] * d[2];
+  y[8] = 0.546274f * ( d[0] * d[0] - d[1] * d[1] );
+}
+
+/* projects the light from every texel onto the harmonics, weighted by the
+solid angle of the texel, which is smaller towards a face's corners. then
+each band is convolved with the cosine lobe of a diffuse surface, from
+Ramamoorthi and Hanrahan, "An Efficient Representation for Irradiance
+Environment Maps", and divided by pi */
+void cube_map_irradiance_sh( const texture_image_t* faces, float* sh ) {
+  make_srgb_table();
+  memset( sh, 0, CUBE_MAP_SH_COEFFS * 3 * sizeof( float ) );
+  int level = 0;
+  while ( level + 1 < faces[0].n_levels && texture_level_dim( faces[0].width, level ) > SH_LEVEL_SIZE ) { level++; }
+  int dim            = texture_level_dim( faces[0].width, level );
+  float total_weight = 0.0f;
+  for ( int f = 0; f < 6; f++ ) {
+    for ( int y = 0; y < dim; y++ ) {
+      for ( int x = 0; x < dim; x++ ) {
+        float s = ( x + 0.5f ) / dim * 2.0f - 1.0f, t = ( y + 0.5f ) / dim * 2.0f - 1.0f;
+        float d[3], basis[CUBE_MAP_SH_COEFFS], rgb[3];
+        face_direction( f, s, t, d );
+        float length2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+        float length  = sqrtf( length2 );
+        for ( int i = 0; i < 3; i++ ) { d[i] /= length; }
+        float weight = 1.0f / ( length2 * length );
+        sh_basis( d, basis );
+        texel_linear( &faces[f], level, x, y, rgb );
+        for ( int i = 0; i < CUBE_MAP_SH_COEFFS; i++ ) {
+          for ( int c = 0; c < 3; c++ ) { sh[i * 3 + c] += basis[i] * rgb[c] * weight; }
+        }
+        total_weight += weight;
+      }
+    }
+  }
+  /* the weights, summed, are the whole sphere */
+  const float band_scales[3] = { 1.0f, 2.0f / 3.0f, 0.25f };
+  for ( int i = 0; i < CUBE_MAP_SH_COEFFS; i++ ) {
+    float band = band_scales[0 == i ? 0 : ( i < 4 ? 1 : 2 )];
+    for ( int c = 0; c < 3; c++ ) { sh[i * 3 + c] *= 4.0f * CUBE_PI / total_weight * band; }
+  }
+}
@@ -0,0 +1,53 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Cube map loading and prefiltering.                                           |
+| The six faces are decoded at once, a thread each, through texture_loader.h,  |
+| which also makes their mipmaps, so that a reflection far away, or on a       |
+| curved surface, samples a smaller level instead of aliasing.                 |
+| A glossy surface reflects a cone of directions, wider the rougher it is. The |
+| prefilter works that blur out ahead of time, with the GGX distribution of    |
+| microfacet normals, into a chain of mipmap levels, each for a rougher        |
+| surface than the last, so the shader takes one textureLod() instead of many  |
+| samples. Each texel is the average of n_samples directions, importance       |
+| sampled from the GGX lobe, and each of those is read from a source level     |
+| about as blurry as the gap between samples, so a few dozen are enough.       |
+| Diffuse light, from the whole hemisphere around a normal, is smoother still, |
+| and fits in 9 spherical harmonic coefficients per colour channel.            |
+| Colours are made linear before they are averaged, and sRGB again after.      |
+\******************************************************************************/
+#ifndef _CUBE_MAP_H_
+#define _CUBE_MAP_H_
+
+#include "texture_loader.h"
+#include <GL/glew.h>
+
+/* coefficients of spherical harmonic bands 0, 1, and 2 */
+#define CUBE_MAP_SH_COEFFS 9
+/* the metadata key that the prefilter tool keeps the coefficients under, in
+its KTX2 file, as 9 RGB floats */
+#define CUBE_MAP_SH_KEY "irradianceSH"
+
+/* loads six images, +X -X +Y -Y +Z -Z, with n_threads threads in all, a face
+each, and their mipmaps. cube map faces have their top row first, so they are
+flipped back after. the images have to be square and all the same size */
+bool load_cube_map_faces( const char* const* file_names, texture_image_t* faces, int n_threads );
+/* creates a cube map of the faces and all of their levels, trilinear */
+bool create_cube_map_from_faces( const texture_image_t* faces, GLuint* tex );
+
+/* works out n_levels levels, size x size pixels to start with and half as big
+each level after, for roughness 0 in level 0 up to 1 in the last, with
+n_samples samples per texel on n_threads threads. levels[l] gets all 6 faces
+of level l, RGBA, one after the other, and has to be freed */
+bool prefilter_cube_map( const texture_image_t* faces, int size, int n_levels, int n_samples, int n_threads, unsigned char** levels );
+/* the light falling on a surface facing each direction, divided by pi, as
+coefficients for the same 9 spherical harmonics as sh_irradiance() in the
+shaders. sh is 9 RGB, 27 floats, in linear colour */
+void cube_map_irradiance_sh( const texture_image_t* faces, float* sh );
+
+#endif
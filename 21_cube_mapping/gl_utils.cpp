@@ -15,6 +15,7 @@
 #include "gl_utils.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "texture_loader.h"
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
@@ -248,44 +249,12 @@ GLuint create_programme_from_files( const char* vert_file_name, const char* frag
 }
 
 /*----------------------------------TEXTURES----------------------------------*/
+/* decodes the image and makes its mipmaps through the texture pipeline, keeping
+its own number of channels, then uploads them */
 bool load_texture( const char* file_name, GLuint* tex ) {
-  int x, y, n;
-  int force_channels        = 4;
-  unsigned char* image_data = stbi_load( file_name, &x, &y, &n, force_channels );
-  if ( !image_data ) {
-    fprintf( stderr, "ERROR: could not load %s\n", file_name );
-    return false;
-  }
-  // NPOT check
-  if ( ( x & ( x - 1 ) ) != 0 || ( y & ( y - 1 ) ) != 0 ) { fprintf( stderr, "WARNING: texture %s is not power-of-2 dimensions\n", file_name ); }
-  int width_in_bytes    = x * 4;
-  unsigned char* top    = NULL;
-  unsigned char* bottom = NULL;
-  unsigned char temp    = 0;
-  int half_height       = y / 2;
-
-  for ( int row = 0; row < half_height; row++ ) {
-    top    = image_data + row * width_in_bytes;
-    bottom = image_data + ( y - row - 1 ) * width_in_bytes;
-    for ( int col = 0; col < width_in_bytes; col++ ) {
-      temp    = *top;
-      *top    = *bottom;
-      *bottom = temp;
-      top++;
-      bottom++;
-    }
-  }
-  glGenTextures( 1, tex );
-  glBindTexture( GL_TEXTURE_2D, *tex );
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data );
-  glGenerateMipmap( GL_TEXTURE_2D );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-  GLfloat max_aniso = 0.0f;
-  glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso );
-  // set the maximum!
-  glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso );
-  return true;
+  texture_image_t image;
+  if ( !load_texture_image( file_name, &image, 0 ) ) { return false; }
+  bool ok = create_texture_from_image( &image, tex );
+  free_texture_image( &image );
+  return ok;
 }
@@ -9,17 +9,35 @@
 | Cube Maps                                                                    |
 | You can swap the "reflect_vs.glsl" and "reflect_fs.glsl" for the refraction  |
 | versions. Comment one set out and uncomment the other                        |
+| Press B to time loading the six 2048x2048 cube map images as 2D textures,    |
+| the old way and through the texture pipeline in texture_loader.h.            |
+| The cube map is loaded from cube.ktx2 if there is one, already compressed to |
+| BC1 with all of its mipmaps: 16 MB of video memory instead of 96 MB of RGBA8 |
+| for level 0 alone. Build the compress tool with the Makefile, then run       |
+|   ./compress -format bc1 -cube -out cube.ktx2 posx.jpg negx.jpg posy.jpg     |
+|     negy.jpg posz.jpg negz.jpg                                               |
+| Otherwise the six JPEGs are decoded at once, a thread each, with mipmaps.    |
+| The monkey's reflections are glossy, from cube_prefiltered.ktx2, a chain of  |
+| levels blurred for rougher and rougher surfaces, with the diffuse light as   |
+| spherical harmonics, made by the prefilter tool - see cube_map.h. Without    |
+| it, they are from the cube map's own mipmaps. R and F change the roughness.  |
+|   ./prefilter posx.jpg negx.jpg posy.jpg negy.jpg posz.jpg negz.jpg          |
 \******************************************************************************/
+#include "cube_map.h"    // parallel loading and prefiltering of cube maps
 #include "gl_utils.h"    // common opengl functions and small utilities like logs
+#include "ktx2.h"        // block compressed textures
 #include "maths_funcs.h" // my maths functions
 #include "obj_parser.h"  // my little Wavefront .obj mesh loader
 #include "stb_image.h"   // Sean Barrett's image loader - nothings.org
+#include "texture_loader.h"
 #include <GL/glew.h>     // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h>  // GLFW helper library
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <thread>
 #define MESH_FILE "suzanne.obj"
 
 /* choose pure reflection or pure refraction here. */
@@ -36,12 +54,23 @@
 #define BOTTOM "negy.jpg"
 #define LEFT "negx.jpg"
 #define RIGHT "posx.jpg"
+#define CUBE_KTX2_FILE "cube.ktx2"
+#define PREFILTERED_KTX2_FILE "cube_prefiltered.ktx2"
 
 // keep track of window size for things like the viewport and the mouse cursor
 int g_gl_width       = 640;
 int g_gl_height      = 480;
 GLFWwindow* g_window = NULL;
 
+/* the KTX2 files are optional, so look for them before load_ktx2_texture()
+reports a missing one as an error */
+bool file_exists( const char* file_name ) {
+  FILE* fp = fopen( file_name, "rb" );
+  if ( !fp ) { return false; }
+  fclose( fp );
+  return true;
+}
+
 /* big cube. returns Vertex Array Object */
 GLuint make_big_cube() {
   float points[] = { -10.0f, 10.0f, -10.0f, -10.0f, -10.0f, -10.0f, 10.0f, -10.0f, -10.0f, 10.0f, -10.0f, -10.0f, 10.0f, 10.0f, -10.0f, -10.0f, 10.0f, -10.0f,
@@ -90,9 +119,9 @@ bool load_cube_map_side( GLuint texture, GLenum side_target, const char* file_na
   return true;
 }
 
-/* load all 6 sides of the cube-map from images, then apply formatting to the
-final texture */
-void create_cube_map( const char* front, const char* back, const char* top, const char* bottom, const char* left, const char* right, GLuint* tex_cube ) {
+/* the old create_cube_map(): load all 6 sides of the cube-map from images, one
+after the other, then apply formatting to the final texture. no mipmaps */
+void create_cube_map_old_way( const char* front, const char* back, const char* top, const char* bottom, const char* left, const char* right, GLuint* tex_cube ) {
   // generate a cube-map texture to hold all the sides
   glActiveTexture( GL_TEXTURE0 );
   glGenTextures( 1, tex_cube );
@@ -112,6 +141,123 @@ void create_cube_map( const char* front, const char* back, const char* top, cons
   glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
 }
 
+/* times loading the cube map the old way, through cube_map.h, which decodes
+the faces at once and makes mipmaps as well, and from the KTX2 files, if there
+are any */
+void benchmark_cube_map_loading() {
+  const char* faces_files[] = { RIGHT, LEFT, TOP, BOTTOM, BACK, FRONT };
+  GLuint tex;
+  double start = glfwGetTime();
+  create_cube_map_old_way( FRONT, BACK, TOP, BOTTOM, LEFT, RIGHT, &tex );
+  glFinish();
+  double old_s = glfwGetTime() - start;
+  glDeleteTextures( 1, &tex );
+  printf( "cube map, old way, one face after another, no mipmaps: %.1fms\n", old_s * 1000.0 );
+
+  int max_threads      = (int)std::thread::hardware_concurrency();
+  int thread_counts[2] = { 1, max_threads };
+  for ( int t = 0; t < ( max_threads > 1 ? 2 : 1 ); t++ ) {
+    texture_image_t faces[6];
+    start         = glfwGetTime();
+    bool ok       = load_cube_map_faces( faces_files, faces, thread_counts[t] );
+    double loaded = glfwGetTime();
+    ok            = ok && create_cube_map_from_faces( faces, &tex );
+    glFinish();
+    double total_s = glfwGetTime() - start;
+    if ( ok ) {
+      printf( "cube map, cube_map.h on %i threads, with mipmaps: %.1fms (load %.1f, upload %.1f)\n", thread_counts[t], total_s * 1000.0, ( loaded - start ) * 1000.0, ( total_s - ( loaded - start ) ) * 1000.0 );
+      glDeleteTextures( 1, &tex );
+    }
+    for ( int f = 0; f < 6; f++ ) { free_texture_image( &faces[f] ); }
+  }
+
+  const char* ktx2_files[] = { CUBE_KTX2_FILE, PREFILTERED_KTX2_FILE };
+  for ( int i = 0; i < 2; i++ ) {
+    size_t bytes = 0;
+    start        = glfwGetTime();
+    if ( !file_exists( ktx2_files[i] ) || !load_ktx2_texture( ktx2_files[i], &tex, NULL, &bytes ) ) { continue; }
+    glFinish();
+    printf( "cube map, %s, %.1f KB: %.1fms\n", ktx2_files[i], bytes / 1024.0, ( glfwGetTime() - start ) * 1000.0 );
+    glDeleteTextures( 1, &tex );
+  }
+}
+
+/* the old load_texture(): forced to RGBA, flipped a byte at a time, and
+mipmapped by the driver on this thread */
+GLuint load_texture_old_way( const char* file_name, double* decode_s, double* flip_s, double* upload_s ) {
+  double start = glfwGetTime();
+  int x, y, n;
+  unsigned char* image_data = stbi_load( file_name, &x, &y, &n, 4 );
+  if ( !image_data ) { return 0; }
+  double decoded     = glfwGetTime();
+  int width_in_bytes = x * 4;
+  for ( int row = 0; row < y / 2; row++ ) {
+    unsigned char* top    = image_data + row * width_in_bytes;
+    unsigned char* bottom = image_data + ( y - row - 1 ) * width_in_bytes;
+    for ( int col = 0; col < width_in_bytes; col++ ) {
+      unsigned char temp = top[col];
+      top[col]           = bottom[col];
+      bottom[col]        = temp;
+    }
+  }
+  double flipped = glfwGetTime();
+  GLuint tex;
+  glGenTextures( 1, &tex );
+  glBindTexture( GL_TEXTURE_2D, tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data );
+  glGenerateMipmap( GL_TEXTURE_2D );
+  glFinish();
+  stbi_image_free( image_data );
+  *decode_s += decoded - start;
+  *flip_s += flipped - decoded;
+  *upload_s += glfwGetTime() - flipped;
+  return tex;
+}
+
+/* loads the six cube map images as mipmapped 2D textures the old way, then with
+the pipeline on 1 thread and on one per core. times are until the textures are
+ready to use. MB/s are of the images' pixels, in the files' number of channels,
+whatever they are decoded to */
+void benchmark_texture_loading() {
+  const char* files[] = { FRONT, BACK, TOP, BOTTOM, LEFT, RIGHT };
+  const int n_files   = 6;
+  GLuint texs[n_files];
+  double decode_s = 0.0, flip_s = 0.0, upload_s = 0.0;
+  double start    = glfwGetTime();
+  for ( int i = 0; i < n_files; i++ ) { texs[i] = load_texture_old_way( files[i], &decode_s, &flip_s, &upload_s ); }
+  double old_s = glfwGetTime() - start;
+  glDeleteTextures( n_files, texs );
+  int width = 0, height = 0, n_channels = 0;
+  stbi_info( files[0], &width, &height, &n_channels );
+  double to_4k = 4096.0 * 4096.0 / ( (double)width * height );
+  double mb    = (double)width * height * n_channels * n_files / ( 1024.0 * 1024.0 );
+  printf( "%i %ix%i images, old way: %.1fms (decode %.1f, flip %.1f, upload and glGenerateMipmap %.1f). %.1f MB/s, %.1fms per 4K texture\n", n_files, width, height, old_s * 1000.0, decode_s * 1000.0, flip_s * 1000.0,
+    upload_s * 1000.0, mb / old_s, old_s * 1000.0 / n_files * to_4k );
+
+  int max_threads      = (int)std::thread::hardware_concurrency();
+  int thread_counts[2] = { 1, max_threads };
+  for ( int t = 0; t < ( max_threads > 1 ? 2 : 1 ); t++ ) {
+    int n_threads = thread_counts[t];
+    texture_image_t images[n_files];
+    start         = glfwGetTime();
+    int n_loaded  = load_texture_images( files, n_files, images, n_threads );
+    double loaded = glfwGetTime();
+    for ( int i = 0; i < n_files; i++ ) { create_texture_from_image( &images[i], &texs[i] ); }
+    glFinish();
+    double total_s = glfwGetTime() - start;
+    double mips_s  = 0.0;
+    decode_s       = 0.0;
+    for ( int i = 0; i < n_files; i++ ) {
+      decode_s += images[i].decode_s;
+      mips_s += images[i].mips_s;
+      free_texture_image( &images[i] );
+    }
+    glDeleteTextures( n_files, texs );
+    printf( "%i images, pipeline on %i threads: %.1fms (load %.1f, of which decode %.1f and mipmaps %.1f summed over threads, upload %.1f). %.1f MB/s, %.1fms per 4K texture\n", n_loaded, n_threads, total_s * 1000.0,
+      ( loaded - start ) * 1000.0, decode_s * 1000.0, mips_s * 1000.0, ( total_s - ( loaded - start ) ) * 1000.0, mb / total_s, total_s * 1000.0 / n_files * to_4k );
+  }
+}
+
 // camera matrices. it's easier if they are global
 mat4 view_mat;
 mat4 proj_mat;
@@ -122,12 +268,42 @@ int main() {
   restart_gl_log();
   // start GL context and O/S window using the GLFW helper library
   start_gl();
+  // filter across the edges of cube map faces, or blurry levels show seams
+  glEnable( GL_TEXTURE_CUBE_MAP_SEAMLESS );
 
   /*---------------------------------CUBE
    * MAP-----------------------------------*/
-  GLuint cube_vao = make_big_cube();
-  GLuint cube_map_texture;
-  create_cube_map( FRONT, BACK, TOP, BOTTOM, LEFT, RIGHT, &cube_map_texture );
+  GLuint cube_vao           = make_big_cube();
+  GLuint cube_map_texture   = 0;
+  size_t cube_map_bytes     = 0;
+  const char* faces_files[] = { RIGHT, LEFT, TOP, BOTTOM, BACK, FRONT }; // +X -X +Y -Y +Z -Z
+  texture_image_t faces[6];
+  bool have_faces   = false;
+  double load_start = glfwGetTime();
+  if ( file_exists( CUBE_KTX2_FILE ) && load_ktx2_texture( CUBE_KTX2_FILE, &cube_map_texture, NULL, &cube_map_bytes ) ) {
+    printf( "cube map: %.1f KB of BC1 in video memory\n", cube_map_bytes / 1024.0 );
+  } else {
+    printf( "no usable %s, so loading the cube map from JPEGs\n", CUBE_KTX2_FILE );
+    have_faces = load_cube_map_faces( faces_files, faces, 0 );
+    if ( have_faces ) { create_cube_map_from_faces( faces, &cube_map_texture ); }
+  }
+  printf( "cube map loaded in %.1fms\n", ( glfwGetTime() - load_start ) * 1000.0 );
+
+  /* the glossy reflections, and the diffuse light, as 9 RGB coefficients */
+  GLuint reflect_texture = cube_map_texture;
+  float irradiance_sh[CUBE_MAP_SH_COEFFS * 3];
+  if ( read_ktx2_value( PREFILTERED_KTX2_FILE, CUBE_MAP_SH_KEY, irradiance_sh, sizeof( irradiance_sh ) ) && load_ktx2_texture( PREFILTERED_KTX2_FILE, &reflect_texture, NULL, NULL ) ) {
+    printf( "reflections from %s\n", PREFILTERED_KTX2_FILE );
+  } else {
+    printf( "no %s, so reflections are from the cube map's mipmaps. make it with the prefilter tool\n", PREFILTERED_KTX2_FILE );
+    if ( !have_faces ) { have_faces = load_cube_map_faces( faces_files, faces, 0 ); }
+    memset( irradiance_sh, 0, sizeof( irradiance_sh ) );
+    if ( have_faces ) { cube_map_irradiance_sh( faces, irradiance_sh ); }
+  }
+  for ( int f = 0; have_faces && f < 6; f++ ) { free_texture_image( &faces[f] ); }
+  GLint reflect_max_level = 0;
+  glBindTexture( GL_TEXTURE_CUBE_MAP, reflect_texture );
+  glGetTexParameteriv( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, &reflect_max_level );
   /*------------------------------create geometry-------------------------------*/
   GLfloat* vp       = NULL; // array of vertex points
   GLfloat* vn       = NULL; // array of vertex normals
@@ -157,10 +333,14 @@ int main() {
 
   /*-------------------------------CREATE SHADERS-------------------------------*/
   // shaders for "Suzanne" mesh
-  GLuint monkey_sp      = create_programme_from_files( MONKEY_VERT_FILE, MONKEY_FRAG_FILE );
-  int monkey_M_location = glGetUniformLocation( monkey_sp, "M" );
-  int monkey_V_location = glGetUniformLocation( monkey_sp, "V" );
-  int monkey_P_location = glGetUniformLocation( monkey_sp, "P" );
+  GLuint monkey_sp              = create_programme_from_files( MONKEY_VERT_FILE, MONKEY_FRAG_FILE );
+  int monkey_M_location         = glGetUniformLocation( monkey_sp, "M" );
+  int monkey_V_location         = glGetUniformLocation( monkey_sp, "V" );
+  int monkey_P_location         = glGetUniformLocation( monkey_sp, "P" );
+  int monkey_roughness_location = glGetUniformLocation( monkey_sp, "roughness" );
+  int monkey_max_lod_location   = glGetUniformLocation( monkey_sp, "max_lod" );
+  int monkey_sh_location        = glGetUniformLocation( monkey_sp, "irradiance_sh" );
+  float roughness               = 0.2f;
 
   // cube-map shaders
   GLuint cube_sp = create_programme_from_files( CUBE_VERT_FILE, CUBE_FRAG_FILE );
@@ -193,6 +373,9 @@ int main() {
   glUseProgram( monkey_sp );
   glUniformMatrix4fv( monkey_V_location, 1, GL_FALSE, view_mat.m );
   glUniformMatrix4fv( monkey_P_location, 1, GL_FALSE, proj_mat.m );
+  glUniform1f( monkey_roughness_location, roughness );
+  glUniform1f( monkey_max_lod_location, (float)reflect_max_level );
+  glUniform3fv( monkey_sh_location, CUBE_MAP_SH_COEFFS, irradiance_sh );
   glUseProgram( cube_sp );
   glUniformMatrix4fv( cube_V_location, 1, GL_FALSE, R.m );
   glUniformMatrix4fv( cube_P_location, 1, GL_FALSE, proj_mat.m );
@@ -235,6 +418,7 @@ int main() {
     glDepthMask( GL_TRUE );
 
     glUseProgram( monkey_sp );
+    glBindTexture( GL_TEXTURE_CUBE_MAP, reflect_texture );
     glBindVertexArray( vao );
     glUniformMatrix4fv( monkey_M_location, 1, GL_FALSE, model_mat.m );
     glUniformMatrix4fv( monkey_P_location, 1, GL_FALSE, proj_mat.m );
@@ -308,6 +492,25 @@ int main() {
       versor q_roll = quat_from_axis_deg( cam_roll, fwd.v[0], fwd.v[1], fwd.v[2] );
       q             = q_roll * q;
     }
+    static bool b_was_down = false;
+    bool b_is_down         = glfwGetKey( g_window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) {
+      benchmark_texture_loading();
+      benchmark_cube_map_loading();
+    }
+    b_was_down             = b_is_down;
+    static bool r_was_down = false, f_was_down = false;
+    bool r_is_down         = glfwGetKey( g_window, GLFW_KEY_R );
+    bool f_is_down         = glfwGetKey( g_window, GLFW_KEY_F );
+    if ( ( r_is_down && !r_was_down ) || ( f_is_down && !f_was_down ) ) {
+      roughness += r_is_down ? 0.1f : -0.1f;
+      roughness = roughness < 0.0f ? 0.0f : ( roughness > 1.0f ? 1.0f : roughness );
+      printf( "roughness %.1f\n", roughness );
+      glUseProgram( monkey_sp );
+      glUniform1f( monkey_roughness_location, roughness );
+    }
+    r_was_down = r_is_down;
+    f_was_down = f_is_down;
     // update view matrix
     if ( cam_moved ) {
       cam_heading += cam_yaw;
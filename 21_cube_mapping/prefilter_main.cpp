@@ -0,0 +1,132 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Cube Map Prefilter                                                           |
+| Loads six cube map faces, works out a chain of levels for rougher and        |
+| rougher reflections, and the spherical harmonics of their diffuse light,     |
+| with cube_map.h, and writes them all to one block compressed KTX2 file.      |
+| The roughness of level l is l / (levels - 1). Options:                       |
+|   -size 256          of level 0. the reflections of a glossy surface don't   |
+|                      need the full size of the sky                           |
+|   -levels 6          roughness 0, 0.2, 0.4 ... 1                             |
+|   -samples 64        per texel                                               |
+|   -format bc7        bc1 or bc7                                              |
+|   -threads n         defaults to the number of cores                         |
+|   -out cube_prefiltered.ktx2                                                 |
+| e.g. ./prefilter posx.jpg negx.jpg posy.jpg negy.jpg posz.jpg negz.jpg       |
+\******************************************************************************/
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "block_compression.h"
+#include "cube_map.h"
+#include "ktx2.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+static double get_seconds() { return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count(); }
+
+int main( int argc, char** argv ) {
+  const char* output_name = "cube_prefiltered.ktx2";
+  const char* file_names[6];
+  bc_format_t format = BC_FORMAT_BC7;
+  int n_threads      = (int)std::thread::hardware_concurrency();
+  int n_files        = 0;
+  int size           = 256;
+  int n_levels       = 6;
+  int n_samples      = 64;
+  for ( int i = 1; i < argc; i++ ) {
+    bool has_value = i + 1 < argc;
+    if ( 0 == strcmp( argv[i], "-size" ) && has_value ) {
+      size = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-levels" ) && has_value ) {
+      n_levels = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-samples" ) && has_value ) {
+      n_samples = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-format" ) && has_value ) {
+      i++;
+      if ( 0 == strcmp( argv[i], "bc1" ) ) {
+        format = BC_FORMAT_BC1;
+      } else if ( 0 == strcmp( argv[i], "bc7" ) ) {
+        format = BC_FORMAT_BC7;
+      } else {
+        fprintf( stderr, "unknown format %s. use bc1 or bc7\n", argv[i] );
+        return 1;
+      }
+    } else if ( 0 == strcmp( argv[i], "-threads" ) && has_value ) {
+      n_threads = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-out" ) && has_value ) {
+      output_name = argv[++i];
+    } else if ( '-' != argv[i][0] && n_files < 6 ) {
+      file_names[n_files++] = argv[i];
+    } else {
+      fprintf( stderr, "unknown option %s\n", argv[i] );
+      return 1;
+    }
+  }
+  if ( n_threads < 1 ) { n_threads = 1; }
+  if ( 6 != n_files || size < 1 || ( size & ( size - 1 ) ) || n_levels < 1 || n_samples < 1 ) {
+    fprintf( stderr, "usage: %s [-size 256] [-levels 6] [-samples 64] [-format bc1|bc7] [-threads n] [-out file.ktx2] +x -x +y -y +z -z\n", argv[0] );
+    fprintf( stderr, "       -size is a power of 2\n" );
+    return 1;
+  }
+  /* no smaller than 1x1 */
+  int max_levels = 1;
+  while ( size >> max_levels > 0 ) { max_levels++; }
+  n_levels = n_levels < max_levels ? n_levels : max_levels;
+
+  double start = get_seconds();
+  texture_image_t faces[6];
+  if ( !load_cube_map_faces( file_names, faces, n_threads ) ) { return 1; }
+  double loaded = get_seconds();
+  unsigned char* levels[TEXTURE_MAX_LEVELS];
+  if ( !prefilter_cube_map( faces, size, n_levels, n_samples, n_threads, levels ) ) { return 1; }
+  double prefiltered = get_seconds();
+  float sh[CUBE_MAP_SH_COEFFS * 3];
+  cube_map_irradiance_sh( faces, sh );
+  double harmonics = get_seconds();
+
+  /* small enough to encode on this thread */
+  unsigned char* blocks[TEXTURE_MAX_LEVELS];
+  size_t compressed_bytes = 0, rgba8_bytes = 0;
+  for ( int l = 0; l < n_levels; l++ ) {
+    int dim           = size >> l;
+    size_t face_bytes = bc_image_bytes( format, dim, dim );
+    blocks[l]         = (unsigned char*)malloc( 6 * face_bytes );
+    if ( !blocks[l] ) {
+      fprintf( stderr, "ERROR: out of memory\n" );
+      return 1;
+    }
+    for ( int f = 0; f < 6; f++ ) { bc_encode_rows( format, levels[l] + (size_t)f * dim * dim * 4, 4, dim, dim, 0, ( dim + 3 ) / 4, blocks[l] + f * face_bytes ); }
+    compressed_bytes += 6 * face_bytes;
+    rgba8_bytes += (size_t)6 * dim * dim * 4;
+  }
+  double encoded = get_seconds();
+
+  printf( "%s and 5 more faces: %ix%i, to %i levels of %ix%i down to %ix%i, %i samples a texel, on %i threads\n", file_names[0], faces[0].width, faces[0].height, n_levels, size, size, size >> ( n_levels - 1 ),
+    size >> ( n_levels - 1 ), n_samples, n_threads );
+  printf( "  loaded and mipmapped in %.3fs. prefiltered in %.3fs, spherical harmonics in %.2fms, %s in %.3fs\n", loaded - start, prefiltered - loaded, ( harmonics - prefiltered ) * 1000.0, bc_format_name( format ),
+    encoded - harmonics );
+  printf( "  %.1f KB of video memory, against %.1f KB as RGBA8\n", compressed_bytes / 1024.0, rgba8_bytes / 1024.0 );
+  /* the harmonics that aren't 0 straight up */
+  float up[3];
+  for ( int c = 0; c < 3; c++ ) { up[c] = 0.282095f * sh[c] + 0.488603f * sh[3 + c] - 0.315392f * sh[18 + c] - 0.546274f * sh[24 + c]; }
+  printf( "  irradiance / pi, facing up: %.3f %.3f %.3f\n", up[0], up[1], up[2] );
+
+  ktx2_key_value_t key_value = { CUBE_MAP_SH_KEY, sh, (uint32_t)sizeof( sh ) };
+  bool ok                    = write_ktx2( output_name, format, size, size, 6, n_levels, blocks, &key_value, 1 );
+  if ( ok ) { printf( "wrote `%s`\n", output_name ); }
+  for ( int l = 0; l < n_levels; l++ ) {
+    free( levels[l] );
+    free( blocks[l] );
+  }
+  for ( int f = 0; f < 6; f++ ) { free_texture_image( &faces[f] ); }
+  return ok ? 0 : 1;
+}
@@ -4,8 +4,22 @@ in vec3 pos_eye;
 in vec3 n_eye;
 uniform samplerCube cube_texture;
 uniform mat4 V; // view matrix
+/* rougher surfaces read smaller, blurrier levels of the prefiltered cube map.
+max_lod is its last level, for roughness 1 */
+uniform float roughness;
+uniform float max_lod;
+/* the diffuse light, divided by pi, as spherical harmonics - see cube_map.h */
+uniform vec3 irradiance_sh[9];
 out vec4 frag_colour;
 
+vec3 sh_irradiance (vec3 n) {
+	return irradiance_sh[0] * 0.282095 +
+		irradiance_sh[1] * 0.488603 * n.y + irradiance_sh[2] * 0.488603 * n.z + irradiance_sh[3] * 0.488603 * n.x +
+		irradiance_sh[4] * 1.092548 * n.x * n.y + irradiance_sh[5] * 1.092548 * n.y * n.z +
+		irradiance_sh[6] * 0.315392 * (3.0 * n.z * n.z - 1.0) + irradiance_sh[7] * 1.092548 * n.x * n.z +
+		irradiance_sh[8] * 0.546274 * (n.x * n.x - n.y * n.y);
+}
+
 void main () {
 	/* reflect ray around normal from eye to surface */
 	vec3 incident_eye = normalize (pos_eye);
@@ -14,6 +28,13 @@ void main () {
 	vec3 reflected = reflect (incident_eye, normal);
 	// convert from eye to world space
 	reflected = vec3 (inverse (V) * vec4 (reflected, 0.0));
+	vec3 normal_wor = vec3 (inverse (V) * vec4 (normal, 0.0));
 
-	frag_colour = texture (cube_texture, reflected);
+	/* the cube map is in sRGB, but light adds up in linear colour */
+	vec3 specular = pow (textureLod (cube_texture, reflected, roughness * max_lod).rgb, vec3 (2.2));
+	vec3 diffuse = vec3 (0.5) * max (sh_irradiance (normal_wor), vec3 (0.0));
+	/* Schlick's Fresnel, more reflective at glancing angles. half metal, so
+	that both show */
+	float fresnel = 0.5 + 0.5 * pow (1.0 - max (dot (-incident_eye, normal), 0.0), 5.0);
+	frag_colour = vec4 (pow (mix (diffuse, specular, fresnel), vec3 (1.0 / 2.2)), 1.0);
 }
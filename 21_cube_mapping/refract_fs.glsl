@@ -4,6 +4,10 @@ in vec3 pos_eye;
 in vec3 n_eye;
 uniform samplerCube cube_texture;
 uniform mat4 V; // view matrix
+/* frosted glass. rougher surfaces read smaller, blurrier levels of the
+prefiltered cube map. max_lod is its last level, for roughness 1 */
+uniform float roughness;
+uniform float max_lod;
 out vec4 frag_colour;
 
 void main () {
@@ -15,5 +19,5 @@ void main () {
 	vec3 refracted = refract (incident_eye, normal, ratio);
 	refracted = vec3 (inverse (V) * vec4 (refracted, 0.0));
 
-	frag_colour = texture (cube_texture, refracted);
+	frag_colour = textureLod (cube_texture, refracted, roughness * max_lod);
 }
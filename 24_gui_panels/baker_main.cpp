@@ -0,0 +1,157 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Virtual Texture Baker                                                        |
+| Lays a set of images out in a grid, each repeated to fill its cell, to make  |
+| one texture far bigger than video memory, and writes its pages, at every     |
+| mipmap level, into a page file for virtual_texture.h. The images take turns, |
+| cell by cell, and have to all be the same size, square, and a power of 2.    |
+| Options:                                                                     |
+|   -grid 8            cells a side                                            |
+|   -repeat 4          times an image repeats across its cell, each way        |
+|   -threads n         threads making pages. defaults to the number of cores   |
+|   -out ground.vtp    the page file                                           |
+| The texture is 256 x 4 x 8 = 8192 pixels a side with the images here, which  |
+| is 341 MB as an RGBA8 texture with mipmaps:                                  |
+|   ./bake -grid 8 -repeat 4 tile2-diamonds256x256.png skulluvmap.png          |
+| and -grid 16 makes 16384, or 1.3 GB.                                         |
+\******************************************************************************/
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "texture_loader.h"
+#include "virtual_texture.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_IMAGES 64
+
+struct bake_t {
+  texture_image_t images[MAX_IMAGES];
+  int n_images;
+  int grid, cell, cell_levels; // cell is in pixels, 2 to the power of cell_levels
+  /* once the cells are smaller than a pixel, each pixel is the average of
+  several cells. level l of the texture is means[l - cell_levels] */
+  unsigned char* means[VT_MAX_LEVELS];
+};
+
+static double get_seconds() { return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count(); }
+
+static int log2_int( int n ) {
+  int l = 0;
+  while ( n >> ( l + 1 ) > 0 ) { l++; }
+  return l;
+}
+
+static void to_rgba( const unsigned char* src, int n_channels, unsigned char* rgba ) {
+  rgba[0] = src[0];
+  rgba[1] = src[n_channels < 3 ? 0 : 1];
+  rgba[2] = src[n_channels < 3 ? 0 : 2];
+  rgba[3] = 2 == n_channels ? src[1] : ( 4 == n_channels ? src[3] : 255 );
+}
+
+/* the images have their mipmaps already, so level l of a cell is level l of
+its image, repeated */
+static void bake_texel( int level, int x, int y, unsigned char* rgba, void* user_data ) {
+  const bake_t* bake = (const bake_t*)user_data;
+  if ( level > bake->cell_levels ) {
+    int n = bake->grid >> ( level - bake->cell_levels );
+    memcpy( rgba, bake->means[level - bake->cell_levels] + ( y * n + x ) * 4, 4 );
+    return;
+  }
+  int cell                     = bake->cell >> level;
+  const texture_image_t* image = &bake->images[( ( y / cell ) * bake->grid + x / cell ) % bake->n_images];
+  int image_level              = level < image->n_levels ? level : image->n_levels - 1;
+  int dim                      = texture_level_dim( image->width, image_level );
+  to_rgba( image->levels[image_level] + ( ( y % cell % dim ) * dim + x % cell % dim ) * image->n_channels, image->n_channels, rgba );
+}
+
+int main( int argc, char** argv ) {
+  const char* output_name = "ground.vtp";
+  const char* file_names[MAX_IMAGES];
+  int n_files   = 0;
+  int grid      = 8;
+  int repeat    = 4;
+  int n_threads = 0;
+  for ( int i = 1; i < argc; i++ ) {
+    if ( 0 == strcmp( argv[i], "-grid" ) && i + 1 < argc ) {
+      grid = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-repeat" ) && i + 1 < argc ) {
+      repeat = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-threads" ) && i + 1 < argc ) {
+      n_threads = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-out" ) && i + 1 < argc ) {
+      output_name = argv[++i];
+    } else if ( n_files < MAX_IMAGES ) {
+      file_names[n_files++] = argv[i];
+    }
+  }
+  if ( 0 == n_files ) {
+    printf( "usage: ./bake [-grid 8] [-repeat 4] [-threads n] [-out ground.vtp] image.png [image2.png ...]\n" );
+    return 0;
+  }
+  if ( grid < 1 || repeat < 1 || ( grid & ( grid - 1 ) ) || ( repeat & ( repeat - 1 ) ) ) {
+    fprintf( stderr, "ERROR: -grid and -repeat have to be powers of 2\n" );
+    return 1;
+  }
+
+  double start = get_seconds();
+  bake_t bake;
+  memset( &bake, 0, sizeof( bake_t ) );
+  bake.n_images = n_files;
+  if ( load_texture_images( file_names, n_files, bake.images, n_threads ) != n_files ) { return 1; }
+  int dim = bake.images[0].width;
+  for ( int i = 0; i < n_files; i++ ) {
+    if ( bake.images[i].width != dim || bake.images[i].height != dim || ( dim & ( dim - 1 ) ) ) {
+      fprintf( stderr, "ERROR: %s is %ix%i. the images have to be square, the same size, and a power of 2\n", file_names[i], bake.images[i].width, bake.images[i].height );
+      return 1;
+    }
+  }
+  bake.grid        = grid;
+  bake.cell        = dim * repeat;
+  bake.cell_levels = log2_int( bake.cell );
+  int size         = bake.grid * bake.cell;
+
+  /* each cell's average is its image's last, 1x1, level */
+  for ( int m = 0; grid >> m > 0 && m < VT_MAX_LEVELS; m++ ) {
+    int n         = grid >> m;
+    bake.means[m] = (unsigned char*)malloc( (size_t)n * n * 4 );
+    for ( int y = 0; y < n; y++ ) {
+      for ( int x = 0; x < n; x++ ) {
+        unsigned char* mean = bake.means[m] + ( y * n + x ) * 4;
+        if ( 0 == m ) {
+          const texture_image_t* image = &bake.images[( y * grid + x ) % n_files];
+          to_rgba( image->levels[image->n_levels - 1], image->n_channels, mean );
+          continue;
+        }
+        const unsigned char* above = bake.means[m - 1];
+        for ( int c = 0; c < 4; c++ ) {
+          int sum = above[( 2 * y * 2 * n + 2 * x ) * 4 + c] + above[( 2 * y * 2 * n + 2 * x + 1 ) * 4 + c] + above[( ( 2 * y + 1 ) * 2 * n + 2 * x ) * 4 + c] + above[( ( 2 * y + 1 ) * 2 * n + 2 * x + 1 ) * 4 + c];
+          mean[c] = (unsigned char)( ( sum + 2 ) >> 2 );
+        }
+      }
+    }
+  }
+  double loaded = get_seconds();
+
+  printf( "baking %s: %i images, %ix%i pixels, %i repeats a cell, %ix%i cells\n", output_name, n_files, dim, dim, repeat, grid, grid );
+  bool ok = write_vt_page_file( output_name, size, bake_texel, &bake, n_threads );
+  if ( ok ) {
+    /* level 0 and its mipmaps take about a third more */
+    double texture_mb = (double)size * size * 4.0 * 4.0 / 3.0 / ( 1024.0 * 1024.0 );
+    int n_pages       = 0;
+    for ( int pages = size / VT_PAGE_SIZE; pages > 0; pages /= 2 ) { n_pages += pages * pages; }
+    printf( "%ix%i pixels in %i pages of %ix%i, %.1f MB on disk. as one RGBA8 texture with mipmaps it would be %.1f MB\n", size, size, n_pages, VT_PAGE_SIZE, VT_PAGE_SIZE,
+      ( sizeof( vt_file_header_t ) + (double)n_pages * VT_PAGE_BYTES ) / ( 1024.0 * 1024.0 ), texture_mb );
+    printf( "loaded images in %.2f s, wrote pages in %.2f s\n", loaded - start, get_seconds() - loaded );
+  }
+  for ( int i = 0; i < n_files; i++ ) { free_texture_image( &bake.images[i] ); }
+  for ( int m = 0; m < VT_MAX_LEVELS; m++ ) { free( bake.means[m] ); }
+  return ok ? 0 : 1;
+}
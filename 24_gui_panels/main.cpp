@@ -10,18 +10,35 @@
 | Working in clip space in 2d, you can very quickly build lots of widgety      |
 | graphics elements. It's also very easy to work out if the mouse is hovering  |
 | over one of your 2d panels                                                   |
+|                                                                              |
+| The ground plane's texture is virtual: 8192x8192 pixels, streamed from a     |
+| page file a 128x128 page at a time, as the camera needs them. See            |
+| virtual_texture.h. Build the bake tool with the Makefile and make the file:  |
+|   ./bake -grid 8 -repeat 4 tile2-diamonds256x256.png skulluvmap.png          |
+| Without it the ground is the one tile. P shows the page cache in the panel.  |
 \******************************************************************************/
 #include "maths_funcs.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"  // Sean Barrett's image loader
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h> // GLFW helper library
+#include "texture_loader.h"
+#include "virtual_texture.h"
 #include <assert.h>
 #include <stdio.h>
 
+#define VT_FILE "ground.vtp"
+/* 16x16 pages of 136x136, with borders, is 18 MB */
+#define VT_CACHE_SLOTS 16
+#define VT_STREAM_THREADS 4
+#define VT_UPLOADS_PER_FRAME 16
+
 int g_viewport_width  = 640;
 int g_viewport_height = 480;
 
+virtual_texture_t g_vt;
+bool g_vt_loaded = false;
+
 // virtual camera view matrix
 mat4 V = identity_mat4();
 // virtual camera projection matrix
@@ -30,40 +47,73 @@ mat4 P = identity_mat4();
 GLuint gp_sp;        // ground plane shader programme
 GLint gp_V_loc;      // view matrix location in gp_sp
 GLint gp_P_loc;      // projection matrix location in gp_sp
+GLuint fb_sp;        // ground plane's virtual texture feedback programme
+GLint fb_V_loc;      // view matrix location in fb_sp
+GLint fb_P_loc;      // projection matrix location in fb_sp
+GLint fb_jitter_loc; // sub-pixel offset location in fb_sp
 GLuint gui_sp;       // 2d GUI panel shader programme
 GLint gui_scale_loc; // scale factors for gui shader
 
-void create_ground_plane_shaders() {
+/* the fragment shader is in several strings, so that the virtual texture's
+GLSL can go between the #version line and the rest */
+GLuint create_programme( const char* vs_str, int n_fs_strs, const char* const* fs_strs ) {
+  GLuint vs = glCreateShader( GL_VERTEX_SHADER );
+  glShaderSource( vs, 1, &vs_str, NULL );
+  glCompileShader( vs );
+  GLuint fs = glCreateShader( GL_FRAGMENT_SHADER );
+  glShaderSource( fs, n_fs_strs, fs_strs, NULL );
+  glCompileShader( fs );
+  GLint compiled = GL_FALSE;
+  glGetShaderiv( fs, GL_COMPILE_STATUS, &compiled );
+  if ( GL_TRUE != compiled ) {
+    char log[2048];
+    glGetShaderInfoLog( fs, sizeof( log ), NULL, log );
+    fprintf( stderr, "ERROR: fragment shader did not compile:\n%s\n", log );
+  }
+  GLuint sp = glCreateProgram();
+  glAttachShader( sp, vs );
+  glAttachShader( sp, fs );
+  glLinkProgram( sp );
+  return sp;
+}
+
+void create_ground_plane_shaders( bool virtual_texture ) {
   /* here i used negative y from the buffer as the z value so that it was on
   the floor but also that the 'front' was on the top side. also note how i
-  work out the texture coordinates, st, from the vertex point position */
+  work out the texture coordinates, st, from the vertex point position. jitter
+  only moves the feedback pass */
   const char* gp_vs_str =
     "#version 410\n"
     "in vec2 vp;"
     "uniform mat4 V, P;"
+    "uniform vec2 jitter;"
     "out vec2 st;"
     "void main () {"
     "  st = (vp + 1.0) * 0.5;"
     "  gl_Position = P * V * vec4 (10.0 * vp.x, -1.0, 10.0 * -vp.y, 1.0);"
+    "  gl_Position.xy += jitter * gl_Position.w;"
     "}";
   const char* gp_fs_str =
-    "#version 410\n"
     "in vec2 st;"
     "uniform sampler2D tex;"
     "out vec4 frag_colour;"
     "void main () {"
     "  frag_colour = texture (tex, st);"
     "}";
-  GLuint gp_vs = glCreateShader( GL_VERTEX_SHADER );
-  glShaderSource( gp_vs, 1, &gp_vs_str, NULL );
-  glCompileShader( gp_vs );
-  GLuint gp_fs = glCreateShader( GL_FRAGMENT_SHADER );
-  glShaderSource( gp_fs, 1, &gp_fs_str, NULL );
-  glCompileShader( gp_fs );
-  gp_sp = glCreateProgram();
-  glAttachShader( gp_sp, gp_vs );
-  glAttachShader( gp_sp, gp_fs );
-  glLinkProgram( gp_sp );
+  const char* vt_fs_str =
+    "in vec2 st;"
+    "out vec4 frag_colour;"
+    "void main () {"
+    "  frag_colour = vt_texture (st);"
+    "}";
+  const char* fb_fs_str =
+    "in vec2 st;"
+    "out uvec4 page;"
+    "void main () {"
+    "  page = vt_feedback (st);"
+    "}";
+  const char* gp_fs_strs[] = { "#version 410\n", virtual_texture ? vt_glsl : "", virtual_texture ? vt_fs_str : gp_fs_str };
+  gp_sp                    = create_programme( gp_vs_str, 3, gp_fs_strs );
   // get uniform locations of camera view and projection matrices
   gp_V_loc = glGetUniformLocation( gp_sp, "V" );
   assert( gp_V_loc > -1 );
@@ -73,6 +123,17 @@ void create_ground_plane_shaders() {
   glUseProgram( gp_sp );
   glUniformMatrix4fv( gp_V_loc, 1, GL_FALSE, V.m );
   glUniformMatrix4fv( gp_P_loc, 1, GL_FALSE, P.m );
+  if ( !virtual_texture ) { return; }
+
+  const char* fb_fs_strs[] = { "#version 410\n", vt_glsl, fb_fs_str };
+  fb_sp                    = create_programme( gp_vs_str, 3, fb_fs_strs );
+  fb_V_loc                 = glGetUniformLocation( fb_sp, "V" );
+  fb_P_loc                 = glGetUniformLocation( fb_sp, "P" );
+  fb_jitter_loc            = glGetUniformLocation( fb_sp, "jitter" );
+  assert( fb_jitter_loc > -1 );
+  glUseProgram( fb_sp );
+  glUniformMatrix4fv( fb_V_loc, 1, GL_FALSE, V.m );
+  glUniformMatrix4fv( fb_P_loc, 1, GL_FALSE, P.m );
 }
 
 void create_gui_shaders() {
@@ -108,49 +169,6 @@ void create_gui_shaders() {
   assert( gui_scale_loc > -1 );
 }
 
-bool load_texture( const char* file_name, GLuint* tex ) {
-  int x, y, n;
-  int force_channels        = 4;
-  unsigned char* image_data = stbi_load( file_name, &x, &y, &n, force_channels );
-  if ( !image_data ) {
-    fprintf( stderr, "ERROR: could not load %s\n", file_name );
-    return false;
-  }
-  // NPOT check
-  if ( ( x & ( x - 1 ) ) != 0 || ( y & ( y - 1 ) ) != 0 ) { fprintf( stderr, "WARNING: texture %s is not power-of-2 dimensions\n", file_name ); }
-  int width_in_bytes    = x * 4;
-  unsigned char* top    = NULL;
-  unsigned char* bottom = NULL;
-  unsigned char temp    = 0;
-  int half_height       = y / 2;
-
-  for ( int row = 0; row < half_height; row++ ) {
-    top    = image_data + row * width_in_bytes;
-    bottom = image_data + ( y - row - 1 ) * width_in_bytes;
-    for ( int col = 0; col < width_in_bytes; col++ ) {
-      temp    = *top;
-      *top    = *bottom;
-      *bottom = temp;
-      top++;
-      bottom++;
-    }
-  }
-  glGenTextures( 1, tex );
-  glActiveTexture( GL_TEXTURE0 );
-  glBindTexture( GL_TEXTURE_2D, *tex );
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data );
-  glGenerateMipmap( GL_TEXTURE_2D );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-  GLfloat max_aniso = 0.0f;
-  glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso );
-  // set the maximum!
-  glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso );
-  return true;
-}
-
 /* we will tell GLFW to run this function whenever the window is resized */
 void glfw_framebuffer_size_callback( GLFWwindow* window, int width, int height ) {
   g_viewport_width  = width;
@@ -158,6 +176,7 @@ void glfw_framebuffer_size_callback( GLFWwindow* window, int width, int height )
   /* update any perspective matrices used here */
   P = perspective( 67.0f, (float)g_viewport_width / (float)g_viewport_height, 0.1f, 100.0f );
   glViewport( 0, 0, g_viewport_width, g_viewport_height );
+  if ( g_vt_loaded ) { vt_resize_feedback( &g_vt, g_viewport_width, g_viewport_height ); }
 }
 
 int main() {
@@ -209,13 +228,28 @@ int main() {
   const float cam_speed         = 3.0f;  // 1 unit per second
   const float cam_heading_speed = 50.0f; // 30 degrees per second
 
-  create_ground_plane_shaders();
+  /* the ground plane's texture is streamed from the page file, if it has been
+  made */
+  g_vt_loaded = init_virtual_texture( &g_vt, VT_FILE, VT_CACHE_SLOTS, VT_STREAM_THREADS, g_viewport_width, g_viewport_height );
+  if ( g_vt_loaded ) {
+    printf( "virtual texture %ix%i, %i pages, cache of %i pages\n", g_vt.header.size, g_vt.header.size, g_vt.header.n_pages, VT_CACHE_SLOTS * VT_CACHE_SLOTS );
+  } else {
+    printf( "no virtual texture. make %s with ./bake -grid 8 -repeat 4 tile2-diamonds256x256.png skulluvmap.png\n", VT_FILE );
+  }
+  create_ground_plane_shaders( g_vt_loaded );
   create_gui_shaders();
 
   // textures for ground plane and gui
-  GLuint gp_tex, gui_tex;
-  ( load_texture( "tile2-diamonds256x256.png", &gp_tex ) );
-  ( load_texture( "skulluvmap.png", &gui_tex ) );
+  /* both images are decoded and mipmapped at once, on worker threads, and only
+  uploaded on this one */
+  const char* image_files[] = { "tile2-diamonds256x256.png", "skulluvmap.png" };
+  texture_image_t images[2];
+  load_texture_images( image_files, 2, images, 0 );
+  GLuint gp_tex = 0, gui_tex = 0;
+  ( create_texture_from_image( &images[0], &gp_tex ) );
+  ( create_texture_from_image( &images[1], &gui_tex ) );
+  free_texture_image( &images[0] );
+  free_texture_image( &images[1] );
 
   // rendering defaults
   glDepthFunc( GL_LESS );   // set depth function but don't enable yet
@@ -229,6 +263,9 @@ int main() {
 
   glViewport( 0, 0, g_viewport_width, g_viewport_height );
 
+  bool show_cache            = false;
+  double stats_start_seconds = glfwGetTime();
+
   // start main rendering loop
   while ( !glfwWindowShouldClose( window ) ) {
     // update timers
@@ -240,21 +277,51 @@ int main() {
     bool cam_moved = false;
     vec3 move( 0.0, 0.0, 0.0 );
 
+    if ( g_vt_loaded ) {
+      /* takes in feedback from a frame or two ago, and pages that have
+      arrived, then draws this frame's feedback */
+      vt_update( &g_vt, VT_UPLOADS_PER_FRAME );
+      float jitter[2];
+      vt_feedback_jitter( &g_vt, jitter );
+      vt_begin_feedback( &g_vt );
+      glEnable( GL_DEPTH_TEST );
+      glUseProgram( fb_sp );
+      vt_bind( &g_vt, fb_sp, 0, 1, true );
+      glUniform2fv( fb_jitter_loc, 1, jitter );
+      glBindVertexArray( vao );
+      glDrawArrays( GL_TRIANGLES, 0, 6 );
+      vt_end_feedback( &g_vt );
+      glViewport( 0, 0, g_viewport_width, g_viewport_height );
+
+      if ( current_seconds - stats_start_seconds > 1.0 ) {
+        vt_stats_t stats = vt_take_stats( &g_vt );
+        double seconds   = current_seconds - stats_start_seconds;
+        printf( "pages resident %i/%i (%.1f MB of %.1f MB), hit rate %.1f%%, streamed %.2f MB/s (%.0f pages/s)\n", stats.n_resident, stats.n_slots, stats.n_resident * VT_PAGE_BYTES / ( 1024.0 * 1024.0 ),
+          g_vt.header.n_pages * (double)VT_PAGE_BYTES / ( 1024.0 * 1024.0 ), stats.n_requested > 0 ? 100.0 * stats.n_hits / stats.n_requested : 100.0,
+          stats.bytes_streamed / ( 1024.0 * 1024.0 ) / seconds, stats.n_streamed / seconds );
+        stats_start_seconds = current_seconds;
+      }
+    }
+
     // wipe the drawing surface clear
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
     // draw ground plane. note: depth test is enabled here
     glEnable( GL_DEPTH_TEST );
-    glActiveTexture( GL_TEXTURE0 );
-    glBindTexture( GL_TEXTURE_2D, gp_tex );
     glUseProgram( gp_sp );
+    if ( g_vt_loaded ) {
+      vt_bind( &g_vt, gp_sp, 0, 1, false );
+    } else {
+      glActiveTexture( GL_TEXTURE0 );
+      glBindTexture( GL_TEXTURE_2D, gp_tex );
+    }
     glBindVertexArray( vao );
     glDrawArrays( GL_TRIANGLES, 0, 6 );
 
     // draw GUI panel. note: depth test is disabled here and drawn AFTER scene
     glDisable( GL_DEPTH_TEST );
     glActiveTexture( GL_TEXTURE0 );
-    glBindTexture( GL_TEXTURE_2D, gui_tex );
+    glBindTexture( GL_TEXTURE_2D, show_cache && g_vt_loaded ? g_vt.cache_tex : gui_tex );
     glUseProgram( gui_sp );
     // resize panel to size in pixels
     float x_scale = panel_width / g_viewport_width;
@@ -266,6 +333,11 @@ int main() {
     // update other events like input handling
     glfwPollEvents();
     if ( GLFW_PRESS == glfwGetKey( window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( window, 1 ); }
+    static bool p_was_down = false;
+    bool p_is_down         = GLFW_PRESS == glfwGetKey( window, GLFW_KEY_P );
+    if ( p_is_down && !p_was_down ) { show_cache = !show_cache; }
+    p_was_down = p_is_down;
+
     float cam_yaw   = 0.0f; // y-rotation in degrees
     float cam_pitch = 0.0f;
     float cam_roll  = 0.0;
@@ -345,11 +417,16 @@ int main() {
       V = inverse( R_inv ) * inverse( T_inv );
       glUseProgram( gp_sp );
       glUniformMatrix4fv( gp_V_loc, 1, GL_FALSE, V.m );
+      if ( g_vt_loaded ) {
+        glUseProgram( fb_sp );
+        glUniformMatrix4fv( fb_V_loc, 1, GL_FALSE, V.m );
+      }
     }
     // put the stuff we've been drawing onto the display
     glfwSwapBuffers( window );
   }
   // done
+  if ( g_vt_loaded ) { free_virtual_texture( &g_vt ); }
   glfwTerminate();
   return 0;
 }
@@ -0,0 +1,658 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Virtual texturing.                                                           |
+\******************************************************************************/
+#include "virtual_texture.h"
+#include <atomic>
+#include <condition_variable>
+#include <math.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* pages that can be waiting for a worker */
+#define VT_MAX_QUEUED 128
+/* pages that can be read and waiting to be copied into the cache. workers stop
+when they run out of these buffers */
+#define VT_MAX_LOADED 32
+/* pages made at once when writing a page file */
+#define VT_WRITE_BATCH 64
+/* anisotropic samples that the border around each page leaves room for */
+#define VT_MAX_ANISO 8.0f
+
+enum vt_page_state_t { VT_PAGE_ABSENT, VT_PAGE_PENDING, VT_PAGE_RESIDENT };
+
+const char* vt_glsl =
+  "uniform usampler2D vt_table;\n"
+  "uniform sampler2D vt_cache;\n"
+  "uniform float vt_size;\n"
+  "uniform int vt_n_levels;\n"
+  "uniform float vt_lod_bias;\n"
+  "uniform float vt_cache_size;\n"
+  "const float vt_page = 128.0, vt_border = 4.0, vt_slot = 136.0, vt_max_aniso = 8.0;\n"
+  /* anisotropic filtering takes up to vt_max_aniso samples along the longer
+  axis, so the level only has to suit the shorter one */
+  "float vt_lod (vec2 dx, vec2 dy) {\n"
+  "  float major = max (dot (dx, dx), dot (dy, dy)), minor = min (dot (dx, dx), dot (dy, dy));\n"
+  "  float lod = 0.5 * log2 (max (max (minor, major / (vt_max_aniso * vt_max_aniso)), 1e-8)) + vt_lod_bias;\n"
+  "  return clamp (lod, 0.0, float (vt_n_levels - 1));\n"
+  "}\n"
+  /* dx and dy are in pixels of level 0. the table's entry can be for a coarser
+  page than the level asked for, if that is all that is loaded. the position in
+  the entry's page is worked out from the same position in pages that picked
+  the entry, scaled by a power of 2, which is exact, so the two can't disagree
+  on which page a pixel on the edge of one is in */
+  "vec4 vt_texture_level (vec2 uv, vec2 dx, vec2 dy, int level) {\n"
+  "  ivec2 n_pages = textureSize (vt_table, level);\n"
+  "  vec2 pages = uv * vec2 (n_pages);\n"
+  "  uvec4 entry = texelFetch (vt_table, min (ivec2 (pages), n_pages - 1), level);\n"
+  "  float scale = exp2 (float (level) - float (entry.z));\n"
+  "  pages *= scale;\n"
+  "  vec2 in_page = pages - min (floor (pages), vec2 (n_pages) * scale - 1.0);\n"
+  "  vec2 at = vec2 (entry.xy) * vt_slot + vt_border + in_page * vt_page;\n"
+  "  float to_cache = exp2 (-float (entry.z)) / vt_cache_size;\n"
+  "  return textureGrad (vt_cache, at / vt_cache_size, dx * to_cache, dy * to_cache);\n"
+  "}\n"
+  "vec4 vt_texture (vec2 uv) {\n"
+  "  vec2 dx = dFdx (uv) * vt_size, dy = dFdy (uv) * vt_size;\n"
+  "  uv = clamp (uv, 0.0, 1.0);\n"
+  "  float lod = vt_lod (dx, dy);\n"
+  "  int level = int (lod);\n"
+  "  vec4 colour = vt_texture_level (uv, dx, dy, level);\n"
+  "  if (level + 1 >= vt_n_levels) { return colour; }\n"
+  "  return mix (colour, vt_texture_level (uv, dx, dy, level + 1), fract (lod));\n"
+  "}\n"
+  "uvec4 vt_feedback (vec2 uv) {\n"
+  "  vec2 dx = dFdx (uv) * vt_size, dy = dFdy (uv) * vt_size;\n"
+  "  int level = int (vt_lod (dx, dy));\n"
+  "  ivec2 n_pages = textureSize (vt_table, level);\n"
+  "  return uvec4 (min (ivec2 (clamp (uv, 0.0, 1.0) * vec2 (n_pages)), n_pages - 1), level, 1);\n"
+  "}\n";
+
+/* the number of pages in all levels, and how many in each */
+static int count_pages( uint32_t size, int* n_levels, int* level_pages, int* level_first ) {
+  int n_pages = 0;
+  *n_levels   = 0;
+  for ( uint32_t pages = size / VT_PAGE_SIZE; pages > 0 && *n_levels < VT_MAX_LEVELS; pages /= 2 ) {
+    level_pages[*n_levels] = pages;
+    level_first[*n_levels] = n_pages;
+    n_pages += pages * pages;
+    ( *n_levels )++;
+  }
+  return n_pages;
+}
+
+static bool is_power_of_2( uint32_t n ) { return n > 0 && 0 == ( n & ( n - 1 ) ); }
+
+struct vt_write_job_t {
+  vt_texel_fn_t texel;
+  void* user_data;
+  int n_levels;
+  int level_pages[VT_MAX_LEVELS], level_first[VT_MAX_LEVELS];
+  int first_page, n_pages;
+  unsigned char* pixels;
+  std::atomic<int> next_page;
+};
+
+/* each page's border repeats the pixels of the pages around it, and the edge
+pixels of the whole level past its edges */
+static void write_page_worker( vt_write_job_t* job ) {
+  for ( int i = job->next_page++; i < job->n_pages; i = job->next_page++ ) {
+    int page  = job->first_page + i;
+    int level = job->n_levels - 1;
+    while ( page < job->level_first[level] ) { level--; }
+    int n              = job->level_pages[level];
+    int page_x         = ( page - job->level_first[level] ) % n;
+    int page_y         = ( page - job->level_first[level] ) / n;
+    int last           = n * VT_PAGE_SIZE - 1;
+    unsigned char* out = job->pixels + (size_t)i * VT_PAGE_BYTES;
+    for ( int j = 0; j < VT_SLOT_SIZE; j++ ) {
+      int y = page_y * VT_PAGE_SIZE + j - VT_PAGE_BORDER;
+      y     = y < 0 ? 0 : ( y > last ? last : y );
+      for ( int k = 0; k < VT_SLOT_SIZE; k++ ) {
+        int x = page_x * VT_PAGE_SIZE + k - VT_PAGE_BORDER;
+        x     = x < 0 ? 0 : ( x > last ? last : x );
+        job->texel( level, x, y, out + ( j * VT_SLOT_SIZE + k ) * 4, job->user_data );
+      }
+    }
+  }
+}
+
+bool write_vt_page_file( const char* file_name, int size, vt_texel_fn_t texel, void* user_data, int n_threads ) {
+  if ( size < VT_PAGE_SIZE || !is_power_of_2( size ) ) {
+    fprintf( stderr, "ERROR: a virtual texture has to be a power of 2 in size, and at least %i. not %i\n", VT_PAGE_SIZE, size );
+    return false;
+  }
+  if ( n_threads < 1 ) { n_threads = (int)std::thread::hardware_concurrency(); }
+  if ( n_threads < 1 ) { n_threads = 1; }
+  vt_file_header_t header;
+  memcpy( header.magic, "VTP1", 4 );
+  header.size        = size;
+  header.page_size   = VT_PAGE_SIZE;
+  header.page_border = VT_PAGE_BORDER;
+
+  vt_write_job_t job;
+  job.texel       = texel;
+  job.user_data   = user_data;
+  header.n_pages  = count_pages( size, &job.n_levels, job.level_pages, job.level_first );
+  header.n_levels = job.n_levels;
+  job.pixels      = (unsigned char*)malloc( (size_t)VT_WRITE_BATCH * VT_PAGE_BYTES );
+  FILE* fp        = job.pixels ? fopen( file_name, "wb" ) : NULL;
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+    free( job.pixels );
+    return false;
+  }
+  bool ok              = 1 == fwrite( &header, sizeof( header ), 1, fp );
+  std::thread* threads = new std::thread[n_threads > 1 ? n_threads - 1 : 1];
+  for ( job.first_page = 0; job.first_page < (int)header.n_pages && ok; job.first_page += VT_WRITE_BATCH ) {
+    job.n_pages   = (int)header.n_pages - job.first_page < VT_WRITE_BATCH ? (int)header.n_pages - job.first_page : VT_WRITE_BATCH;
+    job.next_page = 0;
+    for ( int t = 0; t < n_threads - 1; t++ ) { threads[t] = std::thread( write_page_worker, &job ); }
+    write_page_worker( &job );
+    for ( int t = 0; t < n_threads - 1; t++ ) { threads[t].join(); }
+    ok = (size_t)job.n_pages == fwrite( job.pixels, VT_PAGE_BYTES, job.n_pages, fp );
+  }
+  delete[] threads;
+  free( job.pixels );
+  ok = 0 == fclose( fp ) && ok;
+  if ( !ok ) { fprintf( stderr, "ERROR: could not write %s\n", file_name ); }
+  return ok;
+}
+
+/* a page that a worker has read, or failed to */
+struct vt_loaded_t {
+  int page;
+  unsigned char* pixels;
+  bool ok;
+};
+
+struct vt_streamer_t {
+#ifdef _WIN32
+  HANDLE file;
+#else
+  int fd;
+#endif
+  std::thread* threads;
+  int n_threads;
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool quit;
+  /* everything after here is guarded by mutex */
+  int queue[VT_MAX_QUEUED]; // coarsest pages first
+  int queue_start, queue_end;
+  vt_loaded_t loaded[VT_MAX_LOADED];
+  int n_loaded;
+  unsigned char* free_buffers[VT_MAX_LOADED];
+  int n_free_buffers;
+  int n_streamed;
+  uint64_t bytes_streamed;
+};
+
+/* any number of threads can read from the file at once, each at its own offset */
+static bool read_at( vt_streamer_t* s, uint64_t offset, void* dst, size_t bytes ) {
+#ifdef _WIN32
+  OVERLAPPED overlapped;
+  memset( &overlapped, 0, sizeof( overlapped ) );
+  overlapped.Offset     = (DWORD)offset;
+  overlapped.OffsetHigh = (DWORD)( offset >> 32 );
+  DWORD n_read          = 0;
+  return ReadFile( s->file, dst, (DWORD)bytes, &n_read, &overlapped ) && n_read == bytes;
+#else
+  return (ssize_t)bytes == pread( s->fd, dst, bytes, (off_t)offset );
+#endif
+}
+
+static uint64_t page_offset( int page ) { return sizeof( vt_file_header_t ) + (uint64_t)page * VT_PAGE_BYTES; }
+
+static void stream_worker( vt_streamer_t* s ) {
+  std::unique_lock<std::mutex> lock( s->mutex );
+  while ( !s->quit ) {
+    if ( s->queue_start == s->queue_end || 0 == s->n_free_buffers ) {
+      s->wake.wait( lock );
+      continue;
+    }
+    int page              = s->queue[s->queue_start++];
+    unsigned char* pixels = s->free_buffers[--s->n_free_buffers];
+    lock.unlock();
+    bool ok = read_at( s, page_offset( page ), pixels, VT_PAGE_BYTES );
+    if ( !ok ) { fprintf( stderr, "ERROR: could not read virtual texture page %i\n", page ); }
+    lock.lock();
+    vt_loaded_t* loaded = &s->loaded[s->n_loaded++];
+    loaded->page        = page;
+    loaded->pixels      = pixels;
+    loaded->ok          = ok;
+    if ( ok ) {
+      s->n_streamed++;
+      s->bytes_streamed += VT_PAGE_BYTES;
+    }
+  }
+}
+
+/* every entry of the table from a page down to level 0 that is under it.
+coarse to fine, so that an entry without a page of its own can copy its
+parent's */
+static void update_table( virtual_texture_t* vt, int level, int page_x, int page_y ) {
+  for ( int l = level; l >= 0; l-- ) {
+    int n          = 1 << ( level - l );
+    int x0         = page_x << ( level - l );
+    int y0         = page_y << ( level - l );
+    int row        = vt->level_pages[l];
+    uint8_t* table = vt->table + vt->table_level_offsets[l];
+    for ( int y = y0; y < y0 + n; y++ ) {
+      for ( int x = x0; x < x0 + n; x++ ) {
+        int slot       = vt->page_slots[vt->level_first[l] + y * row + x];
+        uint8_t* entry = table + ( y * row + x ) * 4;
+        if ( slot >= 0 ) {
+          entry[0] = (uint8_t)( slot % vt->slots_a_side );
+          entry[1] = (uint8_t)( slot / vt->slots_a_side );
+          entry[2] = (uint8_t)l;
+          entry[3] = 255;
+        } else {
+          /* the coarsest level is always loaded, so there is always a parent */
+          memcpy( entry, vt->table + vt->table_level_offsets[l + 1] + ( ( y / 2 ) * vt->level_pages[l + 1] + x / 2 ) * 4, 4 );
+        }
+      }
+    }
+    glPixelStorei( GL_UNPACK_ROW_LENGTH, row );
+    glTexSubImage2D( GL_TEXTURE_2D, l, x0, y0, n, n, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, table + ( y0 * row + x0 ) * 4 );
+  }
+  glPixelStorei( GL_UNPACK_ROW_LENGTH, 0 );
+}
+
+static void page_coords( const virtual_texture_t* vt, int page, int* level, int* x, int* y ) {
+  *level = vt->header.n_levels - 1;
+  while ( page < vt->level_first[*level] ) { ( *level )--; }
+  *x = ( page - vt->level_first[*level] ) % vt->level_pages[*level];
+  *y = ( page - vt->level_first[*level] ) / vt->level_pages[*level];
+}
+
+/* copies a page into a slot, in the cache and the table. the table texture
+has to be bound */
+static void place_page( virtual_texture_t* vt, int page, int slot, const unsigned char* pixels ) {
+  int level, x, y;
+  int evicted = vt->slot_pages[slot];
+  if ( evicted >= 0 ) {
+    vt->page_slots[evicted]  = -1;
+    vt->page_states[evicted] = VT_PAGE_ABSENT;
+    page_coords( vt, evicted, &level, &x, &y );
+    update_table( vt, level, x, y );
+  }
+  glBindTexture( GL_TEXTURE_2D, vt->cache_tex );
+  glTexSubImage2D( GL_TEXTURE_2D, 0, ( slot % vt->slots_a_side ) * VT_SLOT_SIZE, ( slot / vt->slots_a_side ) * VT_SLOT_SIZE, VT_SLOT_SIZE, VT_SLOT_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+  glBindTexture( GL_TEXTURE_2D, vt->table_tex );
+  vt->slot_pages[slot]  = page;
+  vt->slot_frames[slot] = vt->frame;
+  vt->page_slots[page]  = slot;
+  vt->page_states[page] = VT_PAGE_RESIDENT;
+  page_coords( vt, page, &level, &x, &y );
+  update_table( vt, level, x, y );
+}
+
+/* a free slot, or else the least recently wanted. not one wanted this frame,
+which would only be swapped straight back, and never the coarsest page's */
+static int find_slot( const virtual_texture_t* vt ) {
+  int best        = -1;
+  uint32_t oldest = vt->frame;
+  for ( int s = 0; s < vt->slots_a_side * vt->slots_a_side; s++ ) {
+    if ( vt->slot_pages[s] < 0 ) { return s; }
+    if ( vt->slot_pages[s] == (int)vt->header.n_pages - 1 ) { continue; }
+    if ( vt->slot_frames[s] < oldest ) {
+      oldest = vt->slot_frames[s];
+      best   = s;
+    }
+  }
+  return best;
+}
+
+static void create_feedback_buffer( virtual_texture_t* vt, int window_width, int window_height ) {
+  vt->feedback_width  = window_width / VT_FEEDBACK_SCALE > 1 ? window_width / VT_FEEDBACK_SCALE : 1;
+  vt->feedback_height = window_height / VT_FEEDBACK_SCALE > 1 ? window_height / VT_FEEDBACK_SCALE : 1;
+  glBindTexture( GL_TEXTURE_2D, vt->feedback_tex );
+  /* x, y, level, and 0 where nothing was drawn. 16 bits allows 65536 pages a side */
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA16UI, vt->feedback_width, vt->feedback_height, 0, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, NULL );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+  glBindRenderbuffer( GL_RENDERBUFFER, vt->feedback_depth_rb );
+  glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT, vt->feedback_width, vt->feedback_height );
+  for ( int i = 0; i < VT_FEEDBACK_FRAMES; i++ ) {
+    if ( vt->feedback_fences[i] ) { glDeleteSync( vt->feedback_fences[i] ); }
+    vt->feedback_fences[i] = 0;
+  }
+}
+
+bool init_virtual_texture( virtual_texture_t* vt, const char* file_name, int slots_a_side, int n_threads, int window_width, int window_height ) {
+  memset( vt, 0, sizeof( virtual_texture_t ) );
+  vt_streamer_t* s = new vt_streamer_t();
+#ifdef _WIN32
+  s->file     = CreateFileA( file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+  bool opened = INVALID_HANDLE_VALUE != s->file;
+#else
+  s->fd       = open( file_name, O_RDONLY );
+  bool opened = s->fd >= 0;
+#endif
+  if ( !opened ) {
+    fprintf( stderr, "ERROR: could not open virtual texture %s\n", file_name );
+    delete s;
+    return false;
+  }
+  vt->streamer = s;
+  int n_levels = 0;
+  if ( !read_at( s, 0, &vt->header, sizeof( vt_file_header_t ) ) || 0 != memcmp( vt->header.magic, "VTP1", 4 ) || VT_PAGE_SIZE != vt->header.page_size || VT_PAGE_BORDER != vt->header.page_border ||
+       !is_power_of_2( vt->header.size ) || vt->header.n_pages != (uint32_t)count_pages( vt->header.size, &n_levels, vt->level_pages, vt->level_first ) || vt->header.n_levels != (uint32_t)n_levels ) {
+    fprintf( stderr, "ERROR: %s is not a page file with %ix%i pages\n", file_name, VT_PAGE_SIZE, VT_PAGE_SIZE );
+    free_virtual_texture( vt );
+    return false;
+  }
+  GLint max_size = 0;
+  glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_size );
+  if ( slots_a_side < 1 || slots_a_side > 256 || slots_a_side * VT_SLOT_SIZE > max_size || vt->level_pages[0] > max_size ) {
+    fprintf( stderr, "ERROR: a cache of %ix%i pages, or a page table of %ix%i, is too big for this GPU\n", slots_a_side, slots_a_side, vt->level_pages[0], vt->level_pages[0] );
+    free_virtual_texture( vt );
+    return false;
+  }
+
+  int n_pages       = (int)vt->header.n_pages;
+  int n_slots       = slots_a_side * slots_a_side;
+  vt->slots_a_side  = slots_a_side;
+  vt->slot_pages    = (int*)malloc( n_slots * sizeof( int ) );
+  vt->slot_frames   = (uint32_t*)calloc( n_slots, sizeof( uint32_t ) );
+  vt->page_slots    = (int*)malloc( n_pages * sizeof( int ) );
+  vt->page_states   = (uint8_t*)calloc( n_pages, sizeof( uint8_t ) );
+  vt->page_requests = (uint32_t*)calloc( n_pages, sizeof( uint32_t ) );
+  vt->page_missing  = (uint32_t*)calloc( n_pages, sizeof( uint32_t ) );
+  vt->missing       = (int*)malloc( n_pages * sizeof( int ) );
+  size_t table_size = 0;
+  for ( int l = 0; l < n_levels; l++ ) {
+    vt->table_level_offsets[l] = table_size;
+    table_size += (size_t)vt->level_pages[l] * vt->level_pages[l] * 4;
+  }
+  vt->table = (uint8_t*)malloc( table_size );
+  for ( int i = 0; i < n_slots; i++ ) { vt->slot_pages[i] = -1; }
+  for ( int i = 0; i < n_pages; i++ ) { vt->page_slots[i] = -1; }
+  vt->frame = 1;
+
+  /* the cache has no mipmaps. the table picks the level */
+  int cache_size = slots_a_side * VT_SLOT_SIZE;
+  glGenTextures( 1, &vt->cache_tex );
+  glBindTexture( GL_TEXTURE_2D, vt->cache_tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, cache_size, cache_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0 );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  GLfloat max_aniso = 0.0f;
+  glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso );
+  glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso < VT_MAX_ANISO ? max_aniso : VT_MAX_ANISO );
+
+  glGenTextures( 1, &vt->table_tex );
+  glBindTexture( GL_TEXTURE_2D, vt->table_tex );
+  for ( int l = 0; l < n_levels; l++ ) { glTexImage2D( GL_TEXTURE_2D, l, GL_RGBA8UI, vt->level_pages[l], vt->level_pages[l], 0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, NULL ); }
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, n_levels - 1 );
+  /* integer textures can't be filtered */
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+
+  /* the coarsest page is read now, and stays. every entry in the table starts
+  out pointing at it */
+  unsigned char* root = (unsigned char*)malloc( VT_PAGE_BYTES );
+  bool ok             = read_at( s, page_offset( n_pages - 1 ), root, VT_PAGE_BYTES );
+  if ( ok ) { place_page( vt, n_pages - 1, 0, root ); }
+  free( root );
+  if ( !ok ) {
+    fprintf( stderr, "ERROR: could not read pages from %s\n", file_name );
+    free_virtual_texture( vt );
+    return false;
+  }
+
+  glGenTextures( 1, &vt->feedback_tex );
+  glGenRenderbuffers( 1, &vt->feedback_depth_rb );
+  create_feedback_buffer( vt, window_width, window_height );
+  glGenFramebuffers( 1, &vt->feedback_fb );
+  glBindFramebuffer( GL_FRAMEBUFFER, vt->feedback_fb );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, vt->feedback_tex, 0 );
+  glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, vt->feedback_depth_rb );
+  GLenum draw_bufs[] = { GL_COLOR_ATTACHMENT0 };
+  glDrawBuffers( 1, draw_bufs );
+  glReadBuffer( GL_COLOR_ATTACHMENT0 );
+  GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  if ( GL_FRAMEBUFFER_COMPLETE != status ) {
+    fprintf( stderr, "ERROR: incomplete feedback framebuffer. status 0x%x\n", status );
+    free_virtual_texture( vt );
+    return false;
+  }
+  glGenBuffers( VT_FEEDBACK_FRAMES, vt->feedback_pbos );
+
+  if ( n_threads < 1 ) { n_threads = (int)std::thread::hardware_concurrency(); }
+  s->n_threads      = n_threads > 0 ? n_threads : 1;
+  s->n_free_buffers = VT_MAX_LOADED;
+  for ( int i = 0; i < VT_MAX_LOADED; i++ ) { s->free_buffers[i] = (unsigned char*)malloc( VT_PAGE_BYTES ); }
+  s->threads = new std::thread[s->n_threads];
+  for ( int t = 0; t < s->n_threads; t++ ) { s->threads[t] = std::thread( stream_worker, s ); }
+  return true;
+}
+
+void free_virtual_texture( virtual_texture_t* vt ) {
+  vt_streamer_t* s = vt->streamer;
+  if ( s ) {
+    {
+      std::lock_guard<std::mutex> lock( s->mutex );
+      s->quit = true;
+    }
+    s->wake.notify_all();
+    for ( int t = 0; t < s->n_threads; t++ ) { s->threads[t].join(); }
+    delete[] s->threads;
+    for ( int i = 0; i < s->n_free_buffers; i++ ) { free( s->free_buffers[i] ); }
+    for ( int i = 0; i < s->n_loaded; i++ ) { free( s->loaded[i].pixels ); }
+#ifdef _WIN32
+    CloseHandle( s->file );
+#else
+    close( s->fd );
+#endif
+    delete s;
+  }
+  for ( int i = 0; i < VT_FEEDBACK_FRAMES; i++ ) {
+    if ( vt->feedback_fences[i] ) { glDeleteSync( vt->feedback_fences[i] ); }
+  }
+  glDeleteBuffers( VT_FEEDBACK_FRAMES, vt->feedback_pbos );
+  glDeleteFramebuffers( 1, &vt->feedback_fb );
+  glDeleteRenderbuffers( 1, &vt->feedback_depth_rb );
+  glDeleteTextures( 1, &vt->feedback_tex );
+  glDeleteTextures( 1, &vt->table_tex );
+  glDeleteTextures( 1, &vt->cache_tex );
+  free( vt->slot_pages );
+  free( vt->slot_frames );
+  free( vt->page_slots );
+  free( vt->page_states );
+  free( vt->page_requests );
+  free( vt->page_missing );
+  free( vt->missing );
+  free( vt->table );
+  memset( vt, 0, sizeof( virtual_texture_t ) );
+}
+
+void vt_resize_feedback( virtual_texture_t* vt, int window_width, int window_height ) { create_feedback_buffer( vt, window_width, window_height ); }
+
+void vt_begin_feedback( virtual_texture_t* vt ) {
+  glBindFramebuffer( GL_FRAMEBUFFER, vt->feedback_fb );
+  glViewport( 0, 0, vt->feedback_width, vt->feedback_height );
+  /* glClear() isn't defined for integer colour buffers */
+  GLuint nothing[4] = { 0, 0, 0, 0 };
+  glClearBufferuiv( GL_COLOR, 0, nothing );
+  glClear( GL_DEPTH_BUFFER_BIT );
+}
+
+void vt_end_feedback( virtual_texture_t* vt ) {
+  /* if the GPU is still busy with the oldest copy this frame's is dropped */
+  int i = vt->feedback_next;
+  if ( !vt->feedback_fences[i] ) {
+    GLsizeiptr size = (GLsizeiptr)vt->feedback_width * vt->feedback_height * 4 * sizeof( GLushort );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, vt->feedback_pbos[i] );
+    glBufferData( GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ );
+    /* returns straight away. the copy happens when the GPU gets to it */
+    glReadPixels( 0, 0, vt->feedback_width, vt->feedback_height, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, NULL );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    vt->feedback_fences[i] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    vt->feedback_next      = ( i + 1 ) % VT_FEEDBACK_FRAMES;
+  }
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+}
+
+void vt_feedback_jitter( const virtual_texture_t* vt, float* xy ) {
+  /* a 4x4 grid of offsets within a feedback pixel, in an order that spreads
+  out each few frames */
+  static const int order[16] = { 0, 10, 2, 8, 5, 15, 7, 13, 1, 11, 3, 9, 4, 14, 6, 12 };
+  int cell                   = order[vt->frame % 16];
+  xy[0]                      = ( ( cell % 4 ) + 0.5f - 2.0f ) / 4.0f * 2.0f / vt->feedback_width;
+  xy[1]                      = ( ( cell / 4 ) + 0.5f - 2.0f ) / 4.0f * 2.0f / vt->feedback_height;
+}
+
+/* makes a list of the pages in a feedback buffer that aren't in the cache */
+static void read_feedback( virtual_texture_t* vt, const GLushort* pixels, int n_missing_max, int* n_missing ) {
+  int n_levels = (int)vt->header.n_levels;
+  for ( int i = 0; i < vt->feedback_width * vt->feedback_height; i++ ) {
+    const GLushort* p = pixels + i * 4;
+    int x             = p[0], y = p[1], level = p[2];
+    if ( !p[3] || level >= n_levels || x >= vt->level_pages[level] || y >= vt->level_pages[level] ) { continue; }
+    int page = vt->level_first[level] + y * vt->level_pages[level] + x;
+    /* most pixels ask for the same page as others in the same frame */
+    if ( vt->page_requests[page] == vt->frame ) { continue; }
+    vt->page_requests[page] = vt->frame;
+    vt->stats.n_requested++;
+    if ( vt->page_slots[page] >= 0 ) { vt->stats.n_hits++; }
+    /* coarser pages over a missing page are asked for too, if they are missing,
+    and go first, so the view sharpens a level at a time rather than sitting
+    blurry until the finest page is in. the coarsest page is always loaded */
+    while ( vt->page_slots[page] < 0 && vt->page_missing[page] != vt->frame && *n_missing < n_missing_max ) {
+      vt->page_missing[page] = vt->frame;
+      vt->missing[( *n_missing )++] = page;
+      x /= 2;
+      y /= 2;
+      level++;
+      page = vt->level_first[level] + y * vt->level_pages[level] + x;
+    }
+    /* keeps the page, or the coarser one drawn in its place, in the cache */
+    if ( vt->page_slots[page] >= 0 ) { vt->slot_frames[vt->page_slots[page]] = vt->frame; }
+  }
+}
+
+/* pages are numbered from level 0 up, so a bigger number is a coarser level */
+static int compare_pages_coarse_first( const void* a, const void* b ) { return *(const int*)b - *(const int*)a; }
+
+void vt_update( virtual_texture_t* vt, int max_uploads ) {
+  vt_streamer_t* s = vt->streamer;
+  vt->frame++;
+
+  /* feedback that the GPU has finished with, oldest first. a timeout of 0 just
+  asks if the fence has been reached */
+  int n_missing = 0;
+  bool read_any = false;
+  for ( int k = 0; k < VT_FEEDBACK_FRAMES; k++ ) {
+    int i = ( vt->feedback_next + k ) % VT_FEEDBACK_FRAMES;
+    if ( !vt->feedback_fences[i] ) { continue; }
+    GLenum result = glClientWaitSync( vt->feedback_fences[i], 0, 0 );
+    if ( GL_ALREADY_SIGNALED != result && GL_CONDITION_SATISFIED != result ) { continue; }
+    glDeleteSync( vt->feedback_fences[i] );
+    vt->feedback_fences[i] = 0;
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, vt->feedback_pbos[i] );
+    GLsizeiptr size        = (GLsizeiptr)vt->feedback_width * vt->feedback_height * 4 * sizeof( GLushort );
+    const GLushort* pixels = (const GLushort*)glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT );
+    if ( pixels ) {
+      read_feedback( vt, pixels, (int)vt->header.n_pages, &n_missing );
+      glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+      vt->stats.n_feedback++;
+      read_any = true;
+    }
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+  }
+
+  if ( read_any ) {
+    qsort( vt->missing, n_missing, sizeof( int ), compare_pages_coarse_first );
+    std::lock_guard<std::mutex> lock( s->mutex );
+    /* the queue is replaced with what was just asked for. pages still queued
+    that aren't wanted any more are forgotten, but pages a worker has started
+    on are let finish */
+    for ( int i = s->queue_start; i < s->queue_end; i++ ) { vt->page_states[s->queue[i]] = VT_PAGE_ABSENT; }
+    s->queue_start = s->queue_end = 0;
+    for ( int i = 0; i < n_missing && s->queue_end < VT_MAX_QUEUED; i++ ) {
+      if ( VT_PAGE_ABSENT != vt->page_states[vt->missing[i]] ) { continue; }
+      vt->page_states[vt->missing[i]] = VT_PAGE_PENDING;
+      s->queue[s->queue_end++]        = vt->missing[i];
+    }
+    if ( s->queue_end > 0 ) { s->wake.notify_all(); }
+  }
+
+  /* pages that have arrived. any left over wait for the next frame */
+  vt_loaded_t loaded[VT_MAX_LOADED];
+  int n_loaded = 0;
+  {
+    std::lock_guard<std::mutex> lock( s->mutex );
+    n_loaded = s->n_loaded < max_uploads ? s->n_loaded : max_uploads;
+    memcpy( loaded, s->loaded, n_loaded * sizeof( vt_loaded_t ) );
+    memmove( s->loaded, s->loaded + n_loaded, ( s->n_loaded - n_loaded ) * sizeof( vt_loaded_t ) );
+    s->n_loaded -= n_loaded;
+    vt->stats.n_streamed += s->n_streamed;
+    vt->stats.bytes_streamed += s->bytes_streamed;
+    s->n_streamed     = 0;
+    s->bytes_streamed = 0;
+  }
+  if ( 0 == n_loaded ) { return; }
+  glBindTexture( GL_TEXTURE_2D, vt->table_tex );
+  for ( int i = 0; i < n_loaded; i++ ) {
+    int slot                        = loaded[i].ok ? find_slot( vt ) : -1;
+    vt->page_states[loaded[i].page] = VT_PAGE_ABSENT;
+    /* a failed read, or a cache full of pages that are all in view. the page
+    will be asked for again */
+    if ( slot < 0 ) { continue; }
+    place_page( vt, loaded[i].page, slot, loaded[i].pixels );
+    vt->stats.n_uploaded++;
+  }
+  {
+    std::lock_guard<std::mutex> lock( s->mutex );
+    for ( int i = 0; i < n_loaded; i++ ) { s->free_buffers[s->n_free_buffers++] = loaded[i].pixels; }
+  }
+  s->wake.notify_all();
+}
+
+void vt_bind( const virtual_texture_t* vt, GLuint programme, int table_unit, int cache_unit, bool feedback ) {
+  glActiveTexture( GL_TEXTURE0 + table_unit );
+  glBindTexture( GL_TEXTURE_2D, vt->table_tex );
+  glActiveTexture( GL_TEXTURE0 + cache_unit );
+  glBindTexture( GL_TEXTURE_2D, vt->cache_tex );
+  glActiveTexture( GL_TEXTURE0 );
+  glUniform1i( glGetUniformLocation( programme, "vt_table" ), table_unit );
+  glUniform1i( glGetUniformLocation( programme, "vt_cache" ), cache_unit );
+  glUniform1f( glGetUniformLocation( programme, "vt_size" ), (float)vt->header.size );
+  glUniform1i( glGetUniformLocation( programme, "vt_n_levels" ), (int)vt->header.n_levels );
+  /* neighbouring pixels of the feedback buffer are VT_FEEDBACK_SCALE times
+  further apart in the texture than in the window */
+  glUniform1f( glGetUniformLocation( programme, "vt_lod_bias" ), feedback ? -log2f( (float)VT_FEEDBACK_SCALE ) : 0.0f );
+  glUniform1f( glGetUniformLocation( programme, "vt_cache_size" ), (float)( vt->slots_a_side * VT_SLOT_SIZE ) );
+}
+
+vt_stats_t vt_take_stats( virtual_texture_t* vt ) {
+  vt_stats_t stats = vt->stats;
+  stats.n_slots    = vt->slots_a_side * vt->slots_a_side;
+  stats.n_resident = 0;
+  for ( int i = 0; i < stats.n_slots; i++ ) {
+    if ( vt->slot_pages[i] >= 0 ) { stats.n_resident++; }
+  }
+  memset( &vt->stats, 0, sizeof( vt_stats_t ) );
+  return stats;
+}
@@ -0,0 +1,144 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Virtual texturing.                                                           |
+| A texture too big for video memory is cut into 128x128 pages, at every       |
+| mipmap level, and kept in a page file on disk. Only the pages that the       |
+| camera can see are in video memory, in slots of one big "cache" texture.     |
+| A small "page table" texture, with a mipmap level for each level of pages,   |
+| says which slot each page is in. Where a page isn't loaded yet, its entry    |
+| points at the nearest coarser page that is, so there is always something     |
+| to draw, just blurrier. The coarsest level is a single page that is always   |
+| loaded.                                                                      |
+| To find out which pages are wanted, the scene is also drawn into a small     |
+| "feedback" framebuffer, 1/8 the size of the window, where each pixel is the  |
+| page and level that the pixel would sample. That is copied into a pixel      |
+| buffer object and read back a frame or two later, once a fence says the GPU  |
+| is done, so the CPU never waits for it. Pages that aren't in the cache go to |
+| a pool of worker threads, which read them from the page file, and the GL     |
+| thread copies finished pages into free slots, or the least recently used.    |
+| Each page is stored with a border of 4 pixels from its neighbours, so that   |
+| bilinear and anisotropic filtering in the cache don't bleed into the next    |
+| slot. Pages are RGBA8.                                                       |
+\******************************************************************************/
+#ifndef _VIRTUAL_TEXTURE_H_
+#define _VIRTUAL_TEXTURE_H_
+
+#include <GL/glew.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define VT_PAGE_SIZE 128
+#define VT_PAGE_BORDER 4
+#define VT_SLOT_SIZE ( VT_PAGE_SIZE + 2 * VT_PAGE_BORDER )
+#define VT_PAGE_BYTES ( VT_SLOT_SIZE * VT_SLOT_SIZE * 4 )
+/* enough for 4 million pixels a side */
+#define VT_MAX_LEVELS 16
+/* the feedback buffer is this many times smaller than the window */
+#define VT_FEEDBACK_SCALE 8
+/* feedback readbacks that can be waiting for the GPU at once */
+#define VT_FEEDBACK_FRAMES 3
+
+/* the start of a page file. the pages follow, level 0 first, each level row by
+row from the bottom, with the bottom row of each page first */
+struct vt_file_header_t {
+  char magic[4]; // "VTP1"
+  uint32_t size; // width and height of level 0, in pixels. a power of 2
+  uint32_t page_size, page_border;
+  uint32_t n_levels; // of pages. the last is 1 page
+  uint32_t n_pages;  // in all of the levels
+};
+
+/* writes the colour of pixel x, y of a level to rgba */
+typedef void ( *vt_texel_fn_t )( int level, int x, int y, unsigned char* rgba, void* user_data );
+
+/* makes a page file for a virtual texture of size x size pixels, which has to
+be a power of 2 and at least VT_PAGE_SIZE, by asking texel() for every pixel
+of every page, with its border, on n_threads threads. 0 is one per core */
+bool write_vt_page_file( const char* file_name, int size, vt_texel_fn_t texel, void* user_data, int n_threads );
+
+/* counts since the last call to vt_take_stats() */
+struct vt_stats_t {
+  int n_resident, n_slots; // pages in the cache, now
+  int n_requested, n_hits; // distinct pages in feedback, and those of them already in the cache
+  int n_streamed;          // pages read from disk
+  int n_uploaded;          // pages copied into the cache
+  uint64_t bytes_streamed;
+  int n_feedback; // feedback buffers read back
+};
+
+struct vt_streamer_t; // worker threads, in virtual_texture.cpp
+
+struct virtual_texture_t {
+  vt_file_header_t header;
+  int level_pages[VT_MAX_LEVELS]; // pages a side in each level
+  int level_first[VT_MAX_LEVELS]; // index of each level's first page
+  /* cache */
+  GLuint cache_tex; // RGBA8
+  int slots_a_side;
+  int* slot_pages;       // page in each slot, or -1
+  uint32_t* slot_frames; // when the page in a slot was last wanted
+  int* page_slots;       // slot of each page, or -1
+  uint8_t* page_states;
+  /* the page table. each entry is the x and y of a slot, and the level of the
+  page in it */
+  GLuint table_tex; // RGBA8UI, with a level for each level of pages
+  uint8_t* table;   // every level, one after the other
+  size_t table_level_offsets[VT_MAX_LEVELS];
+  /* feedback */
+  GLuint feedback_fb, feedback_tex, feedback_depth_rb;
+  int feedback_width, feedback_height;
+  GLuint feedback_pbos[VT_FEEDBACK_FRAMES];
+  GLsync feedback_fences[VT_FEEDBACK_FRAMES];
+  int feedback_next;       // next PBO to read into
+  uint32_t* page_requests; // frame each page was last asked for
+  uint32_t* page_missing;  // frame each page was last put in missing
+  int* missing;            // pages asked for that aren't in the cache
+  uint32_t frame;
+  vt_streamer_t* streamer;
+  vt_stats_t stats;
+};
+
+/* opens a page file, with a cache of slots_a_side x slots_a_side pages, and
+n_threads workers reading pages. the feedback buffer is for a window of
+window_width x window_height */
+bool init_virtual_texture( virtual_texture_t* vt, const char* file_name, int slots_a_side, int n_threads, int window_width, int window_height );
+void free_virtual_texture( virtual_texture_t* vt );
+/* resizes the feedback buffer, and drops any readbacks in flight */
+void vt_resize_feedback( virtual_texture_t* vt, int window_width, int window_height );
+
+/* binds and clears the feedback framebuffer. draw everything that samples the
+virtual texture with a programme that outputs vt_feedback() */
+void vt_begin_feedback( virtual_texture_t* vt );
+/* queues the copy into a PBO, if one is free, and binds the default
+framebuffer again. put the viewport back after */
+void vt_end_feedback( virtual_texture_t* vt );
+/* a sub-pixel offset for the feedback pass, in clip space, that moves around
+each frame so that over a few frames every pixel of the window is looked at */
+void vt_feedback_jitter( const virtual_texture_t* vt, float* xy );
+/* call once per frame. reads back any finished feedback, asks the workers for
+pages that are missing, and copies up to max_uploads pages that have arrived
+into the cache */
+void vt_update( virtual_texture_t* vt, int max_uploads );
+
+/* binds the page table and the cache to texture units table_unit and
+cache_unit, and sets the uniforms of vt_glsl in programme, which has to be in
+use. feedback is true for the programme of the feedback pass */
+void vt_bind( const virtual_texture_t* vt, GLuint programme, int table_unit, int cache_unit, bool feedback );
+
+/* returns the stats and starts counting again */
+vt_stats_t vt_take_stats( virtual_texture_t* vt );
+
+/* GLSL to paste in to fragment shaders after the #version line. it has the
+uniforms, and:
+  vec4 vt_texture (vec2 uv)  - samples the virtual texture, trilinear and
+                               anisotropic
+  uvec4 vt_feedback (vec2 uv) - the page for the feedback pass to output */
+extern const char* vt_glsl;
+
+#endif
@@ -9,12 +9,17 @@
 | Sprite Sheets example                                                        |
 | Displaying a looped animation of some frames from a sprite that I made for   |
 | my Ludum Dare competition #28 entry 'Dolphin Rescue'                         |
+| A school of smaller sharks swims around it, drawn with an instanced sprite   |
+| batch. Press B to compare 100k sprites drawn one at a time and batched.      |
 \******************************************************************************/
 #include "maths_funcs.h"
+#include "sprite_batch.h"
+#include "texture_loader.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"  // Sean Barrett's image loader
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h> // GLFW helper library
+#include <math.h>
 #include <stdio.h>
 
 int g_viewport_width  = 640;
@@ -30,6 +35,10 @@ GLint V_loc;         // view matrix location in sp
 GLint P_loc;         // projection matrix location in sp
 GLint st_offset_loc; // texture coords offset to select sprite within texture
 
+/* sharks swimming in circles around the big one, each with a shadow */
+#define SCHOOL_SIZE 1000
+sprite_batch_t g_batch;
+
 /* change to a new sprite in the sprite sheet. works out new texcoord mods */
 void change_sprite( int sprite_index ) {
   const int num_cols = 2;
@@ -86,47 +95,110 @@ void create_shaders() {
   glUniformMatrix4fv( P_loc, 1, GL_FALSE, P.m );
 }
 
+/* decodes the image and makes its mipmaps through the texture pipeline, keeping
+its own number of channels, then uploads them */
 bool load_texture( const char* file_name, GLuint* tex ) {
-  int x, y, n;
-  int force_channels        = 4;
-  unsigned char* image_data = stbi_load( file_name, &x, &y, &n, force_channels );
-  if ( !image_data ) {
-    fprintf( stderr, "ERROR: could not load %s\n", file_name );
-    return false;
+  texture_image_t image;
+  if ( !load_texture_image( file_name, &image, 0 ) ) { return false; }
+  bool ok = create_texture_from_image( &image, tex );
+  free_texture_image( &image );
+  return ok;
+}
+
+/* the sprite batch works on a 2d plane. this puts its x and y on the floor
+where the big shark is, the same way the shader above does, then into clip
+space */
+mat4 floor_clip_mat( float height ) {
+  mat4 floor_mat( 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, height, 0.0f, 1.0f );
+  return P * V * floor_mat;
+}
+
+/* the frame to show at a time into the 2 second loop. plays 2, 0, 2, 3 */
+int anim_frame( double t ) {
+  if ( t > 1.5 ) { return 3; }
+  if ( t > 1.0 ) { return 2; }
+  if ( t > 0.5 ) { return 0; }
+  return 2;
+}
+
+/* adds shark i of the school to the batch, at a time in seconds. sharks are
+on layer 1 and their shadows on layer 0, so every shadow is under every shark */
+void add_school_shark( sprite_batch_t* batch, GLuint shark_tex, int i, double t ) {
+  /* the golden angle spreads them evenly round without lining them up */
+  float ring  = 2.0f + 8.0f * (float)( i % 50 ) / 50.0f;
+  float angle = (float)i * 2.39996f + (float)t * 2.0f / ring;
+  float size  = 0.3f + 0.2f * (float)( i % 7 ) / 7.0f;
+  sprite_t s;
+  s.pos[0]  = cosf( angle ) * ring;
+  s.pos[1]  = sinf( angle ) * ring;
+  s.size[0] = size;
+  s.size[1] = size;
+  /* the sheet's shark faces +x. a quarter turn more faces it along the circle */
+  s.rotation   = angle + 1.5708f;
+  double phase = fmod( t + (double)( i % 13 ) * 0.15, 2.0 );
+  sprite_sheet_rect( anim_frame( phase ), 2, 2, s.st_rect );
+  s.colour[0] = (GLubyte)( 155 + i % 100 );
+  s.colour[1] = (GLubyte)( 155 + i * 7 % 100 );
+  s.colour[2] = 255;
+  s.colour[3] = 255;
+  add_sprite( batch, shark_tex, 1, &s );
+
+  /* the same frame tinted into a dark, see-through shadow, a little down and to
+  the right */
+  sprite_t shadow  = s;
+  shadow.pos[0]    = s.pos[0] + 0.08f;
+  shadow.pos[1]    = s.pos[1] - 0.08f;
+  shadow.colour[0] = 0;
+  shadow.colour[1] = 0;
+  shadow.colour[2] = 0;
+  shadow.colour[3] = 90;
+  add_sprite( batch, shark_tex, 0, &shadow );
+}
+
+/* 100k sprites drawn the way the big shark is, with change_sprite() and a draw
+for each, then with the batch. the scissor test keeps the fill cost out of it,
+since all of the one-at-a-time sprites land on the same spot. a last batched
+run without it shows what the whole frame costs */
+void benchmark_sprites( GLuint vao, GLuint shark_tex ) {
+  const int n_sprites = 100000;
+  sprite_batch_t batch;
+  if ( !init_sprite_batch( &batch, n_sprites * 2 ) ) { return; }
+  glEnable( GL_SCISSOR_TEST );
+  glScissor( 0, 0, 1, 1 );
+  glDisable( GL_DEPTH_TEST );
+
+  glFinish();
+  double start = glfwGetTime();
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( GL_TEXTURE_2D, shark_tex );
+  glBindVertexArray( vao );
+  for ( int i = 0; i < n_sprites; i++ ) {
+    change_sprite( i % 4 );
+    glDrawArrays( GL_TRIANGLES, 0, 6 );
   }
-  // NPOT check
-  if ( ( x & ( x - 1 ) ) != 0 || ( y & ( y - 1 ) ) != 0 ) { fprintf( stderr, "WARNING: texture %s is not power-of-2 dimensions\n", file_name ); }
-  int width_in_bytes    = x * 4;
-  unsigned char* top    = NULL;
-  unsigned char* bottom = NULL;
-  unsigned char temp    = 0;
-  int half_height       = y / 2;
-
-  for ( int row = 0; row < half_height; row++ ) {
-    top    = image_data + row * width_in_bytes;
-    bottom = image_data + ( y - row - 1 ) * width_in_bytes;
-    for ( int col = 0; col < width_in_bytes; col++ ) {
-      temp    = *top;
-      *top    = *bottom;
-      *bottom = temp;
-      top++;
-      bottom++;
-    }
+  double submitted = glfwGetTime();
+  glFinish();
+  double finished = glfwGetTime();
+  printf( "%i sprites one at a time: submit %8.3fms, finished %8.3fms, %i draw calls\n", n_sprites, ( submitted - start ) * 1000.0, ( finished - start ) * 1000.0, n_sprites );
+
+  /* each shark has a shadow, so half as many sharks for the same sprite count */
+  mat4 clip_mat = floor_clip_mat( -1.0f );
+  for ( int scissor = 1; scissor >= 0; scissor-- ) {
+    if ( !scissor ) { glDisable( GL_SCISSOR_TEST ); }
+    glFinish();
+    start = glfwGetTime();
+    begin_sprite_batch( &batch, clip_mat.m );
+    for ( int i = 0; i < n_sprites / 2; i++ ) { add_school_shark( &batch, shark_tex, i, 0.0 ); }
+    double added = glfwGetTime();
+    int n_draws  = end_sprite_batch( &batch );
+    submitted    = glfwGetTime();
+    glFinish();
+    finished = glfwGetTime();
+    printf( "%i sprites batched%s: add %8.3fms + end %8.3fms, finished %8.3fms, %i draw calls\n", n_sprites, scissor ? "" : " (full fill)", ( added - start ) * 1000.0, ( submitted - added ) * 1000.0,
+      ( finished - start ) * 1000.0, n_draws );
   }
-  glGenTextures( 1, tex );
-  glActiveTexture( GL_TEXTURE0 );
-  glBindTexture( GL_TEXTURE_2D, *tex );
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data );
-  glGenerateMipmap( GL_TEXTURE_2D );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-  GLfloat max_aniso = 0.0f;
-  glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso );
-  // set the maximum!
-  glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso );
-  return true;
+  glEnable( GL_DEPTH_TEST );
+  free_sprite_batch( &batch );
 }
 
 /* we will tell GLFW to run this function whenever the window is resized */
@@ -192,6 +264,7 @@ int main() {
   // textures
   GLuint tex;
   load_texture( "shark_anim.png", &tex );
+  init_sprite_batch( &g_batch, SCHOOL_SIZE * 2 );
 
   // rendering defaults
   glDepthFunc( GL_LESS ); // set depth function
@@ -234,6 +307,14 @@ int main() {
     // wipe the drawing surface clear
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
+    // draw the school flat on the floor, under the big shark
+    glDisable( GL_DEPTH_TEST );
+    mat4 school_mat = floor_clip_mat( -1.0f );
+    begin_sprite_batch( &g_batch, school_mat.m );
+    for ( int i = 0; i < SCHOOL_SIZE; i++ ) { add_school_shark( &g_batch, tex, i, current_seconds ); }
+    end_sprite_batch( &g_batch );
+    glEnable( GL_DEPTH_TEST );
+
     // draw
     glActiveTexture( GL_TEXTURE0 );
     glBindTexture( GL_TEXTURE_2D, tex );
@@ -244,6 +325,11 @@ int main() {
     // update other events like input handling
     glfwPollEvents();
     if ( GLFW_PRESS == glfwGetKey( window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( window, 1 ); }
+    static bool b_was_down = false;
+    bool b_is_down         = glfwGetKey( window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) { benchmark_sprites( vao, tex ); }
+    b_was_down = b_is_down;
+
     float cam_yaw   = 0.0f; // y-rotation in degrees
     float cam_pitch = 0.0f;
     float cam_roll  = 0.0;
@@ -328,6 +414,7 @@ int main() {
     glfwSwapBuffers( window );
   }
   // done
+  free_sprite_batch( &g_batch );
   glfwTerminate();
   return 0;
 }
@@ -0,0 +1,247 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Instanced sprite batching.                                                   |
+\******************************************************************************/
+#include "sprite_batch.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the quad's corners come from gl_VertexID, in the same order as the 2 triangles
+of the demo's panel, so there's no vertex buffer apart from the instances */
+static const char* g_batch_vs_str =
+  "#version 410\n"
+  "layout (location = 0) in vec2 pos;"
+  "layout (location = 1) in vec3 size_rotation;"
+  "layout (location = 2) in vec4 st_rect;"
+  "layout (location = 3) in vec4 colour;"
+  "uniform mat4 clip_mat;"
+  "out vec2 st;"
+  "out vec4 tint;"
+  "const vec2 corners[6] = vec2[6] (vec2 (0.0, 0.0), vec2 (1.0, 0.0), vec2 (0.0, 1.0),"
+  "  vec2 (0.0, 1.0), vec2 (1.0, 0.0), vec2 (1.0, 1.0));"
+  "void main () {"
+  "  vec2 corner = corners[gl_VertexID];"
+  "  st = st_rect.xy + corner * st_rect.zw;"
+  "  tint = colour;"
+  "  vec2 p = (corner - 0.5) * size_rotation.xy;"
+  "  float c = cos (size_rotation.z);"
+  "  float s = sin (size_rotation.z);"
+  "  p = vec2 (c * p.x - s * p.y, s * p.x + c * p.y);"
+  "  gl_Position = clip_mat * vec4 (pos + p, 0.0, 1.0);"
+  "}";
+static const char* g_batch_fs_str =
+  "#version 410\n"
+  "in vec2 st;"
+  "in vec4 tint;"
+  "uniform sampler2D tex;"
+  "out vec4 frag_colour;"
+  "void main () {"
+  "  frag_colour = texture (tex, st) * tint;"
+  "}";
+
+static GLuint create_batch_programme() {
+  GLuint vs = glCreateShader( GL_VERTEX_SHADER );
+  glShaderSource( vs, 1, &g_batch_vs_str, NULL );
+  glCompileShader( vs );
+  GLuint fs = glCreateShader( GL_FRAGMENT_SHADER );
+  glShaderSource( fs, 1, &g_batch_fs_str, NULL );
+  glCompileShader( fs );
+  GLuint sp = glCreateProgram();
+  glAttachShader( sp, vs );
+  glAttachShader( sp, fs );
+  glLinkProgram( sp );
+  glDeleteShader( vs );
+  glDeleteShader( fs );
+  GLint params = -1;
+  glGetProgramiv( sp, GL_LINK_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    char log[2048];
+    glGetProgramInfoLog( sp, sizeof( log ), NULL, log );
+    fprintf( stderr, "ERROR: could not link sprite batch shaders\n%s\n", log );
+    glDeleteProgram( sp );
+    return 0;
+  }
+  return sp;
+}
+
+/* points the instance attributes at the sprite first in the buffer. only
+needed when glDrawArraysInstancedBaseInstance() isn't there to do it (GL 4.2) */
+static void point_instance_attribs( int first ) {
+  /* size and rotation are next to each other, so they go in as one vec3 */
+  size_t base = (size_t)first * sizeof( sprite_t );
+  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( sprite_t ), (GLvoid*)( base + offsetof( sprite_t, pos ) ) );
+  glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, sizeof( sprite_t ), (GLvoid*)( base + offsetof( sprite_t, size ) ) );
+  glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, sizeof( sprite_t ), (GLvoid*)( base + offsetof( sprite_t, st_rect ) ) );
+  glVertexAttribPointer( 3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof( sprite_t ), (GLvoid*)( base + offsetof( sprite_t, colour ) ) );
+}
+
+bool init_sprite_batch( sprite_batch_t* batch, int max_sprites ) {
+  memset( batch, 0, sizeof( sprite_batch_t ) );
+  batch->sprites  = (sprite_t*)malloc( max_sprites * sizeof( sprite_t ) );
+  batch->keys     = (GLushort*)malloc( max_sprites * sizeof( GLushort ) );
+  batch->order[0] = (int*)malloc( max_sprites * sizeof( int ) );
+  batch->order[1] = (int*)malloc( max_sprites * sizeof( int ) );
+  batch->sp       = create_batch_programme();
+  if ( !batch->sprites || !batch->keys || !batch->order[0] || !batch->order[1] || !batch->sp ) {
+    fprintf( stderr, "ERROR: could not make a sprite batch of %i\n", max_sprites );
+    free_sprite_batch( batch );
+    return false;
+  }
+  batch->max_sprites  = max_sprites;
+  batch->clip_mat_loc = glGetUniformLocation( batch->sp, "clip_mat" );
+
+  glGenBuffers( 1, &batch->instance_vbo );
+  glBindBuffer( GL_ARRAY_BUFFER, batch->instance_vbo );
+  glBufferData( GL_ARRAY_BUFFER, (GLsizeiptr)max_sprites * sizeof( sprite_t ), NULL, GL_STREAM_DRAW );
+  glGenVertexArrays( 1, &batch->vao );
+  glBindVertexArray( batch->vao );
+  point_instance_attribs( 0 );
+  for ( int i = 0; i < 4; i++ ) {
+    glEnableVertexAttribArray( i );
+    glVertexAttribDivisor( i, 1 );
+  }
+  glBindVertexArray( 0 );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  return true;
+}
+
+void free_sprite_batch( sprite_batch_t* batch ) {
+  free( batch->sprites );
+  free( batch->keys );
+  free( batch->order[0] );
+  free( batch->order[1] );
+  if ( batch->sp ) { glDeleteProgram( batch->sp ); }
+  glDeleteBuffers( 1, &batch->instance_vbo );
+  glDeleteVertexArrays( 1, &batch->vao );
+  memset( batch, 0, sizeof( sprite_batch_t ) );
+}
+
+void begin_sprite_batch( sprite_batch_t* batch, const float* clip_mat ) {
+  memcpy( batch->clip_mat, clip_mat, sizeof( batch->clip_mat ) );
+  batch->n_sprites  = 0;
+  batch->n_textures = 0;
+  batch->n_draws    = 0;
+}
+
+/* a stable counting sort of the keys, the texture slot byte and then the
+layer byte. returns the sprites' order. a byte that's the same for every sprite
+is skipped, which with one texture and one layer is all of them */
+static const int* sort_sprites( sprite_batch_t* batch ) {
+  int n = batch->n_sprites;
+  int counts[2][256];
+  memset( counts, 0, sizeof( counts ) );
+  for ( int i = 0; i < n; i++ ) {
+    batch->order[0][i] = i;
+    counts[0][batch->keys[i] & 0xff]++;
+    counts[1][batch->keys[i] >> 8]++;
+  }
+  int src = 0;
+  for ( int pass = 0; pass < 2; pass++ ) {
+    int place     = 0;
+    bool all_same = false;
+    for ( int d = 0; d < 256; d++ ) {
+      int count = counts[pass][d];
+      if ( count == n ) { all_same = true; }
+      counts[pass][d] = place;
+      place += count;
+    }
+    if ( all_same ) { continue; }
+    const int* in = batch->order[src];
+    int* out      = batch->order[1 - src];
+    for ( int i = 0; i < n; i++ ) { out[counts[pass][( batch->keys[in[i]] >> ( pass * 8 ) ) & 0xff]++] = in[i]; }
+    src = 1 - src;
+  }
+  return batch->order[src];
+}
+
+/* sorts, uploads and draws the sprites so far, and empties the batch */
+static void flush_sprite_batch( sprite_batch_t* batch ) {
+  int n = batch->n_sprites;
+  if ( n < 1 ) { return; }
+  const int* order = sort_sprites( batch );
+
+  glBindBuffer( GL_ARRAY_BUFFER, batch->instance_vbo );
+  /* invalidating hands back a fresh buffer if the GPU is still drawing from the
+  last one. the sprites are gathered in sorted order so that the writes into the
+  mapped buffer are all in a row */
+  sprite_t* mapped = (sprite_t*)glMapBufferRange( GL_ARRAY_BUFFER, 0, (GLsizeiptr)n * sizeof( sprite_t ), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+  if ( !mapped ) {
+    fprintf( stderr, "ERROR: could not map the sprite instance buffer\n" );
+    batch->n_sprites  = 0;
+    batch->n_textures = 0;
+    return;
+  }
+  for ( int i = 0; i < n; i++ ) { mapped[i] = batch->sprites[order[i]]; }
+  glUnmapBuffer( GL_ARRAY_BUFFER );
+
+  glUseProgram( batch->sp );
+  glUniformMatrix4fv( batch->clip_mat_loc, 1, GL_FALSE, batch->clip_mat );
+  glActiveTexture( GL_TEXTURE0 );
+  glBindVertexArray( batch->vao );
+  bool base_instance = GLEW_ARB_base_instance;
+  /* one draw per run of sprites with the same layer and texture */
+  for ( int first = 0; first < n; ) {
+    GLushort key = batch->keys[order[first]];
+    int last     = first + 1;
+    while ( last < n && batch->keys[order[last]] == key ) { last++; }
+    glBindTexture( GL_TEXTURE_2D, batch->textures[key & 0xff] );
+    if ( base_instance ) {
+      glDrawArraysInstancedBaseInstance( GL_TRIANGLES, 0, 6, last - first, first );
+    } else {
+      point_instance_attribs( first );
+      glDrawArraysInstanced( GL_TRIANGLES, 0, 6, last - first );
+    }
+    batch->n_draws++;
+    first = last;
+  }
+  if ( !base_instance ) { point_instance_attribs( 0 ); }
+  glBindVertexArray( 0 );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  batch->n_sprites  = 0;
+  batch->n_textures = 0;
+}
+
+void add_sprite( sprite_batch_t* batch, GLuint tex, int layer, const sprite_t* sprite ) {
+  if ( layer < 0 ) { layer = 0; }
+  if ( layer >= SPRITE_BATCH_MAX_LAYERS ) { layer = SPRITE_BATCH_MAX_LAYERS - 1; }
+  /* sprites tend to come in runs of the same texture, so look at the last one
+  added before searching */
+  int slot = batch->n_textures - 1;
+  if ( slot < 0 || batch->textures[slot] != tex ) {
+    for ( slot = 0; slot < batch->n_textures; slot++ ) {
+      if ( batch->textures[slot] == tex ) { break; }
+    }
+  }
+  if ( batch->n_sprites >= batch->max_sprites || slot >= SPRITE_BATCH_MAX_TEXTURES ) {
+    flush_sprite_batch( batch );
+    slot = 0;
+  }
+  if ( slot >= batch->n_textures ) {
+    slot                  = batch->n_textures++;
+    batch->textures[slot] = tex;
+  }
+  batch->keys[batch->n_sprites]      = (GLushort)( layer << 8 | slot );
+  batch->sprites[batch->n_sprites++] = *sprite;
+}
+
+int end_sprite_batch( sprite_batch_t* batch ) {
+  flush_sprite_batch( batch );
+  return batch->n_draws;
+}
+
+void sprite_sheet_rect( int sprite_index, int cols, int rows, float* rect ) {
+  int col = sprite_index % cols;
+  int row = rows - 1 - sprite_index / cols;
+  rect[0] = (float)col / (float)cols;
+  rect[1] = (float)row / (float)rows;
+  rect[2] = 1.0f / (float)cols;
+  rect[3] = 1.0f / (float)rows;
+}
@@ -0,0 +1,76 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Instanced sprite batching.                                                   |
+| Drawing sprites one at a time costs a uniform update and a draw call each,   |
+| and at a few thousand sprites the CPU spends the frame talking to the        |
+| driver. A batch instead collects every sprite for the frame, with its own    |
+| position, size, rotation, sprite sheet rectangle and colour, then:           |
+|   sort   - by layer, then by texture, so that each run of sprites sharing    |
+|            both is together. within a run they keep the order they came in   |
+|   upload - the sorted sprites are written into one instance buffer           |
+|   draw   - one glDrawArraysInstanced() per run. the vertex shader makes the  |
+|            6 corners of each quad from gl_VertexID                           |
+| Sprites live on a 2d plane. A matrix passed to begin_sprite_batch() takes    |
+| that plane to clip space, so it can be a pixel-space orthographic matrix for |
+| a GUI, or a 3d camera's for sprites in a scene.                              |
+\******************************************************************************/
+#ifndef _SPRITE_BATCH_H_
+#define _SPRITE_BATCH_H_
+
+#include <GL/glew.h>
+
+/* different textures one batch can hold before it has to be flushed */
+#define SPRITE_BATCH_MAX_TEXTURES 256
+/* layers are drawn lowest first */
+#define SPRITE_BATCH_MAX_LAYERS 256
+
+/* one sprite, laid out as it is in the instance buffer */
+struct sprite_t {
+  float pos[2];     // centre
+  float size[2];    // width and height
+  float rotation;   // anti-clockwise, in radians
+  float st_rect[4]; // texture coordinates of the bottom-left corner, then width and height
+  GLubyte colour[4];
+};
+
+struct sprite_batch_t {
+  int max_sprites, n_sprites;
+  sprite_t* sprites;
+  /* each sprite's layer and texture slot, and the order the sort gives */
+  GLushort* keys;
+  int* order[2];
+  GLuint textures[SPRITE_BATCH_MAX_TEXTURES];
+  int n_textures;
+  float clip_mat[16];
+  GLuint sp, vao, instance_vbo;
+  GLint clip_mat_loc;
+  /* draw calls made since begin_sprite_batch(), including any flushes */
+  int n_draws;
+};
+
+bool init_sprite_batch( sprite_batch_t* batch, int max_sprites );
+void free_sprite_batch( sprite_batch_t* batch );
+
+/* starts a frame's worth of sprites. clip_mat takes the sprite plane's x and
+y to clip space */
+void begin_sprite_batch( sprite_batch_t* batch, const float* clip_mat );
+
+/* adds a sprite to be drawn with a texture. if the batch is full it is drawn
+first, and the new sprite starts the next lot */
+void add_sprite( sprite_batch_t* batch, GLuint tex, int layer, const sprite_t* sprite );
+
+/* sorts, uploads and draws everything added since begin_sprite_batch() or the
+last flush. returns how many draw calls were made, here and in any flushes */
+int end_sprite_batch( sprite_batch_t* batch );
+
+/* sets rect to sprite_index's cell in a sprite sheet of cols by rows equal
+sprites. the first sprite is at the top left */
+void sprite_sheet_rect( int sprite_index, int cols, int rows, float* rect );
+
+#endif
@@ -0,0 +1,205 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Texture loading pipeline.                                                    |
+\******************************************************************************/
+#include "texture_loader.h"
+#include "stb_image.h" // the implementation is in another file
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+/* levels with fewer pixels than this aren't worth starting threads for */
+#define MIN_PIXELS_PER_THREAD 65536
+
+static double get_seconds() { return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count(); }
+
+static int default_threads( int n_threads ) {
+  if ( n_threads > 0 ) { return n_threads; }
+  n_threads = (int)std::thread::hardware_concurrency();
+  return n_threads > 0 ? n_threads : 1;
+}
+
+/* the pixels of the level above, along one axis, that output pixel i covers:
+2 from *first, or 3 for the last one where the level above is odd in size, so
+its last row or column isn't lost. a level 1 pixel across just has the 1 */
+static int source_span( int i, int dim, int src_dim, int* first ) {
+  *first = src_dim > 1 ? 2 * i : 0;
+  if ( src_dim < 2 ) { return 1; }
+  return i == dim - 1 && ( src_dim & 1 ) ? 3 : 2;
+}
+
+/* one level's rows, first to last - 1, from the level above. each pixel is the
+average of the 2x2 pixels above it, or 2x3, 3x2 or 3x3 along an odd edge */
+static void downsample_rows( const texture_image_t* image, int level, int first, int last ) {
+  int n                    = image->n_channels;
+  int src_width            = texture_level_dim( image->width, level - 1 );
+  int src_height           = texture_level_dim( image->height, level - 1 );
+  int width                = texture_level_dim( image->width, level );
+  int height               = texture_level_dim( image->height, level );
+  const unsigned char* src = image->levels[level - 1];
+  unsigned char* dst       = image->levels[level];
+  for ( int y = first; y < last; y++ ) {
+    int sy                    = 0;
+    int ny                    = source_span( y, height, src_height, &sy );
+    const unsigned char* row0 = src + (size_t)sy * src_width * n;
+    const unsigned char* row1 = src + (size_t)( 2 == ny ? sy + 1 : sy ) * src_width * n;
+    unsigned char* out        = dst + (size_t)y * width * n;
+    for ( int x = 0; x < width; x++ ) {
+      int sx = 0;
+      int nx = source_span( x, width, src_width, &sx );
+      if ( 2 == nx && 2 == ny ) {
+        int x0 = sx * n, x1 = x0 + n;
+        for ( int c = 0; c < n; c++ ) { out[x * n + c] = (unsigned char)( ( row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2 ) >> 2 ); }
+        continue;
+      }
+      int count = nx * ny;
+      for ( int c = 0; c < n; c++ ) {
+        int sum = 0;
+        for ( int j = 0; j < ny; j++ ) {
+          const unsigned char* row = src + (size_t)( sy + j ) * src_width * n;
+          for ( int i = 0; i < nx; i++ ) { sum += row[( sx + i ) * n + c]; }
+        }
+        out[x * n + c] = (unsigned char)( ( sum + count / 2 ) / count );
+      }
+    }
+  }
+}
+
+/* every level after the first goes in one allocation. each level needs the one
+above it finished, so threads share out the rows of a level at a time */
+static bool make_mipmaps( texture_image_t* image, int n_threads ) {
+  int max_dim     = image->width > image->height ? image->width : image->height;
+  image->n_levels = 1;
+  while ( max_dim >> image->n_levels > 0 && image->n_levels < TEXTURE_MAX_LEVELS ) { image->n_levels++; }
+  size_t bytes = 0;
+  for ( int l = 1; l < image->n_levels; l++ ) { bytes += (size_t)texture_level_dim( image->width, l ) * texture_level_dim( image->height, l ) * image->n_channels; }
+  if ( 0 == bytes ) { return true; }
+  image->levels[1] = (unsigned char*)malloc( bytes );
+  if ( !image->levels[1] ) { return false; }
+  for ( int l = 2; l < image->n_levels; l++ ) { image->levels[l] = image->levels[l - 1] + (size_t)texture_level_dim( image->width, l - 1 ) * texture_level_dim( image->height, l - 1 ) * image->n_channels; }
+
+  std::thread* threads = new std::thread[n_threads > 1 ? n_threads - 1 : 1];
+  for ( int l = 1; l < image->n_levels; l++ ) {
+    int width     = texture_level_dim( image->width, l );
+    int height    = texture_level_dim( image->height, l );
+    int n_workers = (int)( (long long)width * height / MIN_PIXELS_PER_THREAD );
+    n_workers     = n_workers < 1 ? 1 : ( n_workers > n_threads ? n_threads : n_workers );
+    /* this thread does the last band */
+    for ( int t = 0; t < n_workers - 1; t++ ) { threads[t] = std::thread( downsample_rows, image, l, height * t / n_workers, height * ( t + 1 ) / n_workers ); }
+    downsample_rows( image, l, height * ( n_workers - 1 ) / n_workers, height );
+    for ( int t = 0; t < n_workers - 1; t++ ) { threads[t].join(); }
+  }
+  delete[] threads;
+  return true;
+}
+
+bool load_texture_image( const char* file_name, texture_image_t* image, int n_threads ) {
+  memset( image, 0, sizeof( texture_image_t ) );
+  double start = get_seconds();
+  /* each thread has its own flip setting. it's put back after, so that other
+  stbi_load() calls on this thread don't flip */
+  stbi_set_flip_vertically_on_load_thread( 1 );
+  /* RGB is decoded as RGBA. see texture_loader.h */
+  int n_channels = 0;
+  stbi_info( file_name, &image->width, &image->height, &n_channels );
+  image->levels[0] = stbi_load( file_name, &image->width, &image->height, &image->n_channels, 3 == n_channels ? 4 : 0 );
+  stbi_set_flip_vertically_on_load_thread( 0 );
+  if ( 3 == n_channels ) { image->n_channels = 4; }
+  if ( !image->levels[0] ) {
+    fprintf( stderr, "ERROR: could not load %s\n", file_name );
+    return false;
+  }
+  double decoded  = get_seconds();
+  image->decode_s = decoded - start;
+  if ( !make_mipmaps( image, default_threads( n_threads ) ) ) {
+    fprintf( stderr, "ERROR: no memory for mipmaps of %s\n", file_name );
+    free_texture_image( image );
+    return false;
+  }
+  image->mips_s = get_seconds() - decoded;
+  return true;
+}
+
+struct texture_job_t {
+  const char* const* file_names;
+  texture_image_t* images;
+  int n_files;
+  int n_mip_threads;
+  std::atomic<int> next_file;
+  std::atomic<int> n_loaded;
+};
+
+static void load_texture_worker( texture_job_t* job ) {
+  for ( int i = job->next_file++; i < job->n_files; i = job->next_file++ ) {
+    if ( load_texture_image( job->file_names[i], &job->images[i], job->n_mip_threads ) ) { job->n_loaded++; }
+  }
+}
+
+int load_texture_images( const char* const* file_names, int n_files, texture_image_t* images, int n_threads ) {
+  n_threads = default_threads( n_threads );
+  texture_job_t job;
+  job.file_names = file_names;
+  job.images     = images;
+  job.n_files    = n_files;
+  job.next_file  = 0;
+  job.n_loaded   = 0;
+  /* a thread per file, and if there are threads to spare, they help with mipmaps */
+  int n_workers        = n_files < n_threads ? n_files : n_threads;
+  job.n_mip_threads    = n_workers > 0 ? n_threads / n_workers : 1;
+  std::thread* threads = new std::thread[n_workers > 1 ? n_workers - 1 : 1];
+  for ( int i = 0; i < n_workers - 1; i++ ) { threads[i] = std::thread( load_texture_worker, &job ); }
+  load_texture_worker( &job );
+  for ( int i = 0; i < n_workers - 1; i++ ) { threads[i].join(); }
+  delete[] threads;
+  return job.n_loaded;
+}
+
+void free_texture_image( texture_image_t* image ) {
+  if ( image->levels[0] ) { stbi_image_free( image->levels[0] ); }
+  free( image->levels[1] );
+  memset( image, 0, sizeof( texture_image_t ) );
+}
+
+bool create_texture_from_image( const texture_image_t* image, GLuint* tex ) {
+  if ( !image->levels[0] || image->n_channels < 1 || image->n_channels > 4 ) { return false; }
+  const GLint internal_formats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+  const GLenum formats[]         = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+  glGenTextures( 1, tex );
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( GL_TEXTURE_2D, *tex );
+  // rows of 1 to 3 byte pixels don't always start on 4-byte boundaries
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+  for ( int l = 0; l < image->n_levels; l++ ) {
+    glTexImage2D( GL_TEXTURE_2D, l, internal_formats[image->n_channels - 1], texture_level_dim( image->width, l ), texture_level_dim( image->height, l ), 0, formats[image->n_channels - 1], GL_UNSIGNED_BYTE,
+      image->levels[l] );
+  }
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image->n_levels - 1 );
+  /* grey reads as the same grey in r, g, and b, as it would if it had been
+  expanded to RGBA */
+  if ( 1 == image->n_channels ) {
+    const GLint grey[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+    glTexParameteriv( GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, grey );
+  } else if ( 2 == image->n_channels ) {
+    const GLint grey_alpha[] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+    glTexParameteriv( GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, grey_alpha );
+  }
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+  GLfloat max_aniso = 0.0f;
+  glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso );
+  // set the maximum!
+  glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso );
+  return true;
+}
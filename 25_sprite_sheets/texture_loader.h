@@ -0,0 +1,55 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Texture loading pipeline.                                                    |
+| Only the upload needs the GL thread. Image files are decoded on worker       |
+| threads, a file at a time, and stb_image flips them as it goes, a row at a   |
+| time with memcpy(), instead of swapping byte by byte afterwards.             |
+| Images keep their own number of channels, so greyscale loads as R8 and grey  |
+| with alpha as RG8, swizzled to read the same as RGBA, at a quarter or half   |
+| of the memory. RGB is the exception, and still loads as RGBA: stb_image only |
+| converts JPEG colour with SIMD for 4 channels, and GPUs mostly pad RGB8 out  |
+| to 4 bytes a texel anyway. The mipmaps are made on the CPU with a box        |
+| filter, the rows of each level shared out between threads, so the GL thread  |
+| only copies each level in with glTexImage2D() and doesn't stall in           |
+| glGenerateMipmap(). Images can be any size, not just powers of 2.            |
+\******************************************************************************/
+#ifndef _TEXTURE_LOADER_H_
+#define _TEXTURE_LOADER_H_
+
+#include <GL/glew.h>
+
+/* enough for 32768x32768 */
+#define TEXTURE_MAX_LEVELS 16
+
+/* an image and its mipmaps in memory, with the bottom row first, as GL wants */
+struct texture_image_t {
+  int width, height; // of level 0
+  int n_channels;    // 1 grey, 2 grey and alpha, 4 RGBA. RGB files load as RGBA
+  int n_levels;
+  unsigned char* levels[TEXTURE_MAX_LEVELS];
+  /* stats */
+  double decode_s, mips_s;
+};
+
+/* the size of a level, in pixels, from the size of level 0 */
+inline int texture_level_dim( int dim, int level ) { return dim >> level > 1 ? dim >> level : 1; }
+
+/* decodes an image file and makes its mipmaps, with the rows of each level
+shared between n_threads threads. 0 threads is one per core */
+bool load_texture_image( const char* file_name, texture_image_t* image, int n_threads );
+/* loads several images at once, with n_threads threads in all. 0 is one per
+core. images that fail to load are left empty. returns how many loaded */
+int load_texture_images( const char* const* file_names, int n_files, texture_image_t* images, int n_threads );
+void free_texture_image( texture_image_t* image );
+
+/* creates a 2D texture from the image and all of its levels, clamped to the
+edges, with trilinear and anisotropic filtering */
+bool create_texture_from_image( const texture_image_t* image, GLuint* tex );
+
+#endif
@@ -11,19 +11,22 @@
 | called 'tweak_glyphs' that allows me to customise the spacing and height     |
 | offset for individual glyphs. Ideally I would save these values to a file    |
 | when I'd finished, so that I can re-use them later.                          |
-| I render two strings of text here. I create an unique set of buffers and     |
-| VAO for each string of text, and I work out the position and texture coords  |
-| for each glyph within each string with a function called 'text_to_vbo'       |
-| which maps each character to texture coordinates within the altas texture,   |
-| and pulls out the corresponding glyph spacing offsets that we tweaked.       |
-| I also have a uniform vec4 which lets me customise the colour of the text,   |
-| which I can do easily because I coloured it in white in the image file.      |
+| I render two strings of text here. Each frame 'add_text' works out the       |
+| position and texture coords for each glyph within each string, mapping each  |
+| character to texture coordinates within the altas texture, and pulling out   |
+| the corresponding glyph spacing offsets that we tweaked. The glyphs go into  |
+| one batch for all of the frame's text, drawn with one call (text_batch.h).   |
+| Each string has its own colour, which I can do easily because I coloured the |
+| glyphs in white in the image file.                                           |
+| Press B to time 10000 strings that change every frame.                       |
 \******************************************************************************/
 #include "maths_funcs.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"  // Sean Barrett's image loader
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h> // GLFW helper library
+#include "text_batch.h"
+#include "texture_loader.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -32,13 +35,14 @@
 // size of atlas. my handmade image is 16x16 glyphs
 #define ATLAS_COLS 16
 #define ATLAS_ROWS 16
+/* the most glyphs the demo draws in a frame */
+#define MAX_GLYPHS 1024
+#define BENCH_STRINGS 10000
+#define BENCH_FRAMES 10
 
 int g_viewport_width  = 800;
 int g_viewport_height = 480;
 
-GLuint sp;                 // shader programme
-GLuint sp_text_colour_loc; // location of vec4 "text_colour" uniform
-
 float glyph_y_offsets[256] = { 0.0f };
 float glyph_widths[256]    = { 0.0f };
 
@@ -114,14 +118,18 @@ void tweak_glyphs() {
   glyph_widths['y'] = 0.4f;
 }
 
-void text_to_vbo( const char* str, float at_x, float at_y, float scale_px, GLuint* points_vbo, GLuint* texcoords_vbo, int* point_count ) {
-  int len = strlen( str );
-
-  float* points_tmp    = (float*)malloc( sizeof( float ) * len * 12 );
-  float* texcoords_tmp = (float*)malloc( sizeof( float ) * len * 12 );
+/* lays out a string as glyph records in the frame's text batch. at_x, at_y is
+the top-left of the first glyph, in clip space. returns false if the batch is
+full */
+bool add_text( text_batch_t* batch, const char* str, float at_x, float at_y, float scale_px, const GLubyte* colour ) {
+  int len              = strlen( str );
+  text_glyph_t* glyphs = text_batch_alloc( batch, len );
+  if ( !glyphs ) { return false; }
+  float width  = scale_px / g_viewport_width;
+  float height = scale_px / g_viewport_height;
   for ( int i = 0; i < len; i++ ) {
     // get ascii code as integer
-    int ascii_code = str[i];
+    int ascii_code = (unsigned char)str[i];
 
     // work out row and column in atlas
     int atlas_col = ( ascii_code - ' ' ) % ATLAS_COLS;
@@ -131,139 +139,72 @@ void text_to_vbo( const char* str, float at_x, float at_y, float scale_px, GLuin
     float s = atlas_col * ( 1.0 / ATLAS_COLS );
     float t = ( atlas_row + 1 ) * ( 1.0 / ATLAS_ROWS );
 
-    // work out position of glyphtriangle_width
+    // work out position of glyph
     float x_pos = at_x;
-    float y_pos = at_y - scale_px / g_viewport_height * glyph_y_offsets[ascii_code];
+    float y_pos = at_y - height * glyph_y_offsets[ascii_code];
 
     // move next glyph along to the end of this one
-    if ( i + 1 < len ) {
-      // upper-case letters move twice as far
-      at_x += glyph_widths[ascii_code] * scale_px / g_viewport_width;
-    }
-    // add 6 points and texture coordinates to buffers for each glyph
-    points_tmp[i * 12]     = x_pos;
-    points_tmp[i * 12 + 1] = y_pos;
-    points_tmp[i * 12 + 2] = x_pos;
-    points_tmp[i * 12 + 3] = y_pos - scale_px / g_viewport_height;
-    points_tmp[i * 12 + 4] = x_pos + scale_px / g_viewport_width;
-    points_tmp[i * 12 + 5] = y_pos - scale_px / g_viewport_height;
-
-    points_tmp[i * 12 + 6]  = x_pos + scale_px / g_viewport_width;
-    points_tmp[i * 12 + 7]  = y_pos - scale_px / g_viewport_height;
-    points_tmp[i * 12 + 8]  = x_pos + scale_px / g_viewport_width;
-    points_tmp[i * 12 + 9]  = y_pos;
-    points_tmp[i * 12 + 10] = x_pos;
-    points_tmp[i * 12 + 11] = y_pos;
-
-    texcoords_tmp[i * 12]     = s;
-    texcoords_tmp[i * 12 + 1] = 1.0 - t + 1.0 / ATLAS_ROWS;
-    texcoords_tmp[i * 12 + 2] = s;
-    texcoords_tmp[i * 12 + 3] = 1.0 - t;
-    texcoords_tmp[i * 12 + 4] = s + 1.0 / ATLAS_COLS;
-    texcoords_tmp[i * 12 + 5] = 1.0 - t;
-
-    texcoords_tmp[i * 12 + 6]  = s + 1.0 / ATLAS_COLS;
-    texcoords_tmp[i * 12 + 7]  = 1.0 - t;
-    texcoords_tmp[i * 12 + 8]  = s + 1.0 / ATLAS_COLS;
-    texcoords_tmp[i * 12 + 9]  = 1.0 - t + 1.0 / ATLAS_ROWS;
-    texcoords_tmp[i * 12 + 10] = s;
-    texcoords_tmp[i * 12 + 11] = 1.0 - t + 1.0 / ATLAS_ROWS;
+    at_x += glyph_widths[ascii_code] * width;
+
+    /* the record goes together here and is copied in whole, because the batch
+    is write-only memory that may be slow to read */
+    text_glyph_t glyph;
+    glyph.pos[0]     = x_pos;
+    glyph.pos[1]     = y_pos - height;
+    glyph.size[0]    = width;
+    glyph.size[1]    = height;
+    glyph.st_rect[0] = s;
+    glyph.st_rect[1] = 1.0 - t;
+    glyph.st_rect[2] = 1.0 / ATLAS_COLS;
+    glyph.st_rect[3] = 1.0 / ATLAS_ROWS;
+    memcpy( glyph.colour, colour, sizeof( glyph.colour ) );
+    glyphs[i] = glyph;
   }
-
-  glBindBuffer( GL_ARRAY_BUFFER, *points_vbo );
-  glBufferData( GL_ARRAY_BUFFER, len * 12 * sizeof( float ), points_tmp, GL_DYNAMIC_DRAW );
-  glBindBuffer( GL_ARRAY_BUFFER, *texcoords_vbo );
-  glBufferData( GL_ARRAY_BUFFER, len * 12 * sizeof( float ), texcoords_tmp, GL_DYNAMIC_DRAW );
-
-  free( points_tmp );
-  free( texcoords_tmp );
-
-  *point_count = len * 6;
+  return true;
 }
 
-void create_shaders() {
-  /* here i used negative y from the buffer as the z value so that it was on
-  the floor but also that the 'front' was on the top side. also note how i
-  work out the texture coordinates, st, from the vertex point position */
-  const char* vs_str =
-    "#version 410\n"
-    "layout (location = 0) in vec2 vp;"
-    "layout (location = 1) in vec2 vt;"
-    "out vec2 st;"
-    "void main () {"
-    "  st = vt;"
-    "  gl_Position = vec4 (vp, 0.0, 1.0);"
-    "}";
-  const char* fs_str =
-    "#version 410\n"
-    "in vec2 st;"
-    "uniform sampler2D tex;"
-    "uniform vec4 text_colour;"
-    "out vec4 frag_colour;"
-    "void main () {"
-    "  frag_colour = texture (tex, st) * text_colour;"
-    "}";
-  GLuint vs = glCreateShader( GL_VERTEX_SHADER );
-  glShaderSource( vs, 1, &vs_str, NULL );
-  glCompileShader( vs );
-  int params = -1;
-  glGetShaderiv( vs, GL_COMPILE_STATUS, &params );
-  if ( GL_TRUE != params ) { fprintf( stderr, "ERROR: GL shader index %i did not compile\n", vs ); }
-  GLuint fs = glCreateShader( GL_FRAGMENT_SHADER );
-  glShaderSource( fs, 1, &fs_str, NULL );
-  glCompileShader( fs );
-  glGetShaderiv( fs, GL_COMPILE_STATUS, &params );
-  if ( GL_TRUE != params ) { fprintf( stderr, "ERROR: GL shader index %i did not compile\n", fs ); }
-  sp = glCreateProgram();
-  glAttachShader( sp, vs );
-  glAttachShader( sp, fs );
-  glLinkProgram( sp );
-  glGetProgramiv( sp, GL_LINK_STATUS, &params );
-  if ( GL_TRUE != params ) { fprintf( stderr, "ERROR: could not link shader programme GL index %i\n", sp ); }
-  sp_text_colour_loc = glGetUniformLocation( sp, "text_colour" );
+/* lays out and draws BENCH_STRINGS strings that change every frame, for a few
+frames, in a batch of their own. the scissor box is 1 pixel, so that the time is
+the text system's and not filling in glyphs */
+void benchmark_text( GLuint tex ) {
+  text_batch_t batch;
+  if ( !init_text_batch( &batch, BENCH_STRINGS * 24 ) ) { return; }
+  glEnable( GL_SCISSOR_TEST );
+  glScissor( 0, 0, 1, 1 );
+  const GLubyte colour[] = { 255, 255, 255, 255 };
+  double add_s           = 0.0, end_s = 0.0, finish_s = 0.0;
+  int n_glyphs           = 0;
+  for ( int frame = 0; frame < BENCH_FRAMES; frame++ ) {
+    glFinish();
+    double start = glfwGetTime();
+    text_batch_begin_frame( &batch );
+    for ( int i = 0; i < BENCH_STRINGS; i++ ) {
+      char str[32];
+      snprintf( str, sizeof( str ), "string %5i: %8.3f", i, start * i );
+      add_text( &batch, str, -1.0f + ( i % 4 ) * 0.5f, 1.0f - ( i / 4 % 100 ) * 0.02f, 12.0f, colour );
+    }
+    double added = glfwGetTime();
+    n_glyphs     = text_batch_end_frame( &batch, tex, false );
+    double ended = glfwGetTime();
+    glFinish();
+    add_s += added - start;
+    end_s += ended - added;
+    finish_s += glfwGetTime() - start;
+  }
+  glDisable( GL_SCISSOR_TEST );
+  printf( "%i strings (%i glyphs) per frame, average of %i frames: add %.3fms + end %.3fms, finished %.3fms. %.1fM glyphs/s\n", BENCH_STRINGS, n_glyphs, BENCH_FRAMES, add_s * 1000.0 / BENCH_FRAMES,
+    end_s * 1000.0 / BENCH_FRAMES, finish_s * 1000.0 / BENCH_FRAMES, n_glyphs * BENCH_FRAMES / finish_s / 1e6 );
+  free_text_batch( &batch );
 }
 
+/* decodes the image and makes its mipmaps through the texture pipeline, keeping
+its own number of channels, then uploads them */
 bool load_texture( const char* file_name, GLuint* tex ) {
-  int x, y, n;
-  int force_channels        = 4;
-  unsigned char* image_data = stbi_load( file_name, &x, &y, &n, force_channels );
-  if ( !image_data ) {
-    fprintf( stderr, "ERROR: could not load %s\n", file_name );
-    return false;
-  }
-  // NPOT check
-  if ( ( x & ( x - 1 ) ) != 0 || ( y & ( y - 1 ) ) != 0 ) { fprintf( stderr, "WARNING: texture %s is not power-of-2 dimensions\n", file_name ); }
-  int width_in_bytes    = x * 4;
-  unsigned char* top    = NULL;
-  unsigned char* bottom = NULL;
-  unsigned char temp    = 0;
-  int half_height       = y / 2;
-
-  for ( int row = 0; row < half_height; row++ ) {
-    top    = image_data + row * width_in_bytes;
-    bottom = image_data + ( y - row - 1 ) * width_in_bytes;
-    for ( int col = 0; col < width_in_bytes; col++ ) {
-      temp    = *top;
-      *top    = *bottom;
-      *bottom = temp;
-      top++;
-      bottom++;
-    }
-  }
-  glGenTextures( 1, tex );
-  glActiveTexture( GL_TEXTURE0 );
-  glBindTexture( GL_TEXTURE_2D, *tex );
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data );
-  glGenerateMipmap( GL_TEXTURE_2D );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-  GLfloat max_aniso = 0.0f;
-  glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso );
-  // set the maximum!
-  glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso );
-  return true;
+  texture_image_t image;
+  if ( !load_texture_image( file_name, &image, 0 ) ) { return false; }
+  bool ok = create_texture_from_image( &image, tex );
+  free_texture_image( &image );
+  return ok;
 }
 
 /* we will tell GLFW to run this function whenever the window is resized */
@@ -295,45 +236,11 @@ int main() {
   /* load font meta-data (spacings for each glyph) */
   tweak_glyphs();
 
-  /* set a string of text for lower-case letters */
-  GLuint first_string_vp_vbo, first_string_vt_vbo, first_string_vao;
-  glGenBuffers( 1, &first_string_vp_vbo );
-  glGenBuffers( 1, &first_string_vt_vbo );
-  float x_pos             = -0.75f;
-  float y_pos             = 0.2f;
-  float pixel_scale       = 64.0f;
-  const char first_str[]  = "abcdefghijklmnopqrstuvwxyz";
-  int first_string_points = 0;
-  text_to_vbo( first_str, x_pos, y_pos, pixel_scale, &first_string_vp_vbo, &first_string_vt_vbo, &first_string_points );
-  glGenVertexArrays( 1, &first_string_vao );
-  glBindVertexArray( first_string_vao );
-  glBindBuffer( GL_ARRAY_BUFFER, first_string_vp_vbo );
-  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 0, NULL );
-  glEnableVertexAttribArray( 0 );
-  glBindBuffer( GL_ARRAY_BUFFER, first_string_vt_vbo );
-  glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, 0, NULL );
-  glEnableVertexAttribArray( 1 );
-
-  /* second string of text for capital letters */
-  GLuint second_string_vp_vbo, second_string_vt_vbo, second_string_vao;
-  glGenBuffers( 1, &second_string_vp_vbo );
-  glGenBuffers( 1, &second_string_vt_vbo );
-  x_pos                    = -1.0f;
-  y_pos                    = 1.0f;
-  pixel_scale              = 64.0f;
-  const char second_str[]  = "The human torch was denied a bank loan!";
-  int second_string_points = 0;
-  text_to_vbo( second_str, x_pos, y_pos, pixel_scale, &second_string_vp_vbo, &second_string_vt_vbo, &second_string_points );
-  glGenVertexArrays( 1, &second_string_vao );
-  glBindVertexArray( second_string_vao );
-  glBindBuffer( GL_ARRAY_BUFFER, second_string_vp_vbo );
-  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 0, NULL );
-  glEnableVertexAttribArray( 0 );
-  glBindBuffer( GL_ARRAY_BUFFER, second_string_vt_vbo );
-  glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, 0, NULL );
-  glEnableVertexAttribArray( 1 );
-
-  create_shaders();
+  /* all of the text for a frame goes in one batch */
+  text_batch_t text_batch;
+  if ( !init_text_batch( &text_batch, MAX_GLYPHS ) ) { return 1; }
+  const GLubyte first_colour[]  = { 255, 0, 255, 255 };
+  const GLubyte second_colour[] = { 255, 255, 0, 255 };
 
   // textures
   GLuint tex;
@@ -354,29 +261,28 @@ int main() {
     // wipe the drawing surface clear
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
-    // draw
-    glActiveTexture( GL_TEXTURE0 );
-    glBindTexture( GL_TEXTURE_2D, tex );
-    glUseProgram( sp );
-
     /* Draw text with no depth test and alpha blending */
     glDisable( GL_DEPTH_TEST );
     glEnable( GL_BLEND );
 
-    glBindVertexArray( first_string_vao );
-    glUniform4f( sp_text_colour_loc, 1.0, 0.0, 1.0, 1.0 );
-    glDrawArrays( GL_TRIANGLES, 0, first_string_points );
-
-    glBindVertexArray( second_string_vao );
-    glUniform4f( sp_text_colour_loc, 1.0, 1.0, 0.0, 1.0 );
-    glDrawArrays( GL_TRIANGLES, 0, second_string_points );
+    /* a string of text for lower-case letters, and a second for capital letters.
+    laid out again every frame, as if they changed */
+    text_batch_begin_frame( &text_batch );
+    add_text( &text_batch, "abcdefghijklmnopqrstuvwxyz", -0.75f, 0.2f, 64.0f, first_colour );
+    add_text( &text_batch, "The human torch was denied a bank loan!", -1.0f, 1.0f, 64.0f, second_colour );
+    text_batch_end_frame( &text_batch, tex, false );
 
     // update other events like input handling
     glfwPollEvents();
     if ( GLFW_PRESS == glfwGetKey( window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( window, 1 ); }
+    static bool b_was_down = false;
+    bool b_is_down         = glfwGetKey( window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) { benchmark_text( tex ); }
+    b_was_down = b_is_down;
     glfwSwapBuffers( window );
   }
   // done
+  free_text_batch( &text_batch );
   glfwTerminate();
   return 0;
 }
@@ -0,0 +1,66 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Batched text rendering.                                                      |
+| Every glyph of every string in a frame is one instance record: a rectangle   |
+| on screen, a rectangle in the atlas, and a colour. The records are written   |
+| straight into one buffer, and all the text is drawn with one instanced call  |
+| of 4 vertices per glyph, whose corners come from gl_VertexID. Nothing is     |
+| allocated or re-created per string, unlike making a VBO for each.            |
+| The buffer has a segment per frame in flight and stays mapped, as with the   |
+| uniform ring buffer of the UBO demo. A fence goes in after each frame's draw |
+| and is waited on before its segment is written again.                        |
+| Persistent mapping needs GL 4.4 or ARB_buffer_storage. Without it (e.g. on   |
+| macOS) records are written to CPU memory and sent with glBufferSubData()     |
+| when drawn instead.                                                          |
+\******************************************************************************/
+#ifndef _TEXT_BATCH_H_
+#define _TEXT_BATCH_H_
+
+#include <GL/glew.h>
+
+/* frames that can be in flight at once. triple-buffered */
+#define TEXT_BATCH_FRAMES 3
+
+/* one glyph instance. 36 bytes */
+struct text_glyph_t {
+  float pos[2];      // bottom-left corner, in clip space
+  float size[2];     // in clip space
+  float st_rect[4];  // bottom-left corner and size in the atlas, in texture coordinates
+  GLubyte colour[4]; // rgba. multiplies the atlas texel
+};
+
+struct text_batch_t {
+  GLuint sp, vao, vbo;
+  GLint is_sdf_loc;
+  /* persistently mapped buffer, or CPU memory if persistent mapping is missing */
+  text_glyph_t* ptr;
+  bool persistent;
+  int max_glyphs; // per frame
+  int segment;    // the current frame's segment
+  int n_glyphs;   // added to the current segment so far
+  GLsync fences[TEXT_BATCH_FRAMES];
+  /* stats */
+  int n_dropped;     // glyphs that didn't fit this frame
+  int n_fence_waits; // times the CPU had to wait for the GPU, ever
+};
+
+/* max_glyphs is the most glyphs that one frame will draw */
+bool init_text_batch( text_batch_t* batch, int max_glyphs );
+void free_text_batch( text_batch_t* batch );
+/* moves on to the next segment, waiting for the GPU to finish with it first if
+it hasn't already. call before adding any text in a frame */
+void text_batch_begin_frame( text_batch_t* batch );
+/* returns somewhere to write n glyph records, or NULL if they don't all fit */
+text_glyph_t* text_batch_alloc( text_batch_t* batch, int n );
+/* draws every glyph added this frame with the atlas texture, in one call, and
+fences the segment. is_sdf thresholds the alpha of a signed distance field
+atlas instead of using it as coverage. returns how many glyphs were drawn */
+int text_batch_end_frame( text_batch_t* batch, GLuint tex, bool is_sdf );
+
+#endif
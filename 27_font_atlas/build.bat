@@ -37,8 +37,8 @@ set SRC="*.c??"
 
 @echo on
 
-cl %CFLAGS% generator_main.cpp %INCLUDES% /link %LFLAGS% %LIB_PATH_FREETYPE% %SYSTEM_LIBS% /OUT:"generate.exe" 
-cl %CFLAGS% viewer_main.cpp maths_funcs.cpp %INCLUDES% /link %LFLAGS% %LIBS% /OUT:"view.exe" 
+cl %CFLAGS% generator_main.cpp font_metrics.cpp sdf.cpp skyline_packer.cpp %INCLUDES% /link %LFLAGS% %LIB_PATH_FREETYPE% %SYSTEM_LIBS% /OUT:"generate.exe" 
+cl %CFLAGS% viewer_main.cpp font_metrics.cpp maths_funcs.cpp text_batch.cpp texture_loader.cpp %INCLUDES% /link %LFLAGS% %LIBS% /OUT:"view.exe" 
 
 copy %DLL_PATH_GLEW% .\
 copy %DLL_PATH_GLFW% .\
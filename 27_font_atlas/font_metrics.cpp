@@ -0,0 +1,139 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Binary font metrics.                                                         |
+\******************************************************************************/
+#include "font_metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool write_font_metrics( const char* file_name, const font_metrics_header_t* header, const font_glyph_t* glyphs, const font_kerning_t* kerning ) {
+  /* a block for every page with at least one glyph in it */
+  uint16_t* pages = (uint16_t*)malloc( FONT_METRICS_PAGES * sizeof( uint16_t ) );
+  if ( !pages ) { return false; }
+  memset( pages, 0xff, FONT_METRICS_PAGES * sizeof( uint16_t ) );
+  uint32_t n_blocks = 0;
+  for ( uint32_t i = 0; i < header->n_glyphs; i++ ) {
+    uint32_t page = glyphs[i].codepoint >> 8;
+    if ( FONT_METRICS_NO_BLOCK == pages[page] ) { pages[page] = (uint16_t)n_blocks++; }
+  }
+  /* + 1 so that a font with no glyphs isn't taken for being out of memory */
+  uint32_t* blocks = (uint32_t*)malloc( (size_t)n_blocks * 256 * sizeof( uint32_t ) + 1 );
+  if ( !blocks ) {
+    free( pages );
+    return false;
+  }
+  memset( blocks, 0xff, (size_t)n_blocks * 256 * sizeof( uint32_t ) );
+  for ( uint32_t i = 0; i < header->n_glyphs; i++ ) { blocks[pages[glyphs[i].codepoint >> 8] * 256 + ( glyphs[i].codepoint & 0xff )] = i; }
+
+  font_metrics_header_t out = *header;
+  out.magic                 = FONT_METRICS_MAGIC;
+  out.version               = FONT_METRICS_VERSION;
+  out.n_blocks              = n_blocks;
+  bool ok                   = false;
+  FILE* fp                  = fopen( file_name, "wb" );
+  if ( fp ) {
+    ok = 1 == fwrite( &out, sizeof( out ), 1, fp );
+    ok = ok && out.n_glyphs == fwrite( glyphs, sizeof( font_glyph_t ), out.n_glyphs, fp );
+    ok = ok && FONT_METRICS_PAGES == fwrite( pages, sizeof( uint16_t ), FONT_METRICS_PAGES, fp );
+    ok = ok && n_blocks * 256 == fwrite( blocks, sizeof( uint32_t ), n_blocks * 256, fp );
+    ok = ok && out.n_kerning == fwrite( kerning, sizeof( font_kerning_t ), out.n_kerning, fp );
+    ok = 0 == fclose( fp ) && ok;
+  }
+  free( pages );
+  free( blocks );
+  if ( !ok ) { fprintf( stderr, "ERROR: could not write font metrics to `%s`\n", file_name ); }
+  return ok;
+}
+
+/* points the arrays into the mapping, if the sizes in the header add up to the
+file's, and every index in it stays in range */
+static bool check_font_metrics( font_metrics_t* metrics ) {
+  if ( metrics->size < sizeof( font_metrics_header_t ) ) { return false; }
+  const font_metrics_header_t* header = (const font_metrics_header_t*)metrics->mapping;
+  if ( FONT_METRICS_MAGIC != header->magic || FONT_METRICS_VERSION != header->version ) { return false; }
+  size_t expected = sizeof( font_metrics_header_t ) + (size_t)header->n_glyphs * sizeof( font_glyph_t ) + FONT_METRICS_PAGES * sizeof( uint16_t ) +
+                    (size_t)header->n_blocks * 256 * sizeof( uint32_t ) + (size_t)header->n_kerning * sizeof( font_kerning_t );
+  if ( metrics->size != expected ) { return false; }
+  metrics->header  = header;
+  metrics->glyphs  = (const font_glyph_t*)( header + 1 );
+  metrics->pages   = (const uint16_t*)( metrics->glyphs + header->n_glyphs );
+  metrics->blocks  = (const uint32_t*)( metrics->pages + FONT_METRICS_PAGES );
+  metrics->kerning = (const font_kerning_t*)( metrics->blocks + (size_t)header->n_blocks * 256 );
+
+  for ( uint32_t i = 0; i < FONT_METRICS_PAGES; i++ ) {
+    if ( FONT_METRICS_NO_BLOCK != metrics->pages[i] && metrics->pages[i] >= header->n_blocks ) { return false; }
+  }
+  for ( uint32_t i = 0; i < header->n_blocks * 256; i++ ) {
+    if ( FONT_METRICS_NONE != metrics->blocks[i] && metrics->blocks[i] >= header->n_glyphs ) { return false; }
+  }
+  for ( uint32_t i = 0; i < header->n_glyphs; i++ ) {
+    if ( (uint64_t)metrics->glyphs[i].kerning_first + metrics->glyphs[i].kerning_count > header->n_kerning ) { return false; }
+  }
+  return true;
+}
+
+bool open_font_metrics( const char* file_name, font_metrics_t* metrics ) {
+  memset( metrics, 0, sizeof( font_metrics_t ) );
+#ifdef _WIN32
+  HANDLE file = CreateFileA( file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+  if ( INVALID_HANDLE_VALUE == file ) {
+    fprintf( stderr, "ERROR: could not open font metrics `%s`\n", file_name );
+    return false;
+  }
+  LARGE_INTEGER size;
+  HANDLE mapping = NULL;
+  if ( GetFileSizeEx( file, &size ) && size.QuadPart > 0 ) { mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL ); }
+  if ( mapping ) { metrics->mapping = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ); }
+  metrics->file_handle    = file;
+  metrics->mapping_handle = mapping;
+  metrics->size           = metrics->mapping ? (size_t)size.QuadPart : 0;
+#else
+  int fd = open( file_name, O_RDONLY );
+  if ( fd < 0 ) {
+    fprintf( stderr, "ERROR: could not open font metrics `%s`\n", file_name );
+    return false;
+  }
+  struct stat st;
+  if ( 0 == fstat( fd, &st ) && st.st_size > 0 ) {
+    void* ptr = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( MAP_FAILED != ptr ) {
+      metrics->mapping = ptr;
+      metrics->size    = (size_t)st.st_size;
+    }
+  }
+  /* the mapping keeps the file's pages alive without the descriptor */
+  close( fd );
+#endif
+  if ( !metrics->mapping || !check_font_metrics( metrics ) ) {
+    fprintf( stderr, "ERROR: `%s` is not a valid font metrics file\n", file_name );
+    close_font_metrics( metrics );
+    return false;
+  }
+  return true;
+}
+
+void close_font_metrics( font_metrics_t* metrics ) {
+#ifdef _WIN32
+  if ( metrics->mapping ) { UnmapViewOfFile( metrics->mapping ); }
+  if ( metrics->mapping_handle ) { CloseHandle( (HANDLE)metrics->mapping_handle ); }
+  if ( metrics->file_handle ) { CloseHandle( (HANDLE)metrics->file_handle ); }
+#else
+  if ( metrics->mapping ) { munmap( metrics->mapping, metrics->size ); }
+#endif
+  memset( metrics, 0, sizeof( font_metrics_t ) );
+}
@@ -0,0 +1,110 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Binary font metrics.                                                         |
+| The generator writes an atlas's glyph metrics in a form that the viewer can  |
+| map into memory and use as it is, with no parsing:                           |
+|   header                                                                     |
+|   glyph records, sorted by codepoint                                         |
+|   a page table: for each page of 256 codepoints, its block, or none          |
+|   blocks: for each codepoint in a page that has any glyphs, the index of its |
+|           glyph record, or none                                              |
+|   kerning pairs, sorted by left codepoint then right. each glyph record has  |
+|           the range of pairs with it on the left                             |
+| So finding a glyph is two array reads, whatever the codepoint, and a page    |
+| costs 1 KB only if the font has something in it. The page table itself is    |
+| 8.5 KB of 16-bit block numbers. Every section is 4-byte aligned, and it's    |
+| all little-endian, like every machine the demos run on.                      |
+\******************************************************************************/
+#ifndef _FONT_METRICS_H_
+#define _FONT_METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FONT_METRICS_MAGIC 0x4d544e46 // "FNTM"
+#define FONT_METRICS_VERSION 1
+/* pages of 256 codepoints, up to U+10FFFF */
+#define FONT_METRICS_PAGES 0x1100
+#define FONT_METRICS_NONE 0xffffffff
+#define FONT_METRICS_NO_BLOCK 0xffff
+
+struct font_metrics_header_t {
+  uint32_t magic, version;
+  int32_t atlas_width, atlas_height;
+  int32_t px;          // size the glyphs were rendered at
+  int32_t ascender;    // pixels from the top of a line down to the baseline
+  int32_t line_height; // pixels from one baseline to the next
+  int32_t sdf_spread;  // pixels the distance field reaches past outlines. 0 if it's coverage
+  uint32_t n_glyphs, n_blocks, n_kerning;
+};
+
+/* 28 bytes */
+struct font_glyph_t {
+  uint32_t codepoint;
+  uint16_t atlas_x, atlas_y;   // top-left in the atlas, in pixels, from its top-left
+  uint16_t width, height;      // in pixels. 0 for glyphs with nothing to draw, like space
+  int16_t left, top;           // from the pen position on the baseline to the top-left corner. up is +
+  float advance;               // pen movement to the next glyph, in pixels
+  uint32_t kerning_first;      // this glyph's pairs in the kerning table
+  uint32_t kerning_count;
+};
+
+struct font_kerning_t {
+  uint32_t right; // codepoint of the glyph after
+  float adjust;   // added to the left glyph's advance, in pixels
+};
+
+/* a metrics file mapped into memory. the arrays point into the mapping */
+struct font_metrics_t {
+  const font_metrics_header_t* header;
+  const font_glyph_t* glyphs;
+  const uint16_t* pages;
+  const uint32_t* blocks;
+  const font_kerning_t* kerning;
+  void* mapping;
+  size_t size;
+  void* file_handle;    // Windows only
+  void* mapping_handle; // Windows only
+};
+
+/* builds the page table and blocks and writes the file. glyphs must be sorted by
+codepoint, with no codepoint twice, and kerning must be in the order their
+glyphs' ranges say */
+bool write_font_metrics( const char* file_name, const font_metrics_header_t* header, const font_glyph_t* glyphs, const font_kerning_t* kerning );
+
+/* maps a metrics file into memory and checks it. false if it's not one */
+bool open_font_metrics( const char* file_name, font_metrics_t* metrics );
+void close_font_metrics( font_metrics_t* metrics );
+
+/* the glyph record for a codepoint, or NULL if the font doesn't have it */
+inline const font_glyph_t* find_glyph( const font_metrics_t* metrics, uint32_t codepoint ) {
+  if ( codepoint >> 8 >= FONT_METRICS_PAGES ) { return NULL; }
+  uint32_t block = metrics->pages[codepoint >> 8];
+  if ( FONT_METRICS_NO_BLOCK == block ) { return NULL; }
+  uint32_t index = metrics->blocks[block * 256 + ( codepoint & 0xff )];
+  return FONT_METRICS_NONE == index ? NULL : &metrics->glyphs[index];
+}
+
+/* pixels to add to left's advance when right comes after it */
+inline float find_kerning( const font_metrics_t* metrics, const font_glyph_t* left, uint32_t right ) {
+  const font_kerning_t* pairs = metrics->kerning + left->kerning_first;
+  int lo                      = 0, hi = (int)left->kerning_count - 1;
+  while ( lo <= hi ) {
+    int mid = ( lo + hi ) / 2;
+    if ( pairs[mid].right == right ) { return pairs[mid].adjust; }
+    if ( pairs[mid].right < right ) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return 0.0f;
+}
+
+#endif
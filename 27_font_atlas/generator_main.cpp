@@ -8,23 +8,455 @@
 |******************************************************************************|
 | Font Atlas Generator example                                                 |
 | Uses Sean Barrett's STB_IMAGE_WRITE library for writing to PNG               |
+| Glyphs are rendered on several threads, each with its own FreeType face,     |
+| then packed tightly with a skyline packer into a single-channel atlas, so    |
+| any Unicode ranges fit, not just the 16x16 grid of ASCII that this started   |
+| with. Options, all optional:                                                 |
+|   -font FreeMono.ttf   font file                                             |
+|   -px 58               glyph size in pixels                                  |
+|   -ranges 32-255       codepoints, e.g. 32-126,0xa0-0xff,0x4e00-0x9fff (CJK) |
+|   -pad 2               empty pixels between glyphs, and around the edge      |
+|   -threads n           rendering threads. defaults to the number of cores    |
+|   -sdf 4               signed distance field, reaching 4 pixels either side  |
+|                        of the outline, instead of coverage. see sdf.h        |
+|   -out atlas           writes atlas.png and atlas.metrics. see font_metrics.h |
+|   -bench               times 20000 glyphs with 1 thread and then n threads,  |
+|                        and reports how much of the atlas they fill. uses all |
+|                        of the font's glyphs unless -ranges is given. with    |
+|                        -sdf it also compares the atlas's memory with that of |
+|                        coverage atlases at several sizes                     |
 \******************************************************************************/
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
-#include <ft2build.h>         // FreeType header
-#include FT_FREETYPE_H        // unusual macro
-#include <freetype/ftglyph.h> // needed for bounding box bit
+#include "font_metrics.h"
+#include "sdf.h"
+#include "skyline_packer.h"
+#include <ft2build.h>  // FreeType header
+#include FT_FREETYPE_H // unusual macro
+#include <atomic>
+#include <chrono>
 #include <stdio.h>
 #include <stdlib.h> // some memory management is done
+#include <string.h>
+#include <thread>
 
 /* using the FreeMono font from the GNU fonts collection. this is free and has a
 "copy-left" licence. see package for details */
 #define FONT_FILE_NAME "FreeMono.ttf"
-#define PNG_OUTPUT_IMAGE "atlas.png"
-#define ATLAS_META_FILE "atlas.meta"
+#define OUTPUT_NAME "atlas"
+#define MAX_RANGES 64
+#define MAX_ATLAS_DIMS 16384
+#define BENCH_GLYPHS 20000
+/* glyphs a thread takes from the list at a time */
+#define GLYPH_CHUNK 64
+/* distance fields are made from glyphs rendered this many times bigger */
+#define SDF_UPSCALE 4
 
-int main() {
-  // Now we can initialise FreeType
+struct glyph_t {
+  unsigned int codepoint;
+  int px;            // size it is rendered at
+  int width, height; // of the bitmap, in pixels
+  int left, top;     // from the pen position on the baseline to the bitmap's top-left. up is +
+  float advance;     // pen movement to the next glyph, in pixels
+  unsigned char* bitmap;
+  int atlas_x, atlas_y; // top-left of the bitmap in the atlas
+};
+
+struct codepoint_range_t {
+  unsigned int first, last;
+};
+
+/* shared by every thread working on the glyph list */
+struct glyph_job_t {
+  const char* font_file;
+  glyph_t* glyphs;
+  int n_glyphs;
+  std::atomic<int> next_glyph;
+  std::atomic<int> n_failed;
+  int sdf_spread; // 0 for coverage
+  /* for copying into the atlas */
+  unsigned char* atlas;
+  int atlas_width;
+};
+
+static double get_seconds() { return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count(); }
+
+/* runs fn on n_threads threads, this one included, and waits for them all */
+static void run_threads( int n_threads, void ( *fn )( glyph_job_t* ), glyph_job_t* job ) {
+  job->next_glyph      = 0;
+  std::thread* threads = new std::thread[n_threads - 1];
+  for ( int i = 0; i < n_threads - 1; i++ ) { threads[i] = std::thread( fn, job ); }
+  fn( job );
+  for ( int i = 0; i < n_threads - 1; i++ ) { threads[i].join(); }
+  delete[] threads;
+}
+
+/* FreeType faces can't be shared between threads, so each thread opens its own
+and renders chunks of the list until there are none left. distance fields are
+made on the same threads, one glyph at a time */
+static void render_glyphs( glyph_job_t* job ) {
+  FT_Library ft;
+  FT_Face face;
+  if ( FT_Init_FreeType( &ft ) ) {
+    fprintf( stderr, "Could not init FreeType library\n" );
+    return;
+  }
+  if ( FT_New_Face( ft, job->font_file, 0, &face ) ) {
+    fprintf( stderr, "Could not open font %s\n", job->font_file );
+    FT_Done_FreeType( ft );
+    return;
+  }
+  int px      = 0;
+  int upscale = job->sdf_spread > 0 ? SDF_UPSCALE : 1;
+  for ( ;; ) {
+    int first = job->next_glyph.fetch_add( GLYPH_CHUNK );
+    if ( first >= job->n_glyphs ) { break; }
+    int last = first + GLYPH_CHUNK < job->n_glyphs ? first + GLYPH_CHUNK : job->n_glyphs;
+    for ( int i = first; i < last; i++ ) {
+      glyph_t* g = &job->glyphs[i];
+      if ( g->px != px ) {
+        FT_Set_Pixel_Sizes( face, 0, g->px * upscale );
+        px = g->px;
+      }
+      // draw glyph image anti-aliased
+      if ( FT_Load_Char( face, g->codepoint, FT_LOAD_RENDER ) ) {
+        job->n_failed++;
+        continue;
+      }
+      FT_GlyphSlot slot = face->glyph;
+      g->width          = slot->bitmap.width;
+      g->height         = slot->bitmap.rows;
+      g->left           = slot->bitmap_left;
+      g->top            = slot->bitmap_top;
+      g->advance        = (float)slot->advance.x / ( 64.0f * upscale );
+      if ( g->width < 1 || g->height < 1 ) { continue; }
+      if ( job->sdf_spread > 0 ) {
+        g->bitmap = make_glyph_sdf( slot->bitmap.buffer, slot->bitmap.pitch, upscale, job->sdf_spread, &g->width, &g->height, &g->left, &g->top );
+        if ( !g->bitmap ) { job->n_failed++; }
+        continue;
+      }
+      // copy glyph data into memory because it is overwritten by the next glyph
+      g->bitmap = (unsigned char*)malloc( g->width * g->height );
+      for ( int row = 0; row < g->height; row++ ) { memcpy( g->bitmap + row * g->width, slot->bitmap.buffer + row * slot->bitmap.pitch, g->width ); }
+    }
+  }
+  FT_Done_Face( face );
+  FT_Done_FreeType( ft );
+}
+
+/* every glyph has its own rectangle, so threads can write without locking */
+static void copy_glyphs_to_atlas( glyph_job_t* job ) {
+  for ( ;; ) {
+    int first = job->next_glyph.fetch_add( GLYPH_CHUNK );
+    if ( first >= job->n_glyphs ) { break; }
+    int last = first + GLYPH_CHUNK < job->n_glyphs ? first + GLYPH_CHUNK : job->n_glyphs;
+    for ( int i = first; i < last; i++ ) {
+      const glyph_t* g = &job->glyphs[i];
+      if ( !g->bitmap ) { continue; }
+      for ( int row = 0; row < g->height; row++ ) { memcpy( job->atlas + ( g->atlas_y + row ) * job->atlas_width + g->atlas_x, g->bitmap + row * g->width, g->width ); }
+    }
+  }
+}
+
+/* tallest first, then widest, leaves the fewest gaps under the skyline */
+static const glyph_t* g_sort_glyphs;
+static int compare_glyph_sizes( const void* a, const void* b ) {
+  const glyph_t* ga = &g_sort_glyphs[*(const int*)a];
+  const glyph_t* gb = &g_sort_glyphs[*(const int*)b];
+  if ( ga->height != gb->height ) { return gb->height - ga->height; }
+  if ( ga->width != gb->width ) { return gb->width - ga->width; }
+  return *(const int*)a - *(const int*)b;
+}
+
+/* packs the glyphs into an atlas a power of two wide and only as tall as they
+need, to a multiple of 4. the width starts at the smallest power of two, at
+least 64, whose square holds the glyphs' padded area, so the atlas usually
+comes out wider than it is tall. if the glyphs don't fit in MAX_ATLAS_DIMS rows
+it tries twice the width. sets each glyph's atlas_x and atlas_y */
+static bool pack_glyphs( glyph_t* glyphs, int n_glyphs, int pad, int* atlas_width, int* atlas_height ) {
+  int* order     = (int*)malloc( n_glyphs * sizeof( int ) );
+  int n_order    = 0;
+  long long area = 0;
+  for ( int i = 0; i < n_glyphs; i++ ) {
+    if ( !glyphs[i].bitmap ) { continue; }
+    order[n_order++] = i;
+    area += (long long)( glyphs[i].width + pad ) * ( glyphs[i].height + pad );
+  }
+  g_sort_glyphs = glyphs;
+  qsort( order, n_order, sizeof( int ), compare_glyph_sizes );
+
+  int width = 64;
+  while ( (long long)width * width < area ) { width *= 2; }
+  bool packed = false;
+  for ( ; !packed && width <= MAX_ATLAS_DIMS; width *= 2 ) {
+    /* each glyph takes its size plus pad, with the glyph at the bottom-right of
+    that. the packer is pad smaller so there's pad around the edge too */
+    skyline_packer_t packer;
+    if ( !init_skyline_packer( &packer, width - pad, MAX_ATLAS_DIMS - pad ) ) { break; }
+    packed = true;
+    for ( int i = 0; i < n_order && packed; i++ ) {
+      glyph_t* g = &glyphs[order[i]];
+      packed     = skyline_pack( &packer, g->width + pad, g->height + pad, &g->atlas_x, &g->atlas_y );
+      g->atlas_x += pad;
+      g->atlas_y += pad;
+    }
+    *atlas_width  = width;
+    *atlas_height = ( packer.used_height + pad + 3 ) / 4 * 4;
+    free_skyline_packer( &packer );
+  }
+  free( order );
+  return packed;
+}
+
+/* parses a list like "32-126,0xa0-0xff,8364". returns the number of ranges */
+static int parse_ranges( const char* str, codepoint_range_t* ranges, int max_ranges ) {
+  int n_ranges = 0;
+  while ( *str && n_ranges < max_ranges ) {
+    char* end          = NULL;
+    unsigned int first = (unsigned int)strtoul( str, &end, 0 );
+    unsigned int last  = first;
+    if ( end == str ) { break; }
+    if ( '-' == *end ) { last = (unsigned int)strtoul( end + 1, &end, 0 ); }
+    if ( last > 0x10ffff ) { last = 0x10ffff; }
+    if ( first <= last ) {
+      ranges[n_ranges].first = first;
+      ranges[n_ranges].last  = last;
+      n_ranges++;
+    }
+    str = end;
+    if ( ',' == *str ) { str++; }
+  }
+  return n_ranges;
+}
+
+static bool in_ranges( unsigned long codepoint, const codepoint_range_t* ranges, int n_ranges ) {
+  for ( int r = 0; r < n_ranges; r++ ) {
+    if ( codepoint >= ranges[r].first && codepoint <= ranges[r].last ) { return true; }
+  }
+  return false;
+}
+
+/* lists every codepoint in the ranges that the font has a glyph for, at each
+size, up to max_glyphs. glyphs come out sorted by size, then codepoint. walking
+the font's own character map is quicker than asking about every codepoint in a
+big range, most of which a font won't have */
+static glyph_t* list_glyphs( FT_Face face, const codepoint_range_t* ranges, int n_ranges, const int* sizes, int n_sizes, int max_glyphs, int* n_glyphs ) {
+  int n_per_size      = 0;
+  FT_UInt glyph_index = 0;
+  for ( FT_ULong c = FT_Get_First_Char( face, &glyph_index ); glyph_index; c = FT_Get_Next_Char( face, c, &glyph_index ) ) {
+    if ( in_ranges( c, ranges, n_ranges ) ) { n_per_size++; }
+  }
+  long long n_wanted = (long long)n_per_size * n_sizes;
+  *n_glyphs          = (int)( n_wanted < max_glyphs ? n_wanted : max_glyphs );
+  glyph_t* glyphs    = (glyph_t*)calloc( *n_glyphs > 0 ? *n_glyphs : 1, sizeof( glyph_t ) );
+  int n              = 0;
+  for ( int s = 0; s < n_sizes && n < *n_glyphs; s++ ) {
+    for ( FT_ULong c = FT_Get_First_Char( face, &glyph_index ); glyph_index && n < *n_glyphs; c = FT_Get_Next_Char( face, c, &glyph_index ) ) {
+      if ( !in_ranges( c, ranges, n_ranges ) ) { continue; }
+      glyphs[n].codepoint = (unsigned int)c;
+      glyphs[n].px        = sizes[s];
+      n++;
+    }
+  }
+  return glyphs;
+}
+
+/* renders, packs, and copies the glyphs into a new atlas. returns the atlas,
+with its size, and how long each step took */
+static unsigned char* generate_atlas( const char* font_file, glyph_t* glyphs, int n_glyphs, int pad, int sdf_spread, int n_threads, int* width, int* height, double* times ) {
+  glyph_job_t job;
+  job.font_file  = font_file;
+  job.glyphs     = glyphs;
+  job.n_glyphs   = n_glyphs;
+  job.n_failed   = 0;
+  job.sdf_spread = sdf_spread;
+  double start   = get_seconds();
+  run_threads( n_threads, render_glyphs, &job );
+  times[0] = get_seconds() - start;
+  if ( job.n_failed > 0 ) { fprintf( stderr, "WARNING: could not load %i glyphs\n", (int)job.n_failed ); }
+
+  start = get_seconds();
+  if ( !pack_glyphs( glyphs, n_glyphs, pad, width, height ) ) {
+    fprintf( stderr, "ERROR: glyphs don't fit in a %ix%i atlas\n", MAX_ATLAS_DIMS, MAX_ATLAS_DIMS );
+    return NULL;
+  }
+  times[1] = get_seconds() - start;
+
+  start           = get_seconds();
+  job.atlas       = (unsigned char*)calloc( (size_t)*width * *height, 1 );
+  job.atlas_width = *width;
+  if ( job.atlas ) { run_threads( n_threads, copy_glyphs_to_atlas, &job ); }
+  times[2] = get_seconds() - start;
+  return job.atlas;
+}
+
+static void free_glyph_bitmaps( glyph_t* glyphs, int n_glyphs ) {
+  for ( int i = 0; i < n_glyphs; i++ ) {
+    free( glyphs[i].bitmap );
+    glyphs[i].bitmap = NULL;
+  }
+}
+
+/* how much of the atlas is glyph, with and without the padding around them */
+static void print_efficiency( const glyph_t* glyphs, int n_glyphs, int pad, int width, int height ) {
+  long long glyph_area = 0, padded_area = 0;
+  for ( int i = 0; i < n_glyphs; i++ ) {
+    if ( !glyphs[i].bitmap ) { continue; }
+    glyph_area += (long long)glyphs[i].width * glyphs[i].height;
+    padded_area += (long long)( glyphs[i].width + pad ) * ( glyphs[i].height + pad );
+  }
+  double atlas_area = (double)width * height;
+  printf( "atlas %ix%i R8 (%.1f MB): glyphs fill %.1f%%, %.1f%% with padding\n", width, height, atlas_area / ( 1024.0 * 1024.0 ), 100.0 * glyph_area / atlas_area, 100.0 * padded_area / atlas_area );
+}
+
+/* one distance field atlas stands in for a coverage atlas at every size text is
+drawn at. this adds up the coverage atlases for some common sizes, with the
+same glyphs, and compares them with the distance field atlas at px */
+static void compare_atlas_memory( const char* font_file, glyph_t* glyphs, int n_glyphs, int px, int pad, int sdf_spread, int n_threads ) {
+  const int sizes[]        = { 12, 16, 24, 32, 48, 64, 96 };
+  const int n_sizes        = (int)( sizeof( sizes ) / sizeof( sizes[0] ) );
+  long long coverage_bytes = 0;
+  for ( int s = 0; s < n_sizes; s++ ) {
+    for ( int i = 0; i < n_glyphs; i++ ) { glyphs[i].px = sizes[s]; }
+    int width = 0, height = 0;
+    double times[3];
+    unsigned char* atlas = generate_atlas( font_file, glyphs, n_glyphs, pad, 0, n_threads, &width, &height, times );
+    free_glyph_bitmaps( glyphs, n_glyphs );
+    if ( !atlas ) { return; }
+    free( atlas );
+    coverage_bytes += (long long)width * height;
+    printf( "coverage atlas at %2ipx: %5ix%-5i %8.1f KB\n", sizes[s], width, height, width * height / 1024.0 );
+  }
+  for ( int i = 0; i < n_glyphs; i++ ) { glyphs[i].px = px; }
+  int width = 0, height = 0;
+  double times[3];
+  unsigned char* atlas = generate_atlas( font_file, glyphs, n_glyphs, pad, sdf_spread, n_threads, &width, &height, times );
+  free_glyph_bitmaps( glyphs, n_glyphs );
+  if ( !atlas ) { return; }
+  free( atlas );
+  printf( "SDF atlas at %2ipx: %5ix%-5i %8.1f KB\n", px, width, height, width * height / 1024.0 );
+  printf( "%i sizes of coverage take %.1f KB, %.1fx the SDF atlas\n", n_sizes, coverage_bytes / 1024.0, (double)coverage_bytes / ( (double)width * height ) );
+}
+
+/* the metrics go with the atlas image. pixel positions in the atlas are from
+its top-left, as in the PNG. glyphs are already in codepoint order, from the
+font's character map.
+kerning is every pair of the glyphs that the font's 'kern' table moves closer
+or further apart. FreeType only reads that table, not the GPOS kerning of many
+newer OpenType fonts, which would need a shaper like HarfBuzz. it's a lookup per
+pair, but most fonts with a kern table have a few hundred glyphs */
+static bool write_metrics( const char* file_name, FT_Face face, const glyph_t* glyphs, int n_glyphs, int px, int sdf_spread, int width, int height ) {
+  FT_Set_Pixel_Sizes( face, 0, px );
+  font_glyph_t* records   = (font_glyph_t*)calloc( n_glyphs, sizeof( font_glyph_t ) );
+  FT_UInt* indices        = (FT_UInt*)malloc( n_glyphs * sizeof( FT_UInt ) );
+  int max_kerning         = 1024, n_kerning = 0;
+  font_kerning_t* kerning = (font_kerning_t*)malloc( max_kerning * sizeof( font_kerning_t ) );
+  bool has_kerning        = FT_HAS_KERNING( face );
+  if ( !records || !indices || !kerning ) {
+    fprintf( stderr, "ERROR: out of memory for the metrics of %i glyphs\n", n_glyphs );
+    free( records );
+    free( indices );
+    free( kerning );
+    return false;
+  }
+  for ( int i = 0; i < n_glyphs; i++ ) { indices[i] = FT_Get_Char_Index( face, glyphs[i].codepoint ); }
+  for ( int i = 0; i < n_glyphs; i++ ) {
+    const glyph_t* g         = &glyphs[i];
+    records[i].codepoint     = g->codepoint;
+    records[i].atlas_x       = (uint16_t)g->atlas_x;
+    records[i].atlas_y       = (uint16_t)g->atlas_y;
+    records[i].width         = (uint16_t)( g->bitmap ? g->width : 0 );
+    records[i].height        = (uint16_t)( g->bitmap ? g->height : 0 );
+    records[i].left          = (int16_t)g->left;
+    records[i].top           = (int16_t)g->top;
+    records[i].advance       = g->advance;
+    records[i].kerning_first = n_kerning;
+    for ( int j = 0; has_kerning && j < n_glyphs; j++ ) {
+      FT_Vector delta;
+      if ( FT_Get_Kerning( face, indices[i], indices[j], FT_KERNING_UNFITTED, &delta ) || 0 == delta.x ) { continue; }
+      if ( n_kerning == max_kerning ) {
+        font_kerning_t* bigger = (font_kerning_t*)realloc( kerning, 2 * max_kerning * sizeof( font_kerning_t ) );
+        if ( !bigger ) {
+          fprintf( stderr, "ERROR: out of memory for %i kerning pairs\n", 2 * max_kerning );
+          free( records );
+          free( indices );
+          free( kerning );
+          return false;
+        }
+        kerning = bigger;
+        max_kerning *= 2;
+      }
+      kerning[n_kerning].right  = glyphs[j].codepoint;
+      kerning[n_kerning].adjust = delta.x / 64.0f;
+      n_kerning++;
+    }
+    records[i].kerning_count = n_kerning - records[i].kerning_first;
+  }
+
+  font_metrics_header_t header;
+  memset( &header, 0, sizeof( header ) );
+  header.atlas_width  = width;
+  header.atlas_height = height;
+  header.px           = px;
+  header.ascender     = (int32_t)( face->size->metrics.ascender / 64 );
+  header.line_height  = (int32_t)( face->size->metrics.height / 64 );
+  header.sdf_spread   = sdf_spread;
+  header.n_glyphs     = n_glyphs;
+  header.n_kerning    = n_kerning;
+  bool ok             = write_font_metrics( file_name, &header, records, kerning );
+  if ( ok ) { printf( "%i glyphs, %i kerning pairs\n", n_glyphs, n_kerning ); }
+  free( records );
+  free( indices );
+  free( kerning );
+  return ok;
+}
+
+int main( int argc, char** argv ) {
+  const char* font_file   = FONT_FILE_NAME;
+  const char* output_name = OUTPUT_NAME;
+  const char* range_str   = NULL;
+  int px                  = 58; // the 64px slots of the old grid, less padding for outlines
+  int pad                 = 2;
+  int sdf_spread          = 0;
+  int n_threads           = (int)std::thread::hardware_concurrency();
+  bool bench              = false;
+  for ( int i = 1; i < argc; i++ ) {
+    bool has_value = i + 1 < argc;
+    if ( 0 == strcmp( argv[i], "-font" ) && has_value ) {
+      font_file = argv[++i];
+    } else if ( 0 == strcmp( argv[i], "-px" ) && has_value ) {
+      px = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-ranges" ) && has_value ) {
+      range_str = argv[++i];
+    } else if ( 0 == strcmp( argv[i], "-pad" ) && has_value ) {
+      pad = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-threads" ) && has_value ) {
+      n_threads = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-sdf" ) && has_value ) {
+      sdf_spread = atoi( argv[++i] );
+    } else if ( 0 == strcmp( argv[i], "-out" ) && has_value ) {
+      output_name = argv[++i];
+    } else if ( 0 == strcmp( argv[i], "-bench" ) ) {
+      bench = true;
+    } else {
+      fprintf( stderr, "unknown option %s\n", argv[i] );
+      return 1;
+    }
+  }
+  if ( n_threads < 1 ) { n_threads = 1; }
+  if ( px < 1 ) { px = 1; }
+  if ( pad < 0 ) { pad = 0; }
+  if ( sdf_spread < 0 ) { sdf_spread = 0; }
+  /* the benchmark uses every glyph in the font unless it's told otherwise */
+  if ( !range_str ) { range_str = bench ? "0-0x10ffff" : "32-255"; }
+  codepoint_range_t ranges[MAX_RANGES];
+  int n_ranges = parse_ranges( range_str, ranges, MAX_RANGES );
+  if ( n_ranges < 1 ) {
+    fprintf( stderr, "ERROR: no codepoint ranges in %s\n", range_str );
+    return 1;
+  }
+
+  // this thread's face is only for looking things up. the threads open their own
   FT_Library ft;
   if ( FT_Init_FreeType( &ft ) ) {
     fprintf( stderr, "Could not init FreeType library\n" );
@@ -32,126 +464,71 @@ int main() {
   }
   // load a font face from a file
   FT_Face face;
-  if ( FT_New_Face( ft, FONT_FILE_NAME, 0, &face ) ) {
-    fprintf( stderr, "Could not open font\n" );
+  if ( FT_New_Face( ft, font_file, 0, &face ) ) {
+    fprintf( stderr, "Could not open font %s\n", font_file );
     return 1;
   }
-  int atlas_dimension_px = 1024;            // atlas size in pixels
-  int atlas_columns      = 16;              // number of glyphs across atlas
-  int padding_px         = 6;               // total space in glyph size for outlines
-  int slot_glyph_size    = 64;              // glyph maximum size in pixels
-  int atlas_glyph_px     = 64 - padding_px; // leave some padding for outlines
-
-  // Next we can open a file stream to write our atlas image to
-  unsigned char* atlas_buffer     = (unsigned char*)malloc( atlas_dimension_px * atlas_dimension_px * 4 * sizeof( unsigned char ) );
-  unsigned int atlas_buffer_index = 0;
-
-  // I'll tell FreeType the maximum size of each glyph in pixels
-  int grows[256];                              // glyph height in pixels
-  int gwidth[256];                             // glyph width in pixels
-  int gpitch[256];                             // bytes per row of pixels
-  int gymin[256];                              // offset for letters that dip below baseline like g and y
-  unsigned char* glyph_buffer[256] = { NULL }; // stored glyph images
-  // set height in pixels width 0 height 48 (48x48)
-  FT_Set_Pixel_Sizes( face, 0, atlas_glyph_px );
-  for ( int i = 33; i < 256; i++ ) {
-    if ( FT_Load_Char( face, i, FT_LOAD_RENDER ) ) {
-      fprintf( stderr, "Could not load character %i\n", i );
-      return 1;
-    }
-    // draw glyph image anti-aliased
-    FT_Render_Glyph( face->glyph, FT_RENDER_MODE_NORMAL );
-    // get dimensions of bitmap
-    grows[i]  = face->glyph->bitmap.rows;
-    gwidth[i] = face->glyph->bitmap.width;
-    gpitch[i] = face->glyph->bitmap.pitch;
-    // copy glyph data into memory because it seems to be overwritten/lost later
-    glyph_buffer[i] = (unsigned char*)malloc( grows[i] * gpitch[i] );
-    memcpy( glyph_buffer[i], face->glyph->bitmap.buffer, face->glyph->bitmap.rows * face->glyph->bitmap.pitch );
-
-    // get y-offset to place glyphs on baseline. this is in the bounding box
-    FT_Glyph glyph; // a handle to the glyph image
-    if ( FT_Get_Glyph( face->glyph, &glyph ) ) {
-      fprintf( stderr, "Could not get glyph handle %i\n", i );
-      return 1;
+
+  int n_glyphs    = 0;
+  glyph_t* glyphs = list_glyphs( face, ranges, n_ranges, &px, 1, 0x110000, &n_glyphs );
+  if ( n_glyphs < 1 ) {
+    fprintf( stderr, "ERROR: the font has no glyphs in %s\n", range_str );
+    return 1;
+  }
+  if ( bench ) {
+    if ( sdf_spread > 0 ) { compare_atlas_memory( font_file, glyphs, n_glyphs, px, pad, sdf_spread, n_threads ); }
+    /* few fonts have 20000 glyphs in the ranges asked for, so the same ones go
+    round again at bigger sizes until there are that many */
+    int sizes[64];
+    int n_codepoints = n_glyphs, n_sizes = 0;
+    for ( ; n_sizes < 64 && n_sizes * n_codepoints < BENCH_GLYPHS; n_sizes++ ) { sizes[n_sizes] = px + n_sizes; }
+    free( glyphs );
+    glyphs = list_glyphs( face, ranges, n_ranges, sizes, n_sizes, BENCH_GLYPHS, &n_glyphs );
+    printf( "%s: %i %s glyphs (%i codepoints at %i sizes from %ipx)\n", font_file, n_glyphs, sdf_spread > 0 ? "SDF" : "coverage", n_codepoints, n_sizes, px );
+    int thread_counts[2] = { 1, n_threads };
+    for ( int t = 0; t < ( n_threads > 1 ? 2 : 1 ); t++ ) {
+      int width            = 0, height = 0;
+      double times[3]      = { 0.0, 0.0, 0.0 };
+      double start         = get_seconds();
+      unsigned char* atlas = generate_atlas( font_file, glyphs, n_glyphs, pad, sdf_spread, thread_counts[t], &width, &height, times );
+      double total_s       = get_seconds() - start;
+      if ( !atlas ) { return 1; }
+      printf( "%i threads: render %8.2fms, pack %8.2fms, copy %8.2fms. total %8.2fms (%.0f glyphs/s)\n", thread_counts[t], times[0] * 1000.0, times[1] * 1000.0, times[2] * 1000.0, total_s * 1000.0, n_glyphs / total_s );
+      if ( 0 == t ) { print_efficiency( glyphs, n_glyphs, pad, width, height ); }
+      free( atlas );
+      free_glyph_bitmaps( glyphs, n_glyphs );
     }
-    // get bbox. "truncated" mode means get dimensions in pixels
-    FT_BBox bbox;
-    FT_Glyph_Get_CBox( glyph, FT_GLYPH_BBOX_TRUNCATE, &bbox );
-    gymin[i] = bbox.yMin;
-  }
-
-  for ( int y = 0; y < atlas_dimension_px; y++ ) {
-    for ( int x = 0; x < atlas_dimension_px; x++ ) {
-      // work out which grid slot[col][row] we are in e.g out of 16x16
-      int col         = x / slot_glyph_size;
-      int row         = y / slot_glyph_size;
-      int order       = row * atlas_columns + col;
-      int glyph_index = order + 32;
-
-      // an actual glyph bitmap exists for these indices
-      if ( glyph_index > 32 && glyph_index < 256 ) {
-        // pixel indices within padded glyph slot area
-        int x_loc = x % slot_glyph_size - padding_px / 2;
-        int y_loc = y % slot_glyph_size - padding_px / 2;
-        // outside of glyph dimensions use a transparent, black pixel (0,0,0,0)
-        if ( x_loc < 0 || y_loc < 0 || x_loc >= gwidth[glyph_index] || y_loc >= grows[glyph_index] ) {
-          atlas_buffer[atlas_buffer_index++] = 0;
-          atlas_buffer[atlas_buffer_index++] = 0;
-          atlas_buffer[atlas_buffer_index++] = 0;
-          atlas_buffer[atlas_buffer_index++] = 0;
-        } else {
-          // this is 1, but it's safer to put it in anyway
-          // int bytes_per_pixel = gwidth[glyph_index] / gpitch[glyph_index];
-          // int bytes_in_glyph = grows[glyph_index] * gpitch[glyph_index];
-          int byte_order_in_glyph = y_loc * gwidth[glyph_index] + x_loc;
-          unsigned char colour[4];
-          colour[0] = colour[1] = colour[2] = colour[3] = glyph_buffer[glyph_index][byte_order_in_glyph];
-          // print byte from glyph
-          atlas_buffer[atlas_buffer_index++] = glyph_buffer[glyph_index][byte_order_in_glyph];
-          atlas_buffer[atlas_buffer_index++] = glyph_buffer[glyph_index][byte_order_in_glyph];
-          atlas_buffer[atlas_buffer_index++] = glyph_buffer[glyph_index][byte_order_in_glyph];
-          atlas_buffer[atlas_buffer_index++] = glyph_buffer[glyph_index][byte_order_in_glyph];
-        }
-        // write black in non-graphical ASCII boxes
-      } else {
-        atlas_buffer[atlas_buffer_index++] = 0;
-        atlas_buffer[atlas_buffer_index++] = 0;
-        atlas_buffer[atlas_buffer_index++] = 0;
-        atlas_buffer[atlas_buffer_index++] = 0;
-      } // endif
-    } // endfor
-  } // endfor
-
-  // write meta-data file to go with atlas image
-  FILE* fp = fopen( ATLAS_META_FILE, "w" );
-  // comment, reminding me what each column is
-  fprintf( fp,
-    "// ascii_code prop_xMin prop_width prop_yMin prop_height "
-    "prop_y_offset\n" );
-  // write an unique line for the 'space' character
-  fprintf( fp, "32 0 %f 0 %f 0\n", 0.5f, 1.0f );
-  // write a line for each regular character
-  for ( int i = 33; i < 256; i++ ) {
-    int order   = i - 32;
-    int col     = order % atlas_columns;
-    int row     = order / atlas_columns;
-    float x_min = (float)( col * slot_glyph_size ) / (float)atlas_dimension_px;
-    float y_min = (float)( row * slot_glyph_size ) / (float)atlas_dimension_px;
-    fprintf( fp, "%i %f %f %f %f %f\n", i, x_min, (float)( gwidth[i] + padding_px ) / (float)slot_glyph_size, y_min, ( grows[i] + padding_px ) / (float)slot_glyph_size,
-      -( (float)padding_px - (float)gymin[i] ) / (float)slot_glyph_size );
-  }
-  fclose( fp );
-  printf( "wrote `%s`\n", ATLAS_META_FILE );
-
-  // free that buffer of glyph info
-  for ( int i = 0; i < 256; i++ ) {
-    if ( NULL != glyph_buffer[i] ) { free( glyph_buffer[i] ); }
-  }
-
-  // use stb_image_write to write directly to png
-  if ( !stbi_write_png( PNG_OUTPUT_IMAGE, atlas_dimension_px, atlas_dimension_px, 4, atlas_buffer, 0 ) ) { fprintf( stderr, "ERROR: could not write file %s\n", PNG_OUTPUT_IMAGE ); }
-  printf( "wrote `%s`\n", PNG_OUTPUT_IMAGE );
-  free( atlas_buffer );
+    free( glyphs );
+    FT_Done_Face( face );
+    FT_Done_FreeType( ft );
+    return 0;
+  }
+
+  int n_in_ranges = 0;
+  for ( int r = 0; r < n_ranges; r++ ) { n_in_ranges += (int)( ranges[r].last - ranges[r].first + 1 ); }
+  printf( "%s: %i glyphs at %ipx in %s. %i codepoints not in the font\n", font_file, n_glyphs, px, range_str, n_in_ranges - n_glyphs );
+  int width            = 0, height = 0;
+  double times[3]      = { 0.0, 0.0, 0.0 };
+  unsigned char* atlas = generate_atlas( font_file, glyphs, n_glyphs, pad, sdf_spread, n_threads, &width, &height, times );
+  if ( !atlas ) { return 1; }
+  printf( "%i threads: render %.2fms, pack %.2fms, copy %.2fms\n", n_threads, times[0] * 1000.0, times[1] * 1000.0, times[2] * 1000.0 );
+  print_efficiency( glyphs, n_glyphs, pad, width, height );
+
+  // write metrics file to go with atlas image
+  char file_name[256];
+  snprintf( file_name, sizeof( file_name ), "%s.metrics", output_name );
+  if ( write_metrics( file_name, face, glyphs, n_glyphs, px, sdf_spread, width, height ) ) { printf( "wrote `%s`\n", file_name ); }
+  // use stb_image_write to write directly to png. 1 channel of coverage or distance
+  snprintf( file_name, sizeof( file_name ), "%s.png", output_name );
+  if ( !stbi_write_png( file_name, width, height, 1, atlas, 0 ) ) {
+    fprintf( stderr, "ERROR: could not write file %s\n", file_name );
+  } else {
+    printf( "wrote `%s`\n", file_name );
+  }
+  free( atlas );
+  free_glyph_bitmaps( glyphs, n_glyphs );
+  free( glyphs );
+  FT_Done_Face( face );
+  FT_Done_FreeType( ft );
   return 0;
 }
@@ -0,0 +1,133 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Signed distance fields for glyphs.                                           |
+\******************************************************************************/
+#include "sdf.h"
+#include <math.h>
+#include <stdlib.h>
+
+/* offset from a pixel to the nearest seed pixel found so far, and its length
+squared, so that it's only worked out when it changes. far is far enough away
+that squaring it can't overflow */
+struct sdf_offset_t {
+  int dx, dy, length_sq;
+};
+#define SDF_FAR 10000
+
+/* takes the neighbour's seed if it is nearer than this pixel's */
+static inline void compare( sdf_offset_t* grid, int stride, int i, int ox, int oy ) {
+  const sdf_offset_t* other = &grid[i + oy * stride + ox];
+  int dx                    = other->dx + ox;
+  int dy                    = other->dy + oy;
+  int length_sq             = dx * dx + dy * dy;
+  if ( length_sq < grid[i].length_sq ) { grid[i] = { dx, dy, length_sq }; }
+}
+
+/* the two sweeps of 8SSEDT. the grid has a border of 1 far pixel all round, so
+neighbours never need bounds checks */
+static void sweep( sdf_offset_t* grid, int width, int height ) {
+  int stride = width + 2;
+  for ( int y = 1; y <= height; y++ ) {
+    for ( int x = 1; x <= width; x++ ) {
+      int i = y * stride + x;
+      compare( grid, stride, i, -1, 0 );
+      compare( grid, stride, i, 0, -1 );
+      compare( grid, stride, i, -1, -1 );
+      compare( grid, stride, i, 1, -1 );
+    }
+    for ( int x = width; x >= 1; x-- ) { compare( grid, stride, y * stride + x, 1, 0 ); }
+  }
+  for ( int y = height; y >= 1; y-- ) {
+    for ( int x = width; x >= 1; x-- ) {
+      int i = y * stride + x;
+      compare( grid, stride, i, 1, 0 );
+      compare( grid, stride, i, 0, 1 );
+      compare( grid, stride, i, -1, 1 );
+      compare( grid, stride, i, 1, 1 );
+    }
+    for ( int x = 1; x <= width; x++ ) { compare( grid, stride, y * stride + x, -1, 0 ); }
+  }
+}
+
+/* rounds towards -infinity, unlike /, for offsets left of or below the pen */
+static int floor_div( int a, int b ) { return a >= 0 ? a / b : -( ( -a + b - 1 ) / b ); }
+
+unsigned char* make_glyph_sdf( const unsigned char* coverage, int pitch, int upscale, int spread, int* width, int* height, int* left, int* top ) {
+  /* the field's pixels line up with every upscale'th pixel from the pen, and it
+  reaches spread past the glyph on every side */
+  int big_width    = *width, big_height = *height;
+  int field_left   = floor_div( *left, upscale ) - spread;
+  int field_right  = -floor_div( -( *left + big_width ), upscale ) + spread;
+  int field_top    = -floor_div( -*top, upscale ) + spread;
+  int field_bottom = floor_div( *top - big_height, upscale ) - spread;
+  int field_width  = field_right - field_left;
+  int field_height = field_top - field_bottom;
+
+  /* one grid for the offsets to the nearest inside pixel and one for the nearest
+  outside, both over the whole field at the big size */
+  int grid_width        = field_width * upscale;
+  int grid_height       = field_height * upscale;
+  int stride            = grid_width + 2;
+  size_t grid_pixels    = (size_t)stride * ( grid_height + 2 );
+  sdf_offset_t* inside  = (sdf_offset_t*)malloc( grid_pixels * sizeof( sdf_offset_t ) );
+  sdf_offset_t* outside = (sdf_offset_t*)malloc( grid_pixels * sizeof( sdf_offset_t ) );
+  unsigned char* field  = (unsigned char*)malloc( (size_t)field_width * field_height );
+  if ( !inside || !outside || !field ) {
+    free( inside );
+    free( outside );
+    free( field );
+    return NULL;
+  }
+  const sdf_offset_t far  = { SDF_FAR, SDF_FAR, 2 * SDF_FAR * SDF_FAR };
+  const sdf_offset_t here = { 0, 0, 0 };
+  int x_offset            = *left - field_left * upscale;
+  int y_offset            = field_top * upscale - *top;
+  for ( int y = 0; y < grid_height + 2; y++ ) {
+    for ( int x = 0; x < stride; x++ ) {
+      int cx                  = x - 1 - x_offset;
+      int cy                  = y - 1 - y_offset;
+      bool edge               = x == 0 || y == 0 || x == stride - 1 || y == grid_height + 1;
+      bool in                 = !edge && cx >= 0 && cy >= 0 && cx < big_width && cy < big_height && coverage[cy * pitch + cx] >= 128;
+      inside[y * stride + x]  = in ? here : far;
+      outside[y * stride + x] = in || edge ? far : here;
+    }
+  }
+  sweep( inside, grid_width, grid_height );
+  sweep( outside, grid_width, grid_height );
+
+  /* each field pixel's distance is from the middle of its block of big pixels.
+  the outline is half a pixel from the centre of a pixel next to it */
+  int c0         = ( upscale - 1 ) / 2;
+  int c1         = upscale / 2;
+  float to_field = 1.0f / ( 4.0f * upscale );
+  float to_texel = 127.5f / spread;
+  for ( int fy = 0; fy < field_height; fy++ ) {
+    for ( int fx = 0; fx < field_width; fx++ ) {
+      float sum = 0.0f;
+      for ( int s = 0; s < 4; s++ ) {
+        int i = ( fy * upscale + ( s & 1 ? c1 : c0 ) + 1 ) * stride + fx * upscale + ( s & 2 ? c1 : c0 ) + 1;
+        if ( 0 == inside[i].length_sq ) {
+          sum += sqrtf( (float)outside[i].length_sq ) - 0.5f;
+        } else {
+          sum -= sqrtf( (float)inside[i].length_sq ) - 0.5f;
+        }
+      }
+      float value                  = 127.5f + sum * to_field * to_texel;
+      value                        = value < 0.0f ? 0.0f : ( value > 255.0f ? 255.0f : value );
+      field[fy * field_width + fx] = (unsigned char)( value + 0.5f );
+    }
+  }
+  free( inside );
+  free( outside );
+  *width  = field_width;
+  *height = field_height;
+  *left   = field_left;
+  *top    = field_top;
+  return field;
+}
@@ -0,0 +1,34 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Signed distance fields for glyphs.                                           |
+| Instead of coverage, each texel stores how far its centre is from the        |
+| glyph's outline, 0.5 on the outline and more inside. Bilinear filtering of   |
+| distances stays close to the true distance, so the outline can be found      |
+| again at any scale with a threshold in the fragment shader, and one small    |
+| atlas draws sharp text at every size.                                        |
+| The distances come from 8SSEDT (8-point sequential signed Euclidean          |
+| distance transform): two sweeps over the image, each pixel taking the offset |
+| to the nearest seed from a neighbour that has already been visited. It is    |
+| linear in the number of pixels and very nearly exact. The glyph is rendered  |
+| several times bigger than wanted, so that the outline is found to a fraction |
+| of a pixel, then the field is sampled down.                                  |
+\******************************************************************************/
+#ifndef _SDF_H_
+#define _SDF_H_
+
+/* makes the distance field of a glyph rendered upscale times bigger than the
+field is wanted. anything with at least half coverage is inside. spread is how
+many pixels of the field either side of the outline get distances before they
+saturate, and the field is that much bigger than the glyph all round.
+width, height, left and top go in as the big coverage bitmap's size and offset
+from the pen, with up +, and come out as the field's. returns a malloc'd field,
+or NULL if there's no memory */
+unsigned char* make_glyph_sdf( const unsigned char* coverage, int pitch, int upscale, int spread, int* width, int* height, int* left, int* top );
+
+#endif
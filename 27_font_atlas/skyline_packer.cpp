@@ -0,0 +1,95 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Skyline rectangle packer.                                                    |
+\******************************************************************************/
+#include "skyline_packer.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool init_skyline_packer( skyline_packer_t* packer, int width, int height ) {
+  memset( packer, 0, sizeof( skyline_packer_t ) );
+  /* every rectangle adds at most one node, and it can't be less than 1 wide */
+  packer->max_nodes = width + 1;
+  packer->nodes     = (skyline_node_t*)malloc( packer->max_nodes * sizeof( skyline_node_t ) );
+  if ( !packer->nodes ) { return false; }
+  packer->width    = width;
+  packer->height   = height;
+  packer->nodes[0] = { 0, 0, width };
+  packer->n_nodes  = 1;
+  return true;
+}
+
+void free_skyline_packer( skyline_packer_t* packer ) {
+  free( packer->nodes );
+  memset( packer, 0, sizeof( skyline_packer_t ) );
+}
+
+/* the y a rectangle would rest at if its left edge were at node i's, or -1 if
+it goes off the right or the top */
+static int fit_at_node( const skyline_packer_t* packer, int i, int width, int height ) {
+  int x = packer->nodes[i].x;
+  if ( x + width > packer->width ) { return -1; }
+  int y          = 0;
+  int width_left = width;
+  for ( ; width_left > 0; i++ ) {
+    if ( packer->nodes[i].y > y ) { y = packer->nodes[i].y; }
+    if ( y + height > packer->height ) { return -1; }
+    width_left -= packer->nodes[i].width;
+  }
+  return y;
+}
+
+bool skyline_pack( skyline_packer_t* packer, int width, int height, int* x, int* y ) {
+  int best_i = -1, best_top = INT_MAX, best_width = INT_MAX, best_y = 0;
+  for ( int i = 0; i < packer->n_nodes; i++ ) {
+    int fit_y = fit_at_node( packer, i, width, height );
+    if ( fit_y < 0 ) { continue; }
+    int top = fit_y + height;
+    if ( top < best_top || ( top == best_top && packer->nodes[i].width < best_width ) ) {
+      best_i     = i;
+      best_top   = top;
+      best_width = packer->nodes[i].width;
+      best_y     = fit_y;
+    }
+  }
+  if ( best_i < 0 || packer->n_nodes >= packer->max_nodes ) { return false; }
+  *x = packer->nodes[best_i].x;
+  *y = best_y;
+
+  /* the rectangle's top becomes a new node, and the nodes it covers shrink or go */
+  memmove( &packer->nodes[best_i + 1], &packer->nodes[best_i], ( packer->n_nodes - best_i ) * sizeof( skyline_node_t ) );
+  packer->nodes[best_i] = { *x, best_top, width };
+  packer->n_nodes++;
+  int right = *x + width;
+  int i     = best_i + 1;
+  while ( i < packer->n_nodes && packer->nodes[i].x < right ) {
+    int node_right = packer->nodes[i].x + packer->nodes[i].width;
+    if ( node_right <= right ) {
+      memmove( &packer->nodes[i], &packer->nodes[i + 1], ( packer->n_nodes - i - 1 ) * sizeof( skyline_node_t ) );
+      packer->n_nodes--;
+    } else {
+      packer->nodes[i].x     = right;
+      packer->nodes[i].width = node_right - right;
+      break;
+    }
+  }
+  /* neighbours at the same height join up */
+  for ( i = 0; i + 1 < packer->n_nodes; ) {
+    if ( packer->nodes[i].y == packer->nodes[i + 1].y ) {
+      packer->nodes[i].width += packer->nodes[i + 1].width;
+      memmove( &packer->nodes[i + 1], &packer->nodes[i + 2], ( packer->n_nodes - i - 2 ) * sizeof( skyline_node_t ) );
+      packer->n_nodes--;
+    } else {
+      i++;
+    }
+  }
+  if ( best_top > packer->used_height ) { packer->used_height = best_top; }
+  return true;
+}
@@ -0,0 +1,39 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Skyline rectangle packer.                                                    |
+| Keeps the outline of the tops of everything packed so far as a list of       |
+| horizontal segments, the "skyline". Each new rectangle goes where its top    |
+| would end up lowest, resting on the skyline (bottom-left rule), and ties go  |
+| to the narrowest segment so that gaps fill up. Space under an overhang is    |
+| lost, but packing glyphs tallest first keeps that small, and it is much      |
+| faster than keeping a list of every free rectangle (maxrects).               |
+| "down" here is towards y = 0, so the first row is at the top of an image.    |
+\******************************************************************************/
+#ifndef _SKYLINE_PACKER_H_
+#define _SKYLINE_PACKER_H_
+
+struct skyline_node_t {
+  int x, y, width;
+};
+
+struct skyline_packer_t {
+  int width, height;
+  skyline_node_t* nodes; // sorted by x, and covering 0 to width with no gaps
+  int n_nodes, max_nodes;
+  int used_height; // the highest top of anything packed
+};
+
+bool init_skyline_packer( skyline_packer_t* packer, int width, int height );
+void free_skyline_packer( skyline_packer_t* packer );
+
+/* finds a place for a width by height rectangle and adds it. false if it
+doesn't fit anywhere */
+bool skyline_pack( skyline_packer_t* packer, int width, int height, int* x, int* y );
+
+#endif
@@ -0,0 +1,217 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Batched text rendering.                                                      |
+\******************************************************************************/
+#include "text_batch.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/* how long to wait for a fence each time before printing a warning - 1s */
+#define TEXT_BATCH_FENCE_TIMEOUT_NS 1000000000
+
+/* the quad's corners come from gl_VertexID, as a triangle strip, so there's no
+vertex buffer apart from the instances */
+static const char* g_text_vs_str =
+  "#version 410\n"
+  "layout (location = 0) in vec2 pos;"
+  "layout (location = 1) in vec2 size;"
+  "layout (location = 2) in vec4 st_rect;"
+  "layout (location = 3) in vec4 colour;"
+  "out vec2 st;"
+  "out vec4 tint;"
+  "void main () {"
+  "  vec2 corner = vec2 (gl_VertexID & 1, gl_VertexID >> 1);"
+  "  st = st_rect.xy + corner * st_rect.zw;"
+  "  tint = colour;"
+  "  gl_Position = vec4 (pos + corner * size, 0.0, 1.0);"
+  "}";
+/* a distance field is 0.5 on the outline. fading over one screen pixel either
+side of it, however much the field is scaled, anti-aliases it */
+static const char* g_text_fs_str =
+  "#version 410\n"
+  "in vec2 st;"
+  "in vec4 tint;"
+  "uniform sampler2D tex;"
+  "uniform bool is_sdf;"
+  "out vec4 frag_colour;"
+  "void main () {"
+  "  vec4 texel = texture (tex, st);"
+  "  if (is_sdf) {"
+  "    float w = fwidth (texel.a);"
+  "    texel.a = smoothstep (0.5 - 0.5 * w, 0.5 + 0.5 * w, texel.a);"
+  "  }"
+  "  frag_colour = texel * tint;"
+  "}";
+
+/* returns 0, after printing the info log, if it doesn't compile */
+static GLuint compile_text_shader( GLenum type, const char* str, const char* name ) {
+  GLuint shader = glCreateShader( type );
+  glShaderSource( shader, 1, &str, NULL );
+  glCompileShader( shader );
+  GLint params = -1;
+  glGetShaderiv( shader, GL_COMPILE_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    char log[2048];
+    glGetShaderInfoLog( shader, sizeof( log ), NULL, log );
+    fprintf( stderr, "ERROR: could not compile text batch %s shader\n%s\n", name, log );
+    glDeleteShader( shader );
+    return 0;
+  }
+  return shader;
+}
+
+static GLuint create_text_programme() {
+  GLuint vs = compile_text_shader( GL_VERTEX_SHADER, g_text_vs_str, "vertex" );
+  if ( !vs ) { return 0; }
+  GLuint fs = compile_text_shader( GL_FRAGMENT_SHADER, g_text_fs_str, "fragment" );
+  if ( !fs ) {
+    glDeleteShader( vs );
+    return 0;
+  }
+  GLuint sp = glCreateProgram();
+  glAttachShader( sp, vs );
+  glAttachShader( sp, fs );
+  glLinkProgram( sp );
+  glDeleteShader( vs );
+  glDeleteShader( fs );
+  GLint params = -1;
+  glGetProgramiv( sp, GL_LINK_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    char log[2048];
+    glGetProgramInfoLog( sp, sizeof( log ), NULL, log );
+    fprintf( stderr, "ERROR: could not link text batch shaders\n%s\n", log );
+    glDeleteProgram( sp );
+    return 0;
+  }
+  return sp;
+}
+
+bool init_text_batch( text_batch_t* batch, int max_glyphs ) {
+  memset( batch, 0, sizeof( text_batch_t ) );
+  batch->sp = create_text_programme();
+  if ( !batch->sp ) { return false; }
+  batch->is_sdf_loc = glGetUniformLocation( batch->sp, "is_sdf" );
+  batch->max_glyphs = max_glyphs;
+  GLsizeiptr total  = (GLsizeiptr)max_glyphs * TEXT_BATCH_FRAMES * sizeof( text_glyph_t );
+
+  glGenBuffers( 1, &batch->vbo );
+  glBindBuffer( GL_ARRAY_BUFFER, batch->vbo );
+  /* drawing from a segment other than the first needs a base instance, which
+  comes with 4.2, so every GL with persistent mapping has it */
+  batch->persistent = GLEW_VERSION_4_4 || ( GLEW_ARB_buffer_storage && GLEW_ARB_base_instance );
+  if ( batch->persistent ) {
+    /* immutable storage is required for persistent mapping. coherent means
+    writes are visible to the GPU without any explicit flushing */
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage( GL_ARRAY_BUFFER, total, NULL, flags );
+    batch->ptr = (text_glyph_t*)glMapBufferRange( GL_ARRAY_BUFFER, 0, total, flags );
+  } else {
+    glBufferData( GL_ARRAY_BUFFER, (GLsizeiptr)max_glyphs * sizeof( text_glyph_t ), NULL, GL_STREAM_DRAW );
+    batch->ptr = (text_glyph_t*)malloc( total );
+  }
+  if ( !batch->ptr ) {
+    fprintf( stderr, "ERROR: could not map or allocate a text batch of %i glyphs\n", max_glyphs );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    free_text_batch( batch );
+    return false;
+  }
+
+  glGenVertexArrays( 1, &batch->vao );
+  glBindVertexArray( batch->vao );
+  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( text_glyph_t ), (GLvoid*)offsetof( text_glyph_t, pos ) );
+  glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, sizeof( text_glyph_t ), (GLvoid*)offsetof( text_glyph_t, size ) );
+  glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, sizeof( text_glyph_t ), (GLvoid*)offsetof( text_glyph_t, st_rect ) );
+  glVertexAttribPointer( 3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof( text_glyph_t ), (GLvoid*)offsetof( text_glyph_t, colour ) );
+  for ( int i = 0; i < 4; i++ ) {
+    glEnableVertexAttribArray( i );
+    glVertexAttribDivisor( i, 1 );
+  }
+  glBindVertexArray( 0 );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  /* so that the first begin_frame moves on to segment 0 */
+  batch->segment = TEXT_BATCH_FRAMES - 1;
+  printf( "text batch: %i frames x %i glyphs, %s\n", TEXT_BATCH_FRAMES, max_glyphs, batch->persistent ? "persistent mapped" : "glBufferSubData fallback" );
+  return true;
+}
+
+void free_text_batch( text_batch_t* batch ) {
+  for ( int i = 0; i < TEXT_BATCH_FRAMES; i++ ) {
+    if ( batch->fences[i] ) { glDeleteSync( batch->fences[i] ); }
+  }
+  if ( batch->persistent && batch->ptr ) {
+    glBindBuffer( GL_ARRAY_BUFFER, batch->vbo );
+    glUnmapBuffer( GL_ARRAY_BUFFER );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  } else {
+    free( batch->ptr );
+  }
+  if ( batch->sp ) { glDeleteProgram( batch->sp ); }
+  glDeleteBuffers( 1, &batch->vbo );
+  glDeleteVertexArrays( 1, &batch->vao );
+  memset( batch, 0, sizeof( text_batch_t ) );
+}
+
+void text_batch_begin_frame( text_batch_t* batch ) {
+  batch->segment   = ( batch->segment + 1 ) % TEXT_BATCH_FRAMES;
+  batch->n_glyphs  = 0;
+  batch->n_dropped = 0;
+  GLsync fence     = batch->fences[batch->segment];
+  if ( !fence ) { return; }
+  /* usually signalled already, TEXT_BATCH_FRAMES - 1 frames later */
+  GLenum result = glClientWaitSync( fence, 0, 0 );
+  if ( GL_TIMEOUT_EXPIRED == result ) {
+    batch->n_fence_waits++;
+    do {
+      result = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, TEXT_BATCH_FENCE_TIMEOUT_NS );
+      if ( GL_TIMEOUT_EXPIRED == result ) { fprintf( stderr, "WARNING: waited over 1s for text batch fence\n" ); }
+    } while ( GL_TIMEOUT_EXPIRED == result );
+  }
+  if ( GL_WAIT_FAILED == result ) { fprintf( stderr, "ERROR: glClientWaitSync failed on text batch\n" ); }
+  glDeleteSync( fence );
+  batch->fences[batch->segment] = 0;
+}
+
+text_glyph_t* text_batch_alloc( text_batch_t* batch, int n ) {
+  if ( batch->n_glyphs + n > batch->max_glyphs ) {
+    batch->n_dropped += n;
+    return NULL;
+  }
+  text_glyph_t* glyphs = batch->ptr + batch->segment * batch->max_glyphs + batch->n_glyphs;
+  batch->n_glyphs += n;
+  return glyphs;
+}
+
+int text_batch_end_frame( text_batch_t* batch, GLuint tex, bool is_sdf ) {
+  int n     = batch->n_glyphs;
+  int first = batch->segment * batch->max_glyphs;
+  if ( n > 0 ) {
+    glUseProgram( batch->sp );
+    glUniform1i( batch->is_sdf_loc, is_sdf );
+    glActiveTexture( GL_TEXTURE0 );
+    glBindTexture( GL_TEXTURE_2D, tex );
+    glBindVertexArray( batch->vao );
+    if ( batch->persistent ) {
+      glDrawArraysInstancedBaseInstance( GL_TRIANGLE_STRIP, 0, 4, n, first );
+    } else {
+      /* the GL copies the records, so the segment is free again straight away */
+      glBindBuffer( GL_ARRAY_BUFFER, batch->vbo );
+      glBufferSubData( GL_ARRAY_BUFFER, 0, (GLsizeiptr)n * sizeof( text_glyph_t ), batch->ptr + first );
+      glBindBuffer( GL_ARRAY_BUFFER, 0 );
+      glDrawArraysInstanced( GL_TRIANGLE_STRIP, 0, 4, n );
+    }
+    glBindVertexArray( 0 );
+  }
+  if ( batch->persistent ) {
+    assert( !batch->fences[batch->segment] );
+    batch->fences[batch->segment] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+  }
+  return n;
+}
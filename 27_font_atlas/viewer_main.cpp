@@ -8,210 +8,271 @@
 |******************************************************************************|
 | Bitmap Fonts example                                                         |
 | Modified previous font viewer to read the new generated font, loading meta   |
-| data from a file                                                             |
+| data from a file. The atlas is packed tightly, so each glyph's rectangle in  |
+| it, and where to draw it, come from that file rather than a grid             |
+| Run with the name of an atlas to view, e.g. `viewer freemono_sdf`. The       |
+| default is freemono. freemono_sdf is a signed distance field atlas made with |
+| `generate -px 48 -sdf 4 -out freemono_sdf`. It's about the same size as the  |
+| coverage atlas, yet it stays sharp at 190px, where that blurs. FreeMono's    |
+| strokes are thin, and at much less than 48px they break up in the field.     |
+| All of a frame's text is drawn in one batch (text_batch.h). Press B to time  |
+| 10000 strings that change every frame.                                       |
+| The metrics are a binary file (font_metrics.h), mapped straight into memory. |
+| Strings are UTF-8, so any codepoint in the atlas can be drawn, with kerning  |
+| if the font has it. Press L to time laying out a large block of text.        |
 \******************************************************************************/
 #include "maths_funcs.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"  // Sean Barrett's image loader
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h> // GLFW helper library
+#include "font_metrics.h"
+#include "text_batch.h"
+#include "texture_loader.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define ATLAS_IMAGE "freemono.png"
-#define ATLAS_META "freemono.meta"
-// size of atlas. my handmade image is 16x16 glyphs
-#define ATLAS_COLS 16
-#define ATLAS_ROWS 16
+#define ATLAS_NAME "freemono"
+/* the most glyphs the demo draws in a frame */
+#define MAX_GLYPHS 1024
+#define BENCH_STRINGS 10000
+#define BENCH_FRAMES 10
+#define BENCH_LAYOUT_GLYPHS 1000000
+#define BENCH_LAYOUT_LINE 80
 
 int g_viewport_width  = 800;
 int g_viewport_height = 480;
 
-GLuint sp;                 // shader programme
-GLuint sp_text_colour_loc; // location of vec4 "text_colour" uniform
+font_metrics_t font_metrics;
 
-float glyph_y_offsets[256] = { 0.0f };
-float glyph_widths[256]    = { 0.0f };
-
-/* load meta data file for font. we really only need the ascii value, width,
-height, and y_offset, but if you want to be super precise you have the other
-adjustment values there too */
-bool load_meta_data( const char* meta_file ) {
-  FILE* fp = fopen( meta_file, "r" );
-  if ( !fp ) {
-    fprintf( stderr, "ERROR: could not open file %s\n", meta_file );
-    return false;
-  }
-  char line[128];
-  int ascii_code      = -1;
-  float prop_xMin     = 0.0f;
-  float prop_width    = 0.0f;
-  float prop_yMin     = 0.0f;
-  float prop_height   = 0.0f;
-  float prop_y_offset = 0.0f;
-  // get header line first
-  fgets( line, 128, fp );
-  // loop through and get each glyph's info
-  while ( EOF != fscanf( fp, "%i %f %f %f %f %f\n", &ascii_code, &prop_xMin, &prop_width, &prop_yMin, &prop_height, &prop_y_offset ) ) {
-    glyph_widths[ascii_code]    = prop_width;
-    glyph_y_offsets[ascii_code] = 1.0 - prop_height - prop_y_offset;
-  }
-  fclose( fp );
-  return true;
+/* UTF-8 is decoded as one codepoint for each byte that isn't a continuation
+byte (10xxxxxx), so counting those says how many glyph records a string needs */
+int count_codepoints( const char* str ) {
+  int n = 0;
+  for ( ; *str; str++ ) { n += 0x80 != ( *str & 0xc0 ); }
+  return n;
 }
 
-void text_to_vbo( const char* str, float at_x, float at_y, float scale_px, GLuint* points_vbo, GLuint* texcoords_vbo, int* point_count ) {
-  int len = strlen( str );
-
-  float* points_tmp    = (float*)malloc( sizeof( float ) * len * 12 );
-  float* texcoords_tmp = (float*)malloc( sizeof( float ) * len * 12 );
-  for ( int i = 0; i < len; i++ ) {
-    // get ascii code as integer
-    int ascii_code = str[i];
-
-    // work out row and column in atlas
-    int atlas_col = ( ascii_code - ' ' ) % ATLAS_COLS;
-    int atlas_row = ( ascii_code - ' ' ) / ATLAS_COLS;
-
-    // work out texture coordinates in atlas
-    float s = atlas_col * ( 1.0 / ATLAS_COLS );
-    float t = ( atlas_row + 1 ) * ( 1.0 / ATLAS_ROWS );
-
-    // work out position of glyphtriangle_width
-    float x_pos = at_x;
-    float y_pos = at_y - scale_px / g_viewport_height * glyph_y_offsets[ascii_code];
+/* decodes the codepoint at str and moves str past it. malformed sequences come
+out as U+FFFD, and stray continuation bytes are skipped */
+uint32_t next_codepoint( const unsigned char** str ) {
+  const unsigned char* p = *str;
+  while ( 0x80 == ( *p & 0xc0 ) ) { p++; }
+  uint32_t lead      = *p++;
+  int n_extra        = lead < 0x80 ? 0 : ( lead < 0xe0 ? 1 : ( lead < 0xf0 ? 2 : 3 ) );
+  uint32_t codepoint = n_extra > 0 ? lead & ( 0x3f >> n_extra ) : lead;
+  int i              = 0;
+  for ( ; i < n_extra && 0x80 == ( *p & 0xc0 ); i++ ) { codepoint = ( codepoint << 6 ) | ( *p++ & 0x3f ); }
+  *str = p;
+  return i == n_extra && lead < 0xf8 ? codepoint : 0xfffd;
+}
 
-    // move next glyph along to the end of this one
-    if ( i + 1 < len ) {
-      // upper-case letters move twice as far
-      at_x += glyph_widths[ascii_code] * scale_px / g_viewport_width;
+/* lays out the first n codepoints of a UTF-8 string as glyph records. at_x,
+at_y is the top-left of the first line, and x_scale and y_scale turn the font's
+pixels into the records' units. new lines start under the first. glyphs the
+font doesn't have get no size and no advance.
+each record goes together here and is copied in whole, because records may be
+write-only memory that is slow to read */
+void layout_text( const char* str, int n, float at_x, float at_y, float x_scale, float y_scale, const GLubyte* colour, text_glyph_t* records ) {
+  const font_metrics_header_t* header = font_metrics.header;
+  float s_scale                       = 1.0f / header->atlas_width;
+  float t_scale                       = 1.0f / header->atlas_height;
+  // at_y is the top of the line. glyphs sit on the baseline below it
+  float x                  = at_x;
+  float baseline           = at_y - header->ascender * y_scale;
+  const font_glyph_t* prev = NULL;
+  const unsigned char* p   = (const unsigned char*)str;
+  for ( int i = 0; i < n; i++ ) {
+    uint32_t codepoint = next_codepoint( &p );
+    text_glyph_t glyph;
+    memset( &glyph, 0, sizeof( glyph ) );
+    memcpy( glyph.colour, colour, sizeof( glyph.colour ) );
+    if ( '\n' == codepoint ) {
+      x = at_x;
+      baseline -= header->line_height * y_scale;
+      prev       = NULL;
+      records[i] = glyph;
+      continue;
     }
-    // add 6 points and texture coordinates to buffers for each glyph
-    points_tmp[i * 12]     = x_pos;
-    points_tmp[i * 12 + 1] = y_pos;
-    points_tmp[i * 12 + 2] = x_pos;
-    points_tmp[i * 12 + 3] = y_pos - scale_px / g_viewport_height;
-    points_tmp[i * 12 + 4] = x_pos + scale_px / g_viewport_width;
-    points_tmp[i * 12 + 5] = y_pos - scale_px / g_viewport_height;
-
-    points_tmp[i * 12 + 6]  = x_pos + scale_px / g_viewport_width;
-    points_tmp[i * 12 + 7]  = y_pos - scale_px / g_viewport_height;
-    points_tmp[i * 12 + 8]  = x_pos + scale_px / g_viewport_width;
-    points_tmp[i * 12 + 9]  = y_pos;
-    points_tmp[i * 12 + 10] = x_pos;
-    points_tmp[i * 12 + 11] = y_pos;
-
-    texcoords_tmp[i * 12]     = s;
-    texcoords_tmp[i * 12 + 1] = 1.0 - t + 1.0 / ATLAS_ROWS;
-    texcoords_tmp[i * 12 + 2] = s;
-    texcoords_tmp[i * 12 + 3] = 1.0 - t;
-    texcoords_tmp[i * 12 + 4] = s + 1.0 / ATLAS_COLS;
-    texcoords_tmp[i * 12 + 5] = 1.0 - t;
+    const font_glyph_t* g = find_glyph( &font_metrics, codepoint );
+    if ( !g ) {
+      records[i] = glyph;
+      continue;
+    }
+    // pairs like "AV" tuck in closer
+    if ( prev ) { x += find_kerning( &font_metrics, prev, codepoint ) * x_scale; }
+    glyph.pos[0]     = x + g->left * x_scale;
+    glyph.pos[1]     = baseline + ( g->top - g->height ) * y_scale;
+    glyph.size[0]    = g->width * x_scale;
+    glyph.size[1]    = g->height * y_scale;
+    glyph.st_rect[0] = g->atlas_x * s_scale;
+    // the image is flipped when loaded, so its top row is at t = 1
+    glyph.st_rect[1] = 1.0f - ( g->atlas_y + g->height ) * t_scale;
+    glyph.st_rect[2] = g->width * s_scale;
+    glyph.st_rect[3] = g->height * t_scale;
+    records[i]       = glyph;
 
-    texcoords_tmp[i * 12 + 6]  = s + 1.0 / ATLAS_COLS;
-    texcoords_tmp[i * 12 + 7]  = 1.0 - t;
-    texcoords_tmp[i * 12 + 8]  = s + 1.0 / ATLAS_COLS;
-    texcoords_tmp[i * 12 + 9]  = 1.0 - t + 1.0 / ATLAS_ROWS;
-    texcoords_tmp[i * 12 + 10] = s;
-    texcoords_tmp[i * 12 + 11] = 1.0 - t + 1.0 / ATLAS_ROWS;
+    // move next glyph along to the end of this one
+    x += g->advance * x_scale;
+    prev = g;
   }
+}
 
-  glBindBuffer( GL_ARRAY_BUFFER, *points_vbo );
-  glBufferData( GL_ARRAY_BUFFER, len * 12 * sizeof( float ), points_tmp, GL_DYNAMIC_DRAW );
-  glBindBuffer( GL_ARRAY_BUFFER, *texcoords_vbo );
-  glBufferData( GL_ARRAY_BUFFER, len * 12 * sizeof( float ), texcoords_tmp, GL_DYNAMIC_DRAW );
+/* lays out a UTF-8 string as glyph records in the frame's text batch. at_x,
+at_y is the top-left of the line, in clip space. returns false if the batch is
+full */
+bool add_text( text_batch_t* batch, const char* str, float at_x, float at_y, float scale_px, const GLubyte* colour ) {
+  int n                 = count_codepoints( str );
+  text_glyph_t* records = text_batch_alloc( batch, n );
+  if ( !records ) { return false; }
+  float px = (float)font_metrics.header->px;
+  layout_text( str, n, at_x, at_y, scale_px / ( px * g_viewport_width ), scale_px / ( px * g_viewport_height ), colour, records );
+  return true;
+}
 
-  free( points_tmp );
-  free( texcoords_tmp );
+/* lays out and draws BENCH_STRINGS strings that change every frame, for a few
+frames, in a batch of their own. the scissor box is 1 pixel, so that the time is
+the text system's and not filling in glyphs */
+void benchmark_text( GLuint tex ) {
+  text_batch_t batch;
+  if ( !init_text_batch( &batch, BENCH_STRINGS * 24 ) ) { return; }
+  glEnable( GL_SCISSOR_TEST );
+  glScissor( 0, 0, 1, 1 );
+  const GLubyte colour[] = { 255, 255, 255, 255 };
+  double add_s           = 0.0, end_s = 0.0, finish_s = 0.0;
+  int n_glyphs           = 0;
+  for ( int frame = 0; frame < BENCH_FRAMES; frame++ ) {
+    glFinish();
+    double start = glfwGetTime();
+    text_batch_begin_frame( &batch );
+    for ( int i = 0; i < BENCH_STRINGS; i++ ) {
+      char str[32];
+      snprintf( str, sizeof( str ), "string %5i: %8.3f", i, start * i );
+      add_text( &batch, str, -1.0f + ( i % 4 ) * 0.5f, 1.0f - ( i / 4 % 100 ) * 0.02f, 12.0f, colour );
+    }
+    double added = glfwGetTime();
+    n_glyphs     = text_batch_end_frame( &batch, tex, font_metrics.header->sdf_spread > 0 );
+    double ended = glfwGetTime();
+    glFinish();
+    add_s += added - start;
+    end_s += ended - added;
+    finish_s += glfwGetTime() - start;
+  }
+  glDisable( GL_SCISSOR_TEST );
+  printf( "%i strings (%i glyphs) per frame, average of %i frames: add %.3fms + end %.3fms, finished %.3fms. %.1fM glyphs/s\n", BENCH_STRINGS, n_glyphs, BENCH_FRAMES, add_s * 1000.0 / BENCH_FRAMES,
+    end_s * 1000.0 / BENCH_FRAMES, finish_s * 1000.0 / BENCH_FRAMES, n_glyphs * BENCH_FRAMES / finish_s / 1e6 );
+  free_text_batch( &batch );
+}
 
-  *point_count = len * 6;
+/* writes a codepoint as UTF-8 and returns how many bytes it took */
+int encode_utf8( uint32_t codepoint, char* out ) {
+  if ( codepoint < 0x80 ) {
+    out[0] = (char)codepoint;
+    return 1;
+  }
+  if ( codepoint < 0x800 ) {
+    out[0] = (char)( 0xc0 | codepoint >> 6 );
+    out[1] = (char)( 0x80 | ( codepoint & 0x3f ) );
+    return 2;
+  }
+  if ( codepoint < 0x10000 ) {
+    out[0] = (char)( 0xe0 | codepoint >> 12 );
+    out[1] = (char)( 0x80 | ( codepoint >> 6 & 0x3f ) );
+    out[2] = (char)( 0x80 | ( codepoint & 0x3f ) );
+    return 3;
+  }
+  out[0] = (char)( 0xf0 | codepoint >> 18 );
+  out[1] = (char)( 0x80 | ( codepoint >> 12 & 0x3f ) );
+  out[2] = (char)( 0x80 | ( codepoint >> 6 & 0x3f ) );
+  out[3] = (char)( 0x80 | ( codepoint & 0x3f ) );
+  return 4;
 }
 
-void create_shaders() {
-  /* here i used negative y from the buffer as the z value so that it was on
-  the floor but also that the 'front' was on the top side. also note how i
-  work out the texture coordinates, st, from the vertex point position */
-  const char* vs_str =
-    "#version 410\n"
-    "layout (location = 0) in vec2 vp;"
-    "layout (location = 1) in vec2 vt;"
-    "out vec2 st;"
-    "void main () {"
-    "  st = vt;"
-    "  gl_Position = vec4 (vp, 0.0, 1.0);"
-    "}";
-  const char* fs_str =
-    "#version 410\n"
-    "in vec2 st;"
-    "uniform sampler2D tex;"
-    "uniform vec4 text_colour;"
-    "out vec4 frag_colour;"
-    "void main () {"
-    "  frag_colour = texture (tex, st) * text_colour;"
-    "}";
-  GLuint vs = glCreateShader( GL_VERTEX_SHADER );
-  glShaderSource( vs, 1, &vs_str, NULL );
-  glCompileShader( vs );
-  int params = -1;
-  glGetShaderiv( vs, GL_COMPILE_STATUS, &params );
-  if ( GL_TRUE != params ) { fprintf( stderr, "ERROR: GL shader index %i did not compile\n", vs ); }
-  GLuint fs = glCreateShader( GL_FRAGMENT_SHADER );
-  glShaderSource( fs, 1, &fs_str, NULL );
-  glCompileShader( fs );
-  glGetShaderiv( fs, GL_COMPILE_STATUS, &params );
-  if ( GL_TRUE != params ) { fprintf( stderr, "ERROR: GL shader index %i did not compile\n", fs ); }
-  sp = glCreateProgram();
-  glAttachShader( sp, vs );
-  glAttachShader( sp, fs );
-  glLinkProgram( sp );
-  glGetProgramiv( sp, GL_LINK_STATUS, &params );
-  if ( GL_TRUE != params ) { fprintf( stderr, "ERROR: could not link shader programme GL index %i\n", sp ); }
-  sp_text_colour_loc = glGetUniformLocation( sp, "text_colour" );
+/* the glyph for a codepoint by binary search of the sorted records, as a file
+without the page table would have to. only for comparison */
+const font_glyph_t* search_glyph( uint32_t codepoint ) {
+  int lo = 0, hi = (int)font_metrics.header->n_glyphs - 1;
+  while ( lo <= hi ) {
+    int mid = ( lo + hi ) / 2;
+    if ( font_metrics.glyphs[mid].codepoint == codepoint ) { return &font_metrics.glyphs[mid]; }
+    if ( font_metrics.glyphs[mid].codepoint < codepoint ) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return NULL;
 }
 
-bool load_texture( const char* file_name, GLuint* tex ) {
-  int x, y, n;
-  int force_channels        = 4;
-  unsigned char* image_data = stbi_load( file_name, &x, &y, &n, force_channels );
-  if ( !image_data ) {
-    fprintf( stderr, "ERROR: could not load %s\n", file_name );
-    return false;
+/* lays out a block of BENCH_LAYOUT_GLYPHS codepoints, every one the font has
+over and over in lines of BENCH_LAYOUT_LINE, into CPU memory. the time covers
+decoding the UTF-8, looking up each glyph and its kerning, and writing records.
+then compares looking the codepoints up in the page table with searching the
+sorted records */
+void benchmark_layout() {
+  const font_metrics_header_t* header = font_metrics.header;
+  char* text                          = (char*)malloc( (size_t)BENCH_LAYOUT_GLYPHS * 4 + 1 );
+  uint32_t* codepoints                = (uint32_t*)malloc( BENCH_LAYOUT_GLYPHS * sizeof( uint32_t ) );
+  text_glyph_t* records               = (text_glyph_t*)malloc( BENCH_LAYOUT_GLYPHS * sizeof( text_glyph_t ) );
+  if ( !text || !codepoints || !records || header->n_glyphs < 1 ) {
+    free( text );
+    free( codepoints );
+    free( records );
+    return;
+  }
+  int len = 0;
+  for ( int i = 0; i < BENCH_LAYOUT_GLYPHS; i++ ) {
+    codepoints[i] = BENCH_LAYOUT_LINE - 1 == i % BENCH_LAYOUT_LINE ? '\n' : font_metrics.glyphs[i % header->n_glyphs].codepoint;
+    len += encode_utf8( codepoints[i], text + len );
+  }
+  text[len] = '\0';
+
+  const GLubyte colour[] = { 255, 255, 255, 255 };
+  double start           = glfwGetTime();
+  int n                  = count_codepoints( text );
+  layout_text( text, n, 0.0f, 0.0f, 1.0f, 1.0f, colour, records );
+  double layout_s = glfwGetTime() - start;
+
+  /* summing the advances stops the lookups being optimised away, and checks that
+  both find the same glyphs */
+  float page_sum = 0.0f, search_sum = 0.0f;
+  start          = glfwGetTime();
+  for ( int i = 0; i < BENCH_LAYOUT_GLYPHS; i++ ) {
+    const font_glyph_t* g = find_glyph( &font_metrics, codepoints[i] );
+    if ( g ) { page_sum += g->advance; }
+  }
+  double page_s = glfwGetTime() - start;
+  start         = glfwGetTime();
+  for ( int i = 0; i < BENCH_LAYOUT_GLYPHS; i++ ) {
+    const font_glyph_t* g = search_glyph( codepoints[i] );
+    if ( g ) { search_sum += g->advance; }
   }
-  // NPOT check
-  if ( ( x & ( x - 1 ) ) != 0 || ( y & ( y - 1 ) ) != 0 ) { fprintf( stderr, "WARNING: texture %s is not power-of-2 dimensions\n", file_name ); }
-  int width_in_bytes    = x * 4;
-  unsigned char* top    = NULL;
-  unsigned char* bottom = NULL;
-  unsigned char temp    = 0;
-  int half_height       = y / 2;
+  double search_s = glfwGetTime() - start;
+
+  printf( "laid out %i codepoints (%.1f KB of UTF-8, %u glyphs in the font, %u kerning pairs) in %.3fms: %.1fM glyphs/s\n", n, len / 1024.0, header->n_glyphs, header->n_kerning, layout_s * 1000.0, n / layout_s / 1e6 );
+  printf( "looking up glyphs: page table %.1fM/s, binary search %.1fM/s%s\n", BENCH_LAYOUT_GLYPHS / page_s / 1e6, BENCH_LAYOUT_GLYPHS / search_s / 1e6,
+    page_sum == search_sum ? "" : ". ERROR: they found different glyphs" );
+  free( text );
+  free( codepoints );
+  free( records );
+}
 
-  for ( int row = 0; row < half_height; row++ ) {
-    top    = image_data + row * width_in_bytes;
-    bottom = image_data + ( y - row - 1 ) * width_in_bytes;
-    for ( int col = 0; col < width_in_bytes; col++ ) {
-      temp    = *top;
-      *top    = *bottom;
-      *bottom = temp;
-      top++;
-      bottom++;
-    }
+/* loads through the texture pipeline, which keeps the image's own number of
+channels, so the single-channel atlas loads as GL_R8. that is read as white,
+with the channel as alpha, so the text shader works the same as with a white
+RGBA atlas */
+bool load_texture( const char* file_name, GLuint* tex ) {
+  texture_image_t image;
+  if ( !load_texture_image( file_name, &image, 0 ) ) { return false; }
+  bool ok = create_texture_from_image( &image, tex );
+  if ( ok && 1 == image.n_channels ) {
+    const GLint white_alpha[] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+    glTexParameteriv( GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, white_alpha );
   }
-  glGenTextures( 1, tex );
-  glActiveTexture( GL_TEXTURE0 );
-  glBindTexture( GL_TEXTURE_2D, *tex );
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data );
-  glGenerateMipmap( GL_TEXTURE_2D );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-  GLfloat max_aniso = 0.0f;
-  glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso );
-  // set the maximum!
-  glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso );
-  return true;
+  free_texture_image( &image );
+  return ok;
 }
 
 /* we will tell GLFW to run this function whenever the window is resized */
@@ -221,7 +282,12 @@ void glfw_framebuffer_size_callback( GLFWwindow* window, int width, int height )
   /* update any perspective matrices used here */
 }
 
-int main() {
+int main( int argc, char** argv ) {
+  const char* atlas_name = argc > 1 ? argv[1] : ATLAS_NAME;
+  char atlas_image[256], atlas_metrics[256];
+  snprintf( atlas_image, sizeof( atlas_image ), "%s.png", atlas_name );
+  snprintf( atlas_metrics, sizeof( atlas_metrics ), "%s.metrics", atlas_name );
+
   // start GL context with helper libraries
   ( glfwInit() );
 
@@ -240,52 +306,18 @@ int main() {
   printf( "Renderer: %s\n", renderer );
   printf( "OpenGL version supported %s\n", version );
 
-  /* load font meta-data (spacings for each glyph) */
-  ( load_meta_data( ATLAS_META ) );
+  /* map the font's metrics (where each glyph is, and its spacing) */
+  if ( !open_font_metrics( atlas_metrics, &font_metrics ) ) { return 1; }
 
-  /* set a string of text for lower-case letters */
-  GLuint first_string_vp_vbo, first_string_vt_vbo, first_string_vao;
-  glGenBuffers( 1, &first_string_vp_vbo );
-  glGenBuffers( 1, &first_string_vt_vbo );
-  float x_pos             = -0.75f;
-  float y_pos             = 0.2f;
-  float pixel_scale       = 190.0f;
-  const char first_str[]  = "abcdefghijklmnopqrstuvwxyz";
-  int first_string_points = 0;
-  text_to_vbo( first_str, x_pos, y_pos, pixel_scale, &first_string_vp_vbo, &first_string_vt_vbo, &first_string_points );
-  glGenVertexArrays( 1, &first_string_vao );
-  glBindVertexArray( first_string_vao );
-  glBindBuffer( GL_ARRAY_BUFFER, first_string_vp_vbo );
-  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 0, NULL );
-  glEnableVertexAttribArray( 0 );
-  glBindBuffer( GL_ARRAY_BUFFER, first_string_vt_vbo );
-  glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, 0, NULL );
-  glEnableVertexAttribArray( 1 );
-
-  /* second string of text for capital letters */
-  GLuint second_string_vp_vbo, second_string_vt_vbo, second_string_vao;
-  glGenBuffers( 1, &second_string_vp_vbo );
-  glGenBuffers( 1, &second_string_vt_vbo );
-  x_pos                    = -1.0f;
-  y_pos                    = 1.0f;
-  pixel_scale              = 70.0f;
-  const char second_str[]  = "The human torch was denied a bank loan!";
-  int second_string_points = 0;
-  text_to_vbo( second_str, x_pos, y_pos, pixel_scale, &second_string_vp_vbo, &second_string_vt_vbo, &second_string_points );
-  glGenVertexArrays( 1, &second_string_vao );
-  glBindVertexArray( second_string_vao );
-  glBindBuffer( GL_ARRAY_BUFFER, second_string_vp_vbo );
-  glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 0, NULL );
-  glEnableVertexAttribArray( 0 );
-  glBindBuffer( GL_ARRAY_BUFFER, second_string_vt_vbo );
-  glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, 0, NULL );
-  glEnableVertexAttribArray( 1 );
-
-  create_shaders();
+  /* all of the text for a frame goes in one batch */
+  text_batch_t text_batch;
+  if ( !init_text_batch( &text_batch, MAX_GLYPHS ) ) { return 1; }
+  const GLubyte first_colour[]  = { 255, 0, 255, 255 };
+  const GLubyte second_colour[] = { 255, 255, 0, 255 };
 
   // textures
   GLuint tex;
-  ( load_texture( ATLAS_IMAGE, &tex ) );
+  ( load_texture( atlas_image, &tex ) );
 
   // rendering defaults
   // glDepthFunc (GL_LESS); // set depth function
@@ -302,29 +334,33 @@ int main() {
     // wipe the drawing surface clear
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
-    // draw
-    glActiveTexture( GL_TEXTURE0 );
-    glBindTexture( GL_TEXTURE_2D, tex );
-    glUseProgram( sp );
-
     /* Draw text with no depth test and alpha blending */
     glDisable( GL_DEPTH_TEST );
     glEnable( GL_BLEND );
 
-    glBindVertexArray( first_string_vao );
-    glUniform4f( sp_text_colour_loc, 1.0, 0.0, 1.0, 1.0 );
-    glDrawArrays( GL_TRIANGLES, 0, first_string_points );
-
-    glBindVertexArray( second_string_vao );
-    glUniform4f( sp_text_colour_loc, 1.0, 1.0, 0.0, 1.0 );
-    glDrawArrays( GL_TRIANGLES, 0, second_string_points );
+    /* a string of text for lower-case letters, and a second for capital letters.
+    laid out again every frame, as if they changed */
+    text_batch_begin_frame( &text_batch );
+    add_text( &text_batch, "abcdefghijklmnopqrstuvwxyz", -0.75f, 0.2f, 190.0f, first_colour );
+    add_text( &text_batch, "The human torch was denied a bank loan!", -1.0f, 1.0f, 70.0f, second_colour );
+    text_batch_end_frame( &text_batch, tex, font_metrics.header->sdf_spread > 0 );
 
     // update other events like input handling
     glfwPollEvents();
     if ( GLFW_PRESS == glfwGetKey( window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( window, 1 ); }
+    static bool b_was_down = false;
+    bool b_is_down         = glfwGetKey( window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) { benchmark_text( tex ); }
+    b_was_down             = b_is_down;
+    static bool l_was_down = false;
+    bool l_is_down         = glfwGetKey( window, GLFW_KEY_L );
+    if ( l_is_down && !l_was_down ) { benchmark_layout(); }
+    l_was_down = l_is_down;
     glfwSwapBuffers( window );
   }
   // done
+  free_text_batch( &text_batch );
+  close_font_metrics( &font_metrics );
   glfwTerminate();
   return 0;
 }
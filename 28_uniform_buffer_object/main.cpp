@@ -9,10 +9,15 @@
 | Cube Maps                                                                    |
 | You can swap the "reflect_vs.glsl" and "reflect_fs.glsl" for the refraction  |
 | versions. Comment one set out and uncomment the other                        |
+| The camera and model matrix uniform blocks are written to a persistently-    |
+| mapped ring buffer every frame - see ubo_ring.h                              |
+| The cube map's faces are decoded at once, with mipmaps - see cube_map.h      |
 \******************************************************************************/
+#include "cube_map.h"    // parallel loading of cube maps, with mipmaps
 #include "gl_utils.h"    // common opengl functions and small utilities like logs
 #include "maths_funcs.h" // my maths functions
 #include "obj_parser.h"  // my little Wavefront .obj mesh loader
+#include "ubo_ring.h"    // ring buffer for uniform blocks
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"  // Sean Barrett's image loader - nothings.org
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
@@ -44,6 +49,16 @@ typedef struct Cam_Vars {
   mat4 V; // 16 floats for my view matrix
 } Cam_Vars;
 
+typedef struct Object_Vars {
+  mat4 M; // 16 floats for the model matrix
+} Object_Vars;
+
+/* uniform block binding points */
+#define CAM_BLOCK_BINDING 0
+#define OBJECT_BLOCK_BINDING 1
+/* most uniform block data we will write in one frame */
+#define UBO_BYTES_PER_FRAME 16384
+
 // keep track of window size for things like the viewport and the mouse cursor
 int g_gl_width       = 640;
 int g_gl_height      = 480;
@@ -76,47 +91,15 @@ GLuint make_big_cube() {
   return vao;
 }
 
-/* use stb_image to load an image file into memory, and then into one side of
-a cube-map texture. */
-bool load_cube_map_side( GLuint texture, GLenum side_target, const char* file_name ) {
-  glBindTexture( GL_TEXTURE_CUBE_MAP, texture );
-
-  int x, y, n;
-  int force_channels        = 4;
-  unsigned char* image_data = stbi_load( file_name, &x, &y, &n, force_channels );
-  if ( !image_data ) {
-    fprintf( stderr, "ERROR: could not load %s\n", file_name );
-    return false;
-  }
-  // non-power-of-2 dimensions check
-  if ( ( x & ( x - 1 ) ) != 0 || ( y & ( y - 1 ) ) != 0 ) { fprintf( stderr, "WARNING: image %s is not power-of-2 dimensions\n", file_name ); }
-
-  // copy image data into 'target' side of cube map
-  glTexImage2D( side_target, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data );
-  free( image_data );
-  return true;
-}
-
-/* load all 6 sides of the cube-map from images, then apply formatting to the
-final texture */
-void create_cube_map( const char* front, const char* back, const char* top, const char* bottom, const char* left, const char* right, GLuint* tex_cube ) {
-  // generate a cube-map texture to hold all the sides
-  glActiveTexture( GL_TEXTURE0 );
-  glGenTextures( 1, tex_cube );
-
-  // load each image and copy into a side of the cube-map texture
-  ( load_cube_map_side( *tex_cube, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, front ) );
-  ( load_cube_map_side( *tex_cube, GL_TEXTURE_CUBE_MAP_POSITIVE_Z, back ) );
-  ( load_cube_map_side( *tex_cube, GL_TEXTURE_CUBE_MAP_POSITIVE_Y, top ) );
-  ( load_cube_map_side( *tex_cube, GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, bottom ) );
-  ( load_cube_map_side( *tex_cube, GL_TEXTURE_CUBE_MAP_NEGATIVE_X, left ) );
-  ( load_cube_map_side( *tex_cube, GL_TEXTURE_CUBE_MAP_POSITIVE_X, right ) );
-  // format cube map texture
-  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+/* load all 6 sides of the cube-map at once, with their mipmaps, through
+cube_map.h. without mipmaps, reflections on the curved monkey alias */
+bool create_cube_map( const char* front, const char* back, const char* top, const char* bottom, const char* left, const char* right, GLuint* tex_cube ) {
+  const char* file_names[] = { right, left, top, bottom, back, front }; // +X -X +Y -Y +Z -Z
+  texture_image_t faces[6];
+  if ( !load_cube_map_faces( file_names, faces, 0 ) ) { return false; }
+  bool ok = create_cube_map_from_faces( faces, tex_cube );
+  for ( int f = 0; f < 6; f++ ) { free_texture_image( &faces[f] ); }
+  return ok;
 }
 
 // camera matrices. it's easier if they are global
@@ -129,12 +112,16 @@ int main() {
   ( restart_gl_log() );
   // start GL context and O/S window using the GLFW helper library
   ( start_gl() );
+  // filter across the edges of cube map faces, or smaller levels show seams
+  glEnable( GL_TEXTURE_CUBE_MAP_SEAMLESS );
 
   /*---------------------------------CUBE
    * MAP-----------------------------------*/
-  GLuint cube_vao = make_big_cube();
-  GLuint cube_map_texture;
+  GLuint cube_vao         = make_big_cube();
+  GLuint cube_map_texture = 0;
+  double load_start       = glfwGetTime();
   create_cube_map( FRONT, BACK, TOP, BOTTOM, LEFT, RIGHT, &cube_map_texture );
+  printf( "cube map loaded in %.1fms\n", ( glfwGetTime() - load_start ) * 1000.0 );
   /*------------------------------create geometry-------------------------------*/
   GLfloat* vp       = NULL; // array of vertex points
   GLfloat* vn       = NULL; // array of vertex normals
@@ -168,8 +155,7 @@ int main() {
   printf( "GL_MAX_UNIFORM_BUFFER_BINDINGS = %i\n", blocks );
 
   // shaders for "Suzanne" mesh
-  GLuint monkey_sp      = create_programme_from_files( MONKEY_VERT_FILE, MONKEY_FRAG_FILE );
-  int monkey_M_location = glGetUniformLocation( monkey_sp, "M" );
+  GLuint monkey_sp = create_programme_from_files( MONKEY_VERT_FILE, MONKEY_FRAG_FILE );
 
   /* NOTE: seems to report V as invalid -1 now. good! */
 
@@ -183,19 +169,19 @@ int main() {
   int cube_V_location = glGetUniformLocation( cube_sp, "cam_R" );
   // int cube_P_location = glGetUniformLocation (cube_sp, "P");
 
-  GLuint cam_block_buffer;
-  glGenBuffers( 1, &cam_block_buffer );
-  glBindBuffer( GL_UNIFORM_BUFFER, cam_block_buffer );
-  glBufferData( GL_UNIFORM_BUFFER, sizeof( mat4 ) * 2, NULL, GL_DYNAMIC_DRAW );
+  /* all the uniform blocks are sub-allocated from one ring buffer, with a
+  segment for each frame in flight */
+  ubo_ring_t ubo_ring;
+  ( init_ubo_ring( &ubo_ring, UBO_BYTES_PER_FRAME ) );
 
   /*
-  Bind the block to each of the shader programmes that will use it
-  THIS IS UNNEEDED WITH JUST A SINGLE BLOCK BUT ALLOWS >1 BLOCKS */
-  int block_id                      = 0;
+  Bind the blocks to each of the shader programmes that will use them */
   GLuint uniform_block_index_monkey = glGetUniformBlockIndex( monkey_sp, "cam_block" );
-  glUniformBlockBinding( monkey_sp, uniform_block_index_monkey, block_id );
+  glUniformBlockBinding( monkey_sp, uniform_block_index_monkey, CAM_BLOCK_BINDING );
   GLuint uniform_block_index_cube_sp = glGetUniformBlockIndex( cube_sp, "cam_block" );
-  glUniformBlockBinding( cube_sp, uniform_block_index_cube_sp, block_id );
+  glUniformBlockBinding( cube_sp, uniform_block_index_cube_sp, CAM_BLOCK_BINDING );
+  GLuint object_block_index_monkey = glGetUniformBlockIndex( monkey_sp, "object_block" );
+  glUniformBlockBinding( monkey_sp, object_block_index_monkey, OBJECT_BLOCK_BINDING );
 
 /*-------------------------------CREATE CAMERA--------------------------------*/
 #define ONE_DEG_IN_RAD ( 2.0 * M_PI ) / 360.0 // 0.017444444
@@ -229,14 +215,6 @@ int main() {
   // unique model matrix for each sphere
   mat4 model_mat = identity_mat4();
 
-  glBindBufferBase( GL_UNIFORM_BUFFER, block_id, cam_block_buffer );
-  Cam_Vars* cam_ubo_ptr = (Cam_Vars*)glMapBufferRange( GL_UNIFORM_BUFFER, 0, sizeof( Cam_Vars ), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
-
-  cam_ubo_ptr->P = proj_mat;
-  cam_ubo_ptr->V = view_mat;
-
-  glUnmapBuffer( GL_UNIFORM_BUFFER );
-
   glEnable( GL_DEPTH_TEST );          // enable depth-testing
   glDepthFunc( GL_LESS );             // depth-testing interprets a smaller value as "closer"
   glEnable( GL_CULL_FACE );           // cull face
@@ -257,6 +235,16 @@ int main() {
     // wipe the drawing surface clear
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
+    /* write this frame's camera block into the ring buffer. this waits if the
+    GPU is still reading the segment from UBO_RING_FRAMES frames ago */
+    ubo_ring_begin_frame( &ubo_ring );
+    GLintptr cam_offset   = 0;
+    Cam_Vars* cam_ubo_ptr = (Cam_Vars*)ubo_ring_alloc( &ubo_ring, sizeof( Cam_Vars ), &cam_offset );
+    assert( cam_ubo_ptr );
+    cam_ubo_ptr->P = proj_mat;
+    cam_ubo_ptr->V = view_mat;
+    ubo_ring_bind( &ubo_ring, CAM_BLOCK_BINDING, cam_offset, sizeof( Cam_Vars ) );
+
     // render a sky-box using the cube-map texture
     glDepthMask( GL_FALSE );
     glUseProgram( cube_sp );
@@ -269,8 +257,15 @@ int main() {
 
     glUseProgram( monkey_sp );
     glBindVertexArray( vao );
-    glUniformMatrix4fv( monkey_M_location, 1, GL_FALSE, model_mat.m );
+    /* each draw can have its own allocation for per-object blocks */
+    GLintptr object_offset      = 0;
+    Object_Vars* object_ubo_ptr = (Object_Vars*)ubo_ring_alloc( &ubo_ring, sizeof( Object_Vars ), &object_offset );
+    assert( object_ubo_ptr );
+    object_ubo_ptr->M = model_mat;
+    ubo_ring_bind( &ubo_ring, OBJECT_BLOCK_BINDING, object_offset, sizeof( Object_Vars ) );
     glDrawArrays( GL_TRIANGLES, 0, g_point_count );
+    /* fence after the last draw that reads this frame's segment */
+    ubo_ring_end_frame( &ubo_ring );
     // update other events like input handling
     glfwPollEvents();
 
@@ -355,21 +350,9 @@ int main() {
       cam_pos = cam_pos + vec3( rgt ) * move.v[0];
       mat4 T  = translate( identity_mat4(), vec3( cam_pos ) );
 
+      /* the camera block picks this up next frame */
       view_mat = inverse( R ) * inverse( T );
 
-      glBindBufferBase( GL_UNIFORM_BUFFER, block_id, cam_block_buffer );
-      float* cam_ubo_ptr = (float*)glMapBufferRange( GL_UNIFORM_BUFFER, 0, sizeof( float ) * 32, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
-      memcpy( &cam_ubo_ptr[0], proj_mat.m, sizeof( float ) * 16 );
-      memcpy( &cam_ubo_ptr[16], view_mat.m, sizeof( float ) * 16 );
-
-      glUnmapBuffer( GL_UNIFORM_BUFFER );
-
-      /*			glBindBufferBase (GL_UNIFORM_BUFFER, block_id,
-         cam_block_buffer);
-                              glBufferSubData (
-                                      GL_UNIFORM_BUFFER, sizeof (mat4), sizeof
-         (mat4), view_mat.m);*/
-
       // cube-map view matrix has rotation, but not translation
       glUseProgram( cube_sp );
       glUniformMatrix4fv( cube_V_location, 1, GL_FALSE, inverse( R ).m );
@@ -380,6 +363,8 @@ int main() {
     glfwSwapBuffers( g_window );
   }
 
+  gl_log( "uniform ring buffer waited on a fence %i times\n", ubo_ring.n_fence_waits );
+  free_ubo_ring( &ubo_ring );
   // close GL context and any other GLFW resources
   glfwTerminate();
   return 0;
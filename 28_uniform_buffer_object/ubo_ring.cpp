@@ -0,0 +1,117 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| A ring buffer for per-frame uniform block data.                              |
+\******************************************************************************/
+#include "ubo_ring.h"
+#include "gl_utils.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+/* how long to wait for a fence each time before logging a warning - 1s */
+#define UBO_RING_FENCE_TIMEOUT_NS 1000000000
+
+bool init_ubo_ring( ubo_ring_t* ring, GLsizeiptr bytes_per_frame ) {
+  memset( ring, 0, sizeof( ubo_ring_t ) );
+  glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ring->alignment );
+  if ( ring->alignment < 1 ) { ring->alignment = 256; }
+  /* round up so that every segment starts on an aligned offset */
+  ring->segment_size = ( bytes_per_frame + ring->alignment - 1 ) / ring->alignment * ring->alignment;
+  GLsizeiptr total   = ring->segment_size * UBO_RING_FRAMES;
+
+  glGenBuffers( 1, &ring->buffer );
+  glBindBuffer( GL_UNIFORM_BUFFER, ring->buffer );
+  ring->persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+  if ( ring->persistent ) {
+    /* immutable storage is required for persistent mapping. coherent means
+    writes are visible to the GPU without any explicit flushing */
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage( GL_UNIFORM_BUFFER, total, NULL, flags );
+    ring->ptr = (unsigned char*)glMapBufferRange( GL_UNIFORM_BUFFER, 0, total, flags );
+    if ( !ring->ptr ) {
+      gl_log_err( "ERROR: could not persistently map uniform ring buffer\n" );
+      return false;
+    }
+  } else {
+    glBufferData( GL_UNIFORM_BUFFER, total, NULL, GL_DYNAMIC_DRAW );
+    ring->ptr = (unsigned char*)malloc( total );
+    if ( !ring->ptr ) {
+      gl_log_err( "ERROR: out of memory for uniform ring buffer\n" );
+      return false;
+    }
+  }
+  glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+  /* so that the first begin_frame moves on to segment 0 */
+  ring->segment = UBO_RING_FRAMES - 1;
+  gl_log( "uniform ring buffer: %i frames x %i bytes, alignment %i, %s\n", UBO_RING_FRAMES, (int)ring->segment_size, ring->alignment,
+    ring->persistent ? "persistent mapped" : "glBufferSubData fallback" );
+  return true;
+}
+
+void free_ubo_ring( ubo_ring_t* ring ) {
+  for ( int i = 0; i < UBO_RING_FRAMES; i++ ) {
+    if ( ring->fences[i] ) { glDeleteSync( ring->fences[i] ); }
+  }
+  if ( ring->persistent ) {
+    glBindBuffer( GL_UNIFORM_BUFFER, ring->buffer );
+    glUnmapBuffer( GL_UNIFORM_BUFFER );
+    glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+  } else {
+    free( ring->ptr );
+  }
+  glDeleteBuffers( 1, &ring->buffer );
+  memset( ring, 0, sizeof( ubo_ring_t ) );
+}
+
+void ubo_ring_begin_frame( ubo_ring_t* ring ) {
+  ring->segment  = ( ring->segment + 1 ) % UBO_RING_FRAMES;
+  ring->head     = 0;
+  ring->n_allocs = 0;
+  ring->n_bytes  = 0;
+  GLsync fence   = ring->fences[ring->segment];
+  if ( !fence ) { return; }
+  /* usually signalled already, UBO_RING_FRAMES - 1 frames later */
+  GLenum result = glClientWaitSync( fence, 0, 0 );
+  if ( GL_TIMEOUT_EXPIRED == result ) {
+    ring->n_fence_waits++;
+    do {
+      result = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, UBO_RING_FENCE_TIMEOUT_NS );
+      if ( GL_TIMEOUT_EXPIRED == result ) { gl_log_err( "WARNING: waited over 1s for uniform ring buffer fence\n" ); }
+    } while ( GL_TIMEOUT_EXPIRED == result );
+  }
+  if ( GL_WAIT_FAILED == result ) { gl_log_err( "ERROR: glClientWaitSync failed on uniform ring buffer\n" ); }
+  glDeleteSync( fence );
+  ring->fences[ring->segment] = 0;
+}
+
+void* ubo_ring_alloc( ubo_ring_t* ring, GLsizeiptr size, GLintptr* offset ) {
+  GLsizeiptr padded = ( size + ring->alignment - 1 ) / ring->alignment * ring->alignment;
+  if ( ring->head + padded > ring->segment_size ) {
+    gl_log_err( "ERROR: uniform ring buffer segment full. asked for %i bytes with %i of %i used\n", (int)size, (int)ring->head, (int)ring->segment_size );
+    return NULL;
+  }
+  *offset = ring->segment * ring->segment_size + ring->head;
+  ring->head += padded;
+  ring->n_allocs++;
+  ring->n_bytes += padded;
+  return ring->ptr + *offset;
+}
+
+void ubo_ring_bind( ubo_ring_t* ring, GLuint binding, GLintptr offset, GLsizeiptr size ) {
+  assert( offset % ring->alignment == 0 );
+  if ( !ring->persistent ) {
+    glBindBuffer( GL_UNIFORM_BUFFER, ring->buffer );
+    glBufferSubData( GL_UNIFORM_BUFFER, offset, size, ring->ptr + offset );
+  }
+  glBindBufferRange( GL_UNIFORM_BUFFER, binding, ring->buffer, offset, size );
+}
+
+void ubo_ring_end_frame( ubo_ring_t* ring ) {
+  assert( !ring->fences[ring->segment] );
+  ring->fences[ring->segment] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+}
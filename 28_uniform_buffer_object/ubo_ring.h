@@ -0,0 +1,60 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| A ring buffer for per-frame uniform block data.                              |
+| One big uniform buffer is split into a segment per frame in flight. The      |
+| buffer is mapped once, persistently, so each frame just writes into its own  |
+| segment with memcpy() and binds the range with glBindBufferRange(). Every    |
+| allocation is padded to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. At the end of a  |
+| frame a fence goes in after that frame's draws, and before a segment is      |
+| written again we wait on its fence, so we never overwrite data that the GPU  |
+| hasn't read yet. Camera, light, bone, or per-object blocks can all share it. |
+|                                                                              |
+| Persistent mapping needs GL 4.4 or ARB_buffer_storage. Without it (e.g. on   |
+| macOS) allocations are written to CPU memory and sent with glBufferSubData() |
+| when bound instead.                                                          |
+\******************************************************************************/
+#ifndef _UBO_RING_H_
+#define _UBO_RING_H_
+
+#include <GL/glew.h>
+
+/* frames that can be in flight at once. triple-buffered */
+#define UBO_RING_FRAMES 3
+
+struct ubo_ring_t {
+  GLuint buffer;
+  /* persistently mapped buffer, or CPU memory if persistent mapping is missing */
+  unsigned char* ptr;
+  bool persistent;
+  GLsizeiptr segment_size; /* bytes available per frame */
+  GLint alignment;         /* GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT */
+  int segment;             /* the current frame's segment */
+  GLsizeiptr head;         /* next free byte in the current segment */
+  GLsync fences[UBO_RING_FRAMES];
+  /* stats */
+  int n_allocs;        /* allocations this frame */
+  GLsizeiptr n_bytes;  /* bytes used this frame, including padding */
+  int n_fence_waits;   /* times the CPU had to wait for the GPU, ever */
+};
+
+/* bytes_per_frame is the most uniform data that one frame will allocate */
+bool init_ubo_ring( ubo_ring_t* ring, GLsizeiptr bytes_per_frame );
+void free_ubo_ring( ubo_ring_t* ring );
+/* moves on to the next segment, waiting for the GPU to finish with it first if
+it hasn't already. call before any allocations in a frame */
+void ubo_ring_begin_frame( ubo_ring_t* ring );
+/* returns somewhere to write `size` bytes of block data, and the offset of
+that data in ring->buffer. returns NULL if this frame's segment is full */
+void* ubo_ring_alloc( ubo_ring_t* ring, GLsizeiptr size, GLintptr* offset );
+/* binds an allocation to a uniform block binding point for the next draws */
+void ubo_ring_bind( ubo_ring_t* ring, GLuint binding, GLintptr offset, GLsizeiptr size );
+/* fences this frame's segment. call after the frame's last draw */
+void ubo_ring_end_frame( ubo_ring_t* ring );
+
+#endif
@@ -35,7 +35,7 @@ set SRC="*.c??"
 
 @echo on
 
-cl %CFLAGS% %SRC% %INCLUDES% /link %LFLAGS% %LIBS% /OUT:"particles.exe" 
+cl %CFLAGS% /arch:AVX %SRC% %INCLUDES% /link %LFLAGS% %LIBS% /OUT:"particles.exe" 
 
 copy %DLL_PATH_GLEW% .\
 copy %DLL_PATH_GLFW% .\
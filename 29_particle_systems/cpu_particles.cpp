@@ -0,0 +1,511 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Particles simulated on the CPU.                                              |
+\******************************************************************************/
+#include "cpu_particles.h"
+#include "gl_utils.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+/*-----------------------------------SIMD-------------------------------------*/
+/* a few wrappers so the kernels below are written once for both widths */
+#if defined( __AVX__ )
+#include <immintrin.h>
+#define SIMD_WIDTH 8
+typedef __m256 simd_t;
+static inline simd_t simd_set1( float f ) { return _mm256_set1_ps( f ); }
+static inline simd_t simd_load( const float* p ) { return _mm256_load_ps( p ); }
+static inline void simd_store( float* p, simd_t a ) { _mm256_store_ps( p, a ); }
+static inline simd_t simd_add( simd_t a, simd_t b ) { return _mm256_add_ps( a, b ); }
+static inline simd_t simd_mul( simd_t a, simd_t b ) { return _mm256_mul_ps( a, b ); }
+static inline simd_t simd_lt( simd_t a, simd_t b ) { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+static inline simd_t simd_le( simd_t a, simd_t b ) { return _mm256_cmp_ps( a, b, _CMP_LE_OQ ); }
+static inline simd_t simd_and( simd_t a, simd_t b ) { return _mm256_and_ps( a, b ); }
+static inline simd_t simd_select( simd_t mask, simd_t a, simd_t b ) { return _mm256_blendv_ps( b, a, mask ); }
+static inline int simd_mask_bits( simd_t a ) { return _mm256_movemask_ps( a ); }
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define SIMD_WIDTH 4
+typedef __m128 simd_t;
+static inline simd_t simd_set1( float f ) { return _mm_set1_ps( f ); }
+static inline simd_t simd_load( const float* p ) { return _mm_load_ps( p ); }
+static inline void simd_store( float* p, simd_t a ) { _mm_store_ps( p, a ); }
+static inline simd_t simd_add( simd_t a, simd_t b ) { return _mm_add_ps( a, b ); }
+static inline simd_t simd_mul( simd_t a, simd_t b ) { return _mm_mul_ps( a, b ); }
+static inline simd_t simd_lt( simd_t a, simd_t b ) { return _mm_cmplt_ps( a, b ); }
+static inline simd_t simd_le( simd_t a, simd_t b ) { return _mm_cmple_ps( a, b ); }
+static inline simd_t simd_and( simd_t a, simd_t b ) { return _mm_and_ps( a, b ); }
+/* a where mask is set, otherwise b. SSE4.1 has blendv, SSE2 doesn't */
+static inline simd_t simd_select( simd_t mask, simd_t a, simd_t b ) { return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) ); }
+static inline int simd_mask_bits( simd_t a ) { return _mm_movemask_ps( a ); }
+#else
+#define SIMD_WIDTH 1
+#endif
+
+/* alignment of each array. enough for AVX */
+#define ARRAY_ALIGN 32
+/* 8 float arrays for the particles, then 4 for sorting */
+#define N_ARRAYS 12
+
+int cpu_particles_simd_width() { return SIMD_WIDTH; }
+
+/*--------------------------------THREAD POOL---------------------------------*/
+typedef void ( *chunk_func_t )( cpu_particles_t* ps, int chunk, int first, int count );
+
+struct cpu_particle_pool_t {
+  std::thread* threads;
+  int n_threads; /* not counting the caller */
+  std::mutex mutex;
+  std::condition_variable start_cv, done_cv;
+  int generation; /* goes up by one for each job, so workers know to start */
+  int n_working;
+  bool quit;
+  /* the current job. chunks cover first to first + count - 1 */
+  cpu_particles_t* ps;
+  chunk_func_t func;
+  int first, count;
+  std::atomic<int> next_chunk;
+  int n_chunks;
+  /* per-job parameters */
+  float dt, ground_y;
+  float emitter_pos[3], lifetime, max_start_age;
+  float view_z[4]; /* the third row of the view matrix, for depth */
+  int sort_src, shift;
+  float* mapped;
+};
+
+/* takes chunks until there are none left. every thread runs this */
+static void work_on_job( cpu_particle_pool_t* pool ) {
+  while ( true ) {
+    int chunk = pool->next_chunk.fetch_add( 1 );
+    if ( chunk >= pool->n_chunks ) { return; }
+    int first = chunk * CPU_PARTICLES_CHUNK;
+    int count = pool->count - first < CPU_PARTICLES_CHUNK ? pool->count - first : CPU_PARTICLES_CHUNK;
+    pool->func( pool->ps, chunk, pool->first + first, count );
+  }
+}
+
+static void worker_main( cpu_particle_pool_t* pool ) {
+  int seen_generation = 0;
+  while ( true ) {
+    {
+      std::unique_lock<std::mutex> lock( pool->mutex );
+      while ( !pool->quit && pool->generation == seen_generation ) { pool->start_cv.wait( lock ); }
+      if ( pool->quit ) { return; }
+      seen_generation = pool->generation;
+    }
+    work_on_job( pool );
+    std::lock_guard<std::mutex> lock( pool->mutex );
+    if ( 0 == --pool->n_working ) { pool->done_cv.notify_one(); }
+  }
+}
+
+static cpu_particle_pool_t* create_pool( int n_threads ) {
+  cpu_particle_pool_t* pool = new cpu_particle_pool_t;
+  pool->n_threads           = n_threads > 1 ? n_threads - 1 : 0;
+  pool->generation          = 0;
+  pool->n_working           = 0;
+  pool->quit                = false;
+  pool->ps                  = NULL;
+  pool->func                = NULL;
+  pool->first               = 0;
+  pool->count               = 0;
+  pool->n_chunks            = 0;
+  pool->mapped              = NULL;
+  pool->next_chunk.store( 0 );
+  pool->threads = new std::thread[pool->n_threads];
+  for ( int i = 0; i < pool->n_threads; i++ ) { pool->threads[i] = std::thread( worker_main, pool ); }
+  return pool;
+}
+
+static void destroy_pool( cpu_particle_pool_t* pool ) {
+  {
+    std::lock_guard<std::mutex> lock( pool->mutex );
+    pool->quit = true;
+  }
+  pool->start_cv.notify_all();
+  for ( int i = 0; i < pool->n_threads; i++ ) { pool->threads[i].join(); }
+  delete[] pool->threads;
+  delete pool;
+}
+
+/* runs func over first to first + count - 1 a chunk at a time, and returns
+once every chunk is done. the job's parameters must be set first */
+static void run_job( cpu_particles_t* ps, chunk_func_t func, int first, int count ) {
+  cpu_particle_pool_t* pool = ps->pool;
+  if ( count <= 0 ) { return; }
+  {
+    std::lock_guard<std::mutex> lock( pool->mutex );
+    pool->ps       = ps;
+    pool->func     = func;
+    pool->first    = first;
+    pool->count    = count;
+    pool->n_chunks = ( count + CPU_PARTICLES_CHUNK - 1 ) / CPU_PARTICLES_CHUNK;
+    pool->next_chunk.store( 0 );
+    pool->n_working = pool->n_threads;
+    pool->generation++;
+  }
+  pool->start_cv.notify_all();
+  work_on_job( pool );
+  std::unique_lock<std::mutex> lock( pool->mutex );
+  while ( pool->n_working > 0 ) { pool->done_cv.wait( lock ); }
+}
+
+/*---------------------------------KERNELS------------------------------------*/
+/* the same hash as the compute shaders */
+static inline uint32_t hash( uint32_t x ) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+static inline float rand01( uint32_t* state ) {
+  *state = hash( *state );
+  return (float)( *state >> 8 ) / 16777216.0f;
+}
+
+static void emit_chunk( cpu_particles_t* ps, int chunk, int first, int count ) {
+  const cpu_particle_pool_t* pool = ps->pool;
+  uint32_t r                      = hash( (uint32_t)chunk ^ ( ps->seed * 0x9e3779b9u ) );
+  for ( int i = first; i < first + count; i++ ) {
+    ps->px[i] = pool->emitter_pos[0];
+    ps->py[i] = pool->emitter_pos[1];
+    ps->pz[i] = pool->emitter_pos[2];
+    // start velocities. randomly vary x and z components
+    ps->vx[i]   = rand01( &r ) - 0.5f;
+    ps->vy[i]   = 1.0f;
+    ps->vz[i]   = rand01( &r ) - 0.5f;
+    ps->age[i]  = rand01( &r ) * pool->max_start_age;
+    ps->life[i] = pool->lifetime;
+  }
+}
+
+static inline void move_particle( cpu_particles_t* ps, int from, int to ) {
+  ps->px[to]   = ps->px[from];
+  ps->py[to]   = ps->py[from];
+  ps->pz[to]   = ps->pz[from];
+  ps->vx[to]   = ps->vx[from];
+  ps->vy[to]   = ps->vy[from];
+  ps->vz[to]   = ps->vz[from];
+  ps->age[to]  = ps->age[from];
+  ps->life[to] = ps->life[from];
+}
+
+/* moves and ages a chunk, then swap-removes its dead particles so that its
+survivors are at the front of it. chunks start on a multiple of the SIMD
+width, and the arrays are padded so the last one can run over the end */
+static void update_chunk( cpu_particles_t* ps, int chunk, int first, int count ) {
+  const cpu_particle_pool_t* pool = ps->pool;
+  float dt                        = pool->dt;
+  float ground_y                  = pool->ground_y;
+  int end                         = first + count;
+#if SIMD_WIDTH > 1
+  simd_t dt_v     = simd_set1( dt );
+  simd_t gdt_v    = simd_set1( -1.0f * dt ); // gravity
+  simd_t ground_v = simd_set1( ground_y );
+  simd_t zero_v   = simd_set1( 0.0f );
+  simd_t bounce_v = simd_set1( -0.5f );
+  simd_t drag_v   = simd_set1( 0.8f );
+  for ( int i = first; i < end; i += SIMD_WIDTH ) {
+    simd_t vx = simd_load( &ps->vx[i] );
+    simd_t vy = simd_add( simd_load( &ps->vy[i] ), gdt_v );
+    simd_t vz = simd_load( &ps->vz[i] );
+    simd_t px = simd_add( simd_load( &ps->px[i] ), simd_mul( vx, dt_v ) );
+    simd_t py = simd_add( simd_load( &ps->py[i] ), simd_mul( vy, dt_v ) );
+    simd_t pz = simd_add( simd_load( &ps->pz[i] ), simd_mul( vz, dt_v ) );
+    // bounce off the ground, losing half the speed and some sideways drift
+    simd_t hit = simd_and( simd_lt( py, ground_v ), simd_lt( vy, zero_v ) );
+    py         = simd_select( hit, ground_v, py );
+    vy         = simd_select( hit, simd_mul( vy, bounce_v ), vy );
+    vx         = simd_select( hit, simd_mul( vx, drag_v ), vx );
+    vz         = simd_select( hit, simd_mul( vz, drag_v ), vz );
+    simd_store( &ps->px[i], px );
+    simd_store( &ps->py[i], py );
+    simd_store( &ps->pz[i], pz );
+    simd_store( &ps->vx[i], vx );
+    simd_store( &ps->vy[i], vy );
+    simd_store( &ps->vz[i], vz );
+    simd_store( &ps->age[i], simd_add( simd_load( &ps->age[i] ), dt_v ) );
+  }
+#else
+  for ( int i = first; i < end; i++ ) {
+    ps->vy[i] -= dt;
+    ps->px[i] += ps->vx[i] * dt;
+    ps->py[i] += ps->vy[i] * dt;
+    ps->pz[i] += ps->vz[i] * dt;
+    if ( ps->py[i] < ground_y && ps->vy[i] < 0.0f ) {
+      ps->py[i] = ground_y;
+      ps->vy[i] *= -0.5f;
+      ps->vx[i] *= 0.8f;
+      ps->vz[i] *= 0.8f;
+    }
+    ps->age[i] += dt;
+  }
+#endif
+
+  /* most particles live, so whole registers of survivors are skipped with one
+  compare. only a register with a dead particle in it is looked at one by one */
+  int i = first;
+  while ( i < end ) {
+#if SIMD_WIDTH > 1
+    if ( i + SIMD_WIDTH <= end && 0 == i % SIMD_WIDTH ) {
+      if ( 0 == simd_mask_bits( simd_le( simd_load( &ps->life[i] ), simd_load( &ps->age[i] ) ) ) ) {
+        i += SIMD_WIDTH;
+        continue;
+      }
+    }
+#endif
+    if ( ps->age[i] >= ps->life[i] ) {
+      /* check i again, since the particle moved into it may be dead too */
+      move_particle( ps, --end, i );
+    } else {
+      i++;
+    }
+  }
+  ps->chunk_live[chunk] = end - first;
+}
+
+/* flips a float's bits so that unsigned int order is the same as float order.
+negative numbers flip entirely, so that bigger magnitudes come first, and
+positive numbers just get the sign bit set, so that they come after */
+static inline uint32_t float_sort_key( float f ) {
+  uint32_t u;
+  memcpy( &u, &f, sizeof( u ) );
+  return ( u & 0x80000000u ) ? ~u : u | 0x80000000u;
+}
+
+/* view-space z of a chunk. it's negative in front of the camera, so the
+farthest particles have the smallest keys */
+static void key_chunk( cpu_particles_t* ps, int chunk, int first, int count ) {
+  const float* v = ps->pool->view_z;
+  for ( int i = first; i < first + count; i++ ) {
+    ps->keys[0][i]  = float_sort_key( v[0] * ps->px[i] + v[1] * ps->py[i] + v[2] * ps->pz[i] + v[3] );
+    ps->order[0][i] = (unsigned int)i;
+  }
+}
+
+static void histogram_chunk( cpu_particles_t* ps, int chunk, int first, int count ) {
+  const unsigned int* keys = ps->keys[ps->pool->sort_src];
+  int shift                = ps->pool->shift;
+  unsigned int* h          = ps->histograms + chunk * 256;
+  memset( h, 0, 256 * sizeof( unsigned int ) );
+  for ( int i = first; i < first + count; i++ ) { h[( keys[i] >> shift ) & 0xff]++; }
+}
+
+/* copies a chunk's keys and indices to the chunk's place for each digit. the
+histograms have been turned into those places by now */
+static void scatter_chunk( cpu_particles_t* ps, int chunk, int first, int count ) {
+  int src                      = ps->pool->sort_src;
+  int shift                    = ps->pool->shift;
+  const unsigned int* keys_in  = ps->keys[src];
+  const unsigned int* order_in = ps->order[src];
+  unsigned int* keys_out       = ps->keys[1 - src];
+  unsigned int* order_out      = ps->order[1 - src];
+  unsigned int offsets[256];
+  memcpy( offsets, ps->histograms + chunk * 256, sizeof( offsets ) );
+  for ( int i = first; i < first + count; i++ ) {
+    unsigned int o = offsets[( keys_in[i] >> shift ) & 0xff]++;
+    keys_out[o]    = keys_in[i];
+    order_out[o]   = order_in[i];
+  }
+}
+
+/* writes a chunk's vertices into the mapped buffer */
+static void upload_chunk( cpu_particles_t* ps, int chunk, int first, int count ) {
+  float* v                   = ps->pool->mapped + (size_t)first * 4;
+  const unsigned int* sorted = ps->sorted_order;
+  for ( int i = first; i < first + count; i++ ) {
+    int j = sorted ? (int)sorted[i] : i;
+    v[0]  = ps->px[j];
+    v[1]  = ps->py[j];
+    v[2]  = ps->pz[j];
+    v[3]  = ps->age[j] / ps->life[j];
+    v += 4;
+  }
+}
+
+/*--------------------------------PARTICLES-----------------------------------*/
+bool init_cpu_particles( cpu_particles_t* ps, int max_particles, int n_threads ) {
+  memset( ps, 0, sizeof( cpu_particles_t ) );
+  /* room for the last chunk to run up to a whole register past the end */
+  size_t stride  = ( ( (size_t)max_particles + SIMD_WIDTH - 1 ) / SIMD_WIDTH * SIMD_WIDTH * sizeof( float ) + ARRAY_ALIGN - 1 ) / ARRAY_ALIGN * ARRAY_ALIGN;
+  int n_chunks   = ( max_particles + CPU_PARTICLES_CHUNK - 1 ) / CPU_PARTICLES_CHUNK;
+  ps->memory     = malloc( N_ARRAYS * stride + ARRAY_ALIGN );
+  ps->chunk_live = (int*)malloc( ( n_chunks + 1 ) * sizeof( int ) );
+  ps->histograms = (unsigned int*)malloc( ( n_chunks + 1 ) * 256 * sizeof( unsigned int ) );
+  if ( !ps->memory || !ps->chunk_live || !ps->histograms ) {
+    gl_log_err( "ERROR: out of memory for %i CPU particles\n", max_particles );
+    free( ps->memory );
+    free( ps->chunk_live );
+    free( ps->histograms );
+    memset( ps, 0, sizeof( cpu_particles_t ) );
+    return false;
+  }
+  /* zeroed so that the padding at the end of each array is harmless */
+  memset( ps->memory, 0, N_ARRAYS * stride + ARRAY_ALIGN );
+  char* base        = (char*)( ( (uintptr_t)ps->memory + ARRAY_ALIGN - 1 ) & ~( (uintptr_t)ARRAY_ALIGN - 1 ) );
+  float** arrays[8] = { &ps->px, &ps->py, &ps->pz, &ps->vx, &ps->vy, &ps->vz, &ps->age, &ps->life };
+  for ( int i = 0; i < 8; i++ ) { *arrays[i] = (float*)( base + i * stride ); }
+  for ( int i = 0; i < 2; i++ ) {
+    ps->keys[i]  = (unsigned int*)( base + ( 8 + i ) * stride );
+    ps->order[i] = (unsigned int*)( base + ( 10 + i ) * stride );
+  }
+  ps->max_particles = max_particles;
+  ps->seed          = 1;
+  ps->n_threads     = n_threads > 1 ? n_threads : 1;
+  ps->pool          = create_pool( ps->n_threads );
+
+  glGenBuffers( 1, &ps->vbo );
+  glBindBuffer( GL_ARRAY_BUFFER, ps->vbo );
+  glBufferData( GL_ARRAY_BUFFER, (GLsizeiptr)max_particles * 4 * sizeof( float ), NULL, GL_STREAM_DRAW );
+  glGenVertexArrays( 1, &ps->vao );
+  glBindVertexArray( ps->vao );
+  glVertexAttribPointer( 0, 4, GL_FLOAT, GL_FALSE, 0, NULL );
+  glEnableVertexAttribArray( 0 );
+  glBindVertexArray( 0 );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  gl_log( "CPU particles: %i particles, %i MB, SIMD width %i, %i threads\n", max_particles, (int)( N_ARRAYS * stride / ( 1024 * 1024 ) ), SIMD_WIDTH, ps->n_threads );
+  return true;
+}
+
+void free_cpu_particles( cpu_particles_t* ps ) {
+  if ( ps->pool ) { destroy_pool( ps->pool ); }
+  glDeleteBuffers( 1, &ps->vbo );
+  glDeleteVertexArrays( 1, &ps->vao );
+  free( ps->memory );
+  free( ps->chunk_live );
+  free( ps->histograms );
+  memset( ps, 0, sizeof( cpu_particles_t ) );
+}
+
+void set_cpu_particle_threads( cpu_particles_t* ps, int n_threads ) {
+  n_threads = n_threads > 1 ? n_threads : 1;
+  if ( n_threads == ps->n_threads ) { return; }
+  destroy_pool( ps->pool );
+  ps->n_threads = n_threads;
+  ps->pool      = create_pool( n_threads );
+}
+
+void clear_cpu_particles( cpu_particles_t* ps ) {
+  ps->n_particles  = 0;
+  ps->n_uploaded   = 0;
+  ps->sorted_order = NULL;
+}
+
+void emit_cpu_particles( cpu_particles_t* ps, int n, const float* emitter_pos, float lifetime, float max_start_age ) {
+  if ( n > ps->max_particles - ps->n_particles ) { n = ps->max_particles - ps->n_particles; }
+  if ( n <= 0 ) { return; }
+  cpu_particle_pool_t* pool = ps->pool;
+  memcpy( pool->emitter_pos, emitter_pos, 3 * sizeof( float ) );
+  pool->lifetime      = lifetime;
+  pool->max_start_age = max_start_age;
+  run_job( ps, emit_chunk, ps->n_particles, n );
+  ps->n_particles += n;
+  ps->seed++;
+  ps->sorted_order = NULL;
+}
+
+void update_cpu_particles( cpu_particles_t* ps, float dt, float ground_y ) {
+  int n = ps->n_particles;
+  if ( n <= 0 ) { return; }
+  ps->pool->dt       = dt;
+  ps->pool->ground_y = ground_y;
+  run_job( ps, update_chunk, 0, n );
+
+  /* every chunk's survivors are at its front. fill the gaps that are below
+  the new count with survivors from above it, taken from the end */
+  int n_chunks = ( n + CPU_PARTICLES_CHUNK - 1 ) / CPU_PARTICLES_CHUNK;
+  int n_live   = 0;
+  for ( int c = 0; c < n_chunks; c++ ) { n_live += ps->chunk_live[c]; }
+  int hole_chunk = 0, src_chunk = n_chunks - 1;
+  int hole       = ps->chunk_live[0];
+  int src        = src_chunk * CPU_PARTICLES_CHUNK + ps->chunk_live[src_chunk] - 1;
+  while ( true ) {
+    /* the next gap */
+    while ( hole_chunk < n_chunks && hole >= ( hole_chunk + 1 ) * CPU_PARTICLES_CHUNK ) {
+      hole_chunk++;
+      if ( hole_chunk < n_chunks ) { hole = hole_chunk * CPU_PARTICLES_CHUNK + ps->chunk_live[hole_chunk]; }
+    }
+    if ( hole_chunk >= n_chunks || hole >= n_live ) { break; }
+    /* the last survivor not yet moved */
+    while ( src < src_chunk * CPU_PARTICLES_CHUNK ) {
+      src_chunk--;
+      src = src_chunk * CPU_PARTICLES_CHUNK + ps->chunk_live[src_chunk] - 1;
+    }
+    move_particle( ps, src--, hole++ );
+  }
+  ps->n_particles  = n_live;
+  ps->sorted_order = NULL;
+}
+
+void sort_cpu_particles( cpu_particles_t* ps, const float* view_mat ) {
+  int n = ps->n_particles;
+  if ( n <= 0 ) { return; }
+  cpu_particle_pool_t* pool = ps->pool;
+  for ( int i = 0; i < 4; i++ ) { pool->view_z[i] = view_mat[i * 4 + 2]; }
+  run_job( ps, key_chunk, 0, n );
+
+  int n_chunks = ( n + CPU_PARTICLES_CHUNK - 1 ) / CPU_PARTICLES_CHUNK;
+  int src      = 0;
+  for ( int shift = 0; shift < 32; shift += 8 ) {
+    pool->sort_src = src;
+    pool->shift    = shift;
+    run_job( ps, histogram_chunk, 0, n );
+    /* turn the counts into places: all of the keys with a lower digit come
+    first, then the keys with this digit in earlier chunks */
+    unsigned int place = 0;
+    bool all_same      = false;
+    for ( int d = 0; d < 256 && !all_same; d++ ) {
+      unsigned int digit_start = place;
+      for ( int c = 0; c < n_chunks; c++ ) {
+        unsigned int count          = ps->histograms[c * 256 + d];
+        ps->histograms[c * 256 + d] = place;
+        place += count;
+      }
+      all_same = place - digit_start == (unsigned int)n;
+    }
+    /* the keys are already in order of this digit */
+    if ( all_same ) { continue; }
+    run_job( ps, scatter_chunk, 0, n );
+    src = 1 - src;
+  }
+  ps->sorted_order = ps->order[src];
+}
+
+void upload_cpu_particles( cpu_particles_t* ps ) {
+  ps->n_uploaded = ps->n_particles;
+  if ( ps->n_uploaded <= 0 ) { return; }
+  glBindBuffer( GL_ARRAY_BUFFER, ps->vbo );
+  /* invalidating gives a fresh buffer to write to if the GPU is still drawing
+  the last one, rather than waiting for it */
+  ps->pool->mapped = (float*)glMapBufferRange( GL_ARRAY_BUFFER, 0, (GLsizeiptr)ps->n_uploaded * 4 * sizeof( float ), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+  if ( ps->pool->mapped ) {
+    run_job( ps, upload_chunk, 0, ps->n_uploaded );
+    glUnmapBuffer( GL_ARRAY_BUFFER );
+  } else {
+    gl_log_err( "ERROR: could not map the CPU particle vertex buffer\n" );
+    ps->n_uploaded = 0;
+  }
+  ps->pool->mapped = NULL;
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+void draw_cpu_particles( const cpu_particles_t* ps ) {
+  glBindVertexArray( ps->vao );
+  glVertexAttrib4f( 1, 0.0f, 0.0f, 0.0f, 1.0f );
+  glDrawArrays( GL_POINTS, 0, ps->n_uploaded );
+}
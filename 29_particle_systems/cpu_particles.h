@@ -0,0 +1,95 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Particles simulated on the CPU.                                              |
+| The same particles as the compute shader system, for machines without GL     |
+| 4.3, for servers with no GPU at all, and as a reference to check it against. |
+| Particles are stored as a structure of arrays - all the x positions, then    |
+| all the y positions, etc. - so that 4 (SSE) or 8 (AVX, if compiled with      |
+| -mavx) neighbouring particles load straight into a SIMD register, and        |
+| moving, ageing, and bouncing are done for all of them at once. Without SSE   |
+| they are done one at a time.                                                 |
+| Dead particles are swap-removed: the last live particle is moved into the    |
+| gap, so the live ones stay packed at the front and nothing else moves.       |
+| The arrays are split into chunks that a pool of threads take in turn, the    |
+| calling thread too. Each chunk swap-removes within itself, and the few gaps  |
+| left between chunks are then filled from the end of the array. Emitting and  |
+| writing the vertex buffer are split into chunks in the same way; vertices    |
+| go straight into a mapped buffer rather than through a copy.                 |
+| For blending, the particles can be sorted back to front by a radix sort of   |
+| their view depths, 8 bits a pass. Each chunk counts its digits, the counts   |
+| are added up in chunk order to give every chunk its own place in the output  |
+| for each digit, and then the chunks copy their keys there in parallel. A     |
+| pass is skipped if every key has the same digit, as the top bits of depths   |
+| usually do. The vertex buffer is then written in that order.                 |
+\******************************************************************************/
+#ifndef _CPU_PARTICLES_H_
+#define _CPU_PARTICLES_H_
+
+#include <GL/glew.h>
+
+/* particles per job taken by a thread. a multiple of the SIMD width */
+#define CPU_PARTICLES_CHUNK 16384
+
+/* the threads are hidden away in here */
+struct cpu_particle_pool_t;
+
+struct cpu_particles_t {
+  int max_particles;
+  int n_particles; /* the live ones are 0 to n_particles - 1 */
+  unsigned int seed;
+  /* one array per component, each 32-byte aligned and in one allocation */
+  float *px, *py, *pz;
+  float *vx, *vy, *vz;
+  float *age, *life;
+  void* memory;
+  int* chunk_live; /* survivors of each chunk in the last update */
+  /* depth keys and particle indices for sorting, and in between passes */
+  unsigned int *keys[2], *order[2];
+  unsigned int* histograms; /* 256 digit counts per chunk */
+  /* particle indices back to front, if sorted since the last change */
+  const unsigned int* sorted_order;
+  int n_threads;
+  cpu_particle_pool_t* pool;
+  /* a vec4 per particle: position, then age as a fraction of its life */
+  GLuint vbo, vao;
+  int n_uploaded;
+};
+
+/* n_threads includes the calling thread, so 1 starts no extra threads */
+bool init_cpu_particles( cpu_particles_t* ps, int max_particles, int n_threads );
+void free_cpu_particles( cpu_particles_t* ps );
+/* stops the pool and starts another with a different number of threads */
+void set_cpu_particle_threads( cpu_particles_t* ps, int n_threads );
+
+/* kills every particle */
+void clear_cpu_particles( cpu_particles_t* ps );
+
+/* the same as emit_gpu_particles() */
+void emit_cpu_particles( cpu_particles_t* ps, int n, const float* emitter_pos, float lifetime, float max_start_age );
+
+/* the same as update_gpu_particles() */
+void update_cpu_particles( cpu_particles_t* ps, float dt, float ground_y );
+
+/* sorts the particles by depth from the camera, farthest first, so that
+blending them in that order comes out right. any emit or update unsorts them */
+void sort_cpu_particles( cpu_particles_t* ps, const float* view_mat );
+
+/* writes the live particles into the vertex buffer, in sorted order if they
+are sorted */
+void upload_cpu_particles( cpu_particles_t* ps );
+
+/* draws the uploaded particles as GL_POINTS with whatever programme is in use.
+attribute 0 is the position and age. attribute 1 is left at (0, 0, 0, 1) - a
+lifetime of 1 - so that particles_vs.glsl fades them like the GPU's */
+void draw_cpu_particles( const cpu_particles_t* ps );
+
+/* 8, 4, or 1 if there is no SIMD support */
+int cpu_particles_simd_width();
+
+#endif
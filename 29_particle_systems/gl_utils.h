@@ -41,5 +41,7 @@ bool is_programme_valid( GLuint sp );
 bool create_programme( GLuint vert, GLuint frag, GLuint* programme );
 /* just use this func to create most shaders; give it vertex and frag files */
 GLuint create_programme_from_files( const char* vert_file_name, const char* frag_file_name );
+/* a programme with just a compute shader. 0 if it doesn't compile or link */
+GLuint create_compute_programme( const char* file_name );
 bool load_texture( const char* file_name, GLuint* tex );
 #endif
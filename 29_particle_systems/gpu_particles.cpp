@@ -0,0 +1,198 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Particles simulated by compute shaders.                                      |
+\******************************************************************************/
+#include "gpu_particles.h"
+#include "gl_utils.h"
+#include <string.h>
+#define EMIT_CS "particles_emit_cs.glsl"
+#define PREPARE_CS "particles_prepare_cs.glsl"
+#define UPDATE_CS "particles_update_cs.glsl"
+#define KEYS_CS "particles_keys_cs.glsl"
+
+/* offsets into the state buffer, in GLuints */
+#define STATE_DRAW_CMD_SIZE 4 /* count, instance count, first, base instance */
+#define STATE_DISPATCH_CMD 8  /* x, y, z work groups */
+#define STATE_N_UINTS 11
+
+bool init_gpu_particles( gpu_particles_t* ps, int max_particles ) {
+  memset( ps, 0, sizeof( gpu_particles_t ) );
+  if ( !GLEW_VERSION_4_3 ) {
+    gl_log( "GL 4.3 is not available so there are no compute shader particles\n" );
+    return false;
+  }
+  /* the update is dispatched with a work group per GPU_PARTICLES_GROUP
+  particles, and x is only guaranteed to go up to 65535 groups */
+  GLint max_groups = 0;
+  glGetIntegeri_v( GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &max_groups );
+  if ( max_particles / GPU_PARTICLES_GROUP >= max_groups ) {
+    max_particles = ( max_groups - 1 ) * GPU_PARTICLES_GROUP;
+    gl_log( "particle buffers cut to %i particles by GL_MAX_COMPUTE_WORK_GROUP_COUNT\n", max_particles );
+  }
+  ps->max_particles = max_particles;
+  ps->seed          = 1;
+
+  glGenBuffers( 2, ps->particle_bufs );
+  glGenVertexArrays( 2, ps->vaos );
+  for ( int i = 0; i < 2; i++ ) {
+    glBindBuffer( GL_ARRAY_BUFFER, ps->particle_bufs[i] );
+    glBufferData( GL_ARRAY_BUFFER, (GLsizeiptr)max_particles * sizeof( gpu_particle_t ), NULL, GL_DYNAMIC_COPY );
+    glBindVertexArray( ps->vaos[i] );
+    glVertexAttribPointer( 0, 4, GL_FLOAT, GL_FALSE, sizeof( gpu_particle_t ), NULL );
+    glVertexAttribPointer( 1, 4, GL_FLOAT, GL_FALSE, sizeof( gpu_particle_t ), (GLvoid*)( 4 * sizeof( float ) ) );
+    glEnableVertexAttribArray( 0 );
+    glEnableVertexAttribArray( 1 );
+  }
+  glBindVertexArray( 0 );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+  glGenBuffers( 1, &ps->state_buf );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, ps->state_buf );
+  glBufferData( GL_SHADER_STORAGE_BUFFER, STATE_N_UINTS * sizeof( GLuint ), NULL, GL_DYNAMIC_COPY );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+  clear_gpu_particles( ps );
+
+  ps->emit_sp    = create_compute_programme( EMIT_CS );
+  ps->prepare_sp = create_compute_programme( PREPARE_CS );
+  ps->update_sp  = create_compute_programme( UPDATE_CS );
+  ps->keys_sp    = create_compute_programme( KEYS_CS );
+  if ( !ps->emit_sp || !ps->prepare_sp || !ps->update_sp || !ps->keys_sp ) {
+    free_gpu_particles( ps );
+    return false;
+  }
+  ps->emit_n_loc         = glGetUniformLocation( ps->emit_sp, "n_emit" );
+  ps->emit_seed_loc      = glGetUniformLocation( ps->emit_sp, "seed" );
+  ps->emit_pos_loc       = glGetUniformLocation( ps->emit_sp, "emitter_pos_wor" );
+  ps->emit_lifetime_loc  = glGetUniformLocation( ps->emit_sp, "lifetime" );
+  ps->emit_max_age_loc   = glGetUniformLocation( ps->emit_sp, "max_start_age" );
+  ps->emit_src_loc       = glGetUniformLocation( ps->emit_sp, "src" );
+  ps->emit_max_loc       = glGetUniformLocation( ps->emit_sp, "max_particles" );
+  ps->prepare_src_loc    = glGetUniformLocation( ps->prepare_sp, "src" );
+  ps->prepare_max_loc    = glGetUniformLocation( ps->prepare_sp, "max_particles" );
+  ps->update_dt_loc      = glGetUniformLocation( ps->update_sp, "dt" );
+  ps->update_src_loc     = glGetUniformLocation( ps->update_sp, "src" );
+  ps->update_gravity_loc = glGetUniformLocation( ps->update_sp, "gravity" );
+  ps->update_ground_loc  = glGetUniformLocation( ps->update_sp, "ground_y" );
+  ps->keys_src_loc       = glGetUniformLocation( ps->keys_sp, "src" );
+  ps->keys_view_z_loc    = glGetUniformLocation( ps->keys_sp, "view_z" );
+  gl_log( "compute shader particles: 2 buffers of %i particles, %i MB\n", max_particles, (int)( 2 * (size_t)max_particles * sizeof( gpu_particle_t ) / ( 1024 * 1024 ) ) );
+  return true;
+}
+
+void free_gpu_particles( gpu_particles_t* ps ) {
+  glDeleteBuffers( 2, ps->particle_bufs );
+  glDeleteVertexArrays( 2, ps->vaos );
+  glDeleteBuffers( 1, &ps->state_buf );
+  if ( ps->emit_sp ) { glDeleteProgram( ps->emit_sp ); }
+  if ( ps->prepare_sp ) { glDeleteProgram( ps->prepare_sp ); }
+  if ( ps->update_sp ) { glDeleteProgram( ps->update_sp ); }
+  if ( ps->keys_sp ) { glDeleteProgram( ps->keys_sp ); }
+  memset( ps, 0, sizeof( gpu_particles_t ) );
+}
+
+void clear_gpu_particles( gpu_particles_t* ps ) {
+  /* no particles in either buffer, 1 instance of each draw */
+  GLuint state[STATE_N_UINTS] = { 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 1 };
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, ps->state_buf );
+  glBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, sizeof( state ), state );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+}
+
+void emit_gpu_particles( gpu_particles_t* ps, int n, const float* emitter_pos, float lifetime, float max_start_age ) {
+  if ( n <= 0 ) { return; }
+  if ( n > ps->max_particles ) { n = ps->max_particles; }
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, ps->particle_bufs[ps->src] );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, ps->state_buf );
+  glUseProgram( ps->emit_sp );
+  glUniform1ui( ps->emit_n_loc, (GLuint)n );
+  glUniform1ui( ps->emit_seed_loc, ps->seed++ );
+  glUniform3fv( ps->emit_pos_loc, 1, emitter_pos );
+  glUniform1f( ps->emit_lifetime_loc, lifetime );
+  glUniform1f( ps->emit_max_age_loc, max_start_age );
+  glUniform1ui( ps->emit_src_loc, (GLuint)ps->src );
+  glUniform1ui( ps->emit_max_loc, (GLuint)ps->max_particles );
+  glDispatchCompute( ( n + GPU_PARTICLES_GROUP - 1 ) / GPU_PARTICLES_GROUP, 1, 1 );
+  /* the next step reads the new particles and count */
+  glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+}
+
+void update_gpu_particles( gpu_particles_t* ps, float dt, float ground_y ) {
+  int dst = 1 - ps->src;
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, ps->particle_bufs[ps->src] );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, ps->particle_bufs[dst] );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, ps->state_buf );
+
+  glUseProgram( ps->prepare_sp );
+  glUniform1ui( ps->prepare_src_loc, (GLuint)ps->src );
+  glUniform1ui( ps->prepare_max_loc, (GLuint)ps->max_particles );
+  glDispatchCompute( 1, 1, 1 );
+  /* the dispatch command is read as a command, the live count by the shader */
+  glMemoryBarrier( GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT );
+
+  glUseProgram( ps->update_sp );
+  glUniform1f( ps->update_dt_loc, dt );
+  glUniform1ui( ps->update_src_loc, (GLuint)ps->src );
+  glUniform3f( ps->update_gravity_loc, 0.0f, -1.0f, 0.0f );
+  glUniform1f( ps->update_ground_loc, ground_y );
+  glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, ps->state_buf );
+  glDispatchComputeIndirect( STATE_DISPATCH_CMD * sizeof( GLuint ) );
+  glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, 0 );
+  /* drawn as vertices with a count from the draw command next, and emitted
+  into or updated again after that */
+  glMemoryBarrier( GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT );
+  ps->src = dst;
+}
+
+void draw_gpu_particles( const gpu_particles_t* ps ) {
+  glBindVertexArray( ps->vaos[ps->src] );
+  glBindBuffer( GL_DRAW_INDIRECT_BUFFER, ps->state_buf );
+  glDrawArraysIndirect( GL_POINTS, (const GLvoid*)( ps->src * STATE_DRAW_CMD_SIZE * sizeof( GLuint ) ) );
+  glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+}
+
+void sort_gpu_particles( gpu_particles_t* ps, gpu_sort_t* sort, const float* view_mat ) {
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, ps->particle_bufs[ps->src] );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, ps->state_buf );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 3, sort->key_bufs[0] );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 4, sort->value_bufs[0] );
+  glUseProgram( ps->keys_sp );
+  glUniform1ui( ps->keys_src_loc, (GLuint)ps->src );
+  glUniform4f( ps->keys_view_z_loc, view_mat[2], view_mat[6], view_mat[10], view_mat[14] );
+  /* the last update's dispatch covers at least every particle it kept */
+  glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, ps->state_buf );
+  glDispatchComputeIndirect( STATE_DISPATCH_CMD * sizeof( GLuint ) );
+  glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, 0 );
+  /* the live count is the number of keys. copied on the GPU, so it's never
+  read back */
+  glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT );
+  glBindBuffer( GL_COPY_READ_BUFFER, ps->state_buf );
+  glBindBuffer( GL_COPY_WRITE_BUFFER, sort->state_buf );
+  glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, ps->src * STATE_DRAW_CMD_SIZE * sizeof( GLuint ), GPU_SORT_N * sizeof( GLuint ), sizeof( GLuint ) );
+  glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+  glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+  run_gpu_sort( sort );
+}
+
+void draw_sorted_gpu_particles( const gpu_particles_t* ps, const gpu_sort_t* sort ) {
+  glBindVertexArray( ps->vaos[ps->src] );
+  glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, sort->value_bufs[0] );
+  glBindBuffer( GL_DRAW_INDIRECT_BUFFER, sort->state_buf );
+  glDrawElementsIndirect( GL_POINTS, GL_UNSIGNED_INT, (const GLvoid*)( GPU_SORT_DRAW_CMD * sizeof( GLuint ) ) );
+  glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+}
+
+int count_gpu_particles( const gpu_particles_t* ps ) {
+  GLuint count = 0;
+  glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, ps->state_buf );
+  glGetBufferSubData( GL_SHADER_STORAGE_BUFFER, ps->src * STATE_DRAW_CMD_SIZE * sizeof( GLuint ), sizeof( GLuint ), &count );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+  /* emitting can push the count past the end until the next update clamps it */
+  return (int)count < ps->max_particles ? (int)count : ps->max_particles;
+}
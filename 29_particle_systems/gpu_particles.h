@@ -0,0 +1,89 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Particles simulated by compute shaders (GL 4.3).                             |
+| Each particle's position, velocity, age, and lifetime live in a shader       |
+| storage buffer and carry over from frame to frame, so particles can bounce   |
+| off things and be emitted at any rate. Nothing is read back to the CPU.      |
+| There are two particle buffers. Every frame:                                 |
+|   emit    - new particles are appended to the end of the live buffer         |
+|   prepare - one invocation clamps the live count to the buffer size, and     |
+|             writes the work group count for the update into an indirect      |
+|             dispatch command                                                 |
+|   update  - moves every live particle, and copies the ones still alive into  |
+|             the other buffer. each work group counts its survivors in shared |
+|             memory and reserves space for them with one atomic add, so the   |
+|             copy is also the compaction step                                 |
+| then the buffers swap. The live count of each buffer is the vertex count of  |
+| an indirect draw command, so the CPU never needs to know how many there are. |
+\******************************************************************************/
+#ifndef _GPU_PARTICLES_H_
+#define _GPU_PARTICLES_H_
+
+#include "gpu_sort.h"
+#include <GL/glew.h>
+
+/* invocations per compute work group. the shaders use the same number */
+#define GPU_PARTICLES_GROUP 256
+
+/* the same layout as particle_t in the compute shaders. also read as 2 vertex
+attributes when drawing */
+struct gpu_particle_t {
+  float pos_age[4];  /* world position, seconds since emitted */
+  float vel_life[4]; /* velocity, seconds until it dies */
+};
+
+struct gpu_particles_t {
+  int max_particles; /* the size of each particle buffer */
+  int src;           /* which of the two buffers holds the live particles */
+  unsigned int seed; /* changes every emit, so each batch is different */
+  GLuint particle_bufs[2];
+  GLuint vaos[2];
+  /* a draw command per particle buffer, with the live count as the vertex
+  count, then the update's indirect dispatch command */
+  GLuint state_buf;
+  GLuint emit_sp, prepare_sp, update_sp, keys_sp;
+  GLint emit_n_loc, emit_seed_loc, emit_pos_loc, emit_lifetime_loc, emit_max_age_loc, emit_src_loc, emit_max_loc;
+  GLint prepare_src_loc, prepare_max_loc;
+  GLint update_dt_loc, update_src_loc, update_gravity_loc, update_ground_loc;
+  GLint keys_src_loc, keys_view_z_loc;
+};
+
+/* false if GL 4.3 isn't available or the shaders don't build */
+bool init_gpu_particles( gpu_particles_t* ps, int max_particles );
+void free_gpu_particles( gpu_particles_t* ps );
+
+/* kills every particle */
+void clear_gpu_particles( gpu_particles_t* ps );
+
+/* adds n particles at the emitter. each lives for lifetime seconds, and
+starts up to max_start_age seconds old - pass 0 for a normal emit, or up to
+lifetime to fill a system all at once without everything dying together.
+particles past max_particles are dropped */
+void emit_gpu_particles( gpu_particles_t* ps, int n, const float* emitter_pos, float lifetime, float max_start_age );
+
+/* moves the particles on by dt seconds, removes the dead ones, and swaps the
+buffers. the ground is a plane at height ground_y that particles bounce off */
+void update_gpu_particles( gpu_particles_t* ps, float dt, float ground_y );
+
+/* draws the live particles as GL_POINTS with whatever programme is in use.
+attribute 0 is pos_age, 1 is vel_life */
+void draw_gpu_particles( const gpu_particles_t* ps );
+
+/* sorts the live particles by depth from the camera, farthest first, into
+sort's key and value buffers. the values are the particles' indices */
+void sort_gpu_particles( gpu_particles_t* ps, gpu_sort_t* sort, const float* view_mat );
+
+/* draws the particles in the order sort_gpu_particles() gave, with the sorted
+indices as the index buffer. the count still comes from the GPU */
+void draw_sorted_gpu_particles( const gpu_particles_t* ps, const gpu_sort_t* sort );
+
+/* waits for the GPU and reads back the live count. for printing only */
+int count_gpu_particles( const gpu_particles_t* ps );
+
+#endif
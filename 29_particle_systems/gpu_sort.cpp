@@ -0,0 +1,150 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| A radix sort in compute shaders.                                             |
+\******************************************************************************/
+#include "gpu_sort.h"
+#include "gl_utils.h"
+#include <stdlib.h>
+#include <string.h>
+#define PREPARE_CS "sort_prepare_cs.glsl"
+#define COUNT_CS "sort_count_cs.glsl"
+#define SCAN_CS "sort_scan_cs.glsl"
+#define SCAN_SUMS_CS "sort_scan_sums_cs.glsl"
+#define SCATTER_CS "sort_scatter_cs.glsl"
+
+/* bits sorted by each pass, and so 16 digits */
+#define RADIX_BITS 4
+#define DIGITS 16
+/* counts added up by one work group of the scan, and the most blocks the
+second level can add up */
+#define SCAN_BLOCK 1024
+#define MAX_SCAN_BLOCKS 1024
+
+static GLuint create_storage_buffer( GLsizeiptr size ) {
+  GLuint buf = 0;
+  glGenBuffers( 1, &buf );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, buf );
+  glBufferData( GL_SHADER_STORAGE_BUFFER, size, NULL, GL_DYNAMIC_COPY );
+  return buf;
+}
+
+bool init_gpu_sort( gpu_sort_t* sort, int max_keys ) {
+  memset( sort, 0, sizeof( gpu_sort_t ) );
+  if ( !GLEW_VERSION_4_3 ) {
+    gl_log( "GL 4.3 is not available so there is no compute shader sort\n" );
+    return false;
+  }
+  int max_tiles  = ( max_keys + GPU_SORT_TILE - 1 ) / GPU_SORT_TILE;
+  int max_counts = max_tiles * DIGITS;
+  if ( max_counts > SCAN_BLOCK * MAX_SCAN_BLOCKS ) {
+    max_tiles  = SCAN_BLOCK * MAX_SCAN_BLOCKS / DIGITS;
+    max_keys   = max_tiles * GPU_SORT_TILE;
+    max_counts = max_tiles * DIGITS;
+    gl_log( "compute shader sort cut to %i keys\n", max_keys );
+  }
+  sort->max_keys = max_keys;
+  for ( int i = 0; i < 2; i++ ) {
+    sort->key_bufs[i]   = create_storage_buffer( (GLsizeiptr)max_keys * sizeof( GLuint ) );
+    sort->value_bufs[i] = create_storage_buffer( (GLsizeiptr)max_keys * sizeof( GLuint ) );
+  }
+  sort->counts_buf     = create_storage_buffer( (GLsizeiptr)max_counts * sizeof( GLuint ) );
+  sort->block_sums_buf = create_storage_buffer( MAX_SCAN_BLOCKS * sizeof( GLuint ) );
+  sort->state_buf      = create_storage_buffer( GPU_SORT_STATE_N_UINTS * sizeof( GLuint ) );
+  GLuint state[GPU_SORT_STATE_N_UINTS];
+  memset( state, 0, sizeof( state ) );
+  glBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, sizeof( state ), state );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+
+  sort->prepare_sp   = create_compute_programme( PREPARE_CS );
+  sort->count_sp     = create_compute_programme( COUNT_CS );
+  sort->scan_sp      = create_compute_programme( SCAN_CS );
+  sort->scan_sums_sp = create_compute_programme( SCAN_SUMS_CS );
+  sort->scatter_sp   = create_compute_programme( SCATTER_CS );
+  if ( !sort->prepare_sp || !sort->count_sp || !sort->scan_sp || !sort->scan_sums_sp || !sort->scatter_sp ) {
+    free_gpu_sort( sort );
+    return false;
+  }
+  sort->prepare_max_loc   = glGetUniformLocation( sort->prepare_sp, "max_keys" );
+  sort->count_shift_loc   = glGetUniformLocation( sort->count_sp, "shift" );
+  sort->scatter_shift_loc = glGetUniformLocation( sort->scatter_sp, "shift" );
+  gl_log( "compute shader sort: up to %i keys, %i MB\n", max_keys, (int)( 4 * (size_t)max_keys * sizeof( GLuint ) / ( 1024 * 1024 ) ) );
+  return true;
+}
+
+void free_gpu_sort( gpu_sort_t* sort ) {
+  glDeleteBuffers( 2, sort->key_bufs );
+  glDeleteBuffers( 2, sort->value_bufs );
+  glDeleteBuffers( 1, &sort->counts_buf );
+  glDeleteBuffers( 1, &sort->block_sums_buf );
+  glDeleteBuffers( 1, &sort->state_buf );
+  if ( sort->prepare_sp ) { glDeleteProgram( sort->prepare_sp ); }
+  if ( sort->count_sp ) { glDeleteProgram( sort->count_sp ); }
+  if ( sort->scan_sp ) { glDeleteProgram( sort->scan_sp ); }
+  if ( sort->scan_sums_sp ) { glDeleteProgram( sort->scan_sums_sp ); }
+  if ( sort->scatter_sp ) { glDeleteProgram( sort->scatter_sp ); }
+  memset( sort, 0, sizeof( gpu_sort_t ) );
+}
+
+void set_gpu_sort_keys( gpu_sort_t* sort, const GLuint* keys, int n ) {
+  if ( n > sort->max_keys ) { n = sort->max_keys; }
+  if ( n < 0 ) { n = 0; }
+  GLuint* values = (GLuint*)malloc( ( n > 0 ? n : 1 ) * sizeof( GLuint ) );
+  for ( int i = 0; i < n; i++ ) { values[i] = (GLuint)i; }
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, sort->key_bufs[0] );
+  glBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)n * sizeof( GLuint ), keys );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, sort->value_bufs[0] );
+  glBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)n * sizeof( GLuint ), values );
+  GLuint count = (GLuint)n;
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, sort->state_buf );
+  glBufferSubData( GL_SHADER_STORAGE_BUFFER, GPU_SORT_N * sizeof( GLuint ), sizeof( GLuint ), &count );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+  free( values );
+}
+
+void run_gpu_sort( gpu_sort_t* sort ) {
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 4, sort->counts_buf );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 5, sort->block_sums_buf );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 6, sort->state_buf );
+  /* the key count may have just been written by a shader */
+  glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+  glUseProgram( sort->prepare_sp );
+  glUniform1ui( sort->prepare_max_loc, (GLuint)sort->max_keys );
+  glDispatchCompute( 1, 1, 1 );
+  glMemoryBarrier( GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT );
+
+  glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, sort->state_buf );
+  /* an even number of passes, so the result ends up back in [0] */
+  for ( int pass = 0; pass < 32 / RADIX_BITS; pass++ ) {
+    int src = pass % 2;
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, sort->key_bufs[src] );
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, sort->value_bufs[src] );
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, sort->key_bufs[1 - src] );
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 3, sort->value_bufs[1 - src] );
+
+    glUseProgram( sort->count_sp );
+    glUniform1ui( sort->count_shift_loc, (GLuint)( pass * RADIX_BITS ) );
+    glDispatchComputeIndirect( GPU_SORT_TILE_DISPATCH * sizeof( GLuint ) );
+    glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+
+    glUseProgram( sort->scan_sp );
+    glDispatchComputeIndirect( GPU_SORT_SCAN_DISPATCH * sizeof( GLuint ) );
+    glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+    glUseProgram( sort->scan_sums_sp );
+    glDispatchCompute( 1, 1, 1 );
+    glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+
+    glUseProgram( sort->scatter_sp );
+    glUniform1ui( sort->scatter_shift_loc, (GLuint)( pass * RADIX_BITS ) );
+    glDispatchComputeIndirect( GPU_SORT_TILE_DISPATCH * sizeof( GLuint ) );
+    glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+  }
+  glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, 0 );
+  /* the sorted values are used as indices next, with the draw command */
+  glMemoryBarrier( GL_ELEMENT_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT );
+}
@@ -0,0 +1,63 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| A radix sort of key/value pairs in compute shaders (GL 4.3).                 |
+| The keys are 32-bit unsigned ints, sorted 4 bits at a time from the lowest,  |
+| so 8 passes. Each pass is stable, so each keeps the order the last one gave  |
+| to keys with the same 4 bits. The keys are split into tiles of 1024, and     |
+| every pass is:                                                               |
+|   count   - each tile counts how many of its keys have each of the 16 digits |
+|   scan    - a prefix sum of the counts, laid out digit by digit, gives where |
+|             each tile's keys with each digit start in the output. done in    |
+|             blocks, then a second pass over the block totals                 |
+|   scatter - each tile ranks its keys within their digit, and writes them to  |
+|             their start plus their rank                                      |
+| The number of keys is read from the state buffer rather than passed in, so   |
+| it can come from another shader, and the dispatches are indirect. The state  |
+| buffer also gets a glDrawElementsIndirect() command with the sorted values   |
+| as the index buffer, so anything with indices for values can be drawn in     |
+| sorted order without the CPU knowing how many there are.                     |
+\******************************************************************************/
+#ifndef _GPU_SORT_H_
+#define _GPU_SORT_H_
+
+#include <GL/glew.h>
+
+/* keys sorted by one work group. the shaders use the same number */
+#define GPU_SORT_TILE 1024
+
+/* offsets into the state buffer, in GLuints */
+#define GPU_SORT_N 0             /* the number of keys. written by whoever makes the keys */
+#define GPU_SORT_TILE_DISPATCH 1 /* x, y, z work groups for count and scatter */
+#define GPU_SORT_SCAN_DISPATCH 4 /* x, y, z work groups for the scan */
+#define GPU_SORT_DRAW_CMD 7      /* count, instance count, first index, base vertex, base instance */
+#define GPU_SORT_STATE_N_UINTS 12
+
+struct gpu_sort_t {
+  int max_keys;
+  /* the keys and values go into [0], and come out sorted in [0]. [1] is for
+  the passes in between */
+  GLuint key_bufs[2], value_bufs[2];
+  GLuint counts_buf, block_sums_buf;
+  GLuint state_buf;
+  GLuint prepare_sp, count_sp, scan_sp, scan_sums_sp, scatter_sp;
+  GLint prepare_max_loc, count_shift_loc, scatter_shift_loc;
+};
+
+/* false if GL 4.3 isn't available or the shaders don't build */
+bool init_gpu_sort( gpu_sort_t* sort, int max_keys );
+void free_gpu_sort( gpu_sort_t* sort );
+
+/* copies n keys to the GPU with the values 0 to n - 1. shaders can write
+key_bufs[0], value_bufs[0], and the count instead */
+void set_gpu_sort_keys( gpu_sort_t* sort, const GLuint* keys, int n );
+
+/* sorts key_bufs[0] and value_bufs[0] by key, smallest first */
+void run_gpu_sort( gpu_sort_t* sort );
+
+#endif
@@ -9,8 +9,11 @@
 | Particle Systems                                                             |
 \******************************************************************************/
 
+#include "cpu_particles.h"
 #include "gl_utils.h"
+#include "gpu_particles.h"
 #include "maths_funcs.h"
+#include "wboit.h"
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h> // GLFW helper library
 #include <assert.h>
@@ -19,6 +22,7 @@
 #include <string.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <thread>
 #define GL_LOG_FILE "gl.log"
 
 int g_gl_width       = 640;
@@ -26,6 +30,40 @@ int g_gl_height      = 480;
 GLFWwindow* g_window = NULL;
 
 #define PARTICLE_COUNT 300
+/* the compute shader particle buffers. 2 x 128MB */
+#define MAX_GPU_PARTICLES ( 1 << 22 )
+/* the CPU particle arrays. 192MB with the sorting arrays, and a 64MB vertex
+buffer */
+#define MAX_CPU_PARTICLES ( 1 << 22 )
+#define PARTICLE_LIFETIME 3.0f
+#define GROUND_Y -1.0f
+
+/* closed-form particles are worked out from their start time and velocity in
+test_vs.glsl. the others keep their state and are drawn by particles_vs.glsl */
+enum particle_mode_t { PARTICLES_CLOSED_FORM, PARTICLES_CPU, PARTICLES_COMPUTE, PARTICLE_MODE_COUNT };
+const char* g_particle_mode_names[] = { "closed-form, in the vertex shader", "CPU", "compute shader" };
+particle_mode_t g_particle_mode     = PARTICLES_CLOSED_FORM;
+
+/* blending particles in the order they were made gets overlaps wrong. sorting
+needs each particle's state, so closed-form particles can only use OIT */
+enum blend_mode_t { BLEND_UNSORTED, BLEND_SORTED, BLEND_OIT, BLEND_MODE_COUNT };
+const char* g_blend_mode_names[] = { "blended unsorted", "sorted back to front", "weighted, blended order-independent transparency" };
+blend_mode_t g_blend_mode        = BLEND_UNSORTED;
+
+gpu_particles_t g_gpu_particles;
+/* false if there are no compute shaders */
+bool g_has_compute = false;
+cpu_particles_t g_cpu_particles;
+gpu_sort_t g_gpu_sort;
+wboit_t g_wboit;
+/* each shader with "over" blending, and with OIT accumulation */
+GLuint g_closed_form_sp, g_particle_sp;
+GLuint g_closed_form_oit_sp, g_particle_oit_sp;
+/* the camera, for the particles' depths */
+mat4 g_view_mat;
+/* particles alive at once. emitting this many every lifetime keeps it there */
+int g_target_particles = 10000;
+float g_emitter_pos[]  = { 0.0f, 0.0f, 0.0f };
 
 /* create initial attribute values for particles. return a VAO */
 GLuint gen_particles() {
@@ -69,6 +107,342 @@ GLuint gen_particles() {
   return vao;
 }
 
+/* draws the current mode's particles as blended point sprites. vao is the
+closed-form particles' */
+void draw_particles( GLuint vao, GLuint tex ) {
+  /* Render Particles. Enabling point re-sizing in vertex shader */
+  glEnable( GL_PROGRAM_POINT_SIZE );
+  glPointParameteri( GL_POINT_SPRITE_COORD_ORIGIN, GL_LOWER_LEFT );
+
+  bool oit = BLEND_OIT == g_blend_mode;
+  if ( oit ) { begin_wboit( &g_wboit, g_gl_width, g_gl_height ); }
+  glEnable( GL_BLEND );
+  glDepthMask( GL_FALSE );
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( GL_TEXTURE_2D, tex );
+  if ( PARTICLES_COMPUTE == g_particle_mode ) {
+    glUseProgram( oit ? g_particle_oit_sp : g_particle_sp );
+    /* the vertex count comes from the GPU */
+    if ( BLEND_SORTED == g_blend_mode ) {
+      draw_sorted_gpu_particles( &g_gpu_particles, &g_gpu_sort );
+    } else {
+      draw_gpu_particles( &g_gpu_particles );
+    }
+  } else if ( PARTICLES_CPU == g_particle_mode ) {
+    /* sorted, if at all, when the vertex buffer was written */
+    glUseProgram( oit ? g_particle_oit_sp : g_particle_sp );
+    draw_cpu_particles( &g_cpu_particles );
+  } else {
+    glUseProgram( oit ? g_closed_form_oit_sp : g_closed_form_sp );
+    glBindVertexArray( vao );
+    // draw points 0-3 from the currently bound VAO with current in-use shader
+    glDrawArrays( GL_POINTS, 0, PARTICLE_COUNT );
+  }
+  if ( oit ) { end_wboit( &g_wboit ); }
+  glDisable( GL_BLEND );
+  glDepthMask( GL_TRUE );
+  glDisable( GL_PROGRAM_POINT_SIZE );
+}
+
+/* sorts the particles back to front if they are to be blended that way, and
+writes the CPU particles' vertex buffer. between simulating and drawing */
+void prepare_particles() {
+  bool sorted = BLEND_SORTED == g_blend_mode;
+  if ( PARTICLES_CPU == g_particle_mode ) {
+    if ( sorted ) { sort_cpu_particles( &g_cpu_particles, g_view_mat.m ); }
+    upload_cpu_particles( &g_cpu_particles );
+  } else if ( PARTICLES_COMPUTE == g_particle_mode && sorted ) {
+    sort_gpu_particles( &g_gpu_particles, &g_gpu_sort, g_view_mat.m );
+  }
+}
+
+/* emits enough particles over dt to keep g_target_particles alive, then moves
+them all on. the closed-form particles don't need this */
+void simulate_particles( float dt ) {
+  static double emit_accum = 0.0;
+  if ( PARTICLES_CLOSED_FORM == g_particle_mode ) { return; }
+  emit_accum += (double)dt * g_target_particles / PARTICLE_LIFETIME;
+  int n_emit = (int)emit_accum;
+  emit_accum -= n_emit;
+  if ( PARTICLES_COMPUTE == g_particle_mode ) {
+    emit_gpu_particles( &g_gpu_particles, n_emit, g_emitter_pos, PARTICLE_LIFETIME, 0.0f );
+    update_gpu_particles( &g_gpu_particles, dt, GROUND_Y );
+  } else {
+    emit_cpu_particles( &g_cpu_particles, n_emit, g_emitter_pos, PARTICLE_LIFETIME, 0.0f );
+    update_cpu_particles( &g_cpu_particles, dt, GROUND_Y );
+  }
+}
+
+/* fills the system to each size with particles of every age, then times
+simulating and drawing it at 60Hz steps. particles are drawn 1 pixel big, so
+that the draw is timing the particles rather than how much they overlap. the
+timer query is the GPU's own time. wall time runs from glFinish() to
+glFinish(), which also catches software renderers that the query doesn't */
+void benchmark_gpu_particles( GLuint tex ) {
+  const int counts[]  = { 10000, 100000, 1000000, 4000000 };
+  const int n_counts  = 4;
+  const int n_frames  = 30;
+  const float dt      = 1.0f / 60.0f;
+  int previous_target = g_target_particles;
+  GLuint queries[2]   = { 0, 0 };
+  /* the simulation alone, drawn unsorted */
+  blend_mode_t previous_blend = g_blend_mode;
+  g_blend_mode                = BLEND_UNSORTED;
+  glGenQueries( 2, queries );
+  glUseProgram( g_particle_sp );
+  glUniform1f( glGetUniformLocation( g_particle_sp, "point_size" ), 1.0f );
+  gl_log( "benchmarking compute shader particles over %i frames per test...\n", n_frames );
+  printf( "benchmarking compute shader particles over %i frames per test...\n", n_frames );
+  for ( int c = 0; c < n_counts; c++ ) {
+    if ( counts[c] > g_gpu_particles.max_particles ) { break; }
+    g_target_particles = counts[c];
+    clear_gpu_particles( &g_gpu_particles );
+    emit_gpu_particles( &g_gpu_particles, counts[c], g_emitter_pos, PARTICLE_LIFETIME, PARTICLE_LIFETIME );
+    update_gpu_particles( &g_gpu_particles, 0.0f, GROUND_Y );
+    double sim_gpu_ms = 0.0, sim_wall_ms = 0.0, draw_gpu_ms = 0.0, draw_wall_ms = 0.0;
+    for ( int f = 0; f < n_frames; f++ ) {
+      glFinish();
+      double start = glfwGetTime();
+      glBeginQuery( GL_TIME_ELAPSED, queries[0] );
+      simulate_particles( dt );
+      glEndQuery( GL_TIME_ELAPSED );
+      glFinish();
+      double simulated = glfwGetTime();
+      glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+      glBeginQuery( GL_TIME_ELAPSED, queries[1] );
+      draw_particles( 0, tex );
+      glEndQuery( GL_TIME_ELAPSED );
+      glFinish();
+      double drawn    = glfwGetTime();
+      GLuint64 sim_ns = 0, draw_ns = 0;
+      glGetQueryObjectui64v( queries[0], GL_QUERY_RESULT, &sim_ns );
+      glGetQueryObjectui64v( queries[1], GL_QUERY_RESULT, &draw_ns );
+      sim_gpu_ms += (double)sim_ns / 1000000.0 / n_frames;
+      draw_gpu_ms += (double)draw_ns / 1000000.0 / n_frames;
+      sim_wall_ms += ( simulated - start ) * 1000.0 / n_frames;
+      draw_wall_ms += ( drawn - simulated ) * 1000.0 / n_frames;
+    }
+    int n_alive            = count_gpu_particles( &g_gpu_particles );
+    double ns_per_particle = sim_wall_ms * 1000000.0 / n_alive;
+    gl_log( "%8i particles: simulate gpu %8.3fms wall %8.3fms (%.2fns/particle) | draw gpu %8.3fms wall %8.3fms | frame %8.3fms\n", n_alive, sim_gpu_ms, sim_wall_ms, ns_per_particle,
+      draw_gpu_ms, draw_wall_ms, sim_wall_ms + draw_wall_ms );
+    printf( "%8i particles: simulate gpu %8.3fms wall %8.3fms (%.2fns/particle) | draw gpu %8.3fms wall %8.3fms | frame %8.3fms\n", n_alive, sim_gpu_ms, sim_wall_ms, ns_per_particle,
+      draw_gpu_ms, draw_wall_ms, sim_wall_ms + draw_wall_ms );
+  }
+  glDeleteQueries( 2, queries );
+  glUseProgram( g_particle_sp );
+  glUniform1f( glGetUniformLocation( g_particle_sp, "point_size" ), 15.0f );
+  g_target_particles = previous_target;
+  g_blend_mode       = previous_blend;
+  clear_gpu_particles( &g_gpu_particles );
+}
+
+/* fills a separate CPU system to each size with particles of every age, then
+times emitting and updating it (simulate), and writing the vertex buffer
+(upload), with 1, 2, 4... threads up to the number of cores. nothing is drawn,
+so this is also what a server without a GPU would spend */
+void benchmark_cpu_particles() {
+  const int counts[] = { 100000, 1000000, 10000000 };
+  const int n_counts = 3;
+  const int n_frames = 10;
+  const float dt     = 1.0f / 60.0f;
+  int max_threads    = (int)std::thread::hardware_concurrency();
+  max_threads        = max_threads > 1 ? max_threads : 1;
+  int thread_counts[16];
+  int n_thread_counts = 0;
+  for ( int t = 1; t < max_threads && n_thread_counts < 15; t *= 2 ) { thread_counts[n_thread_counts++] = t; }
+  thread_counts[n_thread_counts++] = max_threads;
+  cpu_particles_t ps;
+  if ( !init_cpu_particles( &ps, counts[n_counts - 1], 1 ) ) { return; }
+  gl_log( "benchmarking CPU particles over %i frames per test. SIMD width %i, up to %i threads...\n", n_frames, cpu_particles_simd_width(), max_threads );
+  printf( "benchmarking CPU particles over %i frames per test. SIMD width %i, up to %i threads...\n", n_frames, cpu_particles_simd_width(), max_threads );
+  for ( int c = 0; c < n_counts; c++ ) {
+    for ( int t = 0; t < n_thread_counts; t++ ) {
+      set_cpu_particle_threads( &ps, thread_counts[t] );
+      clear_cpu_particles( &ps );
+      emit_cpu_particles( &ps, counts[c], g_emitter_pos, PARTICLE_LIFETIME, PARTICLE_LIFETIME );
+      double emit_accum = 0.0, sim_ms = 0.0, upload_ms = 0.0;
+      for ( int f = 0; f < n_frames; f++ ) {
+        double start = glfwGetTime();
+        emit_accum += (double)dt * counts[c] / PARTICLE_LIFETIME;
+        int n_emit = (int)emit_accum;
+        emit_accum -= n_emit;
+        emit_cpu_particles( &ps, n_emit, g_emitter_pos, PARTICLE_LIFETIME, 0.0f );
+        update_cpu_particles( &ps, dt, GROUND_Y );
+        double simulated = glfwGetTime();
+        upload_cpu_particles( &ps );
+        double uploaded = glfwGetTime();
+        sim_ms += ( simulated - start ) * 1000.0 / n_frames;
+        upload_ms += ( uploaded - simulated ) * 1000.0 / n_frames;
+      }
+      double ns_per_particle = sim_ms * 1000000.0 / ps.n_particles;
+      gl_log( "%8i particles, %2i threads: simulate %8.3fms (%.2fns/particle, %.0fM particles/s) | upload %8.3fms\n", ps.n_particles, thread_counts[t], sim_ms, ns_per_particle,
+        1000.0 / ns_per_particle, upload_ms );
+      printf( "%8i particles, %2i threads: simulate %8.3fms (%.2fns/particle, %.0fM particles/s) | upload %8.3fms\n", ps.n_particles, thread_counts[t], sim_ms, ns_per_particle,
+        1000.0 / ns_per_particle, upload_ms );
+    }
+  }
+  free_cpu_particles( &ps );
+}
+
+/* the number of view-space depths that are nearer than the next one, for
+checking a back to front sort. the GPU rounds its depths a little differently,
+so differences smaller than that don't count */
+static int count_out_of_order( const float* xyz, int stride, const unsigned int* order, int n ) {
+  const float* v = g_view_mat.m;
+  int n_wrong    = 0;
+  float previous = -1e30f;
+  for ( int i = 0; i < n; i++ ) {
+    const float* p = xyz + (size_t)order[i] * stride;
+    float z        = v[2] * p[0] + v[6] * p[1] + v[10] * p[2] + v[14];
+    if ( z < previous - 1e-5f ) { n_wrong++; }
+    previous = z;
+  }
+  return n_wrong;
+}
+
+/* times sorting 1M particles by depth on the CPU with 1, 2, 4... threads and
+in compute shaders, each time checking the order that comes out. then times
+whole frames - simulate, sort, draw - of the CPU and compute shader particles
+in each blend mode, with the normal sprite size */
+void benchmark_transparency( GLuint vao, GLuint tex ) {
+  const int n_keys              = 1000000;
+  const int frame_counts[]      = { 10000, 100000 };
+  const int n_frame_counts      = 2;
+  const int n_frames            = 10;
+  const float dt                = 1.0f / 60.0f;
+  int max_threads               = (int)std::thread::hardware_concurrency();
+  max_threads                   = max_threads > 1 ? max_threads : 1;
+  particle_mode_t previous_mode = g_particle_mode;
+  blend_mode_t previous_blend   = g_blend_mode;
+  int previous_target           = g_target_particles;
+  int thread_counts[16];
+  int n_thread_counts = 0;
+  for ( int t = 1; t < max_threads && n_thread_counts < 15; t *= 2 ) { thread_counts[n_thread_counts++] = t; }
+  thread_counts[n_thread_counts++] = max_threads;
+  gl_log( "benchmarking sorting %i particles by depth over %i sorts per test...\n", n_keys, n_frames );
+  printf( "benchmarking sorting %i particles by depth over %i sorts per test...\n", n_keys, n_frames );
+
+  /* particles that live long enough to spread out for a second, so that the
+  depths are a realistic mix */
+  cpu_particles_t ps;
+  if ( !init_cpu_particles( &ps, n_keys, 1 ) ) { return; }
+  emit_cpu_particles( &ps, n_keys, g_emitter_pos, 100.0f, 0.0f );
+  for ( int f = 0; f < 60; f++ ) { update_cpu_particles( &ps, dt, GROUND_Y ); }
+  for ( int t = 0; t < n_thread_counts; t++ ) {
+    set_cpu_particle_threads( &ps, thread_counts[t] );
+    double sort_ms = 0.0;
+    for ( int f = 0; f < n_frames; f++ ) {
+      double start = glfwGetTime();
+      sort_cpu_particles( &ps, g_view_mat.m );
+      sort_ms += ( glfwGetTime() - start ) * 1000.0 / n_frames;
+    }
+    /* the x positions are followed by their own array, so stride 1 won't do */
+    float* xyz = (float*)malloc( (size_t)ps.n_particles * 3 * sizeof( float ) );
+    for ( int i = 0; i < ps.n_particles; i++ ) {
+      xyz[i * 3]     = ps.px[i];
+      xyz[i * 3 + 1] = ps.py[i];
+      xyz[i * 3 + 2] = ps.pz[i];
+    }
+    int n_wrong = count_out_of_order( xyz, 3, ps.sorted_order, ps.n_particles );
+    free( xyz );
+    gl_log( "%8i keys, CPU %2i threads: sort %8.3fms (%.0fM keys/s). %i out of order\n", ps.n_particles, thread_counts[t], sort_ms, ps.n_particles / ( sort_ms * 1000.0 ), n_wrong );
+    printf( "%8i keys, CPU %2i threads: sort %8.3fms (%.0fM keys/s). %i out of order\n", ps.n_particles, thread_counts[t], sort_ms, ps.n_particles / ( sort_ms * 1000.0 ), n_wrong );
+  }
+  free_cpu_particles( &ps );
+
+  if ( g_has_compute ) {
+    GLuint query = 0;
+    glGenQueries( 1, &query );
+    clear_gpu_particles( &g_gpu_particles );
+    emit_gpu_particles( &g_gpu_particles, n_keys, g_emitter_pos, 100.0f, 0.0f );
+    for ( int f = 0; f < 60; f++ ) { update_gpu_particles( &g_gpu_particles, dt, GROUND_Y ); }
+    double sort_gpu_ms = 0.0, sort_wall_ms = 0.0;
+    for ( int f = 0; f < n_frames; f++ ) {
+      glFinish();
+      double start = glfwGetTime();
+      glBeginQuery( GL_TIME_ELAPSED, query );
+      sort_gpu_particles( &g_gpu_particles, &g_gpu_sort, g_view_mat.m );
+      glEndQuery( GL_TIME_ELAPSED );
+      glFinish();
+      GLuint64 ns = 0;
+      glGetQueryObjectui64v( query, GL_QUERY_RESULT, &ns );
+      sort_gpu_ms += (double)ns / 1000000.0 / n_frames;
+      sort_wall_ms += ( glfwGetTime() - start ) * 1000.0 / n_frames;
+    }
+    glDeleteQueries( 1, &query );
+    int n               = count_gpu_particles( &g_gpu_particles );
+    gpu_particle_t* p   = (gpu_particle_t*)malloc( (size_t)n * sizeof( gpu_particle_t ) );
+    unsigned int* order = (unsigned int*)malloc( (size_t)n * sizeof( unsigned int ) );
+    glBindBuffer( GL_SHADER_STORAGE_BUFFER, g_gpu_particles.particle_bufs[g_gpu_particles.src] );
+    glGetBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)n * sizeof( gpu_particle_t ), p );
+    glBindBuffer( GL_SHADER_STORAGE_BUFFER, g_gpu_sort.value_bufs[0] );
+    glGetBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)n * sizeof( unsigned int ), order );
+    glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+    int n_wrong = count_out_of_order( p[0].pos_age, sizeof( gpu_particle_t ) / sizeof( float ), order, n );
+    free( p );
+    free( order );
+    gl_log( "%8i keys, compute shaders: sort gpu %8.3fms wall %8.3fms (%.0fM keys/s). %i out of order\n", n, sort_gpu_ms, sort_wall_ms, n / ( sort_wall_ms * 1000.0 ), n_wrong );
+    printf( "%8i keys, compute shaders: sort gpu %8.3fms wall %8.3fms (%.0fM keys/s). %i out of order\n", n, sort_gpu_ms, sort_wall_ms, n / ( sort_wall_ms * 1000.0 ), n_wrong );
+  }
+
+  gl_log( "benchmarking whole frames in each blend mode over %i frames per test...\n", n_frames );
+  printf( "benchmarking whole frames in each blend mode over %i frames per test...\n", n_frames );
+  for ( int m = PARTICLES_CPU; m <= PARTICLES_COMPUTE; m++ ) {
+    if ( PARTICLES_COMPUTE == m && !g_has_compute ) { break; }
+    g_particle_mode = (particle_mode_t)m;
+    for ( int c = 0; c < n_frame_counts; c++ ) {
+      for ( int b = 0; b < BLEND_MODE_COUNT; b++ ) {
+        g_blend_mode       = (blend_mode_t)b;
+        g_target_particles = frame_counts[c];
+        /* run the system for a lifetime, so that it's full and spread out */
+        if ( g_has_compute ) { clear_gpu_particles( &g_gpu_particles ); }
+        clear_cpu_particles( &g_cpu_particles );
+        for ( int f = 0; f < (int)( PARTICLE_LIFETIME / dt ); f++ ) { simulate_particles( dt ); }
+        double frame_ms = 0.0;
+        for ( int f = 0; f < n_frames; f++ ) {
+          glFinish();
+          double start = glfwGetTime();
+          simulate_particles( dt );
+          prepare_particles();
+          glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+          draw_particles( vao, tex );
+          glFinish();
+          frame_ms += ( glfwGetTime() - start ) * 1000.0 / n_frames;
+        }
+        gl_log( "%8i %s particles, %-48s: frame %8.3fms\n", frame_counts[c], g_particle_mode_names[m], g_blend_mode_names[b], frame_ms );
+        printf( "%8i %s particles, %-48s: frame %8.3fms\n", frame_counts[c], g_particle_mode_names[m], g_blend_mode_names[b], frame_ms );
+      }
+    }
+  }
+  g_particle_mode    = previous_mode;
+  g_blend_mode       = previous_blend;
+  g_target_particles = previous_target;
+  if ( g_has_compute ) { clear_gpu_particles( &g_gpu_particles ); }
+  clear_cpu_particles( &g_cpu_particles );
+}
+
+void print_particle_mode() {
+  if ( PARTICLES_CLOSED_FORM == g_particle_mode ) {
+    printf( "%s particles. %i of them. %s\n", g_particle_mode_names[g_particle_mode], PARTICLE_COUNT, g_blend_mode_names[g_blend_mode] );
+  } else if ( PARTICLES_CPU == g_particle_mode ) {
+    printf( "%s particles. keeping %i alive with %i threads. %s\n", g_particle_mode_names[g_particle_mode], g_target_particles, g_cpu_particles.n_threads,
+      g_blend_mode_names[g_blend_mode] );
+  } else {
+    printf( "%s particles. keeping %i alive. %s\n", g_particle_mode_names[g_particle_mode], g_target_particles, g_blend_mode_names[g_blend_mode] );
+  }
+}
+
+/* the view matrix goes to every particle shader, and is kept for sorting */
+void set_view_mat( const mat4& view_mat ) {
+  GLuint programmes[] = { g_closed_form_sp, g_closed_form_oit_sp, g_particle_sp, g_particle_oit_sp };
+  for ( int i = 0; i < 4; i++ ) {
+    glUseProgram( programmes[i] );
+    glUniformMatrix4fv( glGetUniformLocation( programmes[i], "V" ), 1, GL_FALSE, view_mat.m );
+  }
+  g_view_mat = view_mat;
+}
+
 int main() {
   restart_gl_log();
   // use GLFW and GLEW to start GL context. see gl_utils.cpp for details
@@ -77,7 +451,23 @@ int main() {
   /* create buffer of particle initial attributes and a VAO */
   GLuint vao = gen_particles();
 
+  /* the compute shaders need GL 4.3. without it the CPU particles are the
+  default */
+  g_has_compute   = init_gpu_particles( &g_gpu_particles, MAX_GPU_PARTICLES );
+  g_particle_mode = g_has_compute ? PARTICLES_COMPUTE : PARTICLES_CPU;
+  int n_threads   = (int)std::thread::hardware_concurrency();
+  if ( !init_cpu_particles( &g_cpu_particles, MAX_CPU_PARTICLES, n_threads ) ) { return 1; }
+  if ( g_has_compute && !init_gpu_sort( &g_gpu_sort, MAX_GPU_PARTICLES ) ) { return 1; }
+  if ( !init_wboit( &g_wboit, g_gl_width, g_gl_height ) ) { return 1; }
+
   GLuint shader_programme = create_programme_from_files( "test_vs.glsl", "test_fs.glsl" );
+  g_closed_form_sp        = shader_programme;
+  g_particle_sp           = create_programme_from_files( "particles_vs.glsl", "test_fs.glsl" );
+  g_closed_form_oit_sp    = create_programme_from_files( "test_vs.glsl", "particles_oit_fs.glsl" );
+  g_particle_oit_sp       = create_programme_from_files( "particles_vs.glsl", "particles_oit_fs.glsl" );
+  printf( "M changes the particle system. 1-5 keep 1000, 10k, 100k, 1M, or 4M alive. T changes the CPU threads. B benchmarks\n" );
+  printf( "O changes how particles are blended. P benchmarks sorting and each blend mode\n" );
+  print_particle_mode();
 
 #define ONE_DEG_IN_RAD ( 2.0 * M_PI ) / 360.0 // 0.017444444
   // input variables
@@ -117,6 +507,22 @@ int main() {
   glUniformMatrix4fv( V_loc, 1, GL_FALSE, view_mat.m );
   glUniformMatrix4fv( P_loc, 1, GL_FALSE, proj_mat );
   glUniform3f( emitter_pos_wor_loc, emitter_world_pos.v[0], emitter_world_pos.v[1], emitter_world_pos.v[2] );
+  /* the same matrices for the particles that keep their state */
+  int particle_V_loc = glGetUniformLocation( g_particle_sp, "V" );
+  assert( particle_V_loc > -1 );
+  int particle_P_loc = glGetUniformLocation( g_particle_sp, "P" );
+  assert( particle_P_loc > -1 );
+  glUseProgram( g_particle_sp );
+  glUniformMatrix4fv( particle_V_loc, 1, GL_FALSE, view_mat.m );
+  glUniformMatrix4fv( particle_P_loc, 1, GL_FALSE, proj_mat );
+  /* and for the OIT versions of both */
+  glUseProgram( g_closed_form_oit_sp );
+  glUniformMatrix4fv( glGetUniformLocation( g_closed_form_oit_sp, "P" ), 1, GL_FALSE, proj_mat );
+  glUniform3f( glGetUniformLocation( g_closed_form_oit_sp, "emitter_pos_wor" ), emitter_world_pos.v[0], emitter_world_pos.v[1], emitter_world_pos.v[2] );
+  int oit_elapsed_system_time_loc = glGetUniformLocation( g_closed_form_oit_sp, "elapsed_system_time" );
+  glUseProgram( g_particle_oit_sp );
+  glUniformMatrix4fv( glGetUniformLocation( g_particle_oit_sp, "P" ), 1, GL_FALSE, proj_mat );
+  set_view_mat( view_mat );
 
   // load texture
   GLuint tex;
@@ -136,6 +542,12 @@ int main() {
   glEnable(GL_POINT_SPRITE);
   */
 
+  const int particle_counts[] = { 1000, 10000, 100000, 1000000, 4000000 };
+  static bool m_was_down      = false;
+  static bool t_was_down      = false;
+  static bool b_was_down      = false;
+  static bool o_was_down      = false;
+  static bool p_was_down      = false;
   while ( !glfwWindowShouldClose( g_window ) ) {
     static double previous_seconds = glfwGetTime();
     double current_seconds         = glfwGetTime();
@@ -143,29 +555,19 @@ int main() {
     previous_seconds               = current_seconds;
 
     _update_fps_counter( g_window );
+    /* a long stall would throw everything through the floor */
+    simulate_particles( elapsed_seconds < 0.1 ? (float)elapsed_seconds : 0.1f );
+    prepare_particles();
     // wipe the drawing surface clear
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
     glViewport( 0, 0, g_gl_width, g_gl_height );
 
-    /* Render Particles. Enabling point re-sizing in vertex shader */
-    glEnable( GL_PROGRAM_POINT_SIZE );
-    glPointParameteri( GL_POINT_SPRITE_COORD_ORIGIN, GL_LOWER_LEFT );
-
-    glEnable( GL_BLEND );
-    glDepthMask( GL_FALSE );
-    glActiveTexture( GL_TEXTURE0 );
-    glBindTexture( GL_TEXTURE_2D, tex );
-    glUseProgram( shader_programme );
-
     /* update time in shaders */
+    glUseProgram( shader_programme );
     glUniform1f( elapsed_system_time_loc, (GLfloat)current_seconds );
-
-    glBindVertexArray( vao );
-    // draw points 0-3 from the currently bound VAO with current in-use shader
-    glDrawArrays( GL_POINTS, 0, PARTICLE_COUNT );
-    glDisable( GL_BLEND );
-    glDepthMask( GL_TRUE );
-    glDisable( GL_PROGRAM_POINT_SIZE );
+    glUseProgram( g_closed_form_oit_sp );
+    glUniform1f( oit_elapsed_system_time_loc, (GLfloat)current_seconds );
+    draw_particles( vao, tex );
 
     // update other events like input handling
     glfwPollEvents();
@@ -210,14 +612,68 @@ int main() {
                                              -cam_pos[2] ) ); // cam translation
       mat4 R        = rotate_y_deg( identity_mat4(), -cam_yaw );     //
       mat4 view_mat = R * T;
-      glUniformMatrix4fv( V_loc, 1, GL_FALSE, view_mat.m );
+      set_view_mat( view_mat );
     }
 
+    for ( int i = 0; i < 5; i++ ) {
+      if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_1 + i ) && g_target_particles != particle_counts[i] ) {
+        g_target_particles = particle_counts[i];
+        print_particle_mode();
+      }
+    }
+    bool m_is_down = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_M );
+    if ( m_is_down && !m_was_down ) {
+      g_particle_mode = (particle_mode_t)( ( g_particle_mode + 1 ) % PARTICLE_MODE_COUNT );
+      if ( PARTICLES_COMPUTE == g_particle_mode && !g_has_compute ) { g_particle_mode = PARTICLES_CLOSED_FORM; }
+      /* start the new system from empty */
+      if ( g_has_compute ) { clear_gpu_particles( &g_gpu_particles ); }
+      clear_cpu_particles( &g_cpu_particles );
+      print_particle_mode();
+    }
+    m_was_down     = m_is_down;
+    bool t_is_down = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_T );
+    if ( t_is_down && !t_was_down ) {
+      /* 1, 2, 4... up to the number of cores, then back to 1 */
+      int max_threads = (int)std::thread::hardware_concurrency();
+      int n           = g_cpu_particles.n_threads * 2;
+      if ( g_cpu_particles.n_threads >= max_threads ) {
+        n = 1;
+      } else if ( n > max_threads ) {
+        n = max_threads;
+      }
+      set_cpu_particle_threads( &g_cpu_particles, n );
+      print_particle_mode();
+    }
+    t_was_down     = t_is_down;
+    bool b_is_down = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) {
+      if ( PARTICLES_COMPUTE == g_particle_mode ) { benchmark_gpu_particles( tex ); }
+      if ( PARTICLES_CPU == g_particle_mode ) { benchmark_cpu_particles(); }
+    }
+    b_was_down     = b_is_down;
+    bool o_is_down = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_O );
+    if ( o_is_down && !o_was_down ) {
+      g_blend_mode = (blend_mode_t)( ( g_blend_mode + 1 ) % BLEND_MODE_COUNT );
+      if ( BLEND_SORTED == g_blend_mode && PARTICLES_CLOSED_FORM == g_particle_mode ) { printf( "closed-form particles can't be sorted, so are drawn unsorted\n" ); }
+      print_particle_mode();
+    }
+    o_was_down     = o_is_down;
+    bool p_is_down = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_P );
+    if ( p_is_down && !p_was_down ) { benchmark_transparency( vao, tex ); }
+    p_was_down = p_is_down;
+
     if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( g_window, 1 ); }
     // put the stuff we've been drawing onto the display
     glfwSwapBuffers( g_window );
   }
 
+  if ( g_has_compute ) {
+    free_gpu_particles( &g_gpu_particles );
+    free_gpu_sort( &g_gpu_sort );
+  }
+  free_cpu_particles( &g_cpu_particles );
+  free_wboit( &g_wboit );
+
   // close GL context and any other GLFW resources
   glfwTerminate();
   return 0;
@@ -0,0 +1,55 @@
+/* appends new particles to the live buffer */
+#version 430 core
+
+layout (local_size_x = 256) in;
+
+struct particle_t {
+	vec4 pos_age;  // world position, seconds since emitted
+	vec4 vel_life; // velocity, seconds until it dies
+};
+
+layout (std430, binding = 0) writeonly buffer particles_block { particle_t particles[]; };
+/* an indirect draw command (count, instances, first, base instance) for each
+particle buffer, then the update's indirect dispatch command */
+layout (std430, binding = 2) buffer state_block { uint state[]; };
+
+uniform uint n_emit;
+uniform uint seed;
+uniform uint src; // which draw command counts the live buffer
+uniform uint max_particles;
+uniform vec3 emitter_pos_wor;
+uniform float lifetime;
+uniform float max_start_age;
+
+// a cheap integer hash, good enough to scatter particles
+uint hash (uint x) {
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// random number from 0 to 1. updates the state
+float rand (inout uint state) {
+	state = hash (state);
+	return float (state >> 8) / 16777216.0;
+}
+
+void main () {
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= n_emit) {
+		return;
+	}
+	/* the count can go past the end here. the prepare step clamps it back */
+	uint slot = atomicAdd (state[src * 4u], 1u);
+	if (slot >= max_particles) {
+		return;
+	}
+	uint r = hash (i ^ (seed * 0x9e3779b9u));
+	// start velocities. randomly vary x and z components
+	vec3 v = vec3 (rand (r) - 0.5, 1.0, rand (r) - 0.5);
+	particles[slot].pos_age = vec4 (emitter_pos_wor, rand (r) * max_start_age);
+	particles[slot].vel_life = vec4 (v, lifetime);
+}
@@ -0,0 +1,30 @@
+/* makes a sort key of each live particle's depth from the camera */
+#version 430 core
+
+layout (local_size_x = 256) in;
+
+struct particle_t {
+	vec4 pos_age;  // world position, seconds since emitted
+	vec4 vel_life; // velocity, seconds until it dies
+};
+
+layout (std430, binding = 0) readonly buffer particles_block { particle_t particles[]; };
+layout (std430, binding = 2) readonly buffer state_block { uint state[]; };
+layout (std430, binding = 3) writeonly buffer keys_block { uint keys[]; };
+layout (std430, binding = 4) writeonly buffer values_block { uint values[]; };
+
+uniform uint src;
+uniform vec4 view_z; // the third row of the view matrix
+
+void main () {
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= state[src * 4u]) {
+		return;
+	}
+	// negative in front of the camera, so the farthest come first
+	float z = dot (view_z, vec4 (particles[i].pos_age.xyz, 1.0));
+	// flip the bits so that unsigned order is the same as float order
+	uint u = floatBitsToUint (z);
+	keys[i] = (u & 0x80000000u) != 0u ? ~u : u | 0x80000000u;
+	values[i] = i;
+}
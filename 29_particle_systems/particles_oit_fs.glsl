@@ -0,0 +1,22 @@
+/* adds a particle into the order-independent transparency buffers */
+#version 410 core
+
+in float opacity;
+uniform sampler2D tex;
+layout (location = 0) out vec4 accum;
+layout (location = 1) out float revealage;
+
+vec4 particle_colour = vec4 (0.4, 0.4, 0.8, 0.8);
+
+void main () {
+	vec4 texel = texture (tex, gl_PointCoord);
+	float a = opacity * texel.a;
+	vec3 colour = particle_colour.rgb * texel.rgb;
+	// distance from the camera. gl_FragCoord.w is 1 / clip-space w
+	float z = 1.0 / gl_FragCoord.w;
+	// nearer surfaces count for more in the average. one of the paper's
+	// weights, which falls off over the few units this scene covers
+	float w = a * clamp (10.0 / (0.00001 + pow (z / 5.0, 2.0) + pow (z / 200.0, 6.0)), 0.01, 3000.0);
+	accum = vec4 (colour * a, a) * w;
+	revealage = a;
+}
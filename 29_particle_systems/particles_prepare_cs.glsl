@@ -0,0 +1,22 @@
+/* runs once between emitting and updating. sets up the update's dispatch */
+#version 430 core
+
+layout (local_size_x = 1) in;
+
+layout (std430, binding = 2) buffer state_block { uint state[]; };
+
+#define GROUP_SIZE 256u
+#define DISPATCH_CMD 8
+
+uniform uint src;
+uniform uint max_particles;
+
+void main () {
+	uint n = min (state[src * 4u], max_particles);
+	state[src * 4u] = n;
+	// the update appends the survivors to the other buffer, so it starts empty
+	state[(1u - src) * 4u] = 0u;
+	state[DISPATCH_CMD] = (n + GROUP_SIZE - 1u) / GROUP_SIZE;
+	state[DISPATCH_CMD + 1] = 1u;
+	state[DISPATCH_CMD + 2] = 1u;
+}
@@ -0,0 +1,63 @@
+/* moves every live particle on, and copies the survivors into the other buffer */
+#version 430 core
+
+layout (local_size_x = 256) in;
+
+struct particle_t {
+	vec4 pos_age;  // world position, seconds since emitted
+	vec4 vel_life; // velocity, seconds until it dies
+};
+
+layout (std430, binding = 0) readonly buffer src_block { particle_t src_particles[]; };
+layout (std430, binding = 1) writeonly buffer dst_block { particle_t dst_particles[]; };
+layout (std430, binding = 2) buffer state_block { uint state[]; };
+
+uniform float dt;
+uniform uint src;
+uniform vec3 gravity;
+uniform float ground_y;
+
+// survivors in this work group, and where they go in the other buffer
+shared uint group_count;
+shared uint group_first;
+
+void main () {
+	if (gl_LocalInvocationIndex == 0u) {
+		group_count = 0u;
+	}
+	barrier ();
+
+	uint i = gl_GlobalInvocationID.x;
+	particle_t p;
+	bool alive = false;
+	if (i < state[src * 4u]) {
+		p = src_particles[i];
+		p.pos_age.w += dt;
+		alive = p.pos_age.w < p.vel_life.w;
+	}
+	if (alive) {
+		// semi-implicit Euler. velocity first, then position with the new velocity
+		p.vel_life.xyz += gravity * dt;
+		p.pos_age.xyz += p.vel_life.xyz * dt;
+		// bounce off the ground, losing half the speed and some sideways drift
+		if (p.pos_age.y < ground_y && p.vel_life.y < 0.0) {
+			p.pos_age.y = ground_y;
+			p.vel_life.y *= -0.5;
+			p.vel_life.xz *= 0.8;
+		}
+	}
+
+	/* one atomic per group on the global count rather than one per particle */
+	uint slot = 0u;
+	if (alive) {
+		slot = atomicAdd (group_count, 1u);
+	}
+	barrier ();
+	if (gl_LocalInvocationIndex == 0u) {
+		group_first = atomicAdd (state[(1u - src) * 4u], group_count);
+	}
+	barrier ();
+	if (alive) {
+		dst_particles[group_first + slot] = p;
+	}
+}
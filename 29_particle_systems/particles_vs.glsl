@@ -0,0 +1,19 @@
+/* draws particles straight out of the compute shaders' buffer */
+#version 410 core
+
+layout (location = 0) in vec4 pos_age;  // world position, seconds since emitted
+layout (location = 1) in vec4 vel_life; // velocity, seconds until it dies
+
+uniform mat4 V, P;
+uniform float point_size = 15.0; // size in pixels
+
+// the fragment shader can use this for it's output colour's alpha component
+out float opacity;
+
+void main() {
+	// gradually make particle fade to invisible over its lifetime
+	opacity = 1.0 - pos_age.w / vel_life.w;
+
+	gl_Position = P * V * vec4 (pos_age.xyz, 1.0);
+	gl_PointSize = point_size;
+}
@@ -0,0 +1,42 @@
+/* counts how many of a tile's keys have each digit */
+#version 430 core
+
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 0) readonly buffer keys_in_block { uint keys_in[]; };
+layout (std430, binding = 4) writeonly buffer counts_block { uint counts[]; };
+layout (std430, binding = 6) readonly buffer state_block { uint state[]; };
+
+#define TILE 1024u
+#define DIGITS 16u
+#define ITEMS 4u // keys per invocation
+#define N 0
+
+uniform uint shift; // which 4 bits of the keys this pass sorts by
+
+shared uint group_counts[DIGITS];
+
+void main () {
+	uint t = gl_LocalInvocationIndex;
+	if (t < DIGITS) {
+		group_counts[t] = 0u;
+	}
+	barrier ();
+
+	uint n = state[N];
+	uint tile = gl_WorkGroupID.x;
+	for (uint k = 0u; k < ITEMS; k++) {
+		uint i = tile * TILE + t * ITEMS + k;
+		if (i < n) {
+			atomicAdd (group_counts[(keys_in[i] >> shift) & (DIGITS - 1u)], 1u);
+		}
+	}
+	barrier ();
+
+	// digit by digit, so that a prefix sum over the whole array gives each
+	// tile's start for each digit
+	if (t < DIGITS) {
+		uint n_tiles = (n + TILE - 1u) / TILE;
+		counts[t * n_tiles + tile] = group_counts[t];
+	}
+}
@@ -0,0 +1,33 @@
+/* runs once before a sort. sets up its dispatches and the sorted draw */
+#version 430 core
+
+layout (local_size_x = 1) in;
+
+layout (std430, binding = 6) buffer state_block { uint state[]; };
+
+#define TILE 1024u
+#define DIGITS 16u
+#define SCAN_BLOCK 1024u
+#define N 0
+#define TILE_DISPATCH 1
+#define SCAN_DISPATCH 4
+#define DRAW_CMD 7
+
+uniform uint max_keys;
+
+void main () {
+	uint n = min (state[N], max_keys);
+	state[N] = n;
+	uint n_tiles = (n + TILE - 1u) / TILE;
+	state[TILE_DISPATCH] = n_tiles;
+	state[TILE_DISPATCH + 1] = 1u;
+	state[TILE_DISPATCH + 2] = 1u;
+	state[SCAN_DISPATCH] = (n_tiles * DIGITS + SCAN_BLOCK - 1u) / SCAN_BLOCK;
+	state[SCAN_DISPATCH + 1] = 1u;
+	state[SCAN_DISPATCH + 2] = 1u;
+	state[DRAW_CMD] = n;
+	state[DRAW_CMD + 1] = 1u;
+	state[DRAW_CMD + 2] = 0u;
+	state[DRAW_CMD + 3] = 0u;
+	state[DRAW_CMD + 4] = 0u;
+}
@@ -0,0 +1,53 @@
+/* a prefix sum of the digit counts, a block of 1024 per work group. each
+block's total goes in block_sums for sort_scan_sums_cs.glsl to add up */
+#version 430 core
+
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 4) buffer counts_block { uint counts[]; };
+layout (std430, binding = 5) writeonly buffer block_sums_block { uint block_sums[]; };
+layout (std430, binding = 6) readonly buffer state_block { uint state[]; };
+
+#define GROUP_SIZE 256u
+#define TILE 1024u
+#define DIGITS 16u
+#define ITEMS 4u // counts per invocation
+#define N 0
+
+shared uint scan_tmp[GROUP_SIZE];
+
+/* the sum of x over the invocations before this one. every invocation must
+call it */
+uint group_exclusive_scan (uint x) {
+	uint t = gl_LocalInvocationIndex;
+	scan_tmp[t] = x;
+	barrier ();
+	for (uint offset = 1u; offset < GROUP_SIZE; offset <<= 1) {
+		uint y = t >= offset ? scan_tmp[t - offset] : 0u;
+		barrier ();
+		scan_tmp[t] += y;
+		barrier ();
+	}
+	return scan_tmp[t] - x;
+}
+
+void main () {
+	uint n_counts = (state[N] + TILE - 1u) / TILE * DIGITS;
+	uint first = gl_WorkGroupID.x * GROUP_SIZE * ITEMS + gl_LocalInvocationIndex * ITEMS;
+	uint c[ITEMS];
+	uint sum = 0u;
+	for (uint k = 0u; k < ITEMS; k++) {
+		c[k] = first + k < n_counts ? counts[first + k] : 0u;
+		sum += c[k];
+	}
+	uint running = group_exclusive_scan (sum);
+	for (uint k = 0u; k < ITEMS; k++) {
+		if (first + k < n_counts) {
+			counts[first + k] = running;
+		}
+		running += c[k];
+	}
+	if (gl_LocalInvocationIndex == GROUP_SIZE - 1u) {
+		block_sums[gl_WorkGroupID.x] = running;
+	}
+}
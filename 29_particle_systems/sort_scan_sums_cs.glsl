@@ -0,0 +1,47 @@
+/* a prefix sum of the block totals from sort_scan_cs.glsl, in one work group.
+up to 1024 blocks - enough for 64M keys */
+#version 430 core
+
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 5) buffer block_sums_block { uint block_sums[]; };
+layout (std430, binding = 6) readonly buffer state_block { uint state[]; };
+
+#define GROUP_SIZE 256u
+#define ITEMS 4u // totals per invocation
+#define SCAN_DISPATCH 4
+
+shared uint scan_tmp[GROUP_SIZE];
+
+/* the sum of x over the invocations before this one. every invocation must
+call it */
+uint group_exclusive_scan (uint x) {
+	uint t = gl_LocalInvocationIndex;
+	scan_tmp[t] = x;
+	barrier ();
+	for (uint offset = 1u; offset < GROUP_SIZE; offset <<= 1) {
+		uint y = t >= offset ? scan_tmp[t - offset] : 0u;
+		barrier ();
+		scan_tmp[t] += y;
+		barrier ();
+	}
+	return scan_tmp[t] - x;
+}
+
+void main () {
+	uint n_blocks = state[SCAN_DISPATCH];
+	uint first = gl_LocalInvocationIndex * ITEMS;
+	uint c[ITEMS];
+	uint sum = 0u;
+	for (uint k = 0u; k < ITEMS; k++) {
+		c[k] = first + k < n_blocks ? block_sums[first + k] : 0u;
+		sum += c[k];
+	}
+	uint running = group_exclusive_scan (sum);
+	for (uint k = 0u; k < ITEMS; k++) {
+		if (first + k < n_blocks) {
+			block_sums[first + k] = running;
+		}
+		running += c[k];
+	}
+}
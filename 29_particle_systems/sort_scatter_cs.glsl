@@ -0,0 +1,96 @@
+/* writes a tile's keys and values to where they go in this pass's order */
+#version 430 core
+
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 0) readonly buffer keys_in_block { uint keys_in[]; };
+layout (std430, binding = 1) readonly buffer values_in_block { uint values_in[]; };
+layout (std430, binding = 2) writeonly buffer keys_out_block { uint keys_out[]; };
+layout (std430, binding = 3) writeonly buffer values_out_block { uint values_out[]; };
+layout (std430, binding = 4) readonly buffer counts_block { uint counts[]; };
+layout (std430, binding = 5) readonly buffer block_sums_block { uint block_sums[]; };
+layout (std430, binding = 6) readonly buffer state_block { uint state[]; };
+
+#define GROUP_SIZE 256u
+#define TILE 1024u
+#define DIGITS 16u
+#define ITEMS 4u // keys per invocation, one after the other
+#define SCAN_BLOCK 1024u
+#define N 0
+
+uniform uint shift; // which 4 bits of the keys this pass sorts by
+
+/* how many keys each invocation has of each digit, digit by digit. after the
+scan it is how many keys in the tile come before an invocation's first key
+with that digit */
+shared uint digit_counts[DIGITS * GROUP_SIZE];
+shared uint scan_tmp[GROUP_SIZE];
+
+/* the sum of x over the invocations before this one. every invocation must
+call it */
+uint group_exclusive_scan (uint x) {
+	uint t = gl_LocalInvocationIndex;
+	scan_tmp[t] = x;
+	barrier ();
+	for (uint offset = 1u; offset < GROUP_SIZE; offset <<= 1) {
+		uint y = t >= offset ? scan_tmp[t - offset] : 0u;
+		barrier ();
+		scan_tmp[t] += y;
+		barrier ();
+	}
+	return scan_tmp[t] - x;
+}
+
+void main () {
+	uint t = gl_LocalInvocationIndex;
+	uint n = state[N];
+	uint n_tiles = (n + TILE - 1u) / TILE;
+	uint tile = gl_WorkGroupID.x;
+	uint first = tile * TILE + t * ITEMS;
+
+	for (uint d = 0u; d < DIGITS; d++) {
+		digit_counts[d * GROUP_SIZE + t] = 0u;
+	}
+	// each key's rank among this invocation's keys with the same digit. only
+	// this invocation touches its own column, so no atomics
+	uint key[ITEMS], digit[ITEMS], rank[ITEMS];
+	for (uint k = 0u; k < ITEMS; k++) {
+		if (first + k < n) {
+			key[k] = keys_in[first + k];
+			digit[k] = (key[k] >> shift) & (DIGITS - 1u);
+			rank[k] = digit_counts[digit[k] * GROUP_SIZE + t]++;
+		}
+	}
+	barrier ();
+
+	// prefix sum over all 4096 counts. each invocation adds up 16 in a row,
+	// then the invocations' totals are scanned
+	uint c[DIGITS];
+	uint sum = 0u;
+	for (uint j = 0u; j < DIGITS; j++) {
+		c[j] = digit_counts[t * DIGITS + j];
+		sum += c[j];
+	}
+	uint running = group_exclusive_scan (sum);
+	for (uint j = 0u; j < DIGITS; j++) {
+		digit_counts[t * DIGITS + j] = running;
+		running += c[j];
+	}
+	barrier ();
+
+	for (uint k = 0u; k < ITEMS; k++) {
+		if (first + k < n) {
+			uint d = digit[k];
+			// where this tile's keys with digit d start in the output
+			uint e = d * n_tiles + tile;
+			uint tile_start = counts[e] + block_sums[e / SCAN_BLOCK];
+			// keys in the tile before this one with the same digit. the scan
+			// gives the keys before it with a lower digit too, and the first
+			// invocation's entry is how many of those there are
+			uint before = digit_counts[d * GROUP_SIZE + t] - digit_counts[d * GROUP_SIZE];
+			uint dst = tile_start + before + rank[k];
+			keys_out[dst] = key[k];
+			values_out[dst] = values_in[first + k];
+		}
+	}
+}
@@ -76,8 +76,10 @@ bool start_gl() {
     return false;
   }
 
+  /* 4.3 has compute shaders, for image_kernel.h. macOS stops at 4.1 so fall
+  back to that if a 4.3 window can't be made */
   glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
-  glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 1 );
+  glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 3 );
   glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
   glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
   glfwWindowHint( GLFW_SAMPLES, 4 );
@@ -89,6 +91,10 @@ bool start_gl() {
   );*/
 
   g_window = glfwCreateWindow( g_gl_width, g_gl_height, "Extended Init.", NULL, NULL );
+  if ( !g_window ) {
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 1 );
+    g_window = glfwCreateWindow( g_gl_width, g_gl_height, "Extended Init.", NULL, NULL );
+  }
   if ( !g_window ) {
     fprintf( stderr, "ERROR: could not open window with GLFW3\n" );
     glfwTerminate();
@@ -0,0 +1,286 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Image kernels for post-processing, as 2D, separable, and compute passes.     |
+\******************************************************************************/
+#include "image_kernel.h"
+#include "gl_utils.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/* pixels along a row or column per work group. kernel_cs.glsl has the same */
+#define IMAGE_KERNEL_TILE 128
+/* a weight this far from col[y] * row[x], relative to the biggest, still counts
+as separable */
+#define IMAGE_KERNEL_SEPARABLE_TOLERANCE 1e-4f
+
+bool gaussian_image_kernel( float sigma, image_kernel_t* kernel ) {
+  int radius = sigma > 0.0f ? (int)ceilf( 3.0f * sigma ) : 0;
+  bool fits  = radius <= IMAGE_KERNEL_MAX_RADIUS;
+  if ( !fits ) { radius = IMAGE_KERNEL_MAX_RADIUS; }
+
+  memset( kernel, 0, sizeof( image_kernel_t ) );
+  kernel->size      = 2 * radius + 1;
+  kernel->separable = true;
+  double line[IMAGE_KERNEL_MAX_SIZE];
+  double sum = 0.0;
+  for ( int i = 0; i < kernel->size; i++ ) {
+    double x = i - radius;
+    double s = sigma * sqrt( 2.0 );
+    line[i]  = radius > 0 ? 0.5 * ( erf( ( x + 0.5 ) / s ) - erf( ( x - 0.5 ) / s ) ) : 1.0;
+    sum += line[i];
+  }
+  /* what's past 3 sigma is spread back over the rest */
+  for ( int i = 0; i < kernel->size; i++ ) {
+    kernel->row[i] = (float)( line[i] / sum );
+    kernel->col[i] = kernel->row[i];
+  }
+  for ( int y = 0; y < kernel->size; y++ ) {
+    for ( int x = 0; x < kernel->size; x++ ) { kernel->weights[y * kernel->size + x] = kernel->col[y] * kernel->row[x]; }
+  }
+  return fits;
+}
+
+bool create_image_kernel( const float* weights, int size, image_kernel_t* kernel ) {
+  if ( size < 1 || size > IMAGE_KERNEL_MAX_SIZE || 0 == size % 2 ) {
+    gl_log_err( "ERROR: image kernel size %i. it has to be odd, and up to %i\n", size, IMAGE_KERNEL_MAX_SIZE );
+    return false;
+  }
+  memset( kernel, 0, sizeof( image_kernel_t ) );
+  kernel->size = size;
+  memcpy( kernel->weights, weights, sizeof( float ) * size * size );
+
+  /* if it is a column times a row, then the column through its biggest weight,
+  and the row through it divided by that weight, are those two */
+  int biggest = 0;
+  for ( int i = 1; i < size * size; i++ ) {
+    if ( fabsf( weights[i] ) > fabsf( weights[biggest] ) ) { biggest = i; }
+  }
+  float pivot = weights[biggest];
+  if ( 0.0f == pivot ) { return true; }
+  int py = biggest / size, px = biggest % size;
+  for ( int i = 0; i < size; i++ ) {
+    kernel->col[i] = weights[i * size + px];
+    kernel->row[i] = weights[py * size + i] / pivot;
+  }
+  kernel->separable = true;
+  for ( int y = 0; y < size && kernel->separable; y++ ) {
+    for ( int x = 0; x < size; x++ ) {
+      if ( fabsf( weights[y * size + x] - kernel->col[y] * kernel->row[x] ) > IMAGE_KERNEL_SEPARABLE_TOLERANCE * fabsf( pivot ) ) {
+        kernel->separable = false;
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+static void add_tap( float* taps, int* n_taps, float x, float y, float weight ) {
+  taps[*n_taps * 3 + 0] = x;
+  taps[*n_taps * 3 + 1] = y;
+  taps[*n_taps * 3 + 2] = weight;
+  ( *n_taps )++;
+}
+
+/* the taps of one line of weights, where line[i] weights the texel i - radius
+along dx, dy. merging pairs outwards from the centre keeps a symmetric kernel's
+taps symmetric. a pair only merges if both weights have the same sign, as
+otherwise the offset between them would be outside the two texels */
+static int line_taps( const float* line, int size, int dx, int dy, bool merge, float* taps ) {
+  int radius = size / 2, n_taps = 0;
+  if ( 0.0f != line[radius] ) { add_tap( taps, &n_taps, 0.0f, 0.0f, line[radius] ); }
+  for ( int side = -1; side <= 1; side += 2 ) {
+    for ( int d = 1; d <= radius; d++ ) {
+      float wa = line[radius + side * d];
+      float wb = d < radius ? line[radius + side * ( d + 1 )] : 0.0f;
+      if ( merge && wa * wb > 0.0f ) {
+        float offset = side * ( d * wa + ( d + 1 ) * wb ) / ( wa + wb );
+        add_tap( taps, &n_taps, offset * dx, offset * dy, wa + wb );
+        d++;
+      } else if ( 0.0f != wa ) {
+        add_tap( taps, &n_taps, (float)( side * d * dx ), (float)( side * d * dy ), wa );
+      }
+    }
+  }
+  return n_taps;
+}
+
+int plan_image_kernel( const image_kernel_engine_t* engine, const image_kernel_t* kernel, image_kernel_method_t method, image_kernel_pass_t* passes ) {
+  int size = kernel->size, radius = kernel->size / 2;
+  memset( passes, 0, sizeof( image_kernel_pass_t ) * 2 );
+  if ( KERNEL_METHOD_2D == method ) {
+    /* the top row is written first, but is up the texture, at +y */
+    for ( int y = 0; y < size; y++ ) {
+      for ( int x = 0; x < size; x++ ) {
+        float weight = kernel->weights[y * size + x];
+        if ( 0.0f == weight ) { continue; }
+        if ( passes[0].n_taps >= IMAGE_KERNEL_MAX_TAPS ) { return 0; }
+        add_tap( passes[0].taps, &passes[0].n_taps, (float)( x - radius ), (float)( radius - y ), weight );
+      }
+    }
+    return 1;
+  }
+  if ( !kernel->separable ) { return 0; }
+  if ( KERNEL_METHOD_COMPUTE == method && !engine->compute_programme ) { return 0; }
+
+  /* the column from the bottom up, the way the texture goes */
+  float col[IMAGE_KERNEL_MAX_SIZE];
+  for ( int i = 0; i < size; i++ ) { col[i] = kernel->col[size - 1 - i]; }
+  const float* lines[2] = { kernel->row, col };
+  for ( int p = 0; p < 2; p++ ) {
+    passes[p].compute = KERNEL_METHOD_COMPUTE == method;
+    passes[p].dx      = 0 == p;
+    passes[p].dy      = 1 == p;
+    passes[p].size    = size;
+    memcpy( passes[p].weights, lines[p], sizeof( float ) * size );
+    passes[p].n_taps = line_taps( lines[p], size, passes[p].dx, passes[p].dy, KERNEL_METHOD_SEPARABLE_LINEAR == method, passes[p].taps );
+  }
+  return 2;
+}
+
+const char* image_kernel_method_name( image_kernel_method_t method ) {
+  switch ( method ) {
+  case KERNEL_METHOD_2D: return "2D";
+  case KERNEL_METHOD_SEPARABLE: return "separable";
+  case KERNEL_METHOD_SEPARABLE_LINEAR: return "separable linear";
+  case KERNEL_METHOD_COMPUTE: return "compute";
+  default: return "unknown";
+  }
+}
+
+static GLuint create_compute_programme( const char* file_name ) {
+  GLuint shader = 0;
+  if ( !create_shader( file_name, &shader, GL_COMPUTE_SHADER ) ) {
+    glDeleteShader( shader );
+    return 0;
+  }
+  GLuint programme = glCreateProgram();
+  glAttachShader( programme, shader );
+  glLinkProgram( programme );
+  glDeleteShader( shader );
+  int params = -1;
+  glGetProgramiv( programme, GL_LINK_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    char log[2048];
+    glGetProgramInfoLog( programme, sizeof( log ), NULL, log );
+    gl_log_err( "ERROR: could not link compute shader %s\n%s\n", file_name, log );
+    glDeleteProgram( programme );
+    return 0;
+  }
+  return programme;
+}
+
+bool init_image_kernel_engine( image_kernel_engine_t* engine, GLuint quad_vao, const char* vert_file_name, const char* frag_file_name, const char* compute_file_name ) {
+  memset( engine, 0, sizeof( image_kernel_engine_t ) );
+  engine->quad_vao = quad_vao;
+  if ( !init_shader_variants( &engine->variants, vert_file_name, frag_file_name ) ) { return false; }
+  engine->kernel_key = add_variant_key( &engine->variants, "KERNEL", 1 );
+  if ( engine->kernel_key < 0 ) { return false; }
+
+  if ( !GLEW_VERSION_4_3 && !GLEW_ARB_compute_shader ) {
+    gl_log( "no compute shaders, so no compute image kernels\n" );
+    return true;
+  }
+  engine->compute_programme = create_compute_programme( compute_file_name );
+  if ( !engine->compute_programme ) { return true; }
+  engine->compute_size_loc      = glGetUniformLocation( engine->compute_programme, "size" );
+  engine->compute_direction_loc = glGetUniformLocation( engine->compute_programme, "direction" );
+  engine->compute_weights_loc   = glGetUniformLocation( engine->compute_programme, "weights" );
+  engine->compute_src_loc       = glGetUniformLocation( engine->compute_programme, "src" );
+  engine->compute_dst_loc       = glGetUniformLocation( engine->compute_programme, "dst" );
+  return true;
+}
+
+void free_image_kernel_engine( image_kernel_engine_t* engine ) {
+  free_shader_variants( &engine->variants );
+  if ( engine->compute_programme ) { glDeleteProgram( engine->compute_programme ); }
+  free_image_kernel_target( &engine->middle );
+  memset( engine, 0, sizeof( image_kernel_engine_t ) );
+}
+
+bool create_image_kernel_target( image_kernel_target_t* target, int width, int height, GLenum format ) {
+  memset( target, 0, sizeof( image_kernel_target_t ) );
+  target->format = format;
+  target->width  = width;
+  target->height = height;
+  glGenTextures( 1, &target->tex );
+  glBindTexture( GL_TEXTURE_2D, target->tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glGenFramebuffers( 1, &target->fb );
+  glBindFramebuffer( GL_FRAMEBUFFER, target->fb );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->tex, 0 );
+  GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  if ( GL_FRAMEBUFFER_COMPLETE != status ) {
+    gl_log_err( "ERROR: incomplete image kernel framebuffer %ix%i\n", width, height );
+    free_image_kernel_target( target );
+    return false;
+  }
+  return true;
+}
+
+void free_image_kernel_target( image_kernel_target_t* target ) {
+  if ( target->fb ) { glDeleteFramebuffers( 1, &target->fb ); }
+  if ( target->tex ) { glDeleteTextures( 1, &target->tex ); }
+  memset( target, 0, sizeof( image_kernel_target_t ) );
+}
+
+void run_image_kernel_pass( image_kernel_engine_t* engine, const image_kernel_pass_t* pass, GLuint src_tex, const image_kernel_target_t* dst ) {
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( GL_TEXTURE_2D, src_tex );
+  if ( pass->compute ) {
+    glUseProgram( engine->compute_programme );
+    glUniform1i( engine->compute_src_loc, 0 );
+    glUniform1i( engine->compute_dst_loc, 0 );
+    glUniform1i( engine->compute_size_loc, pass->size );
+    glUniform2i( engine->compute_direction_loc, pass->dx, pass->dy );
+    glUniform1fv( engine->compute_weights_loc, pass->size, pass->weights );
+    glBindImageTexture( 0, dst->tex, 0, GL_FALSE, 0, GL_WRITE_ONLY, dst->format );
+    int length = pass->dx ? dst->width : dst->height;
+    int lines  = pass->dx ? dst->height : dst->width;
+    glDispatchCompute( ( length + IMAGE_KERNEL_TILE - 1 ) / IMAGE_KERNEL_TILE, lines, 1 );
+    /* before anything samples the texture or reads it through its framebuffer */
+    glMemoryBarrier( GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT );
+    return;
+  }
+  GLuint programme = get_variant( &engine->variants, variant_key_bits( &engine->variants, engine->kernel_key, 1 ) );
+  glBindFramebuffer( GL_FRAMEBUFFER, dst->fb );
+  glViewport( 0, 0, dst->width, dst->height );
+  if ( programme != engine->taps_programme ) {
+    engine->taps_programme  = programme;
+    engine->taps_n_taps_loc = glGetUniformLocation( programme, "n_taps" );
+    engine->taps_taps_loc   = glGetUniformLocation( programme, "taps" );
+  }
+  glUseProgram( programme );
+  glUniform1i( engine->taps_n_taps_loc, pass->n_taps );
+  glUniform3fv( engine->taps_taps_loc, pass->n_taps, pass->taps );
+  glBindVertexArray( engine->quad_vao );
+  glDrawArrays( GL_TRIANGLES, 0, 6 );
+}
+
+bool apply_image_kernel( image_kernel_engine_t* engine, const image_kernel_t* kernel, image_kernel_method_t method, GLuint src_tex, const image_kernel_target_t* dst ) {
+  image_kernel_pass_t passes[2];
+  int n_passes = plan_image_kernel( engine, kernel, method, passes );
+  if ( 0 == n_passes ) { return false; }
+  if ( 1 == n_passes ) {
+    run_image_kernel_pass( engine, &passes[0], src_tex, dst );
+    return true;
+  }
+  if ( engine->middle.width != dst->width || engine->middle.height != dst->height ) {
+    free_image_kernel_target( &engine->middle );
+    if ( !create_image_kernel_target( &engine->middle, dst->width, dst->height, GL_RGBA16F ) ) { return false; }
+  }
+  run_image_kernel_pass( engine, &passes[0], src_tex, &engine->middle );
+  run_image_kernel_pass( engine, &passes[1], engine->middle.tex, dst );
+  return true;
+}
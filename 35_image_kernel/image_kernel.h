@@ -0,0 +1,122 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Image kernels for post-processing: blurs, sharpens, edge detection...        |
+| A kernel is a square of weights, and each output pixel is the sum of the     |
+| pixels around it, times their weights. A size x size kernel, done directly,  |
+| takes size x size texture fetches a pixel.                                   |
+| Most useful kernels, the Gaussian blur among them, are separable: the square |
+| is a column of weights times a row. Those are done in two passes instead, a  |
+| row then a column, through a second texture, for 2 x size fetches.           |
+| The fetches of a pass can be halved again by letting the texture unit mix    |
+| two neighbouring texels. Sampling between texels a and b, at                 |
+|   (a wa + b wb) / (wa + wb)                                                  |
+| with a linear filter, and weighting by wa + wb, gives wa A + wb B in one.    |
+| Or a pass can be a compute shader, where a work group reads its tile of a    |
+| row or column, and the kernel's radius either side, into shared memory once, |
+| and every pixel of the tile sums its taps from there.                        |
+| Compute shaders need OpenGL 4.3. Without it only the fragment methods work.  |
+\******************************************************************************/
+#ifndef _IMAGE_KERNEL_H_
+#define _IMAGE_KERNEL_H_
+
+#include "shader_variants.h"
+#include <GL/glew.h>
+
+/* kernel_cs.glsl has the same limit */
+#define IMAGE_KERNEL_MAX_RADIUS 31
+#define IMAGE_KERNEL_MAX_SIZE ( 2 * IMAGE_KERNEL_MAX_RADIUS + 1 )
+/* fetches a fragment pass can take. post.frag has the same limit */
+#define IMAGE_KERNEL_MAX_TAPS 81
+
+/* a size x size kernel, row by row, centred on the middle weight */
+struct image_kernel_t {
+  int size;
+  float weights[IMAGE_KERNEL_MAX_SIZE * IMAGE_KERNEL_MAX_SIZE];
+  /* set if weights[y * size + x] is col[y] * row[x] */
+  bool separable;
+  float row[IMAGE_KERNEL_MAX_SIZE], col[IMAGE_KERNEL_MAX_SIZE];
+};
+
+enum image_kernel_method_t {
+  KERNEL_METHOD_2D = 0,           // one pass, size x size fetches
+  KERNEL_METHOD_SEPARABLE,        // a row pass and a column pass, size fetches each
+  KERNEL_METHOD_SEPARABLE_LINEAR, // the same, with pairs of taps merged into one linear fetch
+  KERNEL_METHOD_COMPUTE,          // the same two passes, as compute shaders reading a tile at a time
+  KERNEL_METHOD_COUNT
+};
+
+/* one pass of a method */
+struct image_kernel_pass_t {
+  bool compute;
+  /* fragment passes: each tap is an offset in texels, x and y, and a weight */
+  int n_taps;
+  float taps[IMAGE_KERNEL_MAX_TAPS * 3];
+  /* compute passes: size weights, along the row, dx = 1, or the column, dy = 1 */
+  int dx, dy;
+  int size;
+  float weights[IMAGE_KERNEL_MAX_SIZE];
+};
+
+/* a texture to filter into, linear filtered, with a framebuffer */
+struct image_kernel_target_t {
+  GLuint fb, tex;
+  GLenum format;
+  int width, height;
+};
+
+struct image_kernel_engine_t {
+  /* fragment passes, from the KERNEL variant key of post.frag: 0 copies the
+  texture, 1 sums the taps */
+  shader_variants_t variants;
+  int kernel_key;
+  /* the tap-summing variant is built the first time it's used. its uniform
+  locations are looked up then, not on every pass */
+  GLuint taps_programme;
+  GLint taps_n_taps_loc, taps_taps_loc;
+  GLuint quad_vao;
+  /* 0 without compute shaders */
+  GLuint compute_programme;
+  GLint compute_size_loc, compute_direction_loc, compute_weights_loc, compute_src_loc, compute_dst_loc;
+  /* between the two passes of a separable method. half floats, as the row
+  pass of a kernel can be out of the 0 to 1 range, e.g. negative for an edge
+  detector. RGBA8 would clamp it, and lose precision */
+  image_kernel_target_t middle;
+};
+
+/* a Gaussian blur, out to 3 sigma either side, with each weight the integral
+of the curve over its pixel rather than its value at the centre, which matters
+for small sigma. returns false if sigma needs more than IMAGE_KERNEL_MAX_RADIUS
+pixels, and makes the largest kernel that fits */
+bool gaussian_image_kernel( float sigma, image_kernel_t* kernel );
+/* any size x size kernel, size odd. works out if it is separable. returns false
+if the size is too big or even */
+bool create_image_kernel( const float* weights, int size, image_kernel_t* kernel );
+/* fills in the passes, 1 or 2, that a method takes for a kernel. returns 0 if
+the method can't do it: the separable methods need a separable kernel, the 2D
+method no more than IMAGE_KERNEL_MAX_TAPS weights that aren't 0, and the
+compute method needs compute shaders */
+int plan_image_kernel( const image_kernel_engine_t* engine, const image_kernel_t* kernel, image_kernel_method_t method, image_kernel_pass_t* passes );
+const char* image_kernel_method_name( image_kernel_method_t method );
+
+/* compiles the shaders. quad_vao has the 2 triangles over the screen that
+post.vert expects. compute_file_name is skipped without OpenGL 4.3 */
+bool init_image_kernel_engine( image_kernel_engine_t* engine, GLuint quad_vao, const char* vert_file_name, const char* frag_file_name, const char* compute_file_name );
+void free_image_kernel_engine( image_kernel_engine_t* engine );
+/* format is a sized format, e.g. GL_RGBA8, so compute passes can write it */
+bool create_image_kernel_target( image_kernel_target_t* target, int width, int height, GLenum format );
+void free_image_kernel_target( image_kernel_target_t* target );
+
+/* one pass from a texture into a target. the texture should be as big as the
+target, and have a linear filter and clamp to its edges for merged taps */
+void run_image_kernel_pass( image_kernel_engine_t* engine, const image_kernel_pass_t* pass, GLuint src_tex, const image_kernel_target_t* dst );
+/* filters a texture into a target with all the passes of a method. returns
+false if the method can't do the kernel. changes the viewport and framebuffer */
+bool apply_image_kernel( image_kernel_engine_t* engine, const image_kernel_t* kernel, image_kernel_method_t method, GLuint src_tex, const image_kernel_target_t* dst );
+
+#endif
@@ -0,0 +1,51 @@
+#version 430
+
+// one pass of a separable image kernel (see image_kernel.h), along each row
+// of the image, or each column. a work group does TILE pixels of one line. it
+// reads them, and the kernel's radius either side, into shared memory once,
+// instead of every pixel fetching all of its taps from the texture
+#define TILE 128
+#define MAX_RADIUS 31
+layout (local_size_x = TILE) in;
+
+uniform sampler2D src;
+// RGBA8, or half floats between the passes. a write-only image doesn't need
+// its format here
+writeonly uniform image2D dst;
+// (1, 0) along rows, (0, 1) along columns
+uniform ivec2 direction;
+// size weights, for the texels -size / 2 to size / 2 along the line
+uniform int size;
+uniform float weights[2 * MAX_RADIUS + 1];
+
+shared vec4 cache[TILE + 2 * MAX_RADIUS];
+
+// texel `along` of line `line`
+ivec2 line_texel (int along, int line) {
+	return direction.x != 0 ? ivec2 (along, line) : ivec2 (line, along);
+}
+
+void main () {
+	ivec2 dims = textureSize (src, 0);
+	int length = direction.x != 0 ? dims.x : dims.y;
+	int line = int (gl_WorkGroupID.y);
+	int first = int (gl_WorkGroupID.x) * TILE;
+	int radius = size / 2;
+	int local = int (gl_LocalInvocationID.x);
+
+	// the tile, and radius texels either side, clamped to the edge
+	for (int i = local; i < TILE + 2 * radius; i += TILE) {
+		int along = clamp (first - radius + i, 0, length - 1);
+		cache[i] = texelFetch (src, line_texel (along, line), 0);
+	}
+	barrier ();
+
+	if (first + local >= length) {
+		return;
+	}
+	vec4 colour = vec4 (0.0);
+	for (int i = 0; i < size; i++) {
+		colour += cache[local + i] * weights[i];
+	}
+	imageStore (dst, line_texel (first + local, line), vec4 (colour.rgb, 1.0));
+}
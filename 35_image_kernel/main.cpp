@@ -7,21 +7,36 @@
 | See individual libraries for separate legal notices                          |
 |******************************************************************************|
 | Doing post-processing with a secondary framebuffer                           |
+| The right half is blurred with a Gaussian kernel from image_kernel.h         |
+|                                                                              |
+| controls:                                                                    |
+| benchmark uber shader vs specialised variants = b key                        |
+| benchmark image kernel methods at 1080p and 4K = k key                       |
+| next kernel method = m key                                                   |
+| blur sigma up/down = up/down arrow keys                                      |
 \******************************************************************************/
 
 #include "gl_utils.h"
+#include "image_kernel.h"
 #include "maths_funcs.h"
 #include "obj_parser.h"
+#include "shader_variants.h"
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h> // GLFW helper library
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define POST_VS "post.vert"
 #define POST_FS "post.frag"
+#define KERNEL_CS "kernel_cs.glsl"
 #define SPHERE_VS "sphere.vert"
 #define SPHERE_FS "sphere.frag"
 #define MESH_FILE "sphere.obj"
+/* number of frames to time each shader permutation for in the benchmark */
+#define BENCH_FRAMES 200
+/* and each image kernel pass, which is a lot slower at 4K */
+#define KERNEL_BENCH_FRAMES 20
 
 /* window global variables */
 int g_gl_width       = 800;
@@ -38,6 +53,24 @@ GLuint g_ss_quad_vao = 0;
 GLuint g_sphere_vao      = 0;
 int g_sphere_point_count = 0;
 
+/* post-processing passes. the shader is built as permutations of the KERNEL
+feature key */
+image_kernel_engine_t g_kernels;
+/* the blur on the rhs, and the texture it is filtered into */
+image_kernel_t g_blur;
+float g_blur_sigma                  = 1.0f;
+image_kernel_method_t g_blur_method = KERNEL_METHOD_SEPARABLE_LINEAR;
+image_kernel_target_t g_blur_target;
+
+/* the 5x5 Gaussian that post.frag used to sample with 25 fetches */
+const float g_old_blur_weights[25] = {
+  0.00048031, 0.00500493, 0.01093176, 0.00500493, 0.00048031,
+  0.00500493, 0.05215252, 0.11391157, 0.05215252, 0.00500493,
+  0.01093176, 0.11391157, 0.24880573, 0.11391157, 0.01093176,
+  0.00500493, 0.05215252, 0.11391157, 0.05215252, 0.00500493,
+  0.00048031, 0.00500493, 0.01093176, 0.00500493, 0.00048031
+};
+
 /* initialise secondary framebuffer. this will just allow us to render our main
 scene to a texture instead of directly to the screen. returns false if something
 went wrong in the framebuffer creation */
@@ -47,11 +80,12 @@ bool init_fb() {
   dimensions as the viewport */
   glGenTextures( 1, &g_fb_tex );
   glBindTexture( GL_TEXTURE_2D, g_fb_tex );
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, g_gl_width, g_gl_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, g_gl_width, g_gl_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+  /* kernels read past the edges, and merged taps sample between texels */
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
   /* attach the texture to the framebuffer */
   glBindFramebuffer( GL_FRAMEBUFFER, g_fb );
   glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_fb_tex, 0 );
@@ -132,14 +166,187 @@ void load_sphere() {
   glEnableVertexAttribArray( 0 );
 }
 
+/* times a full-screen post-processing pass on the GPU with the uber shader,
+which branches on a uniform, against the specialised permutation, with the old
+25-tap blur off and on. to measure the software rasteriser run with
+LIBGL_ALWAYS_SOFTWARE=1 so that Mesa uses llvmpipe */
+void benchmark_variants() {
+  shader_variants_t* variants = &g_kernels.variants;
+  image_kernel_t old_blur;
+  image_kernel_pass_t passes[2];
+  create_image_kernel( g_old_blur_weights, 5, &old_blur );
+  plan_image_kernel( &g_kernels, &old_blur, KERNEL_METHOD_2D, passes );
+  GLuint query = 0;
+  glGenQueries( 1, &query );
+  printf( "benchmarking post shader variants over %i frames each. renderer: %s\n", BENCH_FRAMES, glGetString( GL_RENDERER ) );
+  gl_log( "benchmarking post shader variants over %i frames each. renderer: %s\n", BENCH_FRAMES, glGetString( GL_RENDERER ) );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  glBindVertexArray( g_ss_quad_vao );
+  glActiveTexture( GL_TEXTURE0 );
+  glBindTexture( GL_TEXTURE_2D, g_fb_tex );
+  for ( unsigned int blur = 0; blur < 2; blur++ ) {
+    unsigned int mask = variant_key_bits( variants, g_kernels.kernel_key, blur );
+    for ( int uber = 0; uber < 2; uber++ ) {
+      /* once per programme, before any frames are timed */
+      GLuint programme = uber ? get_uber_variant( variants ) : get_variant( variants, mask );
+      GLint n_taps_loc = glGetUniformLocation( programme, "n_taps" );
+      GLint taps_loc   = glGetUniformLocation( programme, "taps" );
+      glUseProgram( programme );
+      if ( uber ) { set_uber_variant_keys( variants, mask ); }
+      glUniform1i( n_taps_loc, passes[0].n_taps );
+      glUniform3fv( taps_loc, passes[0].n_taps, passes[0].taps );
+      GLuint64 total_ns = 0;
+      for ( int i = 0; i < BENCH_FRAMES; i++ ) {
+        glBeginQuery( GL_TIME_ELAPSED, query );
+        glDrawArrays( GL_TRIANGLES, 0, 6 );
+        glEndQuery( GL_TIME_ELAPSED );
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v( query, GL_QUERY_RESULT, &ns );
+        total_ns += ns;
+      }
+      double ms = (double)total_ns / (double)BENCH_FRAMES / 1000000.0;
+      printf( "  KERNEL=%u %-11s %.4fms/frame\n", blur, uber ? "uber" : "specialised", ms );
+      gl_log( "  KERNEL=%u %-11s %.4fms/frame\n", blur, uber ? "uber" : "specialised", ms );
+    }
+  }
+  glDeleteQueries( 1, &query );
+}
+
+/* times each pass of each image kernel method, on offscreen targets at 1080p
+and 4K, for the old 5x5 blur and bigger Gaussians, on the GPU with a query, and
+on the wall clock, between glFinish()es. llvmpipe's queries leave out the
+fragment shading, so use the wall clock there. each method's output is also
+read back and compared to the plain separable passes, which merging taps and
+tiling shouldn't change, beyond the linear filter's precision */
+void benchmark_kernels() {
+  const int sizes[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+  const float sigmas[] = { 0.0f, 2.0f, 4.0f, 8.0f }; // 0 is the old 5x5 blur
+  GLuint query         = 0;
+  glGenQueries( 1, &query );
+  printf( "benchmarking image kernels over %i frames each. renderer: %s\n", KERNEL_BENCH_FRAMES, glGetString( GL_RENDERER ) );
+  gl_log( "benchmarking image kernels over %i frames each. renderer: %s\n", KERNEL_BENCH_FRAMES, glGetString( GL_RENDERER ) );
+  if ( !g_kernels.compute_programme ) { printf( "  no compute shaders on this context\n" ); }
+  printf( "  times are GPU / wall clock, in ms\n" );
+  for ( int s = 0; s < 2; s++ ) {
+    int w = sizes[s][0], h = sizes[s][1];
+    image_kernel_target_t src, dst;
+    if ( !create_image_kernel_target( &src, w, h, GL_RGBA8 ) ) { break; }
+    if ( !create_image_kernel_target( &dst, w, h, GL_RGBA8 ) ) {
+      free_image_kernel_target( &src );
+      break;
+    }
+    unsigned char* reference = (unsigned char*)malloc( (size_t)w * h * 4 );
+    unsigned char* pixels    = (unsigned char*)malloc( (size_t)w * h * 4 );
+    /* the scene, stretched out */
+    glBindFramebuffer( GL_FRAMEBUFFER, src.fb );
+    glViewport( 0, 0, w, h );
+    glUseProgram( get_variant( &g_kernels.variants, variant_key_bits( &g_kernels.variants, g_kernels.kernel_key, 0 ) ) );
+    glBindVertexArray( g_ss_quad_vao );
+    glActiveTexture( GL_TEXTURE0 );
+    glBindTexture( GL_TEXTURE_2D, g_fb_tex );
+    glDrawArrays( GL_TRIANGLES, 0, 6 );
+
+    for ( int k = 0; k < 4; k++ ) {
+      image_kernel_t kernel;
+      if ( 0.0f == sigmas[k] ) {
+        create_image_kernel( g_old_blur_weights, 5, &kernel );
+        printf( "%ix%i, old 5x5 blur:\n", w, h );
+      } else {
+        gaussian_image_kernel( sigmas[k], &kernel );
+        printf( "%ix%i, sigma %.0f, %ix%i:\n", w, h, sigmas[k], kernel.size, kernel.size );
+      }
+      gl_log( "%ix%i, kernel %ix%i\n", w, h, kernel.size, kernel.size );
+      bool have_reference = false;
+      /* the separable method goes first, as the reference */
+      const image_kernel_method_t methods[] = { KERNEL_METHOD_SEPARABLE, KERNEL_METHOD_2D, KERNEL_METHOD_SEPARABLE_LINEAR, KERNEL_METHOD_COMPUTE };
+      for ( int m = 0; m < KERNEL_METHOD_COUNT; m++ ) {
+        image_kernel_pass_t passes[2];
+        int n_passes = plan_image_kernel( &g_kernels, &kernel, methods[m], passes );
+        if ( 0 == n_passes ) {
+          printf( "  %-16s n/a\n", image_kernel_method_name( methods[m] ) );
+          continue;
+        }
+        /* compiles the variant and sizes the middle target, before timing */
+        apply_image_kernel( &g_kernels, &kernel, methods[m], src.tex, &dst );
+        GLuint64 pass_ns[2] = { 0, 0 };
+        double pass_s[2]    = { 0.0, 0.0 };
+        for ( int i = 0; i < KERNEL_BENCH_FRAMES; i++ ) {
+          for ( int p = 0; p < n_passes; p++ ) {
+            GLuint pass_src                  = 0 == p ? src.tex : g_kernels.middle.tex;
+            const image_kernel_target_t* out = p == n_passes - 1 ? &dst : &g_kernels.middle;
+            glFinish();
+            double start_s = glfwGetTime();
+            glBeginQuery( GL_TIME_ELAPSED, query );
+            run_image_kernel_pass( &g_kernels, &passes[p], pass_src, out );
+            glEndQuery( GL_TIME_ELAPSED );
+            glFinish();
+            pass_s[p] += glfwGetTime() - start_s;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v( query, GL_QUERY_RESULT, &ns );
+            pass_ns[p] += ns;
+          }
+        }
+        /* how many weighted reads a pixel takes. a compute pass's come from
+        shared memory, not the texture */
+        int taps = 0;
+        for ( int p = 0; p < n_passes; p++ ) { taps += passes[p].compute ? passes[p].size : passes[p].n_taps; }
+
+        glBindFramebuffer( GL_FRAMEBUFFER, dst.fb );
+        glReadPixels( 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, have_reference ? pixels : reference );
+        int max_diff = 0;
+        if ( have_reference ) {
+          for ( size_t i = 0; i < (size_t)w * h * 4; i++ ) {
+            int diff = abs( (int)pixels[i] - (int)reference[i] );
+            max_diff = diff > max_diff ? diff : max_diff;
+          }
+        }
+        have_reference = true;
+
+        double gpu_ms[2]  = { pass_ns[0] / (double)KERNEL_BENCH_FRAMES / 1000000.0, pass_ns[1] / (double)KERNEL_BENCH_FRAMES / 1000000.0 };
+        double wall_ms[2] = { pass_s[0] / KERNEL_BENCH_FRAMES * 1000.0, pass_s[1] / KERNEL_BENCH_FRAMES * 1000.0 };
+        printf( "  %-16s %3i taps  pass 1 %8.3f / %8.3f  pass 2 %8.3f / %8.3f  total %8.3f / %8.3f  max diff %i\n", image_kernel_method_name( methods[m] ), taps, gpu_ms[0], wall_ms[0], gpu_ms[1], wall_ms[1],
+          gpu_ms[0] + gpu_ms[1], wall_ms[0] + wall_ms[1], max_diff );
+        gl_log( "  %-16s %3i taps  pass 1 %8.3f / %8.3f  pass 2 %8.3f / %8.3f  total %8.3f / %8.3f  max diff %i\n", image_kernel_method_name( methods[m] ), taps, gpu_ms[0], wall_ms[0], gpu_ms[1], wall_ms[1],
+          gpu_ms[0] + gpu_ms[1], wall_ms[0] + wall_ms[1], max_diff );
+      }
+    }
+    free( reference );
+    free( pixels );
+    free_image_kernel_target( &src );
+    free_image_kernel_target( &dst );
+  }
+  glDeleteQueries( 1, &query );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  glViewport( 0, 0, g_gl_width, g_gl_height );
+}
+
+/* makes the rhs blur for the current sigma, and says what the method does with it */
+void update_blur() {
+  if ( !gaussian_image_kernel( g_blur_sigma, &g_blur ) ) { printf( "sigma %.1f is too big. cut down to %ix%i\n", g_blur_sigma, g_blur.size, g_blur.size ); }
+  image_kernel_pass_t passes[2];
+  int n_passes = plan_image_kernel( &g_kernels, &g_blur, g_blur_method, passes );
+  printf( "blur sigma %.1f, %ix%i, %s: ", g_blur_sigma, g_blur.size, g_blur.size, image_kernel_method_name( g_blur_method ) );
+  if ( 0 == n_passes ) {
+    printf( "can't do this kernel\n" );
+  } else if ( passes[0].compute ) {
+    printf( "%i passes through shared memory\n", n_passes );
+  } else {
+    printf( "%i passes, %i fetches\n", n_passes, passes[0].n_taps + ( 2 == n_passes ? passes[1].n_taps : 0 ) );
+  }
+}
+
 int main() {
   ( restart_gl_log() );
   ( start_gl() );
   /* set up framebuffer with texture attachment */
   ( init_fb() );
   init_ss_quad();
-  /* load the post-processing effect shaders */
-  GLuint post_sp = create_programme_from_files( POST_VS, POST_FS );
+  /* load the post-processing effect shaders. the variants are compiled on
+  first use */
+  ( init_image_kernel_engine( &g_kernels, g_ss_quad_vao, POST_VS, POST_FS, KERNEL_CS ) );
+  unsigned int copy_v = variant_key_bits( &g_kernels.variants, g_kernels.kernel_key, 0 );
+  ( create_image_kernel_target( &g_blur_target, g_gl_width, g_gl_height, GL_RGBA8 ) );
+  update_blur();
   /* load a mesh to draw in the main scene */
   load_sphere();
   GLuint sphere_sp   = create_programme_from_files( SPHERE_VS, SPHERE_FS );
@@ -179,25 +386,70 @@ int main() {
 
     glFlush();
     glFinish();
+    /* blur the whole scene into the other texture, in one or two passes */
+    bool blurred = apply_image_kernel( &g_kernels, &g_blur, g_blur_method, g_fb_tex, &g_blur_target );
     glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    glViewport( 0, 0, g_gl_width, g_gl_height );
 
     // clear the framebuffer's colour and depth buffers
     //		glClearColor (0.0, 0.0, 0.0, 1.0);
     //		glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    // use our post-processing shader for the screen-space quad
-    glUseProgram( post_sp );
     // bind the quad's VAO
     glBindVertexArray( g_ss_quad_vao );
     // activate the first texture slot and put texture from previous pass in it
     glActiveTexture( GL_TEXTURE0 );
     glBindTexture( GL_TEXTURE_2D, g_fb_tex );
-    // draw the quad that covers the screen area
+    // only show the blur on the rhs for comparison. rather than branching on
+    // the texture coordinate in the shader, copy the quad that covers the
+    // screen area once per half, each scissored, from its own texture
+    glEnable( GL_SCISSOR_TEST );
+    glUseProgram( get_variant( &g_kernels.variants, copy_v ) );
+    glScissor( 0, 0, g_gl_width / 2, g_gl_height );
     glDrawArrays( GL_TRIANGLES, 0, 6 );
+    if ( blurred ) { glBindTexture( GL_TEXTURE_2D, g_blur_target.tex ); }
+    glScissor( g_gl_width / 2, 0, g_gl_width - g_gl_width / 2, g_gl_height );
+    glDrawArrays( GL_TRIANGLES, 0, 6 );
+    glDisable( GL_SCISSOR_TEST );
 
     // flip drawn framebuffer onto the display
     glfwSwapBuffers( g_window );
     glfwPollEvents();
+    static bool b_was_down = false;
+    bool b_is_down         = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) { benchmark_variants(); }
+    b_was_down = b_is_down;
+
+    static bool k_was_down = false;
+    bool k_is_down         = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_K );
+    if ( k_is_down && !k_was_down ) { benchmark_kernels(); }
+    k_was_down = k_is_down;
+
+    static bool m_was_down = false;
+    bool m_is_down         = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_M );
+    if ( m_is_down && !m_was_down ) {
+      g_blur_method = ( image_kernel_method_t )( ( g_blur_method + 1 ) % KERNEL_METHOD_COUNT );
+      update_blur();
+    }
+    m_was_down = m_is_down;
+
+    static bool up_was_down = false;
+    bool up_is_down         = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_UP );
+    if ( up_is_down && !up_was_down && g_blur_sigma < 10.0f ) {
+      g_blur_sigma += 0.5f;
+      update_blur();
+    }
+    up_was_down = up_is_down;
+
+    static bool down_was_down = false;
+    bool down_is_down         = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_DOWN );
+    if ( down_is_down && !down_was_down && g_blur_sigma > 0.5f ) {
+      g_blur_sigma -= 0.5f;
+      update_blur();
+    }
+    down_was_down = down_is_down;
     if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( g_window, 1 ); }
   }
+  free_image_kernel_target( &g_blur_target );
+  free_image_kernel_engine( &g_kernels );
   return 0;
 }
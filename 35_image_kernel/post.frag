@@ -6,66 +6,32 @@ in vec2 st;
 // texture sampler
 uniform sampler2D tex;
 
-// size of 1 pixel in texture coordinates
-uniform vec2 pixel_scale = vec2 (1.0 / 800.0, 1.0 / 800.0);
+// the taps of one pass of an image kernel (see image_kernel.h), each an offset
+// in texels, x and y, and a weight. the separable passes only have taps along
+// a row or a column, and some of those are between two texels, to have the
+// linear filter mix them
+#define MAX_TAPS 81
+uniform vec3 taps[MAX_TAPS];
+uniform int n_taps;
 
 // output fragment colour RGBA
 out vec4 frag_colour;
 
-// Gaussian kernel weights
-#define KERNEL_SIZE 25
-float kernel_weights[] = float[]( 
-	0.00048031, 0.00500493, 0.01093176, 0.00500493, 0.00048031,
-	0.00500493, 0.05215252, 0.11391157, 0.05215252, 0.00500493,
-	0.01093176, 0.11391157, 0.24880573, 0.11391157, 0.01093176,
-	0.00500493, 0.05215252, 0.11391157, 0.05215252, 0.00500493,
-	0.00048031, 0.00500493, 0.01093176, 0.00500493, 0.00048031
-);
-float weights_factor = 1.01238;
-
 void main () {
-	vec2 offset[] = vec2[](
-		vec2 (-pixel_scale.s * 2.0, -pixel_scale.t * 2.0),
-		vec2 (-pixel_scale.s, -pixel_scale.t * 2.0),
-		vec2 (0.0, -pixel_scale.t * 2.0),
-		vec2 (pixel_scale.s, -pixel_scale.t * 2.0),
-		vec2 (pixel_scale.s * 2.0, -pixel_scale.t * 2.0),
-	
-		vec2 (-pixel_scale.s * 2.0, -pixel_scale.t),
-		vec2 (-pixel_scale.s, -pixel_scale.t),
-		vec2 (0.0, -pixel_scale.t),
-		vec2 (pixel_scale.s, -pixel_scale.t),
-		vec2 (pixel_scale.s * 2.0, -pixel_scale.t),
-	
-		vec2 (-pixel_scale.s * 2.0, 0.0),
-		vec2 (-pixel_scale.s, 0.0),
-		vec2 (0.0, 0.0),
-		vec2 (pixel_scale.s, 0.0),
-		vec2 (pixel_scale.s * 2.0, 0.0),
-	
-		vec2 (-pixel_scale.s * 2.0, pixel_scale.t),
-		vec2 (-pixel_scale.s, pixel_scale.t),
-		vec2 (0.0, pixel_scale.t),
-		vec2 (pixel_scale.s, pixel_scale.t),
-		vec2 (pixel_scale.s * 2.0, pixel_scale.t),
-	
-		vec2 (-pixel_scale.s * 2.0, pixel_scale.t * 2.0),
-		vec2 (-pixel_scale.s, pixel_scale.t * 2.0),
-		vec2 (0.0, pixel_scale.t * 2.0),
-		vec2 (pixel_scale.s, pixel_scale.t * 2.0),
-		vec2 (pixel_scale.s * 2.0, pixel_scale.t * 2.0)
-	);
-
+	// size of 1 pixel in texture coordinates, for any size of texture
+	vec2 pixel_scale = 1.0 / vec2 (textureSize (tex, 0));
 	// make sure that this starts at zero or could get undefined rubbish on
 	// screen!
 	vec3 colour = vec3 (0.0, 0.0, 0.0);
-	// only blur rhs for comparison
-	if (st.s >= 0.5) {
-		for (int i = 0; i < KERNEL_SIZE; i++) {
-			colour += texture (tex, st + offset[i]).rgb * kernel_weights[i] * weights_factor;
+	// KERNEL is a variant key, #defined to 0 or 1 when the shader is compiled
+	// (see shader_variants.h) so each permutation only keeps one of these
+	// branches. 0 just copies the texture
+	if (KERNEL != 0) {
+		for (int i = 0; i < n_taps; i++) {
+			colour += texture (tex, st + taps[i].xy * pixel_scale).rgb * taps[i].z;
 		}
 	} else {
-		colour = texture(tex, st).rgb;
+		colour = texture (tex, st).rgb;
 	}
 	frag_colour = vec4 (colour, 1.0);
 }
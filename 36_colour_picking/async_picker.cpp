@@ -0,0 +1,242 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Asynchronous ID picking.                                                     |
+\******************************************************************************/
+#include "async_picker.h"
+#include "gl_utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* (re)allocates the ID texture and depth buffer. a minimised window can be 0 x 0 */
+static void create_id_storage( picker_t* picker, int width, int height ) {
+  picker->width  = width > 1 ? width : 1;
+  picker->height = height > 1 ? height : 1;
+  glBindTexture( GL_TEXTURE_2D, picker->id_tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_R32UI, picker->width, picker->height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL );
+  /* integer textures can't be filtered */
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+  glBindRenderbuffer( GL_RENDERBUFFER, picker->depth_rb );
+  glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT, picker->width, picker->height );
+}
+
+bool init_picker( picker_t* picker, int width, int height ) {
+  memset( picker, 0, sizeof( picker_t ) );
+  glGenTextures( 1, &picker->id_tex );
+  glGenRenderbuffers( 1, &picker->depth_rb );
+  create_id_storage( picker, width, height );
+
+  glGenFramebuffers( 1, &picker->fb );
+  glBindFramebuffer( GL_FRAMEBUFFER, picker->fb );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, picker->id_tex, 0 );
+  glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, picker->depth_rb );
+  GLenum draw_bufs[] = { GL_COLOR_ATTACHMENT0 };
+  glDrawBuffers( 1, draw_bufs );
+  glReadBuffer( GL_COLOR_ATTACHMENT0 );
+  GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  if ( GL_FRAMEBUFFER_COMPLETE != status ) {
+    gl_log_err( "ERROR: incomplete picking framebuffer. status 0x%x\n", status );
+    return false;
+  }
+
+  for ( int i = 0; i < PICKER_MAX_PENDING; i++ ) { glGenBuffers( 1, &picker->requests[i].pbo ); }
+  return true;
+}
+
+void free_picker( picker_t* picker ) {
+  for ( int i = 0; i < PICKER_MAX_PENDING; i++ ) {
+    if ( picker->requests[i].fence ) { glDeleteSync( picker->requests[i].fence ); }
+    glDeleteBuffers( 1, &picker->requests[i].pbo );
+  }
+  glDeleteFramebuffers( 1, &picker->fb );
+  glDeleteTextures( 1, &picker->id_tex );
+  glDeleteRenderbuffers( 1, &picker->depth_rb );
+  free( picker->scratch );
+  memset( picker, 0, sizeof( picker_t ) );
+}
+
+void picker_resize( picker_t* picker, int width, int height ) {
+  if ( width == picker->width && height == picker->height ) { return; }
+  /* the framebuffer keeps its attachments when their storage is re-specified */
+  create_id_storage( picker, width, height );
+  /* requests waiting for an ID pass have regions from the old size, so drop
+  them. copies already queued were made before this, and still come back */
+  for ( int i = 0; i < PICKER_MAX_PENDING; i++ ) {
+    if ( !picker->requests[i].issued ) { picker->requests[i].in_use = false; }
+  }
+}
+
+static pick_request_t* new_request( picker_t* picker, int x, int y, int w, int h, pick_callback_t callback, void* user_data ) {
+  /* clip to the framebuffer */
+  if ( x < 0 ) {
+    w += x;
+    x = 0;
+  }
+  if ( y < 0 ) {
+    h += y;
+    y = 0;
+  }
+  if ( x + w > picker->width ) { w = picker->width - x; }
+  if ( y + h > picker->height ) { h = picker->height - y; }
+  if ( w < 1 || h < 1 ) { return NULL; }
+
+  for ( int i = 0; i < PICKER_MAX_PENDING; i++ ) {
+    pick_request_t* r = &picker->requests[i];
+    if ( r->in_use ) { continue; }
+    r->in_use          = true;
+    r->issued          = false;
+    r->x               = x;
+    r->y               = y;
+    r->w               = w;
+    r->h               = h;
+    r->n_lasso_points  = 0;
+    r->frame_requested = picker->frame;
+    r->callback        = callback;
+    r->user_data       = user_data;
+    return r;
+  }
+  gl_log_err( "WARNING: %i picks already pending. pick dropped\n", PICKER_MAX_PENDING );
+  return NULL;
+}
+
+bool picker_request_rect( picker_t* picker, int x, int y, int w, int h, pick_callback_t callback, void* user_data ) {
+  return NULL != new_request( picker, x, y, w, h, callback, user_data );
+}
+
+bool picker_request_lasso( picker_t* picker, const float* xy, int n_points, pick_callback_t callback, void* user_data ) {
+  if ( n_points < 3 ) { return false; }
+  if ( n_points > PICKER_MAX_LASSO_POINTS ) { n_points = PICKER_MAX_LASSO_POINTS; }
+  /* read the polygon's bounding box and test pixels against it when it arrives */
+  float min_x = xy[0], max_x = xy[0], min_y = xy[1], max_y = xy[1];
+  for ( int i = 1; i < n_points; i++ ) {
+    min_x = xy[i * 2] < min_x ? xy[i * 2] : min_x;
+    max_x = xy[i * 2] > max_x ? xy[i * 2] : max_x;
+    min_y = xy[i * 2 + 1] < min_y ? xy[i * 2 + 1] : min_y;
+    max_y = xy[i * 2 + 1] > max_y ? xy[i * 2 + 1] : max_y;
+  }
+  int x             = (int)min_x;
+  int y             = (int)min_y;
+  pick_request_t* r = new_request( picker, x, y, (int)max_x - x + 1, (int)max_y - y + 1, callback, user_data );
+  if ( !r ) { return false; }
+  memcpy( r->lasso, xy, n_points * 2 * sizeof( float ) );
+  r->n_lasso_points = n_points;
+  return true;
+}
+
+bool picker_wants_ids( const picker_t* picker ) {
+  for ( int i = 0; i < PICKER_MAX_PENDING; i++ ) {
+    if ( picker->requests[i].in_use && !picker->requests[i].issued ) { return true; }
+  }
+  return false;
+}
+
+void picker_begin_ids( picker_t* picker ) {
+  glBindFramebuffer( GL_FRAMEBUFFER, picker->fb );
+  glViewport( 0, 0, picker->width, picker->height );
+  /* glClear() isn't defined for integer colour buffers */
+  GLuint no_id[4] = { 0, 0, 0, 0 };
+  glClearBufferuiv( GL_COLOR, 0, no_id );
+  glClear( GL_DEPTH_BUFFER_BIT );
+}
+
+void picker_end_ids( picker_t* picker ) {
+  for ( int i = 0; i < PICKER_MAX_PENDING; i++ ) {
+    pick_request_t* r = &picker->requests[i];
+    if ( !r->in_use || r->issued ) { continue; }
+    GLsizeiptr size = (GLsizeiptr)r->w * r->h * sizeof( GLuint );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, r->pbo );
+    /* re-specifying the storage lets the driver hand us a fresh block rather
+    than waiting for any earlier use of this buffer */
+    glBufferData( GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ );
+    r->pbo_size = size;
+    /* with a pack buffer bound the last argument is an offset into it, and
+    glReadPixels() returns without waiting for the copy */
+    glReadPixels( r->x, r->y, r->w, r->h, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL );
+    r->fence  = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    r->issued = true;
+  }
+  glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+}
+
+/* even-odd rule point in polygon test */
+static bool inside_lasso( const pick_request_t* r, float px, float py ) {
+  bool inside = false;
+  for ( int i = 0, j = r->n_lasso_points - 1; i < r->n_lasso_points; j = i++ ) {
+    float xi = r->lasso[i * 2], yi = r->lasso[i * 2 + 1];
+    float xj = r->lasso[j * 2], yj = r->lasso[j * 2 + 1];
+    if ( ( yi > py ) != ( yj > py ) && px < ( xj - xi ) * ( py - yi ) / ( yj - yi ) + xi ) { inside = !inside; }
+  }
+  return inside;
+}
+
+static int compare_ids( const void* a, const void* b ) {
+  GLuint ia = *(const GLuint*)a;
+  GLuint ib = *(const GLuint*)b;
+  return ia < ib ? -1 : ( ia > ib ? 1 : 0 );
+}
+
+static void deliver( picker_t* picker, pick_request_t* r ) {
+  glBindBuffer( GL_PIXEL_PACK_BUFFER, r->pbo );
+  const GLuint* pixels = (const GLuint*)glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, r->pbo_size, GL_MAP_READ_BIT );
+  int n_ids            = 0;
+  if ( pixels ) {
+    int n_pixels = r->w * r->h;
+    if ( n_pixels > picker->scratch_size ) {
+      picker->scratch      = (GLuint*)realloc( picker->scratch, n_pixels * sizeof( GLuint ) );
+      picker->scratch_size = n_pixels;
+    }
+    for ( int i = 0; i < n_pixels; i++ ) {
+      GLuint id = pixels[i];
+      if ( 0 == id ) { continue; }
+      /* most pixels of a region repeat the previous ID, so skip those early */
+      if ( n_ids > 0 && picker->scratch[n_ids - 1] == id ) { continue; }
+      if ( r->n_lasso_points > 0 && !inside_lasso( r, r->x + i % r->w + 0.5f, r->y + i / r->w + 0.5f ) ) { continue; }
+      picker->scratch[n_ids++] = id;
+    }
+    glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+  } else {
+    gl_log_err( "ERROR: could not map pick buffer\n" );
+  }
+  glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+  /* sort then squash runs of the same ID */
+  qsort( picker->scratch, n_ids, sizeof( GLuint ), compare_ids );
+  int n_unique = 0;
+  for ( int i = 0; i < n_ids; i++ ) {
+    if ( 0 == n_unique || picker->scratch[n_unique - 1] != picker->scratch[i] ) { picker->scratch[n_unique++] = picker->scratch[i]; }
+  }
+
+  pick_result_t result;
+  result.x             = r->x;
+  result.y             = r->y;
+  result.w             = r->w;
+  result.h             = r->h;
+  result.ids           = picker->scratch;
+  result.n_ids         = n_unique;
+  result.frames_waited = picker->frame - r->frame_requested;
+  /* free the slot first so the callback can make a new request */
+  r->in_use = false;
+  if ( r->callback ) { r->callback( &result, r->user_data ); }
+}
+
+void picker_poll( picker_t* picker ) {
+  picker->frame++;
+  for ( int i = 0; i < PICKER_MAX_PENDING; i++ ) {
+    pick_request_t* r = &picker->requests[i];
+    if ( !r->in_use || !r->issued ) { continue; }
+    /* a timeout of 0 just asks if the fence has been reached */
+    GLenum result = glClientWaitSync( r->fence, 0, 0 );
+    if ( GL_ALREADY_SIGNALED != result && GL_CONDITION_SATISFIED != result ) { continue; }
+    glDeleteSync( r->fence );
+    r->fence = 0;
+    deliver( picker, r );
+  }
+}
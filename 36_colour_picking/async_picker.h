@@ -0,0 +1,90 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Asynchronous ID picking.                                                     |
+| Objects are drawn into an R32UI texture with their 32-bit ID as the output.  |
+| Reading a pixel straight back with glReadPixels() makes the CPU wait until   |
+| the GPU has finished everything queued before it, which empties the pipeline |
+| and costs a frame or more. Instead, the pick region is copied into a pixel   |
+| buffer object (PBO), which the GPU does in its own time, and a fence is put  |
+| in after the copy. Each frame picker_poll() checks the fences without        |
+| waiting. Once one has signalled, the PBO is mapped - with no stall - and the |
+| IDs are handed to a callback. That is usually a frame or two after the       |
+| request.                                                                     |
+| A request is a rectangle, a single pixel being a 1x1 rectangle, or a lasso   |
+| polygon. Every distinct ID inside it is returned, in ascending order. ID 0   |
+| means no object, so IDs should start at 1.                                   |
+| All coordinates are in pixels from the bottom-left, like glReadPixels().     |
+\******************************************************************************/
+#ifndef _ASYNC_PICKER_H_
+#define _ASYNC_PICKER_H_
+
+#include <GL/glew.h>
+
+/* requests that can be waiting for the GPU at once */
+#define PICKER_MAX_PENDING 4
+#define PICKER_MAX_LASSO_POINTS 256
+
+struct pick_result_t {
+  int x, y, w, h;    /* region that was read */
+  const GLuint* ids; /* distinct IDs found, ascending. only valid during the callback */
+  int n_ids;
+  int frames_waited; /* calls to picker_poll() between request and result */
+};
+
+typedef void ( *pick_callback_t )( const pick_result_t* result, void* user_data );
+
+struct pick_request_t {
+  bool in_use;
+  bool issued; /* the copy into the PBO has been queued */
+  int x, y, w, h;
+  /* lasso polygon as xy pairs. 0 points for a plain rectangle */
+  float lasso[PICKER_MAX_LASSO_POINTS * 2];
+  int n_lasso_points;
+  GLuint pbo;
+  GLsizeiptr pbo_size;
+  GLsync fence;
+  int frame_requested;
+  pick_callback_t callback;
+  void* user_data;
+};
+
+struct picker_t {
+  GLuint fb;
+  GLuint id_tex; /* GL_R32UI */
+  GLuint depth_rb;
+  int width, height;
+  pick_request_t requests[PICKER_MAX_PENDING];
+  int frame;
+  GLuint* scratch; /* IDs of a region being gathered */
+  int scratch_size;
+};
+
+bool init_picker( picker_t* picker, int width, int height );
+void free_picker( picker_t* picker );
+/* call when the window's framebuffer changes size. requests that haven't had
+an ID pass yet are dropped without a callback */
+void picker_resize( picker_t* picker, int width, int height );
+
+/* returns false if PICKER_MAX_PENDING requests are already waiting. the
+region is clipped to the picker's size */
+bool picker_request_rect( picker_t* picker, int x, int y, int w, int h, pick_callback_t callback, void* user_data );
+/* xy holds n_points pairs of pixel coordinates, closed back to the start */
+bool picker_request_lasso( picker_t* picker, const float* xy, int n_points, pick_callback_t callback, void* user_data );
+/* true if a request is waiting for an ID pass. if not, the pass can be skipped */
+bool picker_wants_ids( const picker_t* picker );
+
+/* binds and clears the ID framebuffer. then draw each object with its ID */
+void picker_begin_ids( picker_t* picker );
+/* queues the copies for requests made before this ID pass and binds the
+default framebuffer again */
+void picker_end_ids( picker_t* picker );
+/* call once per frame. calls back for any requests that the GPU has finished */
+void picker_poll( picker_t* picker );
+
+#endif
@@ -9,16 +9,19 @@
 | Doing post-processing with a secondary framebuffer													 |
 \******************************************************************************/
 
+#include "async_picker.h"
 #include "gl_utils.h"
 #include "maths_funcs.h"
 #include "obj_parser.h"
 #include <GL/glew.h>    // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h> // GLFW helper library
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 
 #define PICK_VS "pick.vert"
 #define PICK_FS "pick.frag"
+#define PICK_DEBUG_FS "pick_debug.frag"
 #define SPHERE_VS "sphere.vert"
 #define SPHERE_FS "sphere.frag"
 #define MESH_FILE "sphere.obj"
@@ -28,88 +31,32 @@ int g_gl_width       = 800;
 int g_gl_height      = 800;
 GLFWwindow* g_window = NULL;
 
-/* global variables for the secondary framebuffer handle and attached texture */
-GLuint g_fb                = 0;
-GLuint g_fb_tex            = 0;
+/* ID picking with an asynchronous read back */
+picker_t g_picker;
 GLuint g_pick_sp           = 0;
 GLint g_pick_unique_id_loc = -1;
 GLint g_pick_P_loc         = -1;
 GLint g_pick_V_loc         = -1;
 GLint g_pick_M_loc         = -1;
+/* the same pass drawn to the screen with each ID as a colour */
+GLuint g_pick_debug_sp           = 0;
+GLint g_pick_debug_unique_id_loc = -1;
+GLint g_pick_debug_P_loc         = -1;
+GLint g_pick_debug_V_loc         = -1;
+GLint g_pick_debug_M_loc         = -1;
 
 /* sphere */
 GLuint g_sphere_vao      = 0;
 int g_sphere_point_count = 0;
 
-// encode an unique ID into a colour with components in range of 0.0 to 1.0
-vec3 encode_id( int id ) {
-  int r = id / 65536;
-  int g = ( id - r * 65536 ) / 256;
-  int b = ( id - r * 65536 - g * 256 );
+/* any 32-bit value but 0 can be an ID - the last one wouldn't fit in 24-bit RGB */
+#define NUM_SPHERES 3
+GLuint g_sphere_ids[NUM_SPHERES] = { 100, 200, 300000000 };
+bool g_selected[NUM_SPHERES];
 
-  // convert to floats. only divide by 255, because range is 0-255
-  return vec3( (float)r / 255.0, (float)g / 255.0, (float)b / 255.0 );
-}
-
-/* initialise secondary framebuffer. this will just allow us to render our main
-scene to a texture instead of directly to the screen. returns false if something
-went wrong in the framebuffer creation */
-bool init_fb() {
-  glGenFramebuffers( 1, &g_fb );
-  /* create the texture that will be attached to the fb. should be the same
-  dimensions as the viewport */
-  glGenTextures( 1, &g_fb_tex );
-  glBindTexture( GL_TEXTURE_2D, g_fb_tex );
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, g_gl_width, g_gl_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-  /* attach the texture to the framebuffer */
-  glBindFramebuffer( GL_FRAMEBUFFER, g_fb );
-  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_fb_tex, 0 );
-  /* create a renderbuffer which allows depth-testing in the framebuffer */
-  GLuint rb = 0;
-  glGenRenderbuffers( 1, &rb );
-  glBindRenderbuffer( GL_RENDERBUFFER, rb );
-  glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT, g_gl_width, g_gl_height );
-  /* attach renderbuffer to framebuffer */
-  glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rb );
-  /* tell the framebuffer to expect a colour output attachment (our texture) */
-  GLenum draw_bufs[] = { GL_COLOR_ATTACHMENT0 };
-  glDrawBuffers( 1, draw_bufs );
-
-  /* validate the framebuffer - an 'incomplete' error tells us if an invalid
-  image format is attached or if the glDrawBuffers information is invalid */
-  GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
-  if ( GL_FRAMEBUFFER_COMPLETE != status ) {
-    fprintf( stderr, "ERROR: incomplete framebuffer\n" );
-    if ( GL_FRAMEBUFFER_UNDEFINED == status ) {
-      fprintf( stderr, "GL_FRAMEBUFFER_UNDEFINED\n" );
-    } else if ( GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT == status ) {
-      fprintf( stderr, "GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT\n" );
-    } else if ( GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT == status ) {
-      fprintf( stderr, "GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT\n" );
-    } else if ( GL_FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER == status ) {
-      fprintf( stderr, "GL_FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER\n" );
-    } else if ( GL_FRAMEBUFFER_INCOMPLETE_READ_BUFFER == status ) {
-      fprintf( stderr, "GL_FRAMEBUFFER_INCOMPLETE_READ_BUFFER\n" );
-    } else if ( GL_FRAMEBUFFER_UNSUPPORTED == status ) {
-      fprintf( stderr, "GL_FRAMEBUFFER_UNSUPPORTED\n" );
-    } else if ( GL_FRAMEBUFFER_INCOMPLETE_MULTISAMPLE == status ) {
-      fprintf( stderr, "GL_FRAMEBUFFER_INCOMPLETE_MULTISAMPLE\n" );
-    } else if ( GL_FRAMEBUFFER_INCOMPLETE_LAYER_TARGETS == status ) {
-      fprintf( stderr, "GL_FRAMEBUFFER_INCOMPLETE_LAYER_TARGETS\n" );
-    } else {
-      fprintf( stderr, "unspecified error\n" );
-    }
-    return false;
-  }
-
-  /* re-bind the default framebuffer as a safe precaution */
-  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
-  return true;
-}
+/* lasso being drawn with the right mouse button */
+float g_lasso[PICKER_MAX_LASSO_POINTS * 2];
+int g_lasso_point_count = 0;
 
 void load_sphere() {
   float* points        = NULL;
@@ -128,51 +75,51 @@ void load_sphere() {
 }
 
 bool debug_colours = false;
-void draw_picker_colours( mat4 P, mat4 V, mat4 M[3] ) {
-  if ( debug_colours ) {
-    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
-  } else {
-    glBindFramebuffer( GL_FRAMEBUFFER, g_fb );
-  }
-  glViewport( 0, 0, g_gl_width, g_gl_height );
-  glClearColor( 0.0, 0.0, 0.0, 1.0 );
-  glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-
-  glUseProgram( g_pick_sp );
-  // set colour
-  vec3 id = encode_id( 255 );
-  glUniform3f( g_pick_unique_id_loc, id.v[0], id.v[1], id.v[2] );
-  glUniformMatrix4fv( g_pick_P_loc, 1, GL_FALSE, P.m );
-  glUniformMatrix4fv( g_pick_V_loc, 1, GL_FALSE, V.m );
-  glUniformMatrix4fv( g_pick_M_loc, 1, GL_FALSE, M[0].m );
-
+void draw_ids( GLuint sp, GLint id_loc, GLint M_loc, mat4 M[NUM_SPHERES] ) {
+  glUseProgram( sp );
   glBindVertexArray( g_sphere_vao );
-  glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
-
-  // 2nd sphere
-  id = encode_id( 65280 );
-  glUniformMatrix4fv( g_pick_M_loc, 1, GL_FALSE, M[1].m );
-  glUniform3f( g_pick_unique_id_loc, id.v[0], id.v[1], id.v[2] );
-  glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
+  for ( int i = 0; i < NUM_SPHERES; i++ ) {
+    glUniform1ui( id_loc, g_sphere_ids[i] );
+    glUniformMatrix4fv( M_loc, 1, GL_FALSE, M[i].m );
+    glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
+  }
+}
 
-  // 3rd sphere
-  id = encode_id( 16711680 );
-  glUniformMatrix4fv( g_pick_M_loc, 1, GL_FALSE, M[2].m );
-  glUniform3f( g_pick_unique_id_loc, id.v[0], id.v[1], id.v[2] );
-  glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
+/* called by picker_poll() a frame or two after a request was made */
+void on_pick( const pick_result_t* result, void* user_data ) {
+  for ( int i = 0; i < NUM_SPHERES; i++ ) { g_selected[i] = false; }
+  printf( "picked %ix%i region at %i,%i after %i frames. %i IDs:", result->w, result->h, result->x, result->y, result->frames_waited, result->n_ids );
+  for ( int i = 0; i < result->n_ids; i++ ) {
+    printf( " %u", result->ids[i] );
+    for ( int j = 0; j < NUM_SPHERES; j++ ) {
+      if ( g_sphere_ids[j] == result->ids[i] ) { g_selected[j] = true; }
+    }
+  }
+  printf( "\n" );
+}
 
-  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+/* cursor position in pixels from the bottom-left, like the picker wants */
+void cursor_pos( float* x, float* y ) {
+  double xpos, ypos;
+  glfwGetCursorPos( g_window, &xpos, &ypos );
+  *x = (float)xpos;
+  *y = (float)( g_gl_height - 1 ) - (float)ypos;
 }
 
-int decode_id( int r, int g, int b ) { return b + g * 256 + r * 256 * 256; }
+/* the ID framebuffer has to match the window's, so resize it along with it */
+void framebuffer_size_callback( GLFWwindow* window, int width, int height ) {
+  glfw_framebuffer_size_callback( window, width, height );
+  picker_resize( &g_picker, width, height );
+}
 
 int main() {
   ( restart_gl_log() );
   ( start_gl() );
   /* load a mesh to draw in the main scene */
   load_sphere();
-  /* set up framebuffer with texture attachment */
-  ( init_fb() );
+  /* set up the integer ID framebuffer and its read back buffers */
+  if ( !init_picker( &g_picker, g_gl_width, g_gl_height ) ) { return 1; }
+  glfwSetFramebufferSizeCallback( g_window, framebuffer_size_callback );
   /* load the picking shaders */
   g_pick_sp            = create_programme_from_files( PICK_VS, PICK_FS );
   g_pick_unique_id_loc = glGetUniformLocation( g_pick_sp, "unique_id" );
@@ -182,10 +129,16 @@ int main() {
   assert( g_pick_P_loc > -1 );
   assert( g_pick_V_loc > -1 );
   assert( g_pick_M_loc > -1 );
-  GLuint sphere_sp   = create_programme_from_files( SPHERE_VS, SPHERE_FS );
-  GLint sphere_P_loc = glGetUniformLocation( sphere_sp, "P" );
-  GLint sphere_V_loc = glGetUniformLocation( sphere_sp, "V" );
-  GLint sphere_M_loc = glGetUniformLocation( sphere_sp, "M" );
+  g_pick_debug_sp            = create_programme_from_files( PICK_VS, PICK_DEBUG_FS );
+  g_pick_debug_unique_id_loc = glGetUniformLocation( g_pick_debug_sp, "unique_id" );
+  g_pick_debug_P_loc         = glGetUniformLocation( g_pick_debug_sp, "P" );
+  g_pick_debug_V_loc         = glGetUniformLocation( g_pick_debug_sp, "V" );
+  g_pick_debug_M_loc         = glGetUniformLocation( g_pick_debug_sp, "M" );
+  GLuint sphere_sp           = create_programme_from_files( SPHERE_VS, SPHERE_FS );
+  GLint sphere_P_loc         = glGetUniformLocation( sphere_sp, "P" );
+  GLint sphere_V_loc         = glGetUniformLocation( sphere_sp, "V" );
+  GLint sphere_M_loc         = glGetUniformLocation( sphere_sp, "M" );
+  GLint sphere_selected_loc  = glGetUniformLocation( sphere_sp, "selected" );
   assert( sphere_P_loc > -1 );
   assert( sphere_V_loc > -1 );
   assert( sphere_M_loc > -1 );
@@ -195,60 +148,88 @@ int main() {
   glUseProgram( sphere_sp );
   glUniformMatrix4fv( sphere_P_loc, 1, GL_FALSE, P.m );
   glUniformMatrix4fv( sphere_V_loc, 1, GL_FALSE, V.m );
-
-  glViewport( 0, 0, g_gl_width, g_gl_height );
-
+  glUseProgram( g_pick_sp );
+  glUniformMatrix4fv( g_pick_P_loc, 1, GL_FALSE, P.m );
+  glUniformMatrix4fv( g_pick_V_loc, 1, GL_FALSE, V.m );
+  glUseProgram( g_pick_debug_sp );
+  glUniformMatrix4fv( g_pick_debug_P_loc, 1, GL_FALSE, P.m );
+  glUniformMatrix4fv( g_pick_debug_V_loc, 1, GL_FALSE, V.m );
+
+  // model matrices for all 3 spheres
+  mat4 Ms[NUM_SPHERES];
+  Ms[0] = identity_mat4();
+  Ms[1] = translate( identity_mat4(), vec3( 1.0, -1.0, -4.0 ) );
+  Ms[2] = translate( identity_mat4(), vec3( -0.50, 2.0, -2.0 ) );
+
+  printf( "left click or drag a box to pick. drag with the right button to lasso. hold space to see the IDs\n" );
+  bool left_was_down  = false;
+  bool right_was_down = false;
+  float drag_x        = 0.0f, drag_y = 0.0f;
   while ( !glfwWindowShouldClose( g_window ) ) {
     _update_fps_counter( g_window );
+    /* hand over any picks that the GPU has finished copying. this never waits */
+    picker_poll( &g_picker );
 
-    /* bind the 'render to a texture' framebuffer for main scene */
     glBindFramebuffer( GL_FRAMEBUFFER, 0 );
-    /* clear the framebuffer's colour and depth buffers */
+    glViewport( 0, 0, g_gl_width, g_gl_height );
     glClearColor( 0.2, 0.2, 0.2, 1.0 );
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-    // render an obj or something
-    glUseProgram( sphere_sp );
-    glBindVertexArray( g_sphere_vao );
-
-    // model matrices for all 3 spheres
-    mat4 Ms[3];
-    // first sphere
-    Ms[0] = identity_mat4();
-    glUniformMatrix4fv( sphere_M_loc, 1, GL_FALSE, Ms[0].m );
-    glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
-    // 2nd sphere
-    Ms[1] = translate( identity_mat4(), vec3( 1.0, -1.0, -4.0 ) );
-    glUniformMatrix4fv( sphere_M_loc, 1, GL_FALSE, Ms[1].m );
-    glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
-    // 3rd sphere
-    Ms[2] = translate( identity_mat4(), vec3( -0.50, 2.0, -2.0 ) );
-    glUniformMatrix4fv( sphere_M_loc, 1, GL_FALSE, Ms[2].m );
-    glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
+    if ( debug_colours ) {
+      draw_ids( g_pick_debug_sp, g_pick_debug_unique_id_loc, g_pick_debug_M_loc, Ms );
+    } else {
+      glUseProgram( sphere_sp );
+      glBindVertexArray( g_sphere_vao );
+      for ( int i = 0; i < NUM_SPHERES; i++ ) {
+        glUniform1f( sphere_selected_loc, g_selected[i] ? 1.0f : 0.0f );
+        glUniformMatrix4fv( sphere_M_loc, 1, GL_FALSE, Ms[i].m );
+        glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
+      }
+    }
 
-    /* bind framebuffer for pick */
-    draw_picker_colours( P, V, Ms );
+    /* only draw the ID pass on frames that have a new request to read */
+    if ( picker_wants_ids( &g_picker ) ) {
+      picker_begin_ids( &g_picker );
+      draw_ids( g_pick_sp, g_pick_unique_id_loc, g_pick_M_loc, Ms );
+      picker_end_ids( &g_picker );
+      glViewport( 0, 0, g_gl_width, g_gl_height );
+    }
 
     // flip drawn framebuffer onto the display
     glfwSwapBuffers( g_window );
     glfwPollEvents();
     if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( g_window, 1 ); }
     debug_colours = glfwGetKey( g_window, GLFW_KEY_SPACE );
-    if ( glfwGetMouseButton( g_window, 0 ) ) {
-      glBindFramebuffer( GL_FRAMEBUFFER, g_fb );
-      double xpos, ypos;
-      glfwGetCursorPos( g_window, &xpos, &ypos );
-      int mx                = (int)xpos;
-      int my                = (int)ypos;
-      unsigned char data[4] = { 0, 0, 0, 0 };
-      glReadPixels( mx, g_gl_height - my, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &data );
-      int id  = decode_id( (int)data[0], (int)data[1], (int)data[2] );
-      int mid = -1;
-      if ( id == 255 ) { mid = 0; }
-      if ( id == 65280 ) { mid = 1; }
-      if ( id == 16711680 ) { mid = 2; }
-      printf( "%i,%i,%i means -> id was %i, and monkey number is %i\n", data[0], data[1], data[2], id, mid );
-      glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+    /* left button: a click picks the pixel under the cursor, a drag picks a box */
+    bool left_down = GLFW_PRESS == glfwGetMouseButton( g_window, GLFW_MOUSE_BUTTON_LEFT );
+    if ( left_down && !left_was_down ) { cursor_pos( &drag_x, &drag_y ); }
+    if ( !left_down && left_was_down ) {
+      float x, y;
+      cursor_pos( &x, &y );
+      int x0 = (int)( x < drag_x ? x : drag_x );
+      int y0 = (int)( y < drag_y ? y : drag_y );
+      int x1 = (int)( x < drag_x ? drag_x : x );
+      int y1 = (int)( y < drag_y ? drag_y : y );
+      picker_request_rect( &g_picker, x0, y0, x1 - x0 + 1, y1 - y0 + 1, on_pick, NULL );
+    }
+    left_was_down = left_down;
+
+    /* right button: add a lasso point whenever the cursor has moved a bit */
+    bool right_down = GLFW_PRESS == glfwGetMouseButton( g_window, GLFW_MOUSE_BUTTON_RIGHT );
+    if ( right_down ) {
+      if ( !right_was_down ) { g_lasso_point_count = 0; }
+      float x, y;
+      cursor_pos( &x, &y );
+      int n = g_lasso_point_count;
+      if ( n < PICKER_MAX_LASSO_POINTS && ( 0 == n || fabs( x - g_lasso[n * 2 - 2] ) + fabs( y - g_lasso[n * 2 - 1] ) > 4.0f ) ) {
+        g_lasso[n * 2]     = x;
+        g_lasso[n * 2 + 1] = y;
+        g_lasso_point_count++;
+      }
     }
+    if ( !right_down && right_was_down ) { picker_request_lasso( &g_picker, g_lasso, g_lasso_point_count, on_pick, NULL ); }
+    right_was_down = right_down;
   }
+  free_picker( &g_picker );
   return 0;
 }
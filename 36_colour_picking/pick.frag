@@ -1,7 +1,8 @@
 #version 410
-uniform vec3 unique_id;
-out vec4 frag_colour;
+uniform uint unique_id;
+/* written to the R32UI attachment, so an integer output */
+out uint frag_id;
 
 void main () {
-  frag_colour = vec4 (unique_id, 1.0);
+  frag_id = unique_id;
 }
@@ -0,0 +1,15 @@
+#version 410
+uniform uint unique_id;
+out vec4 frag_colour;
+
+/* shows the ID pass on screen. large IDs would all look white as a plain
+colour, so the bytes of the ID are mixed up into a colour instead */
+void main () {
+  uint h = unique_id * 2654435761u;
+  frag_colour = vec4 (
+    float ((h >> 24u) & 255u) / 255.0,
+    float ((h >> 16u) & 255u) / 255.0,
+    float ((h >> 8u) & 255u) / 255.0,
+    1.0
+  );
+}
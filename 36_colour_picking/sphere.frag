@@ -1,7 +1,8 @@
 #version 410
 
+uniform float selected;
 out vec4 frag_colour;
 
 void main () {
-	frag_colour = vec4 (1.0, 0.0, 0.0, 1.0);
+	frag_colour = mix (vec4 (1.0, 0.0, 0.0, 1.0), vec4 (1.0, 1.0, 0.0, 1.0), selected);
 }
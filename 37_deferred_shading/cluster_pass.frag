@@ -0,0 +1,66 @@
+#version 410
+
+#define CLUSTER_SLICES 16
+#define CLUSTER_TILE_PIXELS 32
+
+uniform sampler2D p_tex;
+uniform sampler2D n_tex;
+/* lights as 2 texels each: eye position and radius, then colour */
+uniform samplerBuffer lights;
+/* offset and count into the index list for each cluster */
+uniform usamplerBuffer grid;
+uniform usamplerBuffer indices;
+uniform int tiles_x, tiles_y;
+uniform vec2 depth_range; /* near and far depths of the slices */
+
+out vec4 frag_colour;
+
+vec3 kd = vec3 (0.9, 0.9, 0.9);
+vec3 ks = vec3 (0.5, 0.5, 0.5);
+vec3 ls = vec3 (1.0, 1.0, 1.0);
+float specular_exponent = 200.0;
+
+/* the same lighting as second_pass.frag, with the light in eye space already */
+vec3 phong (in vec3 op_eye, in vec3 n_eye, in vec3 lp_eye, in float radius, in vec3 ld) {
+	vec3 dist_to_light_eye = lp_eye - op_eye;
+	vec3 direction_to_light_eye = normalize (dist_to_light_eye);
+
+	float dot_prod = max (dot (direction_to_light_eye,  n_eye), 0.0);
+	vec3 Id = ld * kd * dot_prod;
+
+	vec3 reflection_eye = reflect (-direction_to_light_eye, n_eye);
+	vec3 surface_to_viewer_eye = normalize (-op_eye);
+	float dot_prod_specular = max (dot (reflection_eye, surface_to_viewer_eye), 0.0);
+	float specular_factor = pow (dot_prod_specular, specular_exponent);
+	vec3 Is = ls * ks * specular_factor;
+
+	float atten_factor = max (0.0, 1.0 - length (dist_to_light_eye) / radius);
+	return (Id + Is) * atten_factor;
+}
+
+void main () {
+	ivec2 pixel = ivec2 (gl_FragCoord.xy);
+	vec3 p_eye = texelFetch (p_tex, pixel, 0).rgb;
+	// skip background
+	if (p_eye.z > -0.0001) {
+		discard;
+	}
+	vec3 n_eye = normalize (texelFetch (n_tex, pixel, 0).rgb);
+
+	/* same as cluster_slice() in light_clusters.cpp */
+	float depth = -p_eye.z;
+	int slice = int (log (depth / depth_range.x) / log (depth_range.y / depth_range.x) * float (CLUSTER_SLICES));
+	slice = clamp (slice, 0, CLUSTER_SLICES - 1);
+	ivec2 tile = pixel / CLUSTER_TILE_PIXELS;
+	int cluster = (slice * tiles_y + tile.y) * tiles_x + tile.x;
+
+	uvec2 cell = texelFetch (grid, cluster).rg;
+	vec3 colour = vec3 (0.0);
+	for (uint i = 0u; i < cell.y; i++) {
+		int light = int (texelFetch (indices, int (cell.x + i)).r);
+		vec4 p_radius = texelFetch (lights, light * 2);
+		vec3 ld = texelFetch (lights, light * 2 + 1).rgb;
+		colour += phong (p_eye, n_eye, p_radius.xyz, p_radius.w, ld);
+	}
+	frag_colour = vec4 (colour, 1.0);
+}
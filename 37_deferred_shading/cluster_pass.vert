@@ -0,0 +1,8 @@
+#version 410
+
+/* one triangle that covers the whole screen, made from the vertex number so
+that no vertex buffer is needed */
+void main () {
+	vec2 p = vec2 (float ((gl_VertexID << 1) & 2), float (gl_VertexID & 2));
+	gl_Position = vec4 (p * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,27 @@
+#version 410
+
+in vec3 p_eye;
+in vec3 n_eye;
+
+/* diffuse colour in rgb and specular strength in a */
+uniform vec4 albedo_spec;
+
+/* no position output. the second pass works it out from the depth buffer */
+layout (location = 0) out vec2 def_n;
+layout (location = 1) out vec4 def_albedo_spec;
+
+/* a unit normal fits in 2 numbers. project it onto an octahedron, then unfold
+the lower half of the octahedron over the corners of the upper half's square */
+vec2 oct_encode (vec3 n) {
+	n /= abs (n.x) + abs (n.y) + abs (n.z);
+	if (n.z < 0.0) {
+		vec2 sign_xy = vec2 (n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs (n.yx)) * sign_xy;
+	}
+	return n.xy;
+}
+
+void main () {
+	def_n = oct_encode (normalize (n_eye));
+	def_albedo_spec = albedo_spec;
+}
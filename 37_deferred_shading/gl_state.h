@@ -0,0 +1,53 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| A thin render state tracker. Each function here matches a GL call, but       |
+| remembers the last value set and drops the call if nothing would change.     |
+| Every GL call costs CPU time in the driver, so on CPU-bound frames it is     |
+| worth not asking for state that is already set.                              |
+| The tracker only knows about changes made through it. Call                   |
+| gl_state_invalidate() once the context has started, and again after calling  |
+| GL directly, e.g. while creating textures and framebuffers. The next call of |
+| each kind will then go through.                                              |
+| Unless NDEBUG is defined, requested and actual changes are counted and       |
+| gl_state_end_frame() reports them per frame about once a second.             |
+\******************************************************************************/
+#ifndef _GL_STATE_H_
+#define _GL_STATE_H_
+
+#include <GL/glew.h>
+
+#define GL_STATE_MAX_TEXTURE_UNITS 16
+
+/* forget everything, so that the next call of each kind reaches GL */
+void gl_state_invalidate();
+
+/* GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST,
+and GL_POLYGON_OFFSET_FILL are tracked. anything else is passed straight on */
+void gl_state_enable( GLenum cap );
+void gl_state_disable( GLenum cap );
+void gl_state_depth_mask( GLboolean flag );
+void gl_state_depth_func( GLenum func );
+void gl_state_blend_func( GLenum sfactor, GLenum dfactor );
+void gl_state_blend_equation( GLenum mode );
+void gl_state_cull_face( GLenum mode );
+void gl_state_front_face( GLenum mode );
+void gl_state_clear_colour( GLfloat r, GLfloat g, GLfloat b, GLfloat a );
+void gl_state_viewport( GLint x, GLint y, GLsizei w, GLsizei h );
+void gl_state_use_program( GLuint programme );
+void gl_state_bind_vertex_array( GLuint vao );
+void gl_state_bind_framebuffer( GLuint fb );
+/* combines glActiveTexture() and glBindTexture(). only calls glActiveTexture()
+if the texture binding actually has to change. GL_TEXTURE_2D,
+GL_TEXTURE_CUBE_MAP, and GL_TEXTURE_2D_ARRAY are tracked */
+void gl_state_bind_texture( GLuint unit, GLenum target, GLuint texture );
+
+/* call once per frame. reports counts in debug builds, otherwise does nothing */
+void gl_state_end_frame();
+
+#endif
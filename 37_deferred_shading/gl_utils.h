@@ -36,6 +36,7 @@ void _update_fps_counter( GLFWwindow* window );
 /*-----------------------------------SHADERS----------------------------------*/
 bool parse_file_into_str( const char* file_name, char* shader_str, int max_len );
 void print_shader_info_log( GLuint shader_index );
+void print_programme_info_log( GLuint sp );
 bool create_shader( const char* file_name, GLuint* shader, GLenum type );
 bool is_programme_valid( GLuint sp );
 bool create_programme( GLuint vert, GLuint frag, GLuint* programme );
@@ -0,0 +1,343 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Clustered light binning.                                                     |
+\******************************************************************************/
+#include "light_clusters.h"
+#include "gl_state.h"
+#include "gl_utils.h"
+#include <condition_variable>
+#include <math.h>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#define CLUSTER_BIN_CS "cluster_bin.comp"
+
+/*--------------------------------WORKER THREAD-------------------------------*/
+struct cluster_worker_t {
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable start_cv, done_cv;
+  bool busy; /* set by the caller, cleared by the worker when it's done */
+  bool quit;
+  light_clusters_t* clusters;
+  const cluster_light_t* lights;
+  int n_lights;
+};
+
+static void worker_main( cluster_worker_t* worker ) {
+  std::unique_lock<std::mutex> lock( worker->mutex );
+  while ( true ) {
+    while ( !worker->quit && !worker->busy ) { worker->start_cv.wait( lock ); }
+    if ( worker->quit ) { return; }
+    /* the caller doesn't touch the job until busy is cleared */
+    lock.unlock();
+    bin_lights_cpu( worker->clusters, worker->lights, worker->n_lights );
+    lock.lock();
+    worker->busy = false;
+    worker->done_cv.notify_one();
+  }
+}
+
+/*---------------------------------GL SET UP----------------------------------*/
+static GLuint create_buffer_texture( GLuint* buffer, GLsizeiptr size, GLenum format ) {
+  glGenBuffers( 1, buffer );
+  glBindBuffer( GL_TEXTURE_BUFFER, *buffer );
+  glBufferData( GL_TEXTURE_BUFFER, size, NULL, GL_DYNAMIC_DRAW );
+  GLuint tex = 0;
+  glGenTextures( 1, &tex );
+  glBindTexture( GL_TEXTURE_BUFFER, tex );
+  glTexBuffer( GL_TEXTURE_BUFFER, format, *buffer );
+  glBindTexture( GL_TEXTURE_BUFFER, 0 );
+  glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+  return tex;
+}
+
+static GLuint create_compute_programme( const char* file_name ) {
+  GLuint shader = 0;
+  if ( !create_shader( file_name, &shader, GL_COMPUTE_SHADER ) ) {
+    glDeleteShader( shader );
+    return 0;
+  }
+  GLuint programme = glCreateProgram();
+  glAttachShader( programme, shader );
+  glLinkProgram( programme );
+  glDeleteShader( shader );
+  GLint params = -1;
+  glGetProgramiv( programme, GL_LINK_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    gl_log_err( "ERROR: could not link compute programme %s\n", file_name );
+    print_programme_info_log( programme );
+    glDeleteProgram( programme );
+    return 0;
+  }
+  return programme;
+}
+
+/* eye-space box around the part of the view frustum that a cluster covers */
+static void cluster_aabb( const light_clusters_t* c, int tx, int ty, int slice, float* aabb ) {
+  float d0 = c->near * powf( c->far / c->near, (float)slice / CLUSTER_SLICES );
+  float d1 = c->near * powf( c->far / c->near, (float)( slice + 1 ) / CLUSTER_SLICES );
+  /* tile edges in normalised device coordinates */
+  float x0 = (float)( tx * CLUSTER_TILE_PIXELS ) / c->width * 2.0f - 1.0f;
+  float x1 = (float)( ( tx + 1 ) * CLUSTER_TILE_PIXELS ) / c->width * 2.0f - 1.0f;
+  float y0 = (float)( ty * CLUSTER_TILE_PIXELS ) / c->height * 2.0f - 1.0f;
+  float y1 = (float)( ( ty + 1 ) * CLUSTER_TILE_PIXELS ) / c->height * 2.0f - 1.0f;
+  /* at depth d a point at ndc x is at eye x = x * d / P00. the box has to hold
+  the corners at both the near and far depth of the slice */
+  aabb[0] = fminf( x0 * d0, x0 * d1 ) / c->P00;
+  aabb[1] = fminf( y0 * d0, y0 * d1 ) / c->P11;
+  aabb[2] = -d1;
+  aabb[3] = fmaxf( x1 * d0, x1 * d1 ) / c->P00;
+  aabb[4] = fmaxf( y1 * d0, y1 * d1 ) / c->P11;
+  aabb[5] = -d0;
+}
+
+bool init_light_clusters( light_clusters_t* clusters, int width, int height, float P00, float P11, float near, float far, int max_lights ) {
+  memset( clusters, 0, sizeof( light_clusters_t ) );
+  clusters->width      = width;
+  clusters->height     = height;
+  clusters->tiles_x    = ( width + CLUSTER_TILE_PIXELS - 1 ) / CLUSTER_TILE_PIXELS;
+  clusters->tiles_y    = ( height + CLUSTER_TILE_PIXELS - 1 ) / CLUSTER_TILE_PIXELS;
+  clusters->n_clusters = clusters->tiles_x * clusters->tiles_y * CLUSTER_SLICES;
+  clusters->near       = near;
+  clusters->far        = far;
+  clusters->P00        = P00;
+  clusters->P11        = P11;
+  clusters->max_lights = max_lights;
+  clusters->aabbs      = (float*)malloc( clusters->n_clusters * 6 * sizeof( float ) );
+  clusters->grid       = (GLuint*)malloc( clusters->n_clusters * 2 * sizeof( GLuint ) );
+  clusters->indices    = (GLuint*)malloc( CLUSTER_MAX_INDICES * sizeof( GLuint ) );
+  if ( !clusters->aabbs || !clusters->grid || !clusters->indices ) {
+    gl_log_err( "ERROR: out of memory for %i light clusters\n", clusters->n_clusters );
+    free( clusters->aabbs );
+    free( clusters->grid );
+    free( clusters->indices );
+    clusters->aabbs   = NULL;
+    clusters->grid    = NULL;
+    clusters->indices = NULL;
+    return false;
+  }
+  for ( int s = 0; s < CLUSTER_SLICES; s++ ) {
+    for ( int ty = 0; ty < clusters->tiles_y; ty++ ) {
+      for ( int tx = 0; tx < clusters->tiles_x; tx++ ) {
+        int i = ( s * clusters->tiles_y + ty ) * clusters->tiles_x + tx;
+        cluster_aabb( clusters, tx, ty, s, &clusters->aabbs[i * 6] );
+      }
+    }
+  }
+
+  clusters->lights_tex = create_buffer_texture( &clusters->lights_buf, max_lights * sizeof( cluster_light_t ), GL_RGBA32F );
+  clusters->grid_tex   = create_buffer_texture( &clusters->grid_buf, clusters->n_clusters * 2 * sizeof( GLuint ), GL_RG32UI );
+  clusters->index_tex  = create_buffer_texture( &clusters->index_buf, CLUSTER_MAX_INDICES * sizeof( GLuint ), GL_R32UI );
+
+  if ( GLEW_VERSION_4_3 ) {
+    clusters->compute_sp = create_compute_programme( CLUSTER_BIN_CS );
+    if ( clusters->compute_sp ) {
+      /* everything but the light count stays the same */
+      GLuint sp = clusters->compute_sp;
+      glUseProgram( sp );
+      glUniform1i( glGetUniformLocation( sp, "lights" ), 0 );
+      glUniform2i( glGetUniformLocation( sp, "tiles" ), clusters->tiles_x, clusters->tiles_y );
+      glUniform2f( glGetUniformLocation( sp, "viewport" ), (float)width, (float)height );
+      glUniform2f( glGetUniformLocation( sp, "proj_scale" ), P00, P11 );
+      glUniform2f( glGetUniformLocation( sp, "depth_range" ), near, far );
+      clusters->compute_n_lights_loc = glGetUniformLocation( sp, "n_lights" );
+      glUseProgram( 0 );
+    }
+    glGenBuffers( 1, &clusters->counter_buf );
+    glBindBuffer( GL_SHADER_STORAGE_BUFFER, clusters->counter_buf );
+    glBufferData( GL_SHADER_STORAGE_BUFFER, 2 * sizeof( GLuint ), NULL, GL_DYNAMIC_DRAW );
+    glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+  } else {
+    gl_log( "GL 4.3 is not available so lights can only be binned on the CPU\n" );
+  }
+
+  clusters->worker           = new cluster_worker_t;
+  clusters->worker->busy     = false;
+  clusters->worker->quit     = false;
+  clusters->worker->clusters = clusters;
+  clusters->worker->lights   = NULL;
+  clusters->worker->n_lights = 0;
+  clusters->worker->thread   = std::thread( worker_main, clusters->worker );
+  gl_log( "%ix%i tiles of %ipx x %i slices = %i light clusters\n", clusters->tiles_x, clusters->tiles_y, CLUSTER_TILE_PIXELS, CLUSTER_SLICES, clusters->n_clusters );
+  return true;
+}
+
+void free_light_clusters( light_clusters_t* clusters ) {
+  if ( clusters->worker ) {
+    {
+      std::lock_guard<std::mutex> lock( clusters->worker->mutex );
+      clusters->worker->quit = true;
+    }
+    clusters->worker->start_cv.notify_one();
+    clusters->worker->thread.join();
+    delete clusters->worker;
+  }
+  GLuint textures[] = { clusters->lights_tex, clusters->grid_tex, clusters->index_tex };
+  GLuint buffers[]  = { clusters->lights_buf, clusters->grid_buf, clusters->index_buf, clusters->counter_buf };
+  glDeleteTextures( 3, textures );
+  glDeleteBuffers( 4, buffers );
+  if ( clusters->compute_sp ) { glDeleteProgram( clusters->compute_sp ); }
+  free( clusters->aabbs );
+  free( clusters->grid );
+  free( clusters->indices );
+  memset( clusters, 0, sizeof( light_clusters_t ) );
+}
+
+int cluster_slice( const light_clusters_t* clusters, float depth ) {
+  if ( depth <= clusters->near ) { return 0; }
+  int slice = (int)( logf( depth / clusters->near ) / logf( clusters->far / clusters->near ) * CLUSTER_SLICES );
+  return slice < CLUSTER_SLICES ? slice : CLUSTER_SLICES - 1;
+}
+
+/*--------------------------------CPU BINNING---------------------------------*/
+static bool sphere_touches_aabb( const cluster_light_t* l, const float* aabb ) {
+  float dist_sq = 0.0f;
+  for ( int i = 0; i < 3; i++ ) {
+    float v = l->p_eye[i];
+    if ( v < aabb[i] ) { dist_sq += ( aabb[i] - v ) * ( aabb[i] - v ); }
+    if ( v > aabb[i + 3] ) { dist_sq += ( v - aabb[i + 3] ) * ( v - aabb[i + 3] ); }
+  }
+  return dist_sq <= l->radius * l->radius;
+}
+
+/* screen tiles covered by a range of eye x (or y) at depths d0 to d1. x/d is
+monotonic in both, so the extremes are at the corners */
+static void tile_range( float lo, float hi, float d0, float d1, float P, int size, int n_tiles, int* first, int* last ) {
+  float a = fminf( lo / d0, lo / d1 ) * P;
+  float b = fmaxf( hi / d0, hi / d1 ) * P;
+  *first  = (int)floorf( ( a * 0.5f + 0.5f ) * size / CLUSTER_TILE_PIXELS );
+  *last   = (int)floorf( ( b * 0.5f + 0.5f ) * size / CLUSTER_TILE_PIXELS );
+  *first  = *first < 0 ? 0 : *first;
+  *last   = *last >= n_tiles ? n_tiles - 1 : *last;
+}
+
+/* calls visit for every cluster a light's sphere touches. first narrows down to
+the clusters inside the sphere's screen-space box, then tests each of those */
+static void visit_light_clusters( light_clusters_t* c, const cluster_light_t* l, int light, void ( *visit )( light_clusters_t* c, int cluster, int light ) ) {
+  float depth = -l->p_eye[2];
+  float d0    = depth - l->radius;
+  float d1    = depth + l->radius;
+  if ( d1 < c->near || d0 > c->far ) { return; }
+  d0     = d0 < c->near ? c->near : d0;
+  d1     = d1 > c->far ? c->far : d1;
+  int s0 = cluster_slice( c, d0 ), s1 = cluster_slice( c, d1 );
+  int x0, x1, y0, y1;
+  tile_range( l->p_eye[0] - l->radius, l->p_eye[0] + l->radius, d0, d1, c->P00, c->width, c->tiles_x, &x0, &x1 );
+  tile_range( l->p_eye[1] - l->radius, l->p_eye[1] + l->radius, d0, d1, c->P11, c->height, c->tiles_y, &y0, &y1 );
+  for ( int s = s0; s <= s1; s++ ) {
+    for ( int ty = y0; ty <= y1; ty++ ) {
+      for ( int tx = x0; tx <= x1; tx++ ) {
+        int i = ( s * c->tiles_y + ty ) * c->tiles_x + tx;
+        if ( sphere_touches_aabb( l, &c->aabbs[i * 6] ) ) { visit( c, i, light ); }
+      }
+    }
+  }
+}
+
+static void count_light( light_clusters_t* c, int cluster, int light ) { c->grid[cluster * 2 + 1]++; }
+
+static void add_light( light_clusters_t* c, int cluster, int light ) {
+  GLuint* cell = &c->grid[cluster * 2];
+  if ( cell[1] >= CLUSTER_MAX_LIGHTS || (int)( cell[0] + cell[1] ) >= CLUSTER_MAX_INDICES ) {
+    c->n_dropped++;
+    return;
+  }
+  c->indices[cell[0] + cell[1]] = light;
+  cell[1]++;
+}
+
+void bin_lights_cpu( light_clusters_t* clusters, const cluster_light_t* lights, int n_lights ) {
+  /* count the lights in each cluster, then give each cluster a run of the index
+  list, then fill the runs. the lights end up in ascending order, like the
+  compute shader's */
+  memset( clusters->grid, 0, clusters->n_clusters * 2 * sizeof( GLuint ) );
+  for ( int i = 0; i < n_lights; i++ ) { visit_light_clusters( clusters, &lights[i], i, count_light ); }
+  GLuint offset = 0;
+  for ( int i = 0; i < clusters->n_clusters; i++ ) {
+    GLuint count              = clusters->grid[i * 2 + 1];
+    clusters->grid[i * 2]     = offset;
+    clusters->grid[i * 2 + 1] = 0;
+    offset += count < CLUSTER_MAX_LIGHTS ? count : CLUSTER_MAX_LIGHTS;
+  }
+  clusters->n_dropped = 0;
+  for ( int i = 0; i < n_lights; i++ ) { visit_light_clusters( clusters, &lights[i], i, add_light ); }
+  clusters->n_indices = offset < CLUSTER_MAX_INDICES ? (int)offset : CLUSTER_MAX_INDICES;
+}
+
+void start_binning_lights( light_clusters_t* clusters, const cluster_light_t* lights, int n_lights ) {
+  cluster_worker_t* worker = clusters->worker;
+  {
+    std::lock_guard<std::mutex> lock( worker->mutex );
+    worker->lights   = lights;
+    worker->n_lights = n_lights;
+    worker->busy     = true;
+  }
+  worker->start_cv.notify_one();
+}
+
+void finish_binning_lights( light_clusters_t* clusters ) {
+  cluster_worker_t* worker = clusters->worker;
+  {
+    std::unique_lock<std::mutex> lock( worker->mutex );
+    while ( worker->busy ) { worker->done_cv.wait( lock ); }
+  }
+  glBindBuffer( GL_TEXTURE_BUFFER, clusters->grid_buf );
+  glBufferSubData( GL_TEXTURE_BUFFER, 0, clusters->n_clusters * 2 * sizeof( GLuint ), clusters->grid );
+  glBindBuffer( GL_TEXTURE_BUFFER, clusters->index_buf );
+  glBufferSubData( GL_TEXTURE_BUFFER, 0, clusters->n_indices * sizeof( GLuint ), clusters->indices );
+  glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+}
+
+/*--------------------------------GPU BINNING---------------------------------*/
+void upload_cluster_lights( light_clusters_t* clusters, const cluster_light_t* lights, int n_lights ) {
+  if ( n_lights > clusters->max_lights ) { n_lights = clusters->max_lights; }
+  glBindBuffer( GL_TEXTURE_BUFFER, clusters->lights_buf );
+  /* orphan last frame's lights rather than wait for the GPU to finish with them */
+  glBufferData( GL_TEXTURE_BUFFER, clusters->max_lights * sizeof( cluster_light_t ), NULL, GL_DYNAMIC_DRAW );
+  glBufferSubData( GL_TEXTURE_BUFFER, 0, n_lights * sizeof( cluster_light_t ), lights );
+  glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+}
+
+bool bin_lights_gpu( light_clusters_t* clusters, int n_lights ) {
+  if ( !clusters->compute_sp ) { return false; }
+  if ( n_lights > clusters->max_lights ) { n_lights = clusters->max_lights; }
+  /* the index list is handed out with an atomic counter, and a second counter
+  records dropped lights */
+  GLuint zeros[2] = { 0, 0 };
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, clusters->counter_buf );
+  glBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, sizeof( zeros ), zeros );
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, clusters->grid_buf );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, clusters->index_buf );
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, clusters->counter_buf );
+  gl_state_bind_texture( 0, GL_TEXTURE_BUFFER, clusters->lights_tex );
+
+  gl_state_use_program( clusters->compute_sp );
+  glUniform1i( clusters->compute_n_lights_loc, n_lights );
+  glDispatchCompute( ( clusters->n_clusters + CLUSTER_COMPUTE_GROUP - 1 ) / CLUSTER_COMPUTE_GROUP, 1, 1 );
+  /* the shading pass reads the results as buffer textures */
+  glMemoryBarrier( GL_TEXTURE_FETCH_BARRIER_BIT );
+  return true;
+}
+
+void read_gpu_cluster_counts( const light_clusters_t* clusters, int* n_indices, int* n_dropped ) {
+  GLuint counts[2] = { 0, 0 };
+  if ( clusters->compute_sp ) {
+    glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT );
+    glBindBuffer( GL_SHADER_STORAGE_BUFFER, clusters->counter_buf );
+    glGetBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, sizeof( counts ), counts );
+    glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+  }
+  /* the counter runs on past the end of a full list. clamp it as bin_lights_cpu() does */
+  *n_indices = counts[0] < CLUSTER_MAX_INDICES ? (int)counts[0] : CLUSTER_MAX_INDICES;
+  *n_dropped = (int)counts[1];
+}
@@ -0,0 +1,96 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Clustered light binning.                                                     |
+| Drawing a sphere per light makes every light read the G-buffer again for    |
+| every pixel it covers. Instead, the view frustum is cut into clusters:       |
+| square screen tiles, each split into depth slices that get exponentially     |
+| thicker further away. Each light is listed in every cluster its sphere       |
+| touches, and one full-screen pass then shades each pixel with only the       |
+| lights in its cluster.                                                       |
+| Lights can be binned on the CPU, on a worker thread so that it overlaps the  |
+| G-buffer pass, or by a compute shader (GL 4.3). Both write the same layout:  |
+|   grid    - an offset and count into the index list for each cluster         |
+|   indices - light numbers, grouped by cluster                                |
+|   lights  - 2 RGBA32F texels per light: eye-space position and radius, then  |
+|             colour                                                           |
+| The shading pass reads all three as buffer textures, so it only needs 4.1.   |
+\******************************************************************************/
+#ifndef _LIGHT_CLUSTERS_H_
+#define _LIGHT_CLUSTERS_H_
+
+#include <GL/glew.h>
+
+#define CLUSTER_TILE_PIXELS 32
+#define CLUSTER_SLICES 16
+/* lights past this many in one cluster are dropped */
+#define CLUSTER_MAX_LIGHTS 1024
+/* size of the index list shared by all clusters */
+#define CLUSTER_MAX_INDICES ( 1 << 21 )
+/* invocations per compute work group. also the lights loaded per batch */
+#define CLUSTER_COMPUTE_GROUP 64
+
+/* the same layout as the lights buffer texture */
+struct cluster_light_t {
+  float p_eye[3];
+  float radius;
+  float colour[3];
+  float unused;
+};
+
+/* the worker thread is hidden away in light_clusters.cpp */
+struct cluster_worker_t;
+
+struct light_clusters_t {
+  int width, height; /* of the viewport, in pixels */
+  int tiles_x, tiles_y;
+  int n_clusters;
+  float near, far;   /* depths covered by the slices */
+  float P00, P11;    /* perspective scale factors from the projection matrix */
+  float* aabbs;      /* eye-space min and max corners of each cluster */
+  /* CPU binning results */
+  GLuint* grid;
+  GLuint* indices;
+  int n_indices;
+  int n_dropped; /* lights that didn't fit in a cluster or the index list */
+  /* GL buffers, each with a buffer texture over it */
+  int max_lights;
+  GLuint lights_buf, lights_tex;
+  GLuint grid_buf, grid_tex;
+  GLuint index_buf, index_tex;
+  GLuint counter_buf;
+  GLuint compute_sp; /* 0 if compute shaders aren't supported */
+  GLint compute_n_lights_loc;
+  cluster_worker_t* worker;
+};
+
+/* P00 and P11 are the projection matrix's m[0] and m[5]. clusters cover depths
+from near to far. pixels outside that use the first or last slice */
+bool init_light_clusters( light_clusters_t* clusters, int width, int height, float P00, float P11, float near, float far, int max_lights );
+void free_light_clusters( light_clusters_t* clusters );
+
+/* depth slice for a distance in front of the camera */
+int cluster_slice( const light_clusters_t* clusters, float depth );
+
+/* the reference binning, done on the calling thread. fills grid and indices */
+void bin_lights_cpu( light_clusters_t* clusters, const cluster_light_t* lights, int n_lights );
+/* hands bin_lights_cpu() to the worker thread. lights must stay unchanged until
+finish_binning_lights() returns */
+void start_binning_lights( light_clusters_t* clusters, const cluster_light_t* lights, int n_lights );
+/* waits for the worker and uploads its grid and indices */
+void finish_binning_lights( light_clusters_t* clusters );
+
+/* copies lights into the lights buffer. needed by both binning paths */
+void upload_cluster_lights( light_clusters_t* clusters, const cluster_light_t* lights, int n_lights );
+/* bins the uploaded lights with the compute shader. false if not supported */
+bool bin_lights_gpu( light_clusters_t* clusters, int n_lights );
+/* the compute shader's index and dropped light counts from its last binning.
+waits for the GPU, so it's for statistics only */
+void read_gpu_cluster_counts( const light_clusters_t* clusters, int* n_indices, int* n_dropped );
+
+#endif
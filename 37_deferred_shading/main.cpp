@@ -1,121 +1,246 @@
-
-
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 27 Jan 2014                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries separate legal notices                              |
+|******************************************************************************|
+| Deferred Shading                                                             |
+| The first pass writes each pixel's surface into a G-buffer. The lights are   |
+| then added up from that, either as a sphere drawn per light or in one pass   |
+| over the screen with the lights binned into clusters - see light_clusters.h. |
+| G swaps G-buffer layouts. The full one stores positions and normals as       |
+| floats: 22 bytes a pixel, 18 read per pixel lit. The compact one rebuilds    |
+| positions from depth and packs normals into 2 channels: 12 stored and read.  |
+| B times the lighting passes. On llvmpipe, one core, at 800x800, in ms:       |
+|   lights   volumes full/compact   clustered full/compact   compute f/c       |
+|       16        14.4 / 16.2            24.1 / 29.8          24.3 / 27.7      |
+|     1024         642 / 999              177 / 201            174 / 176       |
+|    10000        6828 / 10213           1440 / 1461          1529 / 1627      |
+| A software rasteriser isn't short of bandwidth, so there the decoding costs  |
+| more than the bytes save, most of all for volumes, which decode per light.   |
+\******************************************************************************/
+#include "gl_state.h"
 #include "gl_utils.h"
+#include "light_clusters.h"
 #include "maths_funcs.h"
 #include "obj_parser.h"
+#include "uniform_cache.h"
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define FIRST_PASS_VS "first_pass.vert"
 #define FIRST_PASS_FS "first_pass.frag"
+#define FIRST_PASS_COMPACT_FS "first_pass_compact.frag"
 #define SECOND_PASS_VS "second_pass.vert"
 #define SECOND_PASS_FS "second_pass.frag"
+#define SECOND_PASS_COMPACT_FS "second_pass_compact.frag"
+#define CLUSTER_PASS_VS "cluster_pass.vert"
+#define CLUSTER_PASS_FS "cluster_pass.frag"
+#define CLUSTER_PASS_COMPACT_FS "cluster_pass_compact.frag"
 #define SPHERE_FILE "sphere.obj"
 #define PLANE_FILE "plane.obj"
-#define NUM_LIGHTS 64
+#define MAX_LIGHTS 10000
+#define LIGHT_RADIUS 10.0f
+/* depths split into cluster slices. the far end of the ground plane is about
+300 away */
+#define CLUSTER_NEAR 1.0f
+#define CLUSTER_FAR 500.0f
 
 int g_gl_width  = 800;
 int g_gl_height = 800;
 GLFWwindow* g_window;
 
-/* the framebuffer used for write-to-G-buffer */
-GLuint g_fb;
-GLuint g_fb_tex_p; /* G-buffer hog_L_ding positions in a texture */
-GLuint g_fb_tex_n; /* G-buffer hog_L_ding normag_L_s in a texture */
+/* a G-buffer layout and the shaders that write and read it. the full layout
+stores positions and normals as floats. the compact one works out positions
+from the depth buffer, packs normals into 2 channels, and adds a colour */
+struct g_buffer_t {
+  const char* name;
+  bool compact;
+  GLuint fb;
+  GLuint tex[2];  /* full: positions, normals. compact: normals, albedo+specular */
+  GLuint depth_tex;
+  int bytes_per_pixel;      /* stored, including depth */
+  int bytes_read_per_pixel; /* fetched by the lighting pass for each pixel */
+  /* shader for collecting the G-buffer */
+  GLuint first_pass_sp;
+  programme_uniforms_t first_pass_uniforms;
+  /* shader for rendering the deferred pass */
+  GLuint second_pass_sp;
+  programme_uniforms_t second_pass_uniforms;
+  /* shader for shading every pixel with the lights of its cluster at once */
+  GLuint cluster_pass_sp;
+  programme_uniforms_t cluster_pass_uniforms;
+};
+g_buffer_t g_gbuffers[2];
+g_buffer_t* g_gbuffer = &g_gbuffers[1]; /* the one in use */
 /* 3d sphere representing light coverage area */
 GLuint g_sphere_vao;
 int g_sphere_point_count;
 /* 3d rectangle that will have light cast onto it */
 GLuint g_plane_vao;
 int g_plane_point_count;
-/* shader for collecting the G-buffer */
-GLuint g_first_pass_sp;
-GLint g_first_pass_P_loc; /* Projection matrix uniform location */
-GLint g_first_pass_V_loc; /* View matrix uniform location */
-GLint g_first_pass_M_loc; /* Model matrix uniform location */
-/* shader for rendering the deferred pass */
-GLuint g_second_pass_sp;
-GLint g_second_pass_P_loc     = -1;
-GLint g_second_pass_V_loc     = -1;
-GLint g_second_pass_M_loc     = -1; /* Model matrix uniform location */
-GLint g_second_pass_L_p_loc   = -1; /* light position uniform location */
-GLint g_second_pass_L_d_loc   = -1; /* light diffuse colour uniform location */
-GLint g_second_pass_L_s_loc   = -1; /* light specular colour uniform location */
-GLint g_second_pass_p_tex_loc = -1; /* positions texture uniform location */
-GLint g_second_pass_n_tex_loc = -1; /* normals texture uniform location */
+GLuint g_empty_vao; /* the full-screen triangle has no vertex buffers */
+light_clusters_t g_clusters;
+/* hashes of uniform names, used to look them up in the uniform caches */
+unsigned int g_P_hash;     /* Projection matrix */
+unsigned int g_V_hash;     /* View matrix */
+unsigned int g_M_hash;     /* Model matrix */
+unsigned int g_L_p_hash;   /* light position */
+unsigned int g_L_d_hash;   /* light diffuse colour */
+unsigned int g_L_s_hash;   /* light specular colour */
+unsigned int g_p_tex_hash; /* positions texture */
+unsigned int g_n_tex_hash; /* normals texture */
 
 /* objects to be lit. model matrices */
 mat4 g_plane_M;
 
 /* light world positions and model matrices */
-vec3 g_L_p[NUM_LIGHTS];
-mat4 g_L_M[NUM_LIGHTS];
+int g_num_lights = 64;
+vec3 g_L_centre[MAX_LIGHTS]; /* each light circles around its centre */
+vec3 g_L_p[MAX_LIGHTS];
+mat4 g_L_M[MAX_LIGHTS];
 /* light colours */
-vec3 g_L_d[NUM_LIGHTS];
-vec3 g_L_s[NUM_LIGHTS];
+vec3 g_L_d[MAX_LIGHTS];
+vec3 g_L_s[MAX_LIGHTS];
+/* eye-space copies of the lights for binning into clusters */
+cluster_light_t g_cluster_lights[MAX_LIGHTS];
+
+/* ways of doing the lighting pass */
+enum lighting_mode_t { LIGHTING_VOLUMES, LIGHTING_CLUSTERED_CPU, LIGHTING_CLUSTERED_COMPUTE, LIGHTING_MODE_COUNT };
+const char* g_lighting_mode_names[] = { "light volumes", "clustered, binned on CPU", "clustered, binned by compute shader" };
+lighting_mode_t g_lighting_mode     = LIGHTING_CLUSTERED_CPU;
 
 /* virtual camera projection and view matrices */
 mat4 g_P;
 mat4 g_V;
 
-/* this function creates the first-pass framebuffer that will write to textures
-comprising the g-buffer, which contain normag_L_s and positions for each pixel on
-the framebuffer. we will attach a renderbuffer which allows us to depth sort
-and write the front-most geometry data into each texture's texel */
-bool init_fb() {
-  glGenFramebuffers( 1, &g_fb );
-  glGenTextures( 1, &g_fb_tex_p );
-  glBindTexture( GL_TEXTURE_2D, g_fb_tex_p );
-  /* note 16-bit float RGB format used for positions */
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB32F, g_gl_width, g_gl_height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL );
+/* makes a texture the size of the viewport to render into */
+GLuint create_target_texture( GLint internal_format, GLenum format, GLenum type ) {
+  GLuint tex;
+  glGenTextures( 1, &tex );
+  glBindTexture( GL_TEXTURE_2D, tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, internal_format, g_gl_width, g_gl_height, 0, format, type, NULL );
   /* no bi-linear filtering required because texture same size as viewport */
   glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
   glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
   glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
   glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-  /* generate output texture to hog_L_d normag_L_s */
-  glGenTextures( 1, &g_fb_tex_n );
-  glBindTexture( GL_TEXTURE_2D, g_fb_tex_n );
-  /* you coug_L_d get away with less than 16-bit precision here for normag_L_s */
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB16F, g_gl_width, g_gl_height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  return tex;
+}
 
-  /* depth texture instead of a renderbuffer */
-  GLuint depth_tex;
-  glGenTextures( 1, &depth_tex );
-  glActiveTexture( GL_TEXTURE0 );
-  glBindTexture( GL_TEXTURE_2D, depth_tex );
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, g_gl_width, g_gl_height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, NULL );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-  // attach depth texture to framebuffer
-  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_tex, 0 );
+/* this function creates the first-pass framebuffer that will write to textures
+comprising the g-buffer. we attach a depth texture which allows us to depth sort
+and write the front-most geometry data into each texture's texel. the compact
+layout reads that depth texture back to work out positions */
+bool init_fb( g_buffer_t* gb, bool compact ) {
+  gb->compact = compact;
+  glGenFramebuffers( 1, &gb->fb );
+  glBindFramebuffer( GL_FRAMEBUFFER, gb->fb );
+  gb->depth_tex = create_target_texture( GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, gb->depth_tex, 0 );
+  if ( compact ) {
+    gb->name = "compact";
+    /* octahedral normals need 2 signed channels. snorm formats don't have to be
+    renderable before GL 4.4, so fall back to 16-bit floats, which are the same
+    size */
+    gb->tex[0] = create_target_texture( GL_RG16_SNORM, GL_RG, GL_FLOAT );
+    glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gb->tex[0], 0 );
+    if ( GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus( GL_FRAMEBUFFER ) ) {
+      gl_log( "GL_RG16_SNORM can't be rendered to here. using GL_RG16F for normals\n" );
+      glDeleteTextures( 1, &gb->tex[0] );
+      gb->tex[0] = create_target_texture( GL_RG16F, GL_RG, GL_FLOAT );
+      glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gb->tex[0], 0 );
+    }
+    gb->tex[1] = create_target_texture( GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE );
+    /* depth 4 + normal 4 + albedo and specular 4. all 3 are read */
+    gb->bytes_per_pixel      = 12;
+    gb->bytes_read_per_pixel = 12;
+  } else {
+    gb->name = "full";
+    /* note 32-bit float RGB format used for positions */
+    gb->tex[0] = create_target_texture( GL_RGB32F, GL_RGB, GL_FLOAT );
+    /* you could get away with less than 16-bit precision here for normals */
+    gb->tex[1] = create_target_texture( GL_RGB16F, GL_RGB, GL_FLOAT );
+    /* positions 12 + normals 6 + depth 4, of which depth isn't read. many GPUs
+    pad RGB formats out to RGBA, which would make it 28 */
+    gb->bytes_per_pixel      = 22;
+    gb->bytes_read_per_pixel = 18;
+  }
 
   /* attach textures to framebuffer. the attachment numbers 0 and 1 don't
   automatically corresponed to frament shader output locations 0 and 1, so we
   specify that afterwards */
-  glBindFramebuffer( GL_FRAMEBUFFER, g_fb );
-  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_fb_tex_p, 0 );
-  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, g_fb_tex_n, 0 );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gb->tex[0], 0 );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gb->tex[1], 0 );
   /* the first item in this array matches fragment shader output location 0 */
   GLenum draw_bufs[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
   glDrawBuffers( 2, draw_bufs );
 
-  /* validate g_fb and return false on error */
+  /* validate the framebuffer and return false on error */
   GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
   if ( GL_FRAMEBUFFER_COMPLETE != status ) {
-    fprintf( stderr, "ERROR: incomplete framebuffer\n" );
+    fprintf( stderr, "ERROR: incomplete %s G-buffer framebuffer\n", gb->name );
     return false;
   }
   return true;
 }
 
+/* loads the shaders for a G-buffer layout and sets the uniforms that never
+change. texture units 0-2 are for the G-buffer and 3-5 for the light clusters.
+returns false if a programme's uniforms couldn't be cached */
+bool load_g_buffer_shaders( g_buffer_t* gb ) {
+  /* load pre-pass shaders that write to the g-buffer */
+  gb->first_pass_sp = create_programme_from_files( FIRST_PASS_VS, gb->compact ? FIRST_PASS_COMPACT_FS : FIRST_PASS_FS );
+  if ( !reflect_programme_uniforms( gb->first_pass_sp, &gb->first_pass_uniforms ) ) { return false; }
+  /* the plane's material. the full layout has these built into the lighting */
+  glUseProgram( gb->first_pass_sp );
+  set_uniform_4f( &gb->first_pass_uniforms, uniform_name_hash( "albedo_spec" ), 0.9f, 0.9f, 0.9f, 0.5f );
+
+  /* load screen-space pass shaders that read from the g-buffer */
+  gb->second_pass_sp  = create_programme_from_files( SECOND_PASS_VS, gb->compact ? SECOND_PASS_COMPACT_FS : SECOND_PASS_FS );
+  gb->cluster_pass_sp = create_programme_from_files( CLUSTER_PASS_VS, gb->compact ? CLUSTER_PASS_COMPACT_FS : CLUSTER_PASS_FS );
+  if ( !reflect_programme_uniforms( gb->second_pass_sp, &gb->second_pass_uniforms ) ) { return false; }
+  if ( !reflect_programme_uniforms( gb->cluster_pass_sp, &gb->cluster_pass_uniforms ) ) { return false; }
+  programme_uniforms_t* pus[] = { &gb->second_pass_uniforms, &gb->cluster_pass_uniforms };
+  mat4 inv_P                  = inverse( g_P );
+  for ( int i = 0; i < 2; i++ ) {
+    glUseProgram( pus[i]->programme );
+    /* setters for uniforms that a programme doesn't have do nothing */
+    set_uniform_1i( pus[i], g_p_tex_hash, 0 );
+    set_uniform_1i( pus[i], uniform_name_hash( "depth_tex" ), 0 );
+    set_uniform_1i( pus[i], g_n_tex_hash, 1 );
+    set_uniform_1i( pus[i], uniform_name_hash( "albedo_tex" ), 2 );
+    set_uniform_1i( pus[i], uniform_name_hash( "lights" ), 3 );
+    set_uniform_1i( pus[i], uniform_name_hash( "grid" ), 4 );
+    set_uniform_1i( pus[i], uniform_name_hash( "indices" ), 5 );
+    set_uniform_1i( pus[i], uniform_name_hash( "tiles_x" ), g_clusters.tiles_x );
+    set_uniform_1i( pus[i], uniform_name_hash( "tiles_y" ), g_clusters.tiles_y );
+    set_uniform_mat4( pus[i], uniform_name_hash( "inv_P" ), inv_P.m );
+    GLint depth_range_loc = get_cached_uniform_location( pus[i], uniform_name_hash( "depth_range" ) );
+    if ( depth_range_loc > -1 ) { glUniform2f( depth_range_loc, CLUSTER_NEAR, CLUSTER_FAR ); }
+    reset_uniform_counters( pus[i] );
+  }
+  reset_uniform_counters( &gb->first_pass_uniforms );
+  return true;
+}
+
+/* binds the textures of the G-buffer in use for a lighting pass */
+void bind_g_buffer_textures() {
+  if ( g_gbuffer->compact ) {
+    gl_state_bind_texture( 0, GL_TEXTURE_2D, g_gbuffer->depth_tex );
+    gl_state_bind_texture( 1, GL_TEXTURE_2D, g_gbuffer->tex[0] );
+    gl_state_bind_texture( 2, GL_TEXTURE_2D, g_gbuffer->tex[1] );
+  } else {
+    gl_state_bind_texture( 0, GL_TEXTURE_2D, g_gbuffer->tex[0] );
+    gl_state_bind_texture( 1, GL_TEXTURE_2D, g_gbuffer->tex[1] );
+  }
+}
+
 /* load the ground plane */
 bool load_plane() {
   float* points     = NULL;
@@ -171,27 +296,29 @@ bool load_sphere() {
 }
 
 /* the first pass draws
-* pixel positions
+* pixel positions (full) or an albedo and specular colour (compact)
 * pixel normals
 * pixel depths
-to 3 attached textures. */
+to the attached textures. */
 void draw_first_pass() {
-  glBindFramebuffer( GL_FRAMEBUFFER, g_fb );
-  glClearColor( 0.0f, 0.0f, 0.0f, 1.0f );
+  programme_uniforms_t* pu = &g_gbuffer->first_pass_uniforms;
+  gl_state_bind_framebuffer( g_gbuffer->fb );
+  gl_state_clear_colour( 0.0f, 0.0f, 0.0f, 1.0f );
+  /* the lighting passes turn depth writes off, and glClear() obeys the mask */
+  gl_state_depth_mask( GL_TRUE );
   glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
-  glDisable( GL_BLEND );
-  glEnable( GL_DEPTH_TEST );
-  glDepthMask( GL_TRUE );
+  gl_state_disable( GL_BLEND );
+  gl_state_enable( GL_DEPTH_TEST );
 
-  glUseProgram( g_first_pass_sp );
-  glBindVertexArray( g_plane_vao );
+  gl_state_use_program( g_gbuffer->first_pass_sp );
+  gl_state_bind_vertex_array( g_plane_vao );
 
-  /* virtual camera matrices */
-  glUniformMatrix4fv( g_first_pass_P_loc, 1, GL_FALSE, g_P.m );
-  glUniformMatrix4fv( g_first_pass_V_loc, 1, GL_FALSE, g_V.m );
+  /* virtual camera matrices. these only reach GL if they changed */
+  set_uniform_mat4( pu, g_P_hash, g_P.m );
+  set_uniform_mat4( pu, g_V_hash, g_V.m );
 
-  glUniformMatrix4fv( g_first_pass_M_loc, 1, GL_FALSE, g_plane_M.m );
+  set_uniform_mat4( pu, g_M_hash, g_plane_M.m );
   glDrawArrays( GL_TRIANGLES, 0, g_plane_point_count );
 }
 
@@ -199,97 +326,260 @@ void draw_first_pass() {
  * retrieves pixel positions, normals, and depths
  */
 void draw_second_pass() {
-  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  programme_uniforms_t* pu = &g_gbuffer->second_pass_uniforms;
+  gl_state_bind_framebuffer( 0 );
   /* clear to any colour */
-  glClearColor( 0.2, 0.2, 0.2, 1.0f );
+  gl_state_clear_colour( 0.2, 0.2, 0.2, 1.0f );
   glClear( GL_COLOR_BUFFER_BIT );
 
-  glEnable( GL_BLEND ); // --- could reject background frags!
-  glBlendEquation( GL_FUNC_ADD );
-  glBlendFunc( GL_ONE, GL_ONE ); // addition each time
-  glDisable( GL_DEPTH_TEST );
-  glDepthMask( GL_FALSE );
+  gl_state_enable( GL_BLEND ); // --- could reject background frags!
+  gl_state_blend_equation( GL_FUNC_ADD );
+  gl_state_blend_func( GL_ONE, GL_ONE ); // addition each time
+  gl_state_disable( GL_DEPTH_TEST );
+  gl_state_depth_mask( GL_FALSE );
 
-  glActiveTexture( GL_TEXTURE0 );
-  glBindTexture( GL_TEXTURE_2D, g_fb_tex_p );
-  glActiveTexture( GL_TEXTURE1 );
-  glBindTexture( GL_TEXTURE_2D, g_fb_tex_n );
+  bind_g_buffer_textures();
 
-  glUseProgram( g_second_pass_sp );
-  glBindVertexArray( g_sphere_vao );
+  gl_state_use_program( g_gbuffer->second_pass_sp );
+  gl_state_bind_vertex_array( g_sphere_vao );
 
   /* virtual camera matrices */
-  glUniformMatrix4fv( g_second_pass_P_loc, 1, GL_FALSE, g_P.m );
-  glUniformMatrix4fv( g_second_pass_V_loc, 1, GL_FALSE, g_V.m );
+  set_uniform_mat4( pu, g_P_hash, g_P.m );
+  set_uniform_mat4( pu, g_V_hash, g_V.m );
 
-  for ( int i = 0; i < NUM_LIGHTS; i++ ) {
+  for ( int i = 0; i < g_num_lights; i++ ) {
     /* world position */
-    glUniform3f( g_second_pass_L_p_loc, g_L_p[i].v[0], g_L_p[i].v[1], g_L_p[i].v[2] );
+    set_uniform_3f( pu, g_L_p_hash, g_L_p[i].v[0], g_L_p[i].v[1], g_L_p[i].v[2] );
     /* diffuse colour */
-    glUniform3f( g_second_pass_L_d_loc, g_L_d[i].v[0], g_L_d[i].v[1], g_L_d[i].v[2] );
-    /* specular colour */
-    glUniform3f( g_second_pass_L_s_loc, g_L_s[i].v[0], g_L_s[i].v[1], g_L_s[i].v[2] );
+    set_uniform_3f( pu, g_L_d_hash, g_L_d[i].v[0], g_L_d[i].v[1], g_L_d[i].v[2] );
+    /* specular colour. the same for every light so only sent once */
+    set_uniform_3f( pu, g_L_s_hash, g_L_s[i].v[0], g_L_s[i].v[1], g_L_s[i].v[2] );
 
-    glUniformMatrix4fv( g_second_pass_M_loc, 1, GL_FALSE, g_L_M[i].m );
+    set_uniform_mat4( pu, g_M_hash, g_L_M[i].m );
     glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
   }
 }
 
+/* the clustered second pass. a full-screen triangle where each pixel adds up
+just the lights listed for its cluster */
+void draw_cluster_pass() {
+  gl_state_bind_framebuffer( 0 );
+  gl_state_clear_colour( 0.2, 0.2, 0.2, 1.0f );
+  glClear( GL_COLOR_BUFFER_BIT );
+
+  /* every light is added up in the shader. the sum is added to the clear
+colour, the same as the light volumes */
+  gl_state_enable( GL_BLEND );
+  gl_state_blend_equation( GL_FUNC_ADD );
+  gl_state_blend_func( GL_ONE, GL_ONE );
+  gl_state_disable( GL_DEPTH_TEST );
+  gl_state_depth_mask( GL_FALSE );
+
+  bind_g_buffer_textures();
+  gl_state_bind_texture( 3, GL_TEXTURE_BUFFER, g_clusters.lights_tex );
+  gl_state_bind_texture( 4, GL_TEXTURE_BUFFER, g_clusters.grid_tex );
+  gl_state_bind_texture( 5, GL_TEXTURE_BUFFER, g_clusters.index_tex );
+
+  gl_state_use_program( g_gbuffer->cluster_pass_sp );
+  gl_state_bind_vertex_array( g_empty_vao );
+  glDrawArrays( GL_TRIANGLES, 0, 3 );
+}
+
+/* places n lights at random over the visible part of the ground plane. the
+more lights, the dimmer each one, so that the scene stays about as bright */
+void create_lights( int n ) {
+  g_num_lights    = n < MAX_LIGHTS ? n : MAX_LIGHTS;
+  float intensity = g_num_lights > 64 ? 64.0f / (float)g_num_lights : 1.0f;
+  int redi        = 0;
+  int bluei       = 1;
+  int greeni      = 2;
+  srand( 1 );
+  for ( int i = 0; i < g_num_lights; i++ ) {
+    float x       = ( (float)rand() / (float)RAND_MAX ) * 160.0f - 80.0f;
+    float z       = ( (float)rand() / (float)RAND_MAX ) * 140.0f - 120.0f;
+    g_L_centre[i] = vec3( x, 2.0f, z );
+    /* cycle different colours for each of the lights */
+    g_L_d[i] = vec3( (float)( ( redi + 1 ) / 3 ), (float)( ( greeni + 1 ) / 3 ), (float)( ( bluei + 1 ) / 3 ) ) * intensity;
+    g_L_s[i] = vec3( 1.0, 1.0, 1.0 );
+    redi     = ( redi + 1 ) % 3;
+    bluei    = ( bluei + 1 ) % 3;
+    greeni   = ( greeni + 1 ) % 3;
+  }
+}
+
+/* moves every light around its own small circle, so the clusters have to be
+worked out again each frame */
+void update_lights( double seconds ) {
+  for ( int i = 0; i < g_num_lights; i++ ) {
+    float a  = (float)seconds * 0.5f + (float)i;
+    g_L_p[i] = g_L_centre[i] + vec3( cosf( a ) * 4.0f, 0.0f, sinf( a ) * 4.0f );
+    g_L_M[i] = scale( identity_mat4(), vec3( LIGHT_RADIUS, LIGHT_RADIUS, LIGHT_RADIUS ) );
+    g_L_M[i] = translate( g_L_M[i], g_L_p[i] );
+
+    vec4 p_eye                    = g_V * vec4( g_L_p[i], 1.0f );
+    g_cluster_lights[i].p_eye[0]  = p_eye.v[0];
+    g_cluster_lights[i].p_eye[1]  = p_eye.v[1];
+    g_cluster_lights[i].p_eye[2]  = p_eye.v[2];
+    g_cluster_lights[i].radius    = LIGHT_RADIUS;
+    g_cluster_lights[i].colour[0] = g_L_d[i].v[0];
+    g_cluster_lights[i].colour[1] = g_L_d[i].v[1];
+    g_cluster_lights[i].colour[2] = g_L_d[i].v[2];
+    g_cluster_lights[i].unused    = 0.0f;
+  }
+}
+
+/* draws a whole frame with the current lighting mode. the CPU binning runs on
+the worker thread while the G-buffer pass is submitted */
+void draw_frame() {
+  if ( LIGHTING_CLUSTERED_CPU == g_lighting_mode ) { start_binning_lights( &g_clusters, g_cluster_lights, g_num_lights ); }
+  draw_first_pass();
+  if ( LIGHTING_VOLUMES == g_lighting_mode ) {
+    draw_second_pass();
+    return;
+  }
+  upload_cluster_lights( &g_clusters, g_cluster_lights, g_num_lights );
+  if ( LIGHTING_CLUSTERED_CPU == g_lighting_mode ) {
+    finish_binning_lights( &g_clusters );
+  } else {
+    bin_lights_gpu( &g_clusters, g_num_lights );
+  }
+  draw_cluster_pass();
+}
+
+void print_settings() {
+  printf( "%i lights, %s, %s G-buffer (%i bytes/pixel)\n", g_num_lights, g_lighting_mode_names[g_lighting_mode], g_gbuffer->name, g_gbuffer->bytes_per_pixel );
+}
+
+/* times the lighting for each G-buffer layout and mode with more and more
+lights. GPU time covers uploads, compute binning, and the lighting pass. CPU
+time is binning on the calling thread, which the worker normally hides behind
+the G-buffer pass */
+void benchmark_lighting() {
+  const int counts[]   = { 16, 64, 256, 1024, 4096, 10000 };
+  const int n_counts   = 6;
+  const int n_frames   = 10;
+  int previous_count   = g_num_lights;
+  lighting_mode_t mode = g_lighting_mode;
+  g_buffer_t* gb       = g_gbuffer;
+  GLuint query         = 0;
+  glGenQueries( 1, &query );
+  gl_log( "benchmarking lighting over %i frames per test...\n", n_frames );
+  printf( "benchmarking lighting over %i frames per test...\n", n_frames );
+  for ( int test = 0; test < 2 * n_counts; test++ ) {
+    int c     = test % n_counts;
+    g_gbuffer = &g_gbuffers[test / n_counts];
+    if ( 0 == c ) {
+      gl_log( "%s G-buffer: %i bytes/pixel stored, %i read per pixel lit\n", g_gbuffer->name, g_gbuffer->bytes_per_pixel, g_gbuffer->bytes_read_per_pixel );
+      printf( "%s G-buffer: %i bytes/pixel stored, %i read per pixel lit\n", g_gbuffer->name, g_gbuffer->bytes_per_pixel, g_gbuffer->bytes_read_per_pixel );
+    }
+    create_lights( counts[c] );
+    update_lights( 0.0 );
+    double gpu_ms[LIGHTING_MODE_COUNT] = { 0.0 };
+    double bin_ms                      = 0.0;
+    int n_indices[LIGHTING_MODE_COUNT] = { 0 };
+    int n_dropped[LIGHTING_MODE_COUNT] = { 0 };
+    for ( int m = 0; m < LIGHTING_MODE_COUNT; m++ ) {
+      if ( LIGHTING_CLUSTERED_COMPUTE == m && !g_clusters.compute_sp ) { continue; }
+      for ( int f = 0; f < n_frames; f++ ) {
+        draw_first_pass();
+        glFinish();
+        double start = glfwGetTime();
+        if ( LIGHTING_CLUSTERED_CPU == m ) {
+          bin_lights_cpu( &g_clusters, g_cluster_lights, g_num_lights );
+          bin_ms += ( glfwGetTime() - start ) * 1000.0 / n_frames;
+        }
+        glBeginQuery( GL_TIME_ELAPSED, query );
+        if ( LIGHTING_VOLUMES == m ) {
+          draw_second_pass();
+        } else {
+          upload_cluster_lights( &g_clusters, g_cluster_lights, g_num_lights );
+          if ( LIGHTING_CLUSTERED_CPU == m ) {
+            /* the worker isn't running, so this just uploads the results */
+            finish_binning_lights( &g_clusters );
+          } else {
+            bin_lights_gpu( &g_clusters, g_num_lights );
+          }
+          draw_cluster_pass();
+        }
+        glEndQuery( GL_TIME_ELAPSED );
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v( query, GL_QUERY_RESULT, &ns );
+        gpu_ms[m] += (double)ns / 1000000.0 / n_frames;
+      }
+      /* each clustered path's own counts. the compute shader's are on the GPU */
+      if ( LIGHTING_CLUSTERED_CPU == m ) {
+        n_indices[m] = g_clusters.n_indices;
+        n_dropped[m] = g_clusters.n_dropped;
+      } else if ( LIGHTING_CLUSTERED_COMPUTE == m ) {
+        read_gpu_cluster_counts( &g_clusters, &n_indices[m], &n_dropped[m] );
+      }
+    }
+    float n_clusters  = (float)g_clusters.n_clusters;
+    char compute[128] = "n/a";
+    if ( g_clusters.compute_sp ) {
+      snprintf( compute, sizeof( compute ), "%7.3fms, %.1f lights/cluster, %i dropped", gpu_ms[LIGHTING_CLUSTERED_COMPUTE], n_indices[LIGHTING_CLUSTERED_COMPUTE] / n_clusters,
+        n_dropped[LIGHTING_CLUSTERED_COMPUTE] );
+    }
+    gl_log( "%5i lights: volumes gpu %8.3fms | clustered cpu bin %7.3fms gpu %7.3fms, %.1f lights/cluster, %i dropped | compute bin+gpu %s\n", g_num_lights, gpu_ms[LIGHTING_VOLUMES], bin_ms,
+      gpu_ms[LIGHTING_CLUSTERED_CPU], n_indices[LIGHTING_CLUSTERED_CPU] / n_clusters, n_dropped[LIGHTING_CLUSTERED_CPU], compute );
+    printf( "%5i lights: volumes gpu %8.3fms | clustered cpu bin %7.3fms gpu %7.3fms, %.1f lights/cluster, %i dropped | compute bin+gpu %s\n", g_num_lights, gpu_ms[LIGHTING_VOLUMES], bin_ms,
+      gpu_ms[LIGHTING_CLUSTERED_CPU], n_indices[LIGHTING_CLUSTERED_CPU] / n_clusters, n_dropped[LIGHTING_CLUSTERED_CPU], compute );
+  }
+  glDeleteQueries( 1, &query );
+  create_lights( previous_count );
+  g_lighting_mode = mode;
+  g_gbuffer       = gb;
+}
+
+/* logs how many glUniform*() calls the uniform caches skipped, averaged per
+frame, about once a second */
+void report_uniform_calls_saved() {
+  static double previous_seconds = glfwGetTime();
+  static int frame_count         = 0;
+  static int set_calls           = 0;
+  static int uploads             = 0;
+  set_calls += g_gbuffer->first_pass_uniforms.n_set_calls + g_gbuffer->second_pass_uniforms.n_set_calls + g_gbuffer->cluster_pass_uniforms.n_set_calls;
+  uploads += g_gbuffer->first_pass_uniforms.n_uploads + g_gbuffer->second_pass_uniforms.n_uploads + g_gbuffer->cluster_pass_uniforms.n_uploads;
+  reset_uniform_counters( &g_gbuffer->first_pass_uniforms );
+  reset_uniform_counters( &g_gbuffer->second_pass_uniforms );
+  reset_uniform_counters( &g_gbuffer->cluster_pass_uniforms );
+  frame_count++;
+  double current_seconds = glfwGetTime();
+  if ( current_seconds - previous_seconds > 1.0 ) {
+    float calls_pf = (float)set_calls / (float)frame_count;
+    float sent_pf  = (float)uploads / (float)frame_count;
+    printf( "uniforms per frame: %.1f set, %.1f sent to GL, %.1f GL calls saved\n", calls_pf, sent_pf, calls_pf - sent_pf );
+    gl_log( "uniforms per frame: %.1f set, %.1f sent to GL, %.1f GL calls saved\n", calls_pf, sent_pf, calls_pf - sent_pf );
+    previous_seconds = current_seconds;
+    frame_count      = 0;
+    set_calls        = 0;
+    uploads          = 0;
+  }
+}
+
 int main() {
   /* initialise GL context and window */
   ( restart_gl_log() );
   ( start_gl() );
-  /* initialise framebuffer and G-buffer */
-
   /* object positions and matrices */
   ( load_plane() );
   g_plane_M = scale( identity_mat4(), vec3( 200.0f, 1.0f, 200.0f ) );
   g_plane_M = translate( g_plane_M, vec3( 0.0f, -2.0f, 0.0f ) );
 
-  ( init_fb() );
-  /* load pre-pass shaders that write to the g-buffer */
-  g_first_pass_sp    = create_programme_from_files( FIRST_PASS_VS, FIRST_PASS_FS );
-  g_first_pass_P_loc = glGetUniformLocation( g_first_pass_sp, "P" );
-  g_first_pass_V_loc = glGetUniformLocation( g_first_pass_sp, "V" );
-  g_first_pass_M_loc = glGetUniformLocation( g_first_pass_sp, "M" );
-  /* load screen-space pass shaders that read from the g-buffer */
-  g_second_pass_sp        = create_programme_from_files( SECOND_PASS_VS, SECOND_PASS_FS );
-  g_second_pass_P_loc     = glGetUniformLocation( g_second_pass_sp, "P" );
-  g_second_pass_V_loc     = glGetUniformLocation( g_second_pass_sp, "V" );
-  g_second_pass_M_loc     = glGetUniformLocation( g_second_pass_sp, "M" );
-  g_second_pass_L_p_loc   = glGetUniformLocation( g_second_pass_sp, "lp" );
-  g_second_pass_L_d_loc   = glGetUniformLocation( g_second_pass_sp, "ld" );
-  g_second_pass_L_s_loc   = glGetUniformLocation( g_second_pass_sp, "ls" );
-  g_second_pass_p_tex_loc = glGetUniformLocation( g_second_pass_sp, "p_tex" );
-  g_second_pass_n_tex_loc = glGetUniformLocation( g_second_pass_sp, "n_tex" );
-  glUseProgram( g_second_pass_sp );
-  glUniform1i( g_second_pass_p_tex_loc, 0 );
-  glUniform1i( g_second_pass_n_tex_loc, 1 );
+  g_P_hash     = uniform_name_hash( "P" );
+  g_V_hash     = uniform_name_hash( "V" );
+  g_M_hash     = uniform_name_hash( "M" );
+  g_L_p_hash   = uniform_name_hash( "lp" );
+  g_L_d_hash   = uniform_name_hash( "ld" );
+  g_L_s_hash   = uniform_name_hash( "ls" );
+  g_p_tex_hash = uniform_name_hash( "p_tex" );
+  g_n_tex_hash = uniform_name_hash( "n_tex" );
+  glGenVertexArrays( 1, &g_empty_vao );
 
   /* load sphere mesh */
   ( load_sphere() );
-  /* light positions and matrices */
-  for ( int i = 0; i < NUM_LIGHTS; i++ ) {
-    float x  = -sinf( (float)i * 0.5f ) * 25.0f; // between +- 10 x
-    float y  = 2.0f;
-    float z  = (float)-i * 2.0f + 10.0; // 1 light every 2 meters away on z
-    g_L_p[i] = vec3( x, y, z );
-  }
-
-  float light_radius = 10.0f;
-  int redi           = 0;
-  int bluei          = 1;
-  int greeni         = 2;
-  for ( int i = 0; i < NUM_LIGHTS; i++ ) {
-    g_L_M[i] = scale( identity_mat4(), vec3( light_radius, light_radius, light_radius ) );
-    g_L_M[i] = translate( g_L_M[i], g_L_p[i] );
-    /* cycle different colours for each of the lights */
-    g_L_d[i] = vec3( (float)( ( redi + 1 ) / 3 ), (float)( ( greeni + 1 ) / 3 ), (float)( ( bluei + 1 ) / 3 ) );
-    g_L_s[i] = vec3( 1.0, 1.0, 1.0 );
-    redi     = ( redi + 1 ) % 3;
-    bluei    = ( bluei + 1 ) % 3;
-    greeni   = ( greeni + 1 ) % 3;
-  }
+  /* light positions and colours */
+  create_lights( g_num_lights );
 
   /* set up virtual camera */
   float aspect = (float)g_gl_width / (float)g_gl_height;
@@ -302,20 +592,66 @@ int main() {
   vec3 cam_pos( 0.0f, 30.0f, 30.0f );
   g_V = look_at( cam_pos, targ_pos, up );
 
-  glViewport( 0, 0, g_gl_width, g_gl_height );
-  glEnable( GL_CULL_FACE ); // cull face
-  glCullFace( GL_BACK );    // cull back face
-  glFrontFace( GL_CCW );    // GL_CCW for counter clock-wise
+  /* the cluster grid is fixed to this viewport and projection */
+  ( init_light_clusters( &g_clusters, g_gl_width, g_gl_height, g_P.m[0], g_P.m[5], CLUSTER_NEAR, CLUSTER_FAR, MAX_LIGHTS ) );
+  /* initialise framebuffers and G-buffers */
+  for ( int i = 0; i < 2; i++ ) {
+    ( init_fb( &g_gbuffers[i], 1 == i ) );
+    if ( !load_g_buffer_shaders( &g_gbuffers[i] ) ) {
+      glfwTerminate();
+      return 1;
+    }
+  }
+  if ( LIGHTING_CLUSTERED_COMPUTE == g_lighting_mode && !g_clusters.compute_sp ) { g_lighting_mode = LIGHTING_CLUSTERED_CPU; }
+  printf( "M changes the lighting mode. G swaps G-buffer layouts. 1-6 set 16, 64, 256, 1024, 4096, or 10000 lights. B benchmarks\n" );
+  print_settings();
+
+  /* everything from here on goes through the state tracker */
+  gl_state_invalidate();
+  gl_state_viewport( 0, 0, g_gl_width, g_gl_height );
+  gl_state_enable( GL_CULL_FACE ); // cull face
+  gl_state_cull_face( GL_BACK );   // cull back face
+  gl_state_front_face( GL_CCW );   // GL_CCW for counter clock-wise
+  const int light_counts[]    = { 16, 64, 256, 1024, 4096, 10000 };
+  static bool m_was_down      = false;
+  static bool layout_was_down = false;
+  static bool b_was_down      = false;
   while ( !glfwWindowShouldClose( g_window ) ) {
     _update_fps_counter( g_window );
-    draw_first_pass();
-    draw_second_pass();
+    update_lights( glfwGetTime() );
+    draw_frame();
+    report_uniform_calls_saved();
+    gl_state_end_frame();
 
     glfwSwapBuffers( g_window );
     glfwPollEvents();
     if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( g_window, 1 ); }
+    for ( int i = 0; i < 6; i++ ) {
+      if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_1 + i ) && g_num_lights != light_counts[i] ) {
+        create_lights( light_counts[i] );
+        print_settings();
+      }
+    }
+    bool m_is_down = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_M );
+    if ( m_is_down && !m_was_down ) {
+      g_lighting_mode = (lighting_mode_t)( ( g_lighting_mode + 1 ) % LIGHTING_MODE_COUNT );
+      if ( LIGHTING_CLUSTERED_COMPUTE == g_lighting_mode && !g_clusters.compute_sp ) { g_lighting_mode = LIGHTING_VOLUMES; }
+      print_settings();
+    }
+    m_was_down          = m_is_down;
+    bool layout_is_down = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_G );
+    if ( layout_is_down && !layout_was_down ) {
+      g_gbuffer = g_gbuffer == &g_gbuffers[0] ? &g_gbuffers[1] : &g_gbuffers[0];
+      print_settings();
+    }
+    layout_was_down = layout_is_down;
+    bool b_is_down  = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) { benchmark_lighting(); }
+    b_was_down = b_is_down;
   }
 
+  free_light_clusters( &g_clusters );
+
   /* close GL context and any other GLFW resources */
   glfwTerminate();
   return 0;
@@ -0,0 +1,63 @@
+#version 410
+
+uniform mat4 V;
+uniform mat4 inv_P;
+uniform sampler2D depth_tex;
+uniform sampler2D n_tex;
+uniform sampler2D albedo_tex;
+uniform vec3 ls;
+uniform vec3 ld;
+uniform vec3 lp;
+
+out vec4 frag_colour;
+
+float specular_exponent = 200.0;
+
+vec3 oct_decode (vec2 e) {
+	vec3 n = vec3 (e, 1.0 - abs (e.x) - abs (e.y));
+	if (n.z < 0.0) {
+		vec2 sign_xy = vec2 (n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs (n.yx)) * sign_xy;
+	}
+	return normalize (n);
+}
+
+/* undo the projection of the pixel centre at its depth */
+vec3 position_from_depth (ivec2 pixel, float depth) {
+	vec2 ndc_xy = (vec2 (pixel) + 0.5) / vec2 (textureSize (depth_tex, 0)) * 2.0 - 1.0;
+	vec4 p = inv_P * vec4 (ndc_xy, depth * 2.0 - 1.0, 1.0);
+	return p.xyz / p.w;
+}
+
+vec3 phong (in vec3 op_eye, in vec3 n_eye, in vec3 kd, in vec3 ks) {
+	vec3 lp_eye = (V * vec4 (lp, 1.0)).xyz;
+	vec3 dist_to_light_eye = lp_eye - op_eye;
+	vec3 direction_to_light_eye = normalize (dist_to_light_eye);
+
+	// standard diffuse light
+	float dot_prod = max (dot (direction_to_light_eye,  n_eye), 0.0);
+	vec3 Id = ld * kd * dot_prod; // final diffuse intensity
+
+	// standard specular light
+	vec3 reflection_eye = reflect (-direction_to_light_eye, n_eye);
+	vec3 surface_to_viewer_eye = normalize (-op_eye);
+	float dot_prod_specular = max (dot (reflection_eye, surface_to_viewer_eye), 0.0);
+	float specular_factor = pow (dot_prod_specular, specular_exponent);
+	vec3 Is = ls * ks * specular_factor; // final specular intensity
+
+	float atten_factor = max (0.0, 1.0 - distance (lp_eye, op_eye) / 10.0);
+	return (Id + Is) * atten_factor;
+}
+
+void main () {
+	ivec2 pixel = ivec2 (gl_FragCoord.xy);
+	float depth = texelFetch (depth_tex, pixel, 0).r;
+	// skip background
+	if (depth >= 1.0) {
+		discard;
+	}
+	vec3 p_eye = position_from_depth (pixel, depth);
+	vec3 n_eye = oct_decode (texelFetch (n_tex, pixel, 0).rg);
+	vec4 albedo_spec = texelFetch (albedo_tex, pixel, 0);
+	frag_colour = vec4 (phong (p_eye, n_eye, albedo_spec.rgb, vec3 (albedo_spec.a)), 1.0);
+}
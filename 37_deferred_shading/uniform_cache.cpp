@@ -0,0 +1,227 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Uniform location cache and typed uniform setters.                            |
+\******************************************************************************/
+#include "uniform_cache.h"
+#include "gl_utils.h"
+#include <assert.h>
+#include <string.h>
+
+unsigned int uniform_name_hash( const char* name ) {
+  unsigned int hash = 2166136261u;
+  for ( const char* c = name; *c; c++ ) {
+    hash ^= (unsigned char)*c;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/* number of 32-bit words in one element of a uniform of this type */
+static int uniform_type_words( GLenum type ) {
+  switch ( type ) {
+  case GL_FLOAT:
+  case GL_INT:
+  case GL_UNSIGNED_INT:
+  case GL_BOOL: return 1;
+  case GL_FLOAT_VEC2:
+  case GL_INT_VEC2:
+  case GL_UNSIGNED_INT_VEC2:
+  case GL_BOOL_VEC2: return 2;
+  case GL_FLOAT_VEC3:
+  case GL_INT_VEC3:
+  case GL_UNSIGNED_INT_VEC3:
+  case GL_BOOL_VEC3: return 3;
+  case GL_FLOAT_VEC4:
+  case GL_INT_VEC4:
+  case GL_UNSIGNED_INT_VEC4:
+  case GL_BOOL_VEC4:
+  case GL_FLOAT_MAT2: return 4;
+  case GL_FLOAT_MAT2x3:
+  case GL_FLOAT_MAT3x2: return 6;
+  case GL_FLOAT_MAT2x4:
+  case GL_FLOAT_MAT4x2: return 8;
+  case GL_FLOAT_MAT3: return 9;
+  case GL_FLOAT_MAT3x4:
+  case GL_FLOAT_MAT4x3: return 12;
+  case GL_FLOAT_MAT4: return 16;
+  default: return 1; /* samplers and images are set with an int unit number */
+  }
+}
+
+/* lookups only compare hashes, so two names with the same hash would share one
+uniform's location and shadow copy. returns false for that, in any build */
+static bool insert_uniform( programme_uniforms_t* pu, int index ) {
+  const uniform_info_t* u = &pu->uniforms[index];
+  unsigned int slot       = u->name_hash & ( UNIFORM_CACHE_TABLE_SIZE - 1 );
+  while ( pu->table[slot] ) {
+    const uniform_info_t* other = &pu->uniforms[pu->table[slot] - 1];
+    if ( other->name_hash == u->name_hash ) {
+      gl_log_err( "ERROR: programme %u uniforms %s and %s have the same name hash 0x%08x. rename one\n", pu->programme, other->name, u->name, u->name_hash );
+      return false;
+    }
+    slot = ( slot + 1 ) & ( UNIFORM_CACHE_TABLE_SIZE - 1 );
+  }
+  pu->table[slot] = index + 1;
+  return true;
+}
+
+bool reflect_programme_uniforms( GLuint programme, programme_uniforms_t* pu ) {
+  memset( pu, 0, sizeof( programme_uniforms_t ) );
+  pu->programme = programme;
+
+  GLint n_active = 0;
+  glGetProgramiv( programme, GL_ACTIVE_UNIFORMS, &n_active );
+  for ( GLuint i = 0; i < (GLuint)n_active; i++ ) {
+    /* uniforms inside a block don't have a location - they are set through a
+    buffer, so they go in the blocks list instead */
+    GLint block_index = -1;
+    glGetActiveUniformsiv( programme, 1, &i, GL_UNIFORM_BLOCK_INDEX, &block_index );
+    if ( block_index != -1 ) { continue; }
+    if ( pu->n_uniforms >= UNIFORM_CACHE_MAX_UNIFORMS ) {
+      gl_log_err( "ERROR: programme %u has more than %i uniforms\n", programme, UNIFORM_CACHE_MAX_UNIFORMS );
+      return false;
+    }
+
+    uniform_info_t* u = &pu->uniforms[pu->n_uniforms];
+    GLsizei length    = 0;
+    glGetActiveUniform( programme, i, UNIFORM_CACHE_MAX_NAME, &length, &u->array_size, &u->type, u->name );
+    /* GL names a plain array "name[0]". an array of structs has a uniform
+    per element, e.g. "lights[0].pos" and "lights[1].pos", so keep those whole */
+    if ( length >= 3 && 0 == strcmp( u->name + length - 3, "[0]" ) ) { u->name[length - 3] = '\0'; }
+    u->name_hash    = uniform_name_hash( u->name );
+    u->location     = glGetUniformLocation( programme, u->name );
+    u->shadow_words = uniform_type_words( u->type ) * u->array_size;
+    if ( pu->n_shadow_words + u->shadow_words > UNIFORM_CACHE_MAX_SHADOW_WORDS ) {
+      gl_log_err( "ERROR: programme %u uniforms too big for shadow copy\n", programme );
+      return false;
+    }
+    u->shadow_offset = pu->n_shadow_words;
+    pu->n_shadow_words += u->shadow_words;
+    if ( !insert_uniform( pu, pu->n_uniforms ) ) { return false; }
+    pu->n_uniforms++;
+  }
+
+  GLint n_blocks = 0;
+  glGetProgramiv( programme, GL_ACTIVE_UNIFORM_BLOCKS, &n_blocks );
+  for ( GLuint i = 0; i < (GLuint)n_blocks; i++ ) {
+    if ( pu->n_blocks >= UNIFORM_CACHE_MAX_BLOCKS ) {
+      gl_log_err( "ERROR: programme %u has more than %i uniform blocks\n", programme, UNIFORM_CACHE_MAX_BLOCKS );
+      return false;
+    }
+    uniform_block_info_t* b = &pu->blocks[pu->n_blocks++];
+    glGetActiveUniformBlockName( programme, i, UNIFORM_CACHE_MAX_NAME, NULL, b->name );
+    glGetActiveUniformBlockiv( programme, i, GL_UNIFORM_BLOCK_DATA_SIZE, &b->data_size );
+    glGetActiveUniformBlockiv( programme, i, GL_UNIFORM_BLOCK_BINDING, &b->binding );
+    b->name_hash = uniform_name_hash( b->name );
+    b->index     = i;
+    for ( int j = 0; j < pu->n_blocks - 1; j++ ) {
+      if ( pu->blocks[j].name_hash == b->name_hash ) {
+        gl_log_err( "ERROR: programme %u uniform blocks %s and %s have the same name hash 0x%08x. rename one\n", programme, pu->blocks[j].name, b->name, b->name_hash );
+        return false;
+      }
+    }
+  }
+
+  gl_log( "programme %u has %i active uniforms and %i uniform blocks:\n", programme, pu->n_uniforms, pu->n_blocks );
+  for ( int i = 0; i < pu->n_uniforms; i++ ) {
+    gl_log( "  %i) %s loc:%i type:0x%04x size:%i\n", i, pu->uniforms[i].name, pu->uniforms[i].location, pu->uniforms[i].type, pu->uniforms[i].array_size );
+  }
+  for ( int i = 0; i < pu->n_blocks; i++ ) { gl_log( "  block %i) %s %i bytes binding:%i\n", i, pu->blocks[i].name, pu->blocks[i].data_size, pu->blocks[i].binding ); }
+  return true;
+}
+
+uniform_info_t* find_uniform( programme_uniforms_t* pu, unsigned int name_hash ) {
+  unsigned int slot = name_hash & ( UNIFORM_CACHE_TABLE_SIZE - 1 );
+  while ( pu->table[slot] ) {
+    uniform_info_t* u = &pu->uniforms[pu->table[slot] - 1];
+    if ( u->name_hash == name_hash ) { return u; }
+    slot = ( slot + 1 ) & ( UNIFORM_CACHE_TABLE_SIZE - 1 );
+  }
+  return NULL;
+}
+
+GLint get_cached_uniform_location( programme_uniforms_t* pu, unsigned int name_hash ) {
+  uniform_info_t* u = find_uniform( pu, name_hash );
+  return u ? u->location : -1;
+}
+
+/* compares a new value against the shadow copy. returns the uniform if it
+changed and needs sending to GL, after updating the copy */
+static uniform_info_t* shadow_compare( programme_uniforms_t* pu, unsigned int name_hash, const void* value, int words ) {
+  pu->n_set_calls++;
+  uniform_info_t* u = find_uniform( pu, name_hash );
+  if ( !u ) { return NULL; } // not active (maybe optimised out) so nothing to do
+  assert( words <= u->shadow_words );
+  GLuint* shadow = &pu->shadow[u->shadow_offset];
+  if ( u->shadow_valid && 0 == memcmp( shadow, value, words * sizeof( GLuint ) ) ) { return NULL; }
+  memcpy( shadow, value, words * sizeof( GLuint ) );
+  u->shadow_valid = true;
+  pu->n_uploads++;
+  return u;
+}
+
+bool set_uniform_1i( programme_uniforms_t* pu, unsigned int name_hash, GLint i ) {
+  uniform_info_t* u = shadow_compare( pu, name_hash, &i, 1 );
+  if ( !u ) { return false; }
+  glUniform1i( u->location, i );
+  return true;
+}
+
+bool set_uniform_1f( programme_uniforms_t* pu, unsigned int name_hash, GLfloat f ) {
+  uniform_info_t* u = shadow_compare( pu, name_hash, &f, 1 );
+  if ( !u ) { return false; }
+  glUniform1f( u->location, f );
+  return true;
+}
+
+bool set_uniform_3f( programme_uniforms_t* pu, unsigned int name_hash, GLfloat x, GLfloat y, GLfloat z ) {
+  GLfloat v[3]      = { x, y, z };
+  uniform_info_t* u = shadow_compare( pu, name_hash, v, 3 );
+  if ( !u ) { return false; }
+  glUniform3fv( u->location, 1, v );
+  return true;
+}
+
+bool set_uniform_4f( programme_uniforms_t* pu, unsigned int name_hash, GLfloat x, GLfloat y, GLfloat z, GLfloat w ) {
+  GLfloat v[4]      = { x, y, z, w };
+  uniform_info_t* u = shadow_compare( pu, name_hash, v, 4 );
+  if ( !u ) { return false; }
+  glUniform4fv( u->location, 1, v );
+  return true;
+}
+
+bool set_uniform_mat4( programme_uniforms_t* pu, unsigned int name_hash, const GLfloat* m ) {
+  uniform_info_t* u = shadow_compare( pu, name_hash, m, 16 );
+  if ( !u ) { return false; }
+  glUniformMatrix4fv( u->location, 1, GL_FALSE, m );
+  return true;
+}
+
+bool set_uniform_block_binding( programme_uniforms_t* pu, unsigned int name_hash, GLuint binding ) {
+  pu->n_set_calls++;
+  for ( int i = 0; i < pu->n_blocks; i++ ) {
+    uniform_block_info_t* b = &pu->blocks[i];
+    if ( b->name_hash != name_hash ) { continue; }
+    if ( b->binding == (GLint)binding ) { return false; }
+    glUniformBlockBinding( pu->programme, b->index, binding );
+    b->binding = (GLint)binding;
+    pu->n_uploads++;
+    return true;
+  }
+  return false;
+}
+
+void reset_uniform_counters( programme_uniforms_t* pu ) {
+  pu->n_set_calls = 0;
+  pu->n_uploads   = 0;
+}
+
+void invalidate_uniform_shadows( programme_uniforms_t* pu ) {
+  for ( int i = 0; i < pu->n_uniforms; i++ ) { pu->uniforms[i].shadow_valid = false; }
+}
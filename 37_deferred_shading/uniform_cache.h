@@ -0,0 +1,90 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Uniform location cache and typed uniform setters.                            |
+| Once a programme is linked, reflect_programme_uniforms() asks GL for all of  |
+| its active uniforms and uniform blocks, so we never call                     |
+| glGetUniformLocation() again. Uniforms are looked up by a hash of the name,  |
+| which you can work out once with uniform_name_hash() and keep around. Two    |
+| active names with the same hash make reflect_programme_uniforms() fail.      |
+| Every setter keeps a CPU-side copy of the last value it sent, and skips the  |
+| glUniform*() call if the new value is the same. Counters record how many     |
+| calls were made and how many actually reached GL.                            |
+| Like glUniform*() the setters expect the programme to be in use.             |
+\******************************************************************************/
+#ifndef _UNIFORM_CACHE_H_
+#define _UNIFORM_CACHE_H_
+
+#include <GL/glew.h>
+
+#define UNIFORM_CACHE_MAX_UNIFORMS 64
+#define UNIFORM_CACHE_MAX_BLOCKS 16
+#define UNIFORM_CACHE_MAX_NAME 64
+/* hash table slots. must be a power of two bigger than the max uniforms */
+#define UNIFORM_CACHE_TABLE_SIZE 128
+/* 32-bit words of CPU-side copies of uniform values, for all uniforms */
+#define UNIFORM_CACHE_MAX_SHADOW_WORDS 2048
+
+struct uniform_info_t {
+  char name[UNIFORM_CACHE_MAX_NAME]; /* array uniforms have the [0] removed */
+  unsigned int name_hash;
+  GLint location;
+  GLenum type;
+  GLint array_size;
+  int shadow_offset; /* first word of this uniform's value in the shadow copy */
+  int shadow_words;
+  bool shadow_valid; /* false until a value has been sent */
+};
+
+struct uniform_block_info_t {
+  char name[UNIFORM_CACHE_MAX_NAME];
+  unsigned int name_hash;
+  GLuint index;
+  GLint data_size;
+  GLint binding;
+};
+
+struct programme_uniforms_t {
+  GLuint programme;
+  uniform_info_t uniforms[UNIFORM_CACHE_MAX_UNIFORMS];
+  int n_uniforms;
+  uniform_block_info_t blocks[UNIFORM_CACHE_MAX_BLOCKS];
+  int n_blocks;
+  /* open-addressed table of name hash -> index into uniforms[]+1. 0 is empty */
+  int table[UNIFORM_CACHE_TABLE_SIZE];
+  GLuint shadow[UNIFORM_CACHE_MAX_SHADOW_WORDS];
+  int n_shadow_words;
+  /* calls to the setters, and the ones that reached glUniform*() */
+  int n_set_calls;
+  int n_uploads;
+};
+
+/* FNV-1a hash of a uniform or block name */
+unsigned int uniform_name_hash( const char* name );
+/* query every active uniform and uniform block of a linked programme */
+bool reflect_programme_uniforms( GLuint programme, programme_uniforms_t* pu );
+/* returns NULL if the programme has no active uniform with this name hash */
+uniform_info_t* find_uniform( programme_uniforms_t* pu, unsigned int name_hash );
+/* -1 if not an active uniform, same as glGetUniformLocation() */
+GLint get_cached_uniform_location( programme_uniforms_t* pu, unsigned int name_hash );
+
+/* typed setters. return true if the value changed and was sent to GL */
+bool set_uniform_1i( programme_uniforms_t* pu, unsigned int name_hash, GLint i );
+bool set_uniform_1f( programme_uniforms_t* pu, unsigned int name_hash, GLfloat f );
+bool set_uniform_3f( programme_uniforms_t* pu, unsigned int name_hash, GLfloat x, GLfloat y, GLfloat z );
+bool set_uniform_4f( programme_uniforms_t* pu, unsigned int name_hash, GLfloat x, GLfloat y, GLfloat z, GLfloat w );
+bool set_uniform_mat4( programme_uniforms_t* pu, unsigned int name_hash, const GLfloat* m );
+/* only calls glUniformBlockBinding() if the binding point changed */
+bool set_uniform_block_binding( programme_uniforms_t* pu, unsigned int name_hash, GLuint binding );
+
+/* zero the call and upload counters, e.g. at the start of a frame */
+void reset_uniform_counters( programme_uniforms_t* pu );
+/* forget the shadow copies, e.g. if glUniform*() was called directly */
+void invalidate_uniform_shadows( programme_uniforms_t* pu );
+
+#endif
@@ -0,0 +1,147 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Cascaded shadow maps.                                                        |
+\******************************************************************************/
+#include "cascades.h"
+#include "gl_utils.h"
+#include <math.h>
+
+bool init_shadow_cascades( shadow_cascades_t* csm, int size ) {
+  /* value-initialising zeroes the plain members. mat4 isn't memset()-able */
+  *csm            = shadow_cascades_t();
+  csm->size       = size;
+  csm->n_cascades = 1;
+
+  glGenTextures( 1, &csm->depth_tex );
+  glBindTexture( GL_TEXTURE_2D_ARRAY, csm->depth_tex );
+  glTexImage3D( GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, CSM_MAX_CASCADES, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+  glGenFramebuffers( 1, &csm->fb );
+  glBindFramebuffer( GL_FRAMEBUFFER, csm->fb );
+  glFramebufferTextureLayer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, csm->depth_tex, 0, 0 );
+  // tell framebuffer not to use any colour drawing outputs
+  GLenum draw_bufs[] = { GL_NONE };
+  glDrawBuffers( 1, draw_bufs );
+  // avoids GL_FRAMEBUFFER_INCOMPLETE_READ_BUFFER on mac with only a depth buffer
+  glReadBuffer( GL_NONE );
+  GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  if ( GL_FRAMEBUFFER_COMPLETE != status ) {
+    gl_log_err( "ERROR: incomplete shadow cascade framebuffer. status 0x%x\n", status );
+    return false;
+  }
+  return true;
+}
+
+void free_shadow_cascades( shadow_cascades_t* csm ) {
+  glDeleteFramebuffers( 1, &csm->fb );
+  glDeleteTextures( 1, &csm->depth_tex );
+  *csm = shadow_cascades_t();
+}
+
+void set_cascade_splits( shadow_cascades_t* csm, int n_cascades, float near, float far, float lambda ) {
+  if ( n_cascades < 1 ) { n_cascades = 1; }
+  if ( n_cascades > CSM_MAX_CASCADES ) { n_cascades = CSM_MAX_CASCADES; }
+  if ( lambda < 0.0f ) { lambda = 0.0f; }
+  if ( lambda > 1.0f ) { lambda = 1.0f; }
+  csm->n_cascades = n_cascades;
+  csm->lambda     = lambda;
+  for ( int i = 0; i <= n_cascades; i++ ) {
+    float t         = (float)i / (float)n_cascades;
+    float log_split = near * powf( far / near, t );
+    float uni_split = near + ( far - near ) * t;
+    csm->splits[i]  = lambda * log_split + ( 1.0f - lambda ) * uni_split;
+  }
+}
+
+/* orthographic projection matching the GL convention, looking down -z */
+static mat4 ortho( float left, float right, float bottom, float top, float near, float far ) {
+  mat4 P  = identity_mat4();
+  P.m[0]  = 2.0f / ( right - left );
+  P.m[5]  = 2.0f / ( top - bottom );
+  P.m[10] = -2.0f / ( far - near );
+  P.m[12] = -( right + left ) / ( right - left );
+  P.m[13] = -( top + bottom ) / ( top - bottom );
+  P.m[14] = -( far + near ) / ( far - near );
+  return P;
+}
+
+static bool overlaps_xy( const float* box, const vec4& c, float r ) {
+  return c.v[0] + r >= box[0] && c.v[0] - r <= box[3] && c.v[1] + r >= box[1] && c.v[1] - r <= box[4];
+}
+
+void fit_shadow_cascades( shadow_cascades_t* csm, mat4 cam_V, float fov_deg, float aspect, vec3 light_dir, const caster_sphere_t* casters, int n_casters ) {
+  /* the light's axes only depend on its direction, never on the camera, so
+  a texel grid in light space stays put in the world */
+  vec3 up( 0.0f, 1.0f, 0.0f );
+  if ( fabsf( normalise( light_dir ).v[1] ) > 0.99f ) { up = vec3( 1.0f, 0.0f, 0.0f ); }
+  csm->V = look_at( vec3( 0.0f, 0.0f, 0.0f ), light_dir, up );
+
+  mat4 cam_W = inverse( cam_V );
+  vec3 cam_pos( cam_W.m[12], cam_W.m[13], cam_W.m[14] );
+  vec3 cam_fwd( -cam_W.m[8], -cam_W.m[9], -cam_W.m[10] );
+  /* distance from the view axis to a frustum corner, per unit of depth */
+  float tan_half = tanf( fov_deg * 0.5f * ONE_DEG_IN_RAD );
+  float k2       = tan_half * tan_half * ( 1.0f + aspect * aspect );
+
+  for ( int c = 0; c < csm->n_cascades; c++ ) {
+    float n = csm->splits[c];
+    float f = csm->splits[c + 1];
+    /* the smallest sphere around the slice is centred on the view axis, where
+    it is as far from the near corners as from the far corners. for a wide
+    slice that point is past the far plane, and the far corners alone decide */
+    float centre_depth = 0.5f * ( f + n ) * ( 1.0f + k2 );
+    if ( centre_depth > f ) { centre_depth = f; }
+    float radius = sqrtf( ( f - centre_depth ) * ( f - centre_depth ) + f * f * k2 );
+
+    /* one texel of margin either side, so that snapping the centre can't push
+    the sphere out of the map */
+    float texel = 2.0f * radius / (float)( csm->size - 2 );
+    float half  = 0.5f * texel * (float)csm->size;
+    vec4 centre = csm->V * vec4( cam_pos + cam_fwd * centre_depth, 1.0f );
+    centre.v[0] = floorf( centre.v[0] / texel ) * texel;
+    centre.v[1] = floorf( centre.v[1] / texel ) * texel;
+
+    float* box = csm->box[c];
+    box[0]     = centre.v[0] - half;
+    box[1]     = centre.v[1] - half;
+    box[2]     = centre.v[2] - radius;
+    box[3]     = centre.v[0] + half;
+    box[4]     = centre.v[1] + half;
+    box[5]     = centre.v[2] + radius;
+    /* the light looks down -z, so casters nearer the light have a bigger z */
+    for ( int i = 0; i < n_casters; i++ ) {
+      vec4 cl = csm->V * vec4( casters[i].centre, 1.0f );
+      if ( !overlaps_xy( box, cl, casters[i].radius ) ) { continue; }
+      if ( cl.v[2] + casters[i].radius > box[5] ) { box[5] = cl.v[2] + casters[i].radius; }
+    }
+    float near_dist = -box[5];
+    float far_dist  = -box[2];
+    csm->P[c]       = ortho( box[0], box[3], box[1], box[4], near_dist, far_dist );
+    csm->VP[c]      = csm->P[c] * csm->V;
+    /* depth is stored in 0 to 1 over the near-far range */
+    csm->bias[c] = 2.0f * texel / ( far_dist - near_dist );
+  }
+}
+
+bool caster_in_cascade( const shadow_cascades_t* csm, int cascade, const caster_sphere_t* caster ) {
+  const float* box = csm->box[cascade];
+  mat4 V           = csm->V;
+  vec4 cl          = V * vec4( caster->centre, 1.0f );
+  if ( !overlaps_xy( box, cl, caster->radius ) ) { return false; }
+  /* entirely behind everything this cascade shades */
+  if ( cl.v[2] + caster->radius < box[2] ) { return false; }
+  return true;
+}
+
+void attach_cascade_layer( const shadow_cascades_t* csm, int cascade ) { glFramebufferTextureLayer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, csm->depth_tex, 0, cascade ); }
@@ -0,0 +1,76 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Cascaded shadow maps for a directional light.                                |
+| One shadow map stretched over the whole view wastes most of its texels far   |
+| away and has too few close up. Instead the view frustum is cut into 2-4      |
+| depth ranges ("cascades") and each gets its own orthographic shadow map,     |
+| all in the layers of one depth texture array.                                |
+| Split distances blend logarithmic and uniform splits by lambda, the          |
+| "practical" scheme: lambda = 1 is fully logarithmic, 0 fully uniform.        |
+| Each cascade is fitted around the smallest sphere holding its slice of the   |
+| frustum. The sphere doesn't change size as the camera turns, so the map's    |
+| texels stay the same size in the world, and the fit is snapped to whole      |
+| texels so that shadow edges don't shimmer as the camera moves. The depth     |
+| range is pulled towards the light to take in casters outside the slice.      |
+\******************************************************************************/
+#ifndef _CASCADES_H_
+#define _CASCADES_H_
+
+#include "maths_funcs.h"
+#include <GL/glew.h>
+
+#define CSM_MAX_CASCADES 4
+
+/* bounding sphere of a shadow caster, in world space */
+struct caster_sphere_t {
+  vec3 centre;
+  float radius;
+};
+
+struct shadow_cascades_t {
+  int n_cascades;
+  int size; /* width and height of each layer, in texels */
+  float lambda;
+  /* view depths where each cascade starts and ends. cascade i covers
+  splits[i] to splits[i + 1] */
+  float splits[CSM_MAX_CASCADES + 1];
+  GLuint fb;
+  GLuint depth_tex; /* GL_TEXTURE_2D_ARRAY with a layer per cascade */
+  /* the light's view matrix is shared. only the projection differs */
+  mat4 V;
+  mat4 P[CSM_MAX_CASCADES];
+  mat4 VP[CSM_MAX_CASCADES];
+  /* light-space box of each cascade: min x,y,z then max x,y,z */
+  float box[CSM_MAX_CASCADES][6];
+  /* depth comparison offset, about 2 texels, in each cascade's depth units */
+  float bias[CSM_MAX_CASCADES];
+  /* casters drawn into each cascade by the last shadow pass */
+  int n_draws[CSM_MAX_CASCADES];
+};
+
+/* allocates all CSM_MAX_CASCADES layers so that the count can change later */
+bool init_shadow_cascades( shadow_cascades_t* csm, int size );
+void free_shadow_cascades( shadow_cascades_t* csm );
+
+/* n_cascades is clamped to 1-CSM_MAX_CASCADES. near and far are the view
+depths covered by shadows, usually the camera's clipping planes */
+void set_cascade_splits( shadow_cascades_t* csm, int n_cascades, float near, float far, float lambda );
+
+/* fits every cascade to the camera. fov_deg and aspect are the camera's,
+light_dir is the direction the light shines in. casters outside a cascade's
+slice but between it and the light pull its near plane back */
+void fit_shadow_cascades( shadow_cascades_t* csm, mat4 cam_V, float fov_deg, float aspect, vec3 light_dir, const caster_sphere_t* casters, int n_casters );
+
+/* true if the caster could shadow anything in the cascade */
+bool caster_in_cascade( const shadow_cascades_t* csm, int cascade, const caster_sphere_t* caster );
+
+/* attaches one cascade's layer for depth writes. csm->fb must be bound */
+void attach_cascade_layer( const shadow_cascades_t* csm, int cascade );
+
+#endif
@@ -0,0 +1,239 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| A thin render state tracker.                                                 |
+\******************************************************************************/
+#include "gl_state.h"
+#include "gl_utils.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/* a value that no real state will have, so the next call always goes through */
+#define UNKNOWN 0xFFFFFFFF
+
+enum tracked_cap_t { CAP_BLEND = 0, CAP_DEPTH_TEST, CAP_CULL_FACE, CAP_SCISSOR_TEST, CAP_STENCIL_TEST, CAP_POLYGON_OFFSET_FILL, CAP_COUNT };
+enum tracked_target_t { TARGET_2D = 0, TARGET_CUBE_MAP, TARGET_2D_ARRAY, TARGET_COUNT };
+
+struct gl_state_t {
+  GLuint caps[CAP_COUNT]; /* GL_TRUE, GL_FALSE, or UNKNOWN */
+  GLuint depth_mask;
+  GLenum depth_func;
+  GLenum blend_src, blend_dst;
+  GLenum blend_equation;
+  GLenum cull_face;
+  GLenum front_face;
+  GLfloat clear_colour[4];
+  bool clear_colour_known;
+  GLint viewport[4];
+  bool viewport_known;
+  GLuint programme;
+  GLuint vao;
+  GLuint fb;
+  GLuint active_unit;
+  GLuint textures[GL_STATE_MAX_TEXTURE_UNITS][TARGET_COUNT];
+};
+static gl_state_t g_state;
+
+#ifndef NDEBUG
+/* calls made to the tracker, and the ones that went through to GL, this frame */
+static int g_state_requests;
+static int g_state_changes;
+#define COUNT_REQUEST() g_state_requests++
+#define COUNT_CHANGE() g_state_changes++
+#else
+#define COUNT_REQUEST()
+#define COUNT_CHANGE()
+#endif
+
+void gl_state_invalidate() {
+  memset( &g_state, 0xFF, sizeof( gl_state_t ) );
+  g_state.clear_colour_known = false;
+  g_state.viewport_known     = false;
+}
+
+static int cap_index( GLenum cap ) {
+  switch ( cap ) {
+  case GL_BLEND: return CAP_BLEND;
+  case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+  case GL_CULL_FACE: return CAP_CULL_FACE;
+  case GL_SCISSOR_TEST: return CAP_SCISSOR_TEST;
+  case GL_STENCIL_TEST: return CAP_STENCIL_TEST;
+  case GL_POLYGON_OFFSET_FILL: return CAP_POLYGON_OFFSET_FILL;
+  default: return -1;
+  }
+}
+
+static int target_index( GLenum target ) {
+  switch ( target ) {
+  case GL_TEXTURE_2D: return TARGET_2D;
+  case GL_TEXTURE_CUBE_MAP: return TARGET_CUBE_MAP;
+  case GL_TEXTURE_2D_ARRAY: return TARGET_2D_ARRAY;
+  default: return -1;
+  }
+}
+
+void gl_state_enable( GLenum cap ) {
+  COUNT_REQUEST();
+  int i = cap_index( cap );
+  if ( i >= 0 && g_state.caps[i] == GL_TRUE ) { return; }
+  if ( i >= 0 ) { g_state.caps[i] = GL_TRUE; }
+  COUNT_CHANGE();
+  glEnable( cap );
+}
+
+void gl_state_disable( GLenum cap ) {
+  COUNT_REQUEST();
+  int i = cap_index( cap );
+  if ( i >= 0 && g_state.caps[i] == GL_FALSE ) { return; }
+  if ( i >= 0 ) { g_state.caps[i] = GL_FALSE; }
+  COUNT_CHANGE();
+  glDisable( cap );
+}
+
+void gl_state_depth_mask( GLboolean flag ) {
+  COUNT_REQUEST();
+  if ( g_state.depth_mask == flag ) { return; }
+  g_state.depth_mask = flag;
+  COUNT_CHANGE();
+  glDepthMask( flag );
+}
+
+void gl_state_depth_func( GLenum func ) {
+  COUNT_REQUEST();
+  if ( g_state.depth_func == func ) { return; }
+  g_state.depth_func = func;
+  COUNT_CHANGE();
+  glDepthFunc( func );
+}
+
+void gl_state_blend_func( GLenum sfactor, GLenum dfactor ) {
+  COUNT_REQUEST();
+  if ( g_state.blend_src == sfactor && g_state.blend_dst == dfactor ) { return; }
+  g_state.blend_src = sfactor;
+  g_state.blend_dst = dfactor;
+  COUNT_CHANGE();
+  glBlendFunc( sfactor, dfactor );
+}
+
+void gl_state_blend_equation( GLenum mode ) {
+  COUNT_REQUEST();
+  if ( g_state.blend_equation == mode ) { return; }
+  g_state.blend_equation = mode;
+  COUNT_CHANGE();
+  glBlendEquation( mode );
+}
+
+void gl_state_cull_face( GLenum mode ) {
+  COUNT_REQUEST();
+  if ( g_state.cull_face == mode ) { return; }
+  g_state.cull_face = mode;
+  COUNT_CHANGE();
+  glCullFace( mode );
+}
+
+void gl_state_front_face( GLenum mode ) {
+  COUNT_REQUEST();
+  if ( g_state.front_face == mode ) { return; }
+  g_state.front_face = mode;
+  COUNT_CHANGE();
+  glFrontFace( mode );
+}
+
+void gl_state_clear_colour( GLfloat r, GLfloat g, GLfloat b, GLfloat a ) {
+  COUNT_REQUEST();
+  GLfloat* c = g_state.clear_colour;
+  if ( g_state.clear_colour_known && c[0] == r && c[1] == g && c[2] == b && c[3] == a ) { return; }
+  c[0]                       = r;
+  c[1]                       = g;
+  c[2]                       = b;
+  c[3]                       = a;
+  g_state.clear_colour_known = true;
+  COUNT_CHANGE();
+  glClearColor( r, g, b, a );
+}
+
+void gl_state_viewport( GLint x, GLint y, GLsizei w, GLsizei h ) {
+  COUNT_REQUEST();
+  GLint* v = g_state.viewport;
+  if ( g_state.viewport_known && v[0] == x && v[1] == y && v[2] == w && v[3] == h ) { return; }
+  v[0]                   = x;
+  v[1]                   = y;
+  v[2]                   = w;
+  v[3]                   = h;
+  g_state.viewport_known = true;
+  COUNT_CHANGE();
+  glViewport( x, y, w, h );
+}
+
+void gl_state_use_program( GLuint programme ) {
+  COUNT_REQUEST();
+  if ( g_state.programme == programme ) { return; }
+  g_state.programme = programme;
+  COUNT_CHANGE();
+  glUseProgram( programme );
+}
+
+void gl_state_bind_vertex_array( GLuint vao ) {
+  COUNT_REQUEST();
+  if ( g_state.vao == vao ) { return; }
+  g_state.vao = vao;
+  COUNT_CHANGE();
+  glBindVertexArray( vao );
+}
+
+void gl_state_bind_framebuffer( GLuint fb ) {
+  COUNT_REQUEST();
+  if ( g_state.fb == fb ) { return; }
+  g_state.fb = fb;
+  COUNT_CHANGE();
+  glBindFramebuffer( GL_FRAMEBUFFER, fb );
+}
+
+void gl_state_bind_texture( GLuint unit, GLenum target, GLuint texture ) {
+  assert( unit < GL_STATE_MAX_TEXTURE_UNITS );
+  COUNT_REQUEST();
+  int t = target_index( target );
+  if ( t >= 0 && g_state.textures[unit][t] == texture ) { return; }
+  if ( t >= 0 ) { g_state.textures[unit][t] = texture; }
+  /* selecting the unit is a request of its own, so that every change is
+  counted against a request and "elided" can't go negative */
+  COUNT_REQUEST();
+  if ( g_state.active_unit != unit ) {
+    g_state.active_unit = unit;
+    COUNT_CHANGE();
+    glActiveTexture( GL_TEXTURE0 + unit );
+  }
+  COUNT_CHANGE();
+  glBindTexture( target, texture );
+}
+
+void gl_state_end_frame() {
+#ifndef NDEBUG
+  static double previous_seconds = glfwGetTime();
+  static int frame_count         = 0;
+  static int requests            = 0;
+  static int changes             = 0;
+  requests += g_state_requests;
+  changes += g_state_changes;
+  g_state_requests = 0;
+  g_state_changes  = 0;
+  frame_count++;
+  double current_seconds = glfwGetTime();
+  if ( current_seconds - previous_seconds > 1.0 ) {
+    float requests_pf = (float)requests / (float)frame_count;
+    float changes_pf  = (float)changes / (float)frame_count;
+    printf( "gl state per frame: %.1f requested, %.1f changed, %.1f elided\n", requests_pf, changes_pf, requests_pf - changes_pf );
+    gl_log( "gl state per frame: %.1f requested, %.1f changed, %.1f elided\n", requests_pf, changes_pf, requests_pf - changes_pf );
+    previous_seconds = current_seconds;
+    frame_count      = 0;
+    requests         = 0;
+    changes          = 0;
+  }
+#endif
+}
@@ -7,6 +7,7 @@
 | See individual libraries' for separate legal notices                         |
 |******************************************************************************|
 | Shadow Mapping from Williams' Algorithm                                      |
+| with cascaded shadow maps for a directional light. see cascades.h            |
 |                                                                              |
 | controls:                                                                    |
 | pitch = up,down arrow keys                                                   |
@@ -14,13 +15,23 @@
 | roll = z,c keys                                                              |
 | move forward/back = w,s keys                                                 |
 | move left/right = a,d keys                                                   |
+| next shadow filter (see shadow_filters.h) = p key                            |
+| wider/narrower shadow filter = =,- keys                                      |
+| 2, 3, or 4 shadow cascades = 2,3,4 keys                                      |
+| split scheme more uniform/more logarithmic = [,] keys                        |
+| show next cascade's depth map = k key                                        |
+| benchmark uber shader vs specialised variants, and cascades = b key          |
 |                                                                              |
 | I wrote a little Wavefront .obj loader to load a mesh from a file            |
 | It's in obj_parser.h and .cpp                                                |
 \******************************************************************************/
+#include "cascades.h"    // cascaded shadow maps
+#include "gl_state.h"    // render state tracker that skips redundant GL calls
 #include "gl_utils.h"    // common opengl functions and small utilities like logs
 #include "maths_funcs.h" // my maths functions
 #include "obj_parser.h"  // my little Wavefront .obj mesh loader
+#include "shader_variants.h"
+#include "shadow_filters.h"
 #include <GL/glew.h>     // include GLEW and new version of GL on Windows
 #include <GLFW/glfw3.h>  // GLFW helper library
 #include <assert.h>
@@ -35,50 +46,78 @@
 #define DEBUG_FS "ss_quad.frag"
 #define DEPTH_VS "depth.vert"
 #define DEPTH_FS "depth.frag"
-#define NUM_SPHERES 4
-
-/* resolution of the shadow map - this is the critical performance/quality
+/* the first 4 are placed by hand, the rest are scattered over the ground */
+#define NUM_SPHERES 64
+/* half the width of the ground plane */
+#define GROUND_EXTENT 100.0f
+/* number of frames to time each shader permutation for in the benchmark */
+#define BENCH_FRAMES 200
+
+/* resolution of each shadow cascade - this is the critical performance/quality
 variable  try changing this*/
 int g_shadow_size = 1024;
+int g_n_cascades  = 4;
+/* blend of logarithmic (1) and uniform (0) split distances */
+float g_cascade_lambda = 0.75f;
+/* cascade shown in the debug quad */
+int g_debug_cascade = 0;
 
 GLuint g_ground_plane_vao;
 int g_ground_plane_point_count;
 GLuint g_sphere_vao;
 int g_sphere_point_count;
+float g_sphere_radius; /* furthest vertex from the mesh's origin */
 GLuint g_ss_quad_vao;
 int g_ss_quad_point_count;
-/* shadow caster's view and projection matrices. in practice each light source
-will be a shadow caster have a set of these. we only have one caster here */
-mat4 g_caster_V;
-mat4 g_caster_P;
+/* direction of the sun. the cascades are fitted around the camera each frame,
+so the light's matrices live in g_cascades rather than here */
+vec3 g_light_dir;
 /* the virtual camera's view and projection matrices */
 mat4 g_camera_V;
 mat4 g_camera_P;
-/* shader used for ground and other objects */
+float g_camera_near, g_camera_far, g_camera_fov, g_camera_aspect;
+/* shader used for ground and other objects. it is built as permutations of
+the SHADOW_FILTER feature key, and g_plain_sp is the one currently in use */
+shader_variants_t g_plain_variants;
+int g_plain_filter_key;
+unsigned int g_plain_mask;
 GLuint g_plain_sp;
 GLint g_plain_M_loc;        /* model matrix location */
 GLint g_plain_V_loc;        /* virtual camera view matrix location */
 GLint g_plain_P_loc;        /* virtual camera projection matrix location */
-GLint g_plain_caster_V_loc; /* shadow caster view matrix location */
-GLint g_plain_caster_P_loc; /* shadow caster projection matrix location */
+GLint g_plain_cascade_VP_loc;   /* shadow cascades' view-projection matrices */
+GLint g_plain_cascade_far_loc;  /* view depth where each cascade ends */
+GLint g_plain_cascade_bias_loc; /* depth comparison offset for each cascade */
+GLint g_plain_n_cascades_loc;
 GLint g_plain_colour_loc;   /* a uniform to switch colour */
 GLint g_plain_shad_resolution_loc;
+GLint g_plain_filter_radius_loc;
+GLint g_plain_esm_c_loc;
+/* samplers, shared moments textures, and the prefilter pass for VSM/ESM */
+shadow_filters_t g_shadow_filters;
+int g_shadow_filter = SHADOW_FILTER_HARDWARE;
+/* half-width of the filter kernels in texels */
+int g_filter_radius = 2;
+/* sharpness of ESM's exponential step. bigger is harder, until exp() overflows */
+float g_esm_c = 80.0f;
 /* shader for debugging quad */
 GLuint g_debug_sp;
+GLint g_debug_layer_loc;
 /* shader to render just the depth to a texture */
 GLuint g_depth_sp;
 GLint g_depth_M_loc;
 GLint g_depth_V_loc;
 GLint g_depth_P_loc;
-/* framebuffer that renders depth to a texture */
-GLuint g_depth_fb;
-GLuint g_depth_fb_tex;
-/* unique model matrix for each sphere */
+/* framebuffer and texture array that the cascades render depth to */
+shadow_cascades_t g_cascades;
+/* unique model matrix and bounding sphere for each sphere */
 mat4 g_sphere_Ms[NUM_SPHERES];
+caster_sphere_t g_sphere_bounds[NUM_SPHERES];
 
 void init_ground_plane() {
   GLuint points_vbo;
-  GLfloat gp_pos[]           = { -20.0, -1.0, -20.0, -20.0, -1.0, 20.0, 20.0, -1.0, 20.0, 20.0, -1.0, 20.0, 20.0, -1.0, -20.0, -20.0, -1.0, -20.0 };
+  const GLfloat e            = GROUND_EXTENT;
+  GLfloat gp_pos[]           = { -e, -1.0, -e, -e, -1.0, e, e, -1.0, e, e, -1.0, e, e, -1.0, -e, -e, -1.0, -e };
   g_ground_plane_point_count = sizeof( gp_pos ) / sizeof( GLfloat ) / 3;
 
   /* create VBO and VAO here */
@@ -91,19 +130,12 @@ void init_ground_plane() {
   glEnableVertexAttribArray( 0 );
 }
 
+/* a far-away directional light, shining from (7,7,0) towards the origin.
+set_cascade_splits() decides how the camera's view distance is
+shared between the cascades */
 void create_shadow_caster() {
-  // create a view matrix for the shadow caster
-  vec3 light_pos( 7.0f, 7.0f, 0.0f );
-  vec3 light_target( 0.0f, 0.0f, 0.0f );
-  vec3 up_dir( normalise( vec3( -1.0f, 1.0f, 0.0f ) ) );
-  g_caster_V = look_at( light_pos, light_target, up_dir );
-
-  // create a projection matrix for the shadow caster
-  float near   = 1.0f;
-  float far    = 20.0f;
-  float fov    = 35.0f;
-  float aspect = 1.0f;
-  g_caster_P   = perspective( fov, aspect, near, far );
+  g_light_dir = normalise( vec3( -7.0f, -7.0f, 0.0f ) );
+  set_cascade_splits( &g_cascades, g_n_cascades, g_camera_near, g_camera_far, g_cascade_lambda );
 }
 
 /* some floating objects to cast shadows */
@@ -123,6 +155,11 @@ void init_spheres() {
     glBufferData( GL_ARRAY_BUFFER, 3 * g_sphere_point_count * sizeof( GLfloat ), vp, GL_STATIC_DRAW );
     glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, 0, NULL );
     glEnableVertexAttribArray( 0 );
+    /* bounding radius for culling against the shadow cascades */
+    for ( int i = 0; i < g_sphere_point_count; i++ ) {
+      float r = length( vec3( vp[i * 3], vp[i * 3 + 1], vp[i * 3 + 2] ) );
+      if ( r > g_sphere_radius ) { g_sphere_radius = r; }
+    }
   }
 }
 
@@ -147,73 +184,275 @@ void init_ss_quad() {
 }
 
 /* setup framebuffer that renders depth to a texture */
-void init_shadow_fb() {
-  // create framebuffer
-  glGenFramebuffers( 1, &g_depth_fb );
-  glBindFramebuffer( GL_FRAMEBUFFER, g_depth_fb );
-
-  // create texture for framebuffer
-  glGenTextures( 1, &g_depth_fb_tex );
-  glActiveTexture( GL_TEXTURE0 );
-  glBindTexture( GL_TEXTURE_2D, g_depth_fb_tex );
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, g_shadow_size, g_shadow_size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, NULL );
-  // bi-linear filtering might help, but might make it less accurate too
-  // glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  // glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-
-  // clamp to edge. clamp to border may reduce artifacts outside light frustum
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-  // attach depth texture to framebuffer
-  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, g_depth_fb_tex, 0 );
-
-  // tell framebuffer not to use any colour drawing outputs
-  GLenum draw_bufs[] = { GL_NONE };
-  glDrawBuffers( 1, draw_bufs );
-
-  // this *should* avoid a GL_FRAMEBUFFER_INCOMPLETE_READ_BUFFER error that
-  // comes on mac - invalid framebuffer due to having only a depth buffer and
-  // no colour buffer specified.
-  glReadBuffer( GL_NONE );
-
-  // bind default framebuffer again
-  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+bool init_shadow_fb() {
+  /* one layer per cascade, in a texture array */
+  return init_shadow_cascades( &g_cascades, g_shadow_size );
 }
 
-/* do a rendering pass writing just the depth to a texture */
-void render_shadow_casting() {
-  /* similar to epsilon offset */
-  /*
-    glEnable (GL_POLYGON_OFFSET_FILL);
-    glPolygonOffset (-1,-1); */
+/* do a rendering pass writing just the depth to a texture, once per cascade.
+each cascade only draws the casters that can shadow something inside it. if
+queries is not NULL each cascade is timed with one query from it */
+void render_shadow_casting( const GLuint* queries ) {
+  /* push depths away from the light a little. the slope-scaled part helps on
+  surfaces nearly edge-on to the light, where the fixed bias in plain.frag isn't
+  enough */
+  gl_state_enable( GL_POLYGON_OFFSET_FILL );
+  glPolygonOffset( 1.0f, 2.0f );
 
   // bind framebuffer that renders to texture instead of screen
-  glBindFramebuffer( GL_FRAMEBUFFER, g_depth_fb );
+  gl_state_bind_framebuffer( g_cascades.fb );
   // set the viewport to the size of the shadow map
-  glViewport( 0, 0, g_shadow_size, g_shadow_size );
-  // clear the shadow map to black (or white)
-  glClearColor( 0.0, 0.0, 0.0, 1.0 );
-  // no need to clear the colour buffer
-  glClear( GL_DEPTH_BUFFER_BIT );
+  gl_state_viewport( 0, 0, g_shadow_size, g_shadow_size );
   // bind out shadow-casting shader from the previous section
-  glUseProgram( g_depth_sp );
-  // send in the view and projection matrices from the light
-  glUniformMatrix4fv( g_depth_V_loc, 1, GL_FALSE, g_caster_V.m );
-  glUniformMatrix4fv( g_depth_P_loc, 1, GL_FALSE, g_caster_P.m );
-  // model matrix does nothing for the monkey - make it an identity matrix
+  gl_state_use_program( g_depth_sp );
+  glUniformMatrix4fv( g_depth_V_loc, 1, GL_FALSE, g_cascades.V.m );
+  gl_state_bind_vertex_array( g_sphere_vao );
+  for ( int c = 0; c < g_cascades.n_cascades; c++ ) {
+    if ( queries ) { glBeginQuery( GL_TIME_ELAPSED, queries[c] ); }
+    attach_cascade_layer( &g_cascades, c );
+    // no need to clear the colour buffer
+    glClear( GL_DEPTH_BUFFER_BIT );
+    // send in the projection matrix fitted to this cascade
+    glUniformMatrix4fv( g_depth_P_loc, 1, GL_FALSE, g_cascades.P[c].m );
+    g_cascades.n_draws[c] = 0;
+    for ( int i = 0; i < NUM_SPHERES; i++ ) {
+      if ( !caster_in_cascade( &g_cascades, c, &g_sphere_bounds[i] ) ) { continue; }
+      glUniformMatrix4fv( g_depth_M_loc, 1, GL_FALSE, g_sphere_Ms[i].m );
+      glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
+      g_cascades.n_draws[c]++;
+    }
+    if ( queries ) { glEndQuery( GL_TIME_ELAPSED ); }
+  }
+  // bind the default framebuffer again
+  gl_state_bind_framebuffer( 0 );
 
-  // bind the sphere vao and draw them
-  glBindVertexArray( g_sphere_vao );
+  gl_state_disable( GL_POLYGON_OFFSET_FILL );
+}
+
+/* switch the ground and objects to a different permutation of the plain
+shader. each programme has its own uniform locations so look them up again and
+re-send the values that don't change every frame */
+void use_plain_programme( GLuint sp ) {
+  g_plain_sp                  = sp;
+  g_plain_M_loc               = glGetUniformLocation( g_plain_sp, "M" );
+  g_plain_V_loc               = glGetUniformLocation( g_plain_sp, "V" );
+  g_plain_P_loc               = glGetUniformLocation( g_plain_sp, "P" );
+  g_plain_cascade_VP_loc      = glGetUniformLocation( g_plain_sp, "cascade_VP" );
+  g_plain_cascade_far_loc     = glGetUniformLocation( g_plain_sp, "cascade_far" );
+  g_plain_cascade_bias_loc    = glGetUniformLocation( g_plain_sp, "cascade_bias" );
+  g_plain_n_cascades_loc      = glGetUniformLocation( g_plain_sp, "n_cascades" );
+  g_plain_colour_loc          = glGetUniformLocation( g_plain_sp, "colour" );
+  g_plain_shad_resolution_loc = glGetUniformLocation( g_plain_sp, "shad_resolution" );
+  g_plain_filter_radius_loc   = glGetUniformLocation( g_plain_sp, "filter_radius" );
+  g_plain_esm_c_loc           = glGetUniformLocation( g_plain_sp, "esm_c" );
+  gl_state_use_program( g_plain_sp );
+  glUniformMatrix4fv( g_plain_V_loc, 1, GL_FALSE, g_camera_V.m );
+  glUniformMatrix4fv( g_plain_P_loc, 1, GL_FALSE, g_camera_P.m );
+  glUniform1f( g_plain_shad_resolution_loc, (GLfloat)g_shadow_size );
+  glUniform1f( g_plain_esm_c_loc, g_esm_c );
+  /* the depth array is read raw, read with comparisons, and as moments */
+  glUniform1i( glGetUniformLocation( g_plain_sp, "depth_map" ), SHADOW_UNIT_DEPTH );
+  glUniform1i( glGetUniformLocation( g_plain_sp, "depth_map_shadow" ), SHADOW_UNIT_COMPARE );
+  glUniform1i( glGetUniformLocation( g_plain_sp, "moments_map" ), SHADOW_UNIT_MOMENTS );
+}
+
+/* VSM and ESM blur moments made from the shadow maps before they are used */
+void prefilter_shadows( int filter ) {
+  if ( SHADOW_FILTER_VSM != filter && SHADOW_FILTER_ESM != filter ) { return; }
+  build_shadow_moments( &g_shadow_filters, g_cascades.depth_tex, g_cascades.n_cascades, g_filter_radius, SHADOW_FILTER_ESM == filter ? g_esm_c : 0.0f );
+}
+
+/* draw the ground plane and spheres, sampling the depth map for shadows */
+void render_shadow_receiving() {
+  gl_state_use_program( g_plain_sp );
+  gl_state_bind_texture( SHADOW_UNIT_DEPTH, GL_TEXTURE_2D_ARRAY, g_cascades.depth_tex );
+  gl_state_bind_texture( SHADOW_UNIT_COMPARE, GL_TEXTURE_2D_ARRAY, g_cascades.depth_tex );
+  gl_state_bind_texture( SHADOW_UNIT_MOMENTS, GL_TEXTURE_2D_ARRAY, g_shadow_filters.moments_tex );
+  glUniform1f( g_plain_filter_radius_loc, (GLfloat)g_filter_radius );
+  /* the cascades are re-fitted whenever the camera moves */
+  glUniformMatrix4fv( g_plain_cascade_VP_loc, g_cascades.n_cascades, GL_FALSE, g_cascades.VP[0].m );
+  glUniform1fv( g_plain_cascade_far_loc, g_cascades.n_cascades, &g_cascades.splits[1] );
+  glUniform1fv( g_plain_cascade_bias_loc, g_cascades.n_cascades, g_cascades.bias );
+  glUniform1i( g_plain_n_cascades_loc, g_cascades.n_cascades );
+
+  /* ground plane (receives shadows) */
+  glUniform3f( g_plain_colour_loc, 0.0, 1.0, 0.0 ); /* green */
+  gl_state_bind_vertex_array( g_ground_plane_vao );
+  glUniformMatrix4fv( g_plain_M_loc, 1, GL_FALSE, identity_mat4().m );
+  glDrawArrays( GL_TRIANGLES, 0, g_ground_plane_point_count );
+
+  /* spheres (cast and receive shadows) */
+  glUniform3f( g_plain_colour_loc, 1.0, 0.0, 0.0 ); /* red */
+  gl_state_bind_vertex_array( g_sphere_vao );
   for ( int i = 0; i < NUM_SPHERES; i++ ) {
-    glUniformMatrix4fv( g_depth_M_loc, 1, GL_FALSE, g_sphere_Ms[i].m );
+    glUniformMatrix4fv( g_plain_M_loc, 1, GL_FALSE, g_sphere_Ms[i].m );
     glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
   }
-  // bind the default framebuffer again
-  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+}
+
+/* reads back the frame just drawn and keeps the brightest channel of each
+pixel. the ground and spheres are pure green and red, so that is the amount of
+light that got through the shadow filter */
+void read_shadow_factors( unsigned char* rgb, float* factors ) {
+  glReadPixels( 0, 0, g_gl_width, g_gl_height, GL_RGB, GL_UNSIGNED_BYTE, rgb );
+  for ( int i = 0; i < g_gl_width * g_gl_height; i++ ) {
+    unsigned char m = rgb[i * 3] > rgb[i * 3 + 1] ? rgb[i * 3] : rgb[i * 3 + 1];
+    m               = m > rgb[i * 3 + 2] ? m : rgb[i * 3 + 2];
+    factors[i]      = (float)m / 255.0f;
+  }
+}
+
+/* times the shadow-receiving pass on the GPU with the uber shader, which
+branches on a uniform, against the specialised permutation, for each setting of
+SHADOW_FILTER. VSM and ESM also time their prefilter pass. llvmpipe's timer
+queries don't cover its rasteriser threads, so the wall-clock time to finish
+each frame is printed too. quality is the mean
+difference in shadowing from the reference filter, and the share of pixels that
+are visibly (more than 10%) off. to measure the software rasteriser run with
+LIBGL_ALWAYS_SOFTWARE=1 so that Mesa uses llvmpipe */
+void benchmark_variants() {
+  GLuint query = 0;
+  glGenQueries( 1, &query );
+  int n_pixels          = g_gl_width * g_gl_height;
+  unsigned char* rgb    = (unsigned char*)malloc( n_pixels * 3 );
+  float* reference      = (float*)malloc( n_pixels * sizeof( float ) );
+  float* factors        = (float*)malloc( n_pixels * sizeof( float ) );
+  unsigned int ref_mask = variant_key_bits( &g_plain_variants, g_plain_filter_key, SHADOW_FILTER_REFERENCE );
+  use_plain_programme( get_variant( &g_plain_variants, ref_mask ) );
+  glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+  render_shadow_receiving();
+  read_shadow_factors( rgb, reference );
+
+  printf( "benchmarking plain shader variants over %i frames each. renderer: %s\n", BENCH_FRAMES, glGetString( GL_RENDERER ) );
+  gl_log( "benchmarking plain shader variants over %i frames each. renderer: %s\n", BENCH_FRAMES, glGetString( GL_RENDERER ) );
+  printf( "  filter radius %i texels. %i cascades of %ix%i. times are GPU query/wall clock to glFinish()\n", g_filter_radius, g_cascades.n_cascades, g_shadow_size, g_shadow_size );
+  gl_log( "  filter radius %i texels. %i cascades of %ix%i. times are GPU query/wall clock to glFinish()\n", g_filter_radius, g_cascades.n_cascades, g_shadow_size, g_shadow_size );
+  for ( int filter = 0; filter < SHADOW_FILTER_COUNT; filter++ ) {
+    unsigned int mask   = variant_key_bits( &g_plain_variants, g_plain_filter_key, filter );
+    double prefilter_ms = 0.0, prefilter_wall_ms = 0.0;
+    if ( SHADOW_FILTER_VSM == filter || SHADOW_FILTER_ESM == filter ) {
+      GLuint64 total_ns = 0;
+      double wall_s     = 0.0;
+      glFinish();
+      for ( int i = 0; i < BENCH_FRAMES; i++ ) {
+        double start = glfwGetTime();
+        glBeginQuery( GL_TIME_ELAPSED, query );
+        prefilter_shadows( filter );
+        glEndQuery( GL_TIME_ELAPSED );
+        glFinish();
+        wall_s += glfwGetTime() - start;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v( query, GL_QUERY_RESULT, &ns );
+        total_ns += ns;
+      }
+      prefilter_ms      = (double)total_ns / (double)BENCH_FRAMES / 1000000.0;
+      prefilter_wall_ms = wall_s * 1000.0 / (double)BENCH_FRAMES;
+      gl_state_viewport( 0, 0, g_gl_width, g_gl_height );
+    }
+    /* specialised last, so that its final frame is the one checked below */
+    double ms[2], wall_ms[2];
+    for ( int uber = 1; uber >= 0; uber-- ) {
+      if ( uber ) {
+        use_plain_programme( get_uber_variant( &g_plain_variants ) );
+        set_uber_variant_keys( &g_plain_variants, mask );
+      } else {
+        use_plain_programme( get_variant( &g_plain_variants, mask ) );
+      }
+      GLuint64 total_ns = 0;
+      double wall_s     = 0.0;
+      for ( int i = 0; i < BENCH_FRAMES; i++ ) {
+        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+        glFinish();
+        double start = glfwGetTime();
+        glBeginQuery( GL_TIME_ELAPSED, query );
+        render_shadow_receiving();
+        glEndQuery( GL_TIME_ELAPSED );
+        glFinish();
+        wall_s += glfwGetTime() - start;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v( query, GL_QUERY_RESULT, &ns );
+        total_ns += ns;
+      }
+      ms[uber]      = (double)total_ns / (double)BENCH_FRAMES / 1000000.0;
+      wall_ms[uber] = wall_s * 1000.0 / (double)BENCH_FRAMES;
+    }
+    read_shadow_factors( rgb, factors );
+    double sum_error = 0.0;
+    int n_visible    = 0;
+    for ( int i = 0; i < n_pixels; i++ ) {
+      float error = fabsf( factors[i] - reference[i] );
+      sum_error += error;
+      if ( error > 0.1f ) { n_visible++; }
+    }
+    double mean_error = 100.0 * sum_error / (double)n_pixels;
+    double visible    = 100.0 * (double)n_visible / (double)n_pixels;
+    printf( "  SHADOW_FILTER=%i %-9s specialised %8.4f/%8.4fms uber %8.4f/%8.4fms prefilter %8.4f/%8.4fms | error %.3f%% mean, %.3f%% of pixels visibly off\n", filter,
+      shadow_filter_name( filter ), ms[0], wall_ms[0], ms[1], wall_ms[1], prefilter_ms, prefilter_wall_ms, mean_error, visible );
+    gl_log( "  SHADOW_FILTER=%i %-9s specialised %8.4f/%8.4fms uber %8.4f/%8.4fms prefilter %8.4f/%8.4fms | error %.3f%% mean, %.3f%% of pixels visibly off\n", filter,
+      shadow_filter_name( filter ), ms[0], wall_ms[0], ms[1], wall_ms[1], prefilter_ms, prefilter_wall_ms, mean_error, visible );
+  }
+  free( rgb );
+  free( reference );
+  free( factors );
+  glDeleteQueries( 1, &query );
+  prefilter_shadows( g_shadow_filter );
+  gl_state_viewport( 0, 0, g_gl_width, g_gl_height );
+  use_plain_programme( get_variant( &g_plain_variants, g_plain_mask ) );
+}
 
-  glDisable( GL_POLYGON_OFFSET_FILL );
+/* re-fit the shadow cascades to the camera. call after moving the camera or
+changing the split scheme */
+void update_cascades() {
+  fit_shadow_cascades( &g_cascades, g_camera_V, g_camera_fov, g_camera_aspect, g_light_dir, g_sphere_bounds, NUM_SPHERES );
+}
+
+void print_cascade_splits() {
+  printf( "%i shadow cascades, lambda %.2f, splits:", g_cascades.n_cascades, g_cascades.lambda );
+  gl_log( "%i shadow cascades, lambda %.2f, splits:", g_cascades.n_cascades, g_cascades.lambda );
+  for ( int c = 0; c <= g_cascades.n_cascades; c++ ) {
+    printf( " %.2f", g_cascades.splits[c] );
+    gl_log( " %.2f", g_cascades.splits[c] );
+  }
+  printf( "\n" );
+  gl_log( "\n" );
+}
+
+/* times the shadow-casting pass on the GPU for each cascade, from the current
+camera position, with 1 (a single map over the whole view) to CSM_MAX_CASCADES
+cascades */
+void benchmark_cascades() {
+  GLuint queries[CSM_MAX_CASCADES];
+  glGenQueries( CSM_MAX_CASCADES, queries );
+  printf( "benchmarking shadow cascades over %i frames each. %ix%i per cascade, %i casters\n", BENCH_FRAMES, g_shadow_size, g_shadow_size, NUM_SPHERES );
+  gl_log( "benchmarking shadow cascades over %i frames each. %ix%i per cascade, %i casters\n", BENCH_FRAMES, g_shadow_size, g_shadow_size, NUM_SPHERES );
+  for ( int n = 1; n <= CSM_MAX_CASCADES; n++ ) {
+    set_cascade_splits( &g_cascades, n, g_camera_near, g_camera_far, g_cascade_lambda );
+    update_cascades();
+    GLuint64 total_ns[CSM_MAX_CASCADES] = { 0 };
+    for ( int i = 0; i < BENCH_FRAMES; i++ ) {
+      render_shadow_casting( queries );
+      for ( int c = 0; c < n; c++ ) {
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v( queries[c], GL_QUERY_RESULT, &ns );
+        total_ns[c] += ns;
+      }
+    }
+    print_cascade_splits();
+    double sum_ms = 0.0;
+    for ( int c = 0; c < n; c++ ) {
+      double ms = (double)total_ns[c] / (double)BENCH_FRAMES / 1000000.0;
+      /* world size of a texel says how sharp the shadows in this cascade are */
+      float texel = ( g_cascades.box[c][3] - g_cascades.box[c][0] ) / (float)g_shadow_size;
+      printf( "  cascade %i: %5.1f-%5.1f %2i draws %.4fms %.3f units/texel\n", c, g_cascades.splits[c], g_cascades.splits[c + 1], g_cascades.n_draws[c], ms, texel );
+      gl_log( "  cascade %i: %5.1f-%5.1f %2i draws %.4fms %.3f units/texel\n", c, g_cascades.splits[c], g_cascades.splits[c + 1], g_cascades.n_draws[c], ms, texel );
+      sum_ms += ms;
+    }
+    printf( "  total %.4fms/frame\n", sum_ms );
+    gl_log( "  total %.4fms/frame\n", sum_ms );
+  }
+  glDeleteQueries( CSM_MAX_CASCADES, queries );
+  set_cascade_splits( &g_cascades, g_n_cascades, g_camera_near, g_camera_far, g_cascade_lambda );
+  update_cascades();
 }
 
 // a world position for each sphere in the scene
@@ -225,36 +464,35 @@ int main() {
   /* start GL context and O/S window using the GLFW helper library */
   ( start_gl() );
   /*---------------------CREATE FRAMEBUFFER TO CAPTURE DEPTH--------------------*/
-  init_shadow_fb();
+  if ( !init_shadow_fb() ) { return 1; }
+  if ( !init_shadow_filters( &g_shadow_filters, g_shadow_size, CSM_MAX_CASCADES ) ) { return 1; }
+  bind_shadow_samplers( &g_shadow_filters );
   /*------------------------------CREATE GEOMETRY-------------------------------*/
   init_ground_plane(); /* a floor that i'll make green */
   init_spheres();      /* some floating spheres to cast shadows */
   init_ss_quad();      /* on-screen square for debugging the depth map */
 
   /*-------------------------------CREATE SHADERS-------------------------------*/
-  g_plain_sp                  = create_programme_from_files( PLAIN_VS, PLAIN_FS );
-  g_plain_M_loc               = glGetUniformLocation( g_plain_sp, "M" );
-  g_plain_V_loc               = glGetUniformLocation( g_plain_sp, "V" );
-  g_plain_P_loc               = glGetUniformLocation( g_plain_sp, "P" );
-  g_plain_caster_V_loc        = glGetUniformLocation( g_plain_sp, "caster_V" );
-  g_plain_caster_P_loc        = glGetUniformLocation( g_plain_sp, "caster_P" );
-  g_plain_colour_loc          = glGetUniformLocation( g_plain_sp, "colour" );
-  g_plain_shad_resolution_loc = glGetUniformLocation( g_plain_sp, "shad_resolution" );
+  ( init_shader_variants( &g_plain_variants, PLAIN_VS, PLAIN_FS ) );
+  g_plain_filter_key = add_variant_key( &g_plain_variants, "SHADOW_FILTER", SHADOW_FILTER_BITS );
+  g_plain_mask       = variant_key_bits( &g_plain_variants, g_plain_filter_key, g_shadow_filter );
 
-  g_debug_sp = create_programme_from_files( DEBUG_VS, DEBUG_FS );
+  g_debug_sp        = create_programme_from_files( DEBUG_VS, DEBUG_FS );
+  g_debug_layer_loc = glGetUniformLocation( g_debug_sp, "layer" );
 
   g_depth_sp    = create_programme_from_files( DEPTH_VS, DEPTH_FS );
   g_depth_M_loc = glGetUniformLocation( g_depth_sp, "M" );
   g_depth_V_loc = glGetUniformLocation( g_depth_sp, "V" );
   g_depth_P_loc = glGetUniformLocation( g_depth_sp, "P" );
   /*-------------------------------CREATE CAMERAS-------------------------------*/
-  create_shadow_caster();
+  g_camera_near   = 0.1f;                                   // clipping plane
+  g_camera_far    = 100.0f;                                 // clipping plane
+  g_camera_fov    = 67.0f;                                  // convert 67 degrees to radians
+  g_camera_aspect = (float)g_gl_width / (float)g_gl_height; // aspect ratio
+  g_camera_P      = perspective( g_camera_fov, g_camera_aspect, g_camera_near, g_camera_far );
 
-  float near   = 0.1f;                                   // clipping plane
-  float far    = 100.0f;                                 // clipping plane
-  float fov    = 67.0f;                                  // convert 67 degrees to radians
-  float aspect = (float)g_gl_width / (float)g_gl_height; // aspect ratio
-  g_camera_P   = perspective( fov, aspect, near, far );
+  create_shadow_caster();
+  print_cascade_splits();
 
   float cam_speed         = 5.0f;   // 1 unit per second
   float cam_heading_speed = 100.0f; // 10 degrees per second
@@ -268,17 +506,29 @@ int main() {
   g_camera_V = inverse( R ) * inverse( T );
 
   /*---------------------------SET RENDERING DEFAULTS---------------------------*/
-  glUseProgram( g_plain_sp );
-  glUniformMatrix4fv( g_plain_V_loc, 1, GL_FALSE, g_camera_V.m );
-  glUniformMatrix4fv( g_plain_P_loc, 1, GL_FALSE, g_camera_P.m );
-  glUniformMatrix4fv( g_plain_caster_V_loc, 1, GL_FALSE, g_caster_V.m );
-  glUniformMatrix4fv( g_plain_caster_P_loc, 1, GL_FALSE, g_caster_P.m );
-  glUniform1f( g_plain_shad_resolution_loc, (GLfloat)g_shadow_size );
-  for ( int i = 0; i < NUM_SPHERES; i++ ) { g_sphere_Ms[i] = translate( identity_mat4(), sphere_pos_wor[i] ); }
+  /* everything from here on goes through the state tracker */
+  gl_state_invalidate();
+  use_plain_programme( get_variant( &g_plain_variants, g_plain_mask ) );
+  /* scatter the rest of the monkeys over the ground, the same way every run */
+  srand( 1 );
+  for ( int i = 0; i < NUM_SPHERES; i++ ) {
+    vec3 pos;
+    if ( i < 4 ) {
+      pos = sphere_pos_wor[i];
+    } else {
+      float x = ( (float)rand() / (float)RAND_MAX * 2.0f - 1.0f ) * GROUND_EXTENT * 0.9f;
+      float z = ( (float)rand() / (float)RAND_MAX * 2.0f - 1.0f ) * GROUND_EXTENT * 0.9f;
+      pos     = vec3( x, (float)rand() / (float)RAND_MAX * 3.0f, z );
+    }
+    g_sphere_Ms[i]            = translate( identity_mat4(), pos );
+    g_sphere_bounds[i].centre = pos;
+    g_sphere_bounds[i].radius = g_sphere_radius;
+  }
+  update_cascades();
 
-  glEnable( GL_CULL_FACE );  // cull face
-  glEnable( GL_DEPTH_TEST ); // enable depth-testing
-  glDepthFunc( GL_LESS );    // depth-testing interprets a smaller value as "closer"
+  gl_state_enable( GL_CULL_FACE );  // cull face
+  gl_state_enable( GL_DEPTH_TEST ); // enable depth-testing
+  gl_state_depth_func( GL_LESS );   // depth-testing interprets a smaller value as "closer"
   /*-------------------------------RENDERING LOOP-------------------------------*/
   while ( !glfwWindowShouldClose( g_window ) ) {
     // update timers
@@ -290,44 +540,84 @@ int main() {
 
     /*------------------------DEPTH WRITING RENDERING PASS--------------------------
     should do one of these per visible light source or shadow caster. we just have
-    one caster that writes to a single texture
+    one caster, but it writes a layer of the texture array for each cascade
     ------------------------------------------------------------------------------*/
     /* back-face rendering only to remove self-shadowing issues. usually helps
     in this demo it made it worse */
     // glCullFace (GL_FRONT);
-    render_shadow_casting();
+    render_shadow_casting( NULL );
+    prefilter_shadows( g_shadow_filter );
     /*------------------------DEPTH READING RENDERING PASS--------------------------
     normal rendering here, but we can sample the depth map and use the shadow
     caster's view and projection matrices to work out what part of the depth map
     should cover the rendered parts of our scene. note that i reset the culling
     information, clear colour, and viewport dimensions here, because these are
     changed in the shadow casting pass */
-    glCullFace( GL_BACK );              // cull back face
-    glFrontFace( GL_CCW );              // set counter-clock-wise vertex order to mean the front
-    glClearColor( 0.2, 0.2, 0.2, 1.0 ); // grey background to help spot mistakes
-    glViewport( 0, 0, g_gl_width, g_gl_height );
+    gl_state_cull_face( GL_BACK );               // cull back face
+    gl_state_front_face( GL_CCW );               // set counter-clock-wise vertex order to mean the front
+    gl_state_clear_colour( 0.2, 0.2, 0.2, 1.0 ); // grey background to help spot mistakes
+    gl_state_viewport( 0, 0, g_gl_width, g_gl_height );
     // wipe the drawing surface clear
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
-    glUseProgram( g_plain_sp );
-    glActiveTexture( GL_TEXTURE0 );
-    glBindTexture( GL_TEXTURE_2D, g_depth_fb_tex );
+    render_shadow_receiving();
+    // update other events like input handling
+    glfwPollEvents();
 
-    /* ground plane (receives shadows) */
-    glUniform3f( g_plain_colour_loc, 0.0, 1.0, 0.0 ); /* green */
-    glBindVertexArray( g_ground_plane_vao );
-    glUniformMatrix4fv( g_plain_M_loc, 1, GL_FALSE, identity_mat4().m );
-    glDrawArrays( GL_TRIANGLES, 0, g_ground_plane_point_count );
+    /* switch shader permutation. the first switch compiles the variant, after
+    that it comes from the cache */
+    static bool p_was_down = false;
+    bool p_is_down         = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_P );
+    if ( p_is_down && !p_was_down ) {
+      g_shadow_filter = ( g_shadow_filter + 1 ) % SHADOW_FILTER_COUNT;
+      g_plain_mask    = variant_key_bits( &g_plain_variants, g_plain_filter_key, g_shadow_filter );
+      use_plain_programme( get_variant( &g_plain_variants, g_plain_mask ) );
+      printf( "shadow filter: %s\n", shadow_filter_name( g_shadow_filter ) );
+    }
+    p_was_down = p_is_down;
+    /* filter width, in texels either side */
+    static int r_was_down = 0;
+    int r_is_down         = 0;
+    if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_MINUS ) ) { r_is_down = -1; }
+    if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_EQUAL ) ) { r_is_down = 1; }
+    if ( r_is_down && r_is_down != r_was_down ) {
+      g_filter_radius += r_is_down;
+      g_filter_radius = g_filter_radius < 1 ? 1 : ( g_filter_radius > 4 ? 4 : g_filter_radius );
+      printf( "shadow filter radius: %i texels\n", g_filter_radius );
+    }
+    r_was_down             = r_is_down;
+    static bool b_was_down = false;
+    bool b_is_down         = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_B );
+    if ( b_is_down && !b_was_down ) {
+      benchmark_variants();
+      benchmark_cascades();
+    }
+    b_was_down = b_is_down;
 
-    /* spheres (cast and receive shadows) */
-    glUniform3f( g_plain_colour_loc, 1.0, 0.0, 0.0 ); /* red */
-    glBindVertexArray( g_sphere_vao );
-    for ( int i = 0; i < NUM_SPHERES; i++ ) {
-      glUniformMatrix4fv( g_plain_M_loc, 1, GL_FALSE, g_sphere_Ms[i].m );
-      glDrawArrays( GL_TRIANGLES, 0, g_sphere_point_count );
+    /* cascade count and split scheme */
+    static int n_was_down = 0;
+    int n_is_down         = 0;
+    for ( int n = 2; n <= CSM_MAX_CASCADES; n++ ) {
+      if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_0 + n ) ) { n_is_down = n; }
     }
-    // update other events like input handling
-    glfwPollEvents();
+    static int l_was_down = 0;
+    int l_is_down         = 0;
+    if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_LEFT_BRACKET ) ) { l_is_down = -1; }
+    if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_RIGHT_BRACKET ) ) { l_is_down = 1; }
+    if ( ( n_is_down && n_is_down != n_was_down ) || ( l_is_down && l_is_down != l_was_down ) ) {
+      if ( n_is_down ) { g_n_cascades = n_is_down; }
+      g_cascade_lambda += 0.125f * (float)l_is_down;
+      g_cascade_lambda = g_cascade_lambda < 0.0f ? 0.0f : ( g_cascade_lambda > 1.0f ? 1.0f : g_cascade_lambda );
+      set_cascade_splits( &g_cascades, g_n_cascades, g_camera_near, g_camera_far, g_cascade_lambda );
+      update_cascades();
+      print_cascade_splits();
+    }
+    n_was_down             = n_is_down;
+    l_was_down             = l_is_down;
+    static bool k_was_down = false;
+    bool k_is_down         = GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_K );
+    if ( k_is_down && !k_was_down ) { g_debug_cascade = ( g_debug_cascade + 1 ) % g_cascades.n_cascades; }
+    k_was_down = k_is_down;
 
     // control keys
     bool cam_moved  = false;
@@ -407,28 +697,34 @@ int main() {
       mat4 T     = translate( identity_mat4(), cam_pos );
       g_camera_V = inverse( R ) * inverse( T );
       glUniformMatrix4fv( g_plain_V_loc, 1, GL_FALSE, g_camera_V.m );
+      update_cascades();
     }
-    /* switch between looking from virtual camera and shadow caster matrices */
+    /* switch between looking from virtual camera and the shown cascade's matrices */
+    if ( g_debug_cascade >= g_cascades.n_cascades ) { g_debug_cascade = 0; }
     if ( glfwGetKey( g_window, GLFW_KEY_SPACE ) ) {
-      glUniformMatrix4fv( g_plain_V_loc, 1, GL_FALSE, g_caster_V.m );
-      glUniformMatrix4fv( g_plain_P_loc, 1, GL_FALSE, g_caster_P.m );
+      glUniformMatrix4fv( g_plain_V_loc, 1, GL_FALSE, g_cascades.V.m );
+      glUniformMatrix4fv( g_plain_P_loc, 1, GL_FALSE, g_cascades.P[g_debug_cascade].m );
     } else {
       glUniformMatrix4fv( g_plain_V_loc, 1, GL_FALSE, g_camera_V.m );
       glUniformMatrix4fv( g_plain_P_loc, 1, GL_FALSE, g_camera_P.m );
     }
 
     /* draw ss quad */
-    glActiveTexture( GL_TEXTURE0 );
-    glBindTexture( GL_TEXTURE_2D, g_depth_fb_tex );
-    glUseProgram( g_debug_sp );
-    glBindVertexArray( g_ss_quad_vao );
+    gl_state_bind_texture( 0, GL_TEXTURE_2D_ARRAY, g_cascades.depth_tex );
+    gl_state_use_program( g_debug_sp );
+    glUniform1i( g_debug_layer_loc, g_debug_cascade );
+    gl_state_bind_vertex_array( g_ss_quad_vao );
     glDrawArrays( GL_TRIANGLES, 0, g_ss_quad_point_count );
+    gl_state_end_frame();
 
     if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_ESCAPE ) ) { glfwSetWindowShouldClose( g_window, 1 ); }
     // put the stuff we've been drawing onto the display
     glfwSwapBuffers( g_window );
   }
 
+  free_shader_variants( &g_plain_variants );
+  free_shadow_cascades( &g_cascades );
+  free_shadow_filters( &g_shadow_filters );
   // close GL context and any other GLFW resources
   glfwTerminate();
   return 0;
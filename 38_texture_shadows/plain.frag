@@ -1,57 +1,163 @@
 #version 410
 
-// vertex points in light coordinate space
-in vec4 st_shadow;
-// the depth map
-uniform sampler2D depth_map;
+#define MAX_CASCADES 4
+/* values of the SHADOW_FILTER variant key. see shadow_filters.h */
+#define FILTER_NONE 0
+#define FILTER_FOUR_TAP 1
+#define FILTER_HARDWARE 2
+#define FILTER_POISSON 3
+#define FILTER_VSM 4
+#define FILTER_ESM 5
+#define FILTER_REFERENCE 6
+
+in vec4 p_wor;
+in float view_depth;
+// the depth maps. one layer per cascade
+uniform sampler2DArray depth_map;
+/* the same texture again, on a unit with a comparison sampler. each lookup
+compares the 4 nearest texels and blends the results */
+uniform sampler2DArrayShadow depth_map_shadow;
+/* blurred moments made from the depth maps, for VSM and ESM */
+uniform sampler2DArray moments_map;
+/* view and projection matrices from the shadow caster (light source) for each
+cascade, and the view depth where each cascade ends */
+uniform mat4 cascade_VP[MAX_CASCADES];
+uniform float cascade_far[MAX_CASCADES];
+uniform float cascade_bias[MAX_CASCADES];
+uniform int n_cascades = 1;
 uniform vec3 colour;
 uniform float shad_resolution = 2048.0;
+/* half-width in texels of the Poisson disc and the reference box. the VSM/ESM
+blur uses the same radius */
+uniform float filter_radius = 2.0;
+uniform float esm_c = 80.0;
 out vec4 frag_colour;
 
-float eval_shadow (in vec4 texcoods) {
-	// constant that you can use to slightly tweak the depth comparison
-	float epsilon = 0.003;
+const vec2 poisson_disc[16] = vec2[] (
+	vec2 (-0.94201624, -0.39906216), vec2 (0.94558609, -0.76890725),
+	vec2 (-0.09418410, -0.92938870), vec2 (0.34495938, 0.29387760),
+	vec2 (-0.91588581, 0.45771432), vec2 (-0.81544232, -0.87912464),
+	vec2 (-0.38277543, 0.27676845), vec2 (0.97484398, 0.75648379),
+	vec2 (0.44323325, -0.97511554), vec2 (0.53742981, -0.47373420),
+	vec2 (-0.26496911, -0.41893023), vec2 (0.79197514, 0.19090188),
+	vec2 (-0.24188840, 0.99706507), vec2 (-0.81409955, 0.91437590),
+	vec2 (0.19984126, 0.78641367), vec2 (0.14383161, -0.14100790)
+);
+
+float eval_shadow (in vec4 texcoods, in int cascade) {
 	if (texcoods.x > 1.0 || texcoods.x < 0.0 || texcoods.y > 1.0 || texcoods.y < 0.0 || texcoods.w < 0.0) {
 		return 1.0; // do not add shadow/ignore
 	}
-	float shadow = texture (depth_map, texcoods.xy).r;
-	
-	if (shadow + epsilon < texcoods.z) {
-		return 0.1; // shadowed
+	float shadow = texture (depth_map, vec3 (texcoods.xy, float (cascade))).r;
+
+	/* the offset that stops surfaces shadowing themselves is about 2 texels in
+	world units, so it is different for each cascade */
+	if (shadow + cascade_bias[cascade] < texcoods.z) {
+		return 0.0; // shadowed
 	}
 	return 1.0; // not shadowed
 }
 
+/* one hardware comparison. 1 is lit, 0 shadowed, in between on edges */
+float compare_shadow (in vec2 st, in float z, in int cascade) {
+	return texture (depth_map_shadow, vec4 (st, float (cascade), z - cascade_bias[cascade]));
+}
+
+/* Chebyshev's upper bound on the lit fraction of the blurred area */
+float vsm_shadow (in vec2 st, in float z, in int cascade) {
+	vec2 m = texture (moments_map, vec3 (st, float (cascade))).rg;
+	if (z <= m.x) {
+		return 1.0;
+	}
+	/* a little variance everywhere stops flat surfaces shadowing themselves */
+	float variance = max (m.y - m.x * m.x, cascade_bias[cascade] * cascade_bias[cascade]);
+	float d = z - m.x;
+	float p_max = variance / (variance + d * d);
+	/* where casters overlap, light bleeds through as a faint outline. cutting
+	off the bottom of the range hides most of it at the cost of some softness */
+	return clamp ((p_max - 0.3) / 0.7, 0.0, 1.0);
+}
+
+float esm_shadow (in vec2 st, in float z, in int cascade) {
+	float m = texture (moments_map, vec3 (st, float (cascade))).r;
+	return clamp (m * exp (-esm_c * (z - cascade_bias[cascade])), 0.0, 1.0);
+}
+
+float filtered_shadow (in vec4 shad_coord, in int cascade) {
+	if (shad_coord.x > 1.0 || shad_coord.x < 0.0 || shad_coord.y > 1.0 || shad_coord.y < 0.0 || shad_coord.w < 0.0) {
+		return 1.0;
+	}
+	vec2 texel = vec2 (1.0 / shad_resolution);
+	float z = shad_coord.z;
+	/* SHADOW_FILTER is a variant key - it is #defined to one of the FILTER_
+	values when the shader is compiled, so only one of these branches survives
+	in each permutation. see shader_variants.h. update the resolution uniform if
+	you change the shadow texture size though */
+	if (SHADOW_FILTER == FILTER_FOUR_TAP) {
+		/* this is a very basic filter for the harsh edges */
+		vec4 sc_a = shad_coord;
+		vec4 sc_b = shad_coord;
+		vec4 sc_c = shad_coord;
+		vec4 sc_d = shad_coord;
+		sc_a.x += texel.x;
+		sc_b.x -= texel.x;
+		sc_c.y += texel.y;
+		sc_d.y -= texel.y;
+		float shadow_factor_a = eval_shadow (sc_a, cascade);
+		float shadow_factor_b = eval_shadow (sc_b, cascade);
+		float shadow_factor_c = eval_shadow (sc_c, cascade);
+		float shadow_factor_d = eval_shadow (sc_d, cascade);
+		return shadow_factor_a * 0.25 + shadow_factor_b * 0.25 +
+			shadow_factor_c * 0.25 + shadow_factor_d * 0.25;
+	} else if (SHADOW_FILTER == FILTER_HARDWARE) {
+		return compare_shadow (shad_coord.xy, z, cascade);
+	} else if (SHADOW_FILTER == FILTER_POISSON) {
+		/* turn the disc by a different angle at each pixel */
+		float angle = 6.2831853 * fract (sin (dot (gl_FragCoord.xy, vec2 (12.9898, 78.233))) * 43758.5453);
+		mat2 rot = mat2 (cos (angle), sin (angle), -sin (angle), cos (angle));
+		float sum = 0.0;
+		for (int i = 0; i < 16; i++) {
+			vec2 offset = rot * poisson_disc[i] * filter_radius * texel;
+			sum += compare_shadow (shad_coord.xy + offset, z, cascade);
+		}
+		return sum / 16.0;
+	} else if (SHADOW_FILTER == FILTER_VSM) {
+		return vsm_shadow (shad_coord.xy, z, cascade);
+	} else if (SHADOW_FILTER == FILTER_ESM) {
+		return esm_shadow (shad_coord.xy, z, cascade);
+	} else if (SHADOW_FILTER == FILTER_REFERENCE) {
+		/* a comparison at every texel of the box that VSM and ESM blur over */
+		int r = int (filter_radius);
+		float sum = 0.0;
+		for (int y = -r; y <= r; y++) {
+			for (int x = -r; x <= r; x++) {
+				sum += compare_shadow (shad_coord.xy + vec2 (x, y) * texel, z, cascade);
+			}
+		}
+		return sum / float ((2 * r + 1) * (2 * r + 1));
+	}
+	/* this is the original sampling without a filter */
+	return eval_shadow (shad_coord, cascade);
+}
+
 void main() {
 	frag_colour = vec4 (colour, 1.0);
-	
-	vec4 shad_coord = st_shadow;
+
+	/* the first cascade that reaches this far. past the last one is unshadowed */
+	int cascade = 0;
+	while (cascade < n_cascades && view_depth > cascade_far[cascade]) {
+		cascade++;
+	}
+	if (cascade >= n_cascades) {
+		return;
+	}
+	vec4 shad_coord = cascade_VP[cascade] * p_wor;
 	/* we compute this in frag shader otherwise we get errors from interpolation*/
 	shad_coord.xyz /= shad_coord.w;
 	shad_coord.xyz += 1.0;
 	shad_coord.xyz *= 0.5;
-	/* this is the original sampling without a filter */
-	float shadow_factor = eval_shadow (shad_coord);
-	
-	/* this section is a very basic filter for the harsh edges
-	update the resolution uniform if you change the shadow texture size though
-	*/
-	/*
-	vec4 sc_a = shad_coord;
-	vec4 sc_b = shad_coord;
-	vec4 sc_c = shad_coord;
-	vec4 sc_d = shad_coord;
-	sc_a.x += 1.0 / shad_resolution;
-	sc_b.x -= 1.0 / shad_resolution;
-	sc_c.y += 1.0 / shad_resolution;
-	sc_d.y -= 1.0 / shad_resolution;
-	float shadow_factor_a = eval_shadow (sc_a);
-	float shadow_factor_b = eval_shadow (sc_b);
-	float shadow_factor_c = eval_shadow (sc_c);
-	float shadow_factor_d = eval_shadow (sc_d);
-	float shadow_factor = shadow_factor_a * 0.25 + shadow_factor_b * 0.25 +
-		shadow_factor_c * 0.25 + shadow_factor_d * 0.25;*/
-	
-	
+	/* 1 is lit, 0 is fully shadowed. shadows keep a little light */
+	float shadow_factor = mix (0.1, 1.0, filtered_shadow (shad_coord, cascade));
+
 	frag_colour = vec4 (colour * shadow_factor, 1.0);
 }
@@ -0,0 +1,161 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Shader permutations ("variants") with compile-time specialised defines.      |
+\******************************************************************************/
+#include "shader_variants.h"
+#include "gl_utils.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define VARIANT_MAX_SHADER_LENGTH 262144
+/* room for a #define line, and a uniform line in the uber shader, per key */
+#define VARIANT_MAX_DEFINES_LENGTH ( VARIANT_MAX_KEYS * ( 2 * VARIANT_MAX_KEY_NAME + 64 ) )
+
+bool init_shader_variants( shader_variants_t* sv, const char* vert_file_name, const char* frag_file_name ) {
+  memset( sv, 0, sizeof( shader_variants_t ) );
+  sv->vs_str = (char*)malloc( VARIANT_MAX_SHADER_LENGTH );
+  sv->fs_str = (char*)malloc( VARIANT_MAX_SHADER_LENGTH );
+  if ( !sv->vs_str || !sv->fs_str ) {
+    gl_log_err( "ERROR: out of memory loading shader variants\n" );
+    return false;
+  }
+  if ( !parse_file_into_str( vert_file_name, sv->vs_str, VARIANT_MAX_SHADER_LENGTH ) ) { return false; }
+  if ( !parse_file_into_str( frag_file_name, sv->fs_str, VARIANT_MAX_SHADER_LENGTH ) ) { return false; }
+  gl_log( "shader variants from %s and %s\n", vert_file_name, frag_file_name );
+  return true;
+}
+
+void free_shader_variants( shader_variants_t* sv ) {
+  for ( int i = 0; i < ( 1 << VARIANT_MAX_BITS ); i++ ) {
+    if ( sv->programmes[i] ) { glDeleteProgram( sv->programmes[i] ); }
+  }
+  if ( sv->uber_programme ) { glDeleteProgram( sv->uber_programme ); }
+  free( sv->vs_str );
+  free( sv->fs_str );
+  memset( sv, 0, sizeof( shader_variants_t ) );
+}
+
+int add_variant_key( shader_variants_t* sv, const char* name, int bits ) {
+  assert( bits > 0 );
+  if ( sv->n_keys >= VARIANT_MAX_KEYS || sv->n_bits + bits > VARIANT_MAX_BITS ) {
+    gl_log_err( "ERROR: no room in variant mask for key %s\n", name );
+    return -1;
+  }
+  if ( sv->n_compiled > 0 || sv->uber_programme ) {
+    gl_log_err( "ERROR: variant key %s added after variants were compiled\n", name );
+    return -1;
+  }
+  variant_key_t* key = &sv->keys[sv->n_keys];
+  strncpy( key->name, name, VARIANT_MAX_KEY_NAME - 1 );
+  key->name[VARIANT_MAX_KEY_NAME - 1] = '\0';
+  key->shift                          = sv->n_bits;
+  key->bits                           = bits;
+  sv->n_bits += bits;
+  return sv->n_keys++;
+}
+
+unsigned int variant_key_bits( const shader_variants_t* sv, int key, unsigned int value ) {
+  assert( key >= 0 && key < sv->n_keys );
+  unsigned int max_value = ( 1u << sv->keys[key].bits ) - 1u;
+  assert( value <= max_value );
+  return ( value & max_value ) << sv->keys[key].shift;
+}
+
+/* compiles one stage with the extra defines inserted after the #version line,
+which has to stay first in the source */
+static bool compile_variant_shader( const char* src, const char* defines, GLenum type, GLuint* shader ) {
+  const char* body = src;
+  int version_len  = 0;
+  if ( 0 == strncmp( src, "#version", 8 ) ) {
+    const char* eol = strchr( src, '\n' );
+    body            = eol ? eol + 1 : src + strlen( src );
+    version_len     = (int)( body - src );
+  }
+  const GLchar* strs[3] = { src, defines, body };
+  GLint lens[3]         = { version_len, -1, -1 };
+  *shader               = glCreateShader( type );
+  glShaderSource( *shader, 3, strs, lens );
+  glCompileShader( *shader );
+  int params = -1;
+  glGetShaderiv( *shader, GL_COMPILE_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    gl_log_err( "ERROR: GL shader index %i did not compile with defines:\n%s", *shader, defines );
+    print_shader_info_log( *shader );
+    glDeleteShader( *shader );
+    *shader = 0;
+    return false;
+  }
+  return true;
+}
+
+static GLuint build_variant( shader_variants_t* sv, const char* defines ) {
+  GLuint vert = 0, frag = 0, programme = 0;
+  if ( !compile_variant_shader( sv->vs_str, defines, GL_VERTEX_SHADER, &vert ) ) { return 0; }
+  if ( !compile_variant_shader( sv->fs_str, defines, GL_FRAGMENT_SHADER, &frag ) ) {
+    glDeleteShader( vert );
+    return 0;
+  }
+  if ( !create_programme( vert, frag, &programme ) ) {
+    glDeleteProgram( programme );
+    return 0;
+  }
+  return programme;
+}
+
+GLuint get_variant( shader_variants_t* sv, unsigned int mask ) {
+  assert( mask < ( 1u << VARIANT_MAX_BITS ) );
+  if ( sv->programmes[mask] ) { return sv->programmes[mask]; }
+  if ( sv->failed[mask] ) { return 0; }
+
+  char defines[VARIANT_MAX_DEFINES_LENGTH];
+  int len = 0;
+  for ( int i = 0; i < sv->n_keys; i++ ) {
+    unsigned int value = ( mask >> sv->keys[i].shift ) & ( ( 1u << sv->keys[i].bits ) - 1u );
+    len += snprintf( defines + len, sizeof( defines ) - len, "#define %s %u\n", sv->keys[i].name, value );
+  }
+  double start_s       = glfwGetTime();
+  GLuint programme     = build_variant( sv, defines );
+  sv->programmes[mask] = programme;
+  sv->failed[mask]     = !programme;
+  if ( programme ) {
+    sv->n_compiled++;
+    gl_log( "compiled variant mask 0x%02x as programme %u in %.2fms\n", mask, programme, ( glfwGetTime() - start_s ) * 1000.0 );
+  }
+  return programme;
+}
+
+GLuint get_uber_variant( shader_variants_t* sv ) {
+  if ( sv->uber_programme ) { return sv->uber_programme; }
+  if ( sv->uber_failed ) { return 0; }
+
+  char defines[VARIANT_MAX_DEFINES_LENGTH];
+  int len = 0;
+  for ( int i = 0; i < sv->n_keys; i++ ) {
+    const char* name = sv->keys[i].name;
+    len += snprintf( defines + len, sizeof( defines ) - len, "uniform int uber_%s;\n#define %s uber_%s\n", name, name, name );
+  }
+  sv->uber_programme = build_variant( sv, defines );
+  sv->uber_failed    = !sv->uber_programme;
+  if ( !sv->uber_programme ) { return 0; }
+  for ( int i = 0; i < sv->n_keys; i++ ) {
+    char uniform_name[VARIANT_MAX_KEY_NAME + 8];
+    snprintf( uniform_name, sizeof( uniform_name ), "uber_%s", sv->keys[i].name );
+    sv->uber_key_locs[i] = glGetUniformLocation( sv->uber_programme, uniform_name );
+  }
+  gl_log( "compiled uber variant as programme %u\n", sv->uber_programme );
+  return sv->uber_programme;
+}
+
+void set_uber_variant_keys( const shader_variants_t* sv, unsigned int mask ) {
+  for ( int i = 0; i < sv->n_keys; i++ ) {
+    unsigned int value = ( mask >> sv->keys[i].shift ) & ( ( 1u << sv->keys[i].bits ) - 1u );
+    glUniform1i( sv->uber_key_locs[i], (GLint)value );
+  }
+}
@@ -0,0 +1,71 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Shader permutations ("variants") with compile-time specialised defines.      |
+| A programme declares some feature keys, e.g. SHADOW_PCF or KERNEL_SIZE, and  |
+| each key gets a few bits of a variant mask. Asking for a mask compiles that  |
+| permutation the first time, with a #define for every key inserted after the  |
+| #version line, and caches the programme in a table indexed by the mask.      |
+|                                                                              |
+| Write the shader as if the keys were constants: if (SHADOW_PCF) {...}. The   |
+| GLSL compiler folds constant branches away, so specialised variants carry no |
+| dead code. The same source can also be built as an "uber" shader, where each |
+| key is replaced by a uniform int called uber_<KEY>, for comparison.          |
+\******************************************************************************/
+#ifndef _SHADER_VARIANTS_H_
+#define _SHADER_VARIANTS_H_
+
+#include <GL/glew.h>
+
+#define VARIANT_MAX_KEYS 8
+/* the mask indexes the cache directly so keep this small */
+#define VARIANT_MAX_BITS 8
+#define VARIANT_MAX_KEY_NAME 64
+
+struct variant_key_t {
+  char name[VARIANT_MAX_KEY_NAME];
+  int shift; /* first bit of this key's value in the variant mask */
+  int bits;  /* number of bits holding the value. 1 for an on/off feature */
+};
+
+struct shader_variants_t {
+  char* vs_str;
+  char* fs_str;
+  variant_key_t keys[VARIANT_MAX_KEYS];
+  int n_keys;
+  int n_bits;
+  /* cache of compiled permutations, indexed by variant mask. 0 if not built */
+  GLuint programmes[1 << VARIANT_MAX_BITS];
+  /* set if a permutation didn't compile, so it isn't tried again every frame */
+  bool failed[1 << VARIANT_MAX_BITS];
+  int n_compiled;
+  GLuint uber_programme;
+  bool uber_failed;
+  GLint uber_key_locs[VARIANT_MAX_KEYS];
+};
+
+/* reads both shader files into memory. nothing is compiled yet */
+bool init_shader_variants( shader_variants_t* sv, const char* vert_file_name, const char* frag_file_name );
+/* deletes every compiled permutation and the source strings */
+void free_shader_variants( shader_variants_t* sv );
+/* declare a feature key using `bits` bits of the variant mask. declare all
+keys before asking for any variants. returns the key's index or -1 */
+int add_variant_key( shader_variants_t* sv, const char* name, int bits );
+/* returns the part of a variant mask that sets key `key` to `value`. OR these
+together to describe a permutation */
+unsigned int variant_key_bits( const shader_variants_t* sv, int key, unsigned int value );
+/* returns the programme for a variant mask, compiling it if not cached yet.
+returns 0 if it did not compile, then or on an earlier call */
+GLuint get_variant( shader_variants_t* sv, unsigned int mask );
+/* one programme with all keys as uniforms instead of defines */
+GLuint get_uber_variant( shader_variants_t* sv );
+/* set the uber programme's key uniforms to match a variant mask. the uber
+programme must be in use */
+void set_uber_variant_keys( const shader_variants_t* sv, unsigned int mask );
+
+#endif
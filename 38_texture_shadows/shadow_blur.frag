@@ -0,0 +1,17 @@
+#version 410
+
+/* the vertical half of the moments blur. see shadow_moments.frag */
+uniform sampler2D moments_map;
+uniform int radius;
+out vec2 moments;
+
+void main () {
+	ivec2 size = textureSize (moments_map, 0);
+	ivec2 p = ivec2 (gl_FragCoord.xy);
+	vec2 sum = vec2 (0.0);
+	for (int i = -radius; i <= radius; i++) {
+		int y = clamp (p.y + i, 0, size.y - 1);
+		sum += texelFetch (moments_map, ivec2 (p.x, y), 0).rg;
+	}
+	moments = sum / float (2 * radius + 1);
+}
@@ -0,0 +1,144 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Shadow map filtering.                                                        |
+\******************************************************************************/
+#include "shadow_filters.h"
+#include "gl_state.h"
+#include "gl_utils.h"
+#include <string.h>
+#define FULLSCREEN_VS "fullscreen.vert"
+#define MOMENTS_FS "shadow_moments.frag"
+#define BLUR_FS "shadow_blur.frag"
+
+static bool create_moments_fb( GLuint* fb, GLuint tex, GLenum target ) {
+  glGenFramebuffers( 1, fb );
+  glBindFramebuffer( GL_FRAMEBUFFER, *fb );
+  if ( GL_TEXTURE_2D_ARRAY == target ) {
+    glFramebufferTextureLayer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex, 0, 0 );
+  } else {
+    glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target, tex, 0 );
+  }
+  GLenum draw_bufs[] = { GL_COLOR_ATTACHMENT0 };
+  glDrawBuffers( 1, draw_bufs );
+  GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  if ( GL_FRAMEBUFFER_COMPLETE != status ) {
+    gl_log_err( "ERROR: incomplete shadow moments framebuffer. status 0x%x\n", status );
+    return false;
+  }
+  return true;
+}
+
+bool init_shadow_filters( shadow_filters_t* sf, int size, int n_layers ) {
+  memset( sf, 0, sizeof( shadow_filters_t ) );
+  sf->size     = size;
+  sf->n_layers = n_layers;
+
+  glGenSamplers( 1, &sf->raw_sampler );
+  glSamplerParameteri( sf->raw_sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+  glSamplerParameteri( sf->raw_sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+  glSamplerParameteri( sf->raw_sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glSamplerParameteri( sf->raw_sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glSamplerParameteri( sf->raw_sampler, GL_TEXTURE_COMPARE_MODE, GL_NONE );
+  /* with linear filtering the comparison is done on each of the 4 nearest
+  texels and the results are blended. that is the "free" 2x2 PCF */
+  glGenSamplers( 1, &sf->compare_sampler );
+  glSamplerParameteri( sf->compare_sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  glSamplerParameteri( sf->compare_sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glSamplerParameteri( sf->compare_sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glSamplerParameteri( sf->compare_sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glSamplerParameteri( sf->compare_sampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE );
+  glSamplerParameteri( sf->compare_sampler, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL );
+
+  /* 32-bit floats. depth squared loses too much precision in 16 bits, and
+  ESM's exponentials need the range */
+  glGenTextures( 1, &sf->moments_tex );
+  glBindTexture( GL_TEXTURE_2D_ARRAY, sf->moments_tex );
+  glTexImage3D( GL_TEXTURE_2D_ARRAY, 0, GL_RG32F, size, size, n_layers, 0, GL_RG, GL_FLOAT, NULL );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glGenTextures( 1, &sf->scratch_tex );
+  glBindTexture( GL_TEXTURE_2D, sf->scratch_tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_RG32F, size, size, 0, GL_RG, GL_FLOAT, NULL );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+  if ( !create_moments_fb( &sf->moments_fb, sf->moments_tex, GL_TEXTURE_2D_ARRAY ) ) { return false; }
+  if ( !create_moments_fb( &sf->scratch_fb, sf->scratch_tex, GL_TEXTURE_2D ) ) { return false; }
+
+  glGenVertexArrays( 1, &sf->vao );
+  sf->moments_sp         = create_programme_from_files( FULLSCREEN_VS, MOMENTS_FS );
+  sf->moments_layer_loc  = glGetUniformLocation( sf->moments_sp, "layer" );
+  sf->moments_radius_loc = glGetUniformLocation( sf->moments_sp, "radius" );
+  sf->moments_esm_loc    = glGetUniformLocation( sf->moments_sp, "esm" );
+  sf->moments_esm_c_loc  = glGetUniformLocation( sf->moments_sp, "esm_c" );
+  sf->blur_sp            = create_programme_from_files( FULLSCREEN_VS, BLUR_FS );
+  sf->blur_radius_loc    = glGetUniformLocation( sf->blur_sp, "radius" );
+  return sf->moments_sp && sf->blur_sp;
+}
+
+void free_shadow_filters( shadow_filters_t* sf ) {
+  glDeleteSamplers( 1, &sf->raw_sampler );
+  glDeleteSamplers( 1, &sf->compare_sampler );
+  glDeleteFramebuffers( 1, &sf->moments_fb );
+  glDeleteFramebuffers( 1, &sf->scratch_fb );
+  glDeleteTextures( 1, &sf->moments_tex );
+  glDeleteTextures( 1, &sf->scratch_tex );
+  glDeleteVertexArrays( 1, &sf->vao );
+  glDeleteProgram( sf->moments_sp );
+  glDeleteProgram( sf->blur_sp );
+  memset( sf, 0, sizeof( shadow_filters_t ) );
+}
+
+void bind_shadow_samplers( const shadow_filters_t* sf ) {
+  glBindSampler( SHADOW_UNIT_DEPTH, sf->raw_sampler );
+  glBindSampler( SHADOW_UNIT_COMPARE, sf->compare_sampler );
+}
+
+void build_shadow_moments( shadow_filters_t* sf, GLuint depth_tex, int n_layers, int radius, float esm_c ) {
+  if ( n_layers > sf->n_layers ) { n_layers = sf->n_layers; }
+  gl_state_disable( GL_DEPTH_TEST );
+  gl_state_disable( GL_BLEND );
+  gl_state_viewport( 0, 0, sf->size, sf->size );
+  gl_state_bind_vertex_array( sf->vao );
+  for ( int l = 0; l < n_layers; l++ ) {
+    /* depth to moments, blurred across */
+    gl_state_bind_framebuffer( sf->scratch_fb );
+    gl_state_use_program( sf->moments_sp );
+    gl_state_bind_texture( SHADOW_UNIT_DEPTH, GL_TEXTURE_2D_ARRAY, depth_tex );
+    glUniform1i( sf->moments_layer_loc, l );
+    glUniform1i( sf->moments_radius_loc, radius );
+    glUniform1i( sf->moments_esm_loc, esm_c > 0.0f ? 1 : 0 );
+    glUniform1f( sf->moments_esm_c_loc, esm_c );
+    glDrawArrays( GL_TRIANGLES, 0, 3 );
+    /* then down, into this layer of the moments array */
+    gl_state_bind_framebuffer( sf->moments_fb );
+    glFramebufferTextureLayer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, sf->moments_tex, 0, l );
+    gl_state_use_program( sf->blur_sp );
+    gl_state_bind_texture( SHADOW_UNIT_DEPTH, GL_TEXTURE_2D, sf->scratch_tex );
+    glUniform1i( sf->blur_radius_loc, radius );
+    glDrawArrays( GL_TRIANGLES, 0, 3 );
+  }
+  gl_state_bind_framebuffer( 0 );
+  gl_state_enable( GL_DEPTH_TEST );
+}
+
+const char* shadow_filter_name( int filter ) {
+  switch ( filter ) {
+  case SHADOW_FILTER_NONE: return "none";
+  case SHADOW_FILTER_FOUR_TAP: return "4-tap";
+  case SHADOW_FILTER_HARDWARE: return "hardware";
+  case SHADOW_FILTER_POISSON: return "poisson";
+  case SHADOW_FILTER_VSM: return "VSM";
+  case SHADOW_FILTER_ESM: return "ESM";
+  case SHADOW_FILTER_REFERENCE: return "reference";
+  default: return "unknown";
+  }
+}
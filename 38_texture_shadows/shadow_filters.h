@@ -0,0 +1,86 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 19 Oct 2026                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Shadow map filtering.                                                        |
+| A plain depth comparison is either in shadow or not, so edges come out as    |
+| hard, jagged texel steps. The filters here soften them in different ways:    |
+|   hardware - the texture unit compares the 4 nearest texels against the      |
+|              fragment's depth and blends the results bilinearly. needs a     |
+|              sampler2DShadow-type sampler with GL_COMPARE_REF_TO_TEXTURE     |
+|   poisson  - averages 16 hardware compares spread over a disc, rotated per   |
+|              pixel to swap banding for noise                                 |
+|   VSM      - variance shadow maps. depth and depth squared are stored and    |
+|              can be blurred like colour before use. Chebyshev's inequality   |
+|              then bounds how much of the blurred area is lit. one fetch per  |
+|              pixel, but light can bleed where casters overlap                |
+|   ESM      - exponential shadow maps. exp(c * depth) is stored and blurred,  |
+|              and multiplying by exp(-c * fragment depth) gives a smooth step |
+| VSM and ESM need a prefilter pass after the shadow maps are drawn. It turns  |
+| each depth layer into moments with a separable box blur: one horizontal      |
+| pass into a scratch texture, then one vertical pass into the moments array.  |
+| The reference filter does a hardware compare at every texel of the same box  |
+| as the blur. It is slow, but it is what the other filters try to match.      |
+\******************************************************************************/
+#ifndef _SHADOW_FILTERS_H_
+#define _SHADOW_FILTERS_H_
+
+#include <GL/glew.h>
+
+/* values of the SHADOW_FILTER variant key. plain.frag uses the same numbers */
+enum shadow_filter_t {
+  SHADOW_FILTER_NONE = 0,
+  SHADOW_FILTER_FOUR_TAP,
+  SHADOW_FILTER_HARDWARE,
+  SHADOW_FILTER_POISSON,
+  SHADOW_FILTER_VSM,
+  SHADOW_FILTER_ESM,
+  SHADOW_FILTER_REFERENCE,
+  SHADOW_FILTER_COUNT
+};
+/* bits needed for the SHADOW_FILTER key */
+#define SHADOW_FILTER_BITS 3
+
+/* texture units used by plain.frag */
+#define SHADOW_UNIT_DEPTH 0
+#define SHADOW_UNIT_COMPARE 1
+#define SHADOW_UNIT_MOMENTS 2
+
+struct shadow_filters_t {
+  int size, n_layers;
+  /* sampler objects override the depth texture's own filtering per unit, so
+  one texture can be read both ways at once */
+  GLuint raw_sampler;     /* nearest, no comparison */
+  GLuint compare_sampler; /* linear, GL_COMPARE_REF_TO_TEXTURE */
+  GLuint moments_tex;     /* RG32F array, a layer per shadow map */
+  GLuint scratch_tex;     /* RG32F, holds the horizontal blur */
+  GLuint moments_fb, scratch_fb;
+  GLuint vao; /* empty. the full-screen triangle comes from gl_VertexID */
+  GLuint moments_sp;
+  GLint moments_layer_loc, moments_radius_loc, moments_esm_loc, moments_esm_c_loc;
+  GLuint blur_sp;
+  GLint blur_radius_loc;
+};
+
+/* size and n_layers must match the depth texture array that will be filtered */
+bool init_shadow_filters( shadow_filters_t* sf, int size, int n_layers );
+void free_shadow_filters( shadow_filters_t* sf );
+
+/* binds the raw and comparison samplers to SHADOW_UNIT_DEPTH and
+SHADOW_UNIT_COMPARE. bind the depth texture array to both units */
+void bind_shadow_samplers( const shadow_filters_t* sf );
+
+/* fills the first n_layers of the moments array from the depth texture array,
+blurred over (2 * radius + 1) texels square. esm_c > 0 stores ESM's exp(c *
+depth), otherwise VSM's depth and depth squared. leaves the default framebuffer
+bound */
+void build_shadow_moments( shadow_filters_t* sf, GLuint depth_tex, int n_layers, int radius, float esm_c );
+
+/* short name of a filter for printing */
+const char* shadow_filter_name( int filter );
+
+#endif
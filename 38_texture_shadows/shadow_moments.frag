@@ -0,0 +1,27 @@
+#version 410
+
+/* turns one layer of the shadow depth maps into moments for VSM or ESM, and
+blurs them horizontally on the way. shadow_blur.frag does the vertical half */
+uniform sampler2DArray depth_map;
+uniform int layer;
+uniform int radius;
+/* 0 for VSM's depth and depth squared, 1 for ESM's exp (c * depth) */
+uniform int esm;
+uniform float esm_c;
+out vec2 moments;
+
+void main () {
+	ivec2 size = textureSize (depth_map, 0).xy;
+	ivec2 p = ivec2 (gl_FragCoord.xy);
+	vec2 sum = vec2 (0.0);
+	for (int i = -radius; i <= radius; i++) {
+		int x = clamp (p.x + i, 0, size.x - 1);
+		float d = texelFetch (depth_map, ivec3 (x, p.y, layer), 0).r;
+		if (esm != 0) {
+			sum.x += exp (esm_c * d);
+		} else {
+			sum += vec2 (d, d * d);
+		}
+	}
+	moments = sum / float (2 * radius + 1);
+}
@@ -1,10 +1,11 @@
 #version 410
 
 in vec2 st;
-uniform sampler2D depth_tex;
+uniform sampler2DArray depth_tex;
+uniform int layer;
 out vec4 frag_colour;
 
 void main () {
-	float d = texture (depth_tex, st).r;
+	float d = texture (depth_tex, vec3 (st, float (layer))).r;
 	frag_colour = vec4 (d, d, d, 1.0);
 }